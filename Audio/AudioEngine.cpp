@@ -12,7 +12,8 @@
 #include "Audio.h"
 #include "SoundCommon.h"
 
-#include <list>
+#include <atomic>
+#include <thread>
 #include <unordered_map>
 
 using namespace DirectX;
@@ -22,6 +23,73 @@ using Microsoft::WRL::ComPtr;
 
 namespace
 {
+    // X3DAudio holds the last point of a volume curve past its end, so an emitter whose curve falls to silence
+    // can't be heard beyond that distance. The default inverse square curve never does.
+    float AudibleRange(const X3DAUDIO_EMITTER& emitter) noexcept
+    {
+        auto curve = emitter.pVolumeCurve;
+        if (!curve || !curve->pPoints || !curve->PointCount)
+            return FLT_MAX;
+
+        const auto& last = curve->pPoints[curve->PointCount - 1];
+        if (last.DSPSetting > 0.f)
+            return FLT_MAX;
+
+        return last.Distance * emitter.CurveDistanceScaler;
+    }
+
+    // Virtual instances can only pass a voice between them if it was created the same way
+    bool IsVoiceCompatible(_In_ const IVirtualVoice* a, _In_ const IVirtualVoice* b) noexcept
+    {
+        if (a->GetVoiceFlags() != b->GetVoiceFlags() || a->GetVoiceOutput() != b->GetVoiceOutput())
+            return false;
+
+        auto wfxa = a->GetVoiceFormat();
+        auto wfxb = b->GetVoiceFormat();
+        if (wfxa->wFormatTag != wfxb->wFormatTag)
+            return false;
+
+        size_t wfxSize = sizeof(WAVEFORMATEX);
+        if (wfxa->wFormatTag != WAVE_FORMAT_PCM)
+        {
+            if (wfxa->cbSize != wfxb->cbSize)
+                return false;
+
+            wfxSize += wfxa->cbSize;
+        }
+
+        return memcmp(wfxa, wfxb, wfxSize) == 0;
+    }
+
+    const DWORD c_DefaultUpdateInterval = 10;
+
+    inline float ElapsedMS(const LARGE_INTEGER& start, const LARGE_INTEGER& end, const LARGE_INTEGER& frequency) noexcept
+    {
+        return float(double(end.QuadPart - start.QuadPart) * 1000.0 / double(frequency.QuadPart));
+    }
+
+    // Submix voices can only send to ones in a later processing stage, so a bus's stage counts down from this by
+    // its depth below the mastering voice
+    const unsigned int c_MaxBusDepth = 64;
+
+    // A named submix bus. The record outlives its voice, so the bus can be recreated with the same effects, volume
+    // and sends when the engine is reset.
+    struct AudioBus
+    {
+        AudioBus() noexcept : voice(nullptr), depth(0), volume(1.f) {}
+
+        AudioBus(AudioBus const&) = delete;
+        AudioBus& operator= (AudioBus const&) = delete;
+
+        std::string                                 name;
+        IXAudio2SubmixVoice*                        voice;
+        unsigned int                                depth;
+        float                                       volume;
+        std::vector<XAUDIO2_EFFECT_DESCRIPTOR>      effects;
+        std::vector<ComPtr<IUnknown>>               effectRefs;
+        std::vector<std::pair<AudioBus*, float>>    outputs;    // The first is the parent (null for the mastering voice)
+    };
+
     struct EngineCallback : public IXAudio2EngineCallback
     {
         EngineCallback() noexcept(false)
@@ -54,22 +122,87 @@ namespace
 
     struct VoiceCallback : public IXAudio2VoiceCallback
     {
-        VoiceCallback() noexcept(false)
+        VoiceCallback() = default;
+
+        virtual ~VoiceCallback()
+        {
+        }
+
+        STDMETHOD_(void, OnVoiceProcessingPassStart) (UINT32) override {}
+        STDMETHOD_(void, OnVoiceProcessingPassEnd)() override {}
+        STDMETHOD_(void, OnStreamEnd)() override {}
+        STDMETHOD_(void, OnBufferStart)(void*) override {}
+
+        STDMETHOD_(void, OnBufferEnd)(void* context) override
         {
-            mBufferEnd.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
-            if (!mBufferEnd)
+            if (context)
             {
-                throw std::exception("CreateEvent");
+                auto inotify = reinterpret_cast<IVoiceNotify*>(context);
+                inotify->OnBufferEnd();
             }
         }
 
-        virtual ~VoiceCallback()
+        STDMETHOD_(void, OnLoopEnd)(void*) override {}
+        STDMETHOD_(void, OnVoiceError)(void*, HRESULT) override {}
+    };
+
+    struct OneShotVoice;
+
+    // Completed one-shots are pushed from XAudio2's worker thread and taken all at once by Update, which is
+    // the only consumer, so a plain lock-free stack is enough.
+    class OneShotQueue
+    {
+    public:
+        OneShotQueue() noexcept : mHead(nullptr) {}
+
+        OneShotQueue(OneShotQueue const&) = delete;
+        OneShotQueue& operator= (OneShotQueue const&) = delete;
+
+        void Push(_In_ OneShotVoice* node) noexcept;
+
+        OneShotVoice* PopAll() noexcept
+        {
+            return mHead.exchange(nullptr, std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<OneShotVoice*> mHead;
+    };
+
+    // Each one-shot voice gets its own callback so OnStreamEnd can say which voice finished. A node is on the
+    // engine's active list while playing and on the free list for its voice key while pooled.
+    struct OneShotVoice : public IXAudio2VoiceCallback
+    {
+        OneShotVoice(_In_ OneShotQueue* queue, unsigned int key) noexcept :
+            voice(nullptr),
+            voiceKey(key),
+            prev(nullptr),
+            next(nullptr),
+            nextCompleted(nullptr),
+            output(nullptr),
+            completed(false),
+            mQueue(queue)
         {
         }
 
+        OneShotVoice(OneShotVoice const&) = delete;
+        OneShotVoice& operator= (OneShotVoice const&) = delete;
+
+        virtual ~OneShotVoice()
+        {
+        }
+
+        void NotifyComplete() noexcept
+        {
+            if (!completed.exchange(true))
+            {
+                mQueue->Push(this);
+            }
+        }
+
         STDMETHOD_(void, OnVoiceProcessingPassStart) (UINT32) override {}
         STDMETHOD_(void, OnVoiceProcessingPassEnd)() override {}
-        STDMETHOD_(void, OnStreamEnd)() override {}
+        STDMETHOD_(void, OnStreamEnd)() override { NotifyComplete(); }
         STDMETHOD_(void, OnBufferStart)(void*) override {}
 
         STDMETHOD_(void, OnBufferEnd)(void* context) override
@@ -78,16 +211,34 @@ namespace
             {
                 auto inotify = reinterpret_cast<IVoiceNotify*>(context);
                 inotify->OnBufferEnd();
-                SetEvent(mBufferEnd.get());
             }
         }
 
         STDMETHOD_(void, OnLoopEnd)(void*) override {}
         STDMETHOD_(void, OnVoiceError)(void*, HRESULT) override {}
 
-        ScopedHandle mBufferEnd;
+        IXAudio2SourceVoice*    voice;
+        unsigned int            voiceKey;
+        OneShotVoice*           prev;
+        OneShotVoice*           next;
+        OneShotVoice*           nextCompleted;
+        IXAudio2Voice*          output;             // Bus the voice sends to, or null for the mastering voice
+        std::atomic<bool>       completed;
+
+    private:
+        OneShotQueue*           mQueue;
     };
 
+    void OneShotQueue::Push(OneShotVoice* node) noexcept
+    {
+        auto head = mHead.load(std::memory_order_relaxed);
+        do
+        {
+            node->nextCompleted = head;
+        }
+        while (!mHead.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
     static const XAUDIO2FX_REVERB_I3DL2_PARAMETERS gReverbPresets[] =
     {
         XAUDIO2FX_I3DL2_PRESET_DEFAULT,             // Reverb_Off
@@ -263,11 +414,34 @@ public:
         mReverbEnabled(false),
         mEngineFlags(AudioEngine_Default),
         mCategory(AudioCategory_GameEffects),
-        mVoiceInstances(0)
+        mOneShots(nullptr),
+        mOneShotCount(0),
+        mVoicePoolCount(0),
+        mVoicePoolHits(0),
+        mVoicePoolMisses(0),
+        mWindingDown(nullptr),
+        mVoiceInstances(0),
+        mOperationSet(0),
+        mQPCFrequency{},
+        mFrameCount(0),
+        mApply3DTime(0.f),
+        mApply3DBatches(0),
+        mApply3DEmitters(0),
+        mApply3DCulled(0),
+        mStreamStalls(0),
+        mLastFrame{},
+        mPerfHistoryNext(0),
+        mPerfHistoryCount(0),
+        mUpdateInterval(c_DefaultUpdateInterval),
+        mUpdateExit(false)
     #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
         , mDLL(nullptr)
     #endif
     {
+        if (!QueryPerformanceFrequency(&mQPCFrequency))
+        {
+            mQPCFrequency.QuadPart = 1;
+        }
     }
 
 #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
@@ -291,20 +465,53 @@ public:
 
     bool Update();
 
+    void Post(std::function<void __cdecl()>&& command);
+    void StartUpdateThread();
+    void StopUpdateThread() noexcept;
+
+    // Only takes the lock when an update thread may be running
+    std::unique_lock<std::recursive_mutex> LockUpdates()
+    {
+        return (mEngineFlags & AudioEngine_UpdateThread)
+            ? std::unique_lock<std::recursive_mutex>(mUpdateMutex)
+            : std::unique_lock<std::recursive_mutex>();
+    }
+
     void SetReverb(_In_opt_ const XAUDIO2FX_REVERB_PARAMETERS* native) noexcept;
 
     void SetMasteringLimit(int release, int loudness);
 
+    IXAudio2SubmixVoice* CreateBus(_In_z_ const char* name, _In_opt_z_ const char* parent, _In_opt_ const XAUDIO2_EFFECT_CHAIN* effects);
+    IXAudio2SubmixVoice* GetBus(_In_z_ const char* name) const noexcept;
+    void SetBusVolume(_In_z_ const char* name, float volume);
+    void SetBusSend(_In_z_ const char* name, _In_opt_z_ const char* target, float level);
+    void DestroyBus(_In_z_ const char* name);
+
     AudioStatistics GetStatistics() const;
 
+    AudioPerformanceData GetPerformanceData() const noexcept { return mLastFrame; }
+    void SetPerformanceHistory(size_t frames);
+    size_t GetPerformanceHistory(_Out_writes_(count) AudioPerformanceData* frames, size_t count) const noexcept;
+    void ReportStreamStall() noexcept { ++mStreamStalls; }
+
+    void Apply3D(const AudioListener& listener, _In_reads_(count) SoundEffectInstance* const* instances, _In_reads_(count) const AudioEmitter* emitters, size_t count, bool rhcoords);
+
     void TrimVoicePool();
 
-    void AllocateVoice(_In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice);
+    void ReserveVoices(_In_ const WAVEFORMATEX* wfx, size_t count);
+
+    void AllocateVoice(_In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice, _In_opt_ IXAudio2Voice* output);
     void DestroyVoice(_In_ IXAudio2SourceVoice* voice);
+    void ReleaseOneShot(_In_ IXAudio2SourceVoice* voice) noexcept;
 
     void RegisterNotify(_In_ IVoiceNotify* notify, bool usesUpdate);
     void UnregisterNotify(_In_ IVoiceNotify* notify, bool oneshots, bool usesUpdate);
 
+    void RegisterVirtual(_In_ IVirtualVoice* instance) { assert(instance != nullptr); mVirtualVoices.insert(instance); }
+    void UnregisterVirtual(_In_ IVirtualVoice* instance) { assert(instance != nullptr); mVirtualVoices.erase(instance); }
+
+    void UpdateVirtualVoices();
+
     ComPtr<IXAudio2>                    xaudio2;
     IXAudio2MasteringVoice*             mMasterVoice;
     IXAudio2SubmixVoice*                mReverbVoice;
@@ -327,17 +534,67 @@ public:
 
 private:
     typedef std::set<IVoiceNotify*> notifylist_t;
-    typedef std::list<std::pair<unsigned int, IXAudio2SourceVoice*>> oneshotlist_t;
-    typedef std::unordered_multimap<unsigned int, IXAudio2SourceVoice*> voicepool_t;
+    typedef std::unordered_map<unsigned int, OneShotVoice*> voicepool_t;
+    typedef std::pair<float, IVirtualVoice*> rankedvoice_t;
+    typedef std::pair<IXAudio2SourceVoice*, IVirtualVoice*> donatedvoice_t;
+
+    OneShotVoice* CreatePooledVoice(unsigned int voiceKey, _In_ const WAVEFORMATEX* wfx);
+    void RouteOneShot(_In_ OneShotVoice* node, _In_opt_ IXAudio2Voice* output);
+    AudioBus* FindBus(_In_z_ const char* name) const noexcept;
+    HRESULT CreateBusVoice(AudioBus& bus) noexcept;
+    HRESULT SetBusOutputs(AudioBus& bus) noexcept;
+    void DestroyBusVoices() noexcept;
+    void RecordFrame(const LARGE_INTEGER& start) noexcept;
+    void RunCommands();
+    void UpdateThreadProc() noexcept;
+    void RecycleOneShot(_In_ OneShotVoice* node) noexcept;
+    void PoolOneShot(_In_ OneShotVoice* node) noexcept;
+    void UnlinkOneShot(_In_ OneShotVoice* node) noexcept;
+    void DestroyOneShots() noexcept;
 
     AUDIO_STREAM_CATEGORY               mCategory;
     ComPtr<IUnknown>                    mReverbEffect;
     ComPtr<IUnknown>                    mVolumeLimiter;
-    oneshotlist_t                       mOneShots;
+    OneShotVoice*                       mOneShots;
+    size_t                              mOneShotCount;
     voicepool_t                         mVoicePool;
+    size_t                              mVoicePoolCount;
+    size_t                              mVoicePoolHits;
+    size_t                              mVoicePoolMisses;
+    OneShotQueue                        mCompletedOneShots;
+    OneShotVoice*                       mWindingDown;
     notifylist_t                        mNotifyObjects;
     notifylist_t                        mNotifyUpdates;
     size_t                              mVoiceInstances;
+    std::set<IVirtualVoice*>            mVirtualVoices;
+    std::vector<rankedvoice_t>          mRankedVoices;
+    std::vector<donatedvoice_t>         mDonatedVoices;
+    std::vector<std::unique_ptr<AudioBus>> mBuses;          // Sorted by depth, so parents and send targets come first
+    UINT32                              mOperationSet;
+
+    // Telemetry
+    LARGE_INTEGER                       mQPCFrequency;
+    uint64_t                            mFrameCount;
+    float                               mApply3DTime;
+    uint32_t                            mApply3DBatches;
+    uint32_t                            mApply3DEmitters;
+    uint32_t                            mApply3DCulled;
+    std::atomic<uint32_t>               mStreamStalls;
+    AudioPerformanceData                mLastFrame;
+    std::vector<AudioPerformanceData>   mPerfHistory;
+    size_t                              mPerfHistoryNext;
+    size_t                              mPerfHistoryCount;
+
+    // Update thread
+    std::thread                         mUpdateThread;
+    std::recursive_mutex                mUpdateMutex;
+    ScopedHandle                        mUpdateWake;
+    std::atomic<DWORD>                  mUpdateInterval;
+    std::atomic<bool>                   mUpdateExit;
+    std::mutex                          mCommandMutex;
+    std::vector<std::function<void __cdecl()>> mCommands;
+    std::vector<std::function<void __cdecl()>> mRunningCommands;
+
     VoiceCallback                       mVoiceCallback;
     EngineCallback                      mEngineCallback;
 
@@ -700,6 +957,19 @@ HRESULT AudioEngine::Impl::Reset(const WAVEFORMATEX* wfx, const wchar_t* deviceI
     X3DAudioInitialize(masterChannelMask, SPEEDOFSOUND, mX3DAudio);
 #endif
 
+    //
+    // Recreate any submix buses for the new device
+    //
+    for (auto it = mBuses.begin(); it != mBuses.end(); ++it)
+    {
+        hr = CreateBusVoice(**it);
+        if (FAILED(hr))
+        {
+            // Anything routed to the bus falls back to the mastering voice
+            DebugTrace("WARNING: Submix bus \"%hs\" could not be recreated (%08X)\n", (*it)->name.c_str(), static_cast<unsigned int>(hr));
+        }
+    }
+
     //
     // Inform any notify objects we are ready to go again
     //
@@ -721,22 +991,12 @@ void AudioEngine::Impl::SetSilentMode()
         (*it)->OnCriticalError();
     }
 
-    for (auto it = mOneShots.begin(); it != mOneShots.end(); ++it)
-    {
-        assert(it->second != nullptr);
-        it->second->DestroyVoice();
-    }
-    mOneShots.clear();
-
-    for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
-    {
-        assert(it->second != nullptr);
-        it->second->DestroyVoice();
-    }
-    mVoicePool.clear();
+    DestroyOneShots();
 
     mVoiceInstances = 0;
 
+    DestroyBusVoices();
+
     SAFE_DESTROY_VOICE(mReverbVoice)
     SAFE_DESTROY_VOICE(mMasterVoice)
 
@@ -748,34 +1008,28 @@ void AudioEngine::Impl::SetSilentMode()
 
 void AudioEngine::Impl::Shutdown() noexcept
 {
+    StopUpdateThread();
+
     for (auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it)
     {
         assert(*it != nullptr);
         (*it)->OnDestroyEngine();
     }
 
+    mVirtualVoices.clear();
+
     if (xaudio2)
     {
         xaudio2->UnregisterForCallbacks(&mEngineCallback);
 
         xaudio2->StopEngine();
 
-        for (auto it = mOneShots.begin(); it != mOneShots.end(); ++it)
-        {
-            assert(it->second != nullptr);
-            it->second->DestroyVoice();
-        }
-        mOneShots.clear();
-
-        for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
-        {
-            assert(it->second != nullptr);
-            it->second->DestroyVoice();
-        }
-        mVoicePool.clear();
+        DestroyOneShots();
 
         mVoiceInstances = 0;
 
+        DestroyBusVoices();
+
         SAFE_DESTROY_VOICE(mReverbVoice)
         SAFE_DESTROY_VOICE(mMasterVoice)
 
@@ -795,11 +1049,15 @@ void AudioEngine::Impl::Shutdown() noexcept
 
 bool AudioEngine::Impl::Update()
 {
+    RunCommands();
+
     if (!xaudio2)
         return false;
 
-    HANDLE events[2] = { mEngineCallback.mCriticalError.get(), mVoiceCallback.mBufferEnd.get() };
-    DWORD result = WaitForMultipleObjectsEx(2, events, FALSE, 0, FALSE);
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
+    DWORD result = WaitForSingleObjectEx(mEngineCallback.mCriticalError.get(), 0, FALSE);
     switch (result)
     {
         case WAIT_TIMEOUT:
@@ -811,50 +1069,37 @@ bool AudioEngine::Impl::Update()
             SetSilentMode();
             return false;
 
-        case WAIT_OBJECT_0 + 1: // OnBufferEnd
-            // Scan for completed one-shot voices
-            for (auto it = mOneShots.begin(); it != mOneShots.end(); )
-            {
-                assert(it->second != nullptr);
+        case WAIT_FAILED:
+            throw std::exception("WaitForSingleObjectEx");
+    }
 
-                XAUDIO2_VOICE_STATE xstate;
-            #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
-                it->second->GetState(&xstate, XAUDIO2_VOICE_NOSAMPLESPLAYED);
-            #else
-                it->second->GetState(&xstate);
-            #endif
+    //
+    // Recycle the one-shot voices that finished since the last update
+    //
+    {
+        auto windingDown = mWindingDown;
+        mWindingDown = nullptr;
 
-                if (!xstate.BuffersQueued)
-                {
-                    (void)it->second->Stop(0);
-                    if (it->first)
-                    {
-                        // Put voice back into voice pool for reuse since it has a non-zero voiceKey
-                    #ifdef VERBOSE_TRACE
-                        DebugTrace("INFO: One-shot voice being saved for reuse (%08X)\n", it->first);
-                    #endif
-                        voicepool_t::value_type v(it->first, it->second);
-                        mVoicePool.emplace(v);
-                    }
-                    else
-                    {
-                        // Voice is to be destroyed rather than reused
-                    #ifdef VERBOSE_TRACE
-                        DebugTrace("INFO: Destroying one-shot voice\n");
-                    #endif
-                        it->second->DestroyVoice();
-                    }
-                    it = mOneShots.erase(it);
-                }
-                else
-                    ++it;
-            }
-            break;
+        for (auto node = mCompletedOneShots.PopAll(); node; )
+        {
+            auto next = node->nextCompleted;
+            RecycleOneShot(node);
+            node = next;
+        }
 
-        case WAIT_FAILED:
-            throw std::exception("WaitForMultipleObjects");
+        for (auto node = windingDown; node; )
+        {
+            auto next = node->nextCompleted;
+            RecycleOneShot(node);
+            node = next;
+        }
     }
 
+    //
+    // Hand the voices to the most audible virtual instances
+    //
+    UpdateVirtualVoices();
+
     //
     // Inform any notify objects of updates
     //
@@ -864,10 +1109,183 @@ bool AudioEngine::Impl::Update()
         (*it)->OnUpdate();
     }
 
+    RecordFrame(start);
+
     return true;
 }
 
 
+_Use_decl_annotations_
+void AudioEngine::Impl::RecordFrame(const LARGE_INTEGER& start) noexcept
+{
+    AudioPerformanceData frame = {};
+    frame.frame = ++mFrameCount;
+    xaudio2->GetPerformanceData(&frame.xaudio2);
+
+    frame.apply3DTime = mApply3DTime;
+    frame.apply3DBatches = mApply3DBatches;
+    frame.apply3DEmitters = mApply3DEmitters;
+    frame.apply3DCulled = mApply3DCulled;
+    frame.streamStalls = mStreamStalls.exchange(0);
+
+    mApply3DTime = 0.f;
+    mApply3DBatches = mApply3DEmitters = mApply3DCulled = 0;
+
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    frame.updateTime = ElapsedMS(start, end, mQPCFrequency);
+
+    mLastFrame = frame;
+
+    if (!mPerfHistory.empty())
+    {
+        mPerfHistory[mPerfHistoryNext] = frame;
+        mPerfHistoryNext = (mPerfHistoryNext + 1) % mPerfHistory.size();
+        if (mPerfHistoryCount < mPerfHistory.size())
+            ++mPerfHistoryCount;
+    }
+}
+
+
+void AudioEngine::Impl::Post(std::function<void __cdecl()>&& command)
+{
+    if (!command)
+        throw std::invalid_argument("Post");
+
+    {
+        std::lock_guard<std::mutex> lock(mCommandMutex);
+        mCommands.emplace_back(std::move(command));
+    }
+
+    if (mUpdateWake)
+    {
+        SetEvent(mUpdateWake.get());
+    }
+}
+
+
+void AudioEngine::Impl::RunCommands()
+{
+    {
+        std::lock_guard<std::mutex> lock(mCommandMutex);
+        if (mCommands.empty())
+            return;
+
+        // Swapped out so commands can post more without deadlocking; those run on the next update
+        std::swap(mCommands, mRunningCommands);
+    }
+
+    for (auto it = mRunningCommands.begin(); it != mRunningCommands.end(); ++it)
+    {
+        try
+        {
+            (*it)();
+        }
+        catch (...)
+        {
+            mRunningCommands.clear();
+            throw;
+        }
+    }
+
+    mRunningCommands.clear();
+}
+
+
+void AudioEngine::Impl::StartUpdateThread()
+{
+    assert(!mUpdateThread.joinable());
+
+    mUpdateWake.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+    if (!mUpdateWake)
+    {
+        throw std::exception("CreateEventEx");
+    }
+
+    mUpdateExit = false;
+    mUpdateThread = std::thread([this]() { UpdateThreadProc(); });
+}
+
+
+void AudioEngine::Impl::StopUpdateThread() noexcept
+{
+    if (mUpdateThread.joinable())
+    {
+        mUpdateExit = true;
+        SetEvent(mUpdateWake.get());
+        mUpdateThread.join();
+    }
+
+    mUpdateWake.reset();
+}
+
+
+void AudioEngine::Impl::UpdateThreadProc() noexcept
+{
+    for (;;)
+    {
+        (void)WaitForSingleObjectEx(mUpdateWake.get(), mUpdateInterval, FALSE);
+
+        if (mUpdateExit)
+            break;
+
+        std::lock_guard<std::recursive_mutex> lock(mUpdateMutex);
+
+        try
+        {
+            (void)Update();
+        }
+        catch (const std::exception& e)
+        {
+            // There is no caller to rethrow to, so keep going; a critical error will already have gone silent
+            DebugTrace("ERROR: AudioEngine update thread failed: %hs\n", e.what());
+        }
+        catch (...)
+        {
+            DebugTrace("ERROR: AudioEngine update thread failed\n");
+        }
+    }
+}
+
+
+void AudioEngine::Impl::SetPerformanceHistory(size_t frames)
+{
+    mPerfHistory.clear();
+    mPerfHistory.shrink_to_fit();
+    mPerfHistory.resize(frames);
+    mPerfHistoryNext = mPerfHistoryCount = 0;
+}
+
+
+_Use_decl_annotations_
+size_t AudioEngine::Impl::GetPerformanceHistory(AudioPerformanceData* frames, size_t count) const noexcept
+{
+    if (!frames || !count)
+        return 0;
+
+    if (mPerfHistory.empty())
+    {
+        if (!mFrameCount)
+            return 0;
+
+        *frames = mLastFrame;
+        return 1;
+    }
+
+    count = std::min(count, mPerfHistoryCount);
+
+    // The ring ends just before mPerfHistoryNext, so start count entries back from there
+    size_t index = (mPerfHistoryNext + mPerfHistory.size() - count) % mPerfHistory.size();
+    for (size_t j = 0; j < count; ++j)
+    {
+        frames[j] = mPerfHistory[index];
+        index = (index + 1) % mPerfHistory.size();
+    }
+
+    return count;
+}
+
+
 _Use_decl_annotations_
 void AudioEngine::Impl::SetReverb(const XAUDIO2FX_REVERB_PARAMETERS* native) noexcept
 {
@@ -912,47 +1330,457 @@ void AudioEngine::Impl::SetMasteringLimit(int release, int loudness)
 }
 
 
-AudioStatistics AudioEngine::Impl::GetStatistics() const
+_Use_decl_annotations_
+IXAudio2SubmixVoice* AudioEngine::Impl::CreateBus(const char* name, const char* parent, const XAUDIO2_EFFECT_CHAIN* effects)
 {
-    AudioStatistics stats = {};
-
-    stats.allocatedVoices = stats.allocatedVoicesOneShot = mOneShots.size() + mVoicePool.size();
-    stats.allocatedVoicesIdle = mVoicePool.size();
+    if (!name || !*name)
+        throw std::invalid_argument("CreateBus");
 
-    for (auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it)
+    if (FindBus(name))
     {
-        assert(*it != nullptr);
-        (*it)->GatherStatistics(stats);
+        DebugTrace("ERROR: Submix bus \"%hs\" already exists\n", name);
+        throw std::exception("CreateBus");
     }
 
-    assert(stats.allocatedVoices == (mOneShots.size() + mVoicePool.size() + mVoiceInstances));
+    AudioBus* parentBus = nullptr;
+    if (parent)
+    {
+        parentBus = FindBus(parent);
+        if (!parentBus)
+        {
+            DebugTrace("ERROR: Parent submix bus \"%hs\" not found\n", parent);
+            throw std::exception("CreateBus");
+        }
+    }
 
-    return stats;
-}
+    auto bus = std::make_unique<AudioBus>();
+    bus->name = name;
+    bus->depth = (parentBus) ? (parentBus->depth + 1) : 1;
+    bus->outputs.emplace_back(parentBus, 1.f);
 
+    if (bus->depth >= c_MaxBusDepth)
+        throw std::out_of_range("CreateBus");
 
-void AudioEngine::Impl::TrimVoicePool()
-{
-    for (auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it)
+    if (effects && effects->EffectCount > 0)
     {
-        assert(*it != nullptr);
-        (*it)->OnTrim();
+        if (!effects->pEffectDescriptors)
+            throw std::invalid_argument("CreateBus");
+
+        bus->effects.assign(effects->pEffectDescriptors, effects->pEffectDescriptors + effects->EffectCount);
+        for (auto it = bus->effects.begin(); it != bus->effects.end(); ++it)
+        {
+            // Effects are attached again whenever the bus is recreated, so the bus holds on to them as well
+            it->OutputChannels = masterChannels;
+            bus->effectRefs.emplace_back(it->pEffect);
+        }
     }
 
-    for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
+    if (xaudio2)
     {
-        assert(it->second != nullptr);
-        it->second->DestroyVoice();
+        HRESULT hr = CreateBusVoice(*bus);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateSubmixVoice failed (%08X) for submix bus \"%hs\"\n", static_cast<unsigned int>(hr), name);
+            throw std::exception("CreateSubmixVoice");
+        }
     }
-    mVoicePool.clear();
+
+    auto voice = bus->voice;
+
+    auto it = std::upper_bound(mBuses.begin(), mBuses.end(), bus->depth,
+        [](unsigned int depth, const std::unique_ptr<AudioBus>& b) noexcept { return depth < b->depth; });
+    mBuses.insert(it, std::move(bus));
+
+    return voice;
 }
 
 
 _Use_decl_annotations_
-void AudioEngine::Impl::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, IXAudio2SourceVoice** voice)
+IXAudio2SubmixVoice* AudioEngine::Impl::GetBus(const char* name) const noexcept
 {
-    if (!wfx)
-        throw std::exception("Wave format is required\n");
+    auto bus = FindBus(name);
+    return (bus) ? bus->voice : nullptr;
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::SetBusVolume(const char* name, float volume)
+{
+    assert(volume >= -XAUDIO2_MAX_VOLUME_LEVEL && volume <= XAUDIO2_MAX_VOLUME_LEVEL);
+
+    auto bus = FindBus(name);
+    if (!bus)
+        throw std::invalid_argument("SetBusVolume");
+
+    bus->volume = volume;
+
+    if (bus->voice)
+    {
+        HRESULT hr = bus->voice->SetVolume(volume);
+        ThrowIfFailed(hr);
+    }
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::SetBusSend(const char* name, const char* target, float level)
+{
+    assert(level >= -XAUDIO2_MAX_VOLUME_LEVEL && level <= XAUDIO2_MAX_VOLUME_LEVEL);
+
+    auto bus = FindBus(name);
+    if (!bus)
+        throw std::invalid_argument("SetBusSend");
+
+    AudioBus* targetBus = nullptr;
+    if (target)
+    {
+        targetBus = FindBus(target);
+        if (!targetBus)
+            throw std::invalid_argument("SetBusSend");
+
+        if (targetBus->depth >= bus->depth)
+        {
+            DebugTrace("ERROR: Submix bus \"%hs\" can only send to buses nearer the mastering voice than itself\n", name);
+            throw std::exception("SetBusSend");
+        }
+    }
+
+    auto it = std::find_if(bus->outputs.begin(), bus->outputs.end(),
+        [targetBus](const std::pair<AudioBus*, float>& output) noexcept { return output.first == targetBus; });
+
+    if (it == bus->outputs.end())
+    {
+        if (level == 0.f)
+            return;
+
+        bus->outputs.emplace_back(targetBus, level);
+    }
+    else if (level == 0.f && it != bus->outputs.begin())
+    {
+        // The parent send stays even when silent; others are removed
+        bus->outputs.erase(it);
+    }
+    else
+    {
+        it->second = level;
+    }
+
+    if (bus->voice)
+    {
+        HRESULT hr = SetBusOutputs(*bus);
+        ThrowIfFailed(hr);
+    }
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::DestroyBus(const char* name)
+{
+    auto bus = FindBus(name);
+    if (!bus)
+        return;
+
+    for (auto it = mBuses.begin(); it != mBuses.end(); ++it)
+    {
+        for (auto& output : (*it)->outputs)
+        {
+            if (output.first == bus)
+            {
+                DebugTrace("ERROR: Submix bus \"%hs\" is still the output of \"%hs\"\n", name, (*it)->name.c_str());
+                throw std::exception("DestroyBus");
+            }
+        }
+    }
+
+    if (bus->voice)
+    {
+        // Idle and playing one-shots go back to the mastering voice; everything else has to be moved by its owner
+        for (auto node = mOneShots; node; node = node->next)
+        {
+            if (node->output == bus->voice)
+                RouteOneShot(node, nullptr);
+        }
+
+        for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
+        {
+            for (auto node = it->second; node; node = node->next)
+            {
+                if (node->output == bus->voice)
+                    RouteOneShot(node, nullptr);
+            }
+        }
+
+        bus->voice->DestroyVoice();
+        bus->voice = nullptr;
+    }
+
+    mBuses.erase(std::find_if(mBuses.begin(), mBuses.end(),
+        [bus](const std::unique_ptr<AudioBus>& b) noexcept { return b.get() == bus; }));
+}
+
+
+_Use_decl_annotations_
+AudioBus* AudioEngine::Impl::FindBus(const char* name) const noexcept
+{
+    if (!name)
+        return nullptr;
+
+    for (auto it = mBuses.cbegin(); it != mBuses.cend(); ++it)
+    {
+        if ((*it)->name == name)
+            return it->get();
+    }
+
+    return nullptr;
+}
+
+
+HRESULT AudioEngine::Impl::CreateBusVoice(AudioBus& bus) noexcept
+{
+    assert(xaudio2 && bus.voice == nullptr);
+
+    XAUDIO2_EFFECT_CHAIN chain = { static_cast<UINT32>(bus.effects.size()), bus.effects.data() };
+
+    for (auto it = bus.effects.begin(); it != bus.effects.end(); ++it)
+    {
+        it->OutputChannels = masterChannels;
+    }
+
+    HRESULT hr = xaudio2->CreateSubmixVoice(&bus.voice, masterChannels, masterRate, 0u, c_MaxBusDepth - bus.depth,
+        nullptr, bus.effects.empty() ? nullptr : &chain);
+    if (FAILED(hr))
+    {
+        bus.voice = nullptr;
+        return hr;
+    }
+
+    hr = SetBusOutputs(bus);
+    if (SUCCEEDED(hr) && bus.volume != 1.f)
+    {
+        hr = bus.voice->SetVolume(bus.volume);
+    }
+
+    if (FAILED(hr))
+    {
+        SAFE_DESTROY_VOICE(bus.voice)
+    }
+
+    return hr;
+}
+
+
+// Points the bus at its parent and sends, skipping any bus that lost its voice on reset, and sets the send levels
+HRESULT AudioEngine::Impl::SetBusOutputs(AudioBus& bus) noexcept
+{
+    assert(bus.voice != nullptr);
+
+    std::vector<XAUDIO2_SEND_DESCRIPTOR> sends;
+    sends.reserve(bus.outputs.size());
+
+    for (auto it = bus.outputs.cbegin(); it != bus.outputs.cend(); ++it)
+    {
+        IXAudio2Voice* output = (it->first) ? static_cast<IXAudio2Voice*>(it->first->voice) : mMasterVoice;
+        if (output)
+        {
+            sends.push_back({ 0, output });
+        }
+    }
+
+    const XAUDIO2_VOICE_SENDS sendList = { static_cast<UINT32>(sends.size()), sends.data() };
+    HRESULT hr = bus.voice->SetOutputVoices(&sendList);
+    if (FAILED(hr))
+        return hr;
+
+    std::vector<float> matrix;
+    for (auto it = bus.outputs.cbegin(); it != bus.outputs.cend(); ++it)
+    {
+        IXAudio2Voice* output = (it->first) ? static_cast<IXAudio2Voice*>(it->first->voice) : mMasterVoice;
+        if (!output || it->second == 1.f)
+            continue;
+
+        matrix.assign(size_t(masterChannels) * masterChannels, 0.f);
+        for (size_t j = 0; j < masterChannels; ++j)
+        {
+            matrix[j * masterChannels + j] = it->second;
+        }
+
+        hr = bus.voice->SetOutputMatrix(output, masterChannels, masterChannels, matrix.data());
+        if (FAILED(hr))
+            return hr;
+    }
+
+    return S_OK;
+}
+
+
+// The deepest buses go first, as XAudio2 won't destroy a voice that others still send to
+void AudioEngine::Impl::DestroyBusVoices() noexcept
+{
+    for (auto it = mBuses.rbegin(); it != mBuses.rend(); ++it)
+    {
+        SAFE_DESTROY_VOICE((*it)->voice)
+    }
+}
+
+
+AudioStatistics AudioEngine::Impl::GetStatistics() const
+{
+    AudioStatistics stats = {};
+
+    stats.allocatedVoices = stats.allocatedVoicesOneShot = mOneShotCount + mVoicePoolCount;
+    stats.allocatedVoicesIdle = mVoicePoolCount;
+    stats.voicePoolHits = mVoicePoolHits;
+    stats.voicePoolMisses = mVoicePoolMisses;
+
+    for (auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it)
+    {
+        assert(*it != nullptr);
+        (*it)->GatherStatistics(stats);
+    }
+
+    assert(stats.allocatedVoices == (mOneShotCount + mVoicePoolCount + mVoiceInstances));
+
+    return stats;
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::Apply3D(const AudioListener& listener, SoundEffectInstance* const* instances, const AudioEmitter* emitters, size_t count, bool rhcoords)
+{
+    if (!xaudio2 || !count)
+        return;
+
+    if (!instances || !emitters)
+        throw std::invalid_argument("Apply3D");
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
+    // The listener is converted to left-handed coordinates once for the whole batch
+    X3DAUDIO_LISTENER lhListener;
+    memcpy(&lhListener, &listener, sizeof(X3DAUDIO_LISTENER));
+    if (rhcoords)
+    {
+        lhListener.OrientFront.z = -listener.OrientFront.z;
+        lhListener.OrientTop.z = -listener.OrientTop.z;
+        lhListener.Position.z = -listener.Position.z;
+        lhListener.Velocity.z = -listener.Velocity.z;
+    }
+
+    // Zero is XAUDIO2_COMMIT_NOW
+    if (++mOperationSet == XAUDIO2_COMMIT_NOW)
+        ++mOperationSet;
+
+    const XMVECTOR listenerPos = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&listener.Position));
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        auto instance = instances[j];
+        if (!instance)
+            continue;
+
+        const auto& emitter = emitters[j];
+
+        bool audible = true;
+
+        const float range = AudibleRange(emitter);
+        if (range < FLT_MAX)
+        {
+            XMVECTOR delta = XMVectorSubtract(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&emitter.Position)), listenerPos);
+            audible = XMVector3LessOrEqual(XMVector3LengthSq(delta), XMVectorReplicate(range * range));
+        }
+
+        instance->Apply3D(lhListener, emitter, rhcoords, audible, mOperationSet);
+
+        if (audible)
+            ++mApply3DEmitters;
+        else
+            ++mApply3DCulled;
+    }
+
+    HRESULT hr = xaudio2->CommitChanges(mOperationSet);
+    ThrowIfFailed(hr);
+
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    mApply3DTime += ElapsedMS(start, end, mQPCFrequency);
+    ++mApply3DBatches;
+}
+
+
+void AudioEngine::Impl::TrimVoicePool()
+{
+    for (auto it = mNotifyObjects.begin(); it != mNotifyObjects.end(); ++it)
+    {
+        assert(*it != nullptr);
+        (*it)->OnTrim();
+    }
+
+    for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
+    {
+        for (auto node = it->second; node; )
+        {
+            auto next = node->next;
+            assert(node->voice != nullptr);
+            node->voice->DestroyVoice();
+            delete node;
+            node = next;
+        }
+    }
+    mVoicePool.clear();
+    mVoicePoolCount = 0;
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::ReserveVoices(const WAVEFORMATEX* wfx, size_t count)
+{
+    if (!wfx)
+        throw std::exception("Wave format is required\n");
+
+    if (!xaudio2 || mCriticalError || (mEngineFlags & AudioEngine_DisableVoiceReuse))
+        return;
+
+    const unsigned int voiceKey = makeVoiceKey(wfx);
+    if (!voiceKey)
+    {
+        DebugTrace("WARNING: ReserveVoices called for a format that can't be reused (tag %u, %u channels, %u-bit)\n",
+                   GetFormatTag(wfx), wfx->nChannels, wfx->wBitsPerSample);
+        return;
+    }
+
+    auto& head = mVoicePool[voiceKey];
+
+    size_t idle = 0;
+    for (auto node = head; node; node = node->next)
+    {
+        ++idle;
+    }
+
+    for (; idle < count; ++idle)
+    {
+        if ((mVoicePoolCount + mOneShotCount + 1) >= maxVoiceOneshots)
+        {
+            DebugTrace("WARNING: ReserveVoices stopped at the one-shot voice limit (%zu)\n", maxVoiceOneshots);
+            break;
+        }
+
+        auto node = CreatePooledVoice(voiceKey, wfx);
+
+        // Idle voices count as finished, the same as ones returned to the pool after playing
+        node->completed = true;
+        node->next = head;
+        head = node;
+        ++mVoicePoolCount;
+    }
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Impl::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, IXAudio2SourceVoice** voice, IXAudio2Voice* output)
+{
+    if (!wfx)
+        throw std::exception("Wave format is required\n");
 
     // No need to call IsValid on wfx because CreateSourceVoice will do that
 
@@ -964,12 +1792,16 @@ void AudioEngine::Impl::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INST
     if (!xaudio2 || mCriticalError)
         return;
 
+    if (output == mMasterVoice)
+        output = nullptr;
+
 #ifndef NDEBUG
     float maxFrequencyRatio = XAudio2SemitonesToFrequencyRatio(12);
     assert(maxFrequencyRatio <= XAUDIO2_DEFAULT_FREQ_RATIO);
 #endif
 
     unsigned int voiceKey = 0;
+    OneShotVoice* oneShot = nullptr;
     if (oneshot)
     {
         if (flags & (SoundEffectInstance_Use3D | SoundEffectInstance_ReverbUseFilters | SoundEffectInstance_NoSetPitch))
@@ -998,156 +1830,377 @@ void AudioEngine::Impl::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INST
             voiceKey = makeVoiceKey(wfx);
             if (voiceKey != 0)
             {
-                auto it = mVoicePool.find(voiceKey);
-                if (it != mVoicePool.end())
+                try
                 {
-                    // Found a matching (stopped) voice to reuse
-                    assert(it->second != nullptr);
-                    *voice = it->second;
-                    mVoicePool.erase(it);
+                    auto it = mVoicePool.find(voiceKey);
+                    if (it != mVoicePool.end() && it->second)
+                    {
+                        // Found a matching (stopped) voice to reuse
+                        oneShot = it->second;
+                        it->second = oneShot->next;
+                        --mVoicePoolCount;
+                        ++mVoicePoolHits;
 
-                    // Reset any volume/pitch-shifting
-                    HRESULT hr = (*voice)->SetVolume(1.f);
-                    ThrowIfFailed(hr);
+                        assert(oneShot->voice != nullptr);
+                        *voice = oneShot->voice;
 
-                    hr = (*voice)->SetFrequencyRatio(1.f);
-                    ThrowIfFailed(hr);
+                        RouteOneShot(oneShot, output);
 
-                    if (wfx->nChannels == 1 || wfx->nChannels == 2)
-                    {
-                        // Reset any panning
-                        float matrix[16] = {};
-                        ComputePan(0.f, wfx->nChannels, matrix);
+                        // Reset any volume/pitch-shifting
+                        HRESULT hr = (*voice)->SetVolume(1.f);
+                        ThrowIfFailed(hr);
 
-                        hr = (*voice)->SetOutputMatrix(nullptr, wfx->nChannels, masterChannels, matrix);
+                        hr = (*voice)->SetFrequencyRatio(1.f);
                         ThrowIfFailed(hr);
+
+                        if (wfx->nChannels == 1 || wfx->nChannels == 2)
+                        {
+                            // Reset any panning
+                            float matrix[16] = {};
+                            ComputePan(0.f, wfx->nChannels, matrix);
+
+                            hr = (*voice)->SetOutputMatrix(nullptr, wfx->nChannels, masterChannels, matrix);
+                            ThrowIfFailed(hr);
+                        }
+                    }
+                    else if ((mVoicePoolCount + mOneShotCount + 1) >= maxVoiceOneshots)
+                    {
+                        ++mVoicePoolMisses;
+                        DebugTrace("WARNING: Too many one-shot voices in use (%zu + %zu >= %zu); one-shot not played\n",
+                                   mVoicePoolCount, mOneShotCount + 1, maxVoiceOneshots);
+                        return;
+                    }
+                    else
+                    {
+                        ++mVoicePoolMisses;
+                        oneShot = CreatePooledVoice(voiceKey, wfx);
+                        *voice = oneShot->voice;
+
+                        RouteOneShot(oneShot, output);
+                    }
+
+                    assert(*voice != nullptr);
+                    HRESULT hr = (*voice)->SetSourceSampleRate(wfx->nSamplesPerSec);
+                    if (FAILED(hr))
+                    {
+                        DebugTrace("ERROR: SetSourceSampleRate failed with error %08X\n", hr);
+                        throw std::exception("SetSourceSampleRate");
                     }
                 }
-                else if ((mVoicePool.size() + mOneShots.size() + 1) >= maxVoiceOneshots)
+                catch (...)
                 {
-                    DebugTrace("WARNING: Too many one-shot voices in use (%zu + %zu >= %zu); one-shot not played\n",
-                               mVoicePool.size(), mOneShots.size() + 1, maxVoiceOneshots);
-                    return;
+                    // Not playing and not pooled, so it would otherwise leak against maxVoiceOneshots
+                    if (oneShot)
+                    {
+                        PoolOneShot(oneShot);
+                    }
+
+                    *voice = nullptr;
+                    throw;
                 }
-                else
-                {
-                    // makeVoiceKey already constrained the supported wfx formats to those supported for reuse
+            }
+        }
+    }
+
+    if (!*voice)
+    {
+        std::unique_ptr<OneShotVoice> node;
+        IXAudio2VoiceCallback* callback = &mVoiceCallback;
+
+        if (oneshot)
+        {
+            if ((mVoicePoolCount + mOneShotCount + 1) >= maxVoiceOneshots)
+            {
+                DebugTrace("WARNING: Too many one-shot voices in use (%zu + %zu >= %zu); one-shot not played; see TrimVoicePool\n",
+                           mVoicePoolCount, mOneShotCount + 1, maxVoiceOneshots);
+                return;
+            }
+
+            // Not reusable, so it is destroyed once it finishes
+            node = std::make_unique<OneShotVoice>(&mCompletedOneShots, 0u);
+            callback = node.get();
+        }
+        else if ((mVoiceInstances + 1) >= maxVoiceInstances)
+        {
+            DebugTrace("ERROR: Too many instance voices (%zu >= %zu); see TrimVoicePool\n", mVoiceInstances + 1, maxVoiceInstances);
+            throw std::exception("Too many instance voices");
+        }
+
+        UINT32 vflags = (flags & SoundEffectInstance_NoSetPitch) ? XAUDIO2_VOICE_NOPITCH : 0u;
+
+        HRESULT hr;
+        if (flags & SoundEffectInstance_Use3D)
+        {
+            XAUDIO2_SEND_DESCRIPTOR sendDescriptors[2];
+            sendDescriptors[0].Flags = sendDescriptors[1].Flags = (flags & SoundEffectInstance_ReverbUseFilters) ? XAUDIO2_SEND_USEFILTER : 0u;
+            sendDescriptors[0].pOutputVoice = (output) ? output : mMasterVoice;
+            sendDescriptors[1].pOutputVoice = mReverbVoice;
+            const XAUDIO2_VOICE_SENDS sendList = { mReverbVoice ? 2U : 1U, sendDescriptors };
+
+        #ifdef VERBOSE_TRACE
+            DebugTrace("INFO: Allocate voice 3D: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfx->wFormatTag,
+                       wfx->nChannels, wfx->wBitsPerSample, wfx->nBlockAlign, wfx->nSamplesPerSec);
+        #endif
+
+            hr = xaudio2->CreateSourceVoice(voice, wfx, vflags, XAUDIO2_DEFAULT_FREQ_RATIO, callback, &sendList, nullptr);
+        }
+        else
+        {
+        #ifdef VERBOSE_TRACE
+            DebugTrace("INFO: Allocate voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfx->wFormatTag,
+                       wfx->nChannels, wfx->wBitsPerSample, wfx->nBlockAlign, wfx->nSamplesPerSec);
+        #endif
+
+            XAUDIO2_SEND_DESCRIPTOR sendDescriptor = { 0, output };
+            const XAUDIO2_VOICE_SENDS sendList = { 1, &sendDescriptor };
+
+            hr = xaudio2->CreateSourceVoice(voice, wfx, vflags, XAUDIO2_DEFAULT_FREQ_RATIO, callback, (output) ? &sendList : nullptr, nullptr);
+        }
+
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateSourceVoice failed with error %08X\n", hr);
+            throw std::exception("CreateSourceVoice");
+        }
+        else if (!oneshot)
+        {
+            ++mVoiceInstances;
+        }
+        else
+        {
+            node->voice = *voice;
+            node->output = output;
+            oneShot = node.release();
+        }
+    }
+
+    if (oneShot)
+    {
+        assert(*voice != nullptr && oneShot->voice == *voice);
+
+        oneShot->completed = false;
+        oneShot->prev = nullptr;
+        oneShot->next = mOneShots;
+        if (mOneShots)
+        {
+            mOneShots->prev = oneShot;
+        }
+        mOneShots = oneShot;
+        ++mOneShotCount;
+    }
+}
+
+
+// Moves a one-shot voice to another submix bus, or back to the mastering voice for nullptr.
+_Use_decl_annotations_
+void AudioEngine::Impl::RouteOneShot(OneShotVoice* node, IXAudio2Voice* output)
+{
+    assert(node != nullptr && node->voice != nullptr);
+
+    if (node->output == output)
+        return;
+
+    XAUDIO2_SEND_DESCRIPTOR sendDescriptor = { 0, output };
+    const XAUDIO2_VOICE_SENDS sendList = { 1, &sendDescriptor };
+
+    HRESULT hr = node->voice->SetOutputVoices((output) ? &sendList : nullptr);
+    ThrowIfFailed(hr);
+
+    node->output = output;
+}
+
+
+// Creates a voice for the pool in the default format for its key; the caller sets the real sample rate.
+_Use_decl_annotations_
+OneShotVoice* AudioEngine::Impl::CreatePooledVoice(unsigned int voiceKey, const WAVEFORMATEX* wfx)
+{
+    // makeVoiceKey already constrained the supported wfx formats to those supported for reuse
+
+    char buff[64] = {};
+    auto wfmt = reinterpret_cast<WAVEFORMATEX*>(buff);
+
+    uint32_t tag = GetFormatTag(wfx);
+    switch (tag)
+    {
+        case WAVE_FORMAT_PCM:
+            CreateIntegerPCM(wfmt, defaultRate, wfx->nChannels, wfx->wBitsPerSample);
+            break;
+
+        case WAVE_FORMAT_IEEE_FLOAT:
+            CreateFloatPCM(wfmt, defaultRate, wfx->nChannels);
+            break;
+
+        case WAVE_FORMAT_ADPCM:
+        {
+            auto wfadpcm = reinterpret_cast<const ADPCMWAVEFORMAT*>(wfx);
+            CreateADPCM(wfmt, sizeof(buff), defaultRate, wfx->nChannels, wfadpcm->wSamplesPerBlock);
+        }
+        break;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        case WAVE_FORMAT_XMA2:
+            CreateXMA2(wfmt, sizeof(buff), defaultRate, wfx->nChannels, 65536, 2, 0);
+            break;
+    #endif
+    }
+
+#ifdef VERBOSE_TRACE
+    DebugTrace("INFO: Allocate reuse voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfmt->wFormatTag,
+               wfmt->nChannels, wfmt->wBitsPerSample, wfmt->nBlockAlign, wfmt->nSamplesPerSec);
+#endif
+
+    assert(voiceKey == makeVoiceKey(wfmt));
+
+    auto node = std::make_unique<OneShotVoice>(&mCompletedOneShots, voiceKey);
 
-                    char buff[64] = {};
-                    auto wfmt = reinterpret_cast<WAVEFORMATEX*>(buff);
+    HRESULT hr = xaudio2->CreateSourceVoice(&node->voice, wfmt, 0, XAUDIO2_DEFAULT_FREQ_RATIO, node.get(), nullptr, nullptr);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: CreateSourceVoice (reuse) failed with error %08X\n", hr);
+        throw std::exception("CreateSourceVoice");
+    }
 
-                    uint32_t tag = GetFormatTag(wfx);
-                    switch (tag)
-                    {
-                        case WAVE_FORMAT_PCM:
-                            CreateIntegerPCM(wfmt, defaultRate, wfx->nChannels, wfx->wBitsPerSample);
-                            break;
+    return node.release();
+}
 
-                        case WAVE_FORMAT_IEEE_FLOAT:
-                            CreateFloatPCM(wfmt, defaultRate, wfx->nChannels);
-                            break;
 
-                        case WAVE_FORMAT_ADPCM:
-                        {
-                            auto wfadpcm = reinterpret_cast<const ADPCMWAVEFORMAT*>(wfx);
-                            CreateADPCM(wfmt, sizeof(buff), defaultRate, wfx->nChannels, wfadpcm->wSamplesPerBlock);
-                        }
-                        break;
+// Returns a finished one-shot to the pool for its key, or destroys it. Voices that still report queued buffers
+// are held over to the next Update.
+void AudioEngine::Impl::RecycleOneShot(_In_ OneShotVoice* node) noexcept
+{
+    assert(node != nullptr && node->voice != nullptr);
 
-                    #if defined(_XBOX_ONE) && defined(_TITLE)
-                        case WAVE_FORMAT_XMA2:
-                            CreateXMA2(wfmt, sizeof(buff), defaultRate, wfx->nChannels, 65536, 2, 0);
-                            break;
-                        #endif
-                    }
+    XAUDIO2_VOICE_STATE xstate;
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    node->voice->GetState(&xstate, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+#else
+    node->voice->GetState(&xstate);
+#endif
+
+    if (xstate.BuffersQueued)
+    {
+        node->nextCompleted = mWindingDown;
+        mWindingDown = node;
+        return;
+    }
 
-                #ifdef VERBOSE_TRACE
-                    DebugTrace("INFO: Allocate reuse voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfmt->wFormatTag,
-                               wfmt->nChannels, wfmt->wBitsPerSample, wfmt->nBlockAlign, wfmt->nSamplesPerSec);
-                #endif
+    (void)node->voice->Stop(0);
+    UnlinkOneShot(node);
+    PoolOneShot(node);
+}
 
-                    assert(voiceKey == makeVoiceKey(wfmt));
 
-                    HRESULT hr = xaudio2->CreateSourceVoice(voice, wfmt, 0, XAUDIO2_DEFAULT_FREQ_RATIO, &mVoiceCallback, nullptr, nullptr);
-                    if (FAILED(hr))
-                    {
-                        DebugTrace("ERROR: CreateSourceVoice (reuse) failed with error %08X\n", hr);
-                        throw std::exception("CreateSourceVoice");
-                    }
-                }
+// Puts a one-shot voice that is not on the active list back into the voice pool, or destroys it if it can't be reused.
+void AudioEngine::Impl::PoolOneShot(_In_ OneShotVoice* node) noexcept
+{
+    assert(node != nullptr && node->voice != nullptr);
 
-                assert(*voice != nullptr);
-                HRESULT hr = (*voice)->SetSourceSampleRate(wfx->nSamplesPerSec);
-                if (FAILED(hr))
-                {
-                    DebugTrace("ERROR: SetSourceSampleRate failed with error %08X\n", hr);
-                    throw std::exception("SetSourceSampleRate");
-                }
-            }
-        }
+    if (node->voiceKey)
+    {
+        // Put voice back into voice pool for reuse since it has a non-zero voiceKey
+    #ifdef VERBOSE_TRACE
+        DebugTrace("INFO: One-shot voice being saved for reuse (%08X)\n", node->voiceKey);
+    #endif
+        auto& head = mVoicePool[node->voiceKey];
+        node->prev = nullptr;
+        node->next = head;
+        head = node;
+        ++mVoicePoolCount;
+    }
+    else
+    {
+        // Voice is to be destroyed rather than reused
+    #ifdef VERBOSE_TRACE
+        DebugTrace("INFO: Destroying one-shot voice\n");
+    #endif
+        node->voice->DestroyVoice();
+        delete node;
     }
+}
 
-    if (!*voice)
+
+// Takes back a one-shot voice whose caller failed to start it, so it does not stay on the active list forever.
+void AudioEngine::Impl::ReleaseOneShot(_In_ IXAudio2SourceVoice* voice) noexcept
+{
+    if (!voice)
+        return;
+
+    for (auto node = mOneShots; node; node = node->next)
     {
-        if (oneshot)
+        if (node->voice == voice)
         {
-            if ((mVoicePool.size() + mOneShots.size() + 1) >= maxVoiceOneshots)
+            // Claiming completion keeps OnStreamEnd from queuing the node as well.
+            if (!node->completed.exchange(true))
             {
-                DebugTrace("WARNING: Too many one-shot voices in use (%zu + %zu >= %zu); one-shot not played; see TrimVoicePool\n",
-                           mVoicePool.size(), mOneShots.size() + 1, maxVoiceOneshots);
-                return;
+                RecycleOneShot(node);
             }
+            return;
         }
-        else if ((mVoiceInstances + 1) >= maxVoiceInstances)
-        {
-            DebugTrace("ERROR: Too many instance voices (%zu >= %zu); see TrimVoicePool\n", mVoiceInstances + 1, maxVoiceInstances);
-            throw std::exception("Too many instance voices");
-        }
+    }
+}
 
-        UINT32 vflags = (flags & SoundEffectInstance_NoSetPitch) ? XAUDIO2_VOICE_NOPITCH : 0u;
 
-        HRESULT hr;
-        if (flags & SoundEffectInstance_Use3D)
-        {
-            XAUDIO2_SEND_DESCRIPTOR sendDescriptors[2];
-            sendDescriptors[0].Flags = sendDescriptors[1].Flags = (flags & SoundEffectInstance_ReverbUseFilters) ? XAUDIO2_SEND_USEFILTER : 0u;
-            sendDescriptors[0].pOutputVoice = mMasterVoice;
-            sendDescriptors[1].pOutputVoice = mReverbVoice;
-            const XAUDIO2_VOICE_SENDS sendList = { mReverbVoice ? 2U : 1U, sendDescriptors };
+void AudioEngine::Impl::UnlinkOneShot(_In_ OneShotVoice* node) noexcept
+{
+    if (node->prev)
+    {
+        node->prev->next = node->next;
+    }
+    else
+    {
+        assert(mOneShots == node);
+        mOneShots = node->next;
+    }
 
-        #ifdef VERBOSE_TRACE
-            DebugTrace("INFO: Allocate voice 3D: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfx->wFormatTag,
-                       wfx->nChannels, wfx->wBitsPerSample, wfx->nBlockAlign, wfx->nSamplesPerSec);
-        #endif
+    if (node->next)
+    {
+        node->next->prev = node->prev;
+    }
 
-            hr = xaudio2->CreateSourceVoice(voice, wfx, vflags, XAUDIO2_DEFAULT_FREQ_RATIO, &mVoiceCallback, &sendList, nullptr);
-        }
-        else
-        {
-        #ifdef VERBOSE_TRACE
-            DebugTrace("INFO: Allocate voice: Format Tag %u, %u channels, %u-bit, %u blkalign, %u Hz\n", wfx->wFormatTag,
-                       wfx->nChannels, wfx->wBitsPerSample, wfx->nBlockAlign, wfx->nSamplesPerSec);
-        #endif
+    node->prev = node->next = nullptr;
 
-            hr = xaudio2->CreateSourceVoice(voice, wfx, vflags, XAUDIO2_DEFAULT_FREQ_RATIO, &mVoiceCallback, nullptr, nullptr);
-        }
+    assert(mOneShotCount > 0);
+    --mOneShotCount;
+}
 
-        if (FAILED(hr))
-        {
-            DebugTrace("ERROR: CreateSourceVoice failed with error %08X\n", hr);
-            throw std::exception("CreateSourceVoice");
-        }
-        else if (!oneshot)
+
+void AudioEngine::Impl::DestroyOneShots() noexcept
+{
+    std::vector<OneShotVoice*> nodes;
+    nodes.reserve(mOneShotCount + mVoicePoolCount);
+
+    for (auto node = mOneShots; node; node = node->next)
+    {
+        nodes.push_back(node);
+    }
+
+    for (auto it = mVoicePool.begin(); it != mVoicePool.end(); ++it)
+    {
+        for (auto node = it->second; node; node = node->next)
         {
-            ++mVoiceInstances;
+            nodes.push_back(node);
         }
     }
 
-    if (oneshot)
+    // No callbacks arrive once the voices are gone, so the completion queue can be dropped before the nodes are
+    for (auto it : nodes)
     {
-        assert(*voice != nullptr);
-        mOneShots.emplace_back(std::make_pair(voiceKey, *voice));
+        assert(it->voice != nullptr);
+        it->voice->DestroyVoice();
     }
+
+    (void)mCompletedOneShots.PopAll();
+    mWindingDown = nullptr;
+
+    for (auto it : nodes)
+    {
+        delete it;
+    }
+
+    mOneShots = nullptr;
+    mOneShotCount = 0;
+    mVoicePool.clear();
+    mVoicePoolCount = 0;
 }
 
 
@@ -1157,9 +2210,9 @@ void AudioEngine::Impl::DestroyVoice(_In_ IXAudio2SourceVoice* voice)
         return;
 
 #ifndef NDEBUG
-    for (auto it = mOneShots.cbegin(); it != mOneShots.cend(); ++it)
+    for (auto node = mOneShots; node; node = node->next)
     {
-        if (it->second == voice)
+        if (node->voice == voice)
         {
             DebugTrace("ERROR: DestroyVoice should not be called for a one-shot voice\n");
             throw std::exception("DestroyVoice");
@@ -1168,10 +2221,13 @@ void AudioEngine::Impl::DestroyVoice(_In_ IXAudio2SourceVoice* voice)
 
     for (auto it = mVoicePool.cbegin(); it != mVoicePool.cend(); ++it)
     {
-        if (it->second == voice)
+        for (auto node = it->second; node; node = node->next)
         {
-            DebugTrace("ERROR: DestroyVoice should not be called for a one-shot voice; see TrimVoicePool\n");
-            throw std::exception("DestroyVoice");
+            if (node->voice == voice)
+            {
+                DebugTrace("ERROR: DestroyVoice should not be called for a one-shot voice; see TrimVoicePool\n");
+                throw std::exception("DestroyVoice");
+            }
         }
     }
 #endif
@@ -1202,37 +2258,162 @@ void AudioEngine::Impl::UnregisterNotify(_In_ IVoiceNotify* notify, bool usesOne
     // Check for any pending one-shots for this notification object
     if (usesOneShots)
     {
-        bool setevent = false;
-
-        for (auto it = mOneShots.begin(); it != mOneShots.end(); ++it)
+        for (auto node = mOneShots; node; node = node->next)
         {
-            assert(it->second != nullptr);
+            assert(node->voice != nullptr);
 
             XAUDIO2_VOICE_STATE state;
         #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
-            it->second->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+            node->voice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
         #else
-            it->second->GetState(&state);
+            node->voice->GetState(&state);
         #endif
 
             if (state.pCurrentBufferContext == notify)
             {
-                (void)it->second->Stop(0);
-                (void)it->second->FlushSourceBuffers();
-                setevent = true;
+                (void)node->voice->Stop(0);
+                (void)node->voice->FlushSourceBuffers();
+
+                // A flushed stream may never report its end, so queue it for the next Update
+                node->NotifyComplete();
             }
         }
+    }
+
+    if (usesUpdate)
+    {
+        mNotifyUpdates.erase(notify);
+    }
+}
+
+
+// Ranks the virtual instances that are playing, and within the instance voice limit left over by everything else,
+// gives voices to the most audible. Those that lose out hand theirs on where the format matches, so most changes
+// don't create or destroy any voices.
+void AudioEngine::Impl::UpdateVirtualVoices()
+{
+    if (mVirtualVoices.empty() || !xaudio2 || mCriticalError)
+        return;
+
+    const size_t limit = (maxVoiceInstances == SIZE_MAX) ? SIZE_MAX : ((maxVoiceInstances > 0) ? (maxVoiceInstances - 1) : 0);
+
+    mRankedVoices.clear();
 
-        if (setevent)
+    size_t held = 0;
+    size_t idle = 0;
+    for (auto it = mVirtualVoices.begin(); it != mVirtualVoices.end(); ++it)
+    {
+        auto instance = *it;
+        assert(instance != nullptr);
+
+        instance->UpdateVirtual();
+
+        const float audibility = instance->GetAudibility();
+        if (audibility >= 0.f)
+        {
+            mRankedVoices.emplace_back(audibility, instance);
+            if (instance->HasVoice())
+                ++held;
+        }
+        else if (instance->HasVoice())
         {
-            // Trigger scan on next call to Update...
-            SetEvent(mVoiceCallback.mBufferEnd.get());
+            ++idle;
         }
     }
 
-    if (usesUpdate)
+    if (mRankedVoices.empty())
+        return;
+
+    // Voices held by other instances are out of reach, apart from those idle ones which virtual instances hold
+    assert(mVoiceInstances >= held + idle);
+    const size_t others = mVoiceInstances - held - idle;
+    size_t available = (limit > others) ? (limit - others) : 0;
+
+    if (available < mRankedVoices.size())
     {
-        mNotifyUpdates.erase(notify);
+        std::nth_element(mRankedVoices.begin(), mRankedVoices.begin() + ptrdiff_t(available), mRankedVoices.end(),
+            [](const rankedvoice_t& a, const rankedvoice_t& b) noexcept { return a.first > b.first; });
+    }
+    else
+    {
+        available = mRankedVoices.size();
+    }
+
+    size_t wanted = 0;
+    for (size_t j = 0; j < available; ++j)
+    {
+        if (!mRankedVoices[j].second->HasVoice())
+            ++wanted;
+    }
+
+    if (!wanted)
+    {
+        // Nobody is waiting, so anything over the limit keeps playing
+        return;
+    }
+
+    mDonatedVoices.clear();
+
+    for (size_t j = available; j < mRankedVoices.size(); ++j)
+    {
+        auto instance = mRankedVoices[j].second;
+        if (instance->HasVoice())
+        {
+            mDonatedVoices.emplace_back(instance->Virtualize(), instance);
+        }
+    }
+
+    // Idle voices are only given up if there isn't room otherwise
+    if (idle > 0 && (mVoiceInstances - mDonatedVoices.size() + wanted) > limit)
+    {
+        for (auto it = mVirtualVoices.begin(); it != mVirtualVoices.end(); ++it)
+        {
+            auto instance = *it;
+            if (instance->GetAudibility() < 0.f && instance->HasVoice())
+            {
+                mDonatedVoices.emplace_back(instance->Virtualize(), instance);
+            }
+        }
+    }
+
+    // Matching formats first, so the voice carries on with a different sound
+    for (size_t j = 0; j < available; ++j)
+    {
+        auto instance = mRankedVoices[j].second;
+        if (instance->HasVoice() || mDonatedVoices.empty())
+            continue;
+
+        for (auto it = mDonatedVoices.begin(); it != mDonatedVoices.end(); ++it)
+        {
+            if (IsVoiceCompatible(instance, it->second))
+            {
+                auto voice = it->first;
+                *it = mDonatedVoices.back();
+                mDonatedVoices.pop_back();
+
+                instance->Devirtualize(voice);
+                break;
+            }
+        }
+    }
+
+    for (auto it = mDonatedVoices.begin(); it != mDonatedVoices.end(); ++it)
+    {
+        assert(it->first != nullptr);
+        DestroyVoice(it->first);
+    }
+    mDonatedVoices.clear();
+
+    for (size_t j = 0; j < available; ++j)
+    {
+        auto instance = mRankedVoices[j].second;
+        if (instance->HasVoice())
+            continue;
+
+        if (mVoiceInstances >= limit)
+            break;
+
+        instance->Devirtualize(nullptr);
     }
 }
 
@@ -1267,6 +2448,11 @@ AudioEngine::AudioEngine(AUDIO_ENGINE_FLAGS flags, const WAVEFORMATEX* wfx, cons
             throw std::exception("AudioEngine");
         }
     }
+
+    if (flags & AudioEngine_UpdateThread)
+    {
+        pImpl->StartUpdateThread();
+    }
 }
 
 
@@ -1298,13 +2484,36 @@ AudioEngine::~AudioEngine()
 // Public methods.
 bool AudioEngine::Update()
 {
+    if (pImpl->mEngineFlags & AudioEngine_UpdateThread)
+    {
+        auto lock = pImpl->LockUpdates();
+        return pImpl->xaudio2 && !pImpl->mCriticalError;
+    }
+
     return pImpl->Update();
 }
 
 
+void AudioEngine::Post(std::function<void __cdecl()> command)
+{
+    pImpl->Post(std::move(command));
+}
+
+
+void AudioEngine::SetUpdateInterval(unsigned int milliseconds)
+{
+    if (!milliseconds)
+        throw std::invalid_argument("SetUpdateInterval");
+
+    pImpl->mUpdateInterval = milliseconds;
+}
+
+
 _Use_decl_annotations_
 bool AudioEngine::Reset(const WAVEFORMATEX* wfx, const wchar_t* deviceId)
 {
+    auto lock = pImpl->LockUpdates();
+
     if (pImpl->xaudio2)
     {
         DebugTrace("WARNING: Called Reset for active audio graph; going silent in preparation for migration\n");
@@ -1406,17 +2615,90 @@ void AudioEngine::SetReverb(const XAUDIO2FX_REVERB_PARAMETERS* native)
 
 void AudioEngine::SetMasteringLimit(int release, int loudness)
 {
+    auto lock = pImpl->LockUpdates();
     pImpl->SetMasteringLimit(release, loudness);
 }
 
 
+// Submix buses.
+_Use_decl_annotations_
+IXAudio2SubmixVoice* AudioEngine::CreateBus(const char* name, const char* parent, const XAUDIO2_EFFECT_CHAIN* effects)
+{
+    auto lock = pImpl->LockUpdates();
+    return pImpl->CreateBus(name, parent, effects);
+}
+
+
+_Use_decl_annotations_
+IXAudio2SubmixVoice* AudioEngine::GetBus(const char* name) const noexcept
+{
+    auto lock = pImpl->LockUpdates();
+    return pImpl->GetBus(name);
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::SetBusVolume(const char* name, float volume)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->SetBusVolume(name, volume);
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::SetBusSend(const char* name, const char* target, float level)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->SetBusSend(name, target, level);
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::DestroyBus(const char* name)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->DestroyBus(name);
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::Apply3D(const AudioListener& listener, SoundEffectInstance* const* instances, const AudioEmitter* emitters, size_t count, bool rhcoords)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->Apply3D(listener, instances, emitters, count, rhcoords);
+}
+
+
 // Public accessors.
 AudioStatistics AudioEngine::GetStatistics() const
 {
+    auto lock = pImpl->LockUpdates();
     return pImpl->GetStatistics();
 }
 
 
+AudioPerformanceData AudioEngine::GetPerformanceData() const noexcept
+{
+    auto lock = pImpl->LockUpdates();
+    return pImpl->GetPerformanceData();
+}
+
+
+void AudioEngine::SetPerformanceHistory(size_t frames)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->SetPerformanceHistory(frames);
+}
+
+
+_Use_decl_annotations_
+size_t AudioEngine::GetPerformanceHistory(AudioPerformanceData* frames, size_t count) const noexcept
+{
+    auto lock = pImpl->LockUpdates();
+    return pImpl->GetPerformanceHistory(frames, count);
+}
+
+
 WAVEFORMATEXTENSIBLE AudioEngine::GetOutputFormat() const noexcept
 {
     WAVEFORMATEXTENSIBLE wfx = {};
@@ -1488,35 +2770,82 @@ void AudioEngine::SetMaxVoicePool(size_t maxOneShots, size_t maxInstances)
 
 void AudioEngine::TrimVoicePool()
 {
+    auto lock = pImpl->LockUpdates();
     pImpl->TrimVoicePool();
 }
 
 
 _Use_decl_annotations_
-void AudioEngine::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, IXAudio2SourceVoice** voice)
+void AudioEngine::ReserveVoices(const WAVEFORMATEX* wfx, size_t count)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->ReserveVoices(wfx, count);
+}
+
+
+_Use_decl_annotations_
+void AudioEngine::AllocateVoice(const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, IXAudio2SourceVoice** voice, IXAudio2Voice* output)
 {
-    pImpl->AllocateVoice(wfx, flags, oneshot, voice);
+    auto lock = pImpl->LockUpdates();
+    pImpl->AllocateVoice(wfx, flags, oneshot, voice, output);
 }
 
 
 void AudioEngine::DestroyVoice(_In_ IXAudio2SourceVoice* voice)
 {
+    auto lock = pImpl->LockUpdates();
     pImpl->DestroyVoice(voice);
 }
 
 
+void AudioEngine::ReleaseOneShot(_In_ IXAudio2SourceVoice* voice)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->ReleaseOneShot(voice);
+}
+
+
 void AudioEngine::RegisterNotify(_In_ IVoiceNotify* notify, bool usesUpdate)
 {
+    auto lock = pImpl->LockUpdates();
     pImpl->RegisterNotify(notify, usesUpdate);
 }
 
 
 void AudioEngine::UnregisterNotify(_In_ IVoiceNotify* notify, bool oneshots, bool usesUpdate)
 {
+    auto lock = pImpl->LockUpdates();
     pImpl->UnregisterNotify(notify, oneshots, usesUpdate);
 }
 
 
+void AudioEngine::RegisterVirtual(_In_ IVirtualVoice* instance)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->RegisterVirtual(instance);
+}
+
+
+void AudioEngine::UnregisterVirtual(_In_ IVirtualVoice* instance)
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->UnregisterVirtual(instance);
+}
+
+
+void AudioEngine::UpdateVirtualVoices()
+{
+    auto lock = pImpl->LockUpdates();
+    pImpl->UpdateVirtualVoices();
+}
+
+
+void AudioEngine::ReportStreamStall() noexcept
+{
+    pImpl->ReportStreamStall();
+}
+
+
 IXAudio2* AudioEngine::GetInterface() const noexcept
 {
     return pImpl->xaudio2.Get();
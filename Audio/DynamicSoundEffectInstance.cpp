@@ -11,6 +11,9 @@
 #include "pch.h"
 #include "SoundCommon.h"
 
+#include <atomic>
+#include <thread>
+
 using namespace DirectX;
 
 
@@ -27,31 +30,21 @@ public:
          int sampleRate, int channels, int sampleBits, SOUND_EFFECT_INSTANCE_FLAGS flags) :
         mBase(),
         mBufferNeeded(nullptr),
-        mObject(object)
+        mObject(object),
+        mWaveFormat{},
+        mRing(false),
+        mRingBufferBytes(0),
+        mRingBufferCount(0),
+        mRingFill(0),
+        mWriteIndex(0),
+        mReleaseIndex(0),
+        mSubmitIndex(0),
+        mBuffersEnded(0),
+        mRingActive(false),
+        mPumpLock(false),
+        mPumpPending(false)
     {
-        if ((sampleRate < XAUDIO2_MIN_SAMPLE_RATE)
-            || (sampleRate > XAUDIO2_MAX_SAMPLE_RATE))
-        {
-            DebugTrace("DynamicSoundEffectInstance sampleRate must be in range %u...%u\n", XAUDIO2_MIN_SAMPLE_RATE, XAUDIO2_MAX_SAMPLE_RATE);
-            throw std::invalid_argument("DynamicSoundEffectInstance");
-        }
-
-        if (!channels || (channels > 8))
-        {
-            DebugTrace("DynamicSoundEffectInstance channels must be in range 1...8\n");
-            throw std::invalid_argument("DynamicSoundEffectInstance");
-        }
-
-        switch (sampleBits)
-        {
-            case 8:
-            case 16:
-                break;
-
-            default:
-                DebugTrace("DynamicSoundEffectInstance sampleBits must be 8-bit or 16-bit\n");
-                throw std::invalid_argument("DynamicSoundEffectInstance");
-        }
+        CheckFormat(sampleRate, channels, sampleBits);
 
         mBufferEvent.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
         if (!mBufferEvent)
@@ -69,34 +62,103 @@ public:
         mBufferNeeded = bufferNeeded;
     }
 
+    Impl(_In_ AudioEngine* engine,
+         _In_ DynamicSoundEffectInstance* object,
+         int sampleRate, int channels, int sampleBits, size_t ringBufferBytes, size_t ringBufferCount, SOUND_EFFECT_INSTANCE_FLAGS flags) :
+        mBase(),
+        mBufferNeeded(nullptr),
+        mObject(object),
+        mWaveFormat{},
+        mRing(true),
+        mRingBufferBytes(0),
+        mRingBufferCount(0),
+        mRingFill(0),
+        mWriteIndex(0),
+        mReleaseIndex(0),
+        mSubmitIndex(0),
+        mBuffersEnded(0),
+        mRingActive(false),
+        mPumpLock(false),
+        mPumpPending(false)
+    {
+        CheckFormat(sampleRate, channels, sampleBits);
+
+        if (ringBufferCount < 2 || ringBufferCount > XAUDIO2_MAX_QUEUED_BUFFERS)
+        {
+            DebugTrace("DynamicSoundEffectInstance ringBufferCount must be in range 2...%u\n", XAUDIO2_MAX_QUEUED_BUFFERS);
+            throw std::invalid_argument("DynamicSoundEffectInstance");
+        }
+
+        CreateIntegerPCM(&mWaveFormat, sampleRate, channels, sampleBits);
+
+        // Every buffer holds whole sample frames
+        ringBufferBytes -= ringBufferBytes % mWaveFormat.nBlockAlign;
+        if (!ringBufferBytes || ringBufferBytes > UINT32_MAX || (ringBufferBytes * ringBufferCount) > UINT32_MAX)
+        {
+            DebugTrace("DynamicSoundEffectInstance ringBufferBytes must hold at least one sample frame (%u bytes)\n", mWaveFormat.nBlockAlign);
+            throw std::invalid_argument("DynamicSoundEffectInstance");
+        }
+
+        mRingBufferBytes = static_cast<uint32_t>(ringBufferBytes);
+        mRingBufferCount = static_cast<uint32_t>(ringBufferCount);
+
+        // All buffer storage is allocated up front, so nothing is allocated per write or submit
+        mRingMemory.reset(new uint8_t[ringBufferBytes * ringBufferCount]);
+
+        assert(engine != nullptr);
+        engine->RegisterNotify(this, false);
+
+        mBase.Initialize(engine, &mWaveFormat, flags);
+    }
+
     virtual ~Impl() override
     {
+        LockRing();
+        mRingActive = false;
         mBase.DestroyVoice();
+        ResetRing();
+        UnlockRing();
 
         if (mBase.engine)
         {
-            mBase.engine->UnregisterNotify(this, false, true);
+            mBase.engine->UnregisterNotify(this, false, !mRing);
             mBase.engine = nullptr;
         }
     }
 
     void Play();
 
+    void Stop(bool immediate) noexcept;
+
     void Resume();
 
     void SubmitBuffer(_In_reads_bytes_(audioBytes) const uint8_t* pAudioData, uint32_t offset, size_t audioBytes);
 
+    size_t WriteRingBuffer(_In_reads_bytes_(audioBytes) const uint8_t* pAudioData, size_t audioBytes);
+
     const WAVEFORMATEX* GetFormat() const noexcept { return &mWaveFormat; }
 
     // IVoiceNotify
     virtual void __cdecl OnBufferEnd() override
     {
-        SetEvent(mBufferEvent.get());
+        if (mRing)
+        {
+            // Called on XAudio2's worker thread, which refills the voice straight away
+            ++mBuffersEnded;
+            RequestPump();
+        }
+        else
+        {
+            SetEvent(mBufferEvent.get());
+        }
     }
 
     virtual void __cdecl OnCriticalError() override
     {
+        LockRing();
         mBase.OnCriticalError();
+        ResetRing();
+        UnlockRing();
     }
 
     virtual void __cdecl OnReset() override
@@ -108,12 +170,21 @@ public:
 
     virtual void __cdecl OnDestroyEngine() noexcept override
     {
+        LockRing();
         mBase.OnDestroy();
+        ResetRing();
+        UnlockRing();
     }
 
     virtual void __cdecl OnTrim() override
     {
+        LockRing();
         mBase.OnTrim();
+        if (!mBase.voice)
+        {
+            ResetRing();
+        }
+        UnlockRing();
     }
 
     virtual void __cdecl GatherStatistics(AudioStatistics& stats) const noexcept override
@@ -124,15 +195,92 @@ public:
     SoundEffectInstanceBase                             mBase;
 
 private:
+    static void CheckFormat(int sampleRate, int channels, int sampleBits);
+
+    // In ring-buffer mode the voice is refilled by whichever thread gets there first: the writer, XAudio2's
+    // callback, or Play. The one holding mPumpLock does the work; the others leave mPumpPending set so it goes
+    // around again. Anything that changes the voice itself takes the lock as well.
+    void RequestPump() noexcept;
+    void PumpLocked() noexcept;
+    void LockRing() noexcept;
+    void UnlockRing() noexcept;
+    void ResetRing() noexcept;
+
     ScopedHandle                                        mBufferEvent;
     std::function<void(DynamicSoundEffectInstance*)>    mBufferNeeded;
     DynamicSoundEffectInstance*                         mObject;
     WAVEFORMATEX                                        mWaveFormat;
+
+    bool                                                mRing;
+    std::unique_ptr<uint8_t[]>                          mRingMemory;
+    uint32_t                                            mRingBufferBytes;
+    uint32_t                                            mRingBufferCount;
+    uint32_t                                            mRingFill;          // Writer only
+    std::atomic<uint32_t>                               mWriteIndex;        // Buffers filled by the writer
+    std::atomic<uint32_t>                               mReleaseIndex;      // Buffers the voice is done with
+    uint32_t                                            mSubmitIndex;       // Buffers queued on the voice, under mPumpLock
+    std::atomic<uint32_t>                               mBuffersEnded;
+    std::atomic<bool>                                   mRingActive;
+    std::atomic<bool>                                   mPumpLock;
+    std::atomic<bool>                                   mPumpPending;
 };
 
 
+void DynamicSoundEffectInstance::Impl::CheckFormat(int sampleRate, int channels, int sampleBits)
+{
+    if ((sampleRate < XAUDIO2_MIN_SAMPLE_RATE)
+        || (sampleRate > XAUDIO2_MAX_SAMPLE_RATE))
+    {
+        DebugTrace("DynamicSoundEffectInstance sampleRate must be in range %u...%u\n", XAUDIO2_MIN_SAMPLE_RATE, XAUDIO2_MAX_SAMPLE_RATE);
+        throw std::invalid_argument("DynamicSoundEffectInstance");
+    }
+
+    if (!channels || (channels > 8))
+    {
+        DebugTrace("DynamicSoundEffectInstance channels must be in range 1...8\n");
+        throw std::invalid_argument("DynamicSoundEffectInstance");
+    }
+
+    switch (sampleBits)
+    {
+        case 8:
+        case 16:
+            break;
+
+        default:
+            DebugTrace("DynamicSoundEffectInstance sampleBits must be 8-bit or 16-bit\n");
+            throw std::invalid_argument("DynamicSoundEffectInstance");
+    }
+}
+
+
 void DynamicSoundEffectInstance::Impl::Play()
 {
+    if (mRing)
+    {
+        LockRing();
+        try
+        {
+            if (!mBase.voice)
+            {
+                mBase.AllocateVoice(&mWaveFormat);
+            }
+
+            (void)mBase.Play();
+        }
+        catch (...)
+        {
+            UnlockRing();
+            throw;
+        }
+
+        mRingActive = mBase.voice && (mBase.state == PLAYING);
+        UnlockRing();
+
+        RequestPump();
+        return;
+    }
+
     if (!mBase.voice)
     {
         mBase.AllocateVoice(&mWaveFormat);
@@ -147,8 +295,39 @@ void DynamicSoundEffectInstance::Impl::Play()
 }
 
 
+void DynamicSoundEffectInstance::Impl::Stop(bool immediate) noexcept
+{
+    bool looped = false;
+
+    if (mRing)
+    {
+        // Whatever was written but not yet queued stays in the ring for the next Play
+        LockRing();
+        mRingActive = false;
+        mBase.Stop(immediate, looped);
+        UnlockRing();
+
+        RequestPump();
+        return;
+    }
+
+    mBase.Stop(immediate, looped);
+}
+
+
 void DynamicSoundEffectInstance::Impl::Resume()
 {
+    if (mRing)
+    {
+        LockRing();
+        mBase.Resume();
+        mRingActive = mBase.voice && (mBase.state == PLAYING);
+        UnlockRing();
+
+        RequestPump();
+        return;
+    }
+
     if (mBase.voice && (mBase.state == PAUSED))
     {
         mBase.Resume();
@@ -164,6 +343,12 @@ void DynamicSoundEffectInstance::Impl::Resume()
 _Use_decl_annotations_
 void DynamicSoundEffectInstance::Impl::SubmitBuffer(const uint8_t* pAudioData, uint32_t offset, size_t audioBytes)
 {
+    if (mRing)
+    {
+        DebugTrace("ERROR: SubmitBuffer can't be used with a ring-buffer DynamicSoundEffectInstance; see WriteRingBuffer\n");
+        throw std::exception("SubmitBuffer");
+    }
+
     if (!pAudioData || !audioBytes)
         throw std::exception("Invalid audio data buffer");
 
@@ -197,6 +382,121 @@ void DynamicSoundEffectInstance::Impl::SubmitBuffer(const uint8_t* pAudioData, u
 }
 
 
+_Use_decl_annotations_
+size_t DynamicSoundEffectInstance::Impl::WriteRingBuffer(const uint8_t* pAudioData, size_t audioBytes)
+{
+    if (!mRing)
+    {
+        DebugTrace("ERROR: WriteRingBuffer requires a DynamicSoundEffectInstance created in ring-buffer mode\n");
+        throw std::exception("WriteRingBuffer");
+    }
+
+    if (!pAudioData || !audioBytes)
+        return 0;
+
+    size_t written = 0;
+    bool published = false;
+
+    while (written < audioBytes)
+    {
+        const uint32_t index = mWriteIndex.load(std::memory_order_relaxed);
+        if ((index - mReleaseIndex.load(std::memory_order_acquire)) >= mRingBufferCount)
+            break;
+
+        uint8_t* dest = mRingMemory.get() + size_t(index % mRingBufferCount) * mRingBufferBytes + mRingFill;
+        const size_t bytes = std::min<size_t>(audioBytes - written, mRingBufferBytes - mRingFill);
+        memcpy(dest, pAudioData + written, bytes);
+
+        written += bytes;
+        mRingFill += static_cast<uint32_t>(bytes);
+
+        if (mRingFill == mRingBufferBytes)
+        {
+            mRingFill = 0;
+            mWriteIndex.store(index + 1, std::memory_order_release);
+            published = true;
+        }
+    }
+
+    if (published)
+    {
+        RequestPump();
+    }
+
+    return written;
+}
+
+
+void DynamicSoundEffectInstance::Impl::RequestPump() noexcept
+{
+    mPumpPending = true;
+
+    while (mPumpPending && !mPumpLock.exchange(true, std::memory_order_acquire))
+    {
+        mPumpPending = false;
+        PumpLocked();
+        mPumpLock.store(false, std::memory_order_release);
+    }
+}
+
+
+void DynamicSoundEffectInstance::Impl::PumpLocked() noexcept
+{
+    // XAudio2 finishes buffers in the order they were queued
+    const uint32_t ended = mBuffersEnded.exchange(0);
+    if (ended)
+    {
+        const uint32_t release = mReleaseIndex.load(std::memory_order_relaxed);
+        mReleaseIndex.store(release + std::min(ended, mSubmitIndex - release), std::memory_order_release);
+    }
+
+    if (!mRingActive || !mBase.voice)
+        return;
+
+    const uint32_t write = mWriteIndex.load(std::memory_order_acquire);
+    while (mSubmitIndex != write)
+    {
+        XAUDIO2_BUFFER buffer = {};
+        buffer.AudioBytes = mRingBufferBytes;
+        buffer.pAudioData = mRingMemory.get() + size_t(mSubmitIndex % mRingBufferCount) * mRingBufferBytes;
+        buffer.pContext = static_cast<IVoiceNotify*>(this);
+
+        HRESULT hr = mBase.voice->SubmitSourceBuffer(&buffer, nullptr);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: DynamicSoundEffectInstance failed (%08X) when submitting ring buffer\n", static_cast<unsigned int>(hr));
+            break;
+        }
+
+        ++mSubmitIndex;
+    }
+}
+
+
+void DynamicSoundEffectInstance::Impl::LockRing() noexcept
+{
+    while (mPumpLock.exchange(true, std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+
+void DynamicSoundEffectInstance::Impl::UnlockRing() noexcept
+{
+    mPumpLock.store(false, std::memory_order_release);
+}
+
+
+// With the voice gone there will be no more buffer-end callbacks, so every queued buffer is free again.
+void DynamicSoundEffectInstance::Impl::ResetRing() noexcept
+{
+    mRingActive = false;
+    mBuffersEnded = 0;
+    mReleaseIndex.store(mSubmitIndex, std::memory_order_release);
+}
+
+
 void DynamicSoundEffectInstance::Impl::OnUpdate()
 {
     DWORD result = WaitForSingleObjectEx(mBufferEvent.get(), 0, FALSE);
@@ -235,6 +535,14 @@ DynamicSoundEffectInstance::DynamicSoundEffectInstance(AudioEngine* engine,
 {
 }
 
+_Use_decl_annotations_
+DynamicSoundEffectInstance::DynamicSoundEffectInstance(AudioEngine* engine,
+                                                       int sampleRate, int channels, int sampleBits,
+                                                       size_t ringBufferBytes, size_t ringBufferCount, SOUND_EFFECT_INSTANCE_FLAGS flags) :
+    pImpl(std::make_unique<Impl>(engine, this, sampleRate, channels, sampleBits, ringBufferBytes, ringBufferCount, flags))
+{
+}
+
 
 // Move constructor.
 DynamicSoundEffectInstance::DynamicSoundEffectInstance(DynamicSoundEffectInstance&& moveFrom) noexcept
@@ -266,8 +574,7 @@ void DynamicSoundEffectInstance::Play()
 
 void DynamicSoundEffectInstance::Stop(bool immediate) noexcept
 {
-    bool looped = false;
-    pImpl->mBase.Stop(immediate, looped);
+    pImpl->Stop(immediate);
 }
 
 
@@ -301,6 +608,13 @@ void DynamicSoundEffectInstance::SetPan(float pan)
 }
 
 
+_Use_decl_annotations_
+void DynamicSoundEffectInstance::SetOutputBus(const char* name)
+{
+    pImpl->mBase.SetOutputBus(name);
+}
+
+
 void DynamicSoundEffectInstance::Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords)
 {
     pImpl->mBase.Apply3D(listener, emitter, rhcoords);
@@ -321,6 +635,13 @@ void DynamicSoundEffectInstance::SubmitBuffer(const uint8_t* pAudioData, uint32_
 }
 
 
+_Use_decl_annotations_
+size_t DynamicSoundEffectInstance::WriteRingBuffer(const uint8_t* pAudioData, size_t audioBytes)
+{
+    return pImpl->WriteRingBuffer(pAudioData, audioBytes);
+}
+
+
 // Public accessors.
 SoundState DynamicSoundEffectInstance::GetState() noexcept
 {
@@ -22,6 +22,38 @@ namespace
         while (x) { ++bitCount; x &= (x - 1); }
         return bitCount;
     }
+
+    // Distance attenuation from the emitter's volume curve, the same way X3DAudio applies it. A null curve is the
+    // default inverse square law with no attenuation inside CurveDistanceScaler.
+    float ComputeDistanceGain(const X3DAUDIO_LISTENER& lhListener, const X3DAUDIO_EMITTER& emitter, bool rhcoords) noexcept
+    {
+        const float dx = emitter.Position.x - lhListener.Position.x;
+        const float dy = emitter.Position.y - lhListener.Position.y;
+        const float dz = (rhcoords ? -emitter.Position.z : emitter.Position.z) - lhListener.Position.z;
+
+        const float scaler = (emitter.CurveDistanceScaler > FLT_MIN) ? emitter.CurveDistanceScaler : FLT_MIN;
+        const float distance = sqrtf(dx * dx + dy * dy + dz * dz) / scaler;
+
+        auto curve = emitter.pVolumeCurve;
+        if (!curve || !curve->pPoints || !curve->PointCount)
+            return (distance <= 1.f) ? 1.f : (1.f / distance);
+
+        auto points = curve->pPoints;
+        if (distance <= points[0].Distance)
+            return points[0].DSPSetting;
+
+        for (UINT32 j = 1; j < curve->PointCount; ++j)
+        {
+            if (distance < points[j].Distance)
+            {
+                const float span = points[j].Distance - points[j - 1].Distance;
+                const float t = (span > 0.f) ? (distance - points[j - 1].Distance) / span : 1.f;
+                return points[j - 1].DSPSetting + t * (points[j].DSPSetting - points[j - 1].DSPSetting);
+            }
+        }
+
+        return points[curve->PointCount - 1].DSPSetting;
+    }
 }
 
 
@@ -698,9 +730,39 @@ void SoundEffectInstanceBase::SetPan(float pan)
 
 
 void SoundEffectInstanceBase::Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords)
+{
+    if (!voice && !(mFlags & SoundEffectInstance_Virtual))
+        return;
+
+    if (rhcoords)
+    {
+        X3DAUDIO_LISTENER lhListener;
+        memcpy(&lhListener, &listener, sizeof(X3DAUDIO_LISTENER));
+        lhListener.OrientFront.z = -listener.OrientFront.z;
+        lhListener.OrientTop.z = -listener.OrientTop.z;
+        lhListener.Position.z = -listener.Position.z;
+        lhListener.Velocity.z = -listener.Velocity.z;
+
+        Apply3D(lhListener, emitter, true, true, XAUDIO2_COMMIT_NOW);
+    }
+    else
+    {
+        Apply3D(listener, emitter, false, true, XAUDIO2_COMMIT_NOW);
+    }
+}
+
+
+void SoundEffectInstanceBase::Apply3D(const X3DAUDIO_LISTENER& lhListener, const AudioEmitter& emitter, bool rhcoords, bool audible, UINT32 operationSet)
 {
     if (!voice)
+    {
+        // A virtual instance still needs its attenuation so the engine can rank it
+        if (mFlags & SoundEffectInstance_Use3D)
+        {
+            m3DGain = (audible) ? ComputeDistanceGain(lhListener, emitter, rhcoords) : 0.f;
+        }
         return;
+    }
 
     if (!(mFlags & SoundEffectInstance_Use3D))
     {
@@ -708,6 +770,41 @@ void SoundEffectInstanceBase::Apply3D(const AudioListener& listener, const Audio
         throw std::exception("Apply3D");
     }
 
+    auto direct = mDirectVoice;
+    assert(direct != nullptr);
+
+    auto reverb = mReverbVoice;
+
+    float matrix[XAUDIO2_MAX_AUDIO_CHANNELS * 8] = {};
+    assert(mDSPSettings.SrcChannelCount <= XAUDIO2_MAX_AUDIO_CHANNELS);
+    assert(mDSPSettings.DstChannelCount <= 8);
+
+    if (!audible)
+    {
+        m3DGain = 0.f;
+
+        // Out of range, so zero the sends once and leave the voice alone until it comes back
+        if (!mSilenced3D)
+        {
+            (void)voice->SetOutputMatrix(direct, mDSPSettings.SrcChannelCount, mDSPSettings.DstChannelCount, matrix, operationSet);
+
+            if (reverb)
+            {
+                (void)voice->SetOutputMatrix(reverb, mDSPSettings.SrcChannelCount, 1, matrix, operationSet);
+            }
+
+            mSilenced3D = true;
+        }
+        return;
+    }
+
+    mSilenced3D = false;
+
+    if (mFlags & SoundEffectInstance_Virtual)
+    {
+        m3DGain = ComputeDistanceGain(lhListener, emitter, rhcoords);
+    }
+
     DWORD dwCalcFlags = X3DAUDIO_CALCULATE_MATRIX | X3DAUDIO_CALCULATE_DOPPLER | X3DAUDIO_CALCULATE_LPF_DIRECT;
 
     if (mFlags & SoundEffectInstance_UseRedirectLFE)
@@ -716,15 +813,11 @@ void SoundEffectInstanceBase::Apply3D(const AudioListener& listener, const Audio
         dwCalcFlags |= X3DAUDIO_CALCULATE_REDIRECT_TO_LFE;
     }
 
-    auto reverb = mReverbVoice;
     if (reverb)
     {
         dwCalcFlags |= X3DAUDIO_CALCULATE_LPF_REVERB | X3DAUDIO_CALCULATE_REVERB;
     }
 
-    float matrix[XAUDIO2_MAX_AUDIO_CHANNELS * 8] = {};
-    assert(mDSPSettings.SrcChannelCount <= XAUDIO2_MAX_AUDIO_CHANNELS);
-    assert(mDSPSettings.DstChannelCount <= 8);
     mDSPSettings.pMatrixCoefficients = matrix;
 
     assert(engine != nullptr);
@@ -737,27 +830,18 @@ void SoundEffectInstanceBase::Apply3D(const AudioListener& listener, const Audio
         lhEmitter.Position.z = -emitter.Position.z;
         lhEmitter.Velocity.z = -emitter.Velocity.z;
 
-        X3DAUDIO_LISTENER lhListener;
-        memcpy(&lhListener, &listener, sizeof(X3DAUDIO_LISTENER));
-        lhListener.OrientFront.z = -listener.OrientFront.z;
-        lhListener.OrientTop.z = -listener.OrientTop.z;
-        lhListener.Position.z = -listener.Position.z;
-        lhListener.Velocity.z = -listener.Velocity.z;
-
         X3DAudioCalculate(engine->Get3DHandle(), &lhListener, &lhEmitter, dwCalcFlags, &mDSPSettings);
     }
     else
     {
-        X3DAudioCalculate(engine->Get3DHandle(), &listener, &emitter, dwCalcFlags, &mDSPSettings);
+        X3DAudioCalculate(engine->Get3DHandle(), &lhListener, &emitter, dwCalcFlags, &mDSPSettings);
     }
 
     mDSPSettings.pMatrixCoefficients = nullptr;
 
-    (void)voice->SetFrequencyRatio(mFreqRatio * mDSPSettings.DopplerFactor);
+    (void)voice->SetFrequencyRatio(mFreqRatio * mDSPSettings.DopplerFactor, operationSet);
 
-    auto direct = mDirectVoice;
-    assert(direct != nullptr);
-    (void)voice->SetOutputMatrix(direct, mDSPSettings.SrcChannelCount, mDSPSettings.DstChannelCount, matrix);
+    (void)voice->SetOutputMatrix(direct, mDSPSettings.SrcChannelCount, mDSPSettings.DstChannelCount, matrix, operationSet);
 
     if (reverb)
     {
@@ -765,20 +849,20 @@ void SoundEffectInstanceBase::Apply3D(const AudioListener& listener, const Audio
         {
             matrix[j] = mDSPSettings.ReverbLevel;
         }
-        (void)voice->SetOutputMatrix(reverb, mDSPSettings.SrcChannelCount, 1, matrix);
+        (void)voice->SetOutputMatrix(reverb, mDSPSettings.SrcChannelCount, 1, matrix, operationSet);
     }
 
     if (mFlags & SoundEffectInstance_ReverbUseFilters)
     {
         XAUDIO2_FILTER_PARAMETERS filterDirect = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * mDSPSettings.LPFDirectCoefficient), 1.0f };
         // see XAudio2CutoffFrequencyToRadians() in XAudio2.h for more information on the formula used here
-        (void)voice->SetOutputFilterParameters(direct, &filterDirect);
+        (void)voice->SetOutputFilterParameters(direct, &filterDirect, operationSet);
 
         if (reverb)
         {
             XAUDIO2_FILTER_PARAMETERS filterReverb = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * mDSPSettings.LPFReverbCoefficient), 1.0f };
             // see XAudio2CutoffFrequencyToRadians() in XAudio2.h for more information on the formula used here
-            (void)voice->SetOutputFilterParameters(reverb, &filterReverb);
+            (void)voice->SetOutputFilterParameters(reverb, &filterReverb, operationSet);
         }
     }
 }
@@ -80,7 +80,9 @@ namespace DirectX
             mFlags(SoundEffectInstance_Default),
             mDirectVoice(nullptr),
             mReverbVoice(nullptr),
-            mDSPSettings{}
+            mDSPSettings{},
+            mSilenced3D(false),
+            m3DGain(1.f)
         {
         }
 
@@ -113,7 +115,126 @@ namespace DirectX
                 return;
 
             assert(engine != nullptr);
-            engine->AllocateVoice(wfx, mFlags, false, &voice);
+            engine->AllocateVoice(wfx, mFlags, false, &voice, mDirectVoice);
+            mSilenced3D = false;
+        }
+
+        // Sends the instance to a named submix bus, or back to the mastering voice for a null or empty name
+        void SetOutputBus(_In_opt_z_ const char* name)
+        {
+            assert(engine != nullptr);
+
+            IXAudio2Voice* output = engine->GetMasterVoice();
+            if (name && *name)
+            {
+                output = engine->GetBus(name);
+                if (!output && engine->IsAudioDevicePresent())
+                {
+                    DebugTrace("ERROR: Submix bus \"%hs\" not found\n", name);
+                    throw std::invalid_argument("SetOutputBus");
+                }
+            }
+
+            if (voice && output && output != mDirectVoice)
+            {
+                XAUDIO2_SEND_DESCRIPTOR sendDescriptors[2];
+                sendDescriptors[0].Flags = sendDescriptors[1].Flags = (mFlags & SoundEffectInstance_ReverbUseFilters) ? XAUDIO2_SEND_USEFILTER : 0u;
+                sendDescriptors[0].pOutputVoice = output;
+                sendDescriptors[1].pOutputVoice = mReverbVoice;
+                const XAUDIO2_VOICE_SENDS sendList = { ((mFlags & SoundEffectInstance_Use3D) && mReverbVoice) ? 2U : 1U, sendDescriptors };
+
+                HRESULT hr = voice->SetOutputVoices(&sendList);
+                ThrowIfFailed(hr);
+
+                mDirectVoice = output;
+
+                if (mFlags & SoundEffectInstance_Use3D)
+                {
+                    // The new sends start with default matrices, so stay silent until the next Apply3D
+                    float matrix[XAUDIO2_MAX_AUDIO_CHANNELS * 8] = {};
+                    (void)voice->SetOutputMatrix(mDirectVoice, mDSPSettings.SrcChannelCount, mDSPSettings.DstChannelCount, matrix);
+
+                    if (mReverbVoice)
+                    {
+                        (void)voice->SetOutputMatrix(mReverbVoice, mDSPSettings.SrcChannelCount, 1, matrix);
+                    }
+
+                    mSilenced3D = true;
+                }
+                else
+                {
+                    SetPan(mPan);
+                }
+            }
+            else
+            {
+                mDirectVoice = output;
+            }
+
+            if (name)
+                mBus = name;
+            else
+                mBus.clear();
+        }
+
+        // Takes over a voice for an instance that was playing virtually, either one handed on by another instance with the
+        // same format and flags or (if null) a newly allocated one, and puts this instance's settings on it
+        void AttachVoice(_In_opt_ IXAudio2SourceVoice* newVoice, _In_ const WAVEFORMATEX* wfx)
+        {
+            assert(voice == nullptr);
+
+            if (!newVoice)
+            {
+                AllocateVoice(wfx);
+                if (!voice)
+                    return;
+            }
+            else
+            {
+                voice = newVoice;
+            }
+
+            HRESULT hr = voice->SetVolume(mVolume);
+            ThrowIfFailed(hr);
+
+            if (!(mFlags & SoundEffectInstance_NoSetPitch))
+            {
+                mFreqRatio = XAudio2SemitonesToFrequencyRatio(mPitch * 12.f);
+
+                hr = voice->SetFrequencyRatio(mFreqRatio);
+                ThrowIfFailed(hr);
+            }
+
+            if (mFlags & SoundEffectInstance_Use3D)
+            {
+                // Silent until the next Apply3D, rather than heard from wherever the last owner was
+                float matrix[XAUDIO2_MAX_AUDIO_CHANNELS * 8] = {};
+                (void)voice->SetOutputMatrix(mDirectVoice, mDSPSettings.SrcChannelCount, mDSPSettings.DstChannelCount, matrix);
+
+                if (mReverbVoice)
+                {
+                    (void)voice->SetOutputMatrix(mReverbVoice, mDSPSettings.SrcChannelCount, 1, matrix);
+                }
+
+                mSilenced3D = true;
+            }
+            else
+            {
+                SetPan(mPan);
+            }
+        }
+
+        // Gives up the voice, stopped and flushed, without destroying it
+        IXAudio2SourceVoice* DetachVoice() noexcept
+        {
+            auto result = voice;
+            if (result)
+            {
+                (void)result->Stop(0);
+                (void)result->FlushSourceBuffers();
+                voice = nullptr;
+            }
+            return result;
         }
 
         void DestroyVoice()
@@ -193,20 +314,27 @@ namespace DirectX
 
         void Pause() noexcept 
         {
-            if (voice && state == PLAYING)
+            // Only a virtual instance can be playing without a voice
+            if (state == PLAYING)
             {
                 state = PAUSED;
 
-                (void)voice->Stop(0);
+                if (voice)
+                {
+                    (void)voice->Stop(0);
+                }
             }
         }
 
         void Resume()
         {
-            if (voice && state == PAUSED)
+            if (state == PAUSED)
             {
-                HRESULT hr = voice->Start(0);
-                ThrowIfFailed(hr);
+                if (voice)
+                {
+                    HRESULT hr = voice->Start(0);
+                    ThrowIfFailed(hr);
+                }
                 state = PLAYING;
             }
         }
@@ -235,11 +363,10 @@ namespace DirectX
             }
 
             mPitch = pitch;
+            mFreqRatio = XAudio2SemitonesToFrequencyRatio(mPitch * 12.f);
 
             if (voice)
             {
-                mFreqRatio = XAudio2SemitonesToFrequencyRatio(mPitch * 12.f);
-
                 HRESULT hr = voice->SetFrequencyRatio(mFreqRatio);
                 ThrowIfFailed(hr);
             }
@@ -248,6 +375,8 @@ namespace DirectX
         void SetPan(float pan);
 
         void Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords);
+        void Apply3D(const X3DAUDIO_LISTENER& lhListener, const AudioEmitter& emitter, bool rhcoords, bool audible, UINT32 operationSet);
+            // Takes a listener already in left-handed coordinates, and defers the voice changes to operationSet
 
         SoundState GetState(bool autostop) noexcept
         {
@@ -271,6 +400,21 @@ namespace DirectX
             return state;
         }
 
+        // How loud the instance would be, from its volume and the distance attenuation found by the last Apply3D
+        float GetAudibility() const noexcept
+        {
+            float gain = fabsf(mVolume);
+            if (mFlags & SoundEffectInstance_Use3D)
+                gain *= m3DGain;
+            return gain;
+        }
+
+        float GetFrequencyRatio() const noexcept { return mFreqRatio; }
+
+        SOUND_EFFECT_INSTANCE_FLAGS GetFlags() const noexcept { return mFlags; }
+
+        IXAudio2Voice* GetOutputVoice() const noexcept { return mDirectVoice; }
+
         int GetPendingBufferCount() const noexcept
         {
             if (!voice)
@@ -303,6 +447,14 @@ namespace DirectX
             mDirectVoice = engine->GetMasterVoice();
             mReverbVoice = engine->GetReverbVoice();
 
+            if (!mBus.empty())
+            {
+                // AudioEngine recreates its buses before notifying, so a missing one has failed and the instance goes to the master
+                auto bus = engine->GetBus(mBus.c_str());
+                if (bus)
+                    mDirectVoice = bus;
+            }
+
             if (engine->GetChannelMask() & SPEAKER_LOW_FREQUENCY)
                 mFlags = mFlags | SoundEffectInstance_UseRedirectLFE;
             else
@@ -363,5 +515,8 @@ namespace DirectX
         IXAudio2Voice*              mDirectVoice;
         IXAudio2Voice*              mReverbVoice;
         X3DAUDIO_DSP_SETTINGS       mDSPSettings;
+        bool                        mSilenced3D;
+        float                       m3DGain;
+        std::string                 mBus;
     };
 }
@@ -11,6 +11,7 @@
 #include "pch.h"
 #include "WAVFileReader.h"
 #include "SoundCommon.h"
+#include "MemoryTracker.h"
 
 #include <list>
 
@@ -42,6 +43,7 @@ public:
         , mSeekCount(0)
         , mSeekTable(nullptr)
     #endif
+        , mTrackingHandle(0)
     #if defined(_XBOX_ONE) && defined(_TITLE)
         , mXMAMemory(nullptr)
     #endif
@@ -83,6 +85,8 @@ public:
             mXMAMemory = nullptr;
         }
     #endif
+
+        MemoryTracker::ReleaseAllocation(mTrackingHandle);
     }
 
     HRESULT Initialize(_In_ AudioEngine* engine, _Inout_ std::unique_ptr<uint8_t[]>& wavData,
@@ -94,6 +98,12 @@ public:
 
     void Play(float volume, float pitch, float pan);
 
+    void TrackMemory(_In_opt_z_ const wchar_t* owner) noexcept
+    {
+        MemoryTracker::ReleaseAllocation(mTrackingHandle);
+        mTrackingHandle = MemoryTracker::TrackAllocation(MemoryCategory_Audio, mAudioBytes, owner);
+    }
+
     // IVoiceNotify
     virtual void __cdecl OnBufferEnd() override
     {
@@ -154,6 +164,7 @@ public:
 
 private:
     std::unique_ptr<uint8_t[]>          mWavData;
+    uint64_t                            mTrackingHandle;
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
     void*                               mXMAMemory;
@@ -271,6 +282,8 @@ HRESULT SoundEffect::Impl::Initialize(AudioEngine* engine, std::unique_ptr<uint8
     mLoopStart = loopStart;
     mLoopLength = loopLength;
 
+    TrackMemory(L"SoundEffect");
+
     return S_OK;
 }
 
@@ -287,61 +300,70 @@ void SoundEffect::Impl::Play(float volume, float pitch, float pan)
     if (!voice)
         return;
 
-    if (volume != 1.f)
+    // Anything failing before the voice is playing hands it back to the engine, or it is lost to the one-shot pool
+    try
     {
-        HRESULT hr = voice->SetVolume(volume);
-        ThrowIfFailed(hr);
-    }
+        if (volume != 1.f)
+        {
+            HRESULT hr = voice->SetVolume(volume);
+            ThrowIfFailed(hr);
+        }
 
-    if (pitch != 0.f)
-    {
-        float fr = XAudio2SemitonesToFrequencyRatio(pitch * 12.f);
+        if (pitch != 0.f)
+        {
+            float fr = XAudio2SemitonesToFrequencyRatio(pitch * 12.f);
 
-        HRESULT hr = voice->SetFrequencyRatio(fr);
-        ThrowIfFailed(hr);
-    }
+            HRESULT hr = voice->SetFrequencyRatio(fr);
+            ThrowIfFailed(hr);
+        }
 
-    if (pan != 0.f)
-    {
-        float matrix[16];
-        if (ComputePan(pan, mWaveFormat->nChannels, matrix))
+        if (pan != 0.f)
         {
-            HRESULT hr = voice->SetOutputMatrix(nullptr, mWaveFormat->nChannels, mEngine->GetOutputChannels(), matrix);
-            ThrowIfFailed(hr);
+            float matrix[16];
+            if (ComputePan(pan, mWaveFormat->nChannels, matrix))
+            {
+                HRESULT hr = voice->SetOutputMatrix(nullptr, mWaveFormat->nChannels, mEngine->GetOutputChannels(), matrix);
+                ThrowIfFailed(hr);
+            }
         }
-    }
 
-    HRESULT hr = voice->Start(0);
-    ThrowIfFailed(hr);
+        HRESULT hr = voice->Start(0);
+        ThrowIfFailed(hr);
 
-    XAUDIO2_BUFFER buffer = {};
-    buffer.AudioBytes = mAudioBytes;
-    buffer.pAudioData = mStartAudio;
-    buffer.Flags = XAUDIO2_END_OF_STREAM;
-    buffer.pContext = this;
+        XAUDIO2_BUFFER buffer = {};
+        buffer.AudioBytes = mAudioBytes;
+        buffer.pAudioData = mStartAudio;
+        buffer.Flags = XAUDIO2_END_OF_STREAM;
+        buffer.pContext = this;
 
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
 
-    uint32_t tag = GetFormatTag(mWaveFormat);
-    if (tag == WAVE_FORMAT_WMAUDIO2 || tag == WAVE_FORMAT_WMAUDIO3)
-    {
-        XAUDIO2_BUFFER_WMA wmaBuffer = {};
-        wmaBuffer.PacketCount = mSeekCount;
-        wmaBuffer.pDecodedPacketCumulativeBytes = mSeekTable;
+        uint32_t tag = GetFormatTag(mWaveFormat);
+        if (tag == WAVE_FORMAT_WMAUDIO2 || tag == WAVE_FORMAT_WMAUDIO3)
+        {
+            XAUDIO2_BUFFER_WMA wmaBuffer = {};
+            wmaBuffer.PacketCount = mSeekCount;
+            wmaBuffer.pDecodedPacketCumulativeBytes = mSeekTable;
 
-        hr = voice->SubmitSourceBuffer(&buffer, &wmaBuffer);
-    }
-    else
+            hr = voice->SubmitSourceBuffer(&buffer, &wmaBuffer);
+        }
+        else
     #endif
-    {
-        hr = voice->SubmitSourceBuffer(&buffer, nullptr);
+        {
+            hr = voice->SubmitSourceBuffer(&buffer, nullptr);
+        }
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: SoundEffect failed (%08X) when submitting buffer:\n", hr);
+            DebugTrace("\tFormat Tag %u, %u channels, %u-bit, %u Hz, %u bytes\n", mWaveFormat->wFormatTag,
+                       mWaveFormat->nChannels, mWaveFormat->wBitsPerSample, mWaveFormat->nSamplesPerSec, mAudioBytes);
+            throw std::exception("SubmitSourceBuffer");
+        }
     }
-    if (FAILED(hr))
+    catch (...)
     {
-        DebugTrace("ERROR: SoundEffect failed (%08X) when submitting buffer:\n", hr);
-        DebugTrace("\tFormat Tag %u, %u channels, %u-bit, %u Hz, %u bytes\n", mWaveFormat->wFormatTag,
-                   mWaveFormat->nChannels, mWaveFormat->wBitsPerSample, mWaveFormat->nSamplesPerSec, mAudioBytes);
-        throw std::exception("SubmitSourceBuffer");
+        mEngine->ReleaseOneShot(voice);
+        throw;
     }
 
     InterlockedIncrement(&mOneShots);
@@ -380,6 +402,8 @@ SoundEffect::SoundEffect(AudioEngine* engine, const wchar_t* waveFileName)
         DebugTrace("ERROR: SoundEffect failed (%08X) to intialize from .wav file \"%ls\"\n", hr, waveFileName);
         throw std::exception("SoundEffect");
     }
+
+    pImpl->TrackMemory(waveFileName);
 }
 
 
@@ -14,12 +14,29 @@
 using namespace DirectX;
 
 
+namespace
+{
+    double GetSeconds() noexcept
+    {
+        static LARGE_INTEGER s_frequency = {};
+        if (!s_frequency.QuadPart)
+        {
+            QueryPerformanceFrequency(&s_frequency);
+        }
+
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return double(counter.QuadPart) / double(s_frequency.QuadPart);
+    }
+}
+
+
 //======================================================================================
 // SoundEffectInstance
 //======================================================================================
 
 // Internal object implementation class.
-class SoundEffectInstance::Impl : public IVoiceNotify
+class SoundEffectInstance::Impl : public IVoiceNotify, public IVirtualVoice
 {
 public:
     Impl(_In_ AudioEngine* engine, _In_ SoundEffect* effect, SOUND_EFFECT_INSTANCE_FLAGS flags) :
@@ -27,13 +44,35 @@ public:
         mEffect(effect),
         mWaveBank(nullptr),
         mIndex(0),
-        mLooped(false)
+        mLooped(false),
+        mVirtual((flags & SoundEffectInstance_Virtual) != 0),
+        mPriority(1.f),
+        mFormat{},
+        mRegionValid(false),
+        mSeekable(false),
+        mSeekAlignment(1),
+        mRegionBegin(0),
+        mRegionEnd(0),
+        mLoopBegin(0),
+        mLoopEnd(0),
+        mPlayBegin(0),
+        mSamplesBase(0),
+        mPosition(0.),
+        mPositionTime(0.)
     {
         assert(engine != nullptr);
         engine->RegisterNotify(this, false);
 
         assert(mEffect != nullptr);
-        mBase.Initialize(engine, effect->GetFormat(), flags);
+        auto wfx = effect->GetFormat();
+        size_t wfxSize = (wfx->wFormatTag == WAVE_FORMAT_PCM) ? sizeof(WAVEFORMATEX) : (sizeof(WAVEFORMATEX) + wfx->cbSize);
+        memcpy(mFormat, wfx, std::min<size_t>(sizeof(mFormat), wfxSize));
+        mBase.Initialize(engine, wfx, flags);
+
+        if (mVirtual)
+        {
+            engine->RegisterVirtual(this);
+        }
     }
 
     Impl(_In_ AudioEngine* engine, _In_ WaveBank* waveBank, uint32_t index, SOUND_EFFECT_INSTANCE_FLAGS flags) :
@@ -41,19 +80,41 @@ public:
         mEffect(nullptr),
         mWaveBank(waveBank),
         mIndex(index),
-        mLooped(false)
+        mLooped(false),
+        mVirtual((flags & SoundEffectInstance_Virtual) != 0),
+        mPriority(1.f),
+        mFormat{},
+        mRegionValid(false),
+        mSeekable(false),
+        mSeekAlignment(1),
+        mRegionBegin(0),
+        mRegionEnd(0),
+        mLoopBegin(0),
+        mLoopEnd(0),
+        mPlayBegin(0),
+        mSamplesBase(0),
+        mPosition(0.),
+        mPositionTime(0.)
     {
         assert(engine != nullptr);
         engine->RegisterNotify(this, false);
 
-        char buff[64] = {};
-        auto wfx = reinterpret_cast<WAVEFORMATEX*>(buff);
         assert(mWaveBank != nullptr);
-        mBase.Initialize(engine, mWaveBank->GetFormat(index, wfx, sizeof(buff)), flags);
+        mBase.Initialize(engine, mWaveBank->GetFormat(index, reinterpret_cast<WAVEFORMATEX*>(mFormat), sizeof(mFormat)), flags);
+
+        if (mVirtual)
+        {
+            engine->RegisterVirtual(this);
+        }
     }
 
     virtual ~Impl() override
     {
+        if (mVirtual && mBase.engine)
+        {
+            mBase.engine->UnregisterVirtual(this);
+        }
+
         mBase.DestroyVoice();
 
         if (mBase.engine)
@@ -65,6 +126,9 @@ public:
 
     void Play(bool loop);
 
+    void Pause() noexcept;
+    void Resume();
+
     // IVoiceNotify
     virtual void __cdecl OnBufferEnd() override
     {
@@ -101,19 +165,84 @@ public:
     virtual void __cdecl GatherStatistics(AudioStatistics& stats) const noexcept override
     {
         mBase.GatherStatistics(stats);
+
+        if (mVirtual && !mBase.voice && mBase.state == PLAYING)
+        {
+            ++stats.virtualInstances;
+        }
     }
 
+    // IVirtualVoice
+    virtual void __cdecl UpdateVirtual() override;
+
+    virtual float __cdecl GetAudibility() const noexcept override
+    {
+        if (mBase.state != PLAYING)
+            return -1.f;
+
+        return mPriority * mBase.GetAudibility();
+    }
+
+    virtual bool __cdecl HasVoice() const noexcept override
+    {
+        return mBase.voice != nullptr;
+    }
+
+    virtual const WAVEFORMATEX* __cdecl GetVoiceFormat() const noexcept override
+    {
+        return reinterpret_cast<const WAVEFORMATEX*>(mFormat);
+    }
+
+    virtual SOUND_EFFECT_INSTANCE_FLAGS __cdecl GetVoiceFlags() const noexcept override
+    {
+        return mBase.GetFlags();
+    }
+
+    virtual IXAudio2Voice* __cdecl GetVoiceOutput() const noexcept override
+    {
+        return mBase.GetOutputVoice();
+    }
+
+    virtual IXAudio2SourceVoice* __cdecl Virtualize() noexcept override;
+
+    virtual void __cdecl Devirtualize(_In_opt_ IXAudio2SourceVoice* voice) override;
+
     SoundEffectInstanceBase         mBase;
     SoundEffect*                    mEffect;
     WaveBank*                       mWaveBank;
     uint32_t                        mIndex;
     bool                            mLooped;
+    bool                            mVirtual;
+    float                           mPriority;
+
+private:
+    void Submit(uint32_t playBegin);
+    void LoadRegion();
+    double GetPosition() const noexcept;
+
+    uint8_t                         mFormat[64];
+
+    // Play and loop regions in samples, for picking up a virtual sound part way through
+    bool                            mRegionValid;
+    bool                            mSeekable;
+    uint32_t                        mSeekAlignment;
+    uint32_t                        mRegionBegin;
+    uint32_t                        mRegionEnd;
+    uint32_t                        mLoopBegin;
+    uint32_t                        mLoopEnd;
+
+    // The voice's SamplesPlayed counts from mSamplesBase at mPlayBegin; without a voice the sound was at mPosition
+    // at mPositionTime
+    uint32_t                        mPlayBegin;
+    uint64_t                        mSamplesBase;
+    double                          mPosition;
+    double                          mPositionTime;
 };
 
 
 void SoundEffectInstance::Impl::Play(bool loop)
 {
-    if (!mBase.voice)
+    if (!mBase.voice && !mVirtual)
     {
         if (mWaveBank)
         {
@@ -128,10 +257,75 @@ void SoundEffectInstance::Impl::Play(bool loop)
         }
     }
 
+    if (!mBase.voice && mVirtual)
+    {
+        // Starts without a voice and asks the engine for one, which it gets if it ranks among the most audible
+        if (mBase.state == PLAYING || !mBase.engine)
+            return;
+
+        if (mBase.state == STOPPED)
+        {
+            LoadRegion();
+
+            mLooped = loop;
+            mPosition = mRegionBegin;
+        }
+
+        mPositionTime = GetSeconds();
+        mBase.state = PLAYING;
+
+        mBase.engine->UpdateVirtualVoices();
+        return;
+    }
+
     if (!mBase.Play())
         return;
 
-    // Submit audio data for STOPPED -> PLAYING state transition
+    if (mVirtual)
+    {
+        LoadRegion();
+    }
+
+    mLooped = loop;
+    Submit(0);
+}
+
+
+void SoundEffectInstance::Impl::Pause() noexcept
+{
+    if (!mBase.voice && mBase.state == PLAYING)
+    {
+        mPosition = GetPosition();
+    }
+
+    mBase.Pause();
+}
+
+
+void SoundEffectInstance::Impl::Resume()
+{
+    if (mBase.state != PAUSED)
+        return;
+
+    if (mBase.voice)
+    {
+        mBase.Resume();
+        return;
+    }
+
+    mPositionTime = GetSeconds();
+    mBase.Resume();
+
+    if (mVirtual && mBase.engine)
+    {
+        mBase.engine->UpdateVirtualVoices();
+    }
+}
+
+
+// Submits the audio data, starting at playBegin if that is inside the play region and the format can seek
+void SoundEffectInstance::Impl::Submit(uint32_t playBegin)
+{
     XAUDIO2_BUFFER buffer;
 
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
@@ -163,18 +357,31 @@ void SoundEffectInstance::Impl::Play(bool loop)
 #endif
 
     buffer.Flags = XAUDIO2_END_OF_STREAM;
-    if (loop)
+    if (mLooped)
     {
-        mLooped = true;
         buffer.LoopCount = XAUDIO2_LOOP_INFINITE;
     }
     else
     {
-        mLooped = false;
         buffer.LoopCount = buffer.LoopBegin = buffer.LoopLength = 0;
     }
     buffer.pContext = nullptr;
 
+    if (mRegionValid && mSeekable && playBegin > buffer.PlayBegin && playBegin < mRegionEnd)
+    {
+        // A zero length means the whole buffer, which also requires PlayBegin to be zero
+        if (mLooped && !buffer.LoopLength)
+        {
+            buffer.LoopBegin = mLoopBegin;
+            buffer.LoopLength = mLoopEnd - mLoopBegin;
+        }
+
+        buffer.PlayBegin = playBegin;
+        buffer.PlayLength = mRegionEnd - playBegin;
+    }
+
+    mPlayBegin = buffer.PlayBegin;
+
     HRESULT hr;
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
     if (iswma)
@@ -204,6 +411,162 @@ void SoundEffectInstance::Impl::Play(bool loop)
         mBase.Stop(true, mLooped);
         throw std::exception("SubmitSourceBuffer");
     }
+
+    if (mVirtual)
+    {
+        XAUDIO2_VOICE_STATE xstate;
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        mBase.voice->GetState(&xstate, 0);
+    #else
+        mBase.voice->GetState(&xstate);
+    #endif
+        mSamplesBase = xstate.SamplesPlayed;
+    }
+}
+
+
+void SoundEffectInstance::Impl::LoadRegion()
+{
+    if (mRegionValid)
+        return;
+
+    XAUDIO2_BUFFER buffer;
+    size_t duration;
+
+#if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
+    bool iswma;
+    XAUDIO2_BUFFER_WMA wmaBuffer;
+    if (mWaveBank)
+    {
+        iswma = mWaveBank->FillSubmitBuffer(mIndex, buffer, wmaBuffer);
+        duration = mWaveBank->GetSampleDuration(mIndex);
+    }
+    else
+    {
+        assert(mEffect != nullptr);
+        iswma = mEffect->FillSubmitBuffer(buffer, wmaBuffer);
+        duration = mEffect->GetSampleDuration();
+    }
+
+    // xWMA can't start part way through, so it restarts from the top
+    mSeekable = !iswma;
+#else
+    if (mWaveBank)
+    {
+        mWaveBank->FillSubmitBuffer(mIndex, buffer);
+        duration = mWaveBank->GetSampleDuration(mIndex);
+    }
+    else
+    {
+        assert(mEffect != nullptr);
+        mEffect->FillSubmitBuffer(buffer);
+        duration = mEffect->GetSampleDuration();
+    }
+
+    mSeekable = true;
+#endif
+
+    auto wfx = reinterpret_cast<const WAVEFORMATEX*>(mFormat);
+    switch (GetFormatTag(wfx))
+    {
+        case WAVE_FORMAT_ADPCM:
+            mSeekAlignment = reinterpret_cast<const ADPCMWAVEFORMAT*>(wfx)->wSamplesPerBlock;
+            break;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        case WAVE_FORMAT_XMA2:
+            mSeekAlignment = 128;
+            break;
+    #endif
+
+        default:
+            mSeekAlignment = 1;
+            break;
+    }
+
+    if (!mSeekAlignment)
+        mSeekAlignment = 1;
+
+    mRegionBegin = buffer.PlayBegin;
+    mRegionEnd = (buffer.PlayLength) ? (buffer.PlayBegin + buffer.PlayLength) : static_cast<uint32_t>(duration);
+    mLoopBegin = (buffer.LoopLength) ? buffer.LoopBegin : mRegionBegin;
+    mLoopEnd = (buffer.LoopLength) ? (buffer.LoopBegin + buffer.LoopLength) : mRegionEnd;
+    mRegionValid = true;
+}
+
+
+// Where the sound has got to in samples, wrapped into the loop for looped sounds
+double SoundEffectInstance::Impl::GetPosition() const noexcept
+{
+    double position = mPosition;
+
+    if (mBase.voice)
+    {
+        XAUDIO2_VOICE_STATE xstate;
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        mBase.voice->GetState(&xstate, 0);
+    #else
+        mBase.voice->GetState(&xstate);
+    #endif
+        position = double(mPlayBegin) + double(xstate.SamplesPlayed - mSamplesBase);
+    }
+    else if (mBase.state == PLAYING)
+    {
+        auto wfx = reinterpret_cast<const WAVEFORMATEX*>(mFormat);
+        position += (GetSeconds() - mPositionTime) * double(wfx->nSamplesPerSec) * double(mBase.GetFrequencyRatio());
+    }
+
+    if (mLooped && mLoopEnd > mLoopBegin && position >= double(mLoopEnd))
+    {
+        position = double(mLoopBegin) + fmod(position - double(mLoopBegin), double(mLoopEnd - mLoopBegin));
+    }
+
+    return position;
+}
+
+
+void SoundEffectInstance::Impl::UpdateVirtual()
+{
+    if (mBase.voice || mBase.state != PLAYING)
+        return;
+
+    if (!mLooped && GetPosition() >= double(mRegionEnd))
+    {
+        mBase.state = STOPPED;
+    }
+}
+
+
+IXAudio2SourceVoice* SoundEffectInstance::Impl::Virtualize() noexcept
+{
+    if (mBase.voice && mBase.state != STOPPED)
+    {
+        mPosition = GetPosition();
+        mPositionTime = GetSeconds();
+    }
+
+    return mBase.DetachVoice();
+}
+
+
+_Use_decl_annotations_
+void SoundEffectInstance::Impl::Devirtualize(IXAudio2SourceVoice* voice)
+{
+    assert(!mBase.voice && mBase.state == PLAYING);
+
+    const double position = GetPosition();
+
+    mBase.AttachVoice(voice, reinterpret_cast<const WAVEFORMATEX*>(mFormat));
+    if (!mBase.voice)
+        return;
+
+    auto playBegin = static_cast<uint32_t>(position);
+    playBegin -= playBegin % mSeekAlignment;
+
+    Submit(playBegin);
+
+    HRESULT hr = mBase.voice->Start(0);
+    ThrowIfFailed(hr);
 }
 
 
@@ -275,13 +638,13 @@ void SoundEffectInstance::Stop(bool immediate) noexcept
 
 void SoundEffectInstance::Pause() noexcept
 {
-    pImpl->mBase.Pause();
+    pImpl->Pause();
 }
 
 
 void SoundEffectInstance::Resume()
 {
-    pImpl->mBase.Resume();
+    pImpl->Resume();
 }
 
 
@@ -309,6 +672,28 @@ void SoundEffectInstance::Apply3D(const AudioListener& listener, const AudioEmit
 }
 
 
+void SoundEffectInstance::Apply3D(const X3DAUDIO_LISTENER& lhListener, const AudioEmitter& emitter, bool rhcoords, bool audible, uint32_t operationSet)
+{
+    pImpl->mBase.Apply3D(lhListener, emitter, rhcoords, audible, operationSet);
+}
+
+
+_Use_decl_annotations_
+void SoundEffectInstance::SetOutputBus(const char* name)
+{
+    pImpl->mBase.SetOutputBus(name);
+}
+
+
+void SoundEffectInstance::SetPriority(float priority)
+{
+    if (priority < 0.f)
+        throw std::out_of_range("SetPriority");
+
+    pImpl->mPriority = priority;
+}
+
+
 // Public accessors.
 bool SoundEffectInstance::IsLooped() const noexcept
 {
@@ -316,8 +701,19 @@ bool SoundEffectInstance::IsLooped() const noexcept
 }
 
 
+bool SoundEffectInstance::IsVirtual() const noexcept
+{
+    return !pImpl->mBase.voice && pImpl->mBase.state == PLAYING;
+}
+
+
 SoundState SoundEffectInstance::GetState() noexcept
 {
+    if (pImpl->mVirtual)
+    {
+        pImpl->UpdateVirtual();
+    }
+
     return pImpl->mBase.GetState(true);
 }
 
@@ -325,6 +721,11 @@ SoundState SoundEffectInstance::GetState() noexcept
 // Notifications.
 void SoundEffectInstance::OnDestroyParent() noexcept
 {
+    if (pImpl->mVirtual && pImpl->mBase.engine)
+    {
+        pImpl->mBase.engine->UnregisterVirtual(pImpl.get());
+    }
+
     pImpl->mBase.OnDestroy();
     pImpl->mWaveBank = nullptr;
     pImpl->mEffect = nullptr;
@@ -0,0 +1,1078 @@
+//--------------------------------------------------------------------------------------
+// File: SoundStreamInstance.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SoundCommon.h"
+#include "WAVFileReader.h"
+#include "WaveBankReader.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <apu.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Streaming wave banks are opened for unbuffered I/O, so every read must start and end on a sector
+    // boundary and land in sector-aligned memory. 4096 covers both 512-byte and 4K native drives.
+    const uint32_t c_SectorSize = 4096;
+
+    // Each stream cycles this many buffers of roughly this size between the disk and its voice: one
+    // playing, one queued behind it, and one being read.
+    const size_t c_StreamBufferCount = 3;
+    const uint32_t c_StreamBufferTarget = 65536;
+
+    inline uint32_t RoundDownToSector(uint32_t value) noexcept
+    {
+        return value & ~(c_SectorSize - 1);
+    }
+
+    inline uint32_t RoundUpToSector(uint32_t value) noexcept
+    {
+        return (value + c_SectorSize - 1) & ~(c_SectorSize - 1);
+    }
+
+    //----------------------------------------------------------------------------------
+    class IStreamingClient
+    {
+    public:
+        virtual ~IStreamingClient() = default;
+
+        virtual void __cdecl OnServiceIO() noexcept = 0;
+            // Called on the streaming thread to retire played buffers, submit read ones, and issue new reads
+    };
+
+    // One thread services the disk reads of every SoundStreamInstance. Reads are issued with ReadFileEx, so
+    // their completion routines run on this thread whenever it waits alertably for more work.
+    class StreamingThread
+    {
+    public:
+        StreamingThread() noexcept(false) :
+            mExit(false)
+        {
+            mWake.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+            if (!mWake)
+            {
+                throw std::exception("CreateEvent");
+            }
+
+            mThread = std::thread([this]() { Run(); });
+        }
+
+        StreamingThread(StreamingThread const&) = delete;
+        StreamingThread& operator= (StreamingThread const&) = delete;
+
+        ~StreamingThread()
+        {
+            mExit = true;
+            SetEvent(mWake.get());
+            mThread.join();
+        }
+
+        static std::shared_ptr<StreamingThread> Get()
+        {
+            static std::mutex s_mutex;
+            static std::weak_ptr<StreamingThread> s_instance;
+
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            auto thread = s_instance.lock();
+            if (!thread)
+            {
+                thread = std::make_shared<StreamingThread>();
+                s_instance = thread;
+            }
+
+            return thread;
+        }
+
+        void Add(_In_ IStreamingClient* client)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClients.push_back(client);
+        }
+
+        void Remove(_In_ IStreamingClient* client)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClients.remove(client);
+        }
+
+        void Wake() noexcept
+        {
+            SetEvent(mWake.get());
+        }
+
+    private:
+        void Run()
+        {
+            for (;;)
+            {
+                // Alertable, so read completion routines are delivered here
+                (void)WaitForSingleObjectEx(mWake.get(), INFINITE, TRUE);
+
+                if (mExit)
+                    break;
+
+                std::lock_guard<std::mutex> lock(mMutex);
+                for (auto it : mClients)
+                {
+                    it->OnServiceIO();
+                }
+            }
+        }
+
+        std::atomic<bool>               mExit;
+        ScopedHandle                    mWake;
+        std::mutex                      mMutex;
+        std::list<IStreamingClient*>    mClients;
+        std::thread                     mThread;
+    };
+}
+
+
+//======================================================================================
+// SoundStreamInstance
+//======================================================================================
+
+// Internal object implementation class.
+class SoundStreamInstance::Impl : public IVoiceNotify, public IStreamingClient
+{
+public:
+    Impl(_In_ AudioEngine* engine, _In_opt_ WaveBank* waveBank, uint32_t index, _In_opt_z_ const wchar_t* wavFileName, SOUND_EFFECT_INSTANCE_FLAGS flags);
+
+    virtual ~Impl() override;
+
+    void Play(bool loop);
+    void Stop(bool immediate) noexcept;
+    SoundState GetState() noexcept;
+    void OnDestroyParent() noexcept;
+
+    // IVoiceNotify
+    virtual void __cdecl OnBufferEnd() override
+    {
+        // Called from XAudio2's worker thread; the streaming thread does the rest
+        ++mBuffersEnded;
+        mStreamingThread->Wake();
+    }
+
+    virtual void __cdecl OnCriticalError() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBase.OnCriticalError();
+        OnVoiceDestroyed();
+    }
+
+    virtual void __cdecl OnReset() override
+    {
+        mBase.OnReset();
+    }
+
+    virtual void __cdecl OnUpdate() override
+    {
+        // We do not register for update notification
+        assert(false);
+    }
+
+    virtual void __cdecl OnDestroyEngine() noexcept override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBase.OnDestroy();
+        OnVoiceDestroyed();
+    }
+
+    virtual void __cdecl OnTrim() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBase.OnTrim();
+        if (!mBase.voice)
+        {
+            OnVoiceDestroyed();
+        }
+    }
+
+    virtual void __cdecl GatherStatistics(AudioStatistics& stats) const noexcept override
+    {
+        mBase.GatherStatistics(stats);
+    }
+
+    // IStreamingClient
+    virtual void __cdecl OnServiceIO() noexcept override;
+
+    SoundEffectInstanceBase         mBase;
+    WaveBank*                       mWaveBank;
+    uint32_t                        mIndex;
+    bool                            mLooped;
+    std::mutex                      mMutex;
+
+private:
+    enum class BufferState
+    {
+        Free,
+        Reading,
+        Ready,
+        Submitted,
+    };
+
+    struct StreamBuffer
+    {
+        OVERLAPPED              request;
+        Impl*                   owner;
+        uint8_t*                memory;
+        BufferState             state;
+        uint32_t                generation;
+        uint32_t                sequence;
+        uint32_t                audioOffset;
+        uint32_t                audioBytes;
+        std::vector<uint32_t>   packetBytes;
+    };
+
+    static void CALLBACK OnReadComplete(DWORD error, DWORD bytesRead, _Inout_ LPOVERLAPPED request) noexcept;
+
+    void OpenWAVFile(_In_z_ const wchar_t* wavFileName);
+    void ReadComplete(StreamBuffer& buffer, DWORD error, DWORD bytesRead) noexcept;
+    bool IssueRead(StreamBuffer& buffer) noexcept;
+    bool SubmitBuffer(StreamBuffer& buffer) noexcept;
+    void StopStream() noexcept;
+    void OnVoiceDestroyed() noexcept;
+    void Shutdown() noexcept;
+
+    std::shared_ptr<StreamingThread>    mStreamingThread;
+    HANDLE                              mAsync;
+    ScopedHandle                        mFile;
+    std::unique_ptr<uint8_t[]>          mHeader;
+    uint64_t                            mFormat[8];
+    WaveBankReader::Metadata            mMetadata;
+    WaveBankReader::SeekData            mSeekData;
+    bool                                mWMA;
+    bool                                mXMAMemory;
+    uint32_t                            mPacketSize;
+    uint32_t                            mChunkSize;
+    uint32_t                            mBufferSize;
+    uint32_t                            mLoopBegin;
+    uint32_t                            mLoopEnd;
+    uint8_t*                            mMemory;
+    StreamBuffer                        mBuffers[c_StreamBufferCount];
+
+    // Buffers handed to the voice, in submission order. OnBufferEnd can't say which buffer finished, but
+    // XAudio2 always plays them in order, so the count of ended buffers retires them from the front.
+    StreamBuffer*                       mSubmitted[c_StreamBufferCount];
+    size_t                              mSubmittedHead;
+    size_t                              mSubmittedCount;
+    std::atomic<uint32_t>               mBuffersEnded;
+
+    uint32_t                            mReadsInFlight;
+    ScopedHandle                        mReadsIdle;
+
+    bool                                mStreaming;
+    bool                                mEndRead;
+    bool                                mEndSubmitted;
+    uint32_t                            mGeneration;
+    uint32_t                            mNextOffset;
+    uint32_t                            mReadSequence;
+    uint32_t                            mSubmitSequence;
+    uint32_t                            mLastChunkSequence;
+    uint32_t                            mEndSequence;
+};
+
+
+_Use_decl_annotations_
+SoundStreamInstance::Impl::Impl(AudioEngine* engine, WaveBank* waveBank, uint32_t index, const wchar_t* wavFileName, SOUND_EFFECT_INSTANCE_FLAGS flags) :
+    mBase(),
+    mWaveBank(waveBank),
+    mIndex(index),
+    mLooped(false),
+    mAsync(INVALID_HANDLE_VALUE),
+    mFormat{},
+    mMetadata{},
+    mSeekData{},
+    mWMA(false),
+    mXMAMemory(false),
+    mPacketSize(0),
+    mChunkSize(0),
+    mBufferSize(0),
+    mLoopBegin(0),
+    mLoopEnd(0),
+    mMemory(nullptr),
+    mBuffers{},
+    mSubmitted{},
+    mSubmittedHead(0),
+    mSubmittedCount(0),
+    mBuffersEnded(0),
+    mReadsInFlight(0),
+    mStreaming(false),
+    mEndRead(false),
+    mEndSubmitted(false),
+    mGeneration(0),
+    mNextOffset(0),
+    mReadSequence(0),
+    mSubmitSequence(0),
+    mLastChunkSequence(UINT32_MAX),
+    mEndSequence(UINT32_MAX)
+{
+    assert(engine != nullptr);
+
+    auto wfx = reinterpret_cast<WAVEFORMATEX*>(mFormat);
+
+    if (mWaveBank)
+    {
+        if (!mWaveBank->GetFormat(index, wfx, sizeof(mFormat)))
+        {
+            throw std::exception("GetFormat");
+        }
+
+        if (!mWaveBank->GetPrivateData(index, &mMetadata, sizeof(mMetadata))
+            || !mWaveBank->GetPrivateData(index, &mSeekData, sizeof(mSeekData)))
+        {
+            throw std::exception("GetPrivateData");
+        }
+
+        mAsync = mWaveBank->GetAsyncHandle();
+    }
+    else
+    {
+        OpenWAVFile(wavFileName);
+    }
+
+    if (mAsync == INVALID_HANDLE_VALUE || !mAsync)
+    {
+        throw std::exception("GetAsyncHandle");
+    }
+
+    // Every buffer must hold whole packets for the decoder
+    switch (GetFormatTag(wfx))
+    {
+        case WAVE_FORMAT_PCM:
+        case WAVE_FORMAT_IEEE_FLOAT:
+        case WAVE_FORMAT_ADPCM:
+            mPacketSize = wfx->nBlockAlign;
+            break;
+
+    #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
+        case WAVE_FORMAT_WMAUDIO2:
+        case WAVE_FORMAT_WMAUDIO3:
+            if (!mSeekData.seekTable || !mSeekData.seekCount)
+            {
+                DebugTrace("ERROR: SoundStreamInstance requires a seek table for xWMA\n");
+                throw std::exception("SoundStreamInstance");
+            }
+            mPacketSize = wfx->nBlockAlign;
+            mWMA = true;
+            break;
+    #endif
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        case WAVE_FORMAT_XMA2:
+            mPacketSize = std::max<uint32_t>(2048, reinterpret_cast<const XMA2WAVEFORMATEX*>(wfx)->BytesPerBlock);
+            break;
+    #endif
+
+        default:
+            DebugTrace("ERROR: SoundStreamInstance does not support format tag %u\n", GetFormatTag(wfx));
+            throw std::exception("SoundStreamInstance");
+    }
+
+    if (!mPacketSize || !mMetadata.lengthBytes)
+    {
+        throw std::exception("SoundStreamInstance");
+    }
+
+    mChunkSize = std::max<uint32_t>(1, c_StreamBufferTarget / mPacketSize) * mPacketSize;
+
+    // Loop points are in samples, so the stream loops over the whole blocks that cover them. Compressed formats
+    // always loop the whole wave, as their packets can't be split at a sample.
+    mLoopBegin = 0;
+    mLoopEnd = mMetadata.lengthBytes;
+
+    const uint32_t tag = GetFormatTag(wfx);
+    if (mMetadata.loopLength > 0 && (tag == WAVE_FORMAT_PCM || tag == WAVE_FORMAT_IEEE_FLOAT || tag == WAVE_FORMAT_ADPCM))
+    {
+        const uint64_t samplesPerBlock = (tag == WAVE_FORMAT_ADPCM) ? reinterpret_cast<const ADPCMWAVEFORMAT*>(wfx)->wSamplesPerBlock : 1u;
+        const uint64_t begin = (uint64_t(mMetadata.loopStart) / samplesPerBlock) * mPacketSize;
+        const uint64_t end = ((uint64_t(mMetadata.loopStart) + mMetadata.loopLength + samplesPerBlock - 1) / samplesPerBlock) * mPacketSize;
+
+        if (samplesPerBlock > 0 && begin < end && end <= mMetadata.lengthBytes)
+        {
+            mLoopBegin = static_cast<uint32_t>(begin);
+            mLoopEnd = static_cast<uint32_t>(end);
+        }
+    }
+
+    // Room for a chunk plus the partial sectors on either end of its read
+    mBufferSize = RoundUpToSector(mChunkSize) + c_SectorSize;
+
+    mReadsIdle.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET | CREATE_EVENT_INITIAL_SET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+    if (!mReadsIdle)
+    {
+        throw std::exception("CreateEvent");
+    }
+
+    mBase.Initialize(engine, wfx, flags);
+
+    const size_t totalSize = c_StreamBufferCount * mBufferSize;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    if (GetFormatTag(wfx) == WAVE_FORMAT_XMA2)
+    {
+        void* xmaMemory = nullptr;
+        HRESULT hr = ApuAlloc(&xmaMemory, nullptr, static_cast<UINT32>(totalSize), SHAPE_XMA_INPUT_BUFFER_ALIGNMENT);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: ApuAlloc failed. Did you allocate a large enough heap with ApuCreateHeap for all your XMA wave data?\n");
+            throw std::exception("ApuAlloc");
+        }
+        mMemory = static_cast<uint8_t*>(xmaMemory);
+        mXMAMemory = true;
+    }
+    else
+#endif
+    {
+        mMemory = static_cast<uint8_t*>(_aligned_malloc(totalSize, c_SectorSize));
+        if (!mMemory)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    for (size_t j = 0; j < c_StreamBufferCount; ++j)
+    {
+        auto& buffer = mBuffers[j];
+        buffer.owner = this;
+        buffer.memory = mMemory + j * mBufferSize;
+        buffer.state = BufferState::Free;
+
+        if (mWMA)
+        {
+            buffer.packetBytes.reserve(mChunkSize / mPacketSize + 1);
+        }
+    }
+
+    mStreamingThread = StreamingThread::Get();
+    mStreamingThread->Add(this);
+
+    engine->RegisterNotify(this, false);
+}
+
+
+SoundStreamInstance::Impl::~Impl()
+{
+    Shutdown();
+
+    if (mStreamingThread)
+    {
+        mStreamingThread->Remove(this);
+        mStreamingThread.reset();
+    }
+
+    if (mBase.engine)
+    {
+        mBase.engine->UnregisterNotify(this, false, false);
+        mBase.engine = nullptr;
+    }
+
+    if (mMemory)
+    {
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        if (mXMAMemory)
+        {
+            (void)ApuFree(mMemory);
+        }
+        else
+    #endif
+        {
+            _aligned_free(mMemory);
+        }
+        mMemory = nullptr;
+    }
+}
+
+
+void SoundStreamInstance::Impl::Play(bool loop)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (!mWaveBank && !mFile)
+        {
+            DebugTrace("ERROR: SoundStreamInstance::Play called after its WaveBank was destroyed\n");
+            return;
+        }
+
+        if (!mBase.voice)
+        {
+            mBase.AllocateVoice(reinterpret_cast<const WAVEFORMATEX*>(mFormat));
+        }
+
+        if (!mBase.Play())
+            return;
+
+        // STOPPED -> PLAYING starts reading from the top of the wave; the voice stays silent until the
+        // first buffer arrives. Reads still in flight from an earlier play are thrown away on completion.
+        StopStream();
+
+        mLooped = loop;
+        mStreaming = true;
+        mEndRead = mEndSubmitted = false;
+        ++mGeneration;
+        mNextOffset = mReadSequence = mSubmitSequence = 0;
+        mLastChunkSequence = mEndSequence = UINT32_MAX;
+    }
+
+    mStreamingThread->Wake();
+}
+
+
+// Only the chunk index and format of the file are kept in memory; the wave data is read as it plays.
+_Use_decl_annotations_
+void SoundStreamInstance::Impl::OpenWAVFile(const wchar_t* wavFileName)
+{
+    if (!wavFileName)
+        throw std::invalid_argument("SoundStreamInstance");
+
+    WAVData wavInfo = {};
+    uint32_t dataOffset = 0;
+    HRESULT hr = LoadWAVAudioHeaderFromFile(wavFileName, mHeader, wavInfo, &dataOffset);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: SoundStreamInstance failed (%08X) to load from .wav file \"%ls\"\n", static_cast<unsigned int>(hr), wavFileName);
+        throw std::exception("SoundStreamInstance");
+    }
+
+    // A PCM 'fmt ' chunk can be a PCMWAVEFORMAT, which has no cbSize
+    const size_t wfxSize = (wavInfo.wfx->wFormatTag == WAVE_FORMAT_PCM || wavInfo.wfx->wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
+        ? sizeof(PCMWAVEFORMAT) : (sizeof(WAVEFORMATEX) + wavInfo.wfx->cbSize);
+    if (wfxSize > sizeof(mFormat))
+    {
+        throw std::exception("SoundStreamInstance");
+    }
+    memcpy(mFormat, wavInfo.wfx, wfxSize);
+
+    mMetadata.loopStart = wavInfo.loopStart;
+    mMetadata.loopLength = wavInfo.loopLength;
+    mMetadata.offsetBytes = dataOffset;
+    mMetadata.lengthBytes = wavInfo.audioBytes;
+
+    mSeekData.seekCount = wavInfo.seekCount;
+    mSeekData.seekTable = wavInfo.seek;
+    mSeekData.tag = (wavInfo.seek) ? GetFormatTag(wavInfo.wfx) : 0;
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    CREATEFILE2_EXTENDED_PARAMETERS params = { sizeof(CREATEFILE2_EXTENDED_PARAMETERS), 0, 0, 0, {}, nullptr };
+    params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    params.dwFileFlags = FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING;
+    mFile.reset(safe_handle(CreateFile2(wavFileName,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        OPEN_EXISTING,
+        &params)));
+#else
+    mFile.reset(safe_handle(CreateFileW(wavFileName,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING,
+        nullptr)));
+#endif
+
+    if (!mFile)
+    {
+        DebugTrace("ERROR: SoundStreamInstance failed (%08X) to open .wav file \"%ls\" for streaming\n",
+            static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())), wavFileName);
+        throw std::exception("SoundStreamInstance");
+    }
+
+    mAsync = mFile.get();
+}
+
+
+void SoundStreamInstance::Impl::Stop(bool immediate) noexcept
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!immediate && mLooped)
+    {
+        // Play through to the end of the wave, then stop. If the reads have already wrapped around to the
+        // start, the wave ends with the last chunk read so far and the rest is dropped.
+        mLooped = false;
+
+        if (mLastChunkSequence != UINT32_MAX && mLastChunkSequence + 1 == mReadSequence && mLoopEnd < mMetadata.lengthBytes)
+        {
+            // Nothing has been read past the loop end yet, so carry on into the rest of the wave
+            mNextOffset = mLoopEnd;
+        }
+        else if (mLastChunkSequence != UINT32_MAX)
+        {
+            mEndSequence = mLastChunkSequence;
+            mEndRead = true;
+            mEndSubmitted = (mSubmitSequence > mEndSequence);
+
+            for (auto& buffer : mBuffers)
+            {
+                if (buffer.state == BufferState::Ready && buffer.sequence > mEndSequence)
+                {
+                    buffer.state = BufferState::Free;
+                }
+            }
+        }
+        return;
+    }
+
+    mBase.Stop(immediate, mLooped);
+
+    if (!immediate && mBase.voice)
+    {
+        (void)mBase.voice->FlushSourceBuffers();
+    }
+
+    mLooped = false;
+    StopStream();
+}
+
+
+SoundState SoundStreamInstance::Impl::GetState() noexcept
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mBase.state == PLAYING && mBase.voice && (mEndSubmitted || !mStreaming))
+    {
+        // Nothing more will be queued, so the sound is done once the voice drains
+        if (!mBase.GetPendingBufferCount())
+        {
+            (void)mBase.voice->Stop(0);
+            mBase.state = STOPPED;
+            mStreaming = false;
+        }
+    }
+
+    return mBase.state;
+}
+
+
+void SoundStreamInstance::Impl::OnDestroyParent() noexcept
+{
+    Shutdown();
+    mWaveBank = nullptr;
+}
+
+
+void SoundStreamInstance::Impl::OnServiceIO() noexcept
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Retire the buffers the voice has finished with, oldest first
+    bool retired = false;
+    for (uint32_t ended = mBuffersEnded.exchange(0); ended > 0 && mSubmittedCount > 0; --ended)
+    {
+        mSubmitted[mSubmittedHead]->state = BufferState::Free;
+        mSubmittedHead = (mSubmittedHead + 1) % c_StreamBufferCount;
+        --mSubmittedCount;
+        retired = true;
+    }
+
+    if (!mStreaming || !mBase.voice)
+        return;
+
+    if (retired && !mSubmittedCount && !mEndSubmitted && mBase.state == PLAYING && mBase.engine)
+    {
+        // The voice played everything it had before the next read was ready
+        mBase.engine->ReportStreamStall();
+    }
+
+    // Reads can finish out of order, but they are queued on the voice in sequence
+    for (bool found = true; found && !mEndSubmitted;)
+    {
+        found = false;
+        for (auto& buffer : mBuffers)
+        {
+            if (buffer.state == BufferState::Ready && buffer.sequence == mSubmitSequence)
+            {
+                if (!SubmitBuffer(buffer))
+                {
+                    StopStream();
+                    return;
+                }
+                found = true;
+                break;
+            }
+        }
+    }
+
+    for (auto& buffer : mBuffers)
+    {
+        if (mEndRead)
+            break;
+
+        if (buffer.state == BufferState::Free)
+        {
+            if (!IssueRead(buffer))
+            {
+                StopStream();
+                return;
+            }
+        }
+    }
+}
+
+
+_Use_decl_annotations_
+void CALLBACK SoundStreamInstance::Impl::OnReadComplete(DWORD error, DWORD bytesRead, LPOVERLAPPED request) noexcept
+{
+    auto buffer = CONTAINING_RECORD(request, StreamBuffer, request);
+    assert(buffer != nullptr && buffer->owner != nullptr);
+    buffer->owner->ReadComplete(*buffer, error, bytesRead);
+}
+
+
+void SoundStreamInstance::Impl::ReadComplete(StreamBuffer& buffer, DWORD error, DWORD bytesRead) noexcept
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    assert(buffer.state == BufferState::Reading);
+
+    const bool current = mStreaming && (buffer.generation == mGeneration) && (buffer.sequence <= mEndSequence);
+
+    if (error != ERROR_SUCCESS || bytesRead < (buffer.audioOffset + buffer.audioBytes))
+    {
+        buffer.state = BufferState::Free;
+
+        if (current)
+        {
+            DebugTrace("ERROR: SoundStreamInstance read of wave %u failed (%08X)\n", mIndex, static_cast<unsigned int>(HRESULT_FROM_WIN32(error)));
+            StopStream();
+        }
+    }
+    else
+    {
+        buffer.state = (current) ? BufferState::Ready : BufferState::Free;
+    }
+
+    assert(mReadsInFlight > 0);
+    const bool idle = (--mReadsInFlight == 0);
+
+    lock.unlock();
+
+    // The streaming thread services clients after it wakes from the alertable wait
+    mStreamingThread->Wake();
+
+    // Once signaled, Shutdown may return and the instance be destroyed, so this must be the last use of it
+    if (idle)
+    {
+        SetEvent(mReadsIdle.get());
+    }
+}
+
+
+bool SoundStreamInstance::Impl::IssueRead(StreamBuffer& buffer) noexcept
+{
+    assert(buffer.state == BufferState::Free);
+
+    // Looping streams wrap at the loop end, and only the first pass plays the part before the loop begin
+    const uint32_t playEnd = (mLooped) ? mLoopEnd : mMetadata.lengthBytes;
+    assert(mNextOffset < playEnd);
+
+    const uint32_t chunkStart = mNextOffset;
+    const uint32_t bytes = std::min(mChunkSize, playEnd - chunkStart);
+    const uint32_t start = mMetadata.offsetBytes + chunkStart;
+    const uint32_t readStart = RoundDownToSector(start);
+    const uint32_t readEnd = RoundUpToSector(start + bytes);
+    assert((readEnd - readStart) <= mBufferSize);
+
+    buffer.audioOffset = start - readStart;
+    buffer.audioBytes = bytes;
+    buffer.generation = mGeneration;
+    buffer.sequence = mReadSequence++;
+
+    if (mWMA)
+    {
+        // The decoder wants cumulative decoded bytes for just the packets in this buffer
+        const uint32_t first = chunkStart / mPacketSize;
+        const uint32_t last = std::min(mSeekData.seekCount, (chunkStart + bytes + mPacketSize - 1) / mPacketSize);
+        const uint32_t base = (first > 0 && first <= mSeekData.seekCount) ? mSeekData.seekTable[first - 1] : 0;
+
+        buffer.packetBytes.clear();
+        for (uint32_t p = first; p < last; ++p)
+        {
+            buffer.packetBytes.push_back(mSeekData.seekTable[p] - base);
+        }
+    }
+
+    mNextOffset += bytes;
+    if (mNextOffset >= playEnd)
+    {
+        mLastChunkSequence = buffer.sequence;
+
+        if (mLooped)
+        {
+            mNextOffset = mLoopBegin;
+        }
+        else
+        {
+            mEndSequence = buffer.sequence;
+            mEndRead = true;
+        }
+    }
+
+    memset(&buffer.request, 0, sizeof(OVERLAPPED));
+    buffer.request.Offset = readStart;
+    buffer.state = BufferState::Reading;
+
+    if (mReadsInFlight++ == 0)
+    {
+        ResetEvent(mReadsIdle.get());
+    }
+
+    if (!ReadFileEx(mAsync, buffer.memory, readEnd - readStart, &buffer.request, OnReadComplete))
+    {
+        DebugTrace("ERROR: SoundStreamInstance failed (%08X) to issue read\n", static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())));
+
+        buffer.state = BufferState::Free;
+        if (--mReadsInFlight == 0)
+        {
+            SetEvent(mReadsIdle.get());
+        }
+        return false;
+    }
+
+    return true;
+}
+
+
+bool SoundStreamInstance::Impl::SubmitBuffer(StreamBuffer& buffer) noexcept
+{
+    assert(buffer.state == BufferState::Ready);
+    assert(mSubmittedCount < c_StreamBufferCount);
+
+    XAUDIO2_BUFFER xbuffer = {};
+    xbuffer.AudioBytes = buffer.audioBytes;
+    xbuffer.pAudioData = buffer.memory + buffer.audioOffset;
+    xbuffer.Flags = (buffer.sequence == mEndSequence) ? XAUDIO2_END_OF_STREAM : 0;
+    xbuffer.pContext = static_cast<IVoiceNotify*>(this);
+
+    HRESULT hr;
+#if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
+    if (mWMA)
+    {
+        XAUDIO2_BUFFER_WMA wmaBuffer = {};
+        wmaBuffer.pDecodedPacketCumulativeBytes = buffer.packetBytes.data();
+        wmaBuffer.PacketCount = static_cast<UINT32>(buffer.packetBytes.size());
+        hr = mBase.voice->SubmitSourceBuffer(&xbuffer, &wmaBuffer);
+    }
+    else
+#endif
+    {
+        hr = mBase.voice->SubmitSourceBuffer(&xbuffer, nullptr);
+    }
+
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: SoundStreamInstance failed (%08X) when submitting buffer\n", static_cast<unsigned int>(hr));
+        return false;
+    }
+
+    buffer.state = BufferState::Submitted;
+    mSubmitted[(mSubmittedHead + mSubmittedCount) % c_StreamBufferCount] = &buffer;
+    ++mSubmittedCount;
+    ++mSubmitSequence;
+
+    if (buffer.sequence == mEndSequence)
+    {
+        mEndSubmitted = true;
+    }
+
+    return true;
+}
+
+
+// Stops reading and drops anything read but not yet queued. Buffers already on the voice are retired by
+// OnBufferEnd as XAudio2 flushes them.
+void SoundStreamInstance::Impl::StopStream() noexcept
+{
+    mStreaming = false;
+
+    for (auto& buffer : mBuffers)
+    {
+        if (buffer.state == BufferState::Ready)
+        {
+            buffer.state = BufferState::Free;
+        }
+    }
+}
+
+
+// Once the voice is gone no more OnBufferEnd callbacks will arrive for what it had queued.
+void SoundStreamInstance::Impl::OnVoiceDestroyed() noexcept
+{
+    StopStream();
+
+    for (; mSubmittedCount > 0; --mSubmittedCount)
+    {
+        mSubmitted[mSubmittedHead]->state = BufferState::Free;
+        mSubmittedHead = (mSubmittedHead + 1) % c_StreamBufferCount;
+    }
+    mSubmittedHead = 0;
+    mBuffersEnded = 0;
+}
+
+
+void SoundStreamInstance::Impl::Shutdown() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mBase.DestroyVoice();
+        OnVoiceDestroyed();
+
+        for (auto& buffer : mBuffers)
+        {
+            if (buffer.state == BufferState::Reading)
+            {
+                (void)CancelIoEx(mAsync, &buffer.request);
+            }
+        }
+    }
+
+    // Completion routines run on the streaming thread, so this can't be done while holding the lock
+    (void)WaitForSingleObjectEx(mReadsIdle.get(), INFINITE, FALSE);
+
+    // Whoever signaled may still be inside a locked section, so wait for it to leave before teardown
+    std::lock_guard<std::mutex> lock(mMutex);
+}
+
+
+//--------------------------------------------------------------------------------------
+// SoundStreamInstance
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+_Use_decl_annotations_
+SoundStreamInstance::SoundStreamInstance(AudioEngine* engine, const wchar_t* wavFileName, SOUND_EFFECT_INSTANCE_FLAGS flags) :
+    pImpl(std::make_unique<Impl>(engine, nullptr, 0u, wavFileName, flags))
+{
+}
+
+
+// Private constructors
+_Use_decl_annotations_
+SoundStreamInstance::SoundStreamInstance(AudioEngine* engine, WaveBank* waveBank, unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags) :
+    pImpl(std::make_unique<Impl>(engine, waveBank, index, nullptr, flags))
+{
+}
+
+
+// Move constructor.
+SoundStreamInstance::SoundStreamInstance(SoundStreamInstance&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+SoundStreamInstance& SoundStreamInstance::operator= (SoundStreamInstance&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+SoundStreamInstance::~SoundStreamInstance()
+{
+    if (pImpl)
+    {
+        if (pImpl->mWaveBank)
+        {
+            pImpl->mWaveBank->UnregisterInstance(this);
+            pImpl->mWaveBank = nullptr;
+        }
+    }
+}
+
+
+// Public methods.
+void SoundStreamInstance::Play(bool loop)
+{
+    pImpl->Play(loop);
+}
+
+
+void SoundStreamInstance::Stop(bool immediate) noexcept
+{
+    pImpl->Stop(immediate);
+}
+
+
+void SoundStreamInstance::Pause() noexcept
+{
+    std::lock_guard<std::mutex> lock(pImpl->mMutex);
+    pImpl->mBase.Pause();
+}
+
+
+void SoundStreamInstance::Resume()
+{
+    std::lock_guard<std::mutex> lock(pImpl->mMutex);
+    pImpl->mBase.Resume();
+}
+
+
+void SoundStreamInstance::SetVolume(float volume)
+{
+    pImpl->mBase.SetVolume(volume);
+}
+
+
+void SoundStreamInstance::SetPitch(float pitch)
+{
+    pImpl->mBase.SetPitch(pitch);
+}
+
+
+void SoundStreamInstance::SetPan(float pan)
+{
+    pImpl->mBase.SetPan(pan);
+}
+
+
+_Use_decl_annotations_
+void SoundStreamInstance::SetOutputBus(const char* name)
+{
+    pImpl->mBase.SetOutputBus(name);
+}
+
+
+void SoundStreamInstance::Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords)
+{
+    pImpl->mBase.Apply3D(listener, emitter, rhcoords);
+}
+
+
+// Public accessors.
+bool SoundStreamInstance::IsLooped() const noexcept
+{
+    return pImpl->mLooped;
+}
+
+
+SoundState SoundStreamInstance::GetState() noexcept
+{
+    return pImpl->GetState();
+}
+
+
+// Notifications.
+void SoundStreamInstance::OnDestroyParent() noexcept
+{
+    pImpl->OnDestroyParent();
+}
@@ -132,12 +132,10 @@ namespace
 
 
     //---------------------------------------------------------------------------------
-    HRESULT WaveFindFormatAndData(
+    HRESULT WaveFindFormat(
         _In_reads_bytes_(wavDataSize) const uint8_t* wavData,
         _In_ size_t wavDataSize,
         _Outptr_ const WAVEFORMATEX** pwfx,
-        _Outptr_ const uint8_t** pdata,
-        _Out_ uint32_t* dataSize,
         _Out_ bool& dpds,
         _Out_ bool& seek) noexcept
     {
@@ -275,8 +273,34 @@ namespace
             }
         }
 
+        *pwfx = reinterpret_cast<const WAVEFORMATEX*>(wf);
+        return S_OK;
+    }
+
+
+    //---------------------------------------------------------------------------------
+    HRESULT WaveFindFormatAndData(
+        _In_reads_bytes_(wavDataSize) const uint8_t* wavData,
+        _In_ size_t wavDataSize,
+        _Outptr_ const WAVEFORMATEX** pwfx,
+        _Outptr_ const uint8_t** pdata,
+        _Out_ uint32_t* dataSize,
+        _Out_ bool& dpds,
+        _Out_ bool& seek) noexcept
+    {
+        const WAVEFORMATEX* wfx = nullptr;
+        HRESULT hr = WaveFindFormat(wavData, wavDataSize, &wfx, dpds, seek);
+        if (FAILED(hr))
+            return hr;
+
+        const uint8_t* wavEnd = wavData + wavDataSize;
+
+        // WaveFindFormat has already validated the RIFF header
+        auto riffChunk = FindChunk(wavData, wavDataSize, FOURCC_RIFF_TAG);
+        auto riffHeader = reinterpret_cast<const RIFFChunkHeader*>(riffChunk);
+
         // Locate 'data'
-        ptr = reinterpret_cast<const uint8_t*>(riffHeader) + sizeof(RIFFChunkHeader);
+        auto ptr = reinterpret_cast<const uint8_t*>(riffHeader) + sizeof(RIFFChunkHeader);
         if ((ptr + sizeof(RIFFChunk)) > wavEnd)
         {
             return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
@@ -294,7 +318,7 @@ namespace
             return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
         }
 
-        *pwfx = reinterpret_cast<const WAVEFORMATEX*>(wf);
+        *pwfx = wfx;
         *pdata = ptr;
         *dataSize = dataChunk->size;
         return S_OK;
@@ -545,6 +569,173 @@ namespace
 
         return (*bytesRead < fileInfo.EndOfFile.LowPart) ? E_FAIL : S_OK;
     }
+
+
+    //---------------------------------------------------------------------------------
+    HRESULT ReadFileAt(HANDLE hFile, uint32_t offset, _Out_writes_bytes_(size) void* buffer, uint32_t size) noexcept
+    {
+        LARGE_INTEGER position = {};
+        position.LowPart = offset;
+        if (!SetFilePointerEx(hFile, position, nullptr, FILE_BEGIN))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile, buffer, size, &bytesRead, nullptr))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        return (bytesRead < size) ? HRESULT_FROM_WIN32(ERROR_HANDLE_EOF) : S_OK;
+    }
+
+
+    //---------------------------------------------------------------------------------
+    // Reads the RIFF chunk index of a file, and copies the chunks other than 'data' into a compact RIFF image that the
+    // in-memory parsers can use. The image has no 'data' chunk; its offset and size in the file are returned instead.
+    HRESULT LoadAudioHeaderFromFile(
+        _In_z_ const wchar_t* szFileName,
+        _Inout_ std::unique_ptr<uint8_t[]>& headerData,
+        _Out_ uint32_t* headerSize,
+        _Out_ uint32_t* dataOffset,
+        _Out_ uint32_t* dataSize) noexcept
+    {
+        if (!szFileName)
+            return E_INVALIDARG;
+
+        *headerSize = *dataOffset = *dataSize = 0;
+
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        ScopedHandle hFile(safe_handle(CreateFile2(szFileName,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            OPEN_EXISTING,
+            nullptr)));
+    #else
+        ScopedHandle hFile(safe_handle(CreateFileW(szFileName,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr)));
+    #endif
+
+        if (!hFile)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        FILE_STANDARD_INFO fileInfo;
+        if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        // Offsets are 32-bit, the same as for loading the whole file
+        if (fileInfo.EndOfFile.HighPart > 0)
+        {
+            return E_FAIL;
+        }
+
+        const uint32_t fileSize = fileInfo.EndOfFile.LowPart;
+        if (fileSize < (sizeof(RIFFChunk) * 2 + sizeof(DWORD) + sizeof(WAVEFORMAT)))
+        {
+            return E_FAIL;
+        }
+
+        RIFFChunkHeader riff;
+        HRESULT hr = ReadFileAt(hFile.get(), 0, &riff, sizeof(riff));
+        if (FAILED(hr))
+            return hr;
+
+        if (riff.tag != FOURCC_RIFF_TAG || riff.size < 4
+            || (riff.riff != FOURCC_WAVE_FILE_TAG && riff.riff != FOURCC_XWMA_FILE_TAG))
+        {
+            return E_FAIL;
+        }
+
+        const uint32_t riffEnd = static_cast<uint32_t>(std::min<uint64_t>(fileSize, uint64_t(riff.size) + sizeof(RIFFChunk)));
+
+        std::vector<uint8_t> image(sizeof(RIFFChunkHeader));
+
+        for (uint32_t offset = sizeof(RIFFChunkHeader); uint64_t(offset) + sizeof(RIFFChunk) <= riffEnd; )
+        {
+            RIFFChunk chunk;
+            hr = ReadFileAt(hFile.get(), offset, &chunk, sizeof(chunk));
+            if (FAILED(hr))
+                return hr;
+
+            const uint64_t next = uint64_t(offset) + sizeof(RIFFChunk) + chunk.size;
+
+            switch (chunk.tag)
+            {
+                case FOURCC_DATA_TAG:
+                    if (!*dataSize)
+                    {
+                        if (!chunk.size)
+                            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+                        if (next > fileSize)
+                            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+                        *dataOffset = offset + sizeof(RIFFChunk);
+                        *dataSize = chunk.size;
+                    }
+                    break;
+
+                case FOURCC_FORMAT_TAG:
+                case FOURCC_DLS_SAMPLE:
+                case FOURCC_MIDI_SAMPLE:
+                case FOURCC_XWMA_DPDS:
+                case FOURCC_XMA_SEEK:
+                    {
+                        if (next > fileSize)
+                            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+                        const size_t pos = image.size();
+                        image.resize(pos + sizeof(RIFFChunk) + chunk.size);
+                        memcpy(&image[pos], &chunk, sizeof(RIFFChunk));
+
+                        if (chunk.size > 0)
+                        {
+                            hr = ReadFileAt(hFile.get(), offset + sizeof(RIFFChunk), &image[pos + sizeof(RIFFChunk)], chunk.size);
+                            if (FAILED(hr))
+                                return hr;
+                        }
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            if (next > UINT32_MAX)
+                break;
+
+            offset = static_cast<uint32_t>(next);
+        }
+
+        if (!*dataSize)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        riff.size = static_cast<uint32_t>(image.size() - sizeof(RIFFChunk));
+        memcpy(image.data(), &riff, sizeof(riff));
+
+        headerData.reset(new (std::nothrow) uint8_t[image.size()]);
+        if (!headerData)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        memcpy(headerData.get(), image.data(), image.size());
+        *headerSize = static_cast<uint32_t>(image.size());
+
+        return S_OK;
+    }
 }
 
 //-------------------------------------------------------------------------------------
@@ -698,3 +889,50 @@ HRESULT DirectX::LoadWAVAudioFromFileEx(
     return S_OK;
 }
 
+
+
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadWAVAudioHeaderFromFile(
+    const wchar_t* szFileName,
+    std::unique_ptr<uint8_t[]>& headerData,
+    DirectX::WAVData& result,
+    uint32_t* dataOffset) noexcept
+{
+    if (!szFileName || !dataOffset)
+        return E_INVALIDARG;
+
+    memset(&result, 0, sizeof(result));
+    *dataOffset = 0;
+
+    uint32_t headerSize = 0;
+    HRESULT hr = LoadAudioHeaderFromFile(szFileName, headerData, &headerSize, dataOffset, &result.audioBytes);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    bool dpds, seek;
+    hr = WaveFindFormat(headerData.get(), headerSize, &result.wfx, dpds, seek);
+    if (FAILED(hr))
+        return hr;
+
+    hr = WaveFindLoopInfo(headerData.get(), headerSize, &result.loopStart, &result.loopLength);
+    if (FAILED(hr))
+        return hr;
+
+    if (dpds)
+    {
+        hr = WaveFindTable(headerData.get(), headerSize, FOURCC_XWMA_DPDS, &result.seek, &result.seekCount);
+        if (FAILED(hr))
+            return hr;
+    }
+    else if (seek)
+    {
+        hr = WaveFindTable(headerData.get(), headerSize, FOURCC_XMA_SEEK, &result.seek, &result.seekCount);
+        if (FAILED(hr))
+            return hr;
+    }
+
+    return S_OK;
+}
@@ -54,4 +54,12 @@ namespace DirectX
         _In_z_ const wchar_t* szFileName,
         _Inout_ std::unique_ptr<uint8_t[]>& wavData,
         _Out_ WAVData& result) noexcept;
+
+    // Reads only the chunk index and the chunks describing the audio, not the audio itself. WAVData::startAudio is null,
+    // and the wave data is audioBytes long starting at dataOffset in the file.
+    HRESULT LoadWAVAudioHeaderFromFile(
+        _In_z_ const wchar_t* szFileName,
+        _Inout_ std::unique_ptr<uint8_t[]>& headerData,
+        _Out_ WAVData& result,
+        _Out_ uint32_t* dataOffset) noexcept;
 }
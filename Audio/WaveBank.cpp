@@ -52,6 +52,19 @@ public:
             mInstances.clear();
         }
 
+        if (!mStreamInstances.empty())
+        {
+            DebugTrace("WARNING: Destroying WaveBank \"%hs\" with %zu outstanding SoundStreamInstances\n", mReader.BankName(), mStreamInstances.size());
+
+            for (auto it = mStreamInstances.begin(); it != mStreamInstances.end(); ++it)
+            {
+                assert(*it != nullptr);
+                (*it)->OnDestroyParent();
+            }
+
+            mStreamInstances.clear();
+        }
+
         if (mOneShots > 0)
         {
             DebugTrace("WARNING: Destroying WaveBank \"%hs\" with %u outstanding one shot effects\n", mReader.BankName(), mOneShots);
@@ -64,7 +77,7 @@ public:
         }
     }
 
-    HRESULT Initialize(_In_ AudioEngine* engine, _In_z_ const wchar_t* wbFileName) noexcept;
+    HRESULT Initialize(_In_ AudioEngine* engine, _In_z_ const wchar_t* wbFileName, WAVE_BANK_FLAGS flags) noexcept;
 
     void Play(unsigned int index, float volume, float pitch, float pan);
 
@@ -118,20 +131,22 @@ public:
 
     AudioEngine*                        mEngine;
     std::list<SoundEffectInstance*>     mInstances;
+    std::list<SoundStreamInstance*>     mStreamInstances;
     WaveBankReader                      mReader;
     uint32_t                            mOneShots;
     bool                                mPrepared;
     bool                                mStreaming;
+    std::string                         mBus;
 };
 
 
 _Use_decl_annotations_
-HRESULT WaveBank::Impl::Initialize(AudioEngine* engine, const wchar_t* wbFileName) noexcept
+HRESULT WaveBank::Impl::Initialize(AudioEngine* engine, const wchar_t* wbFileName, WAVE_BANK_FLAGS flags) noexcept
 {
     if (!engine || !wbFileName)
         return E_INVALIDARG;
 
-    HRESULT hr = mReader.Open(wbFileName);
+    HRESULT hr = mReader.Open(wbFileName, (flags & WaveBank_MemoryMapped) != 0, (flags & WaveBank_Prefetch) != 0);
     if (FAILED(hr))
         return hr;
 
@@ -171,72 +186,81 @@ void WaveBank::Impl::Play(unsigned int index, float volume, float pitch, float p
     ThrowIfFailed(hr);
 
     IXAudio2SourceVoice* voice = nullptr;
-    mEngine->AllocateVoice(wfx, SoundEffectInstance_Default, true, &voice);
+    mEngine->AllocateVoice(wfx, SoundEffectInstance_Default, true, &voice, mBus.empty() ? nullptr : mEngine->GetBus(mBus.c_str()));
 
     if (!voice)
         return;
 
-    if (volume != 1.f)
+    // Anything failing before the voice is playing hands it back to the engine, or it is lost to the one-shot pool
+    try
     {
-        hr = voice->SetVolume(volume);
-        ThrowIfFailed(hr);
-    }
+        if (volume != 1.f)
+        {
+            hr = voice->SetVolume(volume);
+            ThrowIfFailed(hr);
+        }
 
-    if (pitch != 0.f)
-    {
-        float fr = XAudio2SemitonesToFrequencyRatio(pitch * 12.f);
+        if (pitch != 0.f)
+        {
+            float fr = XAudio2SemitonesToFrequencyRatio(pitch * 12.f);
 
-        hr = voice->SetFrequencyRatio(fr);
-        ThrowIfFailed(hr);
-    }
+            hr = voice->SetFrequencyRatio(fr);
+            ThrowIfFailed(hr);
+        }
 
-    if (pan != 0.f)
-    {
-        float matrix[16];
-        if (ComputePan(pan, wfx->nChannels, matrix))
+        if (pan != 0.f)
         {
-            hr = voice->SetOutputMatrix(nullptr, wfx->nChannels, mEngine->GetOutputChannels(), matrix);
-            ThrowIfFailed(hr);
+            float matrix[16];
+            if (ComputePan(pan, wfx->nChannels, matrix))
+            {
+                hr = voice->SetOutputMatrix(nullptr, wfx->nChannels, mEngine->GetOutputChannels(), matrix);
+                ThrowIfFailed(hr);
+            }
         }
-    }
 
-    hr = voice->Start(0);
-    ThrowIfFailed(hr);
+        hr = voice->Start(0);
+        ThrowIfFailed(hr);
 
-    XAUDIO2_BUFFER buffer = {};
-    hr = mReader.GetWaveData(index, &buffer.pAudioData, buffer.AudioBytes);
-    ThrowIfFailed(hr);
+        XAUDIO2_BUFFER buffer = {};
+        hr = mReader.GetWaveData(index, &buffer.pAudioData, buffer.AudioBytes);
+        ThrowIfFailed(hr);
 
-    WaveBankReader::Metadata metadata;
-    hr = mReader.GetMetadata(index, metadata);
-    ThrowIfFailed(hr);
+        WaveBankReader::Metadata metadata;
+        hr = mReader.GetMetadata(index, metadata);
+        ThrowIfFailed(hr);
 
-    buffer.Flags = XAUDIO2_END_OF_STREAM;
-    buffer.pContext = this;
+        buffer.Flags = XAUDIO2_END_OF_STREAM;
+        buffer.pContext = this;
 
 #if defined(_XBOX_ONE) || (_WIN32_WINNT < _WIN32_WINNT_WIN8) || (_WIN32_WINNT >= _WIN32_WINNT_WIN10)
 
-    XAUDIO2_BUFFER_WMA wmaBuffer = {};
+        XAUDIO2_BUFFER_WMA wmaBuffer = {};
 
-    uint32_t tag;
-    hr = mReader.GetSeekTable(index, &wmaBuffer.pDecodedPacketCumulativeBytes, wmaBuffer.PacketCount, tag);
-    ThrowIfFailed(hr);
+        uint32_t tag;
+        hr = mReader.GetSeekTable(index, &wmaBuffer.pDecodedPacketCumulativeBytes, wmaBuffer.PacketCount, tag);
+        ThrowIfFailed(hr);
 
-    if (tag == WAVE_FORMAT_WMAUDIO2 || tag == WAVE_FORMAT_WMAUDIO3)
-    {
-        hr = voice->SubmitSourceBuffer(&buffer, &wmaBuffer);
-    }
-    else
+        if (tag == WAVE_FORMAT_WMAUDIO2 || tag == WAVE_FORMAT_WMAUDIO3)
+        {
+            hr = voice->SubmitSourceBuffer(&buffer, &wmaBuffer);
+        }
+        else
     #endif
-    {
-        hr = voice->SubmitSourceBuffer(&buffer, nullptr);
+        {
+            hr = voice->SubmitSourceBuffer(&buffer, nullptr);
+        }
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: WaveBank failed (%08X) when submitting buffer:\n", hr);
+            DebugTrace("\tFormat Tag %u, %u channels, %u-bit, %u Hz, %u bytes\n", wfx->wFormatTag,
+                       wfx->nChannels, wfx->wBitsPerSample, wfx->nSamplesPerSec, metadata.lengthBytes);
+            throw std::exception("SubmitSourceBuffer");
+        }
     }
-    if (FAILED(hr))
+    catch (...)
     {
-        DebugTrace("ERROR: WaveBank failed (%08X) when submitting buffer:\n", hr);
-        DebugTrace("\tFormat Tag %u, %u channels, %u-bit, %u Hz, %u bytes\n", wfx->wFormatTag,
-                   wfx->nChannels, wfx->wBitsPerSample, wfx->nSamplesPerSec, metadata.lengthBytes);
-        throw std::exception("SubmitSourceBuffer");
+        mEngine->ReleaseOneShot(voice);
+        throw;
     }
 
     InterlockedIncrement(&mOneShots);
@@ -249,10 +273,10 @@ void WaveBank::Impl::Play(unsigned int index, float volume, float pitch, float p
 
 // Public constructors.
 _Use_decl_annotations_
-WaveBank::WaveBank(AudioEngine* engine, const wchar_t* wbFileName)
+WaveBank::WaveBank(AudioEngine* engine, const wchar_t* wbFileName, WAVE_BANK_FLAGS flags)
     : pImpl(std::make_unique<Impl>(engine))
 {
-    HRESULT hr = pImpl->Initialize(engine, wbFileName);
+    HRESULT hr = pImpl->Initialize(engine, wbFileName, flags);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: WaveBank failed (%08X) to intialize from .xwb file \"%ls\"\n", hr, wbFileName);
@@ -346,10 +370,13 @@ std::unique_ptr<SoundEffectInstance> WaveBank::CreateInstance(unsigned int index
         pImpl->mPrepared = true;
     }
 
-    auto effect = new SoundEffectInstance(pImpl->mEngine, this, index, flags);
-    assert(effect != nullptr);
-    pImpl->mInstances.emplace_back(effect);
-    return std::unique_ptr<SoundEffectInstance>(effect);
+    std::unique_ptr<SoundEffectInstance> effect(new SoundEffectInstance(pImpl->mEngine, this, index, flags));
+    if (!pImpl->mBus.empty())
+    {
+        effect->SetOutputBus(pImpl->mBus.c_str());
+    }
+    pImpl->mInstances.emplace_back(effect.get());
+    return effect;
 }
 
 
@@ -366,6 +393,45 @@ std::unique_ptr<SoundEffectInstance> WaveBank::CreateInstance(_In_z_ const char*
 }
 
 
+std::unique_ptr<SoundStreamInstance> WaveBank::CreateStreamInstance(unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags)
+{
+    auto& wb = pImpl->mReader;
+
+    if (!pImpl->mStreaming)
+    {
+        DebugTrace("ERROR: SoundStreamInstances can only be created from a streaming wave bank\n");
+        throw std::exception("WaveBank::CreateStreamInstance");
+    }
+
+    if (index >= wb.Count())
+    {
+        // We don't throw an exception here as titles often simply ignore missing assets rather than fail
+        return std::unique_ptr<SoundStreamInstance>();
+    }
+
+    std::unique_ptr<SoundStreamInstance> stream(new SoundStreamInstance(pImpl->mEngine, this, index, flags));
+    if (!pImpl->mBus.empty())
+    {
+        stream->SetOutputBus(pImpl->mBus.c_str());
+    }
+    pImpl->mStreamInstances.emplace_back(stream.get());
+    return stream;
+}
+
+
+std::unique_ptr<SoundStreamInstance> WaveBank::CreateStreamInstance(_In_z_ const char* name, SOUND_EFFECT_INSTANCE_FLAGS flags)
+{
+    unsigned int index = pImpl->mReader.Find(name);
+    if (index == unsigned(-1))
+    {
+        // We don't throw an exception here as titles often simply ignore missing assets rather than fail
+        return std::unique_ptr<SoundStreamInstance>();
+    }
+
+    return CreateStreamInstance(index, flags);
+}
+
+
 void WaveBank::UnregisterInstance(_In_ SoundEffectInstance* instance)
 {
     auto it = std::find(pImpl->mInstances.begin(), pImpl->mInstances.end(), instance);
@@ -376,6 +442,54 @@ void WaveBank::UnregisterInstance(_In_ SoundEffectInstance* instance)
 }
 
 
+void WaveBank::UnregisterInstance(_In_ SoundStreamInstance* instance)
+{
+    auto it = std::find(pImpl->mStreamInstances.begin(), pImpl->mStreamInstances.end(), instance);
+    if (it == pImpl->mStreamInstances.end())
+        return;
+
+    pImpl->mStreamInstances.erase(it);
+}
+
+
+HANDLE WaveBank::GetAsyncHandle() const noexcept
+{
+    return pImpl->mReader.GetAsyncHandle();
+}
+
+
+// Fills in a WaveBankReader::Metadata, with offsetBytes made relative to the start of the file, or a
+// WaveBankReader::SeekData, picked by the size of the data.
+_Use_decl_annotations_
+bool WaveBank::GetPrivateData(unsigned int index, void* data, size_t datasize)
+{
+    if (index >= pImpl->mReader.Count() || !data)
+        return false;
+
+    switch (datasize)
+    {
+        case sizeof(WaveBankReader::Metadata):
+        {
+            auto ptr = reinterpret_cast<WaveBankReader::Metadata*>(data);
+            if (FAILED(pImpl->mReader.GetMetadata(index, *ptr)))
+                return false;
+
+            ptr->offsetBytes += pImpl->mReader.BankAudioOffset();
+            return true;
+        }
+
+        case sizeof(WaveBankReader::SeekData):
+        {
+            auto ptr = reinterpret_cast<WaveBankReader::SeekData*>(data);
+            return SUCCEEDED(pImpl->mReader.GetSeekTable(index, &ptr->seekTable, ptr->seekCount, ptr->tag));
+        }
+
+        default:
+            return false;
+    }
+}
+
+
 // Public accessors.
 bool WaveBank::IsPrepared() const noexcept
 {
@@ -392,7 +506,7 @@ bool WaveBank::IsPrepared() const noexcept
 
 bool WaveBank::IsInUse() const noexcept
 {
-    return (pImpl->mOneShots > 0) || !pImpl->mInstances.empty();
+    return (pImpl->mOneShots > 0) || !pImpl->mInstances.empty() || !pImpl->mStreamInstances.empty();
 }
 
 
@@ -402,6 +516,26 @@ bool WaveBank::IsStreamingBank() const noexcept
 }
 
 
+_Use_decl_annotations_
+void WaveBank::SetOutputBus(const char* name)
+{
+    if (name && *name)
+    {
+        if (!pImpl->mEngine->GetBus(name) && pImpl->mEngine->IsAudioDevicePresent())
+        {
+            DebugTrace("ERROR: Submix bus \"%hs\" not found\n", name);
+            throw std::invalid_argument("SetOutputBus");
+        }
+
+        pImpl->mBus = name;
+    }
+    else
+    {
+        pImpl->mBus.clear();
+    }
+}
+
+
 size_t WaveBank::GetSampleSizeInBytes(unsigned int index) const noexcept
 {
     if (index >= pImpl->mReader.Count())
@@ -450,6 +584,27 @@ size_t WaveBank::GetSampleDurationMS(unsigned int index) const noexcept
 }
 
 
+void WaveBank::ReserveVoices(size_t count)
+{
+    // Streaming banks only play through instances, which don't use the voice pool
+    if (pImpl->mStreaming || !count)
+        return;
+
+    auto& wb = pImpl->mReader;
+
+    for (uint32_t j = 0; j < wb.Count(); ++j)
+    {
+        char buff[64] = {};
+        auto wfx = reinterpret_cast<WAVEFORMATEX*>(buff);
+        if (FAILED(wb.GetFormat(j, wfx, sizeof(buff))))
+            continue;
+
+        // Entries that share a format share the same pooled voices
+        pImpl->mEngine->ReserveVoices(wfx, count);
+    }
+}
+
+
 _Use_decl_annotations_
 const WAVEFORMATEX* WaveBank::GetFormat(unsigned int index, WAVEFORMATEX* wfx, size_t maxsize) const noexcept
 {
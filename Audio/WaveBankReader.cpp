@@ -14,6 +14,7 @@
 #include "WaveBankReader.h"
 #include "Audio.h"
 #include "PlatformHelpers.h"
+#include "MemoryTracker.h"
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
 #include <apu.h>
@@ -428,16 +429,19 @@ public:
         m_request{},
         m_prepared(false),
         m_header{},
-        m_data{}
+        m_data{},
+        m_mappedData(nullptr),
+        m_prefetch(nullptr),
+        m_trackingHandle(0)
     #if defined(_XBOX_ONE) && defined(_TITLE)
         , m_xmaMemory(nullptr)
     #endif
     {
     }
 
-    ~Impl() { Close(); }
+    ~Impl() { Close(); MemoryTracker::ReleaseAllocation(m_trackingHandle); }
 
-    HRESULT Open(_In_z_ const wchar_t* szFileName) noexcept;
+    HRESULT Open(_In_z_ const wchar_t* szFileName, bool memoryMapped, bool prefetch) noexcept;
     void Close() noexcept;
 
     HRESULT GetFormat(_In_ uint32_t index, _Out_writes_bytes_(maxsize) WAVEFORMATEX* pFormat, _In_ size_t maxsize) const noexcept;
@@ -459,6 +463,11 @@ public:
         m_entries.reset();
         m_seekData.reset();
         m_waveData.reset();
+        m_mappedView.reset();
+        m_mappedData = nullptr;
+
+        MemoryTracker::ReleaseAllocation(m_trackingHandle);
+        m_trackingHandle = 0;
 
     #if defined(_XBOX_ONE) && defined(_TITLE)
         if (m_xmaMemory)
@@ -483,6 +492,15 @@ private:
     std::unique_ptr<uint8_t[]>          m_seekData;
     std::unique_ptr<uint8_t[]>          m_waveData;
 
+    ScopedMappedView                    m_mappedView;
+    const uint8_t*                      m_mappedData;
+    PTP_WORK                            m_prefetch;
+    uint64_t                            m_trackingHandle;
+
+    HRESULT MapWaveData(_In_ HANDLE hFile, bool prefetch) noexcept;
+
+    static void CALLBACK PrefetchCallback(PTP_CALLBACK_INSTANCE, void* context, PTP_WORK) noexcept;
+
 #if defined(_XBOX_ONE) && defined(_TITLE)
 public:
     void*                               m_xmaMemory;
@@ -491,7 +509,7 @@ public:
 
 
 _Use_decl_annotations_
-HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName) noexcept
+HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName, bool memoryMapped, bool prefetch) noexcept
 {
     Close();
     Clear();
@@ -836,9 +854,7 @@ HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName) noexcept
     }
     else
     {
-        // If in-memory, kick off read of wave data
-        void *dest;
-
+        // If in-memory, map or kick off read of wave data
     #if defined(_XBOX_ONE) && defined(_TITLE)
         bool xma = false;
         if (m_data.dwFlags & BANKDATA::FLAGS_COMPACT)
@@ -859,6 +875,19 @@ HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName) noexcept
             }
         }
 
+        // XMA data has to live in APU memory, so it is always read
+        if (xma)
+            memoryMapped = false;
+    #endif
+
+        if (memoryMapped)
+        {
+            return MapWaveData(hFile.get(), prefetch);
+        }
+
+        void *dest;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
         if (xma)
         {
             HRESULT hr = ApuAlloc(&m_xmaMemory, nullptr, waveLen, SHAPE_XMA_INPUT_BUFFER_ALIGNMENT);
@@ -880,6 +909,8 @@ HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName) noexcept
             dest = m_waveData.get();
         }
 
+        m_trackingHandle = MemoryTracker::TrackAllocation(MemoryCategory_Audio, waveLen, szFileName);
+
         memset(&m_request, 0, sizeof(OVERLAPPED));
         m_request.Offset = m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset;
         m_request.hEvent = m_event.get();
@@ -903,8 +934,91 @@ HRESULT WaveBankReader::Impl::Open(const wchar_t* szFileName) noexcept
 }
 
 
+_Use_decl_annotations_
+HRESULT WaveBankReader::Impl::MapWaveData(HANDLE hFile, bool prefetch) noexcept
+{
+    const DWORD waveOffset = m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset;
+    const DWORD waveLen = m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwLength;
+
+    // Views have to start on an allocation granularity boundary
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+
+    const DWORD viewOffset = waveOffset - (waveOffset % info.dwAllocationGranularity);
+    const size_t viewBytes = size_t(waveOffset - viewOffset) + waveLen;
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hMapping(CreateFileMappingFromApp(hFile, nullptr, PAGE_READONLY, 0, nullptr));
+#else
+    ScopedHandle hMapping(CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr));
+#endif
+
+    if (!hMapping)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    // Fails if the file is shorter than the wave data segment claims
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    m_mappedView.reset(MapViewOfFileFromApp(hMapping.get(), FILE_MAP_READ, viewOffset, viewBytes));
+#else
+    m_mappedView.reset(MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, viewOffset, viewBytes));
+#endif
+
+    if (!m_mappedView)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    m_mappedData = static_cast<const uint8_t*>(m_mappedView.get()) + (waveOffset - viewOffset);
+    m_prepared = true;
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN10) || ((_WIN32_WINNT >= _WIN32_WINNT_WIN8) && WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP))
+    if (prefetch)
+    {
+        // Prefetch is only a hint, so the bank is still usable if it can't be queued
+        m_prefetch = CreateThreadpoolWork(PrefetchCallback, this, nullptr);
+        if (m_prefetch)
+        {
+            SubmitThreadpoolWork(m_prefetch);
+        }
+    }
+#else
+    UNREFERENCED_PARAMETER(prefetch);
+#endif
+
+    return S_OK;
+}
+
+
+void CALLBACK WaveBankReader::Impl::PrefetchCallback(PTP_CALLBACK_INSTANCE, void* context, PTP_WORK) noexcept
+{
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN10) || ((_WIN32_WINNT >= _WIN32_WINNT_WIN8) && WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP))
+    auto pThis = static_cast<Impl*>(context);
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t*>(pThis->m_mappedData);
+    range.NumberOfBytes = pThis->m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwLength;
+
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0))
+    {
+        DebugTrace("WARNING: PrefetchVirtualMemory failed (%08X) for wave bank \"%hs\"\n",
+                   static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())), pThis->m_data.szBankName);
+    }
+#else
+    UNREFERENCED_PARAMETER(context);
+#endif
+}
+
+
 void WaveBankReader::Impl::Close() noexcept
 {
+    if (m_prefetch)
+    {
+        WaitForThreadpoolWorkCallbacks(m_prefetch, TRUE);
+        CloseThreadpoolWork(m_prefetch);
+        m_prefetch = nullptr;
+    }
+
+    m_mappedView.reset();
+    m_mappedData = nullptr;
+
     if (m_async != INVALID_HANDLE_VALUE)
     {
         if (m_request.hEvent)
@@ -1087,6 +1201,9 @@ HRESULT WaveBankReader::Impl::GetWaveData(uint32_t index, const uint8_t** pData,
     const uint8_t* waveData = m_waveData.get();
 #endif
 
+    if (m_mappedData)
+        waveData = m_mappedData;
+
     if (!waveData)
         return E_FAIL;
 
@@ -1256,9 +1373,9 @@ WaveBankReader::~WaveBankReader()
 
 
 _Use_decl_annotations_
-HRESULT WaveBankReader::Open(const wchar_t* szFileName) noexcept
+HRESULT WaveBankReader::Open(const wchar_t* szFileName, bool memoryMapped, bool prefetch) noexcept
 {
-    return pImpl->Open(szFileName);
+    return pImpl->Open(szFileName, memoryMapped, prefetch);
 }
 
 
@@ -1336,6 +1453,12 @@ uint32_t WaveBankReader::BankAudioSize() const noexcept
 }
 
 
+uint32_t WaveBankReader::BankAudioOffset() const noexcept
+{
+    return pImpl->m_header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset;
+}
+
+
 _Use_decl_annotations_
 HRESULT WaveBankReader::GetFormat(uint32_t index, WAVEFORMATEX* pFormat, size_t maxsize) const noexcept
 {
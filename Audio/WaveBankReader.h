@@ -33,7 +33,9 @@ namespace DirectX
 
         ~WaveBankReader();
 
-        HRESULT Open(_In_z_ const wchar_t* szFileName) noexcept;
+        // A memory-mapped bank points straight into a read-only view of the file rather than reading the wave
+        // data up front, and can optionally prefetch the view from a background thread.
+        HRESULT Open(_In_z_ const wchar_t* szFileName, bool memoryMapped = false, bool prefetch = false) noexcept;
 
         uint32_t Find(_In_z_ const char* name) const;
 
@@ -53,6 +55,9 @@ namespace DirectX
 
         uint32_t BankAudioSize() const noexcept;
 
+        // File offset of the wave data, which Metadata::offsetBytes is relative to.
+        uint32_t BankAudioOffset() const noexcept;
+
         HRESULT GetFormat(_In_ uint32_t index, _Out_writes_bytes_(maxsize) WAVEFORMATEX* pFormat, _In_ size_t maxsize) const noexcept;
 
         HRESULT GetWaveData(_In_ uint32_t index, _Outptr_ const uint8_t** pData, _Out_ uint32_t& dataSize) const noexcept;
@@ -71,6 +76,14 @@ namespace DirectX
         };
         HRESULT GetMetadata(_In_ uint32_t index, _Out_ Metadata& metadata) const noexcept;
 
+        // Seek table of an xWMA or XMA entry, as returned by GetSeekTable.
+        struct SeekData
+        {
+            uint32_t        seekCount;
+            const uint32_t* seekTable;
+            uint32_t        tag;
+        };
+
     private:
         // Private implementation.
         class Impl;
@@ -0,0 +1,976 @@
+//--------------------------------------------------------------------------------------
+// File: benchmark.cpp
+//
+// Command-line benchmark for the library's hot paths: SpriteBatch in every sort mode,
+// SpriteFont, Model drawing, effect Apply, PrimitiveBatch, DDS and WIC loading, and
+// AudioEngine updates. Every scenario uses generated content and fixed random seeds, so
+// runs are comparable across builds and releases. Timings are CPU time per iteration and
+// GPU time from timestamp queries, written as JSON.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma warning(push)
+#pragma warning(disable : 4005)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NODRAWTEXT
+#define NOMCX
+#define NOSERVICE
+#define NOHELP
+#pragma warning(pop)
+
+#include <Windows.h>
+
+#include <d3d11_1.h>
+#include <wincodec.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <wrl\client.h>
+
+#include "CommonStates.h"
+#include "DDSTextureLoader.h"
+#include "Effects.h"
+#include "GeometricPrimitive.h"
+#include "GraphicsMemory.h"
+#include "Model.h"
+#include "PrimitiveBatch.h"
+#include "ScreenGrab.h"
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+#include "VertexTypes.h"
+#include "WICTextureLoader.h"
+
+#ifdef BENCHMARK_AUDIO
+#include "Audio.h"
+#endif
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    const UINT c_width = 1920;
+    const UINT c_height = 1080;
+
+    const uint32_t c_seed = 0x5eed1234;
+
+    struct Timings
+    {
+        std::vector<double> cpu;
+        std::vector<double> gpu;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t      items;
+        Timings     timings;
+    };
+
+    void PrintLogo()
+    {
+        wprintf(L"Microsoft (R) DirectX Tool Kit Benchmark\n");
+        wprintf(L"Copyright (C) Microsoft Corp. All rights reserved.\n");
+#ifdef _DEBUG
+        wprintf(L"*** Debug build ***\n");
+#endif
+        wprintf(L"\n");
+    }
+
+    void PrintUsage()
+    {
+        PrintLogo();
+
+        wprintf(L"Usage: benchmark <options>\n");
+        wprintf(L"\n");
+        wprintf(L"   -o <filename>       write the results as JSON to a file rather than the console\n");
+        wprintf(L"   -iterations <n>     timed iterations of each scenario (default 50)\n");
+        wprintf(L"   -filter <text>      only run scenarios whose names contain text\n");
+        wprintf(L"   -warp               use the WARP software device\n");
+        wprintf(L"   -nologo             suppress copyright message\n");
+    }
+
+
+    // Brackets GPU work with timestamp queries, waiting for the result so each iteration is measured on its own.
+    class GpuTimer
+    {
+    public:
+        explicit GpuTimer(_In_ ID3D11Device* device)
+        {
+            D3D11_QUERY_DESC desc = {};
+            desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+            if (FAILED(device->CreateQuery(&desc, mDisjoint.GetAddressOf())))
+                throw std::exception("CreateQuery");
+
+            desc.Query = D3D11_QUERY_TIMESTAMP;
+            if (FAILED(device->CreateQuery(&desc, mStart.GetAddressOf()))
+                || FAILED(device->CreateQuery(&desc, mEnd.GetAddressOf())))
+                throw std::exception("CreateQuery");
+        }
+
+        void Begin(_In_ ID3D11DeviceContext* context)
+        {
+            context->Begin(mDisjoint.Get());
+            context->End(mStart.Get());
+        }
+
+        // Returns milliseconds, or a negative value if the clock was disturbed.
+        double End(_In_ ID3D11DeviceContext* context)
+        {
+            context->End(mEnd.Get());
+            context->End(mDisjoint.Get());
+
+            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+            while (context->GetData(mDisjoint.Get(), &disjoint, sizeof(disjoint), 0) == S_FALSE)
+            {
+                SwitchToThread();
+            }
+
+            UINT64 start = 0;
+            UINT64 end = 0;
+            while (context->GetData(mStart.Get(), &start, sizeof(start), 0) == S_FALSE) {}
+            while (context->GetData(mEnd.Get(), &end, sizeof(end), 0) == S_FALSE) {}
+
+            if (disjoint.Disjoint || !disjoint.Frequency)
+                return -1.0;
+
+            return double(end - start) * 1000.0 / double(disjoint.Frequency);
+        }
+
+    private:
+        ComPtr<ID3D11Query> mDisjoint;
+        ComPtr<ID3D11Query> mStart;
+        ComPtr<ID3D11Query> mEnd;
+    };
+
+
+    class Benchmark
+    {
+    public:
+        Benchmark(size_t iterations, const wchar_t* filter) :
+            mIterations(iterations),
+            mFilter(filter)
+        {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            mTicksToMs = 1000.0 / double(frequency.QuadPart);
+        }
+
+        bool IsEnabled(const char* name) const
+        {
+            if (!mFilter)
+                return true;
+
+            wchar_t wname[256] = {};
+            MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, static_cast<int>(_countof(wname)) - 1);
+            return wcsstr(wname, mFilter) != nullptr;
+        }
+
+        // Runs work a few times untimed, then for every iteration. With a context, GPU time is measured as well.
+        void Run(const char* name, size_t items, _In_opt_ ID3D11DeviceContext* context, _In_opt_ GpuTimer* timer,
+                 const std::function<void()>& work)
+        {
+            if (!IsEnabled(name))
+                return;
+
+            wprintf(L"%hs...\n", name);
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                work();
+                Finish(context);
+            }
+
+            Result result;
+            result.name = name;
+            result.items = items;
+
+            for (size_t j = 0; j < mIterations; ++j)
+            {
+                if (context && timer)
+                    timer->Begin(context);
+
+                LARGE_INTEGER start;
+                QueryPerformanceCounter(&start);
+
+                work();
+
+                LARGE_INTEGER end;
+                QueryPerformanceCounter(&end);
+
+                result.timings.cpu.push_back(double(end.QuadPart - start.QuadPart) * mTicksToMs);
+
+                if (context && timer)
+                {
+                    double gpu = timer->End(context);
+                    if (gpu >= 0.0)
+                        result.timings.gpu.push_back(gpu);
+                }
+
+                Finish(context);
+            }
+
+            mResults.push_back(std::move(result));
+        }
+
+        void WriteJson(FILE* out, const wchar_t* adapter, D3D_FEATURE_LEVEL featureLevel) const
+        {
+            char adapterName[256] = {};
+            WideCharToMultiByte(CP_UTF8, 0, adapter, -1, adapterName, static_cast<int>(_countof(adapterName)) - 1, nullptr, nullptr);
+
+            fprintf(out, "{\n");
+            fprintf(out, "  \"adapter\": \"%s\",\n", Escape(adapterName).c_str());
+            fprintf(out, "  \"featureLevel\": \"%u.%u\",\n", (featureLevel >> 12) & 0xF, (featureLevel >> 8) & 0xF);
+            fprintf(out, "  \"iterations\": %zu,\n", mIterations);
+            fprintf(out, "  \"results\": [\n");
+
+            for (size_t j = 0; j < mResults.size(); ++j)
+            {
+                auto& result = mResults[j];
+
+                fprintf(out, "    {\n");
+                fprintf(out, "      \"name\": \"%s\",\n", Escape(result.name.c_str()).c_str());
+                fprintf(out, "      \"items\": %zu,\n", result.items);
+                fprintf(out, "      \"cpu_ms\": ");
+                WriteStats(out, result.timings.cpu);
+                fprintf(out, ",\n      \"gpu_ms\": ");
+                WriteStats(out, result.timings.gpu);
+                fprintf(out, "\n    }%s\n", (j + 1 < mResults.size()) ? "," : "");
+            }
+
+            fprintf(out, "  ]\n");
+            fprintf(out, "}\n");
+        }
+
+    private:
+        static void Finish(_In_opt_ ID3D11DeviceContext* context)
+        {
+            if (GraphicsMemory::IsCreated())
+                GraphicsMemory::Get().Commit();
+
+            if (context)
+                context->Flush();
+        }
+
+        static void WriteStats(FILE* out, std::vector<double> samples)
+        {
+            if (samples.empty())
+            {
+                fprintf(out, "null");
+                return;
+            }
+
+            std::sort(samples.begin(), samples.end());
+
+            double sum = 0.0;
+            for (auto value : samples)
+                sum += value;
+
+            fprintf(out, "{ \"min\": %.6f, \"median\": %.6f, \"mean\": %.6f, \"max\": %.6f }",
+                samples.front(), samples[samples.size() / 2], sum / double(samples.size()), samples.back());
+        }
+
+        static std::string Escape(const char* text)
+        {
+            std::string result;
+            for (; *text; ++text)
+            {
+                if (*text == '"' || *text == '\\')
+                    result += '\\';
+
+                result += *text;
+            }
+            return result;
+        }
+
+        size_t              mIterations;
+        const wchar_t*      mFilter;
+        double              mTicksToMs;
+        std::vector<Result> mResults;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Generated content
+
+    void CreateSolidTexture(_In_ ID3D11Device* device, uint32_t color, UINT size, _Outptr_ ID3D11ShaderResourceView** textureView)
+    {
+        std::vector<uint32_t> pixels(size * size, color);
+
+        D3D11_SUBRESOURCE_DATA initData = { pixels.data(), size * sizeof(uint32_t), 0 };
+
+        CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+
+        ComPtr<ID3D11Texture2D> texture;
+        if (FAILED(device->CreateTexture2D(&desc, &initData, texture.GetAddressOf()))
+            || FAILED(device->CreateShaderResourceView(texture.Get(), nullptr, textureView)))
+            throw std::exception("CreateSolidTexture");
+    }
+
+
+    // Monospaced font of 8x16 cells covering printable ASCII, laid out 16 glyphs to a row.
+    std::unique_ptr<SpriteFont> CreateMonospaceFont(_In_ ID3D11ShaderResourceView* texture)
+    {
+        std::vector<SpriteFont::Glyph> glyphs;
+
+        for (uint32_t c = 32; c < 127; ++c)
+        {
+            LONG x = LONG((c - 32) % 16) * 8;
+            LONG y = LONG((c - 32) / 16) * 16;
+
+            SpriteFont::Glyph glyph = {};
+            glyph.Character = c;
+            glyph.Subrect = { x, y, x + 8, y + 16 };
+            glyph.XAdvance = 1.f;
+            glyphs.push_back(glyph);
+        }
+
+        auto font = std::make_unique<SpriteFont>(texture, glyphs.data(), glyphs.size(), 16.f);
+        font->SetDefaultCharacter(L'?');
+        return font;
+    }
+
+
+    // Model of partCount cubes sharing one vertex and index buffer, in meshes of 100 parts, cycling through the effects.
+    std::unique_ptr<Model> CreateModel(_In_ ID3D11Device* device, std::vector<std::shared_ptr<IEffect>> const& effects, size_t partCount)
+    {
+        std::vector<GeometricPrimitive::VertexType> vertices;
+        std::vector<uint16_t> indices;
+        GeometricPrimitive::CreateCube(vertices, indices);
+
+        ComPtr<ID3D11Buffer> vb;
+        {
+            CD3D11_BUFFER_DESC desc(static_cast<UINT>(vertices.size() * sizeof(vertices[0])), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+            D3D11_SUBRESOURCE_DATA initData = { vertices.data(), 0, 0 };
+            if (FAILED(device->CreateBuffer(&desc, &initData, vb.GetAddressOf())))
+                throw std::exception("CreateBuffer");
+        }
+
+        ComPtr<ID3D11Buffer> ib;
+        {
+            CD3D11_BUFFER_DESC desc(static_cast<UINT>(indices.size() * sizeof(uint16_t)), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+            D3D11_SUBRESOURCE_DATA initData = { indices.data(), 0, 0 };
+            if (FAILED(device->CreateBuffer(&desc, &initData, ib.GetAddressOf())))
+                throw std::exception("CreateBuffer");
+        }
+
+        auto decl = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+            VertexPositionNormalTexture::InputElements,
+            VertexPositionNormalTexture::InputElements + VertexPositionNormalTexture::InputElementCount);
+
+        std::vector<ComPtr<ID3D11InputLayout>> inputLayouts(effects.size());
+        for (size_t j = 0; j < effects.size(); ++j)
+        {
+            void const* shaderByteCode;
+            size_t byteCodeLength;
+            effects[j]->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+            if (FAILED(device->CreateInputLayout(decl->data(), static_cast<UINT>(decl->size()), shaderByteCode, byteCodeLength,
+                inputLayouts[j].GetAddressOf())))
+                throw std::exception("CreateInputLayout");
+        }
+
+        const size_t partsPerMesh = 100;
+
+        auto model = std::make_unique<Model>();
+
+        for (size_t j = 0; j < partCount; j += partsPerMesh)
+        {
+            auto mesh = std::make_shared<ModelMesh>();
+            mesh->ccw = true;
+            mesh->boundingSphere = BoundingSphere(XMFLOAT3(0.f, 0.f, 0.f), 1.f);
+            mesh->boundingBox = BoundingBox(XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+            for (size_t k = j; k < std::min(j + partsPerMesh, partCount); ++k)
+            {
+                size_t e = k % effects.size();
+
+                auto part = new ModelMeshPart();
+                part->indexCount = static_cast<uint32_t>(indices.size());
+                part->vertexStride = sizeof(GeometricPrimitive::VertexType);
+                part->inputLayout = inputLayouts[e];
+                part->indexBuffer = ib;
+                part->vertexBuffer = vb;
+                part->effect = effects[e];
+                part->vbDecl = decl;
+
+                mesh->meshParts.emplace_back(part);
+            }
+
+            model->meshes.push_back(mesh);
+        }
+
+        return model;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Scenarios
+
+    void RunSpriteBatch(Benchmark& bench, _In_ ID3D11DeviceContext* context, GpuTimer& timer,
+                        std::vector<ComPtr<ID3D11ShaderResourceView>> const& textures)
+    {
+        struct SortMode
+        {
+            SpriteSortMode  mode;
+            const char*     name;
+        };
+
+        static const SortMode s_modes[] =
+        {
+            { SpriteSortMode_Deferred,      "Deferred" },
+            { SpriteSortMode_Immediate,     "Immediate" },
+            { SpriteSortMode_Texture,       "Texture" },
+            { SpriteSortMode_BackToFront,   "BackToFront" },
+            { SpriteSortMode_FrontToBack,   "FrontToBack" },
+        };
+
+        static const size_t s_counts[] = { 1000, 10000, 100000 };
+
+        SpriteBatch batch(context);
+
+        struct Sprite
+        {
+            XMFLOAT2    position;
+            XMFLOAT4    color;
+            float       depth;
+            size_t      texture;
+        };
+
+        std::mt19937 rng(c_seed);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        std::vector<Sprite> sprites(s_counts[_countof(s_counts) - 1]);
+        for (auto& sprite : sprites)
+        {
+            sprite.position = XMFLOAT2(unit(rng) * c_width, unit(rng) * c_height);
+            sprite.color = XMFLOAT4(unit(rng), unit(rng), unit(rng), 1.f);
+            sprite.depth = unit(rng);
+            sprite.texture = rng() % textures.size();
+        }
+
+        for (auto& mode : s_modes)
+        {
+            for (auto count : s_counts)
+            {
+                std::string name = std::string("SpriteBatch.") + mode.name + "." + std::to_string(count);
+
+                bench.Run(name.c_str(), count, context, &timer, [&]()
+                {
+                    batch.Begin(mode.mode);
+
+                    for (size_t j = 0; j < count; ++j)
+                    {
+                        auto& sprite = sprites[j];
+                        batch.Draw(textures[sprite.texture].Get(), sprite.position, nullptr, XMLoadFloat4(&sprite.color),
+                                   0.f, Float2Zero, 1.f, SpriteEffects_None, sprite.depth);
+                    }
+
+                    batch.End();
+                });
+            }
+        }
+    }
+
+
+    void RunSpriteFont(Benchmark& bench, _In_ ID3D11DeviceContext* context, GpuTimer& timer, _In_ ID3D11ShaderResourceView* fontTexture)
+    {
+        static const wchar_t s_text[] = L"The quick brown fox jumps over the lazy dog. 0123456789 !@#$%^&*()";
+        const size_t lines = 60;
+
+        auto font = CreateMonospaceFont(fontTexture);
+        SpriteBatch batch(context);
+
+        bench.Run("SpriteFont.DrawString", lines * (_countof(s_text) - 1), context, &timer, [&]()
+        {
+            batch.Begin();
+
+            for (size_t j = 0; j < lines; ++j)
+            {
+                font->DrawString(&batch, s_text, XMFLOAT2(0.f, float(j) * 16.f));
+            }
+
+            batch.End();
+        });
+
+        const size_t measures = 10000;
+
+        bench.Run("SpriteFont.MeasureString", measures, nullptr, nullptr, [&]()
+        {
+            XMVECTOR total = XMVectorZero();
+
+            for (size_t j = 0; j < measures; ++j)
+            {
+                total = XMVectorAdd(total, font->MeasureString(s_text));
+            }
+
+            // Keeps the loop from being optimized away.
+            if (XMVectorGetX(total) < 0.f)
+                wprintf(L"\n");
+        });
+    }
+
+
+    void RunModel(Benchmark& bench, _In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, GpuTimer& timer,
+                  _In_ ID3D11ShaderResourceView* texture)
+    {
+        const size_t partCount = 10000;
+
+        std::vector<std::shared_ptr<IEffect>> effects;
+        for (size_t j = 0; j < 8; ++j)
+        {
+            auto effect = std::make_shared<BasicEffect>(device);
+            effect->EnableDefaultLighting();
+            effect->SetTextureEnabled(true);
+            effect->SetTexture(texture);
+            effect->SetDiffuseColor(XMVectorSet(float(j + 1) / 8.f, 1.f, 1.f, 1.f));
+            effects.push_back(effect);
+        }
+
+        auto model = CreateModel(device, effects, partCount);
+
+        CommonStates states(device);
+
+        XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0.f, 2.f, 4.f, 0.f), g_XMZero, g_XMIdentityR1);
+        XMMATRIX projection = XMMatrixPerspectiveFovRH(XM_PIDIV4, float(c_width) / float(c_height), 0.1f, 100.f);
+
+        bench.Run("Model.Draw.10000parts", partCount, context, &timer, [&]()
+        {
+            model->Draw(context, states, XMMatrixIdentity(), view, projection);
+        });
+
+        bench.Run("Model.DrawCulled.10000parts", partCount, context, &timer, [&]()
+        {
+            model->DrawCulled(context, states, XMMatrixIdentity(), view, projection);
+        });
+    }
+
+
+    void RunEffects(Benchmark& bench, _In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, GpuTimer& timer,
+                    _In_ ID3D11ShaderResourceView* texture)
+    {
+        std::vector<std::shared_ptr<IEffect>> effects;
+
+        {
+            auto effect = std::make_shared<BasicEffect>(device);
+            effect->EnableDefaultLighting();
+            effect->SetPerPixelLighting(true);
+            effect->SetTextureEnabled(true);
+            effect->SetTexture(texture);
+            effects.push_back(effect);
+        }
+
+        {
+            auto effect = std::make_shared<BasicEffect>(device);
+            effect->SetVertexColorEnabled(true);
+            effects.push_back(effect);
+        }
+
+        {
+            auto effect = std::make_shared<AlphaTestEffect>(device);
+            effect->SetTexture(texture);
+            effects.push_back(effect);
+        }
+
+        {
+            auto effect = std::make_shared<DualTextureEffect>(device);
+            effect->SetTexture(texture);
+            effect->SetTexture2(texture);
+            effects.push_back(effect);
+        }
+
+        {
+            auto effect = std::make_shared<SkinnedEffect>(device);
+            effect->EnableDefaultLighting();
+            effect->SetTexture(texture);
+            effects.push_back(effect);
+        }
+
+        const size_t applies = 10000;
+
+        XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0.f, 2.f, 4.f, 0.f), g_XMZero, g_XMIdentityR1);
+        XMMATRIX projection = XMMatrixPerspectiveFovRH(XM_PIDIV4, float(c_width) / float(c_height), 0.1f, 100.f);
+
+        bench.Run("Effect.Apply.churn", applies, context, &timer, [&]()
+        {
+            for (size_t j = 0; j < applies; ++j)
+            {
+                auto effect = effects[j % effects.size()].get();
+
+                auto imatrices = dynamic_cast<IEffectMatrices*>(effect);
+                if (imatrices)
+                {
+                    imatrices->SetMatrices(XMMatrixTranslation(float(j % 100), 0.f, 0.f), view, projection);
+                }
+
+                effect->Apply(context);
+            }
+        });
+    }
+
+
+    void RunPrimitiveBatch(Benchmark& bench, _In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, GpuTimer& timer)
+    {
+        const size_t lineCount = 100000;
+
+        BasicEffect effect(device);
+        effect.SetVertexColorEnabled(true);
+
+        void const* shaderByteCode;
+        size_t byteCodeLength;
+        effect.GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+        ComPtr<ID3D11InputLayout> inputLayout;
+        if (FAILED(device->CreateInputLayout(VertexPositionColor::InputElements, VertexPositionColor::InputElementCount,
+            shaderByteCode, byteCodeLength, inputLayout.GetAddressOf())))
+            throw std::exception("CreateInputLayout");
+
+        std::mt19937 rng(c_seed);
+        std::uniform_real_distribution<float> coord(-1.f, 1.f);
+
+        std::vector<VertexPositionColor> vertices(lineCount * 2);
+        for (auto& v : vertices)
+        {
+            v.position = XMFLOAT3(coord(rng), coord(rng), 0.5f);
+            v.color = XMFLOAT4(1.f, 1.f, 1.f, 1.f);
+        }
+
+        PrimitiveBatch<VertexPositionColor> batch(context);
+
+        bench.Run("PrimitiveBatch.DrawLine.100000", lineCount, context, &timer, [&]()
+        {
+            effect.Apply(context);
+            context->IASetInputLayout(inputLayout.Get());
+
+            batch.Begin();
+
+            for (size_t j = 0; j < lineCount; ++j)
+            {
+                batch.DrawLine(vertices[j * 2], vertices[j * 2 + 1]);
+            }
+
+            batch.End();
+        });
+    }
+
+
+    bool ReadFile(_In_z_ const wchar_t* fileName, std::vector<uint8_t>& data)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file)
+            return false;
+
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !data.empty();
+    }
+
+
+    // Saves the render target as DDS and PNG, then times loading those images from memory.
+    void RunTextureLoading(Benchmark& bench, _In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, _In_ ID3D11Texture2D* source)
+    {
+        wchar_t tempPath[MAX_PATH] = {};
+        if (!GetTempPathW(MAX_PATH, tempPath))
+            return;
+
+        std::wstring ddsFile = std::wstring(tempPath) + L"DirectXTK_benchmark.dds";
+        std::wstring pngFile = std::wstring(tempPath) + L"DirectXTK_benchmark.png";
+
+        std::vector<uint8_t> ddsData;
+        if (SUCCEEDED(SaveDDSTextureToFile(context, source, ddsFile.c_str())) && ReadFile(ddsFile.c_str(), ddsData))
+        {
+            bench.Run("DDSTextureLoader.FromMemory.1920x1080", 1, nullptr, nullptr, [&]()
+            {
+                ComPtr<ID3D11ShaderResourceView> srv;
+                if (FAILED(CreateDDSTextureFromMemory(device, ddsData.data(), ddsData.size(), nullptr, srv.GetAddressOf())))
+                    throw std::exception("CreateDDSTextureFromMemory");
+            });
+        }
+
+        std::vector<uint8_t> pngData;
+        if (SUCCEEDED(SaveWICTextureToFile(context, source, GUID_ContainerFormatPng, pngFile.c_str())) && ReadFile(pngFile.c_str(), pngData))
+        {
+            bench.Run("WICTextureLoader.FromMemory.1920x1080", 1, nullptr, nullptr, [&]()
+            {
+                ComPtr<ID3D11ShaderResourceView> srv;
+                if (FAILED(CreateWICTextureFromMemory(device, pngData.data(), pngData.size(), nullptr, srv.GetAddressOf())))
+                    throw std::exception("CreateWICTextureFromMemory");
+            });
+        }
+
+        DeleteFileW(ddsFile.c_str());
+        DeleteFileW(pngFile.c_str());
+    }
+
+
+#ifdef BENCHMARK_AUDIO
+    // Half a second of a 16-bit mono tone. SoundEffect keeps pointers into its data, so the format goes in the same block.
+    std::unique_ptr<SoundEffect> CreateTone(_In_ AudioEngine* engine)
+    {
+        const uint32_t sampleRate = 44100;
+        const size_t sampleCount = sampleRate / 2;
+
+        std::unique_ptr<uint8_t[]> wavData(new uint8_t[sizeof(WAVEFORMATEX) + sampleCount * sizeof(int16_t)]);
+
+        auto wfx = reinterpret_cast<WAVEFORMATEX*>(wavData.get());
+        *wfx = {};
+        wfx->wFormatTag = WAVE_FORMAT_PCM;
+        wfx->nChannels = 1;
+        wfx->nSamplesPerSec = sampleRate;
+        wfx->wBitsPerSample = 16;
+        wfx->nBlockAlign = sizeof(int16_t);
+        wfx->nAvgBytesPerSec = sampleRate * sizeof(int16_t);
+
+        auto samples = reinterpret_cast<int16_t*>(wavData.get() + sizeof(WAVEFORMATEX));
+        for (size_t j = 0; j < sampleCount; ++j)
+        {
+            samples[j] = static_cast<int16_t>(8192.f * sinf(float(j) * XM_2PI * 440.f / float(sampleRate)));
+        }
+
+        auto startAudio = reinterpret_cast<const uint8_t*>(samples);
+        return std::make_unique<SoundEffect>(engine, wavData, wfx, startAudio, sampleCount * sizeof(int16_t));
+    }
+
+
+    void RunAudio(Benchmark& bench)
+    {
+        if (!bench.IsEnabled("AudioEngine.Update.oneshots"))
+            return;
+
+        std::unique_ptr<AudioEngine> engine;
+        try
+        {
+            engine = std::make_unique<AudioEngine>();
+        }
+        catch (...)
+        {
+            wprintf(L"WARNING: Skipping audio, no audio engine\n");
+            return;
+        }
+
+        if (!engine->IsAudioDevicePresent())
+        {
+            wprintf(L"WARNING: Skipping audio, no audio device\n");
+            return;
+        }
+
+        auto tone = CreateTone(engine.get());
+
+        std::mt19937 rng(c_seed);
+        std::uniform_real_distribution<float> pitch(-1.f, 1.f);
+
+        const size_t oneShots = 32;
+
+        bench.Run("AudioEngine.Update.oneshots", oneShots, nullptr, nullptr, [&]()
+        {
+            for (size_t j = 0; j < oneShots; ++j)
+            {
+                tone->Play(0.1f, pitch(rng), 0.f);
+            }
+
+            engine->Update();
+        });
+
+        engine->Suspend();
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------------------------------
+// Entry-point
+//--------------------------------------------------------------------------------------
+#pragma prefast(disable : 28198, "Command-line tool, frees all memory on exit")
+
+int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
+{
+    const wchar_t* outputFile = nullptr;
+    const wchar_t* filter = nullptr;
+    size_t iterations = 50;
+    bool warp = false;
+    bool nologo = false;
+
+    for (int iArg = 1; iArg < argc; ++iArg)
+    {
+        const wchar_t* pArg = argv[iArg];
+
+        if (!_wcsicmp(pArg, L"-o") && iArg + 1 < argc)
+        {
+            outputFile = argv[++iArg];
+        }
+        else if (!_wcsicmp(pArg, L"-iterations") && iArg + 1 < argc)
+        {
+            iterations = wcstoul(argv[++iArg], nullptr, 10);
+            if (!iterations)
+            {
+                wprintf(L"ERROR: Invalid iteration count\n");
+                return 1;
+            }
+        }
+        else if (!_wcsicmp(pArg, L"-filter") && iArg + 1 < argc)
+        {
+            filter = argv[++iArg];
+        }
+        else if (!_wcsicmp(pArg, L"-warp"))
+        {
+            warp = true;
+        }
+        else if (!_wcsicmp(pArg, L"-nologo"))
+        {
+            nologo = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!nologo)
+        PrintLogo();
+
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr))
+    {
+        wprintf(L"ERROR: CoInitializeEx failed (%08X)\n", static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    static const D3D_FEATURE_LEVEL s_featureLevels[] =
+    {
+        D3D_FEATURE_LEVEL_11_1,
+        D3D_FEATURE_LEVEL_11_0,
+        D3D_FEATURE_LEVEL_10_1,
+        D3D_FEATURE_LEVEL_10_0,
+    };
+
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11DeviceContext> context;
+    D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_10_0;
+
+    hr = D3D11CreateDevice(nullptr, warp ? D3D_DRIVER_TYPE_WARP : D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
+        s_featureLevels, static_cast<UINT>(_countof(s_featureLevels)), D3D11_SDK_VERSION,
+        device.GetAddressOf(), &featureLevel, context.GetAddressOf());
+    if (FAILED(hr))
+    {
+        wprintf(L"ERROR: D3D11CreateDevice failed (%08X)\n", static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    wchar_t adapterName[128] = L"Unknown";
+    {
+        ComPtr<IDXGIDevice> dxgiDevice;
+        ComPtr<IDXGIAdapter> adapter;
+        DXGI_ADAPTER_DESC desc;
+        if (SUCCEEDED(device.As(&dxgiDevice))
+            && SUCCEEDED(dxgiDevice->GetAdapter(adapter.GetAddressOf()))
+            && SUCCEEDED(adapter->GetDesc(&desc)))
+        {
+            wcscpy_s(adapterName, desc.Description);
+        }
+    }
+
+    wprintf(L"Adapter: %ls\n\n", adapterName);
+
+    FILE* out = stdout;
+    if (outputFile)
+    {
+        if (_wfopen_s(&out, outputFile, L"wt") != 0 || !out)
+        {
+            wprintf(L"ERROR: Failed creating %ls\n", outputFile);
+            return 1;
+        }
+    }
+
+    Benchmark bench(iterations, filter);
+
+    try
+    {
+        GraphicsMemory graphicsMemory(device.Get());
+
+        // Off-screen target for every GPU scenario.
+        ComPtr<ID3D11Texture2D> renderTarget;
+        ComPtr<ID3D11RenderTargetView> rtv;
+        {
+            CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, c_width, c_height, 1, 1, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE);
+            if (FAILED(device->CreateTexture2D(&desc, nullptr, renderTarget.GetAddressOf()))
+                || FAILED(device->CreateRenderTargetView(renderTarget.Get(), nullptr, rtv.GetAddressOf())))
+                throw std::exception("Render target");
+        }
+
+        ComPtr<ID3D11Texture2D> depthStencil;
+        ComPtr<ID3D11DepthStencilView> dsv;
+        {
+            CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_D32_FLOAT, c_width, c_height, 1, 1, D3D11_BIND_DEPTH_STENCIL);
+            if (FAILED(device->CreateTexture2D(&desc, nullptr, depthStencil.GetAddressOf()))
+                || FAILED(device->CreateDepthStencilView(depthStencil.Get(), nullptr, dsv.GetAddressOf())))
+                throw std::exception("Depth stencil");
+        }
+
+        context->OMSetRenderTargets(1, rtv.GetAddressOf(), dsv.Get());
+
+        CD3D11_VIEWPORT viewport(0.f, 0.f, float(c_width), float(c_height));
+        context->RSSetViewports(1, &viewport);
+
+        std::vector<ComPtr<ID3D11ShaderResourceView>> textures(4);
+        static const uint32_t s_colors[] = { 0xffffffff, 0xff0000ff, 0xff00ff00, 0xffff0000 };
+        for (size_t j = 0; j < textures.size(); ++j)
+        {
+            CreateSolidTexture(device.Get(), s_colors[j], 64, textures[j].GetAddressOf());
+        }
+
+        ComPtr<ID3D11ShaderResourceView> fontTexture;
+        CreateSolidTexture(device.Get(), 0xffffffff, 128, fontTexture.GetAddressOf());
+
+        GpuTimer timer(device.Get());
+
+        RunSpriteBatch(bench, context.Get(), timer, textures);
+        RunSpriteFont(bench, context.Get(), timer, fontTexture.Get());
+        RunModel(bench, device.Get(), context.Get(), timer, textures[0].Get());
+        RunEffects(bench, device.Get(), context.Get(), timer, textures[0].Get());
+        RunPrimitiveBatch(bench, device.Get(), context.Get(), timer);
+
+        // The target holds the last scenario's output, which makes for a less trivial image to decode.
+        RunTextureLoading(bench, device.Get(), context.Get(), renderTarget.Get());
+
+    #ifdef BENCHMARK_AUDIO
+        RunAudio(bench);
+    #endif
+    }
+    catch (const std::exception& e)
+    {
+        wprintf(L"ERROR: %hs\n", e.what());
+
+        if (out != stdout)
+            fclose(out);
+
+        return 1;
+    }
+
+    bench.WriteJson(out, adapterName, featureLevel);
+
+    if (out != stdout)
+    {
+        fclose(out);
+        wprintf(L"\nWrote results to %ls\n", outputFile);
+    }
+
+    return 0;
+}
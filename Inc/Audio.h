@@ -58,6 +58,10 @@
 namespace DirectX
 {
     class SoundEffectInstance;
+    class SoundStreamInstance;
+
+    struct AudioEmitter;
+    struct AudioListener;
 
     //----------------------------------------------------------------------------------
     struct AudioStatistics
@@ -69,12 +73,27 @@ namespace DirectX
         size_t  allocatedVoices3d;      // Number of XAudio2 voices allocated for 3D
         size_t  allocatedVoicesOneShot; // Number of XAudio2 voices allocated for one-shot sounds
         size_t  allocatedVoicesIdle;    // Number of XAudio2 voices allocated for one-shot sounds but not currently in use
+        size_t  voicePoolHits;          // Number of one-shots that reused an idle voice from the pool
+        size_t  voicePoolMisses;        // Number of one-shots in a reusable format that found no idle voice in the pool
+        size_t  virtualInstances;       // Number of sound effect instances playing without a voice (see SoundEffectInstance_Virtual)
         size_t  audioBytes;             // Total wave data (in bytes) in SoundEffects and in-memory WaveBanks
 #if defined(_XBOX_ONE) && defined(_TITLE)
         size_t  xmaAudioBytes;          // Total wave data (in bytes) in SoundEffects and in-memory WaveBanks allocated with ApuAlloc
 #endif
     };
 
+    struct AudioPerformanceData
+    {
+        uint64_t    frame;                  // Number of AudioEngine::Update calls made when this was recorded
+        XAUDIO2_PERFORMANCE_DATA xaudio2;   // Mixing cost, glitch count, active voices, and latency from IXAudio2::GetPerformanceData
+        float       updateTime;             // Milliseconds spent in AudioEngine::Update
+        float       apply3DTime;            // Milliseconds spent in AudioEngine::Apply3D batches since the previous update
+        uint32_t    apply3DBatches;         // Number of AudioEngine::Apply3D batches since the previous update
+        uint32_t    apply3DEmitters;        // Number of emitters positioned with X3DAudioCalculate in those batches
+        uint32_t    apply3DCulled;          // Number of emitters muted as out of range in those batches
+        uint32_t    streamStalls;           // Number of times a SoundStreamInstance voice ran dry waiting on a read since the previous update
+    };
+
 
     //----------------------------------------------------------------------------------
     class IVoiceNotify
@@ -114,6 +133,7 @@ namespace DirectX
         IVoiceNotify() = default;
     };
 
+
     //----------------------------------------------------------------------------------
     enum AUDIO_ENGINE_FLAGS : uint32_t
     {
@@ -126,6 +146,7 @@ namespace DirectX
         AudioEngine_Debug               = 0x10000,
         AudioEngine_ThrowOnNoAudioHW    = 0x20000,
         AudioEngine_DisableVoiceReuse   = 0x40000,
+        AudioEngine_UpdateThread        = 0x80000,
     };
 
     inline AUDIO_ENGINE_FLAGS operator|(AUDIO_ENGINE_FLAGS a, AUDIO_ENGINE_FLAGS b) noexcept { return static_cast<AUDIO_ENGINE_FLAGS>( static_cast<int>(a) | static_cast<int>(b) ); }
@@ -138,11 +159,27 @@ namespace DirectX
         SoundEffectInstance_ReverbUseFilters    = 0x2,
         SoundEffectInstance_NoSetPitch          = 0x4,
 
+        // Lets the instance give up its voice to more audible virtual instances when the instance voice limit is
+        // reached, carrying on silently and picking up where it would have been if it gets a voice back.
+        SoundEffectInstance_Virtual             = 0x8,
+
         SoundEffectInstance_UseRedirectLFE      = 0x10000,
     };
 
     inline SOUND_EFFECT_INSTANCE_FLAGS operator|(SOUND_EFFECT_INSTANCE_FLAGS a, SOUND_EFFECT_INSTANCE_FLAGS b) noexcept { return static_cast<SOUND_EFFECT_INSTANCE_FLAGS>(static_cast<int>(a) | static_cast<int>(b)); }
 
+    enum WAVE_BANK_FLAGS : uint32_t
+    {
+        WaveBank_Default                = 0x0,
+
+        // In-memory banks play straight from a read-only view of the file instead of reading it up front,
+        // optionally asking the OS to page the view in on a background thread. Ignored for streaming banks.
+        WaveBank_MemoryMapped           = 0x1,
+        WaveBank_Prefetch               = 0x2,
+    };
+
+    inline WAVE_BANK_FLAGS operator|(WAVE_BANK_FLAGS a, WAVE_BANK_FLAGS b) noexcept { return static_cast<WAVE_BANK_FLAGS>(static_cast<int>(a) | static_cast<int>(b)); }
+
     enum AUDIO_ENGINE_REVERB
     {
         Reverb_Off,
@@ -187,6 +224,42 @@ namespace DirectX
     };
 
 
+    //----------------------------------------------------------------------------------
+    class IVirtualVoice
+    {
+    public:
+        virtual ~IVirtualVoice() = default;
+
+        IVirtualVoice(const IVirtualVoice&) = delete;
+        IVirtualVoice& operator=(const IVirtualVoice&) = delete;
+
+        IVirtualVoice(IVirtualVoice&&) = delete;
+        IVirtualVoice& operator=(IVirtualVoice&&) = delete;
+
+        virtual void __cdecl UpdateVirtual() = 0;
+            // Advances a sound playing without a voice, and stops it once it has played out
+
+        virtual float __cdecl GetAudibility() const noexcept = 0;
+            // Priority-weighted loudness used to rank sounds for voices; negative if not playing
+
+        virtual bool __cdecl HasVoice() const noexcept = 0;
+
+        virtual const WAVEFORMATEX* __cdecl GetVoiceFormat() const noexcept = 0;
+        virtual SOUND_EFFECT_INSTANCE_FLAGS __cdecl GetVoiceFlags() const noexcept = 0;
+        virtual IXAudio2Voice* __cdecl GetVoiceOutput() const noexcept = 0;
+            // Voices are only passed between sounds when all of these match
+
+        virtual IXAudio2SourceVoice* __cdecl Virtualize() noexcept = 0;
+            // Gives up the voice, stopped and flushed, but keeps playing virtually
+
+        virtual void __cdecl Devirtualize(_In_opt_ IXAudio2SourceVoice* voice) = 0;
+            // Resumes on the given voice (or a newly allocated one if null) where the virtual sound has got to
+
+    protected:
+        IVirtualVoice() = default;
+    };
+
+
     //----------------------------------------------------------------------------------
     class AudioEngine
     {
@@ -194,6 +267,8 @@ namespace DirectX
         explicit AudioEngine(
             AUDIO_ENGINE_FLAGS flags = AudioEngine_Default, _In_opt_ const WAVEFORMATEX* wfx = nullptr, _In_opt_z_ const wchar_t* deviceId = nullptr,
             AUDIO_STREAM_CATEGORY category = AudioCategory_GameEffects) noexcept(false);
+            // With AudioEngine_UpdateThread, the work of Update is done on an internal thread at a fixed rate instead.
+            // Engine calls are then locked against it, but changes to sounds should go through Post.
 
         AudioEngine(AudioEngine&& moveFrom) noexcept;
         AudioEngine& operator= (AudioEngine&& moveFrom) noexcept;
@@ -205,6 +280,14 @@ namespace DirectX
 
         bool __cdecl Update();
             // Performs per-frame processing for the audio engine, returns false if in 'silent mode'
+            // With AudioEngine_UpdateThread this only returns the status, as the update thread does the processing
+
+        void __cdecl Post(std::function<void __cdecl()> command);
+            // Queues a command (such as playing or changing a sound) to run at the start of the next update
+            // With AudioEngine_UpdateThread this wakes the update thread, which runs it under the engine lock
+
+        void __cdecl SetUpdateInterval(unsigned int milliseconds);
+            // Sets how often the AudioEngine_UpdateThread thread updates (defaults to 10 ms)
 
         bool __cdecl Reset(_In_opt_ const WAVEFORMATEX* wfx = nullptr, _In_opt_z_ const wchar_t* deviceId = nullptr);
             // Reset audio engine from critical error/silent mode using a new device; can also 'migrate' the graph
@@ -226,9 +309,42 @@ namespace DirectX
         void __cdecl SetMasteringLimit(int release, int loudness);
             // Sets the mastering volume limiter properties (if active)
 
+        // Submix buses.
+        IXAudio2SubmixVoice* __cdecl CreateBus(_In_z_ const char* name, _In_opt_z_ const char* parent = nullptr,
+            _In_opt_ const XAUDIO2_EFFECT_CHAIN* effects = nullptr);
+            // Creates a named submix voice in the mastering format that outputs to parent (the mastering voice if null)
+            // The effects are kept referenced so the bus can be rebuilt by Reset; returns null in 'silent mode'
+
+        IXAudio2SubmixVoice* __cdecl GetBus(_In_z_ const char* name) const noexcept;
+
+        void __cdecl SetBusVolume(_In_z_ const char* name, float volume);
+
+        void __cdecl SetBusSend(_In_z_ const char* name, _In_opt_z_ const char* target, float level);
+            // Sets the level of an extra send to target (or the mastering voice if null); a level of 0 removes the send
+            // Buses can only send to buses nearer the mastering voice than themselves
+
+        void __cdecl DestroyBus(_In_z_ const char* name);
+            // Idle and playing one-shots move back to the mastering voice; instances using the bus must be moved first
+
+        void __cdecl Apply3D(const AudioListener& listener,
+            _In_reads_(count) SoundEffectInstance* const* instances, _In_reads_(count) const AudioEmitter* emitters, size_t count,
+            bool rhcoords = true);
+            // Positions many 3D instances against one listener, with emitters[i] applied to instances[i] (null instances are skipped)
+            // Emitters past the end of a volume curve that falls to silence are muted without running X3DAudioCalculate
+            // All of the voice changes take effect together in the same audio frame
+
         AudioStatistics __cdecl GetStatistics() const;
             // Gathers audio engine statistics
 
+        AudioPerformanceData __cdecl GetPerformanceData() const noexcept;
+            // Returns the performance data recorded by the last Update
+
+        void __cdecl SetPerformanceHistory(size_t frames);
+            // Keeps the performance data of the last few updates (defaults to 0 for only the latest)
+
+        size_t __cdecl GetPerformanceHistory(_Out_writes_(count) AudioPerformanceData* frames, size_t count) const noexcept;
+            // Copies up to count of the most recent updates, oldest first, and returns how many were copied
+
         WAVEFORMATEXTENSIBLE __cdecl GetOutputFormat() const noexcept;
             // Returns the format consumed by the mastering voice (which is the same as the device output if defaults are used)
 
@@ -251,19 +367,38 @@ namespace DirectX
         void __cdecl SetMaxVoicePool(size_t maxOneShots, size_t maxInstances);
             // Maximum number of voices to allocate for one-shots and instances
             // Note: one-shots over this limit are ignored; too many instance voices throws an exception
+            //       except for SoundEffectInstance_Virtual instances, which share what's left by audibility
 
         void __cdecl TrimVoicePool();
             // Releases any currently unused voices
 
+        void __cdecl ReserveVoices(_In_ const WAVEFORMATEX* wfx, size_t count);
+            // Creates idle one-shot voices until the pool holds at least count for this format, so the first plays don't create them
+            // Note: does nothing for formats that can't be reused, or with AudioEngine_DisableVoiceReuse
+
         // Internal-use functions
-        void __cdecl AllocateVoice(_In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice);
+        void __cdecl AllocateVoice(_In_ const WAVEFORMATEX* wfx, SOUND_EFFECT_INSTANCE_FLAGS flags, bool oneshot, _Outptr_result_maybenull_ IXAudio2SourceVoice** voice,
+            _In_opt_ IXAudio2Voice* output = nullptr);
+            // Output is the submix bus to send to, instead of the mastering voice
 
         void __cdecl DestroyVoice(_In_ IXAudio2SourceVoice* voice);
             // Should only be called for instance voices, not one-shots
 
+        void __cdecl ReleaseOneShot(_In_ IXAudio2SourceVoice* voice);
+            // Returns a one-shot voice from AllocateVoice that could not be started, so it is reused rather than leaked
+
         void __cdecl RegisterNotify(_In_ IVoiceNotify* notify, bool usesUpdate);
         void __cdecl UnregisterNotify(_In_ IVoiceNotify* notify, bool usesOneShots, bool usesUpdate);
 
+        void __cdecl RegisterVirtual(_In_ IVirtualVoice* instance);
+        void __cdecl UnregisterVirtual(_In_ IVirtualVoice* instance);
+
+        void __cdecl UpdateVirtualVoices();
+            // Ranks the virtual instances, giving voices to the most audible and taking them from the rest (called by Update)
+
+        void __cdecl ReportStreamStall() noexcept;
+            // Counts a streaming voice running out of data; may be called from any thread
+
         // XAudio2 interface access
         IXAudio2* __cdecl GetInterface() const noexcept;
         IXAudio2MasteringVoice* __cdecl GetMasterVoice() const noexcept;
@@ -291,7 +426,7 @@ namespace DirectX
     class WaveBank
     {
     public:
-        WaveBank(_In_ AudioEngine* engine, _In_z_ const wchar_t* wbFileName);
+        WaveBank(_In_ AudioEngine* engine, _In_z_ const wchar_t* wbFileName, WAVE_BANK_FLAGS flags = WaveBank_Default);
 
         WaveBank(WaveBank&& moveFrom) noexcept;
         WaveBank& operator= (WaveBank&& moveFrom) noexcept;
@@ -310,10 +445,20 @@ namespace DirectX
         std::unique_ptr<SoundEffectInstance> __cdecl CreateInstance(unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
         std::unique_ptr<SoundEffectInstance> __cdecl CreateInstance(_In_z_ const char* name, SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
 
+        // Streaming wave banks play through SoundStreamInstances, which read the wave data from disk as it plays.
+        std::unique_ptr<SoundStreamInstance> __cdecl CreateStreamInstance(unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
+        std::unique_ptr<SoundStreamInstance> __cdecl CreateStreamInstance(_In_z_ const char* name, SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
+
         bool __cdecl IsPrepared() const noexcept;
         bool __cdecl IsInUse() const noexcept;
         bool __cdecl IsStreamingBank() const noexcept;
 
+        void __cdecl SetOutputBus(_In_opt_z_ const char* name);
+        // Sends one-shots, and the instances created from now on, to the named AudioEngine submix bus (null for the mastering voice)
+
+        void __cdecl ReserveVoices(size_t count = 1);
+        // Reserves count idle one-shot voices for each format used in an in-memory bank (see AudioEngine::ReserveVoices)
+
         size_t __cdecl GetSampleSizeInBytes(unsigned int index) const noexcept;
         // Returns size of wave audio data
 
@@ -341,8 +486,13 @@ namespace DirectX
 
         // Private interface
         void __cdecl UnregisterInstance(_In_ SoundEffectInstance* instance);
+        void __cdecl UnregisterInstance(_In_ SoundStreamInstance* instance);
+
+        HANDLE __cdecl GetAsyncHandle() const noexcept;
+        bool __cdecl GetPrivateData(unsigned int index, _Out_writes_bytes_(datasize) void* data, size_t datasize);
 
         friend class SoundEffectInstance;
+        friend class SoundStreamInstance;
     };
 
 
@@ -612,8 +762,17 @@ namespace DirectX
 
         void __cdecl Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords = true);
 
+        void __cdecl SetOutputBus(_In_opt_z_ const char* name);
+            // Plays through the named AudioEngine submix bus, or the mastering voice for null
+
+        void __cdecl SetPriority(float priority);
+            // Weights the instance's volume and 3D attenuation when ranking SoundEffectInstance_Virtual instances (defaults to 1)
+
         bool __cdecl IsLooped() const noexcept;
 
+        bool __cdecl IsVirtual() const noexcept;
+            // Returns true if the instance is playing without a voice
+
         SoundState __cdecl GetState() noexcept;
 
         // Notifications.
@@ -625,6 +784,11 @@ namespace DirectX
 
         std::unique_ptr<Impl> pImpl;
 
+        // Used by AudioEngine::Apply3D
+        void __cdecl Apply3D(const X3DAUDIO_LISTENER& lhListener, const AudioEmitter& emitter, bool rhcoords, bool audible, uint32_t operationSet);
+
+        friend class AudioEngine;
+
         // Private constructors
         SoundEffectInstance(_In_ AudioEngine* engine, _In_ SoundEffect* effect, SOUND_EFFECT_INSTANCE_FLAGS flags);
         SoundEffectInstance(_In_ AudioEngine* engine, _In_ WaveBank* effect, unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags);
@@ -634,6 +798,55 @@ namespace DirectX
     };
 
 
+    //----------------------------------------------------------------------------------
+    class SoundStreamInstance
+    {
+    public:
+        SoundStreamInstance(_In_ AudioEngine* engine, _In_z_ const wchar_t* wavFileName, SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
+            // Streams a .wav file from disk, keeping only its chunk index and a few small buffers in memory
+            // Loops use the file's loop region (if any) for PCM and ADPCM, and the whole wave otherwise
+
+        SoundStreamInstance(SoundStreamInstance&& moveFrom) noexcept;
+        SoundStreamInstance& operator= (SoundStreamInstance&& moveFrom) noexcept;
+
+        SoundStreamInstance(SoundStreamInstance const&) = delete;
+        SoundStreamInstance& operator= (SoundStreamInstance const&) = delete;
+
+        virtual ~SoundStreamInstance();
+
+        void __cdecl Play(bool loop = false);
+        void __cdecl Stop(bool immediate = true) noexcept;
+        void __cdecl Pause() noexcept;
+        void __cdecl Resume();
+
+        void __cdecl SetVolume(float volume);
+        void __cdecl SetPitch(float pitch);
+        void __cdecl SetPan(float pan);
+
+        void __cdecl Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords = true);
+
+        void __cdecl SetOutputBus(_In_opt_z_ const char* name);
+
+        bool __cdecl IsLooped() const noexcept;
+
+        SoundState __cdecl GetState() noexcept;
+
+        // Notifications.
+        void __cdecl OnDestroyParent() noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+
+        // Private constructors
+        SoundStreamInstance(_In_ AudioEngine* engine, _In_ WaveBank* waveBank, unsigned int index, SOUND_EFFECT_INSTANCE_FLAGS flags);
+
+        friend std::unique_ptr<SoundStreamInstance> __cdecl WaveBank::CreateStreamInstance(unsigned int, SOUND_EFFECT_INSTANCE_FLAGS);
+    };
+
+
     //----------------------------------------------------------------------------------
     class DynamicSoundEffectInstance
     {
@@ -642,6 +855,11 @@ namespace DirectX
             _In_opt_ std::function<void __cdecl(DynamicSoundEffectInstance*)> bufferNeeded,
             int sampleRate, int channels, int sampleBits = 16,
             SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
+        DynamicSoundEffectInstance(_In_ AudioEngine* engine,
+            int sampleRate, int channels, int sampleBits, size_t ringBufferBytes, size_t ringBufferCount,
+            SOUND_EFFECT_INSTANCE_FLAGS flags = SoundEffectInstance_Default);
+            // Ring-buffer mode: audio from WriteRingBuffer is cut into ringBufferCount buffers of ringBufferBytes each, which
+            // XAudio2's buffer-end callback queues to the voice directly, so latency is set by the buffer size and not by Update
         DynamicSoundEffectInstance(DynamicSoundEffectInstance&& moveFrom) noexcept;
         DynamicSoundEffectInstance& operator= (DynamicSoundEffectInstance&& moveFrom) noexcept;
 
@@ -661,9 +879,15 @@ namespace DirectX
 
         void __cdecl Apply3D(const AudioListener& listener, const AudioEmitter& emitter, bool rhcoords = true);
 
+        void __cdecl SetOutputBus(_In_opt_z_ const char* name);
+
         void __cdecl SubmitBuffer(_In_reads_bytes_(audioBytes) const uint8_t* pAudioData, size_t audioBytes);
         void __cdecl SubmitBuffer(_In_reads_bytes_(audioBytes) const uint8_t* pAudioData, uint32_t offset, size_t audioBytes);
 
+        size_t __cdecl WriteRingBuffer(_In_reads_bytes_(audioBytes) const uint8_t* pAudioData, size_t audioBytes);
+        // Copies as much as fits into the ring and returns the number of bytes taken
+        // May be called from any thread, but only from one thread at a time
+
         SoundState __cdecl GetState() noexcept;
 
         size_t __cdecl GetSampleDuration(size_t bytes) const noexcept;
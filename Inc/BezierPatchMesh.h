@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------------
+// File: BezierPatchMesh.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Effects.h"
+
+#include <memory>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    // Bicubic Bezier patches tessellated on the GPU. The control points are uploaded once and drawn as a 16 control
+    // point patch list; the hull shader sets each edge's tessellation factor from its distance to the camera, so
+    // detail follows the view without regenerating the mesh. Both patches on a shared edge pick the same factor, so
+    // adaptive tessellation does not open cracks.
+    //
+    // Shading is BasicEffect's per pixel lighting with a texture, which is white when none is set. Blend, depth,
+    // rasterizer, and sampler states are left to the caller, as with the other effects.
+    //
+    // Requires Feature Level 11.0. Apply binds hull and domain shaders, which the other effects do not clear; Draw
+    // unbinds them again when it is done.
+    class BezierPatchMesh : public IEffect, public IEffectMatrices, public IEffectLights
+    {
+    public:
+        // Each patch is 16 indices into controlPoints, in rows of four: u runs along a row and v from row to row, as
+        // in Bezier.h. Triangles are wound as Bezier::CreatePatchIndices winds an unmirrored patch.
+        BezierPatchMesh(_In_ ID3D11Device* device,
+            _In_reads_(controlPointCount) XMFLOAT3 const* controlPoints, size_t controlPointCount,
+            _In_reads_(patchCount * 16) uint32_t const* patchIndices, size_t patchCount);
+
+        BezierPatchMesh(BezierPatchMesh&& moveFrom) noexcept;
+        BezierPatchMesh& operator= (BezierPatchMesh&& moveFrom) noexcept;
+
+        BezierPatchMesh(BezierPatchMesh const&) = delete;
+        BezierPatchMesh& operator= (BezierPatchMesh const&) = delete;
+
+        virtual ~BezierPatchMesh() override;
+
+        // The teapot from GeometricPrimitive::CreateTeapot, as patches.
+        static std::unique_ptr<BezierPatchMesh> __cdecl CreateTeapot(_In_ ID3D11Device* device, float size = 1, bool rhcoords = true);
+
+        // IEffect methods. The input layout is VertexPosition; Draw binds its own.
+        void __cdecl Apply(_In_ ID3D11DeviceContext* deviceContext) override;
+
+        void __cdecl GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength) override;
+
+        // Camera settings.
+        void XM_CALLCONV SetWorld(FXMMATRIX value) override;
+        void XM_CALLCONV SetView(FXMMATRIX value) override;
+        void XM_CALLCONV SetProjection(FXMMATRIX value) override;
+        void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+
+        // Material settings.
+        void XM_CALLCONV SetDiffuseColor(FXMVECTOR value);
+        void __cdecl SetAlpha(float value);
+        void XM_CALLCONV SetColorAndAlpha(FXMVECTOR value);
+        void __cdecl SetTexture(_In_opt_ ID3D11ShaderResourceView* value);
+
+        // Light settings. Lighting is always per pixel.
+        void __cdecl SetLightingEnabled(bool value) override;
+        void __cdecl SetPerPixelLighting(bool value) override;
+        void XM_CALLCONV SetAmbientLightColor(FXMVECTOR value) override;
+
+        void __cdecl SetLightEnabled(int whichLight, bool value) override;
+        void XM_CALLCONV SetLightDirection(int whichLight, FXMVECTOR value) override;
+        void XM_CALLCONV SetLightDiffuseColor(int whichLight, FXMVECTOR value) override;
+        void XM_CALLCONV SetLightSpecularColor(int whichLight, FXMVECTOR value) override;
+
+        void __cdecl EnableDefaultLighting() override;
+
+        // Tessellation settings. Edges closer to the camera than nearDistance use nearFactor, edges beyond
+        // farDistance use farFactor, and those in between are interpolated. Factors are clamped to [1, 64].
+        void __cdecl SetTessellation(float nearDistance, float farDistance, float nearFactor = 64, float farFactor = 1);
+
+        // Applies the effect and draws every patch.
+        void __cdecl Draw(_In_ ID3D11DeviceContext* deviceContext);
+
+        size_t __cdecl GetPatchCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
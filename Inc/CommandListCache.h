@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------------
+// File: CommandListCache.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    // Records a static segment of drawing (Model::Draw, GeometricPrimitive::Draw, PostProcess::Process, and so on)
+    // into an ID3D11CommandList on a private deferred context, then replays it with ExecuteCommandList for as long
+    // as its dependencies stay the same.
+    //
+    // The dependencies are the inputs the recorded draws read when they are recorded: matrices, effect parameters,
+    // textures, and anything else the recording callback passes to DirectXTK. They are gathered afresh for each
+    // Execute and compared byte for byte with those of the last recording; any difference records the segment
+    // again. The render targets, depth stencil and viewports bound on the executing context are dependencies too,
+    // and are bound on the deferred context before each recording.
+    //
+    // Resources are compared by identity. The command list holds a reference to everything it binds, so a texture
+    // it draws with cannot be freed and another one created at the same address while the list is kept.
+    //
+    // Objects drawn in the segment should not also be drawn elsewhere with different settings: post-processes and
+    // primitives only upload their constants when they change, and a list that merely binds their constant buffer
+    // reads whatever was last written to it when it is executed. The built-in effects always upload their constants
+    // on a deferred context, so sharing them is fine.
+    //
+    // The executing context's state is restored after each replay. On Xbox One, DirectXTK writes constants to
+    // GraphicsMemory, which is recycled a few frames later, so the segment is recorded again on every Execute.
+    class CommandListCache
+    {
+    public:
+        explicit CommandListCache(_In_ ID3D11Device* device);
+
+        CommandListCache(CommandListCache&& moveFrom) noexcept;
+        CommandListCache& operator= (CommandListCache&& moveFrom) noexcept;
+
+        CommandListCache(CommandListCache const&) = delete;
+        CommandListCache& operator= (CommandListCache const&) = delete;
+
+        virtual ~CommandListCache();
+
+        // Inputs of one recording, compared byte for byte.
+        class Dependencies
+        {
+        public:
+            Dependencies() = default;
+
+            void __cdecl Add(_In_reads_bytes_(size) void const* data, size_t size);
+            void XM_CALLCONV Add(FXMMATRIX value);
+            void XM_CALLCONV Add(FXMVECTOR value);
+            void __cdecl Add(float value);
+            void __cdecl Add(uint32_t value);
+            void __cdecl Add(_In_opt_ ID3D11DeviceChild* resource);
+
+            void __cdecl Clear() noexcept { mData.clear(); }
+
+        private:
+            friend class CommandListCache;
+
+            std::vector<uint8_t> mData;
+        };
+
+        // Replays the cached command list on deviceContext, first recording it by calling record with the deferred
+        // context if there is none yet or any dependency changed. record must do all of its drawing on the context
+        // it is given.
+        void __cdecl Execute(_In_ ID3D11DeviceContext* deviceContext, Dependencies const& dependencies,
+                             std::function<void __cdecl(_In_ ID3D11DeviceContext* deferredContext)> record);
+
+        // Drops the cached list, so the next Execute records again.
+        void __cdecl Invalidate() noexcept;
+
+        // Number of times the segment has been recorded, and replayed without recording.
+        uint64_t __cdecl GetRecordCount() const noexcept;
+        uint64_t __cdecl GetReplayCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
@@ -57,6 +57,14 @@ namespace DirectX
         ID3D11SamplerState* __cdecl AnisotropicWrap() const;
         ID3D11SamplerState* __cdecl AnisotropicClamp() const;
 
+        // Custom states. Each distinct description is created once per device and then shared by every caller,
+        // including the built-in states above when their descriptions match. The objects live as long as the
+        // device's CommonStates; looking up one that already exists takes no lock.
+        ID3D11BlendState* __cdecl GetBlendState(const D3D11_BLEND_DESC& desc) const;
+        ID3D11DepthStencilState* __cdecl GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc) const;
+        ID3D11RasterizerState* __cdecl GetRasterizerState(const D3D11_RASTERIZER_DESC& desc) const;
+        ID3D11SamplerState* __cdecl GetSamplerState(const D3D11_SAMPLER_DESC& desc) const;
+
     private:
         // Private implementation.
         class Impl;
@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------------
+// File: ComputeSkinning.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <functional>
+#include <memory>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    class IEffect;
+    class Model;
+
+    // Skins models once per frame with a compute shader, instead of in the vertex shader of every draw. The skinned
+    // vertices are written to a vertex buffer owned by this object, so the shadow, depth prepass, and main passes all
+    // draw them as static geometry with the non-skinned effects (BasicEffect, NormalMapEffect, and so on).
+    //
+    // Register moves a model's skinned mesh parts over to that buffer once, after loading. Each frame, Skin queues a
+    // model with its bone palette, and Dispatch uploads every queued palette into one structured buffer and skins all
+    // the queued models with a single dispatch. Models not queued keep the last pose written for them.
+    //
+    // Handles the VertexPositionNormalTangentColorTextureSkinning layout used by the CMO loader; other parts are left
+    // alone. A registered model must stay alive, and be drawn only while this object is.
+    //
+    // Requires Feature Level 11.0. Register and Dispatch use the device context, so call them from the thread that owns it.
+    class ComputeSkinning
+    {
+    public:
+        // maxVertices is shared by all the registered models, and maxBones by all the palettes queued for a dispatch.
+        ComputeSkinning(_In_ ID3D11Device* device, size_t maxVertices, size_t maxBones = 4096);
+
+        ComputeSkinning(ComputeSkinning&& moveFrom) noexcept;
+        ComputeSkinning& operator= (ComputeSkinning&& moveFrom) noexcept;
+
+        ComputeSkinning(ComputeSkinning const&) = delete;
+        ComputeSkinning& operator= (ComputeSkinning const&) = delete;
+
+        virtual ~ComputeSkinning();
+
+        // Copies the model's skinned vertices into this object and points its skinned parts at the output buffer. Each
+        // of those parts gets the effect returned by createEffect for its old one, which must not need blend weights;
+        // the input layouts are rebuilt and Model::Modified is called.
+        void __cdecl Register(_In_ ID3D11DeviceContext* deviceContext, Model& model,
+            _In_ std::function<std::shared_ptr<IEffect> __cdecl(const std::shared_ptr<IEffect>& skinnedEffect)> createEffect);
+
+        // Queues a registered model for the next Dispatch. Bone transforms are in model space, as for Model::DrawSkinned.
+        void __cdecl Skin(const Model& model, size_t nbones, _In_reads_(nbones) const XMMATRIX* boneTransforms);
+
+        // Skins every model queued since the last Dispatch. Call before the passes that draw them.
+        void __cdecl Dispatch(_In_ ID3D11DeviceContext* deviceContext);
+
+        // Forgets every registered model, freeing their vertex space. Those models must not be drawn again.
+        void __cdecl Reset() noexcept;
+
+        size_t __cdecl GetMaxVertices() const noexcept;
+        size_t __cdecl GetUsedVertices() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
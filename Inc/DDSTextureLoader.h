@@ -7,6 +7,9 @@
 // a full-featured DDS file reader, writer, and texture processing pipeline see
 // the 'Texconv' sample and the 'DirectXTex' library.
 //
+// The auto-gen mipmap versions accept a deferred context, in which case the upload and
+// GenerateMips are only recorded, and run when its command list is executed.
+//
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 //
@@ -151,4 +154,29 @@ namespace DirectX
         _Outptr_opt_ ID3D11Resource** texture,
         _Outptr_opt_ ID3D11ShaderResourceView** textureView,
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr) noexcept;
+
+    // Batch versions, which parse and create many textures in parallel on the system thread pool.
+    // Textures are created immutable with only the shader resource bind flag, so no context is
+    // needed. Each entry of the optional output arrays receives its own texture, view, alpha mode
+    // and HRESULT; the return value is S_OK or the failure of the lowest-indexed texture.
+    HRESULT __cdecl CreateDDSTexturesFromMemory(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ size_t count,
+        _In_reads_(count) const uint8_t* const* ddsData,
+        _In_reads_(count) const size_t* ddsDataSize,
+        _Out_writes_opt_(count) ID3D11Resource** textures,
+        _Out_writes_opt_(count) ID3D11ShaderResourceView** textureViews,
+        _Out_writes_opt_(count) HRESULT* results = nullptr,
+        _In_ size_t maxsize = 0,
+        _Out_writes_opt_(count) DDS_ALPHA_MODE* alphaModes = nullptr) noexcept;
+
+    HRESULT __cdecl CreateDDSTexturesFromFile(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ size_t count,
+        _In_reads_(count) const wchar_t* const* szFileNames,
+        _Out_writes_opt_(count) ID3D11Resource** textures,
+        _Out_writes_opt_(count) ID3D11ShaderResourceView** textureViews,
+        _Out_writes_opt_(count) HRESULT* results = nullptr,
+        _In_ size_t maxsize = 0,
+        _Out_writes_opt_(count) DDS_ALPHA_MODE* alphaModes = nullptr) noexcept;
 }
@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureStreamer.h
+//
+// Streams the mip levels of large DDS textures in and out against a video memory budget
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <memory>
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Streaming DDS textures start out with just their low mip tail resident: the levels no larger than
+    // initialMaxSize, picked the same way as the maxsize parameter of CreateDDSTextureFromFile. Callers then ask for
+    // more detail per texture with SetRequestedMip, and Update promotes textures within the budget by reallocating
+    // them with the extra levels and reading those levels with overlapped I/O. Each level becomes visible as soon as
+    // its read completes, through SetResourceMinLOD. Requests for less detail shrink the texture again.
+    //
+    // Only 2D textures, texture arrays, and cubemaps are supported. All methods must be called from one thread, and
+    // Update needs a context that may create and copy resources, normally the immediate context.
+    class DDSTextureStreamer
+    {
+    public:
+        typedef uint32_t TextureId;
+
+        DDSTextureStreamer(_In_ ID3D11Device* device, size_t budgetInBytes);
+
+        DDSTextureStreamer(DDSTextureStreamer&& moveFrom) noexcept;
+        DDSTextureStreamer& operator= (DDSTextureStreamer&& moveFrom) noexcept;
+
+        DDSTextureStreamer(DDSTextureStreamer const&) = delete;
+        DDSTextureStreamer& operator= (DDSTextureStreamer const&) = delete;
+
+        virtual ~DDSTextureStreamer();
+
+        // Opens a DDS file and loads its mip tail synchronously. The file stays open for later reads.
+        TextureId __cdecl Load(_In_z_ const wchar_t* fileName, size_t initialMaxSize = 256, bool forceSRGB = false);
+
+        // Releases the texture, cancelling any reads in flight.
+        void __cdecl Unload(TextureId id);
+
+        // The view changes whenever the texture is reallocated, so fetch it again after each Update.
+        ID3D11ShaderResourceView* __cdecl GetShaderResourceView(TextureId id) const;
+
+        // Most detailed mip level wanted (0 is the full size image). Levels beyond the initial mip tail are clamped.
+        void __cdecl SetRequestedMip(TextureId id, unsigned int mip);
+
+        // Most detailed mip level whose data is on the GPU.
+        unsigned int __cdecl GetResidentMip(TextureId id) const;
+
+        // Completes finished reads, shrinks textures that want less detail, then grows the textures furthest from
+        // their requested level first, as far as the budget allows.
+        void __cdecl Update(_In_ ID3D11DeviceContext* deviceContext);
+
+        void __cdecl SetBudget(size_t budgetInBytes) noexcept;
+        size_t __cdecl GetBudget() const noexcept;
+
+        // Video memory allocated by all streaming textures, including levels still being read.
+        size_t __cdecl GetAllocatedBytes() const noexcept;
+
+        // Number of subresource reads in flight.
+        size_t __cdecl GetPendingReadCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
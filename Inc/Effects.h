@@ -16,7 +16,11 @@
 #endif
 
 #include <DirectXMath.h>
+#include <functional>
+#include <future>
 #include <memory>
+#include <stdint.h>
+#include <vector>
 
 
 namespace DirectX
@@ -43,6 +47,79 @@ namespace DirectX
     };
 
 
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    // Opt-in for the built-in effects to write their constants into the shared GraphicsMemory upload ring and bind
+    // them with VSSetConstantBuffers1/PSSetConstantBuffers1 offsets, rather than mapping a private constant buffer
+    // with WRITE_DISCARD whenever they change. Each effect falls back to its private buffer if no GraphicsMemory
+    // instance exists, the device lacks constant buffer offsetting, or the context is not an ID3D11DeviceContext1.
+    void __cdecl SetEffectConstantSuballocation(bool enable) noexcept;
+    bool __cdecl GetEffectConstantSuballocation() noexcept;
+#endif
+
+
+    // Opt-in for the built-in effects to remember the shaders and slot 0 constant buffer they last bound on each
+    // device context, shared by all effect types, so Apply skips VSSetShader, PSSetShader, and *SetConstantBuffers
+    // calls that would not change anything. Code which binds shaders or constant buffers itself, or calls ClearState,
+    // FinishCommandList, or ExecuteCommandList, must call InvalidateEffectStateCache for that context before the next
+    // effect Apply. Passing a null context invalidates every context. Draw methods that take a setCustomState hook
+    // invalidate the context after calling it.
+    void __cdecl SetEffectStateCaching(bool enable) noexcept;
+    bool __cdecl GetEffectStateCaching() noexcept;
+    void __cdecl InvalidateEffectStateCache(_In_opt_ ID3D11DeviceContext* deviceContext) noexcept;
+
+
+    // Built-in effect types, for reporting statistics.
+    enum BuiltInEffect : unsigned int
+    {
+        BuiltInEffect_AlphaTest,
+        BuiltInEffect_Basic,
+        BuiltInEffect_Debug,
+        BuiltInEffect_DGSL,
+        BuiltInEffect_DualTexture,
+        BuiltInEffect_EnvironmentMap,
+        BuiltInEffect_NormalMap,
+        BuiltInEffect_PBR,
+        BuiltInEffect_Skinned,
+
+        BuiltInEffect_Count
+    };
+
+    // Counters for one built-in effect type, summed over every device and effect instance. The redundant skips
+    // count bindings dropped by SetEffectStateCaching, and constant buffer updates count each write of constants
+    // to the GPU, whether into a private buffer or the suballocation ring. DGSLEffect permutations are numbered
+    // as vertex shader permutation * 12 + pixel shader permutation.
+    struct EffectStatistics
+    {
+        static const size_t MaxPermutations = 96;
+
+        uint64_t vertexShadersCreated;
+        uint64_t pixelShadersCreated;
+        uint64_t applyCount;
+        uint64_t constantBufferUpdates;
+        uint64_t redundantShaderSkips;
+        uint64_t redundantConstantBufferSkips;
+        uint64_t permutationApplyCounts[MaxPermutations];
+    };
+
+    // Opt-in for the built-in effects to count shader creation, Apply calls, and constant buffer traffic, so an
+    // application can see which permutations it uses and where its Apply costs go. The counters keep running until
+    // ResetEffectStatistics, which can be called once per frame for per-frame numbers. DumpEffectStatistics writes
+    // every effect type that has been used to the debugger output in debug builds.
+    void __cdecl SetEffectStatisticsCollection(bool enable) noexcept;
+    bool __cdecl GetEffectStatisticsCollection() noexcept;
+    void __cdecl GetEffectStatistics(BuiltInEffect effect, _Out_ EffectStatistics* stats) noexcept;
+    void __cdecl ResetEffectStatistics() noexcept;
+    void __cdecl DumpEffectStatistics() noexcept;
+
+
+#if defined(DIRECTX_TOOLKIT_SHADER_PACK)
+    // Libraries built with DIRECTX_TOOLKIT_SHADER_PACK leave the built-in effect shaders out of the binary, and read
+    // them from a pack file made by the shaderpack tool instead. Call once at startup, before creating any effect.
+    // The file is memory mapped for the life of the process, so only the shaders actually created are paged in.
+    HRESULT __cdecl LoadEffectShaderPack(_In_z_ const wchar_t* fileName) noexcept;
+#endif
+
+
     // Abstract interface for effects with world, view, and projection matrices.
     class IEffectMatrices
     {
@@ -139,9 +216,322 @@ namespace DirectX
         IEffectSkinning() = default;
     };
 
+
+    //----------------------------------------------------------------------------------
+    // Abstract interface for effects with hardware instancing support. The instanced shaders read a
+    // per-instance transform from vertex buffer slot 1 as three float4 rows of an XMFLOAT3X4 (semantic
+    // InstMatrix, indices 0-2), which is applied ahead of the effect's world matrix.
+    class IEffectInstancing
+    {
+    public:
+        virtual ~IEffectInstancing() = default;
+
+        IEffectInstancing(const IEffectInstancing&) = delete;
+        IEffectInstancing& operator=(const IEffectInstancing&) = delete;
+
+        IEffectInstancing(IEffectInstancing&&) = delete;
+        IEffectInstancing& operator=(IEffectInstancing&&) = delete;
+
+        virtual void __cdecl SetInstancingEnabled(bool value) = 0;
+
+    protected:
+        IEffectInstancing() = default;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Passes an effect can be switched to, in place of its full shading.
+    enum EffectPass : unsigned int
+    {
+        EffectPass_Default = 0,     // Normal shading
+        EffectPass_DepthOnly,       // Clip-space position only, with no pixel shader bound (depth prepass, shadows)
+        EffectPass_VelocityOnly,    // Writes packed motion vectors to render target 0
+    };
+
+    // Abstract interface for effects with reduced depth-only and velocity-only passes. The reduced passes keep
+    // the effect's vertex input and instancing settings, so the same input layout works for all passes.
+    class IEffectPass
+    {
+    public:
+        virtual ~IEffectPass() = default;
+
+        IEffectPass(const IEffectPass&) = delete;
+        IEffectPass& operator=(const IEffectPass&) = delete;
+
+        IEffectPass(IEffectPass&&) = delete;
+        IEffectPass& operator=(IEffectPass&&) = delete;
+
+        virtual void __cdecl SetPass(EffectPass pass) = 0;
+        virtual EffectPass __cdecl GetPass() const noexcept = 0;
+
+    protected:
+        IEffectPass() = default;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Point or spot light for ClusteredLights, in world space. Intensity falls smoothly to zero at range.
+    struct ClusteredLight
+    {
+        XMFLOAT3 position;
+        float    range;
+        XMFLOAT3 color;
+        float    spotCosOuter;
+        XMFLOAT3 direction;
+        float    spotCosInner;
+
+        static ClusteredLight XM_CALLCONV CreatePoint(FXMVECTOR position, float range, FXMVECTOR color) noexcept
+        {
+            ClusteredLight light = {};
+            XMStoreFloat3(&light.position, position);
+            light.range = range;
+            XMStoreFloat3(&light.color, color);
+            light.spotCosOuter = -2.f;
+            light.direction = XMFLOAT3(0.f, 0.f, 1.f);
+            light.spotCosInner = -1.f;
+            return light;
+        }
+
+        // Angles are half-angles of the cone, in radians; the light fades between the inner and outer cones.
+        static ClusteredLight XM_CALLCONV CreateSpot(FXMVECTOR position, FXMVECTOR direction, float range, GXMVECTOR color,
+                                                     float innerAngle, float outerAngle) noexcept
+        {
+            ClusteredLight light = {};
+            XMStoreFloat3(&light.position, position);
+            light.range = range;
+            XMStoreFloat3(&light.color, color);
+            light.spotCosOuter = XMScalarCos(outerAngle);
+            XMStoreFloat3(&light.direction, XMVector3Normalize(direction));
+            light.spotCosInner = XMScalarCos(innerAngle);
+            return light;
+        }
+    };
+
+
+    // Bins point and spot lights into a grid of view-space clusters with a compute shader, so the clustered
+    // permutations of BasicEffect, NormalMapEffect, and PBREffect can shade each pixel with just the lights that
+    // reach its cluster, in one pass. The grid is 16 x 9 screen tiles by 24 slices spaced exponentially in depth,
+    // and each cluster keeps at most MaxLightsPerCluster lights.
+    //
+    // Call Update once per view, after SetLights and before drawing with effects that use it. Requires Feature Level 11.0.
+    class ClusteredLights
+    {
+    public:
+        ClusteredLights(_In_ ID3D11Device* device, size_t maxLights = 1024);
+
+        ClusteredLights(ClusteredLights&& moveFrom) noexcept;
+        ClusteredLights& operator= (ClusteredLights&& moveFrom) noexcept;
+
+        ClusteredLights(ClusteredLights const&) = delete;
+        ClusteredLights& operator= (ClusteredLights const&) = delete;
+
+        virtual ~ClusteredLights();
+
+        // Replaces the light list. The GPU copy is not touched until Update.
+        void __cdecl SetLights(_In_reads_(count) const ClusteredLight* lights, size_t count);
+
+        // Rebuilds the clusters for a view. nearZ and farZ bound the slices (pixels beyond farZ share the last one),
+        // and width and height are the viewport size in pixels. Lights are tested against the clusters in view space.
+        void XM_CALLCONV Update(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection,
+                                float nearZ, float farZ, int width, int height);
+
+        // Binds the clusters for the clustered pixel shaders (constant buffer b1, shader resources t8 to t10).
+        // Called by the effects' Apply.
+        void __cdecl Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+        size_t __cdecl GetLightCount() const noexcept;
+        size_t __cdecl GetMaxLights() const noexcept;
+
+        static const size_t MaxLightsPerCluster = 128;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    // Abstract interface for effects that can add the clustered point and spot lights of a ClusteredLights to their
+    // directional lights. The clustered permutations always light per pixel. The ClusteredLights must outlive the
+    // effect, or be cleared from it with nullptr.
+    class IEffectClusteredLights
+    {
+    public:
+        virtual ~IEffectClusteredLights() = default;
+
+        IEffectClusteredLights(const IEffectClusteredLights&) = delete;
+        IEffectClusteredLights& operator=(const IEffectClusteredLights&) = delete;
+
+        IEffectClusteredLights(IEffectClusteredLights&&) = delete;
+        IEffectClusteredLights& operator=(IEffectClusteredLights&&) = delete;
+
+        virtual void __cdecl SetClusteredLights(_In_opt_ ClusteredLights* value) = 0;
+
+    protected:
+        IEffectClusteredLights() = default;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    class CommonStates;
+    class Model;
+
+    // Cascaded shadow map for one directional light, for the shadowed permutations of BasicEffect, NormalMapEffect,
+    // and PBREffect. Update fits up to MaxCascades cascades to slices of the camera's view frustum; each cascade
+    // covers the bounding sphere of its slice, snapped to whole texels, so the shadows don't shimmer as the camera
+    // moves. The cascades are slices of one depth texture array, filtered with 4x4 PCF when read.
+    //
+    // Each frame: Update, then Render with a callback that draws the shadow casters (DrawModel draws a Model with
+    // its depth-only pass), then draw the scene with effects that use it. Requires Feature Level 10.0 to render,
+    // and Feature Level 11.0 for the effects to receive the shadows.
+    class CascadedShadowMap
+    {
+    public:
+        CascadedShadowMap(_In_ ID3D11Device* device, int resolution = 2048, size_t cascadeCount = 4);
+
+        CascadedShadowMap(CascadedShadowMap&& moveFrom) noexcept;
+        CascadedShadowMap& operator= (CascadedShadowMap&& moveFrom) noexcept;
+
+        CascadedShadowMap(CascadedShadowMap const&) = delete;
+        CascadedShadowMap& operator= (CascadedShadowMap const&) = delete;
+
+        virtual ~CascadedShadowMap();
+
+        // Fits the cascades to the camera's view between nearZ and farZ, for a light shining along lightDirection
+        // (the direction given to the effects' light 0). splitLambda blends the split distances between uniform (0)
+        // and logarithmic (1). Writes the constants the effects read.
+        void XM_CALLCONV Update(_In_ ID3D11DeviceContext* deviceContext, FXMVECTOR lightDirection, CXMMATRIX view, CXMMATRIX projection,
+                                float nearZ, float farZ, float splitLambda = 0.75f);
+
+        // Clears and renders every cascade. The viewport and the sloped-bias, depth-clamped rasterizer state are set
+        // once, and only the depth stencil view changes between cascades; drawCasters is called once per cascade.
+        // Leaves no render targets bound.
+        void __cdecl Render(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl(size_t cascade)> drawCasters);
+
+        // Draws the opaque parts of a model into the cascade being rendered, with Model::DrawPass and
+        // EffectPass_DepthOnly. Only valid inside the Render callback.
+        void XM_CALLCONV DrawModel(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const Model& model,
+                                   FXMMATRIX world) const;
+
+        // Binds the shadow map for the shadowed pixel shaders (constant buffer b2, shader resource t11, sampler s2).
+        // Called by the effects' Apply; does nothing while Render is drawing the casters.
+        void __cdecl Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+        // Depth bias subtracted by the receivers before comparing, in light-space depth. Takes effect at the next Update.
+        void __cdecl SetDepthBias(float value) noexcept;
+
+        // Shared light view and per-cascade projection, as of the last Update.
+        XMMATRIX __cdecl GetLightView() const noexcept;
+        XMMATRIX __cdecl GetCascadeProjection(size_t cascade) const;
+
+        // View distance at which a cascade ends, as of the last Update.
+        float __cdecl GetCascadeSplit(size_t cascade) const;
+
+        size_t __cdecl GetCascadeCount() const noexcept;
+        int __cdecl GetResolution() const noexcept;
+
+        ID3D11ShaderResourceView* __cdecl GetShaderResourceView() const noexcept;
+
+        static const size_t MaxCascades = 4;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    // Abstract interface for effects that can attenuate their first directional light with a CascadedShadowMap.
+    // The shadowed permutations always light per pixel. The CascadedShadowMap must outlive the effect, or be cleared
+    // from it with nullptr.
+    class IEffectShadows
+    {
+    public:
+        virtual ~IEffectShadows() = default;
+
+        IEffectShadows(const IEffectShadows&) = delete;
+        IEffectShadows& operator=(const IEffectShadows&) = delete;
+
+        IEffectShadows(IEffectShadows&&) = delete;
+        IEffectShadows& operator=(IEffectShadows&&) = delete;
+
+        virtual void __cdecl SetShadowMap(_In_opt_ CascadedShadowMap* value) = 0;
+
+    protected:
+        IEffectShadows() = default;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Camera views for drawing up to MaxViews split-screen viewports in one instanced draw, for the multi-view
+    // permutations of BasicEffect. Instance i of each draw is sent to view i: its view and projection are placed in
+    // the view's rectangle of the full render target viewport, and the other views are clipped away with clip
+    // distances, so the full viewport stays bound for the whole batch. Requires Feature Level 10.0.
+    class MultiView
+    {
+    public:
+        explicit MultiView(_In_ ID3D11Device* device);
+
+        MultiView(MultiView&& moveFrom) noexcept;
+        MultiView& operator= (MultiView&& moveFrom) noexcept;
+
+        MultiView(MultiView const&) = delete;
+        MultiView& operator= (MultiView const&) = delete;
+
+        virtual ~MultiView();
+
+        // Sets the camera and viewport (in the same pixel space as targetViewport) of each view, and writes the
+        // constants the effects read. targetViewport is the viewport bound while drawing, and must contain all of the views.
+        void __cdecl SetViews(_In_ ID3D11DeviceContext* deviceContext, size_t count,
+                              _In_reads_(count) const XMMATRIX* views,
+                              _In_reads_(count) const XMMATRIX* projections,
+                              _In_reads_(count) const D3D11_VIEWPORT* viewports,
+                              const D3D11_VIEWPORT& targetViewport);
+
+        size_t __cdecl GetViewCount() const noexcept;
+        XMMATRIX __cdecl GetView(size_t index) const;
+        XMMATRIX __cdecl GetProjection(size_t index) const;
+
+        // Binds the per-view constants for the multi-view vertex shaders (constant buffer b3). Called by the effects' Apply.
+        void __cdecl Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+        static const size_t MaxViews = 4;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    // Abstract interface for effects that can draw each instance into one of the views of a MultiView (see
+    // Model::DrawMultiView). Lighting, fog, and the world matrix come from the usual effect settings; the eye position
+    // for specular and fog is taken from the effect's own view. The MultiView must outlive the effect, or be cleared
+    // from it with nullptr.
+    class IEffectMultiView
+    {
+    public:
+        virtual ~IEffectMultiView() = default;
+
+        IEffectMultiView(const IEffectMultiView&) = delete;
+        IEffectMultiView& operator=(const IEffectMultiView&) = delete;
+
+        IEffectMultiView(IEffectMultiView&&) = delete;
+        IEffectMultiView& operator=(IEffectMultiView&&) = delete;
+
+        virtual void __cdecl SetMultiView(_In_opt_ MultiView* value) = 0;
+
+    protected:
+        IEffectMultiView() = default;
+    };
+
     //----------------------------------------------------------------------------------
     // Built-in shader supports optional texture mapping, vertex coloring, directional lighting, and fog.
-    class BasicEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectFog
+    class BasicEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectFog, public IEffectInstancing, public IEffectClusteredLights,
+                        public IEffectShadows, public IEffectMultiView
     {
     public:
         explicit BasicEffect(_In_ ID3D11Device* device);
@@ -201,6 +591,19 @@ namespace DirectX
         // Normal compression settings.
         void __cdecl SetBiasedVertexNormals(bool value);
 
+        // Instancing settings (requires Feature Level 10.0 or later, and always uses per-pixel lighting). Lighting must be
+        // enabled first, and cannot be disabled while instancing is on.
+        void __cdecl SetInstancingEnabled(bool value) override;
+
+        // Clustered lights (requires Feature Level 11.0, and only applies while lighting is enabled).
+        void __cdecl SetClusteredLights(_In_opt_ ClusteredLights* value) override;
+
+        // Shadows for light 0 (requires Feature Level 11.0, and only applies while lighting is enabled).
+        void __cdecl SetShadowMap(_In_opt_ CascadedShadowMap* value) override;
+
+        // Multi-view drawing (requires Feature Level 10.0 and lighting, and always uses per-pixel lighting).
+        void __cdecl SetMultiView(_In_opt_ MultiView* value) override;
+
     private:
         // Private implementation.
         class Impl;
@@ -447,6 +850,12 @@ namespace DirectX
         // Normal compression settings.
         void __cdecl SetBiasedVertexNormals(bool value);
 
+        // Reads the bones from a BonePalette (or any buffer view of three float4 rows per bone) instead of
+        // SetBoneTransforms, which lifts the MaxBones limit. Vertex bone indices are relative to firstBone, and
+        // instanced draws step on by bonesPerInstance for each instance. Pass nullptr to go back to SetBoneTransforms.
+        // Requires Feature Level 10.0.
+        void __cdecl SetBonePalette(_In_opt_ ID3D11ShaderResourceView* value, uint32_t firstBone = 0, uint32_t bonesPerInstance = 0);
+
     private:
         // Private implementation.
         class Impl;
@@ -457,6 +866,39 @@ namespace DirectX
         void __cdecl SetLightingEnabled(bool value) override;
     };
 
+
+    //----------------------------------------------------------------------------------
+    // GPU bone storage for SkinnedEffect::SetBonePalette. One palette can hold the bones of many models, or of every
+    // instance of one, and Update uploads only the range of bones changed since the previous Update.
+    class BonePalette
+    {
+    public:
+        BonePalette(_In_ ID3D11Device* device, size_t maxBones);
+
+        BonePalette(BonePalette&& moveFrom) noexcept;
+        BonePalette& operator= (BonePalette&& moveFrom) noexcept;
+
+        BonePalette(BonePalette const&) = delete;
+        BonePalette& operator= (BonePalette const&) = delete;
+
+        virtual ~BonePalette();
+
+        // Sets count bones starting at firstBone. The GPU copy is not touched until Update.
+        void __cdecl SetBoneTransforms(size_t firstBone, _In_reads_(count) XMMATRIX const* value, size_t count);
+
+        void __cdecl Update(_In_ ID3D11DeviceContext* deviceContext);
+
+        ID3D11ShaderResourceView* __cdecl GetShaderResourceView() const noexcept;
+
+        size_t __cdecl GetMaxBones() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
     //----------------------------------------------------------------------------------
     // Built-in effect for Visual Studio Shader Designer (DGSL) shaders
     class DGSLEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectSkinning
@@ -533,13 +975,17 @@ namespace DirectX
 
         std::unique_ptr<Impl> pImpl;
 
+        // Lets EffectWarmup create the shaders up front.
+        friend std::shared_ptr<void> CreateAllDGSLEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+
         // Unsupported interface methods.
         void __cdecl SetPerPixelLighting(bool value) override;
     };
 
     //----------------------------------------------------------------------------------
     // Built-in shader extends BasicEffect with normal maps and optional specular maps
-    class NormalMapEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectFog
+    class NormalMapEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectFog, public IEffectInstancing, public IEffectPass,
+                            public IEffectClusteredLights, public IEffectShadows
     {
     public:
         explicit NormalMapEffect(_In_ ID3D11Device* device);
@@ -598,6 +1044,22 @@ namespace DirectX
         // Normal compression settings.
         void __cdecl SetBiasedVertexNormals(bool value);
 
+        // Instancing settings.
+        void __cdecl SetInstancingEnabled(bool value) override;
+
+        // Clustered lights (requires Feature Level 11.0).
+        void __cdecl SetClusteredLights(_In_opt_ ClusteredLights* value) override;
+
+        // Shadows for light 0 (requires Feature Level 11.0).
+        void __cdecl SetShadowMap(_In_opt_ CascadedShadowMap* value) override;
+
+        // Pass settings.
+        void __cdecl SetPass(EffectPass pass) override;
+        EffectPass __cdecl GetPass() const noexcept override;
+
+        // Render target size, required for velocity-only output.
+        void __cdecl SetRenderTargetSizeInPixels(int width, int height);
+
     private:
         // Private implementation.
         class Impl;
@@ -611,7 +1073,8 @@ namespace DirectX
 
     //----------------------------------------------------------------------------------
     // Built-in shader for Physically-Based Rendering (Roughness/Metalness) with Image-based lighting
-    class PBREffect : public IEffect, public IEffectMatrices, public IEffectLights
+    class PBREffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectInstancing, public IEffectPass,
+                      public IEffectClusteredLights, public IEffectShadows
     {
     public:
         explicit PBREffect(_In_ ID3D11Device* device);
@@ -667,12 +1130,26 @@ namespace DirectX
         // Normal compression settings.
         void __cdecl SetBiasedVertexNormals(bool value);
 
+        // Instancing settings.
+        void __cdecl SetInstancingEnabled(bool value) override;
+
+        // Clustered lights (requires Feature Level 11.0; not used by the velocity generation shaders).
+        void __cdecl SetClusteredLights(_In_opt_ ClusteredLights* value) override;
+
+        // Shadows for light 0 (requires Feature Level 11.0; not used by the velocity generation shaders).
+        void __cdecl SetShadowMap(_In_opt_ CascadedShadowMap* value) override;
+
         // Velocity buffer settings.
         void __cdecl SetVelocityGeneration(bool value);
 
         // Render target size, required for velocity buffer output.
         void __cdecl SetRenderTargetSizeInPixels(int width, int height);
 
+        // Pass settings. Velocity is measured against the world-view-projection of the previous Apply that wrote
+        // velocity, so use either the velocity-only pass or SetVelocityGeneration in a frame, not both.
+        void __cdecl SetPass(EffectPass pass) override;
+        EffectPass __cdecl GetPass() const noexcept override;
+
     private:
         // Private implementation.
         class Impl;
@@ -798,7 +1275,8 @@ namespace DirectX
     };
 
 
-    // Factory for sharing effects and texture resources
+    // Factory for sharing effects and texture resources. With sharing enabled, the built-in factories hand out one
+    // effect for every EffectInfo with the same settings and texture names, regardless of the material name.
     class EffectFactory : public IEffectFactory
     {
     public:
@@ -909,6 +1387,16 @@ namespace DirectX
 
         virtual void __cdecl CreatePixelShader(_In_z_ const wchar_t* shader, _Outptr_ ID3D11PixelShader** pixelShader);
 
+        // Creates every shader in a pack built by the shaderpack tool from a directory of DGSL .cso files. A pixel
+        // shader whose file name (without directory or extension) matches a pack entry then comes from the pack
+        // rather than from disk. Pack shaders live until ReleaseCache.
+        void __cdecl LoadShaderPack(_In_z_ const wchar_t* fileName);
+
+        // Loads the named DGSL pixel shaders into the shader cache on the thread pool, so later CreateDGSLEffect calls
+        // for them find the shaders ready. Load failures are left for CreateDGSLEffect to report. Does nothing when
+        // sharing is disabled.
+        std::future<void> __cdecl PreloadPixelShadersAsync(_In_reads_(count) const wchar_t* const* shaders, size_t count);
+
         // Settings.
         void __cdecl ReleaseCache();
 
@@ -927,4 +1415,59 @@ namespace DirectX
 
         std::shared_ptr<Impl> pImpl;
     };
+
+
+    //----------------------------------------------------------------------------------
+    // Built-in effects create each shader permutation the first time it is drawn with. EffectWarmup creates them
+    // all up front instead, so the first frames showing a new material do not stall. The shaders stay created for
+    // as long as the EffectWarmup object lives.
+    enum EffectWarmupFlags : uint32_t
+    {
+        EffectWarmup_AlphaTest      = 0x1,
+        EffectWarmup_Basic          = 0x2,
+        EffectWarmup_Debug          = 0x4,
+        EffectWarmup_DGSL           = 0x8,
+        EffectWarmup_DualTexture    = 0x10,
+        EffectWarmup_EnvironmentMap = 0x20,
+        EffectWarmup_NormalMap      = 0x40,
+        EffectWarmup_PBR            = 0x80,
+        EffectWarmup_Skinned        = 0x100,
+
+        EffectWarmup_All            = 0x1ff,
+    };
+
+    class EffectWarmup
+    {
+    public:
+        explicit EffectWarmup(_In_ ID3D11Device* device);
+        EffectWarmup(EffectWarmup&& moveFrom) noexcept;
+        EffectWarmup& operator= (EffectWarmup&& moveFrom) noexcept;
+
+        EffectWarmup(EffectWarmup const&) = delete;
+        EffectWarmup& operator= (EffectWarmup const&) = delete;
+
+        virtual ~EffectWarmup();
+
+        struct Timing
+        {
+            const wchar_t*  effectName;
+            size_t          shaderCount;
+            float           milliseconds;
+        };
+
+        // Creates the shaders of each effect type selected by EffectWarmupFlags on the calling thread
+        void __cdecl Run(uint32_t effects = EffectWarmup_All);
+
+        // Does the same on a worker thread; the future rethrows anything that fails
+        std::future<void> __cdecl RunAsync(uint32_t effects = EffectWarmup_All);
+
+        // Reports how many shaders each effect type created and how long that took
+        std::vector<Timing> __cdecl GetTimings() const;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::shared_ptr<Impl> pImpl;
+    };
 }
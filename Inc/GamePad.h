@@ -37,6 +37,8 @@
 
 namespace DirectX
 {
+    class InputEventQueue;
+
     class GamePad
     {
     public:
@@ -265,6 +267,14 @@ namespace DirectX
 
     #if (_WIN32_WINNT >= 0x0A00 /*_WIN32_WINNT_WIN10*/ ) || defined(_XBOX_ONE)
         void __cdecl RegisterEvents(void* ctrlChanged, void* userChanged) noexcept;
+    #else
+        // Samples every XInput controller from a background thread this many times a second, so GetState just reads
+        // the latest sample instead of calling the driver; empty slots are probed there about once a second. Zero
+        // (the default) stops the thread and goes back to reading XInput in GetState.
+        void __cdecl SetPollingRate(unsigned int samplesPerSecond);
+
+        // While polling, also report connections and button changes to the queue as they are sampled (nullptr to stop)
+        void __cdecl SetEventQueue(_In_opt_ InputEventQueue* queue) noexcept;
     #endif
 
         // Singleton
@@ -45,6 +45,7 @@ namespace DirectX
         static std::unique_ptr<GeometricPrimitive> __cdecl CreateIcosahedron(_In_ ID3D11DeviceContext* deviceContext, float size = 1, bool rhcoords = true);
         static std::unique_ptr<GeometricPrimitive> __cdecl CreateTeapot(_In_ ID3D11DeviceContext* deviceContext, float size = 1, size_t tessellation = 8, bool rhcoords = true);
         static std::unique_ptr<GeometricPrimitive> __cdecl CreateCustom(_In_ ID3D11DeviceContext* deviceContext, const std::vector<VertexType>& vertices, const std::vector<uint16_t>& indices);
+        static std::unique_ptr<GeometricPrimitive> __cdecl CreateCustom(_In_ ID3D11DeviceContext* deviceContext, const std::vector<VertexType>& vertices, const std::vector<uint32_t>& indices);
 
         static void __cdecl CreateCube(std::vector<VertexType>& vertices, std::vector<uint16_t>& indices, float size = 1, bool rhcoords = true);
         static void __cdecl CreateBox(std::vector<VertexType>& vertices, std::vector<uint16_t>& indices, const XMFLOAT3& size, bool rhcoords = true, bool invertn = false);
@@ -59,6 +60,64 @@ namespace DirectX
         static void __cdecl CreateIcosahedron(std::vector<VertexType>& vertices, std::vector<uint16_t>& indices, float size = 1, bool rhcoords = true);
         static void __cdecl CreateTeapot(std::vector<VertexType>& vertices, std::vector<uint16_t>& indices, float size = 1, size_t tessellation = 8, bool rhcoords = true);
 
+        // 32-bit index versions, for tessellations that need more than 65535 vertices.
+        static void __cdecl CreateCube(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateBox(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, const XMFLOAT3& size, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateSphere(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float diameter = 1, size_t tessellation = 16, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateGeoSphere(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float diameter = 1, size_t tessellation = 3, bool rhcoords = true);
+        static void __cdecl CreateCylinder(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float height = 1, float diameter = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateCone(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float diameter = 1, float height = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTorus(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float diameter = 1, float thickness = 0.333f, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTetrahedron(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateOctahedron(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateDodecahedron(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateIcosahedron(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateTeapot(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, float size = 1, size_t tessellation = 8, bool rhcoords = true);
+
+        // Generate into caller-provided memory, such as a GraphicsMemory allocation, with no intermediate copies.
+        // Size the arrays with the matching Get*Size; std::out_of_range is thrown if either is too small. The
+        // left-handed and inverted-normal options read back what was written, so avoid them on write-combined memory.
+        // GeoSphere is not offered, as its seam fixups rewrite the output while generating it.
+        static void __cdecl CreateCube(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateBox(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, const XMFLOAT3& size, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateSphere(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float diameter = 1, size_t tessellation = 16, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateCylinder(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float height = 1, float diameter = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateCone(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float diameter = 1, float height = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTorus(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float diameter = 1, float thickness = 0.333f, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTetrahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateOctahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateDodecahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateIcosahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateTeapot(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint16_t* indices, size_t indexCount, float size = 1, size_t tessellation = 8, bool rhcoords = true);
+        static void __cdecl CreateCube(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateBox(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, const XMFLOAT3& size, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateSphere(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float diameter = 1, size_t tessellation = 16, bool rhcoords = true, bool invertn = false);
+        static void __cdecl CreateCylinder(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float height = 1, float diameter = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateCone(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float diameter = 1, float height = 1, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTorus(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float diameter = 1, float thickness = 0.333f, size_t tessellation = 32, bool rhcoords = true);
+        static void __cdecl CreateTetrahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateOctahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateDodecahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateIcosahedron(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, bool rhcoords = true);
+        static void __cdecl CreateTeapot(_Out_writes_(vertexCount) VertexType* vertices, size_t vertexCount, _Out_writes_(indexCount) uint32_t* indices, size_t indexCount, float size = 1, size_t tessellation = 8, bool rhcoords = true);
+
+        static void __cdecl GetCubeSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetBoxSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetSphereSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount, size_t tessellation = 16);
+        static void __cdecl GetCylinderSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount, size_t tessellation = 32);
+        static void __cdecl GetConeSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount, size_t tessellation = 32);
+        static void __cdecl GetTorusSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount, size_t tessellation = 32);
+        static void __cdecl GetTetrahedronSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetOctahedronSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetDodecahedronSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetIcosahedronSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount) noexcept;
+        static void __cdecl GetTeapotSize(_Out_ size_t& vertexCount, _Out_ size_t& indexCount, size_t tessellation = 8);
+
+        // Reorder triangles for post-transform vertex cache reuse, then vertices into first-use order. The device
+        // factory methods above apply this to the shapes they create.
+        static void __cdecl OptimizeForVertexCache(std::vector<VertexType>& vertices, std::vector<uint16_t>& indices, size_t cacheSize = 32);
+        static void __cdecl OptimizeForVertexCache(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, size_t cacheSize = 32);
+
         // Draw the primitive.
         void XM_CALLCONV Draw(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection, FXMVECTOR color = Colors::White, _In_opt_ ID3D11ShaderResourceView* texture = nullptr, bool wireframe = false,
                               _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
@@ -70,6 +129,22 @@ namespace DirectX
        // Create input layout for drawing with a custom effect.
         void __cdecl CreateInputLayout(_In_ IEffect* effect, _Outptr_ ID3D11InputLayout** inputLayout) const;
 
+        // Draw the primitive once per instance with hardware instancing (requires Feature Level 10.0 or later). Each
+        // transform takes the place of the world matrix, and instanceColors may be null to draw every instance in white.
+        // Instance colors are straight alpha, like the color passed to Draw, and are premultiplied on upload.
+        void XM_CALLCONV DrawInstanced(_In_reads_(instanceCount) const XMFLOAT4X4* instanceTransforms, _In_reads_opt_(instanceCount) const XMFLOAT4* instanceColors, size_t instanceCount,
+                                       FXMMATRIX view, CXMMATRIX projection, _In_opt_ ID3D11ShaderResourceView* texture = nullptr, bool wireframe = false,
+                                       _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Queue an instance of the primitive, then draw everything queued with Flush using one instanced draw for the
+        // opaque instances and one for the translucent ones.
+        void XM_CALLCONV Accumulate(FXMMATRIX world, FXMVECTOR color = Colors::White);
+
+        void XM_CALLCONV Flush(FXMMATRIX view, CXMMATRIX projection, bool wireframe = false,
+                               _In_opt_ std::function<void __cdecl()> setCustomState = nullptr);
+
+        size_t __cdecl GetAccumulatedCount() const noexcept;
+
     private:
         GeometricPrimitive() noexcept(false);
 
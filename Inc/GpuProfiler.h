@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------------
+// File: GpuProfiler.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Opt-in CPU and GPU timing of named scopes. While one exists, SpriteBatch::End, Model::Draw and DrawCulled,
+    // GeometricPrimitive::Draw, the post-process Process calls and the built-in effects' Apply are each wrapped in
+    // an ID3DUserDefinedAnnotation event (seen by PIX and other GPU tools) and a pair of timestamp queries.
+    //
+    // Scopes nest, and repeats of a scope under the same parent are merged, so a frame reports one entry per call
+    // site with a call count. Queries sit in a ring of frames and are only read back once the GPU has finished
+    // with them, without flushing or waiting, so results arrive a few frames late and reading them never stalls.
+    // A frame still unresolved when its slot comes round again is dropped.
+    //
+    // Only work on the given device context, between BeginFrame and EndFrame, is recorded. GpuProfileScope may be
+    // used on any thread, since scopes on other contexts are ignored; destroying the profiler waits for any such call
+    // still in progress. Scope names must stay valid for the lifetime of the profiler (string literals are the
+    // intent). Singleton.
+    class GpuProfiler
+    {
+    public:
+        // frameLatency is how many frames the results lag behind; maxScopes caps the timed scopes in one frame
+        // (scopes past it still get events and CPU time).
+        GpuProfiler(_In_ ID3D11DeviceContext* deviceContext, size_t frameLatency = 3, size_t maxScopes = 1024);
+
+        GpuProfiler(GpuProfiler&& moveFrom) noexcept;
+        GpuProfiler& operator= (GpuProfiler&& moveFrom) noexcept;
+
+        GpuProfiler(GpuProfiler const&) = delete;
+        GpuProfiler& operator= (GpuProfiler const&) = delete;
+
+        virtual ~GpuProfiler();
+
+        struct Scope
+        {
+            static const uint32_t c_NoParent = uint32_t(-1);
+
+            const wchar_t*  name;
+            uint32_t        parent;             // Index of the enclosing scope in the results, or c_NoParent
+            uint32_t        depth;
+            uint32_t        calls;
+            float           cpuMilliseconds;    // Summed over the calls
+            float           gpuMilliseconds;    // Summed over the timed calls
+        };
+
+        void __cdecl BeginFrame();
+        void __cdecl EndFrame();
+
+        // Scopes for application code; see also GpuProfileScope.
+        void __cdecl BeginScope(_In_ ID3D11DeviceContext* deviceContext, _In_z_ const wchar_t* name);
+        void __cdecl EndScope(_In_ ID3D11DeviceContext* deviceContext);
+
+        // Scopes of the most recently resolved frame, parents before their children.
+        const std::vector<Scope>& __cdecl GetResults() const noexcept;
+
+        // Frame number (counting EndFrame calls from 1) of the results, or 0 before any have resolved.
+        uint64_t __cdecl GetResultsFrame() const noexcept;
+
+        float __cdecl GetFrameCpuMilliseconds() const noexcept;
+        float __cdecl GetFrameGpuMilliseconds() const noexcept;
+
+        // Number of frames dropped because their queries had not finished in time.
+        uint64_t __cdecl GetDroppedFrames() const noexcept;
+
+        // Used by GpuProfileScope: these do nothing, cheaply, when no profiler exists or the context is not profiled.
+        static bool __cdecl TryBeginScope(_In_ ID3D11DeviceContext* deviceContext, _In_z_ const wchar_t* name) noexcept;
+        static void __cdecl EndActiveScope(_In_ ID3D11DeviceContext* deviceContext) noexcept;
+
+        // Singleton
+        static GpuProfiler& __cdecl Get();
+        static bool __cdecl IsCreated() noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    // Profiles the enclosing block when a GpuProfiler is recording the context.
+    class GpuProfileScope
+    {
+    public:
+        GpuProfileScope(_In_ ID3D11DeviceContext* deviceContext, _In_z_ const wchar_t* name) noexcept
+            : mDeviceContext(GpuProfiler::TryBeginScope(deviceContext, name) ? deviceContext : nullptr)
+        {
+        }
+
+        GpuProfileScope(GpuProfileScope const&) = delete;
+        GpuProfileScope& operator= (GpuProfileScope const&) = delete;
+
+        ~GpuProfileScope()
+        {
+            if (mDeviceContext)
+                GpuProfiler::EndActiveScope(mDeviceContext);
+        }
+
+    private:
+        ID3D11DeviceContext* mDeviceContext;
+    };
+}
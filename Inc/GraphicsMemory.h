@@ -36,12 +36,50 @@ namespace DirectX
 
         virtual ~GraphicsMemory();
 
+        // Allocate may be called from several threads at once without locking. Commit retires everything
+        // allocated since the previous Commit, so it must not run concurrently with Allocate. Commit also issues its
+        // frame fence and queries on the device's immediate context, which is not thread-safe, so call it from the
+        // thread that submits work to that context (typically just before Present), never from a worker thread.
         void* __cdecl Allocate(_In_opt_ ID3D11DeviceContext* context, size_t size, int alignment);
 
         void __cdecl Commit();
 
+        // Commit marks the end of the frame on the immediate context, then returns once no more than maxFrameLatency
+        // committed frames are still unfinished on the GPU; 0 waits for all of them. Defaults to backBufferCount - 1
+        // on Xbox One, as in earlier versions, and to 3, the DXGI default, otherwise. Waits block on an ID3D11Fence
+        // event where the device has one, and otherwise poll with a back-off.
+        void __cdecl SetMaximumFrameLatency(UINT maxFrameLatency) noexcept;
+        UINT __cdecl GetMaximumFrameLatency() const noexcept;
+
+        // Committed frames the GPU had not finished at the last Commit, counted before it waited.
+        UINT __cdecl GetFramesInFlight() const noexcept;
+
+        // Commit releases upload memory held for reuse until the working set is no more than bytes: free pages on
+        // Xbox One, otherwise the rings of contexts that did not upload during the frame. Memory in use is kept, so
+        // the working set can stay above the target. Defaults to no limit.
+        void __cdecl SetTargetWorkingSet(size_t bytes) noexcept;
+        size_t __cdecl GetWorkingSet() const noexcept;
+
+    #if !defined(_XBOX_ONE) || !defined(_TITLE)
+        // Suballocates from a per-context dynamic ring buffer shared by all callers, mapped with D3D11_MAP_WRITE_NO_OVERWRITE
+        // (or WRITE_DISCARD when the ring wraps). bindFlag selects the vertex/index ring or the constant ring, whose offsets
+        // are multiples of 256 bytes for use with *SetConstantBuffers1. Only one range per ring can be mapped at a time, and
+        // it must be unmapped before drawing. The returned buffer is owned by GraphicsMemory and stays valid until it is destroyed,
+        // or until Commit releases the context's rings to meet the target working set.
+        void* __cdecl MapUpload(_In_ ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag, size_t size, int alignment, _Outptr_ ID3D11Buffer** buffer, _Out_ UINT* offset);
+        void __cdecl UnmapUpload(_In_ ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag);
+
+        // The next upload to each ring of this context will use WRITE_DISCARD. Commit does this for every context, but
+        // a deferred context that records several command lists per frame must call it after each FinishCommandList.
+        void __cdecl ResetUploads(_In_ ID3D11DeviceContext* context);
+
+        // Whether the device supports constant buffer offsets and NO_OVERWRITE maps of dynamic constant buffers.
+        bool __cdecl IsConstantUploadSupported() const noexcept;
+    #endif
+
         // Singleton
         static GraphicsMemory& __cdecl Get();
+        static bool __cdecl IsCreated() noexcept;
 
     private:
         // Private implementation.
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------
+// File: IBLBaker.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <memory>
+
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Prefilters an environment cubemap into the radiance and irradiance cubemaps PBREffect::SetIBLTextures expects, on
+    // the GPU. Radiance mip m is GGX filtered for roughness m / mip count, which is how PBREffect picks the mip.
+    //
+    // A bake is split into small dispatches, each a band of rows on one face of one mip, and Process issues as many as
+    // fit a GPU time budget. The cost per sample is measured with timestamp queries read back a few frames later, so
+    // the budget is approximate until the first measurements arrive. Results go to a second pair of cubemaps and are
+    // swapped in when the bake completes, so the textures returned by GetRadianceTexture and GetIrradianceTexture are
+    // always whole; they are null until the first bake finishes.
+    //
+    // Requires Feature Level 11.0. Use it from the thread that owns the device context.
+    class IBLBaker
+    {
+    public:
+        IBLBaker(_In_ ID3D11Device* device,
+            unsigned int radianceSize = 256,
+            unsigned int irradianceSize = 32,
+            DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT);
+
+        IBLBaker(IBLBaker&& moveFrom) noexcept;
+        IBLBaker& operator= (IBLBaker&& moveFrom) noexcept;
+
+        IBLBaker(IBLBaker const&) = delete;
+        IBLBaker& operator= (IBLBaker const&) = delete;
+
+        virtual ~IBLBaker();
+
+        // Starts baking from a cubemap view, abandoning any bake in progress. The source is copied by the first Process
+        // call, so it only has to stay unchanged until then.
+        void __cdecl Begin(_In_ ID3D11ShaderResourceView* environment);
+
+        // Issues the next part of the bake. Returns true on the call that completes it and swaps in the results.
+        bool __cdecl Process(_In_ ID3D11DeviceContext* deviceContext, float budgetMilliseconds = 1.f);
+
+        // Runs a whole bake at once.
+        void __cdecl Bake(_In_ ID3D11DeviceContext* deviceContext, _In_ ID3D11ShaderResourceView* environment);
+
+        bool __cdecl IsBaking() const noexcept;
+
+        // Fraction of the current bake issued so far.
+        float __cdecl GetProgress() const noexcept;
+
+        // Number of bakes completed.
+        uint64_t __cdecl GetGeneration() const noexcept;
+
+        ID3D11ShaderResourceView* __cdecl GetRadianceTexture() const noexcept;
+        ID3D11ShaderResourceView* __cdecl GetIrradianceTexture() const noexcept;
+        int __cdecl GetRadianceMipLevels() const noexcept;
+
+        // Sample counts for the filters, used from the next Begin. More samples reduce noise from small, bright lights.
+        void __cdecl SetSampleCounts(unsigned int specularSamples, unsigned int irradianceSamples);
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
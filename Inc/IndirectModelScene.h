@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------------------------
+// File: IndirectModelScene.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <functional>
+#include <memory>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    class CommonStates;
+    class Model;
+
+    // Draws static model placements with culling done on the GPU. Every opaque mesh part of every added model goes
+    // into a table on the GPU; Cull runs a compute shader that tests each placement against the view frustum, and
+    // optionally a hierarchical-Z buffer, and writes the survivors' transforms and instance counts straight into
+    // the instance stream and argument buffer read by DrawIndexedInstancedIndirect.
+    //
+    // Placements of the same part share one indirect draw, so the work on the CPU each frame follows the number of
+    // distinct parts, whatever the number of placements or how many are culled. The effects of the added parts must
+    // support IEffectInstancing. Alpha parts are left out, to be drawn sorted by Model::Draw or ModelRenderQueue.
+    //
+    // The part ranges are read when the table is built, so pack the models with ModelBufferArena (if at all) before
+    // adding them, and keep them alive and unchanged while this object draws them. Requires Feature Level 11.0.
+    class IndirectModelScene
+    {
+    public:
+        explicit IndirectModelScene(_In_ ID3D11Device* device);
+
+        IndirectModelScene(IndirectModelScene&& moveFrom) noexcept;
+        IndirectModelScene& operator= (IndirectModelScene&& moveFrom) noexcept;
+
+        IndirectModelScene(IndirectModelScene const&) = delete;
+        IndirectModelScene& operator= (IndirectModelScene const&) = delete;
+
+        virtual ~IndirectModelScene();
+
+        // Adds the opaque parts of the model, placed with the given world transform. The table is rebuilt on the next Cull.
+        void XM_CALLCONV Add(const Model& model, FXMMATRIX world);
+
+        // Culls every placement for the coming Draw calls. hiZ is an optional R32_FLOAT depth pyramid covering the
+        // viewport, for example built from the previous frame: mip 0 at the viewport size, each texel of the mips
+        // below holding the farthest depth of the 2x2 texels above it, with depth increasing away from the camera.
+        void XM_CALLCONV Cull(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection,
+                              _In_opt_ ID3D11ShaderResourceView* hiZ = nullptr);
+
+        // Draws the placements that passed the last Cull, one indirect draw per part.
+        void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+                              bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr);
+
+        // Removes every placement.
+        void __cdecl Clear() noexcept;
+
+        size_t __cdecl GetInstanceCount() const noexcept;
+        size_t __cdecl GetDrawCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------
+// File: InputEvents.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    struct InputEvent
+    {
+        enum Type : uint8_t
+        {
+            KEY_DOWN = 0,         // code is a Keyboard::Keys
+            KEY_UP,
+            MOUSE_BUTTON_DOWN,    // code is a MouseButton
+            MOUSE_BUTTON_UP,
+            MOUSE_MOVE,           // x, y is the absolute position
+            MOUSE_DELTA,          // x, y is the relative motion
+            MOUSE_WHEEL,          // x is the wheel delta
+            GAMEPAD_BUTTON_DOWN,  // code is a GamePadButton, player is set
+            GAMEPAD_BUTTON_UP,
+            GAMEPAD_CONNECTED,    // player is set
+            GAMEPAD_DISCONNECTED,
+        };
+
+        enum MouseButton : uint16_t
+        {
+            MOUSE_LEFT = 0,
+            MOUSE_RIGHT,
+            MOUSE_MIDDLE,
+            MOUSE_X1,
+            MOUSE_X2,
+        };
+
+        // Bit masks, matching XINPUT_GAMEPAD_*.
+        enum GamePadButton : uint16_t
+        {
+            GAMEPAD_DPAD_UP = 0x0001,
+            GAMEPAD_DPAD_DOWN = 0x0002,
+            GAMEPAD_DPAD_LEFT = 0x0004,
+            GAMEPAD_DPAD_RIGHT = 0x0008,
+            GAMEPAD_START = 0x0010,
+            GAMEPAD_BACK = 0x0020,
+            GAMEPAD_LEFT_STICK = 0x0040,
+            GAMEPAD_RIGHT_STICK = 0x0080,
+            GAMEPAD_LEFT_SHOULDER = 0x0100,
+            GAMEPAD_RIGHT_SHOULDER = 0x0200,
+            GAMEPAD_A = 0x1000,
+            GAMEPAD_B = 0x2000,
+            GAMEPAD_X = 0x4000,
+            GAMEPAD_Y = 0x8000,
+        };
+
+        int64_t     timestamp;  // QueryPerformanceCounter ticks
+        Type        type;
+        uint8_t     player;
+        uint16_t    code;
+        int32_t     x;
+        int32_t     y;
+    };
+
+    // A fixed-size queue of input events, stamped with QueryPerformanceCounter when they are seen. Keyboard, Mouse,
+    // and GamePad push into it from their message handlers and polling threads once given it with SetEventQueue, and
+    // a single consumer takes the events in order, for instance per simulation step up to that step's time. Pushing
+    // is lock-free from any number of threads; when the queue is full new events are dropped and counted.
+    class InputEventQueue
+    {
+    public:
+        // capacity is rounded up to a power of two.
+        explicit InputEventQueue(size_t capacity = 1024);
+
+        InputEventQueue(InputEventQueue&& moveFrom) noexcept;
+        InputEventQueue& operator= (InputEventQueue&& moveFrom) noexcept;
+
+        InputEventQueue(InputEventQueue const&) = delete;
+        InputEventQueue& operator= (InputEventQueue const&) = delete;
+
+        virtual ~InputEventQueue();
+
+        // Stamps the event with the current time and queues it. Returns false if the queue was full.
+        bool __cdecl Push(InputEvent::Type type, uint16_t code, int32_t x = 0, int32_t y = 0, uint8_t player = 0) noexcept;
+
+        // Queues an event that already has a timestamp.
+        bool __cdecl Push(const InputEvent& event) noexcept;
+
+        // Takes the oldest event, if there is one stamped before the given time. Only one thread may pop.
+        bool __cdecl Pop(InputEvent& event, int64_t before = INT64_MAX) noexcept;
+
+        // Drops every queued event.
+        void __cdecl Clear() noexcept;
+
+        size_t __cdecl GetCapacity() const noexcept;
+        size_t __cdecl GetDroppedCount() const noexcept;
+
+        static int64_t __cdecl GetTimestamp() noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
@@ -25,6 +25,8 @@ namespace ABI { namespace Windows { namespace UI { namespace Core { struct ICore
 
 namespace DirectX
 {
+    class InputEventQueue;
+
     class Keyboard
     {
     public:
@@ -458,6 +460,9 @@ namespace DirectX
         // Feature detection
         bool __cdecl IsConnected() const;
 
+        // Also report each key press and release to the queue, as KEY_DOWN/KEY_UP events (nullptr to stop)
+        void __cdecl SetEventQueue(_In_opt_ InputEventQueue* queue) noexcept;
+
     #if (!defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)) && defined(WM_USER)
         static void __cdecl ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam);
     #endif
@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------
+// File: MemoryTracker.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    enum MemoryCategory : uint32_t
+    {
+        MemoryCategory_Texture = 0,
+        MemoryCategory_VertexBuffer,
+        MemoryCategory_IndexBuffer,
+        MemoryCategory_ConstantBuffer,
+        MemoryCategory_Upload,          // GraphicsMemory pages and upload rings
+        MemoryCategory_Audio,           // System memory for wave data
+        MemoryCategory_Other,
+
+        MemoryCategory_Count
+    };
+
+    // Process-wide accounting of the memory DirectXTK creates, by category and owner (a file or model name).
+    // Tracking is off until enabled, and only allocations made while it is on are recorded; it should be
+    // turned on once at startup. Tracked Direct3D resources are removed automatically when they are destroyed.
+    //
+    // Resource sizes are estimated from their descriptions, so they ignore driver padding and tiling.
+    class MemoryTracker
+    {
+    public:
+        struct Usage
+        {
+            uint64_t    bytes;
+            uint64_t    allocations;
+            uint64_t    peakBytes;              // Since tracking started, or the last ResetPeaks
+            uint64_t    frameHighWaterBytes;    // Most held at once during the last completed frame
+            uint64_t    frameTransientBytes;    // Handed out for the last completed frame only (GraphicsMemory uploads)
+        };
+
+        struct Allocation
+        {
+            MemoryCategory  category;
+            uint64_t        bytes;
+            std::wstring    owner;
+        };
+
+        MemoryTracker() = delete;
+
+        static void __cdecl SetEnabled(bool enabled) noexcept;
+        static bool __cdecl IsEnabled() noexcept;
+
+        // Records a resource until it is destroyed. Tracking it again replaces the earlier record.
+        static void __cdecl TrackResource(_In_opt_ ID3D11Resource* resource, MemoryCategory category, _In_opt_z_ const wchar_t* owner) noexcept;
+
+        // Records other memory, returning a handle for ReleaseAllocation (0 when nothing was recorded).
+        static uint64_t __cdecl TrackAllocation(MemoryCategory category, size_t bytes, _In_opt_z_ const wchar_t* owner) noexcept;
+        static void __cdecl ReleaseAllocation(uint64_t handle) noexcept;
+
+        // Counts short-lived per-frame memory, such as suballocations from GraphicsMemory. Lock-free.
+        static void __cdecl AddFrameUsage(MemoryCategory category, size_t bytes) noexcept;
+
+        // Closes the frame's high-water marks and transient counts. GraphicsMemory::Commit calls this, so
+        // applications only need to when they do not use GraphicsMemory.
+        static void __cdecl EndFrame() noexcept;
+
+        static Usage __cdecl GetUsage(MemoryCategory category) noexcept;
+        static Usage __cdecl GetTotalUsage() noexcept;
+
+        static void __cdecl GetAllocations(std::vector<Allocation>& allocations);
+
+        static void __cdecl ResetPeaks() noexcept;
+    };
+}
@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <functional>
+#include <future>
 #include <set>
 #include <string>
 #include <vector>
@@ -34,8 +35,125 @@ namespace DirectX
 {
     class IEffect;
     class IEffectFactory;
+    class IEffectMatrices;
     class CommonStates;
+    class MultiView;
+    enum EffectPass : unsigned int;
     class ModelMesh;
+    class AnimationClip;
+
+    // Optional occlusion test for Model::DrawCulled, run on meshes that pass frustum culling (for example against a
+    // hierarchical-Z buffer kept by the application). Receives the mesh's bounds in world space; returns true to skip it.
+    using ModelOcclusionTest = std::function<bool __cdecl(const ModelMesh& mesh, const BoundingBox& worldBounds)>;
+
+    //----------------------------------------------------------------------------------
+    // Remembers the blend, depth/stencil, rasterizer and sampler state last set by ModelMesh::PrepareForRendering,
+    // so redundant state changes between meshes and models can be skipped. Call Reset whenever anything else may
+    // have changed this state on the device context.
+    class ModelRenderState
+    {
+    public:
+        ModelRenderState() noexcept { Reset(); }
+
+        void __cdecl Reset() noexcept
+        {
+            blendState = nullptr;
+            depthStencilState = nullptr;
+            rasterizerState = nullptr;
+            samplerState = nullptr;
+        }
+
+        ID3D11BlendState*           blendState;
+        ID3D11DepthStencilState*    depthStencilState;
+        ID3D11RasterizerState*      rasterizerState;
+        ID3D11SamplerState*         samplerState;
+    };
+
+    //----------------------------------------------------------------------------------
+    // Remembers the level of detail last drawn for each mesh of a model by the Model::Draw overload that selects
+    // them, so a mesh sitting near a threshold does not switch back and forth every frame. Keep one per model
+    // instance. A mesh only changes level once its projected size passes the threshold by the hysteresis fraction.
+    class ModelLodState
+    {
+    public:
+        ModelLodState() noexcept : hysteresis(0.1f) {}
+
+        void __cdecl Reset() noexcept { levels.clear(); }
+
+        std::vector<uint8_t>    levels;
+        float                   hysteresis;
+    };
+
+    //----------------------------------------------------------------------------------
+    // A bone of a model's skeleton (see ModelAnimation.h for evaluating animation clips)
+    class ModelBone
+    {
+    public:
+        ModelBone() noexcept :
+            parentIndex(c_Invalid)
+        {
+            XMStoreFloat4x4(&invBindPose, XMMatrixIdentity());
+            XMStoreFloat4x4(&localTransform, XMMatrixIdentity());
+        }
+
+        static const uint32_t c_Invalid = uint32_t(-1);
+
+        uint32_t        parentIndex;
+        std::wstring    name;
+        XMFLOAT4X4      invBindPose;
+        XMFLOAT4X4      localTransform;
+
+        typedef std::vector<ModelBone> Collection;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Transform hierarchy of one model instance: the local transform of each bone relative to its parent, and the
+    // absolute transform relative to the model root that results. Meshes attached to a bone (see ModelMesh::boneIndex)
+    // draw with its absolute transform ahead of the world matrix. Local and absolute transforms are kept in separate
+    // arrays, and Update recomputes only the bones whose local transform, or that of an ancestor, changed since the
+    // last one. Bones must be ordered with each parent before its children, as the model loaders ensure. Keep one
+    // per model instance.
+    class ModelTransforms
+    {
+    public:
+        ModelTransforms() noexcept;
+        explicit ModelTransforms(const ModelBone::Collection& bones);
+
+        ModelTransforms(ModelTransforms&&) = default;
+        ModelTransforms& operator= (ModelTransforms&&) = default;
+
+        ModelTransforms(ModelTransforms const&) = default;
+        ModelTransforms& operator= (ModelTransforms const&) = default;
+
+        // Starts over from the bones' local transforms in the bind pose, with every absolute transform up to date
+        void __cdecl Reset(const ModelBone::Collection& bones);
+
+        size_t __cdecl GetBoneCount() const noexcept { return mParents.size(); }
+
+        void XM_CALLCONV SetLocalTransform(size_t bone, FXMMATRIX transform);
+        void __cdecl SetLocalTransforms(size_t firstBone, _In_reads_(count) const XMMATRIX* transforms, size_t count);
+        XMMATRIX __cdecl GetLocalTransform(size_t bone) const;
+
+        // Absolute transforms are as of the last Update (or Reset)
+        XMMATRIX __cdecl GetAbsoluteTransform(size_t bone) const;
+        const XMFLOAT4X4* __cdecl GetAbsoluteTransforms() const noexcept { return mAbsolute.data(); }
+
+        bool __cdecl IsDirty() const noexcept { return mFirstDirty < mParents.size(); }
+
+        void __cdecl Update() noexcept;
+
+    private:
+        std::vector<uint32_t>   mParents;
+        std::vector<XMFLOAT4X4> mLocal;
+        std::vector<XMFLOAT4X4> mAbsolute;
+        std::vector<uint8_t>    mDirty;
+        size_t                  mFirstDirty;
+    };
+
+    // Updates many model instances in parallel on the system thread pool; instances with nothing dirty cost nothing.
+    void __cdecl UpdateModelTransforms(_Inout_updates_(count) ModelTransforms* transforms, size_t count);
+
 
     //----------------------------------------------------------------------------------
     // Each mesh part is a submesh with a single effect
@@ -52,18 +170,34 @@ namespace DirectX
         D3D_PRIMITIVE_TOPOLOGY                                  primitiveType;
         DXGI_FORMAT                                             indexFormat;
         Microsoft::WRL::ComPtr<ID3D11InputLayout>               inputLayout;
+        Microsoft::WRL::ComPtr<ID3D11InputLayout>               instancedInputLayout;
         Microsoft::WRL::ComPtr<ID3D11Buffer>                    indexBuffer;
         Microsoft::WRL::ComPtr<ID3D11Buffer>                    vertexBuffer;
         std::shared_ptr<IEffect>                                effect;
         std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>>  vbDecl;
         bool                                                    isAlpha;
 
+        // Coarser levels of detail made by Model::GenerateLods. Each is a range of lodIndexBuffer (in indexFormat)
+        // indexing the same vertices as the full-detail part, so the vertex buffer is shared; lods[0] is level 1.
+        struct LodLevel
+        {
+            uint32_t    startIndex;
+            uint32_t    indexCount;
+        };
+
+        std::vector<LodLevel>                                   lods;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                    lodIndexBuffer;
+
         typedef std::vector<std::unique_ptr<ModelMeshPart>> Collection;
 
         // Draw mesh part with custom effect
         void __cdecl Draw(_In_ ID3D11DeviceContext* deviceContext, _In_ IEffect* ieffect, _In_ ID3D11InputLayout* iinputLayout,
             _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
 
+        // Draw mesh part at a level of detail, where 0 is full detail. Levels past the last one generated draw the last.
+        void __cdecl DrawLod(_In_ ID3D11DeviceContext* deviceContext, _In_ IEffect* ieffect, _In_ ID3D11InputLayout* iinputLayout,
+            size_t level, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
         void __cdecl DrawInstanced(_In_ ID3D11DeviceContext* deviceContext, _In_ IEffect* ieffect, _In_ ID3D11InputLayout* iinputLayout,
             uint32_t instanceCount, uint32_t startInstanceLocation = 0,
             _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
@@ -71,8 +205,18 @@ namespace DirectX
        // Create input layout for drawing with a custom effect.
         void __cdecl CreateInputLayout(_In_ ID3D11Device* d3dDevice, _In_ IEffect* ieffect, _Outptr_ ID3D11InputLayout** iinputLayout) const;
 
+        // Create input layout that adds the per-instance transform stream (see IEffectInstancing) in vertex buffer slot 1.
+        void __cdecl CreateInstancedInputLayout(_In_ ID3D11Device* d3dDevice, _In_ IEffect* ieffect, _Outptr_ ID3D11InputLayout** iinputLayout) const;
+
         // Change effect used by part and regenerate input layout (be sure to call Model::Modified as well)
         void __cdecl ModifyEffect(_In_ ID3D11Device* d3dDevice, _In_ std::shared_ptr<IEffect>& ieffect, bool isalpha = false);
+
+        // Returns the IEffectMatrices interface of the effect, or nullptr. The cast is only repeated when the effect changes.
+        IEffectMatrices* __cdecl GetEffectMatrices() const;
+
+    private:
+        mutable std::weak_ptr<IEffect>  mMatricesEffect;
+        mutable IEffectMatrices*        mEffectMatrices;
     };
 
 
@@ -91,14 +235,29 @@ namespace DirectX
         bool                        ccw;
         bool                        pmalpha;
 
+        // Bone the mesh is attached to, used by the Model draws that take a ModelTransforms. ModelBone::c_Invalid
+        // leaves it at the model root.
+        uint32_t                    boneIndex;
+
+        // Projected sizes at which the mesh drops to each coarser level: below lodScreenSizes[k] it draws level k + 1.
+        // The size is the bounding sphere's radius over its view depth, scaled by the projection (about half the
+        // fraction of the viewport height it covers). Filled in by Model::GenerateLods when left empty.
+        std::vector<float>          lodScreenSizes;
+
         typedef std::vector<std::shared_ptr<ModelMesh>> Collection;
 
         // Setup states for drawing mesh
         void __cdecl PrepareForRendering(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, bool alpha = false, bool wireframe = false) const;
+        void __cdecl PrepareForRendering(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, ModelRenderState& renderState,
+                                         bool alpha = false, bool wireframe = false) const;
 
         // Draw the mesh
         void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
                               bool alpha = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Draw the mesh once per instance, using the per-instance transforms already bound to vertex buffer slot 1
+        void XM_CALLCONV DrawInstanced(_In_ ID3D11DeviceContext* deviceContext, uint32_t instanceCount, FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                       bool alpha = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
     };
 
 
@@ -109,24 +268,115 @@ namespace DirectX
     public:
         virtual ~Model();
 
-        ModelMesh::Collection   meshes;
-        std::wstring            name;
+        ModelMesh::Collection                       meshes;
+        std::wstring                                name;
+        ModelBone::Collection                       bones;
+        std::vector<std::shared_ptr<AnimationClip>> animations;
 
         // Draw all the meshes in the model
         void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
                               bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
 
+        // Draw all the meshes, skipping state already set according to renderState (which can be shared across models)
+        void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, ModelRenderState& renderState,
+                              FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                              bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Draw all the meshes, each at the level of detail picked from the projected size of its bounding sphere and
+        // its lodScreenSizes. lodState carries each mesh's level from frame to frame for hysteresis.
+        void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, ModelLodState& lodState,
+                              FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                              bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Draw all the meshes, placing each mesh attached to a bone with that bone's absolute transform ahead of the
+        // world matrix. The transforms must be for this model's bones.
+        void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const ModelTransforms& transforms,
+                              FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                              bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Builds up to maxLevels coarser levels of detail for every triangle list part by vertex clustering, each
+        // keeping about ratio of the triangles of the level before. Only index buffers are created and vertices are
+        // shared with the full-detail part. The buffers are read back through the device context, so this belongs at
+        // load time; it replaces any levels already generated.
+        void __cdecl GenerateLods(_In_ ID3D11DeviceContext* deviceContext, size_t maxLevels = 3, float ratio = 0.5f);
+
+        // Draw only the meshes whose bounding spheres intersect the view frustum, which is derived from world, view and
+        // projection unless one is given in world space. Culled meshes get no state setup or effect work. Returns the
+        // number of meshes drawn.
+        size_t XM_CALLCONV DrawCulled(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states,
+                                      FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                      bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr,
+                                      _In_opt_ ModelOcclusionTest isOccluded = nullptr) const;
+
+        size_t XM_CALLCONV DrawCulled(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const BoundingFrustum& frustum,
+                                      FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                      bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr,
+                                      _In_opt_ ModelOcclusionTest isOccluded = nullptr) const;
+
+        // Culled draws with the meshes placed by a transform hierarchy, as for Draw. Each mesh's bounds are moved by
+        // its bone's absolute transform before the test.
+        size_t XM_CALLCONV DrawCulled(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const ModelTransforms& transforms,
+                                      FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                      bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr,
+                                      _In_opt_ ModelOcclusionTest isOccluded = nullptr) const;
+
+        size_t XM_CALLCONV DrawCulled(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const BoundingFrustum& frustum,
+                                      const ModelTransforms& transforms,
+                                      FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                      bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr,
+                                      _In_opt_ ModelOcclusionTest isOccluded = nullptr) const;
+
+        // Draw all the meshes once per instance with hardware instancing. Each instance transform is applied ahead of
+        // the world matrix and uploaded through GraphicsMemory, and every effect in the model must support IEffectInstancing.
+        void XM_CALLCONV DrawInstanced(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states,
+                                       _In_reads_(instanceCount) const XMFLOAT4X4* instanceTransforms, size_t instanceCount,
+                                       FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                       bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+    #if (DIRECTX_MATH_VERSION >= 313)
+        void XM_CALLCONV DrawInstanced(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states,
+                                       _In_reads_(instanceCount) const XMFLOAT3X4* instanceTransforms, size_t instanceCount,
+                                       FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                       bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+    #endif
+
+        static const size_t MaxInstanceCount = 65536;
+
+        // Draw all the meshes, first giving the bone palette to every effect that supports IEffectSkinning
+        void XM_CALLCONV DrawSkinned(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states,
+                                     size_t nbones, _In_reads_(nbones) const XMMATRIX* boneTransforms,
+                                     FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                     bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Draw the opaque parts with one reduced pass, such as an early-Z prepass. Effects that support IEffectPass are
+        // switched to the pass for the draw and back to the default afterwards; other effects draw normally in a
+        // depth-only pass and are skipped in a velocity-only pass.
+        void XM_CALLCONV DrawPass(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, EffectPass pass,
+                                  FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                                  _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+        // Draw all the meshes into every view of a MultiView at once, with one instance per view. Each effect is given
+        // the MultiView for the draw and has it cleared afterwards, so every effect in the model must support
+        // IEffectMultiView. The viewport the MultiView was set up for must be bound.
+        void XM_CALLCONV DrawMultiView(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, MultiView& multiView,
+                                       FXMMATRIX world,
+                                       bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
        // Notify model that effects, parts list, or mesh list has changed
         void __cdecl Modified() noexcept { mEffectCache.clear(); }
 
         // Update all effects used by the model
         void __cdecl UpdateEffects(_In_ std::function<void __cdecl(IEffect*)> setEffect);
 
+        // Records the mesh buffers with MemoryTracker under the model's name, replacing earlier records. The loaders call
+        // this; buffers packed into a ModelBufferArena are then recorded by the arena instead.
+        void __cdecl TrackMemory() const noexcept;
+
         // Loads a model from a Visual Studio Starter Kit .CMO file
         static std::unique_ptr<Model> __cdecl CreateFromCMO(_In_ ID3D11Device* d3dDevice, _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
-                                                            _In_ IEffectFactory& fxFactory, bool ccw = true, bool pmalpha = false);
+                                                            _In_ IEffectFactory& fxFactory, bool ccw = true, bool pmalpha = false, bool quantize = false);
         static std::unique_ptr<Model> __cdecl CreateFromCMO(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
-                                                            _In_ IEffectFactory& fxFactory, bool ccw = true, bool pmalpha = false);
+                                                            _In_ IEffectFactory& fxFactory, bool ccw = true, bool pmalpha = false, bool quantize = false);
 
        // Loads a model from a DirectX SDK .SDKMESH file
         static std::unique_ptr<Model> __cdecl CreateFromSDKMESH(_In_ ID3D11Device* d3dDevice, _In_reads_bytes_(dataSize) const uint8_t* meshData, _In_ size_t dataSize,
@@ -136,11 +386,130 @@ namespace DirectX
 
        // Loads a model from a .VBO file
         static std::unique_ptr<Model> __cdecl CreateFromVBO(_In_ ID3D11Device* d3dDevice, _In_reads_bytes_(dataSize) const uint8_t* meshData, _In_ size_t dataSize,
-                                                            _In_opt_ std::shared_ptr<IEffect> ieffect = nullptr, bool ccw = false, bool pmalpha = false);
+                                                            _In_opt_ std::shared_ptr<IEffect> ieffect = nullptr, bool ccw = false, bool pmalpha = false, bool quantize = false);
         static std::unique_ptr<Model> __cdecl CreateFromVBO(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
-                                                            _In_opt_ std::shared_ptr<IEffect> ieffect = nullptr, bool ccw = false, bool pmalpha = false);
+                                                            _In_opt_ std::shared_ptr<IEffect> ieffect = nullptr, bool ccw = false, bool pmalpha = false, bool quantize = false);
+
+        // With quantize set, the CMO and VBO loaders store vertices in the packed VertexTypes (half-precision positions and
+        // texture coordinates, 8-bit normals and tangents), roughly halving vertex memory. Requires Feature Level 10.0.
+
+        // Loads a model from a cooked file written by ModelCooker
+        static std::unique_ptr<Model> __cdecl CreateFromCooked(_In_ ID3D11Device* d3dDevice, _In_reads_bytes_(dataSize) const uint8_t* meshData, _In_ size_t dataSize,
+                                                               _In_ IEffectFactory& fxFactory);
+        static std::unique_ptr<Model> __cdecl CreateFromCooked(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
+                                                               _In_ IEffectFactory& fxFactory);
+
+        // Loads a model on the system thread pool, returning as soon as the work is queued. Load errors are rethrown by
+        // future::get. The effect factory must outlive the load and be safe to use from other threads (the built-in ones are).
+        static std::future<std::unique_ptr<Model>> __cdecl CreateFromCMOAsync(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
+                                                                              _In_ IEffectFactory& fxFactory, bool ccw = true, bool pmalpha = false, bool quantize = false);
+        static std::future<std::unique_ptr<Model>> __cdecl CreateFromSDKMESHAsync(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
+                                                                                  _In_ IEffectFactory& fxFactory, bool ccw = false, bool pmalpha = false);
+        static std::future<std::unique_ptr<Model>> __cdecl CreateFromVBOAsync(_In_ ID3D11Device* d3dDevice, _In_z_ const wchar_t* szFileName,
+                                                                              _In_opt_ std::shared_ptr<IEffect> ieffect = nullptr, bool ccw = false, bool pmalpha = false, bool quantize = false);
 
     private:
         std::set<IEffect*>  mEffectCache;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        mutable Microsoft::WRL::ComPtr<ID3D11Buffer> mInstancePlacementBuffer;
+    #endif
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Collects mesh parts from many models and draws them together. Opaque parts are sorted to minimize state,
+    // effect and buffer changes, then alpha parts are drawn back-to-front by mesh bounding sphere. Queued models
+    // must stay alive, and their effects unchanged, until Draw is called.
+    class ModelRenderQueue
+    {
+    public:
+        ModelRenderQueue() noexcept(false);
+        ModelRenderQueue(ModelRenderQueue&& moveFrom) noexcept;
+        ModelRenderQueue& operator= (ModelRenderQueue&& moveFrom) noexcept;
+
+        ModelRenderQueue(ModelRenderQueue const&) = delete;
+        ModelRenderQueue& operator= (ModelRenderQueue const&) = delete;
+
+        virtual ~ModelRenderQueue();
+
+        // Queue all the meshes of a model, or a single mesh
+        void XM_CALLCONV Add(const Model& model, FXMMATRIX world);
+        void XM_CALLCONV Add(const ModelMesh& mesh, FXMMATRIX world);
+
+        // Sort and draw everything queued, then empty the queue
+        void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+                              bool wireframe = false, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr);
+
+        void __cdecl Clear() noexcept;
+
+        size_t __cdecl GetPartCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Moves the vertex and index buffers of loaded models into a few large shared buffers, grouped by vertex stride
+    // and index size, rewriting each part's vertexOffset and startIndex to match. Packing many models into one arena
+    // cuts the number of D3D buffers and lets consecutive draws share buffer bindings. The data is copied on the GPU
+    // and the model's original buffers are released once nothing else references them.
+    class ModelBufferArena
+    {
+    public:
+        explicit ModelBufferArena(_In_ ID3D11Device* device, size_t pageSize = 16 * 1024 * 1024);
+        ModelBufferArena(ModelBufferArena&& moveFrom) noexcept;
+        ModelBufferArena& operator= (ModelBufferArena&& moveFrom) noexcept;
+
+        ModelBufferArena(ModelBufferArena const&) = delete;
+        ModelBufferArena& operator= (ModelBufferArena const&) = delete;
+
+        virtual ~ModelBufferArena();
+
+        // Packs every mesh part of the model, appending to the arena's existing buffers where there is room
+        void __cdecl Pack(_In_ ID3D11DeviceContext* deviceContext, Model& model);
+
+        size_t __cdecl GetPageCount() const noexcept;
+        size_t __cdecl GetBytesUsed() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Writes models in the cooked format read by Model::CreateFromCooked, which holds vertex and index data, input
+    // element descriptions, bounds and materials ready to use with no parsing. Load the source model passing
+    // GetEffectFactory() as its effect factory, so the cooker can record the material behind each effect.
+    class ModelCooker
+    {
+    public:
+        explicit ModelCooker(_In_ IEffectFactory& fxFactory);
+        ModelCooker(ModelCooker&& moveFrom) noexcept;
+        ModelCooker& operator= (ModelCooker&& moveFrom) noexcept;
+
+        ModelCooker(ModelCooker const&) = delete;
+        ModelCooker& operator= (ModelCooker const&) = delete;
+
+        virtual ~ModelCooker();
+
+        // Effect factory that forwards to the one given to the constructor
+        IEffectFactory& __cdecl GetEffectFactory() noexcept;
+
+        // Reads the model's buffers back through the device context and writes the cooked file
+        void __cdecl Save(_In_ ID3D11DeviceContext* deviceContext, const Model& model, _In_z_ const wchar_t* szFileName);
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
     };
 }
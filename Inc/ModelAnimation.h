@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------------
+// File: ModelAnimation.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Model.h"
+
+
+namespace DirectX
+{
+    //----------------------------------------------------------------------------------
+    // Local transform of every bone in a skeleton, kept as separate scale, rotation (quaternion) and translation
+    // arrays so poses can be sampled and blended a component at a time.
+    class AnimationPose
+    {
+    public:
+        explicit AnimationPose(size_t boneCount = 0);
+
+        AnimationPose(AnimationPose&&) = default;
+        AnimationPose& operator= (AnimationPose&&) = default;
+
+        AnimationPose(AnimationPose const&) = default;
+        AnimationPose& operator= (AnimationPose const&) = default;
+
+        void __cdecl Resize(size_t boneCount);
+
+        size_t __cdecl GetBoneCount() const noexcept { return rotations.size(); }
+
+        // Sets every bone to its local transform in the model's bind pose
+        void __cdecl SetBindPose(const ModelBone::Collection& bones);
+
+        // Blends from one pose towards another; weight 0 gives a, weight 1 gives b
+        static void __cdecl Blend(const AnimationPose& a, const AnimationPose& b, float weight, AnimationPose& result);
+
+        // Computes the skinning matrices for SkinnedEffect::SetBoneTransforms (or Model::DrawSkinned) from this pose.
+        // Bones must be ordered with each parent before its children, as the model loaders ensure.
+        void __cdecl GetBonePalette(const ModelBone::Collection& bones, _Out_writes_(count) XMMATRIX* palette, size_t count) const;
+
+        std::vector<XMFLOAT3> scales;
+        std::vector<XMFLOAT4> rotations;
+        std::vector<XMFLOAT3> translations;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Animation clip resampled at a fixed rate, storing every bone's scale, rotation and translation contiguously
+    // for each frame. Sampling needs no keyframe search: it is one interpolation between two frames for all bones.
+    class AnimationClip
+    {
+    public:
+        // Keyframe holding a bone's local transform at a time; a bone's keyframes need not be sorted or evenly spaced.
+        // Keyframes for bones past the end of the skeleton are ignored.
+        struct Keyframe
+        {
+            uint32_t    boneIndex;
+            float       time;
+            XMFLOAT4X4  transform;
+        };
+
+        // Builds a clip from keyframes. Bones with no keyframes hold their bind pose.
+        AnimationClip(_In_z_ const wchar_t* name, const ModelBone::Collection& bones, float startTime, float endTime,
+                      _In_reads_(keyframeCount) const Keyframe* keyframes, size_t keyframeCount, float sampleRate = 30.f);
+
+        AnimationClip(AnimationClip&&) = default;
+        AnimationClip& operator= (AnimationClip&&) = default;
+
+        AnimationClip(AnimationClip const&) = delete;
+        AnimationClip& operator= (AnimationClip const&) = delete;
+
+        const std::wstring& __cdecl GetName() const noexcept { return mName; }
+        float __cdecl GetDuration() const noexcept { return mDuration; }
+        float __cdecl GetSampleRate() const noexcept { return mSampleRate; }
+        size_t __cdecl GetBoneCount() const noexcept { return mBoneCount; }
+
+        // Samples the clip at a time from its start, wrapping around if loop is set and holding the last frame otherwise
+        void __cdecl Sample(float time, bool loop, AnimationPose& pose) const;
+
+    private:
+        std::wstring            mName;
+        float                   mDuration;
+        float                   mSampleRate;
+        size_t                  mBoneCount;
+        size_t                  mFrameCount;
+        std::vector<XMFLOAT3>   mScales;
+        std::vector<XMFLOAT4>   mRotations;
+        std::vector<XMFLOAT3>   mTranslations;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Computes the bone palettes of many poses of one skeleton in parallel on the system thread pool. Palette j
+    // starts at palettes + j * bones.size(). Upload them with Model::DrawSkinned; when constant suballocation is
+    // enabled (see SetEffectConstantSuballocation), the uploads all go through the shared GraphicsMemory ring.
+    void __cdecl BuildBonePalettes(const ModelBone::Collection& bones, _In_reads_(poseCount) const AnimationPose* poses, size_t poseCount,
+                                   _Out_writes_(poseCount * bones.size()) XMMATRIX* palettes);
+}
@@ -24,6 +24,8 @@ namespace ABI { namespace Windows { namespace UI { namespace Core { struct ICore
 
 namespace DirectX
 {
+    class InputEventQueue;
+
     class Mouse
     {
     public:
@@ -104,6 +106,25 @@ namespace DirectX
     #if (!defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)) && defined(WM_USER)
         void __cdecl SetWindow(HWND window);
         static void __cdecl ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+        enum RawInputMode
+        {
+            RAW_INPUT_MESSAGES = 0,
+            RAW_INPUT_BUFFERED,
+            RAW_INPUT_THREAD,
+        };
+
+        // Sets how raw input (relative motion and the scroll wheel) is read (defaults to messages). With
+        // RAW_INPUT_MESSAGES, ProcessMessage reads each WM_INPUT on its own. RAW_INPUT_BUFFERED instead drains all
+        // pending raw input with GetRawInputBuffer at the first WM_INPUT and in GetState, summing the motion until
+        // GetState reads it, so a high polling rate mouse costs a few calls per frame; call GetState from the window's
+        // thread. RAW_INPUT_THREAD does the same on a dedicated thread with its own hidden window, and the application
+        // window gets no WM_INPUT at all. Call after SetWindow.
+        void __cdecl SetRawInputMode(RawInputMode mode);
+
+        // Also report mouse input to the queue as it arrives (nullptr to stop): button and wheel events, the absolute
+        // position as MOUSE_MOVE, and in relative mode each raw motion as MOUSE_DELTA.
+        void __cdecl SetEventQueue(_In_opt_ InputEventQueue* queue) noexcept;
     #endif
 
     #if (defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)) || (defined(_XBOX_ONE) && defined(_TITLE) && (_XDK_VER >= 0x42D907D1))
@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------------------
+// File: ParticleSystem.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Effects.h"
+
+#include <memory>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    // Particles that are emitted, simulated, and drawn entirely on the GPU. Live particles are tracked in
+    // append/consume lists that compute shaders compact every Update, and Draw renders them as camera facing quads
+    // with DrawInstancedIndirect, so the CPU only ever sees the emitter settings and never a particle count.
+    //
+    // Texture and color work like SpriteBatch: the texture is multiplied by a premultiplied color that fades from the
+    // start color to the end color over each particle's life. Blend, depth, rasterizer, and sampler states are left to
+    // the caller, as with the other effects; quads are not culled consistently, so use CullNone.
+    //
+    // The world matrix places the emitter. Particles are simulated in world space, so moving the emitter leaves a trail.
+    //
+    // Requires Feature Level 11.0. Update and Draw use the device context, so call them from the thread that owns it.
+    class ParticleSystem : public IEffect, public IEffectMatrices
+    {
+    public:
+        ParticleSystem(_In_ ID3D11Device* device, size_t maxParticles);
+
+        ParticleSystem(ParticleSystem&& moveFrom) noexcept;
+        ParticleSystem& operator= (ParticleSystem&& moveFrom) noexcept;
+
+        ParticleSystem(ParticleSystem const&) = delete;
+        ParticleSystem& operator= (ParticleSystem const&) = delete;
+
+        virtual ~ParticleSystem() override;
+
+        // IEffect methods. No input layout is needed; Draw binds none.
+        void __cdecl Apply(_In_ ID3D11DeviceContext* deviceContext) override;
+
+        void __cdecl GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength) override;
+
+        // Camera settings.
+        void XM_CALLCONV SetWorld(FXMMATRIX value) override;
+        void XM_CALLCONV SetView(FXMMATRIX value) override;
+        void XM_CALLCONV SetProjection(FXMMATRIX value) override;
+        void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+
+        // Emitter settings. Positions and velocities are in emitter space; variance is the half extent of the box
+        // that each new particle's value is picked from.
+        void XM_CALLCONV SetEmitterPosition(FXMVECTOR position, FXMVECTOR variance = g_XMZero);
+        void XM_CALLCONV SetVelocity(FXMVECTOR velocity, FXMVECTOR variance = g_XMZero);
+        void __cdecl SetLifetime(float minSeconds, float maxSeconds);
+        void __cdecl SetEmissionRate(float particlesPerSecond);
+
+        // Simulation settings. Acceleration is in world space, and drag is the fraction of velocity lost per second.
+        void XM_CALLCONV SetAcceleration(FXMVECTOR value);
+        void __cdecl SetDrag(float value);
+
+        // Appearance settings. Size is the world space width of each quad.
+        void __cdecl SetSize(float startSize, float endSize);
+        void XM_CALLCONV SetColors(FXMVECTOR startColor, FXMVECTOR endColor);
+        void __cdecl SetTexture(_In_opt_ ID3D11ShaderResourceView* value);
+
+        // Emits count particles at the next Update, on top of the emission rate. Particles beyond the free capacity
+        // are dropped on the GPU.
+        void __cdecl Emit(size_t count);
+
+        // Emits, ages, moves, and compacts the particles on the GPU.
+        void __cdecl Update(_In_ ID3D11DeviceContext* deviceContext, float elapsedTime);
+
+        // Applies the effect and draws the live particles.
+        void __cdecl Draw(_In_ ID3D11DeviceContext* deviceContext);
+
+        // Kills every particle at the next Update.
+        void __cdecl Reset() noexcept;
+
+        size_t __cdecl GetMaxParticles() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
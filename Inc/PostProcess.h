@@ -75,6 +75,13 @@ namespace DirectX
         // Shader control
         void __cdecl SetEffect(Effect fx);
 
+        Effect __cdecl GetEffect() const noexcept;
+
+        // Runs DownScale_2x2/4x4, GaussianBlur_5x5 and BloomBlur as compute shaders if the bound render target
+        // was created with D3D11_BIND_UNORDERED_ACCESS, the blurs also needing it to match the source size.
+        // Otherwise, and below Feature Level 11.0, the pixel shader is used. The compute path fills the whole target.
+        void __cdecl SetUseCompute(bool value = true);
+
         // Properties
         void __cdecl SetSourceTexture(_In_opt_ ID3D11ShaderResourceView* value);
 
@@ -193,6 +200,76 @@ namespace DirectX
         // Sets ST.2084 parameter for how bright white should be in nits
         void SetST2084Parameter(float paperWhiteNits);
 
+        // Works out the exposure each frame from a luminance histogram of the HDR source, built and adapted on the
+        // GPU so nothing is read back. SetExposure becomes exposure compensation. Ignored below Feature Level 11.0.
+        void __cdecl SetAutoExposure(bool value = true);
+
+        // Sets the log2 luminance range of the histogram, how quickly exposure adapts, and the luminance the
+        // scene average is mapped to
+        void __cdecl SetAutoExposureParameters(float minLogLuminance, float maxLogLuminance, float adaptationRate, float targetLuminance = 0.18f);
+
+        // Sets the time in seconds since the last Process, for auto-exposure adaptation
+        void __cdecl SetElapsedTime(float seconds);
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Runs a list of post-process passes, rendering intermediates into pooled targets
+    class PostProcessChain : public IPostProcess
+    {
+    public:
+        enum Input : unsigned int
+        {
+            Input_Source = 0xFFFFFFFF,  // The texture given to SetSourceTexture
+            Input_None = 0xFFFFFFFE,
+        };
+
+        enum Scale                      // Size of a pass's output
+        {
+            Scale_Auto,                 // Picked from the effect and the size of its input
+            Scale_Full,                 // Relative to the source texture
+            Scale_Half,
+            Scale_Quarter,
+            Scale_Max
+        };
+
+        struct Pass
+        {
+            IPostProcess*   effect;     // A BasicPostProcess, DualPostProcess or ToneMapPostProcess, not owned
+            unsigned int    input;      // Index of an earlier pass, or Input_Source
+            unsigned int    input2;     // Second input for a DualPostProcess, otherwise Input_None
+            Scale           scale;      // Ignored for the last pass, which fills the render target
+            DXGI_FORMAT     format;     // DXGI_FORMAT_UNKNOWN to use the format of the first input
+        };
+
+        PostProcessChain(_In_ ID3D11Device* device, _In_reads_(count) const Pass* passes, size_t count);
+        PostProcessChain(PostProcessChain&& moveFrom) noexcept;
+        PostProcessChain& operator= (PostProcessChain&& moveFrom) noexcept;
+
+        PostProcessChain(PostProcessChain const&) = delete;
+        PostProcessChain& operator= (PostProcessChain const&) = delete;
+
+        virtual ~PostProcessChain() override;
+
+        // IPostProcess methods. The custom state callback is run for every pass.
+        void __cdecl Process(_In_ ID3D11DeviceContext* deviceContext, _In_opt_ std::function<void __cdecl()> setCustomState = nullptr) override;
+
+        // Properties
+        void __cdecl SetSourceTexture(_In_opt_ ID3D11ShaderResourceView* value);
+        void __cdecl SetRenderTarget(_In_opt_ ID3D11RenderTargetView* value);
+
+        // Releases the pooled intermediate targets; they are created again as needed.
+        void __cdecl ReleaseTargets() noexcept;
+
+        size_t __cdecl GetTargetCount() const noexcept;
+        size_t __cdecl GetTargetMemory() const noexcept;
+
     private:
         // Private implementation.
         class Impl;
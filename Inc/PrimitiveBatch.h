@@ -22,13 +22,60 @@
 
 namespace DirectX
 {
+    enum PRIMITIVE_BATCH_FLAGS : uint32_t
+    {
+        PRIMITIVE_BATCH_DEFAULT     = 0,
+
+        // Batches use 32-bit indices, so an indexed batch is not limited to 65536 vertices (requires Feature Level 9.2).
+        PRIMITIVE_BATCH_INDEX32     = 0x1,
+
+        // Draws are staged in memory that grows as needed, and each batch is uploaded through GraphicsMemory when it is
+        // flushed. A batch then only ends on a topology change, End, or after 2MB of data, rather than whenever the
+        // fixed-size buffers fill; maxIndices and maxVertices just set the initial reservation.
+        PRIMITIVE_BATCH_GROWABLE    = 0x2,
+    };
+
     namespace Internal
     {
+        // Base class, not to be used directly: clients should access this via the derived PrimitiveRecorder<T>.
+        class PrimitiveRecorderBase
+        {
+        protected:
+            explicit PrimitiveRecorderBase(size_t vertexSize);
+            PrimitiveRecorderBase(PrimitiveRecorderBase&& moveFrom) noexcept;
+            PrimitiveRecorderBase& operator= (PrimitiveRecorderBase&& moveFrom) noexcept;
+
+            PrimitiveRecorderBase(PrimitiveRecorderBase const&) = delete;
+            PrimitiveRecorderBase& operator= (PrimitiveRecorderBase const&) = delete;
+
+            virtual ~PrimitiveRecorderBase();
+
+        public:
+            // Discard everything recorded, keeping the memory for reuse.
+            void __cdecl Clear() noexcept;
+
+            bool __cdecl IsEmpty() const noexcept;
+
+        protected:
+            // Internal, untyped recording methods.
+            void __cdecl Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) uint16_t const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+            void __cdecl Draw(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(indexCount) uint32_t const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+
+        private:
+            friend class PrimitiveBatchBase;
+
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+
+
         // Base class, not to be used directly: clients should access this via the derived PrimitiveBatch<T>.
         class PrimitiveBatchBase
         {
         protected:
-            PrimitiveBatchBase(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize);
+            PrimitiveBatchBase(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize, uint32_t flags);
             PrimitiveBatchBase(PrimitiveBatchBase&& moveFrom) noexcept;
             PrimitiveBatchBase& operator= (PrimitiveBatchBase&& moveFrom) noexcept;
 
@@ -45,6 +92,10 @@ namespace DirectX
         protected:
             // Internal, untyped drawing method.
             void __cdecl Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) uint16_t const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+            void __cdecl Draw(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(indexCount) uint32_t const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+
+            // Internal, untyped merge of a recorder.
+            void __cdecl Submit(PrimitiveRecorderBase const& recorder);
 
         private:
             // Private implementation.
@@ -55,6 +106,95 @@ namespace DirectX
     }
 
 
+    // Records primitives for a later PrimitiveBatch::Submit, with no device access or locking, so each job system
+    // worker can fill its own recorder. Recording is grouped by topology, and only list topologies are supported.
+    template<typename TVertex>
+    class PrimitiveRecorder : public Internal::PrimitiveRecorderBase
+    {
+    public:
+        PrimitiveRecorder()
+            : PrimitiveRecorderBase(sizeof(TVertex))
+        { }
+
+        PrimitiveRecorder(PrimitiveRecorder&& moveFrom) noexcept
+            : PrimitiveRecorderBase(std::move(moveFrom))
+        { }
+
+        PrimitiveRecorder& operator= (PrimitiveRecorder&& moveFrom) noexcept
+        {
+            PrimitiveRecorderBase::operator=(std::move(moveFrom));
+            return *this;
+        }
+
+
+        void Draw(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(vertexCount) TVertex const* vertices, size_t vertexCount)
+        {
+            void* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(topology, false, nullptr, 0, vertexCount, &mappedVertices);
+
+            memcpy(mappedVertices, vertices, vertexCount * sizeof(TVertex));
+        }
+
+
+        void DrawIndexed(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(indexCount) uint16_t const* indices, size_t indexCount, _In_reads_(vertexCount) TVertex const* vertices, size_t vertexCount)
+        {
+            void* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(topology, true, indices, indexCount, vertexCount, &mappedVertices);
+
+            memcpy(mappedVertices, vertices, vertexCount * sizeof(TVertex));
+        }
+
+        void DrawIndexed(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(indexCount) uint32_t const* indices, size_t indexCount, _In_reads_(vertexCount) TVertex const* vertices, size_t vertexCount)
+        {
+            void* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(topology, indices, indexCount, vertexCount, &mappedVertices);
+
+            memcpy(mappedVertices, vertices, vertexCount * sizeof(TVertex));
+        }
+
+
+        void DrawLine(TVertex const& v1, TVertex const& v2)
+        {
+            TVertex* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(D3D11_PRIMITIVE_TOPOLOGY_LINELIST, false, nullptr, 0, 2, reinterpret_cast<void**>(&mappedVertices));
+
+            mappedVertices[0] = v1;
+            mappedVertices[1] = v2;
+        }
+
+
+        void DrawTriangle(TVertex const& v1, TVertex const& v2, TVertex const& v3)
+        {
+            TVertex* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, false, nullptr, 0, 3, reinterpret_cast<void**>(&mappedVertices));
+
+            mappedVertices[0] = v1;
+            mappedVertices[1] = v2;
+            mappedVertices[2] = v3;
+        }
+
+
+        void DrawQuad(TVertex const& v1, TVertex const& v2, TVertex const& v3, TVertex const& v4)
+        {
+            static const uint16_t quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+            TVertex* mappedVertices;
+
+            PrimitiveRecorderBase::Draw(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, true, quadIndices, 6, 4, reinterpret_cast<void**>(&mappedVertices));
+
+            mappedVertices[0] = v1;
+            mappedVertices[1] = v2;
+            mappedVertices[2] = v3;
+            mappedVertices[3] = v4;
+        }
+    };
+
+
     // Template makes the API typesafe, eg. PrimitiveBatch<VertexPositionColor>.
     template<typename TVertex>
     class PrimitiveBatch : public Internal::PrimitiveBatchBase
@@ -62,8 +202,8 @@ namespace DirectX
         static const size_t DefaultBatchSize = 2048;
 
     public:
-        explicit PrimitiveBatch(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices = DefaultBatchSize * 3, size_t maxVertices = DefaultBatchSize)
-            : PrimitiveBatchBase(deviceContext, maxIndices, maxVertices, sizeof(TVertex))
+        explicit PrimitiveBatch(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices = DefaultBatchSize * 3, size_t maxVertices = DefaultBatchSize, uint32_t flags = PRIMITIVE_BATCH_DEFAULT)
+            : PrimitiveBatchBase(deviceContext, maxIndices, maxVertices, sizeof(TVertex), flags)
         { }
 
         PrimitiveBatch(PrimitiveBatch&& moveFrom) noexcept
@@ -98,6 +238,24 @@ namespace DirectX
             memcpy(mappedVertices, vertices, vertexCount * sizeof(TVertex));
         }
 
+        // On a batch with 16-bit indices, throws std::out_of_range for any index above 0xFFFF.
+        void DrawIndexed(D3D11_PRIMITIVE_TOPOLOGY topology, _In_reads_(indexCount) uint32_t const* indices, size_t indexCount, _In_reads_(vertexCount) TVertex const* vertices, size_t vertexCount)
+        {
+            void* mappedVertices;
+
+            PrimitiveBatchBase::Draw(topology, indices, indexCount, vertexCount, &mappedVertices);
+
+            memcpy(mappedVertices, vertices, vertexCount * sizeof(TVertex));
+        }
+
+
+        // Queues a recorder to be drawn at End, when everything submitted is merged by topology into as few draws as the
+        // batch buffers allow. The recorder must be left unchanged until End returns.
+        void Submit(PrimitiveRecorder<TVertex> const& recorder)
+        {
+            PrimitiveBatchBase::Submit(recorder);
+        }
+
 
         void DrawLine(TVertex const& v1, TVertex const& v2)
         {
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// File: ScreenGrabQueue.h
+//
+// Captures 2D textures every frame without stalling on the GPU, writing them on a
+// background thread
+//
+// Note: Assumes application has already called CoInitializeEx
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <functional>
+#include <memory>
+
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Each capture copies the top level of its source into one of a ring of reused staging textures. Update polls the
+    // ring with D3D11_MAP_FLAG_DO_NOT_WAIT, copies finished captures out to memory owned by the ring slot, and hands
+    // them to a worker thread that writes the file or runs the callback. A slot is reused once the worker is done with
+    // it, so memory stays bounded; a capture made while every slot is busy is dropped and counted.
+    //
+    // Capture, Update and Flush use the device context, so call them from the thread that owns it.
+    class ScreenGrabQueue
+    {
+    public:
+        // A completed capture, passed to Capture callbacks. The pixels are only valid during the call.
+        struct Frame
+        {
+            uint64_t        frameNumber;
+            DXGI_FORMAT     format;
+            UINT            width;
+            UINT            height;
+            size_t          rowPitch;
+            const uint8_t*  pixels;
+        };
+
+        // Called on the worker thread, in capture order. It must not throw.
+        typedef std::function<void __cdecl(const Frame& frame)> Callback;
+
+        explicit ScreenGrabQueue(_In_ ID3D11Device* device, size_t ringSize = 3);
+
+        ScreenGrabQueue(ScreenGrabQueue&& moveFrom) noexcept;
+        ScreenGrabQueue& operator= (ScreenGrabQueue&& moveFrom) noexcept;
+
+        ScreenGrabQueue(ScreenGrabQueue const&) = delete;
+        ScreenGrabQueue& operator= (ScreenGrabQueue const&) = delete;
+
+        // Finishes captures already handed to the worker. Call Flush first to also keep those still on the GPU.
+        virtual ~ScreenGrabQueue();
+
+        // Each returns false if the capture was dropped because the ring was full.
+        bool __cdecl CaptureDDS(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source, _In_z_ const wchar_t* fileName);
+        bool __cdecl CaptureWIC(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source,
+                                _In_ REFGUID guidContainerFormat, _In_z_ const wchar_t* fileName,
+                                _In_opt_ const GUID* targetFormat = nullptr, bool forceSRGB = false);
+        bool __cdecl Capture(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source, Callback callback);
+
+        // Passes captures the GPU has finished to the worker thread. Call once a frame.
+        void __cdecl Update(_In_ ID3D11DeviceContext* context);
+
+        // Blocks until every capture so far has been written.
+        void __cdecl Flush(_In_ ID3D11DeviceContext* context);
+
+        // Captures either waiting on the GPU or being written.
+        size_t __cdecl GetPendingCount() const noexcept;
+
+        uint64_t __cdecl GetDroppedCount() const noexcept;
+
+        size_t __cdecl GetRingSize() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
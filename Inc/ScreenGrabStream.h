@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------------
+// File: ScreenGrabStream.h
+//
+// Records a sequence of 2D textures to a single YUV video file
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <memory>
+
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // A compute shader converts each frame to 4:2:0 YUV (BT.709, studio range), so only 12 bits a pixel are read
+    // back instead of 32. Readback goes through a ring of staging buffers polled with D3D11_MAP_FLAG_DO_NOT_WAIT,
+    // and a worker thread writes frames in order straight out of the mapped buffers. Memory use is fixed by the ring
+    // size; frames added while every buffer is busy are dropped and counted.
+    //
+    // Requires Feature Level 11.0. Width and height must be even. AddFrame, Update, Flush and Close use the device
+    // context, so call them from the thread that owns it.
+    class ScreenGrabStream
+    {
+    public:
+        enum Container : unsigned int
+        {
+            Y4M,        // YUV4MPEG2 with planar 4:2:0 frames, which most video tools read directly
+            RawNV12,    // NV12 frames back to back, with no header
+        };
+
+        ScreenGrabStream(_In_ ID3D11Device* device, _In_z_ const wchar_t* fileName, UINT width, UINT height,
+                         Container container = Y4M, UINT frameRate = 60, size_t ringSize = 4);
+
+        ScreenGrabStream(ScreenGrabStream&& moveFrom) noexcept;
+        ScreenGrabStream& operator= (ScreenGrabStream&& moveFrom) noexcept;
+
+        ScreenGrabStream(ScreenGrabStream const&) = delete;
+        ScreenGrabStream& operator= (ScreenGrabStream const&) = delete;
+
+        // Writes frames already handed to the worker and closes the file. Call Close first to keep the rest.
+        virtual ~ScreenGrabStream();
+
+        // Converts the top level of source, which must be width x height. Returns false if the frame was dropped.
+        bool __cdecl AddFrame(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source);
+
+        // Hands converted frames to the worker and recycles the buffers it has written. Call once a frame.
+        void __cdecl Update(_In_ ID3D11DeviceContext* context);
+
+        // Blocks until every frame added so far has been written.
+        void __cdecl Flush(_In_ ID3D11DeviceContext* context);
+
+        // Flushes and closes the file. No more frames can be added.
+        void __cdecl Close(_In_ ID3D11DeviceContext* context);
+
+        uint64_t __cdecl GetFrameCount() const noexcept;
+        uint64_t __cdecl GetDroppedCount() const noexcept;
+        size_t __cdecl GetPendingCount() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
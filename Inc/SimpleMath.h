@@ -318,6 +318,9 @@ namespace DirectX
             static Vector3 TransformNormal(const Vector3& v, const Matrix& m) noexcept;
             static void TransformNormal(_In_reads_(count) const Vector3* varray, size_t count, const Matrix& m, _Out_writes_(count) Vector3* resultArray) noexcept;
 
+            static void Normalize(_In_reads_(count) const Vector3* varray, size_t count, _Out_writes_(count) Vector3* resultArray) noexcept;
+            static void Dot(_In_reads_(count) const Vector3* varray, size_t count, const Vector3& v, _Out_writes_(count) float* resultArray) noexcept;
+
             // Constants
             static const Vector3 Zero;
             static const Vector3 One;
@@ -437,6 +440,9 @@ namespace DirectX
             static Vector4 Transform(const Vector4& v, const Matrix& m) noexcept;
             static void Transform(_In_reads_(count) const Vector4* varray, size_t count, const Matrix& m, _Out_writes_(count) Vector4* resultArray) noexcept;
 
+            static void Normalize(_In_reads_(count) const Vector4* varray, size_t count, _Out_writes_(count) Vector4* resultArray) noexcept;
+            static void Dot(_In_reads_(count) const Vector4* varray, size_t count, const Vector4& v, _Out_writes_(count) float* resultArray) noexcept;
+
             // Constants
             static const Vector4 Zero;
             static const Vector4 One;
@@ -594,6 +600,12 @@ namespace DirectX
             static void Transform(const Matrix& M, const Quaternion& rotation, Matrix& result) noexcept;
             static Matrix Transform(const Matrix& M, const Quaternion& rotation) noexcept;
 
+            static void Multiply(_In_reads_(count) const Matrix* marray, size_t count, const Matrix& M, _Out_writes_(count) Matrix* resultArray) noexcept;
+                // resultArray[i] = marray[i] * M
+
+            static void Transform(_In_reads_(count) const BoundingBox* boxArray, size_t count, const Matrix& M, _Out_writes_(count) BoundingBox* resultArray) noexcept;
+                // Matrix must be affine; gives the same boxes as BoundingBox::Transform without transforming the corners
+
             // Constants
             static const Matrix Identity;
         };
@@ -661,6 +673,11 @@ namespace DirectX
             static void Transform(const Plane& plane, const Quaternion& rotation, Plane& result) noexcept;
             static Plane Transform(const Plane& plane, const Quaternion& rotation) noexcept;
                 // Input quaternion must be the inverse transpose of the transformation
+
+            static size_t CullSpheres(_In_reads_(planeCount) const Plane* planes, size_t planeCount,
+                _In_reads_(count) const BoundingSphere* spheres, size_t count, _Out_writes_to_(count, return) uint32_t* visibleIndices) noexcept;
+                // Planes must be normalized and face out of the volume (as from BoundingFrustum::GetPlanes); returns the
+                // number of spheres not entirely outside any plane, writing their indices in ascending order
         };
 
         //------------------------------------------------------------------------------
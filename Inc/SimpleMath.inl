@@ -1304,6 +1304,62 @@ inline void Vector3::TransformNormal(const Vector3* varray, size_t count, const
     XMVector3TransformNormalStream(resultArray, sizeof(XMFLOAT3), varray, sizeof(XMFLOAT3), count, M);
 }
 
+inline void Vector3::Normalize(const Vector3* varray, size_t count, Vector3* resultArray) noexcept
+{
+    using namespace DirectX;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Transpose to x, y, z rows so a single sqrt and divide serve four vectors
+        XMMATRIX V(XMLoadFloat3(&varray[i]), XMLoadFloat3(&varray[i + 1]), XMLoadFloat3(&varray[i + 2]), XMLoadFloat3(&varray[i + 3]));
+        V = XMMatrixTranspose(V);
+
+        XMVECTOR length = XMVectorSqrt(XMVectorMultiplyAdd(V.r[0], V.r[0], XMVectorMultiplyAdd(V.r[1], V.r[1], XMVectorMultiply(V.r[2], V.r[2]))));
+        XMVECTOR scale = XMVectorSelect(XMVectorReciprocal(length), XMVectorZero(), XMVectorEqual(length, XMVectorZero()));
+
+        V.r[0] = XMVectorMultiply(V.r[0], scale);
+        V.r[1] = XMVectorMultiply(V.r[1], scale);
+        V.r[2] = XMVectorMultiply(V.r[2], scale);
+        V = XMMatrixTranspose(V);
+
+        XMStoreFloat3(&resultArray[i], V.r[0]);
+        XMStoreFloat3(&resultArray[i + 1], V.r[1]);
+        XMStoreFloat3(&resultArray[i + 2], V.r[2]);
+        XMStoreFloat3(&resultArray[i + 3], V.r[3]);
+    }
+
+    for (; i < count; ++i)
+    {
+        XMVECTOR v1 = XMLoadFloat3(&varray[i]);
+        XMStoreFloat3(&resultArray[i], XMVector3Normalize(v1));
+    }
+}
+
+inline void Vector3::Dot(const Vector3* varray, size_t count, const Vector3& v, float* resultArray) noexcept
+{
+    using namespace DirectX;
+    XMVECTOR v2 = XMLoadFloat3(&v);
+    XMVECTOR vx = XMVectorSplatX(v2);
+    XMVECTOR vy = XMVectorSplatY(v2);
+    XMVECTOR vz = XMVectorSplatZ(v2);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        XMMATRIX V(XMLoadFloat3(&varray[i]), XMLoadFloat3(&varray[i + 1]), XMLoadFloat3(&varray[i + 2]), XMLoadFloat3(&varray[i + 3]));
+        V = XMMatrixTranspose(V);
+
+        XMVECTOR X = XMVectorMultiplyAdd(V.r[0], vx, XMVectorMultiplyAdd(V.r[1], vy, XMVectorMultiply(V.r[2], vz)));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&resultArray[i]), X);
+    }
+
+    for (; i < count; ++i)
+    {
+        XMVECTOR v1 = XMLoadFloat3(&varray[i]);
+        resultArray[i] = XMVectorGetX(XMVector3Dot(v1, v2));
+    }
+}
+
 
 /****************************************************************************
  *
@@ -1897,6 +1953,57 @@ inline void Vector4::Transform(const Vector4* varray, size_t count, const Matrix
     XMVector4TransformStream(resultArray, sizeof(XMFLOAT4), varray, sizeof(XMFLOAT4), count, M);
 }
 
+inline void Vector4::Normalize(const Vector4* varray, size_t count, Vector4* resultArray) noexcept
+{
+    using namespace DirectX;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        XMMATRIX V = XMMatrixTranspose(XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&varray[i])));
+
+        XMVECTOR lengthSq = XMVectorMultiplyAdd(V.r[0], V.r[0], XMVectorMultiplyAdd(V.r[1], V.r[1], XMVectorMultiplyAdd(V.r[2], V.r[2], XMVectorMultiply(V.r[3], V.r[3]))));
+        XMVECTOR length = XMVectorSqrt(lengthSq);
+        XMVECTOR scale = XMVectorSelect(XMVectorReciprocal(length), XMVectorZero(), XMVectorEqual(length, XMVectorZero()));
+
+        V.r[0] = XMVectorMultiply(V.r[0], scale);
+        V.r[1] = XMVectorMultiply(V.r[1], scale);
+        V.r[2] = XMVectorMultiply(V.r[2], scale);
+        V.r[3] = XMVectorMultiply(V.r[3], scale);
+        XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(&resultArray[i]), XMMatrixTranspose(V));
+    }
+
+    for (; i < count; ++i)
+    {
+        XMVECTOR v1 = XMLoadFloat4(&varray[i]);
+        XMStoreFloat4(&resultArray[i], XMVector4Normalize(v1));
+    }
+}
+
+inline void Vector4::Dot(const Vector4* varray, size_t count, const Vector4& v, float* resultArray) noexcept
+{
+    using namespace DirectX;
+    XMVECTOR v2 = XMLoadFloat4(&v);
+    XMVECTOR vx = XMVectorSplatX(v2);
+    XMVECTOR vy = XMVectorSplatY(v2);
+    XMVECTOR vz = XMVectorSplatZ(v2);
+    XMVECTOR vw = XMVectorSplatW(v2);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        XMMATRIX V = XMMatrixTranspose(XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&varray[i])));
+
+        XMVECTOR X = XMVectorMultiplyAdd(V.r[0], vx, XMVectorMultiplyAdd(V.r[1], vy, XMVectorMultiplyAdd(V.r[2], vz, XMVectorMultiply(V.r[3], vw))));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&resultArray[i]), X);
+    }
+
+    for (; i < count; ++i)
+    {
+        XMVECTOR v1 = XMLoadFloat4(&varray[i]);
+        resultArray[i] = XMVectorGetX(XMVector4Dot(v1, v2));
+    }
+}
+
 
 /****************************************************************************
  *
@@ -2741,6 +2848,38 @@ inline Matrix Matrix::Transform(const Matrix& M, const Quaternion& rotation) noe
     return result;
 }
 
+inline void Matrix::Multiply(const Matrix* marray, size_t count, const Matrix& M, Matrix* resultArray) noexcept
+{
+    using namespace DirectX;
+    XMMATRIX M1 = XMLoadFloat4x4(&M);
+    for (size_t i = 0; i < count; ++i)
+    {
+        XMMATRIX M0 = XMLoadFloat4x4(&marray[i]);
+        XMStoreFloat4x4(&resultArray[i], XMMatrixMultiply(M0, M1));
+    }
+}
+
+inline void Matrix::Transform(const BoundingBox* boxArray, size_t count, const Matrix& M, BoundingBox* resultArray) noexcept
+{
+    using namespace DirectX;
+    XMMATRIX M0 = XMLoadFloat4x4(&M);
+
+    // The new extents are the old ones projected onto the absolute values of the basis rows
+    XMVECTOR a0 = XMVectorAbs(M0.r[0]);
+    XMVECTOR a1 = XMVectorAbs(M0.r[1]);
+    XMVECTOR a2 = XMVectorAbs(M0.r[2]);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        XMVECTOR center = XMLoadFloat3(&boxArray[i].Center);
+        XMVECTOR extents = XMLoadFloat3(&boxArray[i].Extents);
+
+        XMVECTOR X = XMVectorMultiplyAdd(XMVectorSplatX(extents), a0, XMVectorMultiplyAdd(XMVectorSplatY(extents), a1, XMVectorMultiply(XMVectorSplatZ(extents), a2)));
+        XMStoreFloat3(&resultArray[i].Center, XMVector3Transform(center, M0));
+        XMStoreFloat3(&resultArray[i].Extents, X);
+    }
+}
+
 
 /****************************************************************************
  *
@@ -2873,6 +3012,56 @@ inline Plane Plane::Transform(const Plane& plane, const Quaternion& rotation) no
     return result;
 }
 
+inline size_t Plane::CullSpheres(const Plane* planes, size_t planeCount, const BoundingSphere* spheres, size_t count, uint32_t* visibleIndices) noexcept
+{
+    using namespace DirectX;
+    static_assert(sizeof(BoundingSphere) == sizeof(XMFLOAT4), "CullSpheres loads Center and Radius as one vector");
+
+    size_t visible = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Transpose to cx, cy, cz, radius rows and test four spheres against each plane at once
+        XMMATRIX S = XMMatrixTranspose(XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&spheres[i])));
+
+        XMVECTOR outside = XMVectorFalseInt();
+        for (size_t p = 0; p < planeCount; ++p)
+        {
+            XMVECTOR P = XMLoadFloat4(&planes[p]);
+            XMVECTOR dist = XMVectorMultiplyAdd(S.r[0], XMVectorSplatX(P),
+                XMVectorMultiplyAdd(S.r[1], XMVectorSplatY(P),
+                    XMVectorMultiplyAdd(S.r[2], XMVectorSplatZ(P), XMVectorSplatW(P))));
+            outside = XMVectorOrInt(outside, XMVectorGreater(dist, S.r[3]));
+        }
+
+        uint32_t lanes[4];
+        XMStoreInt4(lanes, outside);
+        for (size_t j = 0; j < 4; ++j)
+        {
+            if (!lanes[j])
+                visibleIndices[visible++] = static_cast<uint32_t>(i + j);
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        XMVECTOR center = XMLoadFloat3(&spheres[i].Center);
+        XMVECTOR radius = XMVectorReplicate(spheres[i].Radius);
+
+        bool culled = false;
+        for (size_t p = 0; p < planeCount && !culled; ++p)
+        {
+            XMVECTOR P = XMLoadFloat4(&planes[p]);
+            culled = XMVector4Greater(XMPlaneDotCoord(P, center), radius);
+        }
+
+        if (!culled)
+            visibleIndices[visible++] = static_cast<uint32_t>(i);
+    }
+
+    return visible;
+}
+
 
 /****************************************************************************
  *
@@ -43,10 +43,74 @@ namespace DirectX
     };
 
 
+    enum SPRITEBATCH_FLAGS : uint32_t
+    {
+        SpriteBatch_Default     = 0x0,
+
+        // Expand sprite corners in the vertex shader from one instance record per sprite (requires Feature Level 10.0 or later)
+        SpriteBatch_Instancing  = 0x1,
+    };
+
+    inline SPRITEBATCH_FLAGS operator|(SPRITEBATCH_FLAGS a, SPRITEBATCH_FLAGS b) noexcept { return static_cast<SPRITEBATCH_FLAGS>( static_cast<int>(a) | static_cast<int>(b) ); }
+
+
+    enum SpriteDistanceField : uint32_t
+    {
+        SpriteDistanceField_None = 0,
+        SpriteDistanceField_SingleChannel,      // Signed distance in the alpha channel
+        SpriteDistanceField_MultiChannel,       // Median of the RGB channels (MSDF)
+    };
+
+
+    // How SpriteBatch shades distance-field sprites such as SpriteFont glyphs. Distances, widths and softness are
+    // fractions of the field's range; colors are premultiplied like sprite colors, and transparent ones disable
+    // the outline or shadow. SpriteFont::GetDistanceFieldSettings fills in the type and range for a font.
+    struct SpriteDistanceFieldSettings
+    {
+        SpriteDistanceField type;
+        float distanceRange;        // Spread of the field in texels, edge to either extreme and back
+        float weight;               // Moves the edge outward (bolder) or inward (thinner)
+        float outlineWidth;
+        XMFLOAT4 outlineColor;
+        XMFLOAT2 shadowOffset;      // In texels of the sprite sheet
+        float shadowSoftness;       // 0 is a hard shadow
+        XMFLOAT4 shadowColor;
+    };
+
+
+    // Retained set of sprites recorded through SpriteBatch::BeginRecording/EndRecording. The sprites
+    // are sorted and baked into a GPU vertex buffer once, then drawn many times by SpriteBatch::Draw.
+    class SpriteList
+    {
+    public:
+        SpriteList(SpriteList&& moveFrom) noexcept;
+        SpriteList& operator= (SpriteList&& moveFrom) noexcept;
+
+        SpriteList(SpriteList const&) = delete;
+        SpriteList& operator= (SpriteList const&) = delete;
+
+        virtual ~SpriteList();
+
+        size_t __cdecl GetSpriteCount() const noexcept;
+        size_t __cdecl GetBatchCount() const noexcept;
+        bool __cdecl IsUpdatable() const noexcept;
+
+    private:
+        friend class SpriteBatch;
+
+        // Private implementation.
+        class Impl;
+
+        explicit SpriteList(std::unique_ptr<Impl> impl) noexcept;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+
+
     class SpriteBatch
     {
     public:
-        explicit SpriteBatch(_In_ ID3D11DeviceContext* deviceContext);
+        explicit SpriteBatch(_In_ ID3D11DeviceContext* deviceContext, SPRITEBATCH_FLAGS flags = SpriteBatch_Default);
         SpriteBatch(SpriteBatch&& moveFrom) noexcept;
         SpriteBatch& operator= (SpriteBatch&& moveFrom) noexcept;
 
@@ -74,6 +138,24 @@ namespace DirectX
         void XM_CALLCONV Draw(_In_ ID3D11ShaderResourceView* texture, RECT const& destinationRectangle, FXMVECTOR color = Colors::White);
         void XM_CALLCONV Draw(_In_ ID3D11ShaderResourceView* texture, RECT const& destinationRectangle, _In_opt_ RECT const* sourceRectangle, FXMVECTOR color = Colors::White, float rotation = 0, XMFLOAT2 const& origin = Float2Zero, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0);
 
+        // Draw overloads taking one slice of a Texture2DArray (requires Feature Level 10.0 or later). Sprites that share
+        // a texture array are batched together whatever their slice, so an array of atlas pages draws in one call.
+        void XM_CALLCONV Draw(_In_ ID3D11ShaderResourceView* textureArray, UINT arraySlice, XMFLOAT2 const& position, _In_opt_ RECT const* sourceRectangle, FXMVECTOR color = Colors::White, float rotation = 0, XMFLOAT2 const& origin = Float2Zero, float scale = 1, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0);
+        void XM_CALLCONV Draw(_In_ ID3D11ShaderResourceView* textureArray, UINT arraySlice, RECT const& destinationRectangle, _In_opt_ RECT const* sourceRectangle, FXMVECTOR color = Colors::White, float rotation = 0, XMFLOAT2 const& origin = Float2Zero, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0);
+
+        // Draw a retained sprite list, transformed by the given matrix ahead of the Begin transform. Sprites
+        // already queued are drawn first; the list is not sorted along with the sprites queued in this batch.
+        void XM_CALLCONV Draw(SpriteList const& spriteList, FXMMATRIX transformMatrix = MatrixIdentity);
+
+        // Record Draw calls into a retained sprite list instead of drawing them. Sprites are sorted
+        // according to sortMode, which cannot be SpriteSortMode_Immediate.
+        void __cdecl BeginRecording(SpriteSortMode sortMode = SpriteSortMode_Deferred);
+        std::unique_ptr<SpriteList> __cdecl EndRecording(bool allowUpdates = false);
+
+        // Replace the sprites starting at firstSprite (in baked order) with the ones recorded since
+        // BeginRecording. The list must have been created with allowUpdates.
+        void __cdecl EndRecording(SpriteList& spriteList, size_t firstSprite);
+
         // Rotation mode to be applied to the sprite transformation
         void __cdecl SetRotation(DXGI_MODE_ROTATION mode);
         DXGI_MODE_ROTATION __cdecl GetRotation() const noexcept;
@@ -81,6 +163,36 @@ namespace DirectX
         // Set viewport for sprite transformation
         void __cdecl SetViewport(const D3D11_VIEWPORT& viewPort);
 
+        // Split vertex generation for large batches across worker threads. The scheduler must call
+        // processChunk once for every index in [0, chunkCount) and return when they have all finished.
+        // If no scheduler is given, the system thread pool is used. Output matches the serial path.
+        typedef std::function<void __cdecl(size_t chunkCount, std::function<void __cdecl(size_t chunkIndex)> const& processChunk)> TaskScheduler;
+
+        void __cdecl SetParallelVertexGeneration(bool enable, _In_opt_ TaskScheduler scheduler = nullptr);
+
+        // Draws following batches from distance fields instead of coverage (requires Feature Level 10.0 or later), so
+        // one sprite sheet stays sharp at any scale. Takes effect at the next Begin, until cleared with nullptr. Texture
+        // array sprites and setCustomShaders replacements are not affected.
+        void __cdecl SetDistanceField(_In_opt_ SpriteDistanceFieldSettings const* settings);
+
+        // Clips the sprites drawn from now on to a rectangle, in the same coordinates as their positions (ahead of the
+        // Begin transform), until cleared with nullptr. May be changed between Draw calls: each quad and its source
+        // region are trimmed on the CPU as it is queued, so sprites under different clip rectangles share batches, and
+        // those entirely outside are dropped at once. Rotated sprites are dropped if their bounds miss the rectangle,
+        // but are otherwise drawn whole.
+        void __cdecl SetClipRectangle(_In_opt_ RECT const* clipRectangle);
+
+        // Draws every following batch into up to MaxViews split-screen views with one instanced draw (requires Feature
+        // Level 10.0 or later, and cannot be combined with SpriteBatch_Instancing). Sprites of each view are positioned
+        // in pixels from the top left of its viewport, after the Begin transform and that view's viewTransform, and are
+        // clipped to the viewport; the viewports lie within the one bound while drawing, or set by SetViewport. Takes
+        // effect at the next Begin, until cleared with a count of 0. Texture array sprites cannot be drawn this way, and
+        // setCustomShaders replacements of the vertex shader must do their own placement from SV_InstanceID.
+        void __cdecl SetMultiView(size_t count, _In_reads_opt_(count) D3D11_VIEWPORT const* viewports,
+                                  _In_reads_opt_(count) XMMATRIX const* viewTransforms = nullptr);
+
+        static const size_t MaxViews = 4;
+
     private:
         // Private implementation.
         class Impl;
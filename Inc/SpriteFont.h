@@ -12,17 +12,27 @@
 #include "SpriteBatch.h"
 
 
+struct IDWriteFontFace;
+
+
 namespace DirectX
 {
     class SpriteFont
     {
     public:
         struct Glyph;
+        class TextLayout;
 
+        // Files written by MakeSpriteFont /FastLoad keep their glyph table and lookup index in place, in the mapped file
+        // or, when created from memory, in a copy of just those tables.
         SpriteFont(_In_ ID3D11Device* device, _In_z_ wchar_t const* fileName, bool forceSRGB = false);
         SpriteFont(_In_ ID3D11Device* device, _In_reads_bytes_(dataSize) uint8_t const* dataBlob, _In_ size_t dataSize, bool forceSRGB = false);
         SpriteFont(_In_ ID3D11ShaderResourceView* texture, _In_reads_(glyphCount) Glyph const* glyphs, _In_ size_t glyphCount, _In_ float lineSpacing);
 
+        // Dynamic font: glyphs are rasterized from the font face on a worker thread the first time they are drawn, into
+        // an atlasSize square texture that keeps the most recently drawn ones. fontSize is the em size in pixels.
+        SpriteFont(_In_ ID3D11Device* device, _In_ IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize = 1024);
+
         SpriteFont(SpriteFont&& moveFrom) noexcept;
         SpriteFont& operator= (SpriteFont&& moveFrom) noexcept;
 
@@ -53,6 +63,12 @@ namespace DirectX
         RECT __cdecl MeasureDrawBounds(_In_z_ char const* text, XMFLOAT2 const& position) const;
         RECT XM_CALLCONV MeasureDrawBounds(_In_z_ char const* text, FXMVECTOR position) const;
 
+        // Pre-shaped text
+        void XM_CALLCONV DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, XMFLOAT2 const& position, FXMVECTOR color = Colors::White, float rotation = 0, XMFLOAT2 const& origin = Float2Zero, float scale = 1, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0) const;
+        void XM_CALLCONV DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, XMFLOAT2 const& position, FXMVECTOR color, float rotation, XMFLOAT2 const& origin, XMFLOAT2 const& scale, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0) const;
+        void XM_CALLCONV DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, FXMVECTOR position, FXMVECTOR color = Colors::White, float rotation = 0, FXMVECTOR origin = g_XMZero, float scale = 1, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0) const;
+        void XM_CALLCONV DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, FXMVECTOR position, FXMVECTOR color, float rotation, FXMVECTOR origin, GXMVECTOR scale, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0) const;
+
         // Spacing properties
         float __cdecl GetLineSpacing() const noexcept;
         void __cdecl SetLineSpacing(float spacing);
@@ -63,10 +79,23 @@ namespace DirectX
 
         bool __cdecl ContainsCharacter(wchar_t character) const;
 
+        // Distance field sprite sheets, as written by MakeSpriteFont /DistanceField, must be drawn with
+        // SpriteBatch::SetDistanceField. Fonts without one report SpriteDistanceField_None.
+        SpriteDistanceField __cdecl GetDistanceFieldType() const noexcept;
+        float __cdecl GetDistanceFieldRange() const noexcept;
+        SpriteDistanceFieldSettings __cdecl GetDistanceFieldSettings() const noexcept;
+        void __cdecl SetDistanceField(SpriteDistanceField type, float distanceRange);
+
         // Custom layout/rendering
         Glyph const* __cdecl FindGlyph(wchar_t character) const;
         void __cdecl GetSpriteSheet(ID3D11ShaderResourceView** texture) const;
 
+        // Dynamic fonts. Update copies newly rasterized glyphs into the atlas; call it once a frame, outside any
+        // SpriteBatch Begin/End pair that draws with this font. Text is laid out straight away, but characters appear
+        // from the first frame after their glyphs are uploaded. Does nothing for other fonts.
+        bool __cdecl IsDynamic() const noexcept;
+        void __cdecl Update(_In_ ID3D11DeviceContext* deviceContext);
+
         // Describes a single character glyph.
         struct Glyph
         {
@@ -78,6 +107,40 @@ namespace DirectX
         };
 
 
+        // Glyph placement for a string, computed once so static text can be measured and drawn many times
+        // without looking up or converting characters. The font must outlive the layout, and the layout must be
+        // rebuilt if the font line spacing or default character changes.
+        class TextLayout
+        {
+        public:
+            TextLayout(SpriteFont const& font, _In_z_ wchar_t const* text);
+            TextLayout(SpriteFont const& font, _In_z_ char const* text);
+
+            TextLayout(TextLayout&& moveFrom) noexcept;
+            TextLayout& operator= (TextLayout&& moveFrom) noexcept;
+
+            TextLayout(TextLayout const&) = delete;
+            TextLayout& operator= (TextLayout const&) = delete;
+
+            virtual ~TextLayout();
+
+            XMVECTOR XM_CALLCONV Measure() const noexcept;
+
+            RECT __cdecl MeasureDrawBounds(XMFLOAT2 const& position) const noexcept;
+            RECT XM_CALLCONV MeasureDrawBounds(FXMVECTOR position) const noexcept;
+
+            size_t __cdecl GetGlyphCount() const noexcept;
+
+        private:
+            friend class SpriteFont;
+
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+
+
     private:
         // Private implementation.
         class Impl;
@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------------
+// File: TextureLoadQueue.h
+//
+// Loads many DDS and WIC textures in parallel on the system thread pool
+//
+// Note: Assumes application has already called CoInitializeEx
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <functional>
+#include <future>
+#include <memory>
+
+#include <stdint.h>
+
+#include <wrl\client.h>
+
+
+namespace DirectX
+{
+    struct TextureLoadResult
+    {
+        HRESULT hr;
+        Microsoft::WRL::ComPtr<ID3D11Resource> texture;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView;
+    };
+
+
+    // Each load reads, decodes, converts and resizes its image on a thread pool worker, then creates the texture on
+    // the device, which is free-threaded. At most maxConcurrency loads run at once (0 means one per hardware thread),
+    // and each of those slots has its own IWICImagingFactory. DDS data is recognized by its magic number, so the file
+    // extension does not matter.
+    //
+    // With generateMips, textures that would get auto-generated mipmaps from the loaders have their upload and
+    // GenerateMips recorded into a deferred context per slot instead, so workers never touch the immediate context.
+    // Those textures are returned empty; call ExecuteUploads on the render thread, for instance once a frame, to
+    // fill them.
+    class TextureLoadQueue
+    {
+    public:
+        // Called on the worker thread that finished the load. It must not throw.
+        typedef std::function<void __cdecl(const TextureLoadResult& result)> Callback;
+
+        explicit TextureLoadQueue(_In_ ID3D11Device* device, size_t maxConcurrency = 0, bool generateMips = false);
+
+        TextureLoadQueue(TextureLoadQueue&& moveFrom) noexcept;
+        TextureLoadQueue& operator= (TextureLoadQueue&& moveFrom) noexcept;
+
+        TextureLoadQueue(TextureLoadQueue const&) = delete;
+        TextureLoadQueue& operator= (TextureLoadQueue const&) = delete;
+
+        // Waits for loads already running; loads still queued complete with E_ABORT.
+        virtual ~TextureLoadQueue();
+
+        std::future<TextureLoadResult> __cdecl LoadFromFile(_In_z_ const wchar_t* fileName, size_t maxsize = 0, bool forceSRGB = false);
+        void __cdecl LoadFromFile(_In_z_ const wchar_t* fileName, Callback callback, size_t maxsize = 0, bool forceSRGB = false);
+
+        // The data must stay valid until the load completes.
+        std::future<TextureLoadResult> __cdecl LoadFromMemory(_In_reads_bytes_(dataSize) const uint8_t* data, size_t dataSize,
+                                                              size_t maxsize = 0, bool forceSRGB = false);
+        void __cdecl LoadFromMemory(_In_reads_bytes_(dataSize) const uint8_t* data, size_t dataSize, Callback callback,
+                                    size_t maxsize = 0, bool forceSRGB = false);
+
+        // Blocks until every load queued so far has completed.
+        void __cdecl WaitForAll();
+
+        // Runs the uploads and mipmap generation recorded by completed loads. Context state is preserved. Never
+        // blocks on a load in progress: slots still busy decoding are left for the next call.
+        void __cdecl ExecuteUploads(_In_ ID3D11DeviceContext* immediateContext);
+
+        // Loads queued or running.
+        size_t __cdecl GetPendingCount() const noexcept;
+
+        size_t __cdecl GetMaxConcurrency() const noexcept;
+
+    private:
+        // Private implementation.
+        class Impl;
+
+        std::unique_ptr<Impl> pImpl;
+    };
+}
@@ -16,6 +16,7 @@
 #endif
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 
 namespace DirectX
@@ -487,4 +488,116 @@ namespace DirectX
         static const int InputElementCount = 7;
         static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
     };
+
+
+    //----------------------------------------------------------------------------------
+    // Packed vertex types. The input assembler expands these to the same float inputs
+    // the full-precision types give the built-in effects, so they work with the same
+    // shaders. Positions and texture coordinates are half-precision, and normals and
+    // tangents are signed-normalized 8-bit (requires Feature Level 10.0 or later).
+
+    // Vertex struct holding position, normal vector, and texture mapping information (16 bytes).
+    struct VertexPositionNormalTexturePacked
+    {
+        VertexPositionNormalTexturePacked() = default;
+
+        VertexPositionNormalTexturePacked(const VertexPositionNormalTexturePacked&) = default;
+        VertexPositionNormalTexturePacked& operator=(const VertexPositionNormalTexturePacked&) = default;
+
+        VertexPositionNormalTexturePacked(VertexPositionNormalTexturePacked&&) = default;
+        VertexPositionNormalTexturePacked& operator=(VertexPositionNormalTexturePacked&&) = default;
+
+        VertexPositionNormalTexturePacked(FXMVECTOR iposition, FXMVECTOR inormal, FXMVECTOR itextureCoordinate) noexcept
+        {
+            SetPosition(iposition);
+            PackedVector::XMStoreByteN4(&this->normal, XMVectorAndInt(inormal, g_XMMask3));
+            PackedVector::XMStoreHalf2(&this->textureCoordinate, itextureCoordinate);
+        }
+
+        explicit VertexPositionNormalTexturePacked(VertexPositionNormalTexture const& vertex) noexcept
+            : VertexPositionNormalTexturePacked(XMLoadFloat3(&vertex.position), XMLoadFloat3(&vertex.normal), XMLoadFloat2(&vertex.textureCoordinate))
+        { }
+
+        void XM_CALLCONV SetPosition(FXMVECTOR iposition) noexcept
+        {
+            PackedVector::XMStoreHalf4(&this->position, XMVectorSelect(g_XMOne, iposition, g_XMSelect1110));
+        }
+
+        PackedVector::XMHALF4 position;
+        PackedVector::XMBYTEN4 normal;
+        PackedVector::XMHALF2 textureCoordinate;
+
+        static const int InputElementCount = 3;
+        static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+    };
+
+
+    // Vertex struct holding position, normal, tangent, color (RGBA), and texture mapping information (24 bytes).
+    struct VertexPositionNormalTangentColorTexturePacked
+    {
+        VertexPositionNormalTangentColorTexturePacked() = default;
+
+        VertexPositionNormalTangentColorTexturePacked(const VertexPositionNormalTangentColorTexturePacked&) = default;
+        VertexPositionNormalTangentColorTexturePacked& operator=(const VertexPositionNormalTangentColorTexturePacked&) = default;
+
+        VertexPositionNormalTangentColorTexturePacked(VertexPositionNormalTangentColorTexturePacked&&) = default;
+        VertexPositionNormalTangentColorTexturePacked& operator=(VertexPositionNormalTangentColorTexturePacked&&) = default;
+
+        PackedVector::XMHALF4 position;
+        PackedVector::XMBYTEN4 normal;
+        PackedVector::XMBYTEN4 tangent;
+        uint32_t color;
+        PackedVector::XMHALF2 textureCoordinate;
+
+        VertexPositionNormalTangentColorTexturePacked(
+            FXMVECTOR iposition,
+            FXMVECTOR inormal,
+            FXMVECTOR itangent,
+            uint32_t irgba,
+            CXMVECTOR itextureCoordinate) noexcept
+            : color(irgba)
+        {
+            PackedVector::XMStoreHalf4(&this->position, XMVectorSelect(g_XMOne, iposition, g_XMSelect1110));
+            PackedVector::XMStoreByteN4(&this->normal, XMVectorAndInt(inormal, g_XMMask3));
+            PackedVector::XMStoreByteN4(&this->tangent, itangent);
+            PackedVector::XMStoreHalf2(&this->textureCoordinate, itextureCoordinate);
+        }
+
+        explicit VertexPositionNormalTangentColorTexturePacked(VertexPositionNormalTangentColorTexture const& vertex) noexcept
+            : VertexPositionNormalTangentColorTexturePacked(
+                XMLoadFloat3(&vertex.position),
+                XMLoadFloat3(&vertex.normal),
+                XMLoadFloat4(&vertex.tangent),
+                vertex.color,
+                XMLoadFloat2(&vertex.textureCoordinate))
+        { }
+
+        static const int InputElementCount = 5;
+        static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+    };
+
+
+    // Vertex struct holding position, normal, tangent, color (RGBA), texture mapping information, and skinning weights (32 bytes).
+    struct VertexPositionNormalTangentColorTextureSkinningPacked : public VertexPositionNormalTangentColorTexturePacked
+    {
+        VertexPositionNormalTangentColorTextureSkinningPacked() = default;
+
+        VertexPositionNormalTangentColorTextureSkinningPacked(const VertexPositionNormalTangentColorTextureSkinningPacked&) = default;
+        VertexPositionNormalTangentColorTextureSkinningPacked& operator=(const VertexPositionNormalTangentColorTextureSkinningPacked&) = default;
+
+        VertexPositionNormalTangentColorTextureSkinningPacked(VertexPositionNormalTangentColorTextureSkinningPacked&&) = default;
+        VertexPositionNormalTangentColorTextureSkinningPacked& operator=(VertexPositionNormalTangentColorTextureSkinningPacked&&) = default;
+
+        uint32_t indices;
+        uint32_t weights;
+
+        explicit VertexPositionNormalTangentColorTextureSkinningPacked(VertexPositionNormalTangentColorTextureSkinning const& vertex) noexcept
+            : VertexPositionNormalTangentColorTexturePacked(static_cast<VertexPositionNormalTangentColorTexture const&>(vertex)),
+            indices(vertex.indices),
+            weights(vertex.weights)
+        { }
+
+        static const int InputElementCount = 7;
+        static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+    };
 }
@@ -7,7 +7,8 @@
 // Note: Assumes application has already called CoInitializeEx
 //
 // Warning: CreateWICTexture* functions are not thread-safe if given a d3dContext instance for
-//          auto-gen mipmap support.
+//          auto-gen mipmap support. A deferred context may be given instead, in which case the
+//          upload and GenerateMips are only recorded, and run when its command list is executed.
 //
 // Note these functions are useful for images created as simple 2D textures. For
 // more complex resources, DDSTextureLoader is an excellent light-weight runtime loader.
@@ -39,6 +40,16 @@ namespace DirectX
         WIC_LOADER_DEFAULT      = 0,
         WIC_LOADER_FORCE_SRGB   = 0x1,
         WIC_LOADER_IGNORE_SRGB  = 0x2,
+
+        // Block compress on load, building the full mip chain on the CPU. If more than one is set the best
+        // supported is used; BC7 falls back to BC3 on devices below Feature Level 11.0.
+        WIC_LOADER_COMPRESS_BC1 = 0x4,
+        WIC_LOADER_COMPRESS_BC3 = 0x8,
+        WIC_LOADER_COMPRESS_BC7 = 0x10,
+
+        // With a compression flag, the file loaders save the result as <file>.<key>.bc?.dds and load that instead
+        // while it is newer than the image. The key covers the load flags, maxsize, feature level and image size.
+        WIC_LOADER_CACHE_DDS    = 0x20,
     };
 
     // Standard version
@@ -148,4 +159,10 @@ namespace DirectX
         _In_ unsigned int loadFlags,
         _Outptr_opt_ ID3D11Resource** texture,
         _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept;
+
+    // Turns on a persistent cache for the CreateWICTextureFromFile* functions. Each converted texture is saved in the
+    // directory as a DDS named for a hash of the image file and the options that shaped it, and later loads of the
+    // same content map that file instead of decoding. The directory must already exist; nullptr turns the cache off.
+    // Textures are cached after format conversion and resizing but before auto-gen mipmaps, which are made again.
+    HRESULT __cdecl SetWICTextureCacheDirectory(_In_opt_z_ const wchar_t* directory) noexcept;
 }
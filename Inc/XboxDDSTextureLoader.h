@@ -54,5 +54,31 @@ namespace Xbox
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
         _In_ bool forceSRGB = false) noexcept;
 
+    // These place the texture in graphics memory the caller has already reserved (for example with XMemAlloc using
+    // a GPU-readable memory type and 64K alignment) instead of allocating for each texture. heapOffset is where to
+    // start looking, and on success is moved past the texture; the memory is owned by the caller and must outlive
+    // the texture. The file version reads the tiled data directly into its placement with overlapped I/O.
+    HRESULT __cdecl CreateDDSTextureFromMemoryInHeap(
+        _In_ ID3D11DeviceX* d3dDevice,
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _In_ void* heapMemory,
+        _In_ size_t heapSize,
+        _Inout_ size_t* heapOffset,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+        _In_ bool forceSRGB = false) noexcept;
+
+    HRESULT __cdecl CreateDDSTextureFromFileInHeap( _In_ ID3D11DeviceX* d3dDevice,
+        _In_z_ const wchar_t* szFileName,
+        _In_ void* heapMemory,
+        _In_ size_t heapSize,
+        _Inout_ size_t* heapOffset,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+        _In_ bool forceSRGB = false) noexcept;
+
     void FreeDDSTextureMemory( _In_opt_ void* grfxMemory ) noexcept;
 }
@@ -17,6 +17,7 @@ namespace MakeSpriteFont
         Rgba32,
         Bgra4444,
         CompressedMono,
+        CompressedBC7,
     }
 
 
@@ -81,6 +82,11 @@ namespace MakeSpriteFont
         public bool NoPremultiply = false;
 
 
+        // Writes a signed distance field spreading this many pixels either side of each glyph edge, for drawing
+        // with SpriteBatch::SetDistanceField. Zero writes regular coverage.
+        public int DistanceField = 0;
+
+
         // Dumps the generated sprite texture to a bitmap file (useful for debugging).
         public string DebugOutputSpriteSheet = null;
 
@@ -91,5 +97,10 @@ namespace MakeSpriteFont
 
         // For large fonts, the default tightest pack is too slow
         public bool FastPack = false;
+
+
+        // Writes the version 2 format, whose glyph table and lookup index SpriteFont uses in place from the mapped
+        // file. Older DirectXTK versions cannot read it.
+        public bool FastLoad = false;
     }
 }
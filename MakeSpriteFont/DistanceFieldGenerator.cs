@@ -0,0 +1,104 @@
+// DirectXTK MakeSpriteFont tool
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+
+using System;
+using System.Drawing;
+using System.Drawing.Imaging;
+
+namespace MakeSpriteFont
+{
+    // Replaces glyph coverage with a signed distance field, for SpriteBatch::SetDistanceField.
+    public static class DistanceFieldGenerator
+    {
+        // Each glyph grows by spread pixels on every side. The field stores 0.5 on the edge, rising to 1 at spread
+        // pixels inside and falling to 0 at spread pixels outside, in all four channels.
+        public static void Generate(Glyph glyph, int spread)
+        {
+            int width = glyph.Subrect.Width;
+            int height = glyph.Subrect.Height;
+
+            bool[,] inside = new bool[width, height];
+
+            using (var bitmapData = new BitmapUtils.PixelAccessor(glyph.Bitmap, ImageLockMode.ReadOnly, glyph.Subrect))
+            {
+                for (int y = 0; y < height; y++)
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        inside[x, y] = bitmapData[x, y].A >= 128;
+                    }
+                }
+            }
+
+            int outputWidth = width + spread * 2;
+            int outputHeight = height + spread * 2;
+
+            var output = new Bitmap(outputWidth, outputHeight, PixelFormat.Format32bppArgb);
+
+            using (var outputData = new BitmapUtils.PixelAccessor(output, ImageLockMode.WriteOnly))
+            {
+                for (int y = 0; y < outputHeight; y++)
+                {
+                    for (int x = 0; x < outputWidth; x++)
+                    {
+                        float distance = SignedDistance(inside, x - spread, y - spread, spread);
+
+                        int value = (int)Math.Round((0.5f + distance / (spread * 2)) * 255);
+
+                        value = Math.Max(0, Math.Min(255, value));
+
+                        outputData[x, y] = Color.FromArgb(value, value, value, value);
+                    }
+                }
+            }
+
+            glyph.Bitmap = output;
+            glyph.Subrect = new Rectangle(0, 0, outputWidth, outputHeight);
+
+            glyph.XOffset -= spread;
+            glyph.YOffset -= spread;
+            glyph.XAdvance -= spread;
+        }
+
+
+        // Distance from a pixel center to the nearest pixel of the other state, positive inside the glyph and clamped
+        // to the spread. Searching the whole neighborhood is slow but fonts are small.
+        static float SignedDistance(bool[,] inside, int x, int y, int spread)
+        {
+            bool state = IsInside(inside, x, y);
+
+            int nearest = (spread + 1) * (spread + 1);
+
+            for (int dy = -spread; dy <= spread; dy++)
+            {
+                for (int dx = -spread; dx <= spread; dx++)
+                {
+                    int squared = dx * dx + dy * dy;
+
+                    if (squared < nearest && IsInside(inside, x + dx, y + dy) != state)
+                    {
+                        nearest = squared;
+                    }
+                }
+            }
+
+            // The edge lies halfway between the two pixel centers.
+            float distance = Math.Min((float)Math.Sqrt(nearest) - 0.5f, spread);
+
+            return state ? distance : -distance;
+        }
+
+
+        static bool IsInside(bool[,] inside, int x, int y)
+        {
+            if (x < 0 || y < 0 || x >= inside.GetLength(0) || y >= inside.GetLength(1))
+                return false;
+
+            return inside[x, y];
+        }
+    }
+}
@@ -60,6 +60,29 @@ namespace MakeSpriteFont
                 GlyphCropper.Crop(glyph);
             }
 
+            if (options.DistanceField > 0)
+            {
+                Console.WriteLine("Generating distance fields");
+
+                foreach (Glyph glyph in glyphs)
+                {
+                    DistanceFieldGenerator.Generate(glyph, options.DistanceField);
+                }
+
+                // Distances need full precision and are not colors, so they are never compressed or premultiplied.
+                if (options.TextureFormat != TextureFormat.Auto && options.TextureFormat != TextureFormat.Rgba32)
+                {
+                    Console.WriteLine("WARNING: Distance fields are always written in Rgba32 format.");
+                }
+
+                options.TextureFormat = TextureFormat.Rgba32;
+                options.NoPremultiply = true;
+            }
+            else if (options.DistanceField < 0)
+            {
+                throw new Exception("DistanceField must not be negative.");
+            }
+
             Console.WriteLine("Packing glyphs into sprite sheet");
 
             Bitmap bitmap;
@@ -117,6 +140,11 @@ namespace MakeSpriteFont
                                                  TextureFormat.Rgba32;
             }
 
+            if (options.TextureFormat == TextureFormat.CompressedBC7 && options.FeatureLevel < FeatureLevel.FL11_0)
+            {
+                Console.WriteLine("WARNING: CompressedBC7 textures require a Feature Level 11.0 or later device.");
+            }
+
             // Convert to premultiplied alpha format.
             if (!options.NoPremultiply)
             {
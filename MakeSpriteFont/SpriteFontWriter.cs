@@ -6,6 +6,7 @@
 // http://go.microsoft.com/fwlink/?LinkId=248929
 
 using System;
+using System.Collections.Generic;
 using System.IO;
 using System.Drawing;
 using System.Drawing.Imaging;
@@ -16,15 +17,35 @@ namespace MakeSpriteFont
     public static class SpriteFontWriter
     {
         const string spriteFontMagic = "DXTKfont";
+        const string distanceFieldMagic = "DXTKdfld";
+
+        // Version 2 (FastLoad) layout, matching SpriteFontFormat.h in DirectXTK.
+        const string spriteFontMagicV2 = "DXTKfnt2";
+        const int spriteFontVersion2 = 2;
+        const int headerSizeV2 = 76;
+        const int glyphSize = 32;
+        const int indexPageSize = 256;
+        const int indexPageCount = 0x10000 / indexPageSize;
+        const ushort noGlyph = 0xFFFF;
+        const int textureAlignment = 16;
+
+        const int SpriteDistanceField_SingleChannel = 1;
 
         const int DXGI_FORMAT_R8G8B8A8_UNORM = 28;
         const int DXGI_FORMAT_B4G4R4A4_UNORM = 115;
         const int DXGI_FORMAT_BC2_UNORM = 74;
+        const int DXGI_FORMAT_BC7_UNORM = 98;
 
 
         [System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Usage", "CA2202:Do not dispose objects multiple times")]
         public static void WriteSpriteFont(CommandLineOptions options, Glyph[] glyphs, float lineSpacing, Bitmap bitmap)
         {
+            if (options.FastLoad)
+            {
+                WriteSpriteFontV2(options, glyphs, lineSpacing, bitmap);
+                return;
+            }
+
             using (FileStream file = File.OpenWrite(options.OutputFile))
             using (BinaryWriter writer = new BinaryWriter(file))
             {
@@ -35,23 +56,163 @@ namespace MakeSpriteFont
                 writer.Write(options.DefaultCharacter);
                 
                 WriteBitmap(writer, options, bitmap);
+
+                if (options.DistanceField > 0)
+                {
+                    WriteDistanceField(writer, options);
+                }
             }
         }
 
 
-        static void WriteMagic(BinaryWriter writer)
+        // Writes the version 2 format: a header giving the offset of each table, the glyph table, a direct lookup
+        // index, and then the texture data on a 16 byte boundary, so that SpriteFont can use the file in place.
+        static void WriteSpriteFontV2(CommandLineOptions options, Glyph[] glyphs, float lineSpacing, Bitmap bitmap)
         {
-            foreach (char magic in spriteFontMagic)
+            if (glyphs.Length >= noGlyph)
+            {
+                throw new ArgumentException("Too many glyphs for the FastLoad format.");
+            }
+
+            // The index maps each page of characters that has any glyphs to a page of glyph indices. Like the
+            // version 1 reader, the first of any duplicate characters wins.
+            var pageMap = new ushort[indexPageCount];
+            var pages = new List<ushort[]>();
+
+            for (int i = 0; i < glyphs.Length; i++)
+            {
+                int character = glyphs[i].Character;
+
+                if (pageMap[character / indexPageSize] == 0)
+                {
+                    var newPage = new ushort[indexPageSize];
+
+                    for (int j = 0; j < indexPageSize; j++)
+                    {
+                        newPage[j] = noGlyph;
+                    }
+
+                    pages.Add(newPage);
+                    pageMap[character / indexPageSize] = (ushort)pages.Count;
+                }
+
+                var page = pages[pageMap[character / indexPageSize] - 1];
+
+                if (page[character % indexPageSize] == noGlyph)
+                {
+                    page[character % indexPageSize] = (ushort)i;
+                }
+            }
+
+            // The texture is written as in version 1 (width, height, format, stride and rows, then the data), and
+            // split between the header and the end of the file.
+            byte[] texture;
+            const int textureHeaderSize = 5 * sizeof(int);
+
+            using (var stream = new MemoryStream())
             {
-                writer.Write((byte)magic);
+                var textureWriter = new BinaryWriter(stream);
+
+                WriteBitmap(textureWriter, options, bitmap);
+
+                textureWriter.Flush();
+                texture = stream.ToArray();
+            }
+
+            int glyphsOffset = headerSizeV2;
+            int pageMapOffset = glyphsOffset + glyphs.Length * glyphSize;
+            int pagesOffset = pageMapOffset + indexPageCount * sizeof(ushort);
+            int textureOffset = pagesOffset + pages.Count * indexPageSize * sizeof(ushort);
+
+            textureOffset = (textureOffset + textureAlignment - 1) & ~(textureAlignment - 1);
+
+            int fileSize = textureOffset + texture.Length - textureHeaderSize;
+
+            using (FileStream file = File.Create(options.OutputFile))
+            using (BinaryWriter writer = new BinaryWriter(file))
+            {
+                WriteMagic(writer, spriteFontMagicV2);
+
+                writer.Write(spriteFontVersion2);
+                writer.Write(fileSize);
+
+                writer.Write(glyphs.Length);
+                writer.Write(lineSpacing);
+                writer.Write(options.DefaultCharacter);
+
+                if (options.DistanceField > 0)
+                {
+                    writer.Write(SpriteDistanceField_SingleChannel);
+                    writer.Write((float)(options.DistanceField * 2));
+                }
+                else
+                {
+                    writer.Write(0);
+                    writer.Write(0.0f);
+                }
+
+                writer.Write(texture, 0, textureHeaderSize);
+
+                writer.Write(glyphsOffset);
+                writer.Write(pageMapOffset);
+                writer.Write(pagesOffset);
+                writer.Write(pages.Count);
+                writer.Write(textureOffset);
+
+                WriteGlyphRecords(writer, glyphs);
+
+                foreach (ushort entry in pageMap)
+                {
+                    writer.Write(entry);
+                }
+
+                foreach (ushort[] page in pages)
+                {
+                    foreach (ushort entry in page)
+                    {
+                        writer.Write(entry);
+                    }
+                }
+
+                while (writer.BaseStream.Position < textureOffset)
+                {
+                    writer.Write((byte)0);
+                }
+
+                writer.Write(texture, textureHeaderSize, texture.Length - textureHeaderSize);
+            }
+        }
+
+
+        static void WriteMagic(BinaryWriter writer, string magic = spriteFontMagic)
+        {
+            foreach (char c in magic)
+            {
+                writer.Write((byte)c);
             }
         }
 
 
+        // Optional trailing block, which SpriteFont readers without distance field support skip.
+        static void WriteDistanceField(BinaryWriter writer, CommandLineOptions options)
+        {
+            WriteMagic(writer, distanceFieldMagic);
+
+            writer.Write(SpriteDistanceField_SingleChannel);
+            writer.Write((float)(options.DistanceField * 2));
+        }
+
+
         static void WriteGlyphs(BinaryWriter writer, Glyph[] glyphs)
         {
             writer.Write(glyphs.Length);
 
+            WriteGlyphRecords(writer, glyphs);
+        }
+
+
+        static void WriteGlyphRecords(BinaryWriter writer, Glyph[] glyphs)
+        {
             foreach (Glyph glyph in glyphs)
             {
                 writer.Write((int)glyph.Character);
@@ -86,6 +247,10 @@ namespace MakeSpriteFont
                 case TextureFormat.CompressedMono:
                     WriteCompressedMono(writer, bitmap, options);
                     break;
+
+                case TextureFormat.CompressedBC7:
+                    WriteCompressedBC7(writer, bitmap);
+                    break;
                 
                 default:
                     throw new NotSupportedException();
@@ -264,5 +429,188 @@ namespace MakeSpriteFont
             // Output the RGB bit mask.
             writer.Write(rgbBits);
         }
+
+
+        // Writes a BC7 compressed font texture, which needs a Feature Level 11.0 device.
+        static void WriteCompressedBC7(BinaryWriter writer, Bitmap bitmap)
+        {
+            if ((bitmap.Width & 3) != 0 ||
+                (bitmap.Height & 3) != 0)
+            {
+                throw new ArgumentException("Block compression requires texture size to be a multiple of 4.");
+            }
+
+            writer.Write(DXGI_FORMAT_BC7_UNORM);
+
+            writer.Write(bitmap.Width * 4);
+            writer.Write(bitmap.Height / 4);
+
+            using (var bitmapData = new BitmapUtils.PixelAccessor(bitmap, ImageLockMode.ReadOnly))
+            {
+                for (int y = 0; y < bitmap.Height; y += 4)
+                {
+                    for (int x = 0; x < bitmap.Width; x += 4)
+                    {
+                        CompressBlockBC7(writer, bitmapData, x, y);
+                    }
+                }
+            }
+        }
+
+
+        // The texels of a font block lie on a line between two colors: grey levels with RGB equal to alpha when
+        // premultiplied, or white with varying alpha when not. So every block is encoded in BC7 mode 6, which has
+        // one pair of RGBA endpoints and 16 steps between them. The endpoints are the corners of the block's
+        // bounding box, and each endpoint's shared low bit makes them exact whenever its channels are all even or
+        // all odd, which keeps the solid inside and outside of glyphs exact as CompressBlock does for BC2.
+
+        static readonly int[] bc7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        static void CompressBlockBC7(BinaryWriter writer, BitmapUtils.PixelAccessor bitmapData, int blockX, int blockY)
+        {
+            var pixels = new int[16, 4];
+            var low = new int[] { 255, 255, 255, 255 };
+            var high = new int[] { 0, 0, 0, 0 };
+
+            for (int i = 0; i < 16; i++)
+            {
+                Color color = bitmapData[blockX + (i & 3), blockY + (i >> 2)];
+
+                pixels[i, 0] = color.R;
+                pixels[i, 1] = color.G;
+                pixels[i, 2] = color.B;
+                pixels[i, 3] = color.A;
+
+                for (int c = 0; c < 4; c++)
+                {
+                    low[c] = Math.Min(low[c], pixels[i, c]);
+                    high[c] = Math.Max(high[c], pixels[i, c]);
+                }
+            }
+
+            // Quantize the endpoints to 7 bits per channel plus the shared bit.
+            var q0 = new int[4];
+            var q1 = new int[4];
+
+            int p0 = QuantizeEndpointBC7(low, q0);
+            int p1 = QuantizeEndpointBC7(high, q1);
+
+            // Pick the closest of the 16 interpolated colors for each texel.
+            var indices = new int[16];
+
+            for (int i = 0; i < 16; i++)
+            {
+                int bestError = int.MaxValue;
+
+                for (int index = 0; index < 16; index++)
+                {
+                    int error = 0;
+
+                    for (int c = 0; c < 4; c++)
+                    {
+                        int e0 = (q0[c] << 1) | p0;
+                        int e1 = (q1[c] << 1) | p1;
+                        int value = ((64 - bc7Weights[index]) * e0 + bc7Weights[index] * e1 + 32) >> 6;
+
+                        error += (value - pixels[i, c]) * (value - pixels[i, c]);
+                    }
+
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[i] = index;
+                    }
+                }
+            }
+
+            // The first texel's index is stored without its top bit, so it must be below 8. Swapping the endpoints
+            // and reversing the indices gives the same colors, as the weights are symmetric.
+            if (indices[0] >= 8)
+            {
+                var q = q0; q0 = q1; q1 = q;
+                int p = p0; p0 = p1; p1 = p;
+
+                for (int i = 0; i < 16; i++)
+                {
+                    indices[i] = 15 - indices[i];
+                }
+            }
+
+            // Pack the mode, endpoints, shared bits and indices, least significant bit first.
+            ulong bitsLow = 0;
+            ulong bitsHigh = 0;
+            int position = 0;
+
+            WriteBits(ref bitsLow, ref bitsHigh, ref position, 1 << 6, 7);
+
+            for (int c = 0; c < 4; c++)
+            {
+                WriteBits(ref bitsLow, ref bitsHigh, ref position, q0[c], 7);
+                WriteBits(ref bitsLow, ref bitsHigh, ref position, q1[c], 7);
+            }
+
+            WriteBits(ref bitsLow, ref bitsHigh, ref position, p0, 1);
+            WriteBits(ref bitsLow, ref bitsHigh, ref position, p1, 1);
+
+            for (int i = 0; i < 16; i++)
+            {
+                WriteBits(ref bitsLow, ref bitsHigh, ref position, indices[i], (i == 0) ? 3 : 4);
+            }
+
+            writer.Write(bitsLow);
+            writer.Write(bitsHigh);
+        }
+
+
+        // Chooses the shared bit that best fits a color, and returns it along with the 7 bit channels.
+        static int QuantizeEndpointBC7(int[] color, int[] quantized)
+        {
+            int bestBit = 0;
+            int bestError = int.MaxValue;
+
+            for (int bit = 0; bit < 2; bit++)
+            {
+                int error = 0;
+
+                for (int c = 0; c < 4; c++)
+                {
+                    int q = Math.Min(Math.Max((color[c] - bit + 1) >> 1, 0), 127);
+                    int value = (q << 1) | bit;
+
+                    error += (value - color[c]) * (value - color[c]);
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestBit = bit;
+                }
+            }
+
+            for (int c = 0; c < 4; c++)
+            {
+                quantized[c] = Math.Min(Math.Max((color[c] - bestBit + 1) >> 1, 0), 127);
+            }
+
+            return bestBit;
+        }
+
+
+        static void WriteBits(ref ulong bitsLow, ref ulong bitsHigh, ref int position, int value, int count)
+        {
+            for (int i = 0; i < count; i++, position++)
+            {
+                ulong bit = (ulong)((value >> i) & 1);
+
+                if (position < 64)
+                {
+                    bitsLow |= bit << position;
+                }
+                else
+                {
+                    bitsHigh |= bit << (position - 64);
+                }
+            }
+        }
     }
 }
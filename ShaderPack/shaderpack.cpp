@@ -0,0 +1,284 @@
+//--------------------------------------------------------------------------------------
+// File: shaderpack.cpp
+//
+// Simple command-line tool for building the effect shader pack that libraries built with
+// DIRECTX_TOOLKIT_SHADER_PACK load through LoadEffectShaderPack. It gathers the .cso
+// files written by CompileShaders.cmd, keyed by file name. Packing a directory of DGSL
+// .cso files the same way gives a pack for DGSLEffectFactory::LoadShaderPack.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma warning(push)
+#pragma warning(disable : 4005)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NODRAWTEXT
+#define NOGDI
+#define NOBITMAP
+#define NOMCX
+#define NOSERVICE
+#define NOHELP
+#pragma warning(pop)
+
+#include <Windows.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ShaderPack.h"
+
+namespace
+{
+    struct find_closer { void operator()(HANDLE h) { assert(h != INVALID_HANDLE_VALUE); if (h) FindClose(h); } };
+
+    typedef std::unique_ptr<void, find_closer> ScopedFindHandle;
+
+    inline HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
+
+    const wchar_t c_xboxPrefix[] = L"XboxOne";
+
+    struct Shader
+    {
+        std::string name;
+        std::vector<char> bytecode;
+    };
+
+    void PrintLogo()
+    {
+        wprintf(L"Microsoft (R) DirectX Tool Kit Shader Pack Tool\n");
+        wprintf(L"Copyright (C) Microsoft Corp. All rights reserved.\n");
+#ifdef _DEBUG
+        wprintf(L"*** Debug build ***\n");
+#endif
+        wprintf(L"\n");
+    }
+
+    void PrintUsage()
+    {
+        PrintLogo();
+
+        wprintf(L"Usage: shaderpack <options> <output-file> <compiled-shader-directory>\n");
+        wprintf(L"\n");
+        wprintf(L"   -xbox               pack the XboxOne*.cso shaders rather than the PC ones\n");
+        wprintf(L"   -nologo             suppress copyright message\n");
+    }
+
+    // Shaders are keyed by the name of the bytecode array CompileShaders.cmd generates for them, which is the file
+    // name without the Xbox prefix. Returns false for files that belong to the other platform.
+    bool GetShaderName(const wchar_t* fileName, bool xbox, std::string& name)
+    {
+        size_t prefixLength = wcslen(c_xboxPrefix);
+        bool isXbox = !wcsncmp(fileName, c_xboxPrefix, prefixLength);
+
+        if (isXbox != xbox)
+            return false;
+
+        const wchar_t* stem = (isXbox) ? fileName + prefixLength : fileName;
+        const wchar_t* ext = wcsrchr(stem, L'.');
+
+        name.clear();
+        for (auto p = stem; p != ext; ++p)
+        {
+            if (*p > 0x7f)
+                return false;
+
+            name.push_back(static_cast<char>(*p));
+        }
+
+        return true;
+    }
+
+    bool ReadShader(const wchar_t* path, std::vector<char>& bytecode)
+    {
+        std::ifstream inFile(path, std::ios::in | std::ios::binary);
+        if (!inFile)
+            return false;
+
+        bytecode.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+
+        return !inFile.bad() && !bytecode.empty();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Entry-point
+//--------------------------------------------------------------------------------------
+int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
+{
+    bool xbox = false;
+    bool nologo = false;
+    const wchar_t* outputFile = nullptr;
+    const wchar_t* inputDir = nullptr;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        const wchar_t* pArg = argv[iArg];
+
+        if (('-' == pArg[0]) || ('/' == pArg[0]))
+        {
+            pArg++;
+
+            if (!_wcsicmp(pArg, L"xbox"))
+            {
+                xbox = true;
+            }
+            else if (!_wcsicmp(pArg, L"nologo"))
+            {
+                nologo = true;
+            }
+            else
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (!outputFile)
+        {
+            outputFile = pArg;
+        }
+        else if (!inputDir)
+        {
+            inputDir = pArg;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!outputFile || !inputDir)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!nologo)
+        PrintLogo();
+
+    // Gather the compiled shaders.
+    std::wstring searchPath(inputDir);
+    if (!searchPath.empty() && searchPath.back() != L'\\' && searchPath.back() != L'/')
+        searchPath += L'\\';
+
+    std::vector<Shader> shaders;
+
+    WIN32_FIND_DATAW findData = {};
+    ScopedFindHandle hFind(safe_handle(FindFirstFileExW((searchPath + L"*.cso").c_str(),
+        FindExInfoBasic, &findData,
+        FindExSearchNameMatch, nullptr,
+        FIND_FIRST_EX_LARGE_FETCH)));
+
+    if (hFind)
+    {
+        do
+        {
+            if (findData.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_DIRECTORY))
+                continue;
+
+            Shader shader;
+            if (!GetShaderName(findData.cFileName, xbox, shader.name))
+                continue;
+
+            if (shader.name.size() >= ShaderPack::MAX_NAME_LENGTH)
+            {
+                wprintf(L"ERROR: Shader name too long for the pack: %ls\n", findData.cFileName);
+                return 1;
+            }
+
+            if (!ReadShader((searchPath + findData.cFileName).c_str(), shader.bytecode))
+            {
+                wprintf(L"ERROR: Failed reading %ls\n", findData.cFileName);
+                return 1;
+            }
+
+            shaders.emplace_back(std::move(shader));
+        } while (FindNextFileW(hFind.get(), &findData));
+    }
+
+    if (shaders.empty())
+    {
+        wprintf(L"ERROR: No %ls.cso files found in %ls\n", (xbox) ? L"XboxOne*" : L"*", inputDir);
+        return 1;
+    }
+
+    std::sort(shaders.begin(), shaders.end(), [](Shader const& a, Shader const& b)
+    {
+        return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+    });
+
+    // Lay out the header, the sorted directory, then the aligned bytecode.
+    ShaderPack::header_t header = {};
+    header.magic = ShaderPack::MAGIC;
+    header.version = ShaderPack::VERSION;
+    header.numEntries = static_cast<uint32_t>(shaders.size());
+
+    std::vector<ShaderPack::entry_t> entries(shaders.size());
+
+    uint64_t offset = sizeof(ShaderPack::header_t) + entries.size() * sizeof(ShaderPack::entry_t);
+
+    for (size_t j = 0; j < shaders.size(); ++j)
+    {
+        offset = (offset + ShaderPack::DATA_ALIGNMENT - 1) & ~uint64_t(ShaderPack::DATA_ALIGNMENT - 1);
+
+        memset(&entries[j], 0, sizeof(ShaderPack::entry_t));
+        memcpy(entries[j].name, shaders[j].name.c_str(), shaders[j].name.size());
+        entries[j].offset = static_cast<uint32_t>(offset);
+        entries[j].size = static_cast<uint32_t>(shaders[j].bytecode.size());
+
+        offset += shaders[j].bytecode.size();
+    }
+
+    if (offset > UINT32_MAX)
+    {
+        wprintf(L"ERROR: Shader pack too large\n");
+        return 1;
+    }
+
+    std::ofstream outFile(outputFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!outFile)
+    {
+        wprintf(L"ERROR: Failed creating %ls\n", outputFile);
+        return 1;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outFile.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ShaderPack::entry_t)));
+
+    uint64_t position = sizeof(ShaderPack::header_t) + entries.size() * sizeof(ShaderPack::entry_t);
+
+    for (size_t j = 0; j < shaders.size(); ++j)
+    {
+        static const char s_padding[ShaderPack::DATA_ALIGNMENT] = {};
+
+        outFile.write(s_padding, static_cast<std::streamsize>(entries[j].offset - position));
+        outFile.write(shaders[j].bytecode.data(), static_cast<std::streamsize>(shaders[j].bytecode.size()));
+
+        position = uint64_t(entries[j].offset) + entries[j].size;
+    }
+
+    outFile.close();
+    if (outFile.fail())
+    {
+        wprintf(L"ERROR: Failed writing %ls\n", outputFile);
+        return 1;
+    }
+
+    wprintf(L"Wrote %zu shaders to %ls\n", shaders.size(), outputFile);
+
+    return 0;
+}
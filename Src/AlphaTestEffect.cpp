@@ -34,6 +34,8 @@ struct AlphaTestEffectTraits
     static const int VertexShaderCount = 4;
     static const int PixelShaderCount = 4;
     static const int ShaderPermutationCount = 8;
+
+    static const BuiltInEffect Effect = BuiltInEffect_AlphaTest;
 };
 
 
@@ -56,7 +58,8 @@ public:
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -81,15 +84,16 @@ namespace
     #include "Shaders/Compiled/AlphaTestEffect_PSAlphaTestEqNeNoFog.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<AlphaTestEffectTraits>::VertexShaderBytecode[] =
 {
-    { AlphaTestEffect_VSAlphaTest,        sizeof(AlphaTestEffect_VSAlphaTest)        },
-    { AlphaTestEffect_VSAlphaTestNoFog,   sizeof(AlphaTestEffect_VSAlphaTestNoFog)   },
-    { AlphaTestEffect_VSAlphaTestVc,      sizeof(AlphaTestEffect_VSAlphaTestVc)      },
-    { AlphaTestEffect_VSAlphaTestVcNoFog, sizeof(AlphaTestEffect_VSAlphaTestVcNoFog) },
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_VSAlphaTest),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_VSAlphaTestNoFog),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_VSAlphaTestVc),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_VSAlphaTestVcNoFog),
 };
 
 
@@ -111,10 +115,10 @@ const int EffectBase<AlphaTestEffectTraits>::VertexShaderIndices[] =
 template<>
 const ShaderBytecode EffectBase<AlphaTestEffectTraits>::PixelShaderBytecode[] =
 {
-    { AlphaTestEffect_PSAlphaTestLtGt,      sizeof(AlphaTestEffect_PSAlphaTestLtGt)      },
-    { AlphaTestEffect_PSAlphaTestLtGtNoFog, sizeof(AlphaTestEffect_PSAlphaTestLtGtNoFog) },
-    { AlphaTestEffect_PSAlphaTestEqNe,      sizeof(AlphaTestEffect_PSAlphaTestEqNe)      },
-    { AlphaTestEffect_PSAlphaTestEqNeNoFog, sizeof(AlphaTestEffect_PSAlphaTestEqNeNoFog) },
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_PSAlphaTestLtGt),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_PSAlphaTestLtGtNoFog),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_PSAlphaTestEqNe),
+    EFFECT_SHADER_BYTECODE(AlphaTestEffect_PSAlphaTestEqNeNoFog),
 };
 
 
@@ -138,6 +142,14 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<AlphaTestEffectTraits>::DeviceResources> EffectBase<AlphaTestEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllAlphaTestEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<AlphaTestEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 AlphaTestEffect::Impl::Impl(_In_ ID3D11Device* device)
   : EffectBase(device),
@@ -309,6 +321,8 @@ AlphaTestEffect::~AlphaTestEffect()
 // IEffect methods.
 void AlphaTestEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"AlphaTestEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -0,0 +1,475 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncode.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "BCEncode.h"
+
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const XMVECTORF32 g_Max255 = { { { 255.f, 255.f, 255.f, 255.f } } };
+
+    // Loads one 4x4 block as floats in [0, 255], clamping reads to the image.
+    void LoadBlock(const uint8_t* pixels, size_t width, size_t height, size_t rowPitch, size_t bx, size_t by,
+                   _Out_writes_(16) XMVECTOR* block) noexcept
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            size_t y = std::min(by * 4 + j, height - 1);
+            auto row = pixels + y * rowPitch;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                size_t x = std::min(bx * 4 + i, width - 1);
+                auto p = row + x * 4;
+
+                block[j * 4 + i] = XMVectorSet(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            }
+        }
+    }
+
+
+    // Finds the two ends of the block's spread along its principal axis. Channels cleared in mask are ignored, and
+    // pixels with a zero weight do not take part.
+    void FitEndpoints(_In_reads_(16) const XMVECTOR* block, _In_reads_(16) const bool* include, FXMVECTOR mask,
+                      XMVECTOR& e0, XMVECTOR& e1) noexcept
+    {
+        XMVECTOR mean = XMVectorZero();
+        XMVECTOR minColor = g_Max255;
+        XMVECTOR maxColor = XMVectorZero();
+        float count = 0;
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            if (!include[j])
+                continue;
+
+            mean = XMVectorAdd(mean, block[j]);
+            minColor = XMVectorMin(minColor, block[j]);
+            maxColor = XMVectorMax(maxColor, block[j]);
+            count += 1.f;
+        }
+
+        assert(count > 0);
+        mean = XMVectorAnd(XMVectorScale(mean, 1.f / count), mask);
+
+        XMMATRIX covariance(XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero());
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            if (!include[j])
+                continue;
+
+            XMVECTOR d = XMVectorAnd(XMVectorSubtract(block[j], mean), mask);
+
+            covariance.r[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), covariance.r[0]);
+            covariance.r[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), covariance.r[1]);
+            covariance.r[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), covariance.r[2]);
+            covariance.r[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), covariance.r[3]);
+        }
+
+        // Power iteration from the bounding box diagonal converges quickly for 16 points.
+        XMVECTOR axis = XMVectorAnd(XMVectorSubtract(maxColor, minColor), mask);
+
+        for (size_t iteration = 0; iteration < 8; ++iteration)
+        {
+            XMVECTOR next = XMVector4Transform(axis, covariance);
+
+            float length = XMVectorGetX(XMVector4Length(next));
+            if (length < 1e-6f)
+                break;
+
+            axis = XMVectorScale(next, 1.f / length);
+        }
+
+        float axisLength = XMVectorGetX(XMVector4Length(axis));
+        if (axisLength < 1e-6f)
+        {
+            // Every pixel is the same color.
+            e0 = e1 = XMVectorSelect(g_Max255, mean, mask);
+            return;
+        }
+
+        axis = XMVectorScale(axis, 1.f / axisLength);
+
+        float tmin = FLT_MAX;
+        float tmax = -FLT_MAX;
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            if (!include[j])
+                continue;
+
+            float t = XMVectorGetX(XMVector4Dot(XMVectorSubtract(block[j], mean), axis));
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+
+        e0 = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(tmin), mean), XMVectorZero(), g_Max255);
+        e1 = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(tmax), mean), XMVectorZero(), g_Max255);
+
+        // Unused channels still need a defined value.
+        e0 = XMVectorSelect(g_Max255, e0, mask);
+        e1 = XMVectorSelect(g_Max255, e1, mask);
+    }
+
+
+    uint32_t NearestIndex(FXMVECTOR color, _In_reads_(count) const XMVECTOR* palette, uint32_t count, FXMVECTOR mask) noexcept
+    {
+        uint32_t best = 0;
+        float bestError = FLT_MAX;
+
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            XMVECTOR d = XMVectorAnd(XMVectorSubtract(color, palette[k]), mask);
+            float error = XMVectorGetX(XMVector4Dot(d, d));
+            if (error < bestError)
+            {
+                bestError = error;
+                best = k;
+            }
+        }
+
+        return best;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // BC1 color block, also used for the color half of BC3.
+    uint16_t Quantize565(FXMVECTOR color) noexcept
+    {
+        XMFLOAT4 c;
+        XMStoreFloat4(&c, color);
+
+        auto r = static_cast<uint32_t>(c.x * (31.f / 255.f) + 0.5f);
+        auto g = static_cast<uint32_t>(c.y * (63.f / 255.f) + 0.5f);
+        auto b = static_cast<uint32_t>(c.z * (31.f / 255.f) + 0.5f);
+
+        return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+    }
+
+
+    XMVECTOR Expand565(uint16_t value) noexcept
+    {
+        uint32_t r = (value >> 11) & 31;
+        uint32_t g = (value >> 5) & 63;
+        uint32_t b = value & 31;
+
+        return XMVectorSet(float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2)), 255.f);
+    }
+
+
+    void EncodeColorBlock(_In_reads_(16) const XMVECTOR* block, bool punchThroughAlpha, _Out_writes_bytes_(8) uint8_t* dest) noexcept
+    {
+        static const XMVECTORU32 s_maskRGB = { { { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 } } };
+
+        bool include[16];
+        bool anyTransparent = false;
+        bool anyOpaque = false;
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            include[j] = !punchThroughAlpha || XMVectorGetW(block[j]) >= 128.f;
+            anyTransparent |= !include[j];
+            anyOpaque |= include[j];
+        }
+
+        uint16_t c0 = 0;
+        uint16_t c1 = 0;
+        uint32_t indices = 0;
+
+        if (!anyOpaque)
+        {
+            // All transparent: three color mode with every index at 3.
+            indices = 0xFFFFFFFF;
+        }
+        else
+        {
+            XMVECTOR e0, e1;
+            FitEndpoints(block, include, s_maskRGB, e0, e1);
+
+            c0 = Quantize565(e1);
+            c1 = Quantize565(e0);
+
+            // Four color mode needs color0 > color1, three color (punch-through) mode color0 <= color1.
+            if (anyTransparent ? (c0 > c1) : (c0 < c1))
+            {
+                std::swap(c0, c1);
+            }
+
+            if (c0 != c1 || anyTransparent)
+            {
+                XMVECTOR palette[4];
+                palette[0] = Expand565(c0);
+                palette[1] = Expand565(c1);
+
+                uint32_t count;
+                if (anyTransparent)
+                {
+                    palette[2] = XMVectorScale(XMVectorAdd(palette[0], palette[1]), 0.5f);
+                    count = 3;
+                }
+                else
+                {
+                    palette[2] = XMVectorLerp(palette[0], palette[1], 1.f / 3.f);
+                    palette[3] = XMVectorLerp(palette[0], palette[1], 2.f / 3.f);
+                    count = 4;
+                }
+
+                for (size_t j = 0; j < 16; ++j)
+                {
+                    uint32_t index = include[j] ? NearestIndex(block[j], palette, count, s_maskRGB) : 3u;
+                    indices |= index << (j * 2);
+                }
+            }
+        }
+
+        memcpy(dest, &c0, sizeof(uint16_t));
+        memcpy(dest + 2, &c1, sizeof(uint16_t));
+        memcpy(dest + 4, &indices, sizeof(uint32_t));
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // BC3 alpha block, in eight value mode.
+    void EncodeAlphaBlock(_In_reads_(16) const XMVECTOR* block, _Out_writes_bytes_(8) uint8_t* dest) noexcept
+    {
+        float alpha[16];
+        float minAlpha = 255.f;
+        float maxAlpha = 0.f;
+
+        for (size_t j = 0; j < 16; ++j)
+        {
+            alpha[j] = XMVectorGetW(block[j]);
+            minAlpha = std::min(minAlpha, alpha[j]);
+            maxAlpha = std::max(maxAlpha, alpha[j]);
+        }
+
+        auto a0 = static_cast<uint8_t>(maxAlpha + 0.5f);
+        auto a1 = static_cast<uint8_t>(minAlpha + 0.5f);
+
+        uint64_t indices = 0;
+
+        if (a0 != a1)
+        {
+            // Index 0 is a0, 1 is a1, and 2 through 7 step from a0 towards a1.
+            float palette[8];
+            palette[0] = float(a0);
+            palette[1] = float(a1);
+            for (uint32_t k = 2; k < 8; ++k)
+            {
+                palette[k] = (float(8 - k) * a0 + float(k - 1) * a1) / 7.f;
+            }
+
+            for (size_t j = 0; j < 16; ++j)
+            {
+                uint64_t best = 0;
+                float bestError = FLT_MAX;
+                for (uint32_t k = 0; k < 8; ++k)
+                {
+                    float error = (alpha[j] - palette[k]) * (alpha[j] - palette[k]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = k;
+                    }
+                }
+
+                indices |= best << (j * 3);
+            }
+        }
+
+        dest[0] = a0;
+        dest[1] = a1;
+        for (size_t j = 0; j < 6; ++j)
+        {
+            dest[2 + j] = static_cast<uint8_t>(indices >> (j * 8));
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // BC7 mode 6: one subset, 7-bit RGBA endpoints each with a shared p-bit, and 4-bit indices.
+    class BitWriter
+    {
+    public:
+        BitWriter() noexcept : mBits{}, mPosition(0) {}
+
+        void Write(uint32_t value, uint32_t count) noexcept
+        {
+            for (uint32_t j = 0; j < count; ++j, ++mPosition)
+            {
+                if (value & (1u << j))
+                {
+                    mBits[mPosition >> 6] |= uint64_t(1) << (mPosition & 63);
+                }
+            }
+        }
+
+        void CopyTo(_Out_writes_bytes_(16) uint8_t* dest) const noexcept
+        {
+            assert(mPosition == 128);
+            memcpy(dest, mBits, 16);
+        }
+
+    private:
+        uint64_t mBits[2];
+        uint32_t mPosition;
+    };
+
+
+    // Picks the 7-bit value and p-bit whose 8-bit reconstruction is closest across all four channels.
+    void QuantizeEndpoint(FXMVECTOR endpoint, _Out_writes_(4) uint32_t* q, uint32_t& pbit) noexcept
+    {
+        XMFLOAT4 e;
+        XMStoreFloat4(&e, endpoint);
+        const float channels[4] = { e.x, e.y, e.z, e.w };
+
+        float bestError = FLT_MAX;
+
+        for (uint32_t p = 0; p < 2; ++p)
+        {
+            uint32_t candidate[4];
+            float error = 0;
+
+            for (size_t c = 0; c < 4; ++c)
+            {
+                float value = (channels[c] - float(p)) * 0.5f + 0.5f;
+                candidate[c] = std::min(static_cast<uint32_t>(std::max(value, 0.f)), 127u);
+
+                float d = float(candidate[c] * 2 + p) - channels[c];
+                error += d * d;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                pbit = p;
+                memcpy(q, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+
+    void EncodeBC7Block(_In_reads_(16) const XMVECTOR* block, _Out_writes_bytes_(16) uint8_t* dest) noexcept
+    {
+        static const XMVECTORU32 s_maskRGBA = { { { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF } } };
+        static const uint32_t s_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        static const bool s_all[16] = { true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true };
+
+        XMVECTOR e0, e1;
+        FitEndpoints(block, s_all, s_maskRGBA, e0, e1);
+
+        uint32_t q[2][4];
+        uint32_t p[2];
+        QuantizeEndpoint(e0, q[0], p[0]);
+        QuantizeEndpoint(e1, q[1], p[1]);
+
+        XMVECTOR ends[2];
+        for (size_t j = 0; j < 2; ++j)
+        {
+            ends[j] = XMVectorSet(float(q[j][0] * 2 + p[j]), float(q[j][1] * 2 + p[j]), float(q[j][2] * 2 + p[j]), float(q[j][3] * 2 + p[j]));
+        }
+
+        XMVECTOR palette[16];
+        for (size_t k = 0; k < 16; ++k)
+        {
+            palette[k] = XMVectorLerp(ends[0], ends[1], float(s_weights[k]) / 64.f);
+        }
+
+        uint32_t indices[16];
+        for (size_t j = 0; j < 16; ++j)
+        {
+            indices[j] = NearestIndex(block[j], palette, 16, s_maskRGBA);
+        }
+
+        // The first index is stored without its top bit, so it must be below 8.
+        if (indices[0] & 8)
+        {
+            std::swap(q[0], q[1]);
+            std::swap(p[0], p[1]);
+
+            for (size_t j = 0; j < 16; ++j)
+            {
+                indices[j] = 15 - indices[j];
+            }
+        }
+
+        BitWriter writer;
+        writer.Write(1u << 6, 7);
+
+        for (size_t c = 0; c < 4; ++c)
+        {
+            writer.Write(q[0][c], 7);
+            writer.Write(q[1][c], 7);
+        }
+
+        writer.Write(p[0], 1);
+        writer.Write(p[1], 1);
+
+        writer.Write(indices[0], 3);
+        for (size_t j = 1; j < 16; ++j)
+        {
+            writer.Write(indices[j], 4);
+        }
+
+        writer.CopyTo(dest);
+    }
+}
+
+
+_Use_decl_annotations_
+void DirectX::CompressBC(DXGI_FORMAT format, const uint8_t* pixels, size_t width, size_t height, size_t rowPitch,
+                         uint8_t* blocks, size_t blockRowPitch)
+{
+    size_t blocksWide = (width + 3) / 4;
+    size_t blocksHigh = (height + 3) / 4;
+
+    ParallelFor(blocksHigh, [=](size_t by)
+    {
+        XMVECTOR block[16];
+
+        auto dest = blocks + by * blockRowPitch;
+
+        for (size_t bx = 0; bx < blocksWide; ++bx)
+        {
+            LoadBlock(pixels, width, height, rowPitch, bx, by, block);
+
+            switch (format)
+            {
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+                EncodeColorBlock(block, true, dest);
+                dest += 8;
+                break;
+
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                EncodeAlphaBlock(block, dest);
+                EncodeColorBlock(block, false, dest + 8);
+                dest += 16;
+                break;
+
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+                EncodeBC7Block(block, dest);
+                dest += 16;
+                break;
+
+            default:
+                assert(false);
+                return;
+            }
+        }
+    });
+}
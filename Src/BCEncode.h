@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncode.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Fast block compressors for textures built at load time, rather than the exhaustive search of an offline tool.
+    // BC1 and BC3 fit endpoints along the principal axis of each block; BC7 does the same in RGBA using mode 6 only.
+    // Input is 32bpp RGBA; blocks that hang off the right or bottom edge repeat the last column or row. Block rows are
+    // spread over the system thread pool.
+    void CompressBC(DXGI_FORMAT format,
+                    _In_reads_bytes_(rowPitch * height) const uint8_t* pixels, size_t width, size_t height, size_t rowPitch,
+                    _Out_writes_bytes_(blockRowPitch * ((height + 3) / 4)) uint8_t* blocks, size_t blockRowPitch);
+}
@@ -42,9 +42,11 @@ struct BasicEffectTraits
 {
     using ConstantBufferType = BasicEffectConstants;
 
-    static const int VertexShaderCount = 32;
-    static const int PixelShaderCount = 10;
-    static const int ShaderPermutationCount = 56;
+    static const int VertexShaderCount = 48;
+    static const int PixelShaderCount = 16;
+    static const int ShaderPermutationCount = 184;
+
+    static const BuiltInEffect Effect = BuiltInEffect_Basic;
 };
 
 
@@ -59,16 +61,26 @@ public:
     bool vertexColorEnabled;
     bool textureEnabled;
     bool biasedVertexNormals;
+    bool instancingEnabled;
+    bool instancingSupported;
+    bool shaderModel5Supported;
 
     EffectLights lights;
 
+    ClusteredLights* clusteredLights;
+
+    CascadedShadowMap* shadowMap;
+
+    MultiView* multiView;
+
     int GetCurrentShaderPermutation() const noexcept;
 
     void Apply(_In_ ID3D11DeviceContext* deviceContext);
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -111,6 +123,26 @@ namespace
     #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxBn.inc"
     #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxVcBn.inc"
 
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingInst.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingVcInst.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxInst.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxVcInst.inc"
+
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingInstBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingVcInstBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxInstBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxVcInstBn.inc"
+
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingMultiView.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingVcMultiView.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxMultiView.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxVcMultiView.inc"
+
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingMultiViewBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingVcMultiViewBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxMultiViewBn.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_VSBasicPixelLightingTxVcMultiViewBn.inc"
+
     #include "Shaders/Compiled/XboxOneBasicEffect_PSBasic.inc"
     #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicNoFog.inc"
     #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicTx.inc"
@@ -123,6 +155,14 @@ namespace
 
     #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLighting.inc"
     #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingTx.inc"
+
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingClustered.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingTxClustered.inc"
+
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingShadow.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingTxShadow.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingClusteredShadow.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingTxClusteredShadow.inc"
 #else
     #include "Shaders/Compiled/BasicEffect_VSBasic.inc"
     #include "Shaders/Compiled/BasicEffect_VSBasicNoFog.inc"
@@ -163,6 +203,26 @@ namespace
     #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxBn.inc"
     #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxVcBn.inc"
 
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingInst.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingVcInst.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxInst.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxVcInst.inc"
+
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingInstBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingVcInstBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxInstBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxVcInstBn.inc"
+
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingMultiView.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingVcMultiView.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxMultiView.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxVcMultiView.inc"
+
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingMultiViewBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingVcMultiViewBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxMultiViewBn.inc"
+    #include "Shaders/Compiled/BasicEffect_VSBasicPixelLightingTxVcMultiViewBn.inc"
+
     #include "Shaders/Compiled/BasicEffect_PSBasic.inc"
     #include "Shaders/Compiled/BasicEffect_PSBasicNoFog.inc"
     #include "Shaders/Compiled/BasicEffect_PSBasicTx.inc"
@@ -175,51 +235,80 @@ namespace
 
     #include "Shaders/Compiled/BasicEffect_PSBasicPixelLighting.inc"
     #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingTx.inc"
+
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingClustered.inc"
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingTxClustered.inc"
+
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingShadow.inc"
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingTxShadow.inc"
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingClusteredShadow.inc"
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingTxClusteredShadow.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<BasicEffectTraits>::VertexShaderBytecode[] =
 {
-    { BasicEffect_VSBasic,                     sizeof(BasicEffect_VSBasic)                     },
-    { BasicEffect_VSBasicNoFog,                sizeof(BasicEffect_VSBasicNoFog)                },
-    { BasicEffect_VSBasicVc,                   sizeof(BasicEffect_VSBasicVc)                   },
-    { BasicEffect_VSBasicVcNoFog,              sizeof(BasicEffect_VSBasicVcNoFog)              },
-    { BasicEffect_VSBasicTx,                   sizeof(BasicEffect_VSBasicTx)                   },
-    { BasicEffect_VSBasicTxNoFog,              sizeof(BasicEffect_VSBasicTxNoFog)              },
-    { BasicEffect_VSBasicTxVc,                 sizeof(BasicEffect_VSBasicTxVc)                 },
-    { BasicEffect_VSBasicTxVcNoFog,            sizeof(BasicEffect_VSBasicTxVcNoFog)            },
-
-    { BasicEffect_VSBasicVertexLighting,       sizeof(BasicEffect_VSBasicVertexLighting)       },
-    { BasicEffect_VSBasicVertexLightingVc,     sizeof(BasicEffect_VSBasicVertexLightingVc)     },
-    { BasicEffect_VSBasicVertexLightingTx,     sizeof(BasicEffect_VSBasicVertexLightingTx)     },
-    { BasicEffect_VSBasicVertexLightingTxVc,   sizeof(BasicEffect_VSBasicVertexLightingTxVc)   },
-
-    { BasicEffect_VSBasicOneLight,             sizeof(BasicEffect_VSBasicOneLight)             },
-    { BasicEffect_VSBasicOneLightVc,           sizeof(BasicEffect_VSBasicOneLightVc)           },
-    { BasicEffect_VSBasicOneLightTx,           sizeof(BasicEffect_VSBasicOneLightTx)           },
-    { BasicEffect_VSBasicOneLightTxVc,         sizeof(BasicEffect_VSBasicOneLightTxVc)         },
-
-    { BasicEffect_VSBasicPixelLighting,        sizeof(BasicEffect_VSBasicPixelLighting)        },
-    { BasicEffect_VSBasicPixelLightingVc,      sizeof(BasicEffect_VSBasicPixelLightingVc)      },
-    { BasicEffect_VSBasicPixelLightingTx,      sizeof(BasicEffect_VSBasicPixelLightingTx)      },
-    { BasicEffect_VSBasicPixelLightingTxVc,    sizeof(BasicEffect_VSBasicPixelLightingTxVc)    },
-
-    { BasicEffect_VSBasicVertexLightingBn,     sizeof(BasicEffect_VSBasicVertexLightingBn)     },
-    { BasicEffect_VSBasicVertexLightingVcBn,   sizeof(BasicEffect_VSBasicVertexLightingVcBn)   },
-    { BasicEffect_VSBasicVertexLightingTxBn,   sizeof(BasicEffect_VSBasicVertexLightingTxBn)   },
-    { BasicEffect_VSBasicVertexLightingTxVcBn, sizeof(BasicEffect_VSBasicVertexLightingTxVcBn) },
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasic),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicNoFog),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVc),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVcNoFog),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicTxNoFog),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicTxVc),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicTxVcNoFog),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLighting),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingVc),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingTxVc),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLight),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightVc),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightTxVc),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLighting),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVc),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVc),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingVcBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingTxBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicVertexLightingTxVcBn),
     
-    { BasicEffect_VSBasicOneLightBn,           sizeof(BasicEffect_VSBasicOneLightBn)           },
-    { BasicEffect_VSBasicOneLightVcBn,         sizeof(BasicEffect_VSBasicOneLightVcBn)         },
-    { BasicEffect_VSBasicOneLightTxBn,         sizeof(BasicEffect_VSBasicOneLightTxBn)         },
-    { BasicEffect_VSBasicOneLightTxVcBn,       sizeof(BasicEffect_VSBasicOneLightTxVcBn)       },
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightVcBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightTxBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicOneLightTxVcBn),
     
-    { BasicEffect_VSBasicPixelLightingBn,      sizeof(BasicEffect_VSBasicPixelLightingBn)      },
-    { BasicEffect_VSBasicPixelLightingVcBn,    sizeof(BasicEffect_VSBasicPixelLightingVcBn)    },
-    { BasicEffect_VSBasicPixelLightingTxBn,    sizeof(BasicEffect_VSBasicPixelLightingTxBn)    },
-    { BasicEffect_VSBasicPixelLightingTxVcBn,  sizeof(BasicEffect_VSBasicPixelLightingTxVcBn)  },
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVcBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVcBn),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingInst),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVcInst),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxInst),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVcInst),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingInstBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVcInstBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxInstBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVcInstBn),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingMultiView),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVcMultiView),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxMultiView),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVcMultiView),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingMultiViewBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingVcMultiViewBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxMultiViewBn),
+    EFFECT_SHADER_BYTECODE(BasicEffect_VSBasicPixelLightingTxVcMultiViewBn),
 };
 
 
@@ -288,24 +377,176 @@ const int EffectBase<BasicEffectTraits>::VertexShaderIndices[] =
     30,     // pixel lighting (biased vertex normals) + texture, no fog
     31,     // pixel lighting (biased vertex normals) + texture + vertex color
     31,     // pixel lighting (biased vertex normals) + texture + vertex color, no fog
+
+    32,     // pixel lighting (instancing)
+    32,     // pixel lighting (instancing), no fog
+    33,     // pixel lighting (instancing) + vertex color
+    33,     // pixel lighting (instancing) + vertex color, no fog
+    34,     // pixel lighting (instancing) + texture
+    34,     // pixel lighting (instancing) + texture, no fog
+    35,     // pixel lighting (instancing) + texture + vertex color
+    35,     // pixel lighting (instancing) + texture + vertex color, no fog
+
+    36,     // pixel lighting (instancing, biased vertex normals)
+    36,     // pixel lighting (instancing, biased vertex normals), no fog
+    37,     // pixel lighting (instancing, biased vertex normals) + vertex color
+    37,     // pixel lighting (instancing, biased vertex normals) + vertex color, no fog
+    38,     // pixel lighting (instancing, biased vertex normals) + texture
+    38,     // pixel lighting (instancing, biased vertex normals) + texture, no fog
+    39,     // pixel lighting (instancing, biased vertex normals) + texture + vertex color
+    39,     // pixel lighting (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    16,     // clustered
+    16,     // clustered, no fog
+    17,     // clustered + vertex color
+    17,     // clustered + vertex color, no fog
+    18,     // clustered + texture
+    18,     // clustered + texture, no fog
+    19,     // clustered + texture + vertex color
+    19,     // clustered + texture + vertex color, no fog
+
+    28,     // clustered (biased vertex normals)
+    28,     // clustered (biased vertex normals), no fog
+    29,     // clustered (biased vertex normals) + vertex color
+    29,     // clustered (biased vertex normals) + vertex color, no fog
+    30,     // clustered (biased vertex normals) + texture
+    30,     // clustered (biased vertex normals) + texture, no fog
+    31,     // clustered (biased vertex normals) + texture + vertex color
+    31,     // clustered (biased vertex normals) + texture + vertex color, no fog
+
+    32,     // clustered (instancing)
+    32,     // clustered (instancing), no fog
+    33,     // clustered (instancing) + vertex color
+    33,     // clustered (instancing) + vertex color, no fog
+    34,     // clustered (instancing) + texture
+    34,     // clustered (instancing) + texture, no fog
+    35,     // clustered (instancing) + texture + vertex color
+    35,     // clustered (instancing) + texture + vertex color, no fog
+
+    36,     // clustered (instancing, biased vertex normals)
+    36,     // clustered (instancing, biased vertex normals), no fog
+    37,     // clustered (instancing, biased vertex normals) + vertex color
+    37,     // clustered (instancing, biased vertex normals) + vertex color, no fog
+    38,     // clustered (instancing, biased vertex normals) + texture
+    38,     // clustered (instancing, biased vertex normals) + texture, no fog
+    39,     // clustered (instancing, biased vertex normals) + texture + vertex color
+    39,     // clustered (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    16,     // shadows
+    16,     // shadows, no fog
+    17,     // shadows + vertex color
+    17,     // shadows + vertex color, no fog
+    18,     // shadows + texture
+    18,     // shadows + texture, no fog
+    19,     // shadows + texture + vertex color
+    19,     // shadows + texture + vertex color, no fog
+
+    28,     // shadows (biased vertex normals)
+    28,     // shadows (biased vertex normals), no fog
+    29,     // shadows (biased vertex normals) + vertex color
+    29,     // shadows (biased vertex normals) + vertex color, no fog
+    30,     // shadows (biased vertex normals) + texture
+    30,     // shadows (biased vertex normals) + texture, no fog
+    31,     // shadows (biased vertex normals) + texture + vertex color
+    31,     // shadows (biased vertex normals) + texture + vertex color, no fog
+
+    32,     // shadows (instancing)
+    32,     // shadows (instancing), no fog
+    33,     // shadows (instancing) + vertex color
+    33,     // shadows (instancing) + vertex color, no fog
+    34,     // shadows (instancing) + texture
+    34,     // shadows (instancing) + texture, no fog
+    35,     // shadows (instancing) + texture + vertex color
+    35,     // shadows (instancing) + texture + vertex color, no fog
+
+    36,     // shadows (instancing, biased vertex normals)
+    36,     // shadows (instancing, biased vertex normals), no fog
+    37,     // shadows (instancing, biased vertex normals) + vertex color
+    37,     // shadows (instancing, biased vertex normals) + vertex color, no fog
+    38,     // shadows (instancing, biased vertex normals) + texture
+    38,     // shadows (instancing, biased vertex normals) + texture, no fog
+    39,     // shadows (instancing, biased vertex normals) + texture + vertex color
+    39,     // shadows (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    16,     // clustered + shadows
+    16,     // clustered + shadows, no fog
+    17,     // clustered + shadows + vertex color
+    17,     // clustered + shadows + vertex color, no fog
+    18,     // clustered + shadows + texture
+    18,     // clustered + shadows + texture, no fog
+    19,     // clustered + shadows + texture + vertex color
+    19,     // clustered + shadows + texture + vertex color, no fog
+
+    28,     // clustered + shadows (biased vertex normals)
+    28,     // clustered + shadows (biased vertex normals), no fog
+    29,     // clustered + shadows (biased vertex normals) + vertex color
+    29,     // clustered + shadows (biased vertex normals) + vertex color, no fog
+    30,     // clustered + shadows (biased vertex normals) + texture
+    30,     // clustered + shadows (biased vertex normals) + texture, no fog
+    31,     // clustered + shadows (biased vertex normals) + texture + vertex color
+    31,     // clustered + shadows (biased vertex normals) + texture + vertex color, no fog
+
+    32,     // clustered + shadows (instancing)
+    32,     // clustered + shadows (instancing), no fog
+    33,     // clustered + shadows (instancing) + vertex color
+    33,     // clustered + shadows (instancing) + vertex color, no fog
+    34,     // clustered + shadows (instancing) + texture
+    34,     // clustered + shadows (instancing) + texture, no fog
+    35,     // clustered + shadows (instancing) + texture + vertex color
+    35,     // clustered + shadows (instancing) + texture + vertex color, no fog
+
+    36,     // clustered + shadows (instancing, biased vertex normals)
+    36,     // clustered + shadows (instancing, biased vertex normals), no fog
+    37,     // clustered + shadows (instancing, biased vertex normals) + vertex color
+    37,     // clustered + shadows (instancing, biased vertex normals) + vertex color, no fog
+    38,     // clustered + shadows (instancing, biased vertex normals) + texture
+    38,     // clustered + shadows (instancing, biased vertex normals) + texture, no fog
+    39,     // clustered + shadows (instancing, biased vertex normals) + texture + vertex color
+    39,     // clustered + shadows (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    40,     // pixel lighting (multi-view)
+    40,     // pixel lighting (multi-view), no fog
+    41,     // pixel lighting (multi-view) + vertex color
+    41,     // pixel lighting (multi-view) + vertex color, no fog
+    42,     // pixel lighting (multi-view) + texture
+    42,     // pixel lighting (multi-view) + texture, no fog
+    43,     // pixel lighting (multi-view) + texture + vertex color
+    43,     // pixel lighting (multi-view) + texture + vertex color, no fog
+
+    44,     // pixel lighting (multi-view, biased vertex normals)
+    44,     // pixel lighting (multi-view, biased vertex normals), no fog
+    45,     // pixel lighting (multi-view, biased vertex normals) + vertex color
+    45,     // pixel lighting (multi-view, biased vertex normals) + vertex color, no fog
+    46,     // pixel lighting (multi-view, biased vertex normals) + texture
+    46,     // pixel lighting (multi-view, biased vertex normals) + texture, no fog
+    47,     // pixel lighting (multi-view, biased vertex normals) + texture + vertex color
+    47,     // pixel lighting (multi-view, biased vertex normals) + texture + vertex color, no fog
 };
 
 
 template<>
 const ShaderBytecode EffectBase<BasicEffectTraits>::PixelShaderBytecode[] =
 {
-    { BasicEffect_PSBasic,                      sizeof(BasicEffect_PSBasic)                      },
-    { BasicEffect_PSBasicNoFog,                 sizeof(BasicEffect_PSBasicNoFog)                 },
-    { BasicEffect_PSBasicTx,                    sizeof(BasicEffect_PSBasicTx)                    },
-    { BasicEffect_PSBasicTxNoFog,               sizeof(BasicEffect_PSBasicTxNoFog)               },
-
-    { BasicEffect_PSBasicVertexLighting,        sizeof(BasicEffect_PSBasicVertexLighting)        },
-    { BasicEffect_PSBasicVertexLightingNoFog,   sizeof(BasicEffect_PSBasicVertexLightingNoFog)   },
-    { BasicEffect_PSBasicVertexLightingTx,      sizeof(BasicEffect_PSBasicVertexLightingTx)      },
-    { BasicEffect_PSBasicVertexLightingTxNoFog, sizeof(BasicEffect_PSBasicVertexLightingTxNoFog) },
-
-    { BasicEffect_PSBasicPixelLighting,         sizeof(BasicEffect_PSBasicPixelLighting)         },
-    { BasicEffect_PSBasicPixelLightingTx,       sizeof(BasicEffect_PSBasicPixelLightingTx)       },
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasic),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicNoFog),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicTxNoFog),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicVertexLighting),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicVertexLightingNoFog),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicVertexLightingTx),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicVertexLightingTxNoFog),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLighting),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingTx),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingClustered),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingTxClustered),
+
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingShadow),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingTxShadow),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingClusteredShadow),
+    EFFECT_SHADER_BYTECODE(BasicEffect_PSBasicPixelLightingTxClusteredShadow),
 };
 
 
@@ -374,6 +615,150 @@ const int EffectBase<BasicEffectTraits>::PixelShaderIndices[] =
     9,      // pixel lighting (biased vertex normals) + texture, no fog
     9,      // pixel lighting (biased vertex normals) + texture + vertex color
     9,      // pixel lighting (biased vertex normals) + texture + vertex color, no fog
+
+    8,      // pixel lighting (instancing)
+    8,      // pixel lighting (instancing), no fog
+    8,      // pixel lighting (instancing) + vertex color
+    8,      // pixel lighting (instancing) + vertex color, no fog
+    9,      // pixel lighting (instancing) + texture
+    9,      // pixel lighting (instancing) + texture, no fog
+    9,      // pixel lighting (instancing) + texture + vertex color
+    9,      // pixel lighting (instancing) + texture + vertex color, no fog
+
+    8,      // pixel lighting (instancing, biased vertex normals)
+    8,      // pixel lighting (instancing, biased vertex normals), no fog
+    8,      // pixel lighting (instancing, biased vertex normals) + vertex color
+    8,      // pixel lighting (instancing, biased vertex normals) + vertex color, no fog
+    9,      // pixel lighting (instancing, biased vertex normals) + texture
+    9,      // pixel lighting (instancing, biased vertex normals) + texture, no fog
+    9,      // pixel lighting (instancing, biased vertex normals) + texture + vertex color
+    9,      // pixel lighting (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    10,     // clustered
+    10,     // clustered, no fog
+    10,     // clustered + vertex color
+    10,     // clustered + vertex color, no fog
+    11,     // clustered + texture
+    11,     // clustered + texture, no fog
+    11,     // clustered + texture + vertex color
+    11,     // clustered + texture + vertex color, no fog
+
+    10,     // clustered (biased vertex normals)
+    10,     // clustered (biased vertex normals), no fog
+    10,     // clustered (biased vertex normals) + vertex color
+    10,     // clustered (biased vertex normals) + vertex color, no fog
+    11,     // clustered (biased vertex normals) + texture
+    11,     // clustered (biased vertex normals) + texture, no fog
+    11,     // clustered (biased vertex normals) + texture + vertex color
+    11,     // clustered (biased vertex normals) + texture + vertex color, no fog
+
+    10,     // clustered (instancing)
+    10,     // clustered (instancing), no fog
+    10,     // clustered (instancing) + vertex color
+    10,     // clustered (instancing) + vertex color, no fog
+    11,     // clustered (instancing) + texture
+    11,     // clustered (instancing) + texture, no fog
+    11,     // clustered (instancing) + texture + vertex color
+    11,     // clustered (instancing) + texture + vertex color, no fog
+
+    10,     // clustered (instancing, biased vertex normals)
+    10,     // clustered (instancing, biased vertex normals), no fog
+    10,     // clustered (instancing, biased vertex normals) + vertex color
+    10,     // clustered (instancing, biased vertex normals) + vertex color, no fog
+    11,     // clustered (instancing, biased vertex normals) + texture
+    11,     // clustered (instancing, biased vertex normals) + texture, no fog
+    11,     // clustered (instancing, biased vertex normals) + texture + vertex color
+    11,     // clustered (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    12,     // shadows
+    12,     // shadows, no fog
+    12,     // shadows + vertex color
+    12,     // shadows + vertex color, no fog
+    13,     // shadows + texture
+    13,     // shadows + texture, no fog
+    13,     // shadows + texture + vertex color
+    13,     // shadows + texture + vertex color, no fog
+
+    12,     // shadows (biased vertex normals)
+    12,     // shadows (biased vertex normals), no fog
+    12,     // shadows (biased vertex normals) + vertex color
+    12,     // shadows (biased vertex normals) + vertex color, no fog
+    13,     // shadows (biased vertex normals) + texture
+    13,     // shadows (biased vertex normals) + texture, no fog
+    13,     // shadows (biased vertex normals) + texture + vertex color
+    13,     // shadows (biased vertex normals) + texture + vertex color, no fog
+
+    12,     // shadows (instancing)
+    12,     // shadows (instancing), no fog
+    12,     // shadows (instancing) + vertex color
+    12,     // shadows (instancing) + vertex color, no fog
+    13,     // shadows (instancing) + texture
+    13,     // shadows (instancing) + texture, no fog
+    13,     // shadows (instancing) + texture + vertex color
+    13,     // shadows (instancing) + texture + vertex color, no fog
+
+    12,     // shadows (instancing, biased vertex normals)
+    12,     // shadows (instancing, biased vertex normals), no fog
+    12,     // shadows (instancing, biased vertex normals) + vertex color
+    12,     // shadows (instancing, biased vertex normals) + vertex color, no fog
+    13,     // shadows (instancing, biased vertex normals) + texture
+    13,     // shadows (instancing, biased vertex normals) + texture, no fog
+    13,     // shadows (instancing, biased vertex normals) + texture + vertex color
+    13,     // shadows (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    14,     // clustered + shadows
+    14,     // clustered + shadows, no fog
+    14,     // clustered + shadows + vertex color
+    14,     // clustered + shadows + vertex color, no fog
+    15,     // clustered + shadows + texture
+    15,     // clustered + shadows + texture, no fog
+    15,     // clustered + shadows + texture + vertex color
+    15,     // clustered + shadows + texture + vertex color, no fog
+
+    14,     // clustered + shadows (biased vertex normals)
+    14,     // clustered + shadows (biased vertex normals), no fog
+    14,     // clustered + shadows (biased vertex normals) + vertex color
+    14,     // clustered + shadows (biased vertex normals) + vertex color, no fog
+    15,     // clustered + shadows (biased vertex normals) + texture
+    15,     // clustered + shadows (biased vertex normals) + texture, no fog
+    15,     // clustered + shadows (biased vertex normals) + texture + vertex color
+    15,     // clustered + shadows (biased vertex normals) + texture + vertex color, no fog
+
+    14,     // clustered + shadows (instancing)
+    14,     // clustered + shadows (instancing), no fog
+    14,     // clustered + shadows (instancing) + vertex color
+    14,     // clustered + shadows (instancing) + vertex color, no fog
+    15,     // clustered + shadows (instancing) + texture
+    15,     // clustered + shadows (instancing) + texture, no fog
+    15,     // clustered + shadows (instancing) + texture + vertex color
+    15,     // clustered + shadows (instancing) + texture + vertex color, no fog
+
+    14,     // clustered + shadows (instancing, biased vertex normals)
+    14,     // clustered + shadows (instancing, biased vertex normals), no fog
+    14,     // clustered + shadows (instancing, biased vertex normals) + vertex color
+    14,     // clustered + shadows (instancing, biased vertex normals) + vertex color, no fog
+    15,     // clustered + shadows (instancing, biased vertex normals) + texture
+    15,     // clustered + shadows (instancing, biased vertex normals) + texture, no fog
+    15,     // clustered + shadows (instancing, biased vertex normals) + texture + vertex color
+    15,     // clustered + shadows (instancing, biased vertex normals) + texture + vertex color, no fog
+
+    8,      // pixel lighting (multi-view)
+    8,      // pixel lighting (multi-view), no fog
+    8,      // pixel lighting (multi-view) + vertex color
+    8,      // pixel lighting (multi-view) + vertex color, no fog
+    9,      // pixel lighting (multi-view) + texture
+    9,      // pixel lighting (multi-view) + texture, no fog
+    9,      // pixel lighting (multi-view) + texture + vertex color
+    9,      // pixel lighting (multi-view) + texture + vertex color, no fog
+
+    8,      // pixel lighting (multi-view, biased vertex normals)
+    8,      // pixel lighting (multi-view, biased vertex normals), no fog
+    8,      // pixel lighting (multi-view, biased vertex normals) + vertex color
+    8,      // pixel lighting (multi-view, biased vertex normals) + vertex color, no fog
+    9,      // pixel lighting (multi-view, biased vertex normals) + texture
+    9,      // pixel lighting (multi-view, biased vertex normals) + texture, no fog
+    9,      // pixel lighting (multi-view, biased vertex normals) + texture + vertex color
+    9,      // pixel lighting (multi-view, biased vertex normals) + texture + vertex color, no fog
 };
 
 
@@ -382,6 +767,14 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<BasicEffectTraits>::DeviceResources> EffectBase<BasicEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllBasicEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<BasicEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 BasicEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -389,7 +782,13 @@ BasicEffect::Impl::Impl(_In_ ID3D11Device* device)
     preferPerPixelLighting(false),
     vertexColorEnabled(false),
     textureEnabled(false),
-    biasedVertexNormals(false)
+    biasedVertexNormals(false),
+    instancingEnabled(false),
+    instancingSupported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0),
+    shaderModel5Supported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0),
+    clusteredLights(nullptr),
+    shadowMap(nullptr),
+    multiView(nullptr)
 {
     static_assert(_countof(EffectBase<BasicEffectTraits>::VertexShaderIndices) == BasicEffectTraits::ShaderPermutationCount, "array/max mismatch");
     static_assert(_countof(EffectBase<BasicEffectTraits>::VertexShaderBytecode) == BasicEffectTraits::VertexShaderCount, "array/max mismatch");
@@ -422,7 +821,58 @@ int BasicEffect::Impl::GetCurrentShaderPermutation() const noexcept
         permutation += 4;
     }
 
-    if (lightingEnabled)
+    if (multiView)
+    {
+        // Multi-view shaders always do lighting in the pixel shader.
+        permutation += 168;
+
+        if (biasedVertexNormals)
+        {
+            permutation += 8;
+        }
+    }
+    else if (lightingEnabled && shadowMap)
+    {
+        // Shadows are always done in the pixel shader, with or without clustered lights.
+        permutation += clusteredLights ? 136 : 104;
+
+        if (biasedVertexNormals)
+        {
+            permutation += 8;
+        }
+
+        if (instancingEnabled)
+        {
+            permutation += 16;
+        }
+    }
+    else if (lightingEnabled && clusteredLights)
+    {
+        // Clustered lights are always done in the pixel shader.
+        permutation += 72;
+
+        if (biasedVertexNormals)
+        {
+            permutation += 8;
+        }
+
+        if (instancingEnabled)
+        {
+            permutation += 16;
+        }
+    }
+    else if (lightingEnabled && instancingEnabled)
+    {
+        // Instanced shaders always do lighting in the pixel shader.
+        permutation += 56;
+
+        if (biasedVertexNormals)
+        {
+            // Compressed normals need to be scaled and biased in the vertex shader.
+            permutation += 8;
+        }
+    }
+    else if (lightingEnabled)
     {
         if (preferPerPixelLighting)
         {
@@ -454,6 +904,15 @@ int BasicEffect::Impl::GetCurrentShaderPermutation() const noexcept
 // Sets our state onto the D3D device.
 void BasicEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    if (multiView)
+    {
+        if (!lightingEnabled)
+            throw std::exception("BasicEffect multi-view requires lighting to be enabled");
+
+        if (instancingEnabled || clusteredLights || shadowMap)
+            throw std::exception("BasicEffect multi-view cannot be combined with instancing, clustered lights, or shadows");
+    }
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -469,6 +928,21 @@ void BasicEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         deviceContext->PSSetShaderResources(0, 1, textures);
     }
 
+    if (lightingEnabled && clusteredLights)
+    {
+        clusteredLights->Apply(deviceContext);
+    }
+
+    if (lightingEnabled && shadowMap)
+    {
+        shadowMap->Apply(deviceContext);
+    }
+
+    if (multiView)
+    {
+        multiView->Apply(deviceContext);
+    }
+
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
 }
@@ -505,6 +979,8 @@ BasicEffect::~BasicEffect()
 // IEffect methods.
 void BasicEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"BasicEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -616,6 +1092,11 @@ void XM_CALLCONV BasicEffect::SetColorAndAlpha(FXMVECTOR value)
 // Light settings.
 void BasicEffect::SetLightingEnabled(bool value)
 {
+    if (!value && pImpl->instancingEnabled)
+    {
+        throw std::exception("BasicEffect instancing requires lighting to be enabled");
+    }
+
     pImpl->lightingEnabled = value;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::MaterialColor;
@@ -728,3 +1209,55 @@ void BasicEffect::SetBiasedVertexNormals(bool value)
 {
     pImpl->biasedVertexNormals = value;
 }
+
+
+// Instancing settings.
+void BasicEffect::SetInstancingEnabled(bool value)
+{
+    if (value && !pImpl->instancingSupported)
+    {
+        throw std::exception("BasicEffect instancing requires Feature Level 10.0 or later");
+    }
+
+    if (value && !pImpl->lightingEnabled)
+    {
+        throw std::exception("BasicEffect instancing requires lighting to be enabled");
+    }
+
+    pImpl->instancingEnabled = value;
+}
+
+
+// Clustered light settings.
+void BasicEffect::SetClusteredLights(_In_opt_ ClusteredLights* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("BasicEffect clustered lights require Feature Level 11.0 or later");
+    }
+
+    pImpl->clusteredLights = value;
+}
+
+
+void BasicEffect::SetShadowMap(_In_opt_ CascadedShadowMap* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("BasicEffect shadows require Feature Level 11.0 or later");
+    }
+
+    pImpl->shadowMap = value;
+}
+
+
+// Multi-view settings.
+void BasicEffect::SetMultiView(_In_opt_ MultiView* value)
+{
+    if (value && !pImpl->instancingSupported)
+    {
+        throw std::exception("BasicEffect multi-view requires Feature Level 10.0 or later");
+    }
+
+    pImpl->multiView = value;
+}
@@ -9,12 +9,14 @@
 
 #include "pch.h"
 #include "PostProcess.h"
+#include "Effects.h"
 
 #include "AlignedNew.h"
 #include "CommonStates.h"
 #include "ConstantBuffer.h"
 #include "DemandCreate.h"
 #include "DirectXHelpers.h"
+#include "GpuProfiler.h"
 #include "SharedResourcePool.h"
 
 using namespace DirectX;
@@ -58,6 +60,11 @@ namespace
     #include "Shaders/Compiled/XboxOnePostProcess_PSGaussianBlur5x5.inc"
     #include "Shaders/Compiled/XboxOnePostProcess_PSBloomExtract.inc"
     #include "Shaders/Compiled/XboxOnePostProcess_PSBloomBlur.inc"
+
+    #include "Shaders/Compiled/XboxOnePostProcessCompute_CSDownScale2x2.inc"
+    #include "Shaders/Compiled/XboxOnePostProcessCompute_CSDownScale4x4.inc"
+    #include "Shaders/Compiled/XboxOnePostProcessCompute_CSGaussianBlur5x5.inc"
+    #include "Shaders/Compiled/XboxOnePostProcessCompute_CSBloomBlur.inc"
 #else
     #include "Shaders/Compiled/PostProcess_VSQuad.inc"
 
@@ -69,6 +76,11 @@ namespace
     #include "Shaders/Compiled/PostProcess_PSGaussianBlur5x5.inc"
     #include "Shaders/Compiled/PostProcess_PSBloomExtract.inc"
     #include "Shaders/Compiled/PostProcess_PSBloomBlur.inc"
+
+    #include "Shaders/Compiled/PostProcessCompute_CSDownScale2x2.inc"
+    #include "Shaders/Compiled/PostProcessCompute_CSDownScale4x4.inc"
+    #include "Shaders/Compiled/PostProcessCompute_CSGaussianBlur5x5.inc"
+    #include "Shaders/Compiled/PostProcessCompute_CSBloomBlur.inc"
 #endif
 }
 
@@ -94,6 +106,25 @@ namespace
 
     static_assert(_countof(pixelShaders) == BasicPostProcess::Effect_Max, "array/max mismatch");
 
+    // Compute versions, used for render targets that also allow unordered access.
+    const ShaderBytecode computeShaders[] =
+    {
+        { nullptr,                              0 },
+        { nullptr,                              0 },
+        { nullptr,                              0 },
+        { PostProcessCompute_CSDownScale2x2,    sizeof(PostProcessCompute_CSDownScale2x2) },
+        { PostProcessCompute_CSDownScale4x4,    sizeof(PostProcessCompute_CSDownScale4x4) },
+        { PostProcessCompute_CSGaussianBlur5x5, sizeof(PostProcessCompute_CSGaussianBlur5x5) },
+        { nullptr,                              0 },
+        { PostProcessCompute_CSBloomBlur,       sizeof(PostProcessCompute_CSBloomBlur) },
+    };
+
+    static_assert(_countof(computeShaders) == BasicPostProcess::Effect_Max, "array/max mismatch");
+
+    // Must match the thread group sizes in PostProcessCompute.fx.
+    const UINT c_ComputeTile = 8;
+    const UINT c_BloomRun = 128;
+
     // Factory for lazily instantiating shaders.
     class DeviceResources
     {
@@ -103,6 +134,7 @@ namespace
             mDevice(device),
             mVertexShader{},
             mPixelShaders{},
+            mComputeShaders{},
             mMutex{}
         { }
 
@@ -137,12 +169,31 @@ namespace
             });
         }
 
+        // Gets or lazily creates the compute version of the specified effect.
+        ID3D11ComputeShader* GetComputeShader(int shaderIndex)
+        {
+            assert(shaderIndex >= 0 && shaderIndex < BasicPostProcess::Effect_Max);
+            _Analysis_assume_(shaderIndex >= 0 && shaderIndex < BasicPostProcess::Effect_Max);
+            assert(computeShaders[shaderIndex].code != nullptr);
+
+            return DemandCreate(mComputeShaders[shaderIndex], mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(computeShaders[shaderIndex].code, computeShaders[shaderIndex].length, nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BasicPostProcess");
+
+                return hr;
+            });
+        }
+
         CommonStates                stateObjects;
 
     protected:
         ComPtr<ID3D11Device>        mDevice;
         ComPtr<ID3D11VertexShader>  mVertexShader;
         ComPtr<ID3D11PixelShader>   mPixelShaders[BasicPostProcess::Effect_Max];
+        ComPtr<ID3D11ComputeShader> mComputeShaders[BasicPostProcess::Effect_Max];
         std::mutex                  mMutex;
     };
 }
@@ -168,10 +219,24 @@ public:
     float                                   bloomBrightness;
     float                                   bloomThreshold;
     bool                                    bloomHorizontal;
+    bool                                    useCompute;
 
 private:
     bool                                    mUseConstants;
     int                                     mDirtyFlags;
+    bool                                    mComputeSupported;
+
+    // Whether the last render target seen by the compute path can be written through a UAV. No reference is kept,
+    // as the target is often a swap chain buffer the application must be free to resize; the description guards
+    // against another texture being created at the same address.
+    ID3D11Resource*                         mComputeTarget;
+    D3D11_TEXTURE2D_DESC                    mComputeTargetDesc;
+    DXGI_FORMAT                             mComputeTargetFormat;
+    UINT                                    mComputeTargetMip;
+    bool                                    mComputeTargetUsable;
+
+    void                                    UpdateConstants(_In_ ID3D11DeviceContext* deviceContext, bool compute);
+    bool                                    ProcessCompute(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl()>& setCustomState);
 
     void                                    DownScale2x2();
     void                                    DownScale4x4();
@@ -202,8 +267,15 @@ BasicPostProcess::Impl::Impl(_In_ ID3D11Device* device)
     bloomBrightness(1.f),
     bloomThreshold(0.25f),
     bloomHorizontal(true),
+    useCompute(false),
     mUseConstants(false),
     mDirtyFlags(INT_MAX),
+    mComputeSupported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0),
+    mComputeTarget(nullptr),
+    mComputeTargetDesc{},
+    mComputeTargetFormat(DXGI_FORMAT_UNKNOWN),
+    mComputeTargetMip(0),
+    mComputeTargetUsable(false),
     mConstantBuffer(device),
     mDeviceResources(deviceResourcesPool.DemandCreate(device))
 {
@@ -217,6 +289,12 @@ BasicPostProcess::Impl::Impl(_In_ ID3D11Device* device)
 // Sets our state onto the D3D device.
 void BasicPostProcess::Impl::Process(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl()>& setCustomState)
 {
+    if (useCompute && mComputeSupported && computeShaders[fx].code)
+    {
+        if (ProcessCompute(deviceContext, setCustomState))
+            return;
+    }
+
     // Set the texture.
     ID3D11ShaderResourceView* textures[1] = { texture.Get() };
     deviceContext->PSSetShaderResources(0, 1, textures);
@@ -236,75 +314,205 @@ void BasicPostProcess::Impl::Process(_In_ ID3D11DeviceContext* deviceContext, st
     deviceContext->VSSetShader(vertexShader, nullptr, 0);
     deviceContext->PSSetShader(pixelShader, nullptr, 0);
 
+    InvalidateEffectStateCache(deviceContext);
+
     // Set constants.
     if (mUseConstants)
     {
-        if (mDirtyFlags & Dirty_Parameters)
-        {
-            mDirtyFlags &= ~Dirty_Parameters;
-            mDirtyFlags |= Dirty_ConstantBuffer;
+        UpdateConstants(deviceContext, false);
+    }
 
-            switch (fx)
-            {
-            case DownScale_2x2:
-                DownScale2x2();
-                break;
+    if (setCustomState)
+    {
+        setCustomState();
+    }
+
+    // Draw quad.
+    deviceContext->IASetInputLayout(nullptr);
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    deviceContext->Draw(3, 0);
+}
+
+
+// Refreshes the constant buffer if needed, and binds it to the pixel or compute stage.
+void BasicPostProcess::Impl::UpdateConstants(_In_ ID3D11DeviceContext* deviceContext, bool compute)
+{
+    if (mDirtyFlags & Dirty_Parameters)
+    {
+        mDirtyFlags &= ~Dirty_Parameters;
+        mDirtyFlags |= Dirty_ConstantBuffer;
 
-            case DownScale_4x4:
-                DownScale4x4();
-                break;
+        switch (fx)
+        {
+        case DownScale_2x2:
+            DownScale2x2();
+            break;
 
-            case GaussianBlur_5x5:
-                GaussianBlur5x5(guassianMultiplier);
-                break;
+        case DownScale_4x4:
+            DownScale4x4();
+            break;
 
-            case BloomExtract:
-                constants.sampleWeights[0] = XMVectorReplicate(bloomThreshold);
-                break;
+        case GaussianBlur_5x5:
+            GaussianBlur5x5(guassianMultiplier);
+            break;
+
+        case BloomExtract:
+            constants.sampleWeights[0] = XMVectorReplicate(bloomThreshold);
+            break;
 
-            case BloomBlur:
-                Bloom(bloomHorizontal, bloomSize, bloomBrightness);
-                break;
+        case BloomBlur:
+            Bloom(bloomHorizontal, bloomSize, bloomBrightness);
+            break;
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
+    }
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
-        void *grfxMemory;
-        mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
 
-        Microsoft::WRL::ComPtr<ID3D11DeviceContextX> deviceContextX;
-        ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+    Microsoft::WRL::ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
 
-        auto buffer = mConstantBuffer.GetBuffer();
+    auto buffer = mConstantBuffer.GetBuffer();
 
+    if (compute)
+        deviceContextX->CSSetPlacementConstantBuffer(0, buffer, grfxMemory);
+    else
         deviceContextX->PSSetPlacementConstantBuffer(0, buffer, grfxMemory);
 #else
-        if (mDirtyFlags & Dirty_ConstantBuffer)
-        {
-            mDirtyFlags &= ~Dirty_ConstantBuffer;
-            mConstantBuffer.SetData(deviceContext, constants);
-        }
+    if (mDirtyFlags & Dirty_ConstantBuffer)
+    {
+        mDirtyFlags &= ~Dirty_ConstantBuffer;
+        mConstantBuffer.SetData(deviceContext, constants);
+    }
 
-        // Set the constant buffer.
-        auto buffer = mConstantBuffer.GetBuffer();
+    // Set the constant buffer.
+    auto buffer = mConstantBuffer.GetBuffer();
 
+    if (compute)
+        deviceContext->CSSetConstantBuffers(0, 1, &buffer);
+    else
         deviceContext->PSSetConstantBuffers(0, 1, &buffer);
 #endif
+}
+
+
+// Runs the effect as a compute shader writing straight into the bound render target. Returns false if the
+// target cannot be used that way, in which case the caller draws with the pixel shader instead.
+bool BasicPostProcess::Impl::ProcessCompute(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl()>& setCustomState)
+{
+    ID3D11RenderTargetView* rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    ComPtr<ID3D11DepthStencilView> dsv;
+    deviceContext->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, rtvs, dsv.GetAddressOf());
+
+    // OMGetRenderTargets adds references, which are released on return.
+    ComPtr<ID3D11RenderTargetView> heldTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    for (UINT j = 0; j < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++j)
+    {
+        heldTargets[j].Attach(rtvs[j]);
     }
 
+    auto rtv = rtvs[0];
+
+    if (!rtv || !texture)
+        return false;
+
+    D3D11_RENDER_TARGET_VIEW_DESC rtvDesc;
+    rtv->GetDesc(&rtvDesc);
+
+    if (rtvDesc.ViewDimension != D3D11_RTV_DIMENSION_TEXTURE2D)
+        return false;
+
+    ComPtr<ID3D11Resource> res;
+    rtv->GetResource(res.GetAddressOf());
+
+    ComPtr<ID3D11Texture2D> tex;
+    ThrowIfFailed(res.As(&tex));
+
+    D3D11_TEXTURE2D_DESC desc;
+    tex->GetDesc(&desc);
+
+    ComPtr<ID3D11Device> device;
+    deviceContext->GetDevice(device.GetAddressOf());
+
+    if (res.Get() != mComputeTarget
+        || memcmp(&desc, &mComputeTargetDesc, sizeof(desc)) != 0
+        || rtvDesc.Format != mComputeTargetFormat
+        || rtvDesc.Texture2D.MipSlice != mComputeTargetMip)
+    {
+        mComputeTarget = res.Get();
+        mComputeTargetDesc = desc;
+        mComputeTargetFormat = rtvDesc.Format;
+        mComputeTargetMip = rtvDesc.Texture2D.MipSlice;
+
+        UINT support = 0;
+        mComputeTargetUsable = (desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS)
+            && SUCCEEDED(device->CheckFormatSupport(rtvDesc.Format, &support))
+            && (support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW);
+    }
+
+    if (!mComputeTargetUsable)
+        return false;
+
+    UINT width = std::max(desc.Width >> mComputeTargetMip, 1u);
+    UINT height = std::max(desc.Height >> mComputeTargetMip, 1u);
+
+    // The blurs read texels by index, which only lines up when the target matches the source.
+    if ((fx == GaussianBlur_5x5 || fx == BloomBlur) && (width != texWidth || height != texHeight))
+        return false;
+
+    // Made for each Process, so nothing holds on to the target afterwards.
+    ComPtr<ID3D11UnorderedAccessView> uav;
+    CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_TEXTURE2D, rtvDesc.Format, rtvDesc.Texture2D.MipSlice);
+    ThrowIfFailed(device->CreateUnorderedAccessView(res.Get(), &uavDesc, uav.GetAddressOf()));
+
+    SetDebugObjectName(uav.Get(), "BasicPostProcess");
+
+    deviceContext->OMSetRenderTargets(0, nullptr, nullptr);
+
+    ID3D11ShaderResourceView* textures[1] = { texture.Get() };
+    deviceContext->CSSetShaderResources(0, 1, textures);
+
+    auto sampler = mDeviceResources->stateObjects.LinearClamp();
+    deviceContext->CSSetSamplers(0, 1, &sampler);
+
+    auto uavPtr = uav.Get();
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &uavPtr, nullptr);
+
+    deviceContext->CSSetShader(mDeviceResources->GetComputeShader(fx), nullptr, 0);
+
+    UpdateConstants(deviceContext, true);
+
     if (setCustomState)
     {
         setCustomState();
     }
 
-    // Draw quad.
-    deviceContext->IASetInputLayout(nullptr);
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    if (fx == BloomBlur)
+    {
+        if (bloomHorizontal)
+            deviceContext->Dispatch((width + c_BloomRun - 1) / c_BloomRun, height, 1);
+        else
+            deviceContext->Dispatch((height + c_BloomRun - 1) / c_BloomRun, width, 1);
+    }
+    else
+    {
+        deviceContext->Dispatch((width + c_ComputeTile - 1) / c_ComputeTile, (height + c_ComputeTile - 1) / c_ComputeTile, 1);
+    }
 
-    deviceContext->Draw(3, 0);
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    deviceContext->CSSetShaderResources(0, 1, &nullSRV);
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+
+    // Put back every render target the caller had bound.
+    deviceContext->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, rtvs, dsv.Get());
+
+    return true;
 }
 
 
@@ -496,6 +704,8 @@ BasicPostProcess::~BasicPostProcess()
 // IPostProcess methods.
 void BasicPostProcess::Process(_In_ ID3D11DeviceContext* deviceContext, _In_opt_ std::function<void __cdecl()> setCustomState)
 {
+    GpuProfileScope profileScope(deviceContext, L"BasicPostProcess::Process");
+
     pImpl->Process(deviceContext, setCustomState);
 }
 
@@ -524,11 +734,27 @@ void BasicPostProcess::SetEffect(Effect fx)
 }
 
 
+BasicPostProcess::Effect BasicPostProcess::GetEffect() const noexcept
+{
+    return pImpl->fx;
+}
+
+
+void BasicPostProcess::SetUseCompute(bool value)
+{
+    pImpl->useCompute = value;
+}
+
+
 // Properties
 void BasicPostProcess::SetSourceTexture(_In_opt_ ID3D11ShaderResourceView* value)
 {
     pImpl->texture = value;
 
+    // Sample offsets depend on the texture size.
+    unsigned oldWidth = pImpl->texWidth;
+    unsigned oldHeight = pImpl->texHeight;
+
     if (value)
     {
         ComPtr<ID3D11Resource> res;
@@ -574,6 +800,11 @@ void BasicPostProcess::SetSourceTexture(_In_opt_ ID3D11ShaderResourceView* value
     {
         pImpl->texWidth = pImpl->texHeight = 0;
     }
+
+    if (pImpl->texWidth != oldWidth || pImpl->texHeight != oldHeight)
+    {
+        pImpl->SetDirtyFlag();
+    }
 }
 
 
@@ -0,0 +1,654 @@
+//--------------------------------------------------------------------------------------
+// File: BezierPatchMesh.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "BezierPatchMesh.h"
+
+#include "AlignedNew.h"
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "EffectCommon.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+#include "VertexTypes.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneBezierPatch_VSControlPoint.inc"
+    #include "Shaders/Compiled/XboxOneBezierPatch_HSBezier.inc"
+    #include "Shaders/Compiled/XboxOneBezierPatch_DSBezier.inc"
+    #include "Shaders/Compiled/XboxOneBasicEffect_PSBasicPixelLightingTx.inc"
+#else
+    #include "Shaders/Compiled/BezierPatch_VSControlPoint.inc"
+    #include "Shaders/Compiled/BezierPatch_HSBezier.inc"
+    #include "Shaders/Compiled/BezierPatch_DSBezier.inc"
+    #include "Shaders/Compiled/BasicEffect_PSBasicPixelLightingTx.inc"
+#endif
+
+#include "TeapotData.inc"
+
+    const size_t ControlPointsPerPatch = 16;
+
+    // Constant buffer layout, which is BasicEffect's plus the tessellation settings. Must match the shader!
+    XM_ALIGNED_STRUCT(16) BezierPatchConstants
+    {
+        XMVECTOR diffuseColor;
+        XMVECTOR emissiveColor;
+        XMVECTOR specularColorAndPower;
+
+        XMVECTOR lightDirection[IEffectLights::MaxDirectionalLights];
+        XMVECTOR lightDiffuseColor[IEffectLights::MaxDirectionalLights];
+        XMVECTOR lightSpecularColor[IEffectLights::MaxDirectionalLights];
+
+        XMVECTOR eyePosition;
+
+        XMVECTOR fogColor;
+        XMVECTOR fogVector;
+
+        XMMATRIX world;
+        XMVECTOR worldInverseTranspose[3];
+        XMMATRIX worldViewProj;
+
+        XMVECTOR tessellationRange;
+        XMVECTOR normalSign;
+    };
+
+    static_assert((sizeof(BezierPatchConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mVertexShader{},
+            mHullShader{},
+            mDomainShader{},
+            mPixelShader{},
+            mInputLayout{},
+            mDefaultTexture{},
+            mMutex{}
+        { }
+
+        ID3D11VertexShader* GetVertexShader()
+        {
+            return DemandCreate(mVertexShader, mMutex, [&](ID3D11VertexShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateVertexShader(BezierPatch_VSControlPoint, sizeof(BezierPatch_VSControlPoint), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BezierPatchMesh");
+
+                return hr;
+            });
+        }
+
+        ID3D11HullShader* GetHullShader()
+        {
+            return DemandCreate(mHullShader, mMutex, [&](ID3D11HullShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateHullShader(BezierPatch_HSBezier, sizeof(BezierPatch_HSBezier), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BezierPatchMesh");
+
+                return hr;
+            });
+        }
+
+        ID3D11DomainShader* GetDomainShader()
+        {
+            return DemandCreate(mDomainShader, mMutex, [&](ID3D11DomainShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateDomainShader(BezierPatch_DSBezier, sizeof(BezierPatch_DSBezier), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BezierPatchMesh");
+
+                return hr;
+            });
+        }
+
+        // Gets or lazily creates the pixel shader, which is the one BasicEffect uses for textured per pixel lighting.
+        ID3D11PixelShader* GetPixelShader()
+        {
+            return DemandCreate(mPixelShader, mMutex, [&](ID3D11PixelShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreatePixelShader(BasicEffect_PSBasicPixelLightingTx, sizeof(BasicEffect_PSBasicPixelLightingTx), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BezierPatchMesh");
+
+                return hr;
+            });
+        }
+
+        ID3D11InputLayout* GetInputLayout()
+        {
+            return DemandCreate(mInputLayout, mMutex, [&](ID3D11InputLayout** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateInputLayout(
+                    VertexPosition::InputElements, VertexPosition::InputElementCount,
+                    BezierPatch_VSControlPoint, sizeof(BezierPatch_VSControlPoint),
+                    pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "BezierPatchMesh");
+
+                return hr;
+            });
+        }
+
+        // Gets or lazily creates the white texture used when none is set.
+        ID3D11ShaderResourceView* GetDefaultTexture()
+        {
+            return DemandCreate(mDefaultTexture, mMutex, [&](ID3D11ShaderResourceView** pResult) -> HRESULT
+            {
+                static const uint32_t s_pixel = 0xffffffff;
+
+                D3D11_SUBRESOURCE_DATA initData = { &s_pixel, sizeof(uint32_t), 0 };
+
+                CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+
+                ComPtr<ID3D11Texture2D> tex;
+                HRESULT hr = mDevice->CreateTexture2D(&desc, &initData, tex.GetAddressOf());
+
+                if (SUCCEEDED(hr))
+                {
+                    SetDebugObjectName(tex.Get(), "BezierPatchMesh");
+
+                    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 1);
+
+                    hr = mDevice->CreateShaderResourceView(tex.Get(), &srvDesc, pResult);
+                    if (SUCCEEDED(hr))
+                        SetDebugObjectName(*pResult, "BezierPatchMesh");
+                }
+
+                return hr;
+            });
+        }
+
+    protected:
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11VertexShader> mVertexShader;
+        ComPtr<ID3D11HullShader> mHullShader;
+        ComPtr<ID3D11DomainShader> mDomainShader;
+        ComPtr<ID3D11PixelShader> mPixelShader;
+        ComPtr<ID3D11InputLayout> mInputLayout;
+        ComPtr<ID3D11ShaderResourceView> mDefaultTexture;
+        std::mutex mMutex;
+    };
+}
+
+
+// Internal BezierPatchMesh implementation class.
+class BezierPatchMesh::Impl : public AlignedNew<BezierPatchConstants>
+{
+public:
+    Impl(_In_ ID3D11Device* device,
+        _In_reads_(controlPointCount) XMFLOAT3 const* controlPoints, size_t controlPointCount,
+        _In_reads_(patchCount * 16) uint32_t const* patchIndices, size_t patchCount);
+
+    void Apply(_In_ ID3D11DeviceContext* deviceContext);
+    void Draw(_In_ ID3D11DeviceContext* deviceContext);
+
+    // Fields.
+    BezierPatchConstants                    constants;
+    ComPtr<ID3D11ShaderResourceView>        texture;
+
+    XMMATRIX                                world;
+    XMMATRIX                                view;
+    XMMATRIX                                projection;
+
+    XMVECTOR                                diffuseColor;
+    float                                   alpha;
+
+    bool                                    lightingEnabled;
+    XMVECTOR                                ambientLightColor;
+    bool                                    lightEnabled[MaxDirectionalLights];
+    XMVECTOR                                lightDiffuseColor[MaxDirectionalLights];
+    XMVECTOR                                lightSpecularColor[MaxDirectionalLights];
+
+    size_t                                  patchCount;
+
+private:
+    void SetConstants(_In_ ID3D11DeviceContext* deviceContext);
+
+    ComPtr<ID3D11Buffer>                    mControlPoints;
+    ComPtr<ID3D11Buffer>                    mPatchIndices;
+
+    ConstantBuffer<BezierPatchConstants>    mConstantBuffer;
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>        mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device BezierPatchMesh resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> BezierPatchMesh::Impl::deviceResourcesPool;
+
+
+// Constructor.
+_Use_decl_annotations_
+BezierPatchMesh::Impl::Impl(ID3D11Device* device, XMFLOAT3 const* controlPoints, size_t controlPointCount, uint32_t const* patchIndices, size_t patchCount)
+    : constants{},
+    world(XMMatrixIdentity()),
+    view(XMMatrixIdentity()),
+    projection(XMMatrixIdentity()),
+    diffuseColor(g_XMOne),
+    alpha(1.f),
+    lightingEnabled(true),
+    ambientLightColor(g_XMZero),
+    lightEnabled{},
+    lightDiffuseColor{},
+    lightSpecularColor{},
+    patchCount(patchCount),
+    mConstantBuffer(device),
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("BezierPatchMesh requires Feature Level 11.0 or later");
+    }
+
+    if (!controlPoints || !controlPointCount || !patchIndices || !patchCount)
+    {
+        throw std::exception("BezierPatchMesh requires control points and at least one patch");
+    }
+
+    if (controlPointCount > UINT32_MAX
+        || patchCount > (size_t(D3D11_REQ_DRAWINDEXED_INDEX_COUNT_2_TO_EXP) - 1) / ControlPointsPerPatch)
+    {
+        throw std::exception("Too many control points or patches for BezierPatchMesh");
+    }
+
+    size_t indexCount = patchCount * ControlPointsPerPatch;
+
+    for (size_t j = 0; j < indexCount; ++j)
+    {
+        if (patchIndices[j] >= controlPointCount)
+            throw std::out_of_range("Patch index out of range");
+    }
+
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(controlPointCount * sizeof(XMFLOAT3)), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+
+        D3D11_SUBRESOURCE_DATA initData = { controlPoints, 0, 0 };
+
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, mControlPoints.GetAddressOf()));
+
+        SetDebugObjectName(mControlPoints.Get(), "BezierPatchMesh");
+    }
+
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(indexCount * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+
+        D3D11_SUBRESOURCE_DATA initData = { patchIndices, 0, 0 };
+
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, mPatchIndices.GetAddressOf()));
+
+        SetDebugObjectName(mPatchIndices.Get(), "BezierPatchMesh");
+    }
+
+    constants.specularColorAndPower = XMVectorSet(1.f, 1.f, 1.f, 16.f);
+    constants.tessellationRange = XMVectorSet(1.f, 100.f, 64.f, 1.f);
+    constants.normalSign = g_XMOne;
+
+    for (int i = 0; i < MaxDirectionalLights; i++)
+    {
+        constants.lightDirection[i] = g_XMNegIdentityR1;
+        lightDiffuseColor[i] = g_XMOne;
+        lightSpecularColor[i] = g_XMZero;
+    }
+
+    lightEnabled[0] = true;
+}
+
+
+// Fills the constant buffer from the current settings, the same way BasicEffect does.
+void BezierPatchMesh::Impl::SetConstants(_In_ ID3D11DeviceContext* deviceContext)
+{
+    constants.world = XMMatrixTranspose(world);
+
+    XMMATRIX worldInverse = XMMatrixInverse(nullptr, world);
+
+    constants.worldInverseTranspose[0] = worldInverse.r[0];
+    constants.worldInverseTranspose[1] = worldInverse.r[1];
+    constants.worldInverseTranspose[2] = worldInverse.r[2];
+
+    constants.worldViewProj = XMMatrixTranspose(XMMatrixMultiply(XMMatrixMultiply(world, view), projection));
+
+    constants.eyePosition = XMMatrixInverse(nullptr, view).r[3];
+
+    // Colors are premultiplied by alpha. Without lighting the diffuse color goes through the emissive term.
+    XMVECTOR diffuse = XMVectorScale(diffuseColor, alpha);
+
+    constants.diffuseColor = XMVectorSetW(diffuse, alpha);
+    constants.emissiveColor = (lightingEnabled) ? XMVectorMultiply(ambientLightColor, diffuse) : diffuse;
+
+    for (int i = 0; i < MaxDirectionalLights; i++)
+    {
+        bool enabled = lightingEnabled && lightEnabled[i];
+
+        constants.lightDiffuseColor[i] = (enabled) ? lightDiffuseColor[i] : g_XMZero;
+        constants.lightSpecularColor[i] = (enabled) ? lightSpecularColor[i] : g_XMZero;
+    }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    auto buffer = mConstantBuffer.GetBuffer();
+
+    deviceContextX->HSSetPlacementConstantBuffer(0, buffer, grfxMemory);
+    deviceContextX->DSSetPlacementConstantBuffer(0, buffer, grfxMemory);
+    deviceContextX->PSSetPlacementConstantBuffer(0, buffer, grfxMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+
+    auto buffer = mConstantBuffer.GetBuffer();
+
+    deviceContext->HSSetConstantBuffers(0, 1, &buffer);
+    deviceContext->DSSetConstantBuffers(0, 1, &buffer);
+    deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+#endif
+}
+
+
+// Sets our state onto the D3D device.
+void BezierPatchMesh::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
+{
+    deviceContext->VSSetShader(mDeviceResources->GetVertexShader(), nullptr, 0);
+    deviceContext->HSSetShader(mDeviceResources->GetHullShader(), nullptr, 0);
+    deviceContext->DSSetShader(mDeviceResources->GetDomainShader(), nullptr, 0);
+    deviceContext->PSSetShader(mDeviceResources->GetPixelShader(), nullptr, 0);
+
+    InvalidateEffectStateCache(deviceContext);
+
+    ID3D11ShaderResourceView* textures[1] = { (texture) ? texture.Get() : mDeviceResources->GetDefaultTexture() };
+    deviceContext->PSSetShaderResources(0, 1, textures);
+
+    SetConstants(deviceContext);
+}
+
+
+void BezierPatchMesh::Impl::Draw(_In_ ID3D11DeviceContext* deviceContext)
+{
+    Apply(deviceContext);
+
+    auto vertexBuffer = mControlPoints.Get();
+    UINT vertexStride = sizeof(XMFLOAT3);
+    UINT vertexOffset = 0;
+
+    deviceContext->IASetInputLayout(mDeviceResources->GetInputLayout());
+    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    deviceContext->IASetIndexBuffer(mPatchIndices.Get(), DXGI_FORMAT_R32_UINT, 0);
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_16_CONTROL_POINT_PATCHLIST);
+
+    deviceContext->DrawIndexed(static_cast<UINT>(patchCount * ControlPointsPerPatch), 0, 0);
+
+    // Other effects only set the vertex and pixel shaders.
+    deviceContext->HSSetShader(nullptr, nullptr, 0);
+    deviceContext->DSSetShader(nullptr, nullptr, 0);
+}
+
+
+//--------------------------------------------------------------------------------------
+// BezierPatchMesh
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+_Use_decl_annotations_
+BezierPatchMesh::BezierPatchMesh(ID3D11Device* device, XMFLOAT3 const* controlPoints, size_t controlPointCount, uint32_t const* patchIndices, size_t patchCount)
+  : pImpl(std::make_unique<Impl>(device, controlPoints, controlPointCount, patchIndices, patchCount))
+{
+}
+
+
+// Move constructor.
+BezierPatchMesh::BezierPatchMesh(BezierPatchMesh&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+BezierPatchMesh& BezierPatchMesh::operator= (BezierPatchMesh&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+BezierPatchMesh::~BezierPatchMesh()
+{
+}
+
+
+// Builds the teapot the way ComputeTeapot does. Instead of reversing the triangles of the mirrored copies, their
+// control point rows are reversed, which flips the winding and the texture u along with them; the normals come out
+// negated, as ComputeTeapot's mirrored normals are. Left-handed output is all the other patches reversed instead,
+// with the normals flipped back in the shader, which is what ReverseWinding does to the tessellated mesh.
+std::unique_ptr<BezierPatchMesh> BezierPatchMesh::CreateTeapot(_In_ ID3D11Device* device, float size, bool rhcoords)
+{
+    std::vector<XMFLOAT3> controlPoints;
+    std::vector<uint32_t> patchIndices;
+
+    auto addPatch = [&](TeapotPatch const& patch, FXMVECTOR scale, bool isMirrored)
+    {
+        bool reverse = (isMirrored == rhcoords);
+
+        for (size_t row = 0; row < 4; ++row)
+        {
+            for (size_t col = 0; col < 4; ++col)
+            {
+                size_t source = row * 4 + ((reverse) ? 3 - col : col);
+
+                XMFLOAT3 position;
+                XMStoreFloat3(&position, XMVectorMultiply(TeapotControlPoints[patch.indices[source]], scale));
+
+                patchIndices.push_back(static_cast<uint32_t>(controlPoints.size()));
+                controlPoints.push_back(position);
+            }
+        }
+    };
+
+    XMVECTOR scaleVector = XMVectorReplicate(size);
+
+    XMVECTOR scaleNegateX = XMVectorMultiply(scaleVector, g_XMNegateX);
+    XMVECTOR scaleNegateZ = XMVectorMultiply(scaleVector, g_XMNegateZ);
+    XMVECTOR scaleNegateXZ = XMVectorMultiply(scaleVector, XMVectorMultiply(g_XMNegateX, g_XMNegateZ));
+
+    for (size_t i = 0; i < _countof(TeapotPatches); i++)
+    {
+        TeapotPatch const& patch = TeapotPatches[i];
+
+        addPatch(patch, scaleVector, false);
+        addPatch(patch, scaleNegateX, true);
+
+        if (patch.mirrorZ)
+        {
+            addPatch(patch, scaleNegateZ, true);
+            addPatch(patch, scaleNegateXZ, false);
+        }
+    }
+
+    auto mesh = std::make_unique<BezierPatchMesh>(device,
+        controlPoints.data(), controlPoints.size(),
+        patchIndices.data(), patchIndices.size() / ControlPointsPerPatch);
+
+    if (!rhcoords)
+    {
+        mesh->pImpl->constants.normalSign = g_XMNegativeOne;
+    }
+
+    return mesh;
+}
+
+
+// IEffect methods.
+void BezierPatchMesh::Apply(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Apply(deviceContext);
+}
+
+
+void BezierPatchMesh::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength)
+{
+    assert(pShaderByteCode != nullptr && pByteCodeLength != nullptr);
+
+    *pShaderByteCode = BezierPatch_VSControlPoint;
+    *pByteCodeLength = sizeof(BezierPatch_VSControlPoint);
+}
+
+
+// Camera settings.
+void XM_CALLCONV BezierPatchMesh::SetWorld(FXMMATRIX value)
+{
+    pImpl->world = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetView(FXMMATRIX value)
+{
+    pImpl->view = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetProjection(FXMMATRIX value)
+{
+    pImpl->projection = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
+{
+    pImpl->world = world;
+    pImpl->view = view;
+    pImpl->projection = projection;
+}
+
+
+// Material settings.
+void XM_CALLCONV BezierPatchMesh::SetDiffuseColor(FXMVECTOR value)
+{
+    pImpl->diffuseColor = value;
+}
+
+
+void BezierPatchMesh::SetAlpha(float value)
+{
+    pImpl->alpha = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetColorAndAlpha(FXMVECTOR value)
+{
+    pImpl->diffuseColor = value;
+    pImpl->alpha = XMVectorGetW(value);
+}
+
+
+void BezierPatchMesh::SetTexture(_In_opt_ ID3D11ShaderResourceView* value)
+{
+    pImpl->texture = value;
+}
+
+
+// Light settings.
+void BezierPatchMesh::SetLightingEnabled(bool value)
+{
+    pImpl->lightingEnabled = value;
+}
+
+
+void BezierPatchMesh::SetPerPixelLighting(bool)
+{
+    // Unsupported interface method: lighting is always per pixel.
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetAmbientLightColor(FXMVECTOR value)
+{
+    pImpl->ambientLightColor = value;
+}
+
+
+void BezierPatchMesh::SetLightEnabled(int whichLight, bool value)
+{
+    EffectLights::ValidateLightIndex(whichLight);
+
+    pImpl->lightEnabled[whichLight] = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetLightDirection(int whichLight, FXMVECTOR value)
+{
+    EffectLights::ValidateLightIndex(whichLight);
+
+    pImpl->constants.lightDirection[whichLight] = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetLightDiffuseColor(int whichLight, FXMVECTOR value)
+{
+    EffectLights::ValidateLightIndex(whichLight);
+
+    pImpl->lightDiffuseColor[whichLight] = value;
+}
+
+
+void XM_CALLCONV BezierPatchMesh::SetLightSpecularColor(int whichLight, FXMVECTOR value)
+{
+    EffectLights::ValidateLightIndex(whichLight);
+
+    pImpl->lightSpecularColor[whichLight] = value;
+}
+
+
+void BezierPatchMesh::EnableDefaultLighting()
+{
+    EffectLights::EnableDefaultLighting(this);
+}
+
+
+// Tessellation settings.
+void BezierPatchMesh::SetTessellation(float nearDistance, float farDistance, float nearFactor, float farFactor)
+{
+    if (nearDistance < 0.f || farDistance < nearDistance)
+        throw std::out_of_range("Tessellation distances must not be negative, with near no greater than far");
+
+    nearFactor = std::min(std::max(nearFactor, 1.f), 64.f);
+    farFactor = std::min(std::max(farFactor, 1.f), 64.f);
+
+    pImpl->constants.tessellationRange = XMVectorSet(nearDistance, farDistance, nearFactor, farFactor);
+}
+
+
+void BezierPatchMesh::Draw(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Draw(deviceContext);
+}
+
+
+size_t BezierPatchMesh::GetPatchCount() const noexcept
+{
+    return pImpl->patchCount;
+}
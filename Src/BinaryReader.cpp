@@ -22,15 +22,15 @@ BinaryReader::BinaryReader(_In_z_ wchar_t const* fileName) noexcept(false) :
 {
     size_t dataSize;
 
-    HRESULT hr = ReadEntireFile(fileName, mOwnedData, &dataSize);
+    HRESULT hr = MapEntireFile(fileName, mMappedData, &dataSize);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: BinaryReader failed (%08X) to load '%ls'\n", hr, fileName);
         throw std::exception("BinaryReader");
     }
 
-    mPos = mOwnedData.get();
-    mEnd = mOwnedData.get() + dataSize;
+    mPos = static_cast<uint8_t const*>(mMappedData.get());
+    mEnd = mPos + dataSize;
 }
 
 
@@ -87,3 +87,58 @@ HRESULT BinaryReader::ReadEntireFile(_In_z_ wchar_t const* fileName, _Inout_ std
 
     return S_OK;
 }
+
+
+// Maps the filesystem into memory.
+HRESULT BinaryReader::MapEntireFile(_In_z_ wchar_t const* fileName, _Inout_ ScopedMappedView& view, _Out_ size_t* dataSize)
+{
+    *dataSize = 0;
+
+    // Open the file.
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile(safe_handle(CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr)));
+#else
+    ScopedHandle hFile(safe_handle(CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)));
+#endif
+
+    if (!hFile)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    // Get the file size.
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    // File is too big for 32-bit sizes, so reject it as ReadEntireFile does.
+    if (fileInfo.EndOfFile.HighPart > 0)
+        return E_FAIL;
+
+    // Empty files cannot be mapped.
+    if (!fileInfo.EndOfFile.LowPart)
+        return E_FAIL;
+
+    // Map a read-only view of the whole file. The view keeps the file open once the handles are closed.
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hMapping(CreateFileMappingFromApp(hFile.get(), nullptr, PAGE_READONLY, 0, nullptr));
+#else
+    ScopedHandle hMapping(CreateFileMappingW(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+#endif
+
+    if (!hMapping)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    view.reset(MapViewOfFileFromApp(hMapping.get(), FILE_MAP_READ, 0, 0));
+#else
+    view.reset(MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0));
+#endif
+
+    if (!view)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    *dataSize = fileInfo.EndOfFile.LowPart;
+
+    return S_OK;
+}
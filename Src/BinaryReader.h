@@ -58,15 +58,26 @@ namespace DirectX
         }
 
 
+        // Bytes left to read, so optional trailing data can be detected.
+        size_t Remaining() const noexcept
+        {
+            return static_cast<size_t>(mEnd - mPos);
+        }
+
+
         // Lower level helper reads directly from the filesystem into memory.
         static HRESULT ReadEntireFile(_In_z_ wchar_t const* fileName, _Inout_ std::unique_ptr<uint8_t[]>& data, _Out_ size_t* dataSize);
 
+        // Lower level helper maps a file read-only into memory, avoiding the heap copy. The view stays valid while it is held,
+        // but device errors reading the file surface as in-page exceptions on access rather than as a failed HRESULT.
+        static HRESULT MapEntireFile(_In_z_ wchar_t const* fileName, _Inout_ ScopedMappedView& view, _Out_ size_t* dataSize);
+
 
     private:
         // The data currently being read.
         uint8_t const* mPos;
         uint8_t const* mEnd;
 
-        std::unique_ptr<uint8_t[]> mOwnedData;
+        ScopedMappedView mMappedData;
     };
 }
@@ -0,0 +1,217 @@
+//--------------------------------------------------------------------------------------
+// File: BonePalette.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Effects.h"
+#include "DirectXHelpers.h"
+#include "GraphicsMemory.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Each bone is stored as the first three rows of its transpose, as in the SkinnedEffect constant buffer.
+    const size_t RowsPerBone = 3;
+}
+
+
+// Internal BonePalette implementation class.
+class BonePalette::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t maxBones);
+
+    void SetBoneTransforms(size_t firstBone, _In_reads_(count) XMMATRIX const* value, size_t count);
+    void Update(_In_ ID3D11DeviceContext* deviceContext);
+
+    size_t                              maxBones;
+    ComPtr<ID3D11ShaderResourceView>    shaderResourceView;
+
+private:
+    ComPtr<ID3D11Buffer>                mBuffer;
+    std::unique_ptr<XMFLOAT4[]>         mRows;
+
+    // Bones changed since the last Update, as a half-open range.
+    size_t                              mDirtyFirst;
+    size_t                              mDirtyLast;
+};
+
+
+// Constructor.
+BonePalette::Impl::Impl(_In_ ID3D11Device* device, size_t maxBones)
+    : maxBones(maxBones),
+    mDirtyFirst(0),
+    mDirtyLast(0)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+    {
+        throw std::exception("BonePalette requires Feature Level 10.0 or later");
+    }
+
+    if (!maxBones)
+    {
+        throw std::exception("maxBones must be greater than 0");
+    }
+
+    if (maxBones > (size_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM) * 1024u * 1024u) / (RowsPerBone * sizeof(XMFLOAT4)))
+    {
+        throw std::exception("maxBones too large for BonePalette");
+    }
+
+    auto rowCount = maxBones * RowsPerBone;
+
+    mRows.reset(new XMFLOAT4[rowCount]);
+
+    for (size_t i = 0; i < maxBones; ++i)
+    {
+        XMStoreFloat4(&mRows[i * RowsPerBone], g_XMIdentityR0);
+        XMStoreFloat4(&mRows[i * RowsPerBone + 1], g_XMIdentityR1);
+        XMStoreFloat4(&mRows[i * RowsPerBone + 2], g_XMIdentityR2);
+    }
+
+    CD3D11_BUFFER_DESC desc(static_cast<UINT>(rowCount * sizeof(XMFLOAT4)), D3D11_BIND_SHADER_RESOURCE);
+
+    D3D11_SUBRESOURCE_DATA initData = { mRows.get(), 0, 0 };
+
+    ThrowIfFailed(device->CreateBuffer(&desc, &initData, mBuffer.GetAddressOf()));
+
+    SetDebugObjectName(mBuffer.Get(), "BonePalette");
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, static_cast<UINT>(rowCount));
+    ThrowIfFailed(device->CreateShaderResourceView(mBuffer.Get(), &srvDesc, shaderResourceView.GetAddressOf()));
+}
+
+
+_Use_decl_annotations_
+void BonePalette::Impl::SetBoneTransforms(size_t firstBone, XMMATRIX const* value, size_t count)
+{
+    if (firstBone > maxBones || count > maxBones - firstBone)
+        throw std::out_of_range("Bone range out of range");
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        XMMATRIX boneMatrix = XMMatrixTranspose(value[i]);
+
+        auto rows = &mRows[(firstBone + i) * RowsPerBone];
+        XMStoreFloat4(&rows[0], boneMatrix.r[0]);
+        XMStoreFloat4(&rows[1], boneMatrix.r[1]);
+        XMStoreFloat4(&rows[2], boneMatrix.r[2]);
+    }
+
+    if (!count)
+        return;
+
+    if (mDirtyFirst == mDirtyLast)
+    {
+        mDirtyFirst = firstBone;
+        mDirtyLast = firstBone + count;
+    }
+    else
+    {
+        mDirtyFirst = std::min(mDirtyFirst, firstBone);
+        mDirtyLast = std::max(mDirtyLast, firstBone + count);
+    }
+}
+
+
+// Uploads the dirty range. With GraphicsMemory it is staged in the shared upload ring and copied on the GPU;
+// otherwise UpdateSubresource is left to do the staging.
+void BonePalette::Impl::Update(_In_ ID3D11DeviceContext* deviceContext)
+{
+    if (mDirtyFirst == mDirtyLast)
+        return;
+
+    auto source = &mRows[mDirtyFirst * RowsPerBone];
+    auto offset = static_cast<UINT>(mDirtyFirst * RowsPerBone * sizeof(XMFLOAT4));
+    auto size = static_cast<UINT>((mDirtyLast - mDirtyFirst) * RowsPerBone * sizeof(XMFLOAT4));
+
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    if (GraphicsMemory::IsCreated())
+    {
+        auto& graphicsMemory = GraphicsMemory::Get();
+
+        ID3D11Buffer* upload = nullptr;
+        UINT uploadOffset = 0;
+        void* mapped = graphicsMemory.MapUpload(deviceContext, D3D11_BIND_VERTEX_BUFFER, size, 16, &upload, &uploadOffset);
+
+        memcpy(mapped, source, size);
+
+        graphicsMemory.UnmapUpload(deviceContext, D3D11_BIND_VERTEX_BUFFER);
+
+        D3D11_BOX box = { uploadOffset, 0, 0, uploadOffset + size, 1, 1 };
+        deviceContext->CopySubresourceRegion(mBuffer.Get(), 0, offset, 0, 0, upload, 0, &box);
+    }
+    else
+#endif
+    {
+        D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+        deviceContext->UpdateSubresource(mBuffer.Get(), 0, &box, source, 0, 0);
+    }
+
+    mDirtyFirst = mDirtyLast = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// BonePalette
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+BonePalette::BonePalette(_In_ ID3D11Device* device, size_t maxBones)
+  : pImpl(std::make_unique<Impl>(device, maxBones))
+{
+}
+
+
+// Move constructor.
+BonePalette::BonePalette(BonePalette&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+BonePalette& BonePalette::operator= (BonePalette&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+BonePalette::~BonePalette()
+{
+}
+
+
+_Use_decl_annotations_
+void BonePalette::SetBoneTransforms(size_t firstBone, XMMATRIX const* value, size_t count)
+{
+    pImpl->SetBoneTransforms(firstBone, value, count);
+}
+
+
+void BonePalette::Update(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Update(deviceContext);
+}
+
+
+ID3D11ShaderResourceView* BonePalette::GetShaderResourceView() const noexcept
+{
+    return pImpl->shaderResourceView.Get();
+}
+
+
+size_t BonePalette::GetMaxBones() const noexcept
+{
+    return pImpl->maxBones;
+}
@@ -0,0 +1,489 @@
+//--------------------------------------------------------------------------------------
+// File: CascadedShadowMap.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Effects.h"
+#include "CommonStates.h"
+#include "ConstantBuffer.h"
+#include "DirectXHelpers.h"
+#include "GpuProfiler.h"
+#include "MemoryTracker.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    static_assert(CascadedShadowMap::MaxCascades == 4, "MaxCascades mismatch");
+
+    // Constant buffer layout. Must match Shadows.fxh!
+    struct ShadowConstants
+    {
+        XMMATRIX shadowMatrix;
+        XMVECTOR cascadeScales[CascadedShadowMap::MaxCascades];
+        XMVECTOR cascadeOffsets[CascadedShadowMap::MaxCascades];
+        float    depthBias;
+        float    texelSize;
+        uint32_t cascadeCount;
+        uint32_t padding;
+    };
+
+    static_assert((sizeof(ShadowConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Clip space to texture space, with depth left as is.
+    const XMMATRIX g_TextureScaleBias(
+        0.5f,  0.f,   0.f, 0.f,
+        0.f,  -0.5f,  0.f, 0.f,
+        0.f,   0.f,   1.f, 0.f,
+        0.5f,  0.5f,  0.f, 1.f);
+}
+
+
+// Internal CascadedShadowMap implementation class.
+class CascadedShadowMap::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, int resolution, size_t cascadeCount);
+
+    void XM_CALLCONV Update(_In_ ID3D11DeviceContext* deviceContext, FXMVECTOR lightDirection, CXMMATRIX view, CXMMATRIX projection,
+                            float nearZ, float farZ, float splitLambda);
+    void Render(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl(size_t cascade)>& drawCasters);
+    void XM_CALLCONV DrawModel(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const Model& model, FXMMATRIX world) const;
+    void Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+    int                                     resolution;
+    size_t                                  cascadeCount;
+    float                                   depthBias;
+
+    XMFLOAT4X4                              lightView;
+    XMFLOAT4X4                              cascadeProjections[MaxCascades];
+    float                                   cascadeSplits[MaxCascades];
+
+    ComPtr<ID3D11ShaderResourceView>        shaderResourceView;
+
+private:
+    ComPtr<ID3D11Texture2D>                 mTexture;
+    ComPtr<ID3D11DepthStencilView>          mDepthViews[MaxCascades];
+    ComPtr<ID3D11SamplerState>              mSampler;
+    ComPtr<ID3D11RasterizerState>           mRasterizerState;
+
+    ConstantBuffer<ShadowConstants>         mConstantBuffer;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    // Placement memory of the constants written by the last Update.
+    void*                                   mConstantMemory;
+#endif
+
+    bool                                    mFitted;
+
+    // Set while Render draws the casters, when the map is bound for writing.
+    bool                                    mRendering;
+    size_t                                  mCurrentCascade;
+};
+
+
+// Constructor.
+CascadedShadowMap::Impl::Impl(_In_ ID3D11Device* device, int resolution, size_t cascadeCount)
+    : resolution(resolution),
+    cascadeCount(cascadeCount),
+    depthBias(0.0005f),
+    lightView{},
+    cascadeProjections{},
+    cascadeSplits{},
+    mConstantBuffer(device),
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    mConstantMemory(nullptr),
+#endif
+    mFitted(false),
+    mRendering(false),
+    mCurrentCascade(0)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+    {
+        throw std::exception("CascadedShadowMap requires Feature Level 10.0 or later");
+    }
+
+    if (resolution <= 0 || resolution > D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+    {
+        throw std::invalid_argument("Invalid shadow map resolution");
+    }
+
+    if (!cascadeCount || cascadeCount > MaxCascades)
+    {
+        throw std::invalid_argument("CascadedShadowMap supports 1 to 4 cascades");
+    }
+
+    // One slice per cascade, written through depth views and read as floats.
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R32_TYPELESS, static_cast<UINT>(resolution), static_cast<UINT>(resolution),
+        static_cast<UINT>(cascadeCount), 1, D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE);
+
+    ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, mTexture.GetAddressOf()));
+
+    SetDebugObjectName(mTexture.Get(), "CascadedShadowMap");
+
+    MemoryTracker::TrackResource(mTexture.Get(), MemoryCategory_Texture, L"CascadedShadowMap");
+
+    for (size_t i = 0; i < cascadeCount; ++i)
+    {
+        CD3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc(D3D11_DSV_DIMENSION_TEXTURE2DARRAY, DXGI_FORMAT_D32_FLOAT, 0, static_cast<UINT>(i), 1);
+        ThrowIfFailed(device->CreateDepthStencilView(mTexture.Get(), &dsvDesc, mDepthViews[i].GetAddressOf()));
+    }
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURE2DARRAY, DXGI_FORMAT_R32_FLOAT, 0, 1, 0, static_cast<UINT>(cascadeCount));
+    ThrowIfFailed(device->CreateShaderResourceView(mTexture.Get(), &srvDesc, shaderResourceView.GetAddressOf()));
+
+    // Bilinear comparisons, with everything outside the map lit.
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    samplerDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+    samplerDesc.AddressU = samplerDesc.AddressV = samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+    samplerDesc.BorderColor[0] = samplerDesc.BorderColor[1] = samplerDesc.BorderColor[2] = samplerDesc.BorderColor[3] = 1.f;
+
+    ThrowIfFailed(device->CreateSamplerState(&samplerDesc, mSampler.GetAddressOf()));
+
+    SetDebugObjectName(mSampler.Get(), "CascadedShadowMap");
+
+    // Casters are drawn two-sided with a slope-scaled bias, and clamped rather than clipped at the near plane so
+    // that casters between the light and the cascade's sphere still land in the map.
+    CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.SlopeScaledDepthBias = 2.f;
+    rasterizerDesc.DepthClipEnable = FALSE;
+
+    ThrowIfFailed(device->CreateRasterizerState(&rasterizerDesc, mRasterizerState.GetAddressOf()));
+
+    SetDebugObjectName(mRasterizerState.Get(), "CascadedShadowMap");
+}
+
+
+// Fits a sphere around each cascade's slice of the view frustum and builds its orthographic projection from the
+// light. The cascades share the light's view, so in texture space each is a scale and offset of cascade 0.
+void XM_CALLCONV CascadedShadowMap::Impl::Update(_In_ ID3D11DeviceContext* deviceContext, FXMVECTOR lightDirection, CXMMATRIX view, CXMMATRIX projection,
+    float nearZ, float farZ, float splitLambda)
+{
+    if (nearZ <= 0.f || farZ <= nearZ)
+        throw std::invalid_argument("CascadedShadowMap requires 0 < nearZ < farZ");
+
+    if (splitLambda < 0.f || splitLambda > 1.f)
+        throw std::invalid_argument("splitLambda must be between 0 and 1");
+
+    if (XMVector3Equal(lightDirection, g_XMZero))
+        throw std::invalid_argument("Light direction must not be zero");
+
+    XMVECTOR direction = XMVector3Normalize(lightDirection);
+
+    // Rays from the eye through the corners of the view, in world space, scaled to unit view depth. Works for
+    // either handedness, and for reversed or infinite depth projections.
+    XMMATRIX invView = XMMatrixInverse(nullptr, view);
+    XMMATRIX invProjection = XMMatrixInverse(nullptr, projection);
+
+    static const XMVECTORF32 s_corners[4] =
+    {
+        { { { -1.f, -1.f, 0.5f, 1.f } } },
+        { { {  1.f, -1.f, 0.5f, 1.f } } },
+        { { { -1.f,  1.f, 0.5f, 1.f } } },
+        { { {  1.f,  1.f, 0.5f, 1.f } } },
+    };
+
+    XMVECTOR rays[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        XMVECTOR corner = XMVector3TransformCoord(s_corners[i], invProjection);
+        corner = XMVectorDivide(corner, XMVectorAbs(XMVectorSplatZ(corner)));
+        rays[i] = XMVector3TransformNormal(corner, invView);
+    }
+
+    XMVECTOR eye = invView.r[3];
+
+    XMVECTOR up = (std::fabs(XMVectorGetY(direction)) > 0.99f) ? g_XMIdentityR2 : g_XMIdentityR1;
+    XMMATRIX light = XMMatrixLookToRH(g_XMZero, direction, up);
+
+    XMStoreFloat4x4(&lightView, light);
+
+    ShadowConstants constants = {};
+
+    XMVECTOR scale0 = g_XMOne;
+    XMVECTOR offset0 = g_XMZero;
+
+    float splitNear = nearZ;
+
+    for (size_t i = 0; i < cascadeCount; ++i)
+    {
+        float t = float(i + 1) / float(cascadeCount);
+        float splitFar = splitLambda * nearZ * std::pow(farZ / nearZ, t) + (1.f - splitLambda) * (nearZ + (farZ - nearZ) * t);
+
+        XMVECTOR corners[8];
+        XMVECTOR center = g_XMZero;
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            corners[j] = XMVectorMultiplyAdd(rays[j], XMVectorReplicate(splitNear), eye);
+            corners[j + 4] = XMVectorMultiplyAdd(rays[j], XMVectorReplicate(splitFar), eye);
+            center = XMVectorAdd(center, XMVectorAdd(corners[j], corners[j + 4]));
+        }
+
+        center = XMVectorScale(center, 1.f / 8.f);
+
+        float radius = 0.f;
+        for (size_t j = 0; j < 8; ++j)
+        {
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corners[j], center))));
+        }
+
+        // The sphere keeps its size as the camera turns; rounding it keeps float noise from changing the texel size.
+        radius = std::ceil(radius * 16.f) / 16.f;
+
+        // Moving the sphere in whole texels keeps the rasterized casters from crawling.
+        float texelSize = 2.f * radius / float(resolution);
+
+        XMFLOAT3 origin;
+        XMStoreFloat3(&origin, XMVector3TransformCoord(center, light));
+        origin.x = std::floor(origin.x / texelSize) * texelSize;
+        origin.y = std::floor(origin.y / texelSize) * texelSize;
+
+        XMMATRIX cascadeProjection = XMMatrixOrthographicOffCenterRH(origin.x - radius, origin.x + radius, origin.y - radius, origin.y + radius,
+            -origin.z - radius, -origin.z + radius);
+
+        XMStoreFloat4x4(&cascadeProjections[i], cascadeProjection);
+        cascadeSplits[i] = splitFar;
+
+        XMFLOAT4X4 texture;
+        XMStoreFloat4x4(&texture, XMMatrixMultiply(cascadeProjection, g_TextureScaleBias));
+
+        XMVECTOR scale = XMVectorSet(texture._11, texture._22, texture._33, 1.f);
+        XMVECTOR offset = XMVectorSet(texture._41, texture._42, texture._43, 0.f);
+
+        if (!i)
+        {
+            constants.shadowMatrix = XMMatrixTranspose(XMMatrixMultiply(light, XMMatrixMultiply(cascadeProjection, g_TextureScaleBias)));
+
+            scale0 = scale;
+            offset0 = offset;
+        }
+
+        XMVECTOR relativeScale = XMVectorDivide(scale, scale0);
+
+        constants.cascadeScales[i] = relativeScale;
+        constants.cascadeOffsets[i] = XMVectorNegativeMultiplySubtract(offset0, relativeScale, offset);
+
+        splitNear = splitFar;
+    }
+
+    constants.depthBias = depthBias;
+    constants.texelSize = 1.f / float(resolution);
+    constants.cascadeCount = static_cast<uint32_t>(cascadeCount);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    mConstantBuffer.SetData(deviceContext, constants, &mConstantMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+#endif
+
+    mFitted = true;
+}
+
+
+// Only the depth stencil view changes from cascade to cascade.
+void CascadedShadowMap::Impl::Render(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl(size_t cascade)>& drawCasters)
+{
+    if (!mFitted)
+        throw std::exception("CascadedShadowMap::Update must be called before Render");
+
+    if (!drawCasters)
+        throw std::invalid_argument("drawCasters is required");
+
+    GpuProfileScope profileScope(deviceContext, L"CascadedShadowMap::Render");
+
+    // The map can't be read while it is written.
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    deviceContext->PSSetShaderResources(11, 1, &nullSRV);
+
+    CD3D11_VIEWPORT viewport(0.f, 0.f, float(resolution), float(resolution));
+    deviceContext->RSSetViewports(1, &viewport);
+    deviceContext->RSSetState(mRasterizerState.Get());
+
+    mRendering = true;
+
+    try
+    {
+        for (size_t i = 0; i < cascadeCount; ++i)
+        {
+            mCurrentCascade = i;
+
+            deviceContext->ClearDepthStencilView(mDepthViews[i].Get(), D3D11_CLEAR_DEPTH, 1.f, 0);
+            deviceContext->OMSetRenderTargets(0, nullptr, mDepthViews[i].Get());
+
+            drawCasters(i);
+        }
+    }
+    catch (...)
+    {
+        mRendering = false;
+        throw;
+    }
+
+    mRendering = false;
+
+    deviceContext->OMSetRenderTargets(0, nullptr, nullptr);
+}
+
+
+// DrawPass restores each mesh's own rasterizer state, so the custom state callback puts the biased one back.
+void XM_CALLCONV CascadedShadowMap::Impl::DrawModel(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const Model& model,
+    FXMMATRIX world) const
+{
+    if (!mRendering)
+        throw std::exception("CascadedShadowMap::DrawModel must be called from the Render callback");
+
+    auto rasterizerState = mRasterizerState.Get();
+
+    model.DrawPass(deviceContext, states, EffectPass_DepthOnly, world,
+        XMLoadFloat4x4(&lightView), XMLoadFloat4x4(&cascadeProjections[mCurrentCascade]),
+        [=]
+        {
+            deviceContext->RSSetState(rasterizerState);
+        });
+}
+
+
+void CascadedShadowMap::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+    // Effects drawn as casters must not bind the map that is being written.
+    if (mRendering)
+        return;
+
+    if (!mFitted)
+        throw std::exception("CascadedShadowMap::Update must be called before drawing");
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->PSSetPlacementConstantBuffer(2, mConstantBuffer.GetBuffer(), mConstantMemory);
+#else
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->PSSetConstantBuffers(2, 1, &buffer);
+#endif
+
+    ID3D11ShaderResourceView* srv = shaderResourceView.Get();
+    deviceContext->PSSetShaderResources(11, 1, &srv);
+
+    ID3D11SamplerState* sampler = mSampler.Get();
+    deviceContext->PSSetSamplers(2, 1, &sampler);
+}
+
+
+//--------------------------------------------------------------------------------------
+// CascadedShadowMap
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+CascadedShadowMap::CascadedShadowMap(_In_ ID3D11Device* device, int resolution, size_t cascadeCount)
+  : pImpl(std::make_unique<Impl>(device, resolution, cascadeCount))
+{
+}
+
+
+// Move constructor.
+CascadedShadowMap::CascadedShadowMap(CascadedShadowMap&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+CascadedShadowMap& CascadedShadowMap::operator= (CascadedShadowMap&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+CascadedShadowMap::~CascadedShadowMap()
+{
+}
+
+
+void XM_CALLCONV CascadedShadowMap::Update(_In_ ID3D11DeviceContext* deviceContext, FXMVECTOR lightDirection, CXMMATRIX view, CXMMATRIX projection,
+    float nearZ, float farZ, float splitLambda)
+{
+    pImpl->Update(deviceContext, lightDirection, view, projection, nearZ, farZ, splitLambda);
+}
+
+
+void CascadedShadowMap::Render(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl(size_t cascade)> drawCasters)
+{
+    pImpl->Render(deviceContext, drawCasters);
+}
+
+
+void XM_CALLCONV CascadedShadowMap::DrawModel(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, const Model& model,
+    FXMMATRIX world) const
+{
+    pImpl->DrawModel(deviceContext, states, model, world);
+}
+
+
+void CascadedShadowMap::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+    pImpl->Apply(deviceContext);
+}
+
+
+void CascadedShadowMap::SetDepthBias(float value) noexcept
+{
+    pImpl->depthBias = value;
+}
+
+
+XMMATRIX CascadedShadowMap::GetLightView() const noexcept
+{
+    return XMLoadFloat4x4(&pImpl->lightView);
+}
+
+
+XMMATRIX CascadedShadowMap::GetCascadeProjection(size_t cascade) const
+{
+    if (cascade >= pImpl->cascadeCount)
+        throw std::out_of_range("Cascade index out of range");
+
+    return XMLoadFloat4x4(&pImpl->cascadeProjections[cascade]);
+}
+
+
+float CascadedShadowMap::GetCascadeSplit(size_t cascade) const
+{
+    if (cascade >= pImpl->cascadeCount)
+        throw std::out_of_range("Cascade index out of range");
+
+    return pImpl->cascadeSplits[cascade];
+}
+
+
+size_t CascadedShadowMap::GetCascadeCount() const noexcept
+{
+    return pImpl->cascadeCount;
+}
+
+
+int CascadedShadowMap::GetResolution() const noexcept
+{
+    return pImpl->resolution;
+}
+
+
+ID3D11ShaderResourceView* CascadedShadowMap::GetShaderResourceView() const noexcept
+{
+    return pImpl->shaderResourceView.Get();
+}
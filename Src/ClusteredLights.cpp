@@ -0,0 +1,382 @@
+//--------------------------------------------------------------------------------------
+// File: ClusteredLights.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Effects.h"
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneClusteredLights_CSBuildClusters.inc"
+#else
+    #include "Shaders/Compiled/ClusteredLights_CSBuildClusters.inc"
+#endif
+
+    // Must match ClusteredLighting.fxh!
+    const UINT TilesX = 16;
+    const UINT TilesY = 9;
+    const UINT Slices = 24;
+    const UINT ClusterCount = TilesX * TilesY * Slices;
+
+    static_assert(ClusteredLights::MaxLightsPerCluster == 128, "MaxLightsPerCluster mismatch");
+    static_assert(sizeof(ClusteredLight) == 48, "ClusteredLight size mismatch");
+
+    // Constant buffer layout. Must match the shader!
+    struct ClusterConstants
+    {
+        XMMATRIX view;
+        XMMATRIX invProjection;
+        XMFLOAT2 tileScale;
+        float    sliceScale;
+        float    sliceBias;
+        float    nearZ;
+        float    farZ;
+        uint32_t lightCount;
+        uint32_t padding;
+    };
+
+    static_assert((sizeof(ClusterConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mBuildShader{},
+            mMutex{}
+        { }
+
+        // Gets or lazily creates the light binning compute shader.
+        ID3D11ComputeShader* GetBuildShader()
+        {
+            return DemandCreate(mBuildShader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(ClusteredLights_CSBuildClusters, sizeof(ClusteredLights_CSBuildClusters), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ClusteredLights");
+
+                return hr;
+            });
+        }
+
+    protected:
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11ComputeShader> mBuildShader;
+        std::mutex mMutex;
+    };
+}
+
+
+// Internal ClusteredLights implementation class.
+class ClusteredLights::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t maxLights);
+
+    void SetLights(_In_reads_(count) const ClusteredLight* lights, size_t count);
+    void XM_CALLCONV Update(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection,
+                            float nearZ, float farZ, int width, int height);
+    void Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+    size_t                                  maxLights;
+    std::vector<ClusteredLight>             lights;
+
+private:
+    void CreateClusterBuffer(_In_ ID3D11Device* device, UINT count,
+                             _Out_ ID3D11Buffer** buffer, _Out_ ID3D11ShaderResourceView** srv, _Out_ ID3D11UnorderedAccessView** uav);
+
+    void SetConstants(_In_ ID3D11DeviceContext* deviceContext, bool compute) const;
+
+    ComPtr<ID3D11Buffer>                    mLightBuffer;
+    ComPtr<ID3D11ShaderResourceView>        mLightSRV;
+
+    ComPtr<ID3D11Buffer>                    mCounts;
+    ComPtr<ID3D11ShaderResourceView>        mCountsSRV;
+    ComPtr<ID3D11UnorderedAccessView>       mCountsUAV;
+
+    ComPtr<ID3D11Buffer>                    mIndices;
+    ComPtr<ID3D11ShaderResourceView>        mIndicesSRV;
+    ComPtr<ID3D11UnorderedAccessView>       mIndicesUAV;
+
+    ConstantBuffer<ClusterConstants>        mConstantBuffer;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    // Placement memory of the constants written by the last Update.
+    void*                                   mConstantMemory;
+#endif
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>        mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device ClusteredLights resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> ClusteredLights::Impl::deviceResourcesPool;
+
+
+// Constructor.
+ClusteredLights::Impl::Impl(_In_ ID3D11Device* device, size_t maxLights)
+    : maxLights(maxLights),
+    mConstantBuffer(device),
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    mConstantMemory(nullptr),
+#endif
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("ClusteredLights requires Feature Level 11.0 or later");
+    }
+
+    if (!maxLights)
+    {
+        throw std::exception("maxLights must be greater than 0");
+    }
+
+    if (maxLights > (size_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM) * 1024u * 1024u) / sizeof(ClusteredLight))
+    {
+        throw std::exception("maxLights too large for ClusteredLights");
+    }
+
+    // Light list, rewritten by each Update.
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(maxLights * sizeof(ClusteredLight)), D3D11_BIND_SHADER_RESOURCE,
+            D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(ClusteredLight));
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mLightBuffer.GetAddressOf()));
+
+        SetDebugObjectName(mLightBuffer.Get(), "ClusteredLights");
+
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, static_cast<UINT>(maxLights));
+        ThrowIfFailed(device->CreateShaderResourceView(mLightBuffer.Get(), &srvDesc, mLightSRV.GetAddressOf()));
+    }
+
+    // Light count of each cluster, and a fixed slot of light indices per cluster.
+    CreateClusterBuffer(device, ClusterCount,
+        mCounts.GetAddressOf(), mCountsSRV.GetAddressOf(), mCountsUAV.GetAddressOf());
+
+    CreateClusterBuffer(device, ClusterCount * static_cast<UINT>(MaxLightsPerCluster),
+        mIndices.GetAddressOf(), mIndicesSRV.GetAddressOf(), mIndicesUAV.GetAddressOf());
+
+    lights.reserve(maxLights);
+}
+
+
+// Structured buffer of uints, written by the compute shader and read by the pixel shaders. Starts out zeroed, so
+// every cluster is empty until the first Update.
+_Use_decl_annotations_
+void ClusteredLights::Impl::CreateClusterBuffer(ID3D11Device* device, UINT count,
+    ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv, ID3D11UnorderedAccessView** uav)
+{
+    CD3D11_BUFFER_DESC desc(count * sizeof(uint32_t), D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
+        D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(uint32_t));
+
+    std::vector<uint32_t> zeros(count);
+    D3D11_SUBRESOURCE_DATA initData = { zeros.data(), 0, 0 };
+
+    ThrowIfFailed(device->CreateBuffer(&desc, &initData, buffer));
+
+    SetDebugObjectName(*buffer, "ClusteredLights");
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+    ThrowIfFailed(device->CreateShaderResourceView(*buffer, &srvDesc, srv));
+
+    CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+    ThrowIfFailed(device->CreateUnorderedAccessView(*buffer, &uavDesc, uav));
+}
+
+
+_Use_decl_annotations_
+void ClusteredLights::Impl::SetLights(const ClusteredLight* value, size_t count)
+{
+    if (count > maxLights)
+        throw std::out_of_range("Too many lights for ClusteredLights");
+
+    if (count && !value)
+        throw std::invalid_argument("Lights are required");
+
+    lights.assign(value, value + count);
+}
+
+
+// Binds the constants written by the last Update, for the compute shader or the effects' pixel shaders.
+void ClusteredLights::Impl::SetConstants(_In_ ID3D11DeviceContext* deviceContext, bool compute) const
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    if (compute)
+        deviceContextX->CSSetPlacementConstantBuffer(1, mConstantBuffer.GetBuffer(), mConstantMemory);
+    else
+        deviceContextX->PSSetPlacementConstantBuffer(1, mConstantBuffer.GetBuffer(), mConstantMemory);
+#else
+    auto buffer = mConstantBuffer.GetBuffer();
+
+    if (compute)
+        deviceContext->CSSetConstantBuffers(1, 1, &buffer);
+    else
+        deviceContext->PSSetConstantBuffers(1, 1, &buffer);
+#endif
+}
+
+
+// Uploads the lights and bins them, one thread group per cluster.
+void XM_CALLCONV ClusteredLights::Impl::Update(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection,
+    float nearZ, float farZ, int width, int height)
+{
+    if (nearZ <= 0.f || farZ <= nearZ)
+        throw std::invalid_argument("ClusteredLights requires 0 < nearZ < farZ");
+
+    if (width <= 0 || height <= 0)
+        throw std::invalid_argument("Invalid viewport size");
+
+    if (!lights.empty())
+    {
+        MapGuard map(deviceContext, mLightBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0);
+        memcpy(map.pData, lights.data(), lights.size() * sizeof(ClusteredLight));
+    }
+
+    // The shaders work in a view space looking down +z, whichever way the projection is handed.
+    XMMATRIX clusterView = view;
+    XMMATRIX clusterProjection = projection;
+
+    if (XMVectorGetW(projection.r[2]) < 0)
+    {
+        XMMATRIX flip = XMMatrixScaling(1.f, 1.f, -1.f);
+        clusterView = XMMatrixMultiply(view, flip);
+        clusterProjection = XMMatrixMultiply(flip, projection);
+    }
+
+    ClusterConstants constants = {};
+    constants.view = XMMatrixTranspose(clusterView);
+    constants.invProjection = XMMatrixTranspose(XMMatrixInverse(nullptr, clusterProjection));
+    constants.tileScale = XMFLOAT2(float(TilesX) / float(width), float(TilesY) / float(height));
+    constants.sliceScale = float(Slices) / logf(farZ / nearZ);
+    constants.sliceBias = -logf(nearZ) * constants.sliceScale;
+    constants.nearZ = nearZ;
+    constants.farZ = farZ;
+    constants.lightCount = static_cast<uint32_t>(lights.size());
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    mConstantBuffer.SetData(deviceContext, constants, &mConstantMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+#endif
+
+    SetConstants(deviceContext, true);
+
+    deviceContext->CSSetShader(mDeviceResources->GetBuildShader(), nullptr, 0);
+
+    ID3D11ShaderResourceView* srv = mLightSRV.Get();
+    deviceContext->CSSetShaderResources(8, 1, &srv);
+
+    ID3D11UnorderedAccessView* uavs[2] = { mCountsUAV.Get(), mIndicesUAV.Get() };
+    deviceContext->CSSetUnorderedAccessViews(0, 2, uavs, nullptr);
+
+    deviceContext->Dispatch(TilesX, TilesY, Slices);
+
+    // The clusters are read by the pixel shaders that follow.
+    ID3D11UnorderedAccessView* nullUAV[2] = {};
+    deviceContext->CSSetUnorderedAccessViews(0, 2, nullUAV, nullptr);
+
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    deviceContext->CSSetShaderResources(8, 1, &nullSRV);
+}
+
+
+void ClusteredLights::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    if (!mConstantMemory)
+        throw std::exception("ClusteredLights::Update must be called before drawing");
+#endif
+
+    SetConstants(deviceContext, false);
+
+    ID3D11ShaderResourceView* srvs[3] = { mLightSRV.Get(), mCountsSRV.Get(), mIndicesSRV.Get() };
+    deviceContext->PSSetShaderResources(8, 3, srvs);
+}
+
+
+//--------------------------------------------------------------------------------------
+// ClusteredLights
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+ClusteredLights::ClusteredLights(_In_ ID3D11Device* device, size_t maxLights)
+  : pImpl(std::make_unique<Impl>(device, maxLights))
+{
+}
+
+
+// Move constructor.
+ClusteredLights::ClusteredLights(ClusteredLights&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ClusteredLights& ClusteredLights::operator= (ClusteredLights&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ClusteredLights::~ClusteredLights()
+{
+}
+
+
+_Use_decl_annotations_
+void ClusteredLights::SetLights(const ClusteredLight* lights, size_t count)
+{
+    pImpl->SetLights(lights, count);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV ClusteredLights::Update(ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection,
+    float nearZ, float farZ, int width, int height)
+{
+    pImpl->Update(deviceContext, view, projection, nearZ, farZ, width, height);
+}
+
+
+void ClusteredLights::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+    pImpl->Apply(deviceContext);
+}
+
+
+size_t ClusteredLights::GetLightCount() const noexcept
+{
+    return pImpl->lights.size();
+}
+
+
+size_t ClusteredLights::GetMaxLights() const noexcept
+{
+    return pImpl->maxLights;
+}
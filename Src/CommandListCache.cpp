@@ -0,0 +1,283 @@
+//--------------------------------------------------------------------------------------
+// File: CommandListCache.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "CommandListCache.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "GraphicsMemory.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+// Internal CommandListCache implementation class.
+class CommandListCache::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device);
+
+    void Execute(_In_ ID3D11DeviceContext* deviceContext, Dependencies const& dependencies,
+                 std::function<void __cdecl(_In_ ID3D11DeviceContext*)>& record);
+
+    ComPtr<ID3D11CommandList> commandList;
+
+    uint64_t recordCount;
+    uint64_t replayCount;
+
+private:
+    void Record(std::vector<uint8_t>& key, std::function<void __cdecl(_In_ ID3D11DeviceContext*)>& record);
+
+    ComPtr<ID3D11DeviceContext> mDeferredContext;
+
+    // Dependencies of the cached list, followed by the output state it was recorded with.
+    std::vector<uint8_t> mKey;
+
+    // Output state of the executing context, looked up for each Execute.
+    ID3D11RenderTargetView* mRenderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView* mDepthStencil;
+    D3D11_VIEWPORT mViewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT mViewportCount;
+};
+
+
+// Constructor.
+CommandListCache::Impl::Impl(_In_ ID3D11Device* device)
+    : recordCount(0),
+    replayCount(0),
+    mRenderTargets{},
+    mDepthStencil(nullptr),
+    mViewports{},
+    mViewportCount(0)
+{
+    ThrowIfFailed(device->CreateDeferredContext(0, mDeferredContext.GetAddressOf()));
+
+    SetDebugObjectName(mDeferredContext.Get(), "DirectXTK:CommandListCache");
+}
+
+
+// Records the segment unless the cached list was made with the same inputs, then replays it.
+_Use_decl_annotations_
+void CommandListCache::Impl::Execute(ID3D11DeviceContext* deviceContext, Dependencies const& dependencies,
+                                     std::function<void __cdecl(ID3D11DeviceContext*)>& record)
+{
+    // The output state is part of the key, and is compared like any other dependency.
+    deviceContext->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, mRenderTargets, &mDepthStencil);
+
+    mViewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+    deviceContext->RSGetViewports(&mViewportCount, mViewports);
+
+    // OMGetRenderTargets adds references, which are only needed for as long as this takes.
+    for (auto rtv : mRenderTargets)
+    {
+        if (rtv)
+            rtv->Release();
+    }
+
+    if (mDepthStencil)
+        mDepthStencil->Release();
+
+    std::vector<uint8_t> key;
+    key.reserve(dependencies.mData.size() + sizeof(mRenderTargets) + sizeof(mDepthStencil) + sizeof(D3D11_VIEWPORT) * mViewportCount);
+
+    key.insert(key.end(), dependencies.mData.cbegin(), dependencies.mData.cend());
+
+    auto append = [&](void const* data, size_t size)
+    {
+        auto bytes = static_cast<uint8_t const*>(data);
+        key.insert(key.end(), bytes, bytes + size);
+    };
+
+    append(mRenderTargets, sizeof(mRenderTargets));
+    append(&mDepthStencil, sizeof(mDepthStencil));
+    append(mViewports, sizeof(D3D11_VIEWPORT) * mViewportCount);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    // Constants recorded into the list live in GraphicsMemory, which does not outlast the frame.
+    bool reuse = false;
+#else
+    bool reuse = commandList && key == mKey;
+#endif
+
+    if (reuse)
+    {
+        ++replayCount;
+    }
+    else
+    {
+        Record(key, record);
+    }
+
+    deviceContext->ExecuteCommandList(commandList.Get(), TRUE);
+}
+
+
+// Records the segment on the deferred context, starting from the executing context's output state.
+void CommandListCache::Impl::Record(std::vector<uint8_t>& key, std::function<void __cdecl(_In_ ID3D11DeviceContext*)>& record)
+{
+    commandList.Reset();
+    mKey.clear();
+
+    auto deferredContext = mDeferredContext.Get();
+
+    // FinishCommandList leaves the deferred context in its default state, whatever the effects last bound on it.
+    InvalidateEffectStateCache(deferredContext);
+
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    // Uploads start the list with WRITE_DISCARD, as NO_OVERWRITE into data from an earlier list is not allowed.
+    if (GraphicsMemory::IsCreated())
+    {
+        GraphicsMemory::Get().ResetUploads(deferredContext);
+    }
+#endif
+
+    deferredContext->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, mRenderTargets, mDepthStencil);
+
+    if (mViewportCount)
+    {
+        deferredContext->RSSetViewports(mViewportCount, mViewports);
+    }
+
+    try
+    {
+        record(deferredContext);
+    }
+    catch (...)
+    {
+        // Throw away the partial list, so the deferred context is ready for the next attempt.
+        ComPtr<ID3D11CommandList> discard;
+        (void)deferredContext->FinishCommandList(FALSE, discard.GetAddressOf());
+        throw;
+    }
+
+    ThrowIfFailed(deferredContext->FinishCommandList(FALSE, commandList.ReleaseAndGetAddressOf()));
+
+    SetDebugObjectName(commandList.Get(), "DirectXTK:CommandListCache");
+
+    mKey.swap(key);
+
+    ++recordCount;
+}
+
+
+//--------------------------------------------------------------------------------------
+// CommandListCache::Dependencies
+//--------------------------------------------------------------------------------------
+
+_Use_decl_annotations_
+void CommandListCache::Dependencies::Add(void const* data, size_t size)
+{
+    if (!data && size)
+        throw std::invalid_argument("Dependency data is required");
+
+    auto bytes = static_cast<uint8_t const*>(data);
+    mData.insert(mData.end(), bytes, bytes + size);
+}
+
+
+void XM_CALLCONV CommandListCache::Dependencies::Add(FXMMATRIX value)
+{
+    XMFLOAT4X4 data;
+    XMStoreFloat4x4(&data, value);
+
+    Add(&data, sizeof(data));
+}
+
+
+void XM_CALLCONV CommandListCache::Dependencies::Add(FXMVECTOR value)
+{
+    XMFLOAT4 data;
+    XMStoreFloat4(&data, value);
+
+    Add(&data, sizeof(data));
+}
+
+
+void CommandListCache::Dependencies::Add(float value)
+{
+    Add(&value, sizeof(value));
+}
+
+
+void CommandListCache::Dependencies::Add(uint32_t value)
+{
+    Add(&value, sizeof(value));
+}
+
+
+_Use_decl_annotations_
+void CommandListCache::Dependencies::Add(ID3D11DeviceChild* resource)
+{
+    Add(&resource, sizeof(resource));
+}
+
+
+//--------------------------------------------------------------------------------------
+// CommandListCache
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+CommandListCache::CommandListCache(_In_ ID3D11Device* device)
+  : pImpl(std::make_unique<Impl>(device))
+{
+}
+
+
+// Move constructor.
+CommandListCache::CommandListCache(CommandListCache&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+CommandListCache& CommandListCache::operator= (CommandListCache&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+CommandListCache::~CommandListCache()
+{
+}
+
+
+_Use_decl_annotations_
+void CommandListCache::Execute(ID3D11DeviceContext* deviceContext, Dependencies const& dependencies,
+                               std::function<void __cdecl(ID3D11DeviceContext*)> record)
+{
+    if (!deviceContext)
+        throw std::invalid_argument("Execute requires a device context");
+
+    if (!record)
+        throw std::invalid_argument("Execute requires a recording callback");
+
+    pImpl->Execute(deviceContext, dependencies, record);
+}
+
+
+void CommandListCache::Invalidate() noexcept
+{
+    pImpl->commandList.Reset();
+}
+
+
+uint64_t CommandListCache::GetRecordCount() const noexcept
+{
+    return pImpl->recordCount;
+}
+
+
+uint64_t CommandListCache::GetReplayCount() const noexcept
+{
+    return pImpl->replayCount;
+}
@@ -13,10 +13,191 @@
 #include "DirectXHelpers.h"
 #include "SharedResourcePool.h"
 
+#include <atomic>
+
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
 
+namespace
+{
+    // Descriptions are hashed and compared as bytes, so any padding is cleared first.
+    D3D11_BLEND_DESC Normalize(const D3D11_BLEND_DESC& desc) noexcept
+    {
+        D3D11_BLEND_DESC result;
+        memset(&result, 0, sizeof(result));
+
+        result.AlphaToCoverageEnable = desc.AlphaToCoverageEnable;
+        result.IndependentBlendEnable = desc.IndependentBlendEnable;
+
+        for (size_t j = 0; j < _countof(desc.RenderTarget); ++j)
+        {
+            auto const& src = desc.RenderTarget[j];
+            auto& dest = result.RenderTarget[j];
+
+            dest.BlendEnable = src.BlendEnable;
+            dest.SrcBlend = src.SrcBlend;
+            dest.DestBlend = src.DestBlend;
+            dest.BlendOp = src.BlendOp;
+            dest.SrcBlendAlpha = src.SrcBlendAlpha;
+            dest.DestBlendAlpha = src.DestBlendAlpha;
+            dest.BlendOpAlpha = src.BlendOpAlpha;
+            dest.RenderTargetWriteMask = src.RenderTargetWriteMask;
+        }
+
+        return result;
+    }
+
+    D3D11_DEPTH_STENCIL_DESC Normalize(const D3D11_DEPTH_STENCIL_DESC& desc) noexcept
+    {
+        D3D11_DEPTH_STENCIL_DESC result;
+        memset(&result, 0, sizeof(result));
+
+        result.DepthEnable = desc.DepthEnable;
+        result.DepthWriteMask = desc.DepthWriteMask;
+        result.DepthFunc = desc.DepthFunc;
+        result.StencilEnable = desc.StencilEnable;
+        result.StencilReadMask = desc.StencilReadMask;
+        result.StencilWriteMask = desc.StencilWriteMask;
+        result.FrontFace = desc.FrontFace;
+        result.BackFace = desc.BackFace;
+
+        return result;
+    }
+
+    // The rasterizer and sampler descriptions have no padding.
+    const D3D11_RASTERIZER_DESC& Normalize(const D3D11_RASTERIZER_DESC& desc) noexcept { return desc; }
+    const D3D11_SAMPLER_DESC& Normalize(const D3D11_SAMPLER_DESC& desc) noexcept { return desc; }
+
+    inline HRESULT CreateState(_In_ ID3D11Device* device, const D3D11_BLEND_DESC& desc, _Outptr_ ID3D11BlendState** pResult)
+    {
+        return device->CreateBlendState(&desc, pResult);
+    }
+
+    inline HRESULT CreateState(_In_ ID3D11Device* device, const D3D11_DEPTH_STENCIL_DESC& desc, _Outptr_ ID3D11DepthStencilState** pResult)
+    {
+        return device->CreateDepthStencilState(&desc, pResult);
+    }
+
+    inline HRESULT CreateState(_In_ ID3D11Device* device, const D3D11_RASTERIZER_DESC& desc, _Outptr_ ID3D11RasterizerState** pResult)
+    {
+        return device->CreateRasterizerState(&desc, pResult);
+    }
+
+    inline HRESULT CreateState(_In_ ID3D11Device* device, const D3D11_SAMPLER_DESC& desc, _Outptr_ ID3D11SamplerState** pResult)
+    {
+        return device->CreateSamplerState(&desc, pResult);
+    }
+
+
+    // Hash table of state objects by description. Each bucket is a list that only ever grows at the head, and a
+    // new node is fully built before it is published, so lookups walk the lists without locking. Insertions are
+    // serialized by the caller's mutex. Nodes are only freed with the cache.
+    template<typename TDesc, typename TState>
+    class StateCache
+    {
+    public:
+        StateCache() noexcept
+            : mBuckets{}
+        {
+        }
+
+        StateCache(StateCache const&) = delete;
+        StateCache& operator= (StateCache const&) = delete;
+
+        ~StateCache()
+        {
+            for (auto& bucket : mBuckets)
+            {
+                auto node = bucket.load(std::memory_order_relaxed);
+                while (node)
+                {
+                    auto next = node->next;
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+
+        // Returns the shared object for the description; the reference stays with the cache.
+        HRESULT GetOrCreate(_In_ ID3D11Device* device, std::mutex& mutex, const TDesc& desc, _Outptr_ TState** pResult)
+        {
+            auto const& key = Normalize(desc);
+
+            size_t hash = Hash(key);
+            auto& bucket = mBuckets[hash % BucketCount];
+
+            auto state = Find(bucket.load(std::memory_order_acquire), hash, key);
+            if (!state)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto head = bucket.load(std::memory_order_relaxed);
+
+                state = Find(head, hash, key);
+                if (!state)
+                {
+                    auto node = std::make_unique<Node>();
+                    node->hash = hash;
+                    node->desc = key;
+                    node->next = head;
+
+                    HRESULT hr = CreateState(device, key, node->state.GetAddressOf());
+                    if (FAILED(hr))
+                        return hr;
+
+                    SetDebugObjectName(node->state.Get(), "DirectXTK:CommonStates");
+
+                    state = node->state.Get();
+                    bucket.store(node.release(), std::memory_order_release);
+                }
+            }
+
+            *pResult = state;
+            return S_OK;
+        }
+
+    private:
+        static const size_t BucketCount = 64;
+
+        struct Node
+        {
+            size_t hash;
+            TDesc desc;
+            ComPtr<TState> state;
+            Node* next;
+        };
+
+        std::atomic<Node*> mBuckets[BucketCount];
+
+        static size_t Hash(const TDesc& desc) noexcept
+        {
+            auto bytes = reinterpret_cast<const uint8_t*>(&desc);
+
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t j = 0; j < sizeof(TDesc); ++j)
+            {
+                hash ^= bytes[j];
+                hash *= 1099511628211ull;
+            }
+
+            return static_cast<size_t>(hash);
+        }
+
+        static TState* Find(_In_opt_ const Node* node, size_t hash, const TDesc& desc) noexcept
+        {
+            for (; node; node = node->next)
+            {
+                if (node->hash == hash && !memcmp(&node->desc, &desc, sizeof(TDesc)))
+                    return node->state.Get();
+            }
+
+            return nullptr;
+        }
+    };
+}
+
+
 // Internal state object implementation class. Only one of these helpers is allocated
 // per D3D device, even if there are multiple public facing CommonStates instances.
 class CommonStates::Impl
@@ -33,6 +214,16 @@ public:
 
     ComPtr<ID3D11Device> mDevice;
 
+    // Every state object, built-in or custom, is owned here. The built-in members below hold extra references
+    // so their accessors skip the hash lookup.
+    StateCache<D3D11_BLEND_DESC, ID3D11BlendState> blendStates;
+    StateCache<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> depthStencilStates;
+    StateCache<D3D11_RASTERIZER_DESC, ID3D11RasterizerState> rasterizerStates;
+    StateCache<D3D11_SAMPLER_DESC, ID3D11SamplerState> samplerStates;
+
+    // Guards insertion into the state caches. DemandCreate holds the other mutex while it calls into them.
+    std::mutex cacheMutex;
+
     ComPtr<ID3D11BlendState> opaque;
     ComPtr<ID3D11BlendState> alphaBlend;
     ComPtr<ID3D11BlendState> additive;
@@ -57,6 +248,19 @@ public:
     std::mutex mutex;
 
     static SharedResourcePool<ID3D11Device*, Impl> instancePool;
+
+private:
+    // Looks up a built-in state in the caches, returning a reference of its own for DemandCreate to attach.
+    template<typename TDesc, typename TState>
+    HRESULT AddRefShared(StateCache<TDesc, TState>& cache, const TDesc& desc, _Out_ TState** pResult)
+    {
+        HRESULT hr = cache.GetOrCreate(mDevice.Get(), cacheMutex, desc, pResult);
+
+        if (SUCCEEDED(hr))
+            (*pResult)->AddRef();
+
+        return hr;
+    }
 };
 
 
@@ -78,12 +282,7 @@ HRESULT CommonStates::Impl::CreateBlendState(D3D11_BLEND srcBlend, D3D11_BLEND d
 
     desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 
-    HRESULT hr = mDevice->CreateBlendState(&desc, pResult);
-
-    if (SUCCEEDED(hr))
-        SetDebugObjectName(*pResult, "DirectXTK:CommonStates");
-
-    return hr;
+    return AddRefShared(blendStates, desc, pResult);
 }
 
 
@@ -107,12 +306,7 @@ HRESULT CommonStates::Impl::CreateDepthStencilState(bool enable, bool writeEnabl
 
     desc.BackFace = desc.FrontFace;
 
-    HRESULT hr = mDevice->CreateDepthStencilState(&desc, pResult);
-
-    if (SUCCEEDED(hr))
-        SetDebugObjectName(*pResult, "DirectXTK:CommonStates");
-
-    return hr;
+    return AddRefShared(depthStencilStates, desc, pResult);
 }
 
 
@@ -126,12 +320,7 @@ HRESULT CommonStates::Impl::CreateRasterizerState(D3D11_CULL_MODE cullMode, D3D1
     desc.DepthClipEnable = TRUE;
     desc.MultisampleEnable = TRUE;
 
-    HRESULT hr = mDevice->CreateRasterizerState(&desc, pResult);
-
-    if (SUCCEEDED(hr))
-        SetDebugObjectName(*pResult, "DirectXTK:CommonStates");
-
-    return hr;
+    return AddRefShared(rasterizerStates, desc, pResult);
 }
 
 
@@ -151,12 +340,7 @@ HRESULT CommonStates::Impl::CreateSamplerState(D3D11_FILTER filter, D3D11_TEXTUR
     desc.MaxLOD = FLT_MAX;
     desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
 
-    HRESULT hr = mDevice->CreateSamplerState(&desc, pResult);
-
-    if (SUCCEEDED(hr))
-        SetDebugObjectName(*pResult, "DirectXTK:CommonStates");
-
-    return hr;
+    return AddRefShared(samplerStates, desc, pResult);
 }
 
 
@@ -359,3 +543,39 @@ ID3D11SamplerState* CommonStates::AnisotropicClamp() const
         return pImpl->CreateSamplerState(D3D11_FILTER_ANISOTROPIC, D3D11_TEXTURE_ADDRESS_CLAMP, pResult);
     });
 }
+
+
+//--------------------------------------------------------------------------------------
+// Custom states
+//--------------------------------------------------------------------------------------
+
+ID3D11BlendState* CommonStates::GetBlendState(const D3D11_BLEND_DESC& desc) const
+{
+    ID3D11BlendState* result = nullptr;
+    ThrowIfFailed(pImpl->blendStates.GetOrCreate(pImpl->mDevice.Get(), pImpl->cacheMutex, desc, &result));
+    return result;
+}
+
+
+ID3D11DepthStencilState* CommonStates::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc) const
+{
+    ID3D11DepthStencilState* result = nullptr;
+    ThrowIfFailed(pImpl->depthStencilStates.GetOrCreate(pImpl->mDevice.Get(), pImpl->cacheMutex, desc, &result));
+    return result;
+}
+
+
+ID3D11RasterizerState* CommonStates::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc) const
+{
+    ID3D11RasterizerState* result = nullptr;
+    ThrowIfFailed(pImpl->rasterizerStates.GetOrCreate(pImpl->mDevice.Get(), pImpl->cacheMutex, desc, &result));
+    return result;
+}
+
+
+ID3D11SamplerState* CommonStates::GetSamplerState(const D3D11_SAMPLER_DESC& desc) const
+{
+    ID3D11SamplerState* result = nullptr;
+    ThrowIfFailed(pImpl->samplerStates.GetOrCreate(pImpl->mDevice.Get(), pImpl->cacheMutex, desc, &result));
+    return result;
+}
@@ -0,0 +1,568 @@
+//--------------------------------------------------------------------------------------
+// File: ComputeSkinning.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ComputeSkinning.h"
+
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+#include "VertexTypes.h"
+
+#include <unordered_map>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneComputeSkinning_CSSkin.inc"
+#else
+    #include "Shaders/Compiled/ComputeSkinning_CSSkin.inc"
+#endif
+
+    // Must match the shader!
+    const UINT GroupSize = 64;
+
+    using SourceVertex = VertexPositionNormalTangentColorTextureSkinning;
+    using OutputVertex = VertexPositionNormalTangentColorTexture;
+
+    static_assert(sizeof(SourceVertex) == 60, "Source vertex size mismatch");
+    static_assert(sizeof(OutputVertex) == 52, "Output vertex size mismatch");
+
+    // Must match the SkinJob struct in ComputeSkinning.fx.
+    struct SkinJob
+    {
+        uint32_t firstGroup;
+        uint32_t vertexStart;
+        uint32_t vertexCount;
+        uint32_t paletteStart;
+    };
+
+    static_assert(sizeof(SkinJob) == 16, "SkinJob size mismatch");
+
+    // Constant buffer layout. Must match the shader!
+    struct SkinningConstants
+    {
+        uint32_t jobCount;
+        uint32_t groupOffset;
+        uint32_t padding[2];
+    };
+
+    static_assert((sizeof(SkinningConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Each bone is stored as the first three rows of its transpose, as in SkinnedEffect.
+    const size_t RowsPerBone = 3;
+
+    const size_t InitialJobCapacity = 64;
+
+    // True if the part uses the skinned layout written by the CMO loader.
+    bool IsSkinnedPart(const ModelMeshPart& part) noexcept
+    {
+        if (!part.vertexBuffer || !part.vbDecl || part.vertexStride != sizeof(SourceVertex))
+            return false;
+
+        auto& decl = *part.vbDecl;
+        if (decl.size() != SourceVertex::InputElementCount)
+            return false;
+
+        for (size_t j = 0; j < decl.size(); ++j)
+        {
+            if (_stricmp(decl[j].SemanticName, SourceVertex::InputElements[j].SemanticName) != 0
+                || decl[j].Format != SourceVertex::InputElements[j].Format
+                || decl[j].InputSlot != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mSkinShader{},
+            mMutex{}
+        { }
+
+        // Gets or lazily creates the skinning compute shader.
+        ID3D11ComputeShader* GetSkinShader()
+        {
+            return DemandCreate(mSkinShader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(ComputeSkinning_CSSkin, sizeof(ComputeSkinning_CSSkin), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ComputeSkinning");
+
+                return hr;
+            });
+        }
+
+    protected:
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11ComputeShader> mSkinShader;
+        std::mutex mMutex;
+    };
+}
+
+
+// Internal ComputeSkinning implementation class.
+class ComputeSkinning::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t maxVertices, size_t maxBones);
+
+    void Register(_In_ ID3D11DeviceContext* deviceContext, Model& model,
+        const std::function<std::shared_ptr<IEffect> __cdecl(const std::shared_ptr<IEffect>&)>& createEffect);
+    void Skin(const Model& model, size_t nbones, _In_reads_(nbones) const XMMATRIX* boneTransforms);
+    void Dispatch(_In_ ID3D11DeviceContext* deviceContext);
+    void Reset() noexcept;
+
+    size_t                                  maxVertices;
+    size_t                                  usedVertices;
+
+private:
+    // A run of vertices in the source and output buffers, copied from one of a model's vertex buffers.
+    struct VertexRange
+    {
+        uint32_t start;
+        uint32_t count;
+    };
+
+    void CreateJobBuffer(size_t capacity);
+    void SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, const SkinningConstants& value);
+
+    size_t                                  mMaxBones;
+
+    std::unordered_map<const Model*, std::vector<VertexRange>> mModels;
+
+    // Palettes and jobs queued for the next dispatch.
+    std::vector<XMFLOAT4>                   mPalette;
+    std::vector<SkinJob>                    mJobs;
+    uint32_t                                mGroupCount;
+
+    ComPtr<ID3D11Buffer>                    mSource;
+    ComPtr<ID3D11ShaderResourceView>        mSourceSRV;
+
+    ComPtr<ID3D11Buffer>                    mOutput;
+    ComPtr<ID3D11UnorderedAccessView>       mOutputUAV;
+
+    ComPtr<ID3D11Buffer>                    mBones;
+    ComPtr<ID3D11ShaderResourceView>        mBonesSRV;
+
+    ComPtr<ID3D11Buffer>                    mJobBuffer;
+    ComPtr<ID3D11ShaderResourceView>        mJobSRV;
+    size_t                                  mJobCapacity;
+
+    std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> mOutputDecl;
+
+    ComPtr<ID3D11Device>                    mDevice;
+    ConstantBuffer<SkinningConstants>       mConstantBuffer;
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>        mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device ComputeSkinning resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> ComputeSkinning::Impl::deviceResourcesPool;
+
+
+// Constructor.
+ComputeSkinning::Impl::Impl(_In_ ID3D11Device* device, size_t maxVertices, size_t maxBones)
+    : maxVertices(maxVertices),
+    usedVertices(0),
+    mMaxBones(maxBones),
+    mGroupCount(0),
+    mJobCapacity(0),
+    mDevice(device),
+    mConstantBuffer(device),
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("ComputeSkinning requires Feature Level 11.0 or later");
+    }
+
+    if (!maxVertices || !maxBones)
+    {
+        throw std::exception("maxVertices and maxBones must be greater than 0");
+    }
+
+    // Limited by the largest buffer.
+    const size_t maxBytes = size_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM) * 1024u * 1024u;
+
+    if (maxVertices > maxBytes / sizeof(SourceVertex))
+    {
+        throw std::exception("maxVertices too large for ComputeSkinning");
+    }
+
+    if (maxBones > maxBytes / (RowsPerBone * sizeof(XMFLOAT4)))
+    {
+        throw std::exception("maxBones too large for ComputeSkinning");
+    }
+
+    // Unskinned vertices, read as a raw buffer.
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(maxVertices * sizeof(SourceVertex)),
+            D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mSource.GetAddressOf()));
+
+        SetDebugObjectName(mSource.Get(), "ComputeSkinning");
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+        srvDesc.BufferEx.NumElements = desc.ByteWidth / sizeof(uint32_t);
+        srvDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+
+        ThrowIfFailed(device->CreateShaderResourceView(mSource.Get(), &srvDesc, mSourceSRV.GetAddressOf()));
+    }
+
+    // Skinned vertices, written as a raw buffer and drawn as a vertex buffer.
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(maxVertices * sizeof(OutputVertex)),
+            D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_UNORDERED_ACCESS, D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mOutput.GetAddressOf()));
+
+        SetDebugObjectName(mOutput.Get(), "ComputeSkinning");
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_R32_TYPELESS, 0, desc.ByteWidth / sizeof(uint32_t), 0, D3D11_BUFFER_UAV_FLAG_RAW);
+        ThrowIfFailed(device->CreateUnorderedAccessView(mOutput.Get(), &uavDesc, mOutputUAV.GetAddressOf()));
+    }
+
+    // Bone palettes for every queued model.
+    {
+        auto count = static_cast<UINT>(maxBones * RowsPerBone);
+
+        CD3D11_BUFFER_DESC desc(count * sizeof(XMFLOAT4), D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE,
+            D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(XMFLOAT4));
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mBones.GetAddressOf()));
+
+        SetDebugObjectName(mBones.Get(), "ComputeSkinning");
+
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+        ThrowIfFailed(device->CreateShaderResourceView(mBones.Get(), &srvDesc, mBonesSRV.GetAddressOf()));
+    }
+
+    CreateJobBuffer(InitialJobCapacity);
+
+    mOutputDecl = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+        OutputVertex::InputElements,
+        OutputVertex::InputElements + OutputVertex::InputElementCount);
+
+    mPalette.reserve(maxBones * RowsPerBone);
+}
+
+
+// (Re)creates the job table with room for at least capacity jobs.
+void ComputeSkinning::Impl::CreateJobBuffer(size_t capacity)
+{
+    mJobSRV.Reset();
+    mJobBuffer.Reset();
+
+    auto count = static_cast<UINT>(capacity);
+
+    CD3D11_BUFFER_DESC desc(count * sizeof(SkinJob), D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE,
+        D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(SkinJob));
+
+    ThrowIfFailed(mDevice->CreateBuffer(&desc, nullptr, mJobBuffer.GetAddressOf()));
+
+    SetDebugObjectName(mJobBuffer.Get(), "ComputeSkinning");
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+    ThrowIfFailed(mDevice->CreateShaderResourceView(mJobBuffer.Get(), &srvDesc, mJobSRV.GetAddressOf()));
+
+    mJobCapacity = capacity;
+}
+
+
+void ComputeSkinning::Impl::SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, const SkinningConstants& value)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, value, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->CSSetPlacementConstantBuffer(0, mConstantBuffer.GetBuffer(), grfxMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, value);
+
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->CSSetConstantBuffers(0, 1, &buffer);
+#endif
+}
+
+
+// Copies each skinned vertex buffer of the model into the source buffer once, however many parts share it, and
+// repoints those parts at the matching range of the output buffer.
+void ComputeSkinning::Impl::Register(_In_ ID3D11DeviceContext* deviceContext, Model& model,
+    const std::function<std::shared_ptr<IEffect> __cdecl(const std::shared_ptr<IEffect>&)>& createEffect)
+{
+    if (!createEffect)
+    {
+        throw std::exception("createEffect must not be null");
+    }
+
+    if (mModels.find(&model) != mModels.end())
+    {
+        throw std::exception("Model is already registered with ComputeSkinning");
+    }
+
+    std::vector<VertexRange> ranges;
+    std::unordered_map<ID3D11Buffer*, uint32_t> copied;
+
+    for (auto& mesh : model.meshes)
+    {
+        for (auto& part : mesh->meshParts)
+        {
+            if (!IsSkinnedPart(*part))
+                continue;
+
+            uint32_t base;
+
+            auto it = copied.find(part->vertexBuffer.Get());
+            if (it != copied.end())
+            {
+                base = it->second;
+            }
+            else
+            {
+                D3D11_BUFFER_DESC desc = {};
+                part->vertexBuffer->GetDesc(&desc);
+
+                auto count = static_cast<uint32_t>(desc.ByteWidth / sizeof(SourceVertex));
+
+                if (count > maxVertices - usedVertices)
+                {
+                    throw std::exception("Too many vertices for ComputeSkinning");
+                }
+
+                base = static_cast<uint32_t>(usedVertices);
+
+                D3D11_BOX box = { 0, 0, 0, UINT(count * sizeof(SourceVertex)), 1, 1 };
+                deviceContext->CopySubresourceRegion(mSource.Get(), 0, UINT(base * sizeof(SourceVertex)), 0, 0, part->vertexBuffer.Get(), 0, &box);
+
+                copied[part->vertexBuffer.Get()] = base;
+                ranges.push_back({ base, count });
+                usedVertices += count;
+            }
+
+            auto effect = createEffect(part->effect);
+            if (!effect)
+            {
+                throw std::exception("createEffect returned no effect");
+            }
+
+            part->vertexBuffer = mOutput;
+            part->vertexOffset += static_cast<int32_t>(base);
+            part->vertexStride = sizeof(OutputVertex);
+            part->vbDecl = mOutputDecl;
+            part->ModifyEffect(mDevice.Get(), effect, part->isAlpha);
+        }
+    }
+
+    if (ranges.empty())
+        return;
+
+    mModels[&model] = std::move(ranges);
+
+    model.Modified();
+}
+
+
+// Appends the model's palette and one job per vertex range. Jobs are ordered by their first group, so the shader
+// can find the one a group belongs to with a binary search.
+void ComputeSkinning::Impl::Skin(const Model& model, size_t nbones, const XMMATRIX* boneTransforms)
+{
+    auto it = mModels.find(&model);
+    if (it == mModels.end())
+    {
+        throw std::exception("Model is not registered with ComputeSkinning");
+    }
+
+    if (!nbones || !boneTransforms)
+    {
+        throw std::exception("Bone transforms array required");
+    }
+
+    auto paletteStart = mPalette.size() / RowsPerBone;
+
+    if (nbones > mMaxBones - paletteStart)
+    {
+        throw std::out_of_range("Too many bones queued for ComputeSkinning");
+    }
+
+    for (size_t i = 0; i < nbones; ++i)
+    {
+        XMMATRIX boneMatrix = XMMatrixTranspose(boneTransforms[i]);
+
+        for (size_t j = 0; j < RowsPerBone; ++j)
+        {
+            XMFLOAT4 row;
+            XMStoreFloat4(&row, boneMatrix.r[j]);
+            mPalette.push_back(row);
+        }
+    }
+
+    for (auto& range : it->second)
+    {
+        mJobs.push_back({ mGroupCount, range.start, range.count, static_cast<uint32_t>(paletteStart) });
+        mGroupCount += (range.count + GroupSize - 1) / GroupSize;
+    }
+}
+
+
+// Uploads the palettes and jobs, then skins them all. The dispatch is only split when it would pass the group limit.
+void ComputeSkinning::Impl::Dispatch(_In_ ID3D11DeviceContext* deviceContext)
+{
+    if (mJobs.empty())
+        return;
+
+    {
+        MapGuard map(deviceContext, mBones.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0);
+        memcpy(map.pData, mPalette.data(), mPalette.size() * sizeof(XMFLOAT4));
+    }
+
+    if (mJobs.size() > mJobCapacity)
+    {
+        CreateJobBuffer(std::max(mJobs.size(), mJobCapacity * 2));
+    }
+
+    {
+        MapGuard map(deviceContext, mJobBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0);
+        memcpy(map.pData, mJobs.data(), mJobs.size() * sizeof(SkinJob));
+    }
+
+    deviceContext->CSSetShader(mDeviceResources->GetSkinShader(), nullptr, 0);
+
+    ID3D11ShaderResourceView* srvs[3] = { mSourceSRV.Get(), mBonesSRV.Get(), mJobSRV.Get() };
+    deviceContext->CSSetShaderResources(0, 3, srvs);
+
+    ID3D11UnorderedAccessView* uav = mOutputUAV.Get();
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+    SkinningConstants constants = {};
+    constants.jobCount = static_cast<uint32_t>(mJobs.size());
+
+    for (uint32_t offset = 0; offset < mGroupCount; offset += D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION)
+    {
+        constants.groupOffset = offset;
+        SetComputeConstants(deviceContext, constants);
+
+        auto groups = std::min<uint32_t>(mGroupCount - offset, D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION);
+        deviceContext->Dispatch(groups, 1, 1);
+    }
+
+    // The output is bound as a vertex buffer by the passes that follow.
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+
+    ID3D11ShaderResourceView* nullSRV[3] = {};
+    deviceContext->CSSetShaderResources(0, 3, nullSRV);
+
+    mPalette.clear();
+    mJobs.clear();
+    mGroupCount = 0;
+}
+
+
+void ComputeSkinning::Impl::Reset() noexcept
+{
+    mModels.clear();
+    mPalette.clear();
+    mJobs.clear();
+    mGroupCount = 0;
+    usedVertices = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// ComputeSkinning
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+ComputeSkinning::ComputeSkinning(_In_ ID3D11Device* device, size_t maxVertices, size_t maxBones)
+  : pImpl(std::make_unique<Impl>(device, maxVertices, maxBones))
+{
+}
+
+
+// Move constructor.
+ComputeSkinning::ComputeSkinning(ComputeSkinning&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ComputeSkinning& ComputeSkinning::operator= (ComputeSkinning&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ComputeSkinning::~ComputeSkinning()
+{
+}
+
+
+void ComputeSkinning::Register(_In_ ID3D11DeviceContext* deviceContext, Model& model,
+    _In_ std::function<std::shared_ptr<IEffect> __cdecl(const std::shared_ptr<IEffect>& skinnedEffect)> createEffect)
+{
+    pImpl->Register(deviceContext, model, createEffect);
+}
+
+
+_Use_decl_annotations_
+void ComputeSkinning::Skin(const Model& model, size_t nbones, const XMMATRIX* boneTransforms)
+{
+    pImpl->Skin(model, nbones, boneTransforms);
+}
+
+
+void ComputeSkinning::Dispatch(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Dispatch(deviceContext);
+}
+
+
+void ComputeSkinning::Reset() noexcept
+{
+    pImpl->Reset();
+}
+
+
+size_t ComputeSkinning::GetMaxVertices() const noexcept
+{
+    return pImpl->maxVertices;
+}
+
+
+size_t ComputeSkinning::GetUsedVertices() const noexcept
+{
+    return pImpl->usedVertices;
+}
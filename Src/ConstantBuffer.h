@@ -11,6 +11,7 @@
 
 #include "DirectXHelpers.h"
 #include "GraphicsMemory.h"
+#include "MemoryTracker.h"
 #include "PlatformHelpers.h"
 
 
@@ -47,6 +48,8 @@ namespace DirectX
             ThrowIfFailed(deviceX->CreatePlacementBuffer(&desc, nullptr, mConstantBuffer.ReleaseAndGetAddressOf()));
 
             SetDebugObjectName(mConstantBuffer.Get(), L"DirectXTK");
+
+            MemoryTracker::TrackResource(mConstantBuffer.Get(), MemoryCategory_ConstantBuffer, L"DirectXTK");
         }
 
 
@@ -77,6 +80,8 @@ namespace DirectX
             );
 
             SetDebugObjectName(mConstantBuffer.Get(), "DirectXTK");
+
+            MemoryTracker::TrackResource(mConstantBuffer.Get(), MemoryCategory_ConstantBuffer, L"DirectXTK");
         }
 
 
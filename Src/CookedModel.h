@@ -0,0 +1,174 @@
+//--------------------------------------------------------------------------------------
+// File: CookedModel.h
+//
+// Cooked model file format written by ModelCooker and read by Model::CreateFromCooked.
+// Everything the loader needs is stored ready to use: vertex and index data exactly as
+// it is given to CreateBuffer, input element descriptions, bounding volumes and material
+// records, all laid out in one file so it can be mapped and used in place.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+
+namespace CookedModel
+{
+    const uint32_t MAGIC = 0x4D4B5444; // "DTKM"
+    const uint32_t VERSION = 1;
+
+    // Vertex and index data starts on this boundary; every table starts on a 4 byte boundary.
+    const uint32_t DATA_ALIGNMENT = 16;
+
+    // String offsets are in bytes from the start of the string table, pointing at null-terminated UTF-16 text.
+    const uint32_t NO_STRING = 0xFFFFFFFF;
+
+    enum MATERIAL_FLAGS : uint32_t
+    {
+        MATERIAL_PER_VERTEX_COLOR       = 0x1,
+        MATERIAL_SKINNING               = 0x2,
+        MATERIAL_DUAL_TEXTURE           = 0x4,
+        MATERIAL_NORMAL_MAPS            = 0x8,
+        MATERIAL_BIASED_VERTEX_NORMALS  = 0x10,
+    };
+
+    enum MESH_FLAGS : uint32_t
+    {
+        MESH_CCW        = 0x1,
+        MESH_PMALPHA    = 0x2,
+    };
+
+    enum PART_FLAGS : uint32_t
+    {
+        PART_ALPHA      = 0x1,
+    };
+
+#pragma pack(push,4)
+
+    struct Header
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint32_t    fileSize;
+
+        uint32_t    numVertexBuffers;
+        uint32_t    numIndexBuffers;
+        uint32_t    numLayouts;
+        uint32_t    numElements;
+        uint32_t    numMaterials;
+        uint32_t    numMeshes;
+        uint32_t    numParts;
+
+        uint32_t    vertexBuffersOffset;
+        uint32_t    indexBuffersOffset;
+        uint32_t    layoutsOffset;
+        uint32_t    elementsOffset;
+        uint32_t    materialsOffset;
+        uint32_t    meshesOffset;
+        uint32_t    partsOffset;
+        uint32_t    stringsOffset;
+        uint32_t    stringsSize;
+    };
+
+    struct BufferRecord
+    {
+        uint32_t    dataOffset;
+        uint32_t    dataSize;
+    };
+
+    struct LayoutRecord
+    {
+        uint32_t    firstElement;
+        uint32_t    elementCount;
+    };
+
+    // D3D11_INPUT_ELEMENT_DESC with the semantic name stored as an index into the known semantics (see GetSemanticName).
+    struct ElementRecord
+    {
+        uint32_t    semantic;
+        uint32_t    semanticIndex;
+        uint32_t    format;
+        uint32_t    inputSlot;
+        uint32_t    alignedByteOffset;
+        uint32_t    inputSlotClass;
+        uint32_t    instanceDataStepRate;
+    };
+
+    struct MaterialRecord
+    {
+        uint32_t    name;
+        uint32_t    flags;
+        float       specularPower;
+        float       alpha;
+        float       ambientColor[3];
+        float       diffuseColor[3];
+        float       specularColor[3];
+        float       emissiveColor[3];
+        uint32_t    diffuseTexture;
+        uint32_t    specularTexture;
+        uint32_t    normalTexture;
+        uint32_t    emissiveTexture;
+    };
+
+    struct MeshRecord
+    {
+        uint32_t    name;
+        uint32_t    flags;
+        float       sphereCenter[3];
+        float       sphereRadius;
+        float       boxCenter[3];
+        float       boxExtents[3];
+        uint32_t    firstPart;
+        uint32_t    partCount;
+    };
+
+    struct PartRecord
+    {
+        uint32_t    indexCount;
+        uint32_t    startIndex;
+        int32_t     vertexOffset;
+        uint32_t    vertexStride;
+        uint32_t    primitiveType;
+        uint32_t    indexFormat;
+        uint32_t    vertexBuffer;
+        uint32_t    indexBuffer;
+        uint32_t    layout;
+        uint32_t    material;
+        uint32_t    flags;
+    };
+
+#pragma pack(pop)
+
+    // Semantic names are stored by index, so the input element descriptions built at load time can point at static strings.
+    inline const char* GetSemanticName(uint32_t semantic) noexcept
+    {
+        static const char* s_semantics[] =
+        {
+            "SV_Position",
+            "NORMAL",
+            "TANGENT",
+            "BINORMAL",
+            "COLOR",
+            "TEXCOORD",
+            "BLENDINDICES",
+            "BLENDWEIGHT",
+            "POSITION",
+        };
+
+        return (semantic < _countof(s_semantics)) ? s_semantics[semantic] : nullptr;
+    }
+
+} // namespace
+
+static_assert(sizeof(CookedModel::Header) == 76, "Cooked model header size mismatch");
+static_assert(sizeof(CookedModel::BufferRecord) == 8, "Cooked model buffer record size mismatch");
+static_assert(sizeof(CookedModel::LayoutRecord) == 8, "Cooked model layout record size mismatch");
+static_assert(sizeof(CookedModel::ElementRecord) == 28, "Cooked model element record size mismatch");
+static_assert(sizeof(CookedModel::MaterialRecord) == 80, "Cooked model material record size mismatch");
+static_assert(sizeof(CookedModel::MeshRecord) == 56, "Cooked model mesh record size mismatch");
+static_assert(sizeof(CookedModel::PartRecord) == 44, "Cooked model part record size mismatch");
@@ -7,6 +7,9 @@
 // a full-featured DDS file reader, writer, and texture processing pipeline see
 // the 'Texconv' sample and the 'DirectXTex' library.
 //
+// The auto-gen mipmap versions accept a deferred context, in which case the upload and
+// GenerateMips are only recorded, and run when its command list is executed.
+//
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 //
@@ -18,10 +21,13 @@
 
 #include "DDSTextureLoader.h"
 
+#include "BinaryReader.h"
 #include "PlatformHelpers.h"
 #include "DDS.h"
 #include "DirectXHelpers.h"
 #include "LoaderHelpers.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
 
 using namespace DirectX;
 using namespace DirectX::LoaderHelpers;
@@ -724,8 +730,12 @@ namespace
                         d3dContext->CopySubresourceRegion(tex, res, 0, 0, 0, pStaging, item, nullptr);
                     }
 
-                    UINT64 copyFence = d3dContextX->InsertFence(0);
-                    while (d3dDeviceX->IsFencePending(copyFence)) { SwitchToThread(); }
+                    // A deferred context's command list holds its own reference to the staging texture.
+                    if (d3dContext->GetType() != D3D11_DEVICE_CONTEXT_DEFERRED)
+                    {
+                        UINT64 copyFence = d3dContextX->InsertFence(0);
+                        while (d3dDeviceX->IsFencePending(copyFence)) { SwitchToThread(); }
+                    }
                     pStaging->Release();
                 }
 #else 
@@ -921,6 +931,29 @@ namespace
         UNREFERENCED_PARAMETER(textureView);
 #endif
     }
+
+    //--------------------------------------------------------------------------------------
+    void TrackTextureMemory(
+        _In_opt_z_ const wchar_t* fileName,
+        _In_opt_ ID3D11Resource** texture,
+        _In_opt_ ID3D11ShaderResourceView** textureView) noexcept
+    {
+        if (!MemoryTracker::IsEnabled())
+            return;
+
+        // Callers may ask for only the view, which still keeps the texture alive.
+        Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+        if (texture && *texture)
+        {
+            resource = *texture;
+        }
+        else if (textureView && *textureView)
+        {
+            (*textureView)->GetResource(resource.GetAddressOf());
+        }
+
+        MemoryTracker::TrackResource(resource.Get(), MemoryCategory_Texture, fileName ? fileName : L"DDSTextureLoader");
+    }
 } // anonymous namespace
 
 
@@ -1042,6 +1075,8 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
             SetDebugObjectName(*textureView, "DDSTextureLoader");
         }
 
+        TrackTextureMemory(nullptr, texture, textureView);
+
         if (alphaMode)
             *alphaMode = GetAlphaMode(header);
     }
@@ -1130,6 +1165,8 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
             SetDebugObjectName(*textureView, "DDSTextureLoader");
         }
 
+        TrackTextureMemory(nullptr, texture, textureView);
+
         if (alphaMode)
             *alphaMode = GetAlphaMode(header);
     }
@@ -1220,9 +1257,17 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     const uint8_t* bitData = nullptr;
     size_t bitSize = 0;
 
-    std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile(fileName,
-        ddsData,
+    // Texture data is uploaded straight from a read-only view of the file.
+    ScopedMappedView ddsData;
+    size_t ddsDataSize = 0;
+    HRESULT hr = BinaryReader::MapEntireFile(fileName, ddsData, &ddsDataSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = LoadTextureDataFromMemory(static_cast<const uint8_t*>(ddsData.get()),
+        ddsDataSize,
         &header,
         &bitData,
         &bitSize
@@ -1245,6 +1290,7 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
+        TrackTextureMemory(fileName, texture, textureView);
 
         if (alphaMode)
             *alphaMode = GetAlphaMode(header);
@@ -1301,9 +1347,17 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     const uint8_t* bitData = nullptr;
     size_t bitSize = 0;
 
-    std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile(fileName,
-        ddsData,
+    // Texture data is uploaded straight from a read-only view of the file.
+    ScopedMappedView ddsData;
+    size_t ddsDataSize = 0;
+    HRESULT hr = BinaryReader::MapEntireFile(fileName, ddsData, &ddsDataSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = LoadTextureDataFromMemory(static_cast<const uint8_t*>(ddsData.get()),
+        ddsDataSize,
         &header,
         &bitData,
         &bitSize
@@ -1326,6 +1380,7 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
+        TrackTextureMemory(fileName, texture, textureView);
 
         if (alphaMode)
             *alphaMode = GetAlphaMode(header);
@@ -1333,3 +1388,111 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
 
     return hr;
 }
+
+
+//--------------------------------------------------------------------------------------
+// Batch creation
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    // Runs create(index, texture, textureView, alphaMode) for each texture of a batch in parallel,
+    // and folds the per-texture results into the batch result.
+    template<typename TCreate>
+    HRESULT CreateTextureBatch(
+        size_t count,
+        _Out_writes_opt_(count) ID3D11Resource** textures,
+        _Out_writes_opt_(count) ID3D11ShaderResourceView** textureViews,
+        _Out_writes_opt_(count) HRESULT* results,
+        _Out_writes_opt_(count) DDS_ALPHA_MODE* alphaModes,
+        TCreate const& create) noexcept
+    {
+        if (!textures && !textureViews)
+        {
+            return E_INVALIDARG;
+        }
+
+        std::unique_ptr<HRESULT[]> localResults;
+        if (!results)
+        {
+            localResults.reset(new (std::nothrow) HRESULT[count]);
+            if (!localResults)
+                return E_OUTOFMEMORY;
+
+            results = localResults.get();
+        }
+
+        ParallelFor(count, [=](size_t index)
+        {
+            results[index] = create(index,
+                textures ? &textures[index] : nullptr,
+                textureViews ? &textureViews[index] : nullptr,
+                alphaModes ? &alphaModes[index] : nullptr);
+        });
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (FAILED(results[j]))
+                return results[j];
+        }
+
+        return S_OK;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTexturesFromMemory(
+    ID3D11Device* d3dDevice,
+    size_t count,
+    const uint8_t* const* ddsData,
+    const size_t* ddsDataSize,
+    ID3D11Resource** textures,
+    ID3D11ShaderResourceView** textureViews,
+    HRESULT* results,
+    size_t maxsize,
+    DDS_ALPHA_MODE* alphaModes) noexcept
+{
+    if (!d3dDevice || (count > 0 && (!ddsData || !ddsDataSize)))
+    {
+        return E_INVALIDARG;
+    }
+
+    return CreateTextureBatch(count, textures, textureViews, results, alphaModes,
+        [=](size_t index, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, DDS_ALPHA_MODE* alphaMode) noexcept
+        {
+            return CreateDDSTextureFromMemoryEx(d3dDevice,
+                ddsData[index], ddsDataSize[index],
+                maxsize,
+                D3D11_USAGE_IMMUTABLE, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+                false,
+                texture, textureView, alphaMode);
+        });
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTexturesFromFile(
+    ID3D11Device* d3dDevice,
+    size_t count,
+    const wchar_t* const* fileNames,
+    ID3D11Resource** textures,
+    ID3D11ShaderResourceView** textureViews,
+    HRESULT* results,
+    size_t maxsize,
+    DDS_ALPHA_MODE* alphaModes) noexcept
+{
+    if (!d3dDevice || (count > 0 && !fileNames))
+    {
+        return E_INVALIDARG;
+    }
+
+    return CreateTextureBatch(count, textures, textureViews, results, alphaModes,
+        [=](size_t index, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, DDS_ALPHA_MODE* alphaMode) noexcept
+        {
+            return CreateDDSTextureFromFileEx(d3dDevice,
+                fileNames[index],
+                maxsize,
+                D3D11_USAGE_IMMUTABLE, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+                false,
+                texture, textureView, alphaMode);
+        });
+}
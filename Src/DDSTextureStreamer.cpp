@@ -0,0 +1,769 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureStreamer.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "DDSTextureStreamer.h"
+
+#include "DirectXHelpers.h"
+#include "LoaderHelpers.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using namespace DirectX::LoaderHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    struct SubresourceInfo
+    {
+        uint64_t fileOffset;
+        UINT numBytes;
+        UINT rowBytes;
+    };
+
+
+    // One overlapped read of a single subresource.
+    struct PendingRead
+    {
+        PendingRead() noexcept : overlapped{}, slice(0) {}
+
+        OVERLAPPED overlapped;
+        ScopedHandle event;
+        std::unique_ptr<uint8_t[]> data;
+        UINT slice;
+    };
+
+
+    HRESULT StartRead(HANDLE hFile, uint64_t offset, UINT size, PendingRead& read) noexcept
+    {
+        read.event.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        if (!read.event)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        read.data.reset(new (std::nothrow) uint8_t[size]);
+        if (!read.data)
+            return E_OUTOFMEMORY;
+
+        read.overlapped = {};
+        read.overlapped.Offset = static_cast<DWORD>(offset);
+        read.overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        read.overlapped.hEvent = read.event.get();
+
+        if (!ReadFile(hFile, read.data.get(), size, nullptr, &read.overlapped))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_IO_PENDING)
+                return HRESULT_FROM_WIN32(error);
+        }
+
+        return S_OK;
+    }
+
+
+    HRESULT ReadAt(HANDLE hFile, uint64_t offset, UINT size, _Out_writes_bytes_(size) void* dest) noexcept
+    {
+        ScopedHandle event(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        if (!event)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        overlapped.hEvent = event.get();
+
+        if (!ReadFile(hFile, dest, size, nullptr, &overlapped))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_IO_PENDING)
+                return HRESULT_FROM_WIN32(error);
+        }
+
+        DWORD bytesRead = 0;
+        if (!GetOverlappedResult(hFile, &overlapped, &bytesRead, TRUE))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        return (bytesRead == size) ? S_OK : HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+
+
+    // Streaming state for one texture. Mip levels are numbered as in the file, so level 0 is always the full size
+    // image, whatever the current D3D texture starts at.
+    struct StreamingTexture
+    {
+        StreamingTexture() noexcept :
+            width(0),
+            height(0),
+            mipCount(0),
+            arraySize(0),
+            format(DXGI_FORMAT_UNKNOWN),
+            isCubeMap(false),
+            tailMip(0),
+            allocatedMip(0),
+            residentMip(0),
+            requestedMip(0),
+            loadingMip(UINT_MAX)
+        {
+        }
+
+        StreamingTexture(StreamingTexture const&) = delete;
+        StreamingTexture& operator= (StreamingTexture const&) = delete;
+
+        ~StreamingTexture()
+        {
+            CancelReads();
+        }
+
+        void CancelReads() noexcept
+        {
+            // Buffers cannot be freed until the I/O system is done with them.
+            for (auto& read : reads)
+            {
+                if (CancelIoEx(file.get(), &read.overlapped) || GetLastError() != ERROR_NOT_FOUND)
+                {
+                    DWORD bytesRead;
+                    (void)GetOverlappedResult(file.get(), &read.overlapped, &bytesRead, TRUE);
+                }
+            }
+
+            reads.clear();
+            loadingMip = UINT_MAX;
+        }
+
+        SubresourceInfo const& GetSubresource(UINT mip, UINT slice) const noexcept
+        {
+            return subresources[size_t(slice) * mipCount + mip];
+        }
+
+        UINT GetWidth(UINT mip) const noexcept { return std::max(width >> mip, 1u); }
+        UINT GetHeight(UINT mip) const noexcept { return std::max(height >> mip, 1u); }
+
+        // Bytes taken by a texture whose most detailed level is topMip.
+        size_t GetBytes(UINT topMip) const noexcept
+        {
+            size_t bytes = 0;
+            for (UINT mip = topMip; mip < mipCount; ++mip)
+            {
+                bytes += size_t(subresources[mip].numBytes) * arraySize;
+            }
+            return bytes;
+        }
+
+        ScopedHandle file;
+
+        UINT width;
+        UINT height;
+        UINT mipCount;
+        UINT arraySize;
+        DXGI_FORMAT format;
+        bool isCubeMap;
+
+        UINT tailMip;           // Most detailed level loaded at creation, and the least detail ever kept.
+        UINT allocatedMip;      // Most detailed level of the current D3D texture.
+        UINT residentMip;       // Most detailed level with data in the current D3D texture.
+        UINT requestedMip;
+        UINT loadingMip;        // Level being read, or UINT_MAX.
+
+        std::vector<SubresourceInfo> subresources;
+        std::vector<PendingRead> reads;
+
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11ShaderResourceView> textureView;
+    };
+}
+
+
+// Internal DDSTextureStreamer implementation class.
+class DDSTextureStreamer::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t budgetInBytes)
+        : mDevice(device),
+        mBudget(budgetInBytes),
+        mAllocatedBytes(0)
+    {
+        if (!device)
+            throw std::exception("Device cannot be null");
+    }
+
+    TextureId Load(_In_z_ const wchar_t* fileName, size_t initialMaxSize, bool forceSRGB);
+    void Update(_In_ ID3D11DeviceContext* deviceContext);
+
+    StreamingTexture& Get(TextureId id) const
+    {
+        if (id >= mTextures.size() || !mTextures[id])
+            throw std::out_of_range("Invalid streaming texture id");
+
+        return *mTextures[id];
+    }
+
+    void Unload(TextureId id)
+    {
+        auto& tex = Get(id);
+        mAllocatedBytes -= tex.GetBytes(tex.allocatedMip);
+        mTextures[id].reset();
+    }
+
+    size_t GetPendingReadCount() const noexcept
+    {
+        size_t count = 0;
+        for (auto const& tex : mTextures)
+        {
+            if (tex)
+                count += tex->reads.size();
+        }
+        return count;
+    }
+
+    size_t mBudget;
+    size_t mAllocatedBytes;
+
+private:
+    void ReadLayout(StreamingTexture& tex, _In_z_ const wchar_t* fileName, bool forceSRGB);
+    void CreateTexture(_In_opt_ ID3D11DeviceContext* deviceContext, StreamingTexture& tex, UINT topMip,
+                       _In_opt_ const D3D11_SUBRESOURCE_DATA* initData);
+    bool CompleteReads(_In_ ID3D11DeviceContext* deviceContext, StreamingTexture& tex);
+    void StartLevel(StreamingTexture& tex);
+
+    ComPtr<ID3D11Device> mDevice;
+
+    std::vector<std::unique_ptr<StreamingTexture>> mTextures;
+};
+
+
+// Opens the file and works out where each subresource lives.
+_Use_decl_annotations_
+void DDSTextureStreamer::Impl::ReadLayout(StreamingTexture& tex, const wchar_t* fileName, bool forceSRGB)
+{
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    CREATEFILE2_EXTENDED_PARAMETERS params = {};
+    params.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+    params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    params.dwFileFlags = FILE_FLAG_OVERLAPPED;
+    tex.file.reset(safe_handle(CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &params)));
+#else
+    tex.file.reset(safe_handle(CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr)));
+#endif
+
+    if (!tex.file)
+    {
+        DebugTrace("ERROR: DDSTextureStreamer failed to open '%ls' (%08X)\n", fileName, HRESULT_FROM_WIN32(GetLastError()));
+        throw std::exception("CreateFile");
+    }
+
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(tex.file.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+    {
+        throw std::exception("GetFileInformationByHandleEx");
+    }
+
+    auto fileSize = static_cast<uint64_t>(fileInfo.EndOfFile.QuadPart);
+
+    uint8_t headerData[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)] = {};
+    auto headerSize = static_cast<UINT>(std::min<uint64_t>(fileSize, sizeof(headerData)));
+
+    ThrowIfFailed(ReadAt(tex.file.get(), 0, headerSize, headerData));
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+    if (FAILED(LoadTextureDataFromMemory(headerData, headerSize, &header, &bitData, &bitSize)))
+    {
+        DebugTrace("ERROR: '%ls' is not a valid DDS file\n", fileName);
+        throw std::exception("LoadTextureDataFromMemory");
+    }
+
+    tex.width = header->width;
+    tex.height = header->height;
+    tex.mipCount = std::max(header->mipMapCount, 1u);
+    tex.arraySize = 1;
+
+    if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+    {
+        auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
+
+        if (d3d10ext->resourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D || !d3d10ext->arraySize)
+        {
+            DebugTrace("ERROR: DDSTextureStreamer only supports 2D textures ('%ls')\n", fileName);
+            throw std::exception("DDSTextureStreamer");
+        }
+
+        tex.format = d3d10ext->dxgiFormat;
+        tex.arraySize = d3d10ext->arraySize;
+
+        if (d3d10ext->miscFlag & D3D11_RESOURCE_MISC_TEXTURECUBE)
+        {
+            tex.arraySize *= 6;
+            tex.isCubeMap = true;
+        }
+    }
+    else
+    {
+        if (header->flags & DDS_HEADER_FLAGS_VOLUME)
+        {
+            DebugTrace("ERROR: DDSTextureStreamer only supports 2D textures ('%ls')\n", fileName);
+            throw std::exception("DDSTextureStreamer");
+        }
+
+        tex.format = GetDXGIFormat(header->ddspf);
+
+        if (header->caps2 & DDS_CUBEMAP)
+        {
+            if ((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+            {
+                DebugTrace("ERROR: DirectX 11 does not support partial cubemaps\n");
+                throw std::exception("DDSTextureStreamer");
+            }
+
+            tex.arraySize = 6;
+            tex.isCubeMap = true;
+        }
+    }
+
+    if (BitsPerPixel(tex.format) == 0)
+    {
+        DebugTrace("ERROR: DDSTextureStreamer does not support the format of '%ls'\n", fileName);
+        throw std::exception("DDSTextureStreamer");
+    }
+
+    // Bound sizes (for security purposes we don't trust DDS file metadata larger than the Direct3D hardware requirements)
+    if (tex.mipCount > D3D11_REQ_MIP_LEVELS
+        || tex.arraySize > D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+        || tex.width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+        || tex.height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+    {
+        DebugTrace("ERROR: Resource dimensions too large for DirectX 11 ('%ls')\n", fileName);
+        throw std::exception("DDSTextureStreamer");
+    }
+
+    if (forceSRGB)
+    {
+        tex.format = MakeSRGB(tex.format);
+    }
+
+    // Array slices are stored one after another, each with its full mip chain.
+    tex.subresources.resize(size_t(tex.mipCount) * tex.arraySize);
+
+    uint64_t offset = static_cast<uint64_t>(bitData - headerData);
+    for (UINT slice = 0; slice < tex.arraySize; ++slice)
+    {
+        for (UINT mip = 0; mip < tex.mipCount; ++mip)
+        {
+            size_t numBytes = 0;
+            size_t rowBytes = 0;
+            ThrowIfFailed(GetSurfaceInfo(tex.GetWidth(mip), tex.GetHeight(mip), tex.format, &numBytes, &rowBytes, nullptr));
+
+            if (numBytes > UINT32_MAX || rowBytes > UINT32_MAX)
+                throw std::exception("DDSTextureStreamer");
+
+            auto& sub = tex.subresources[size_t(slice) * tex.mipCount + mip];
+            sub.fileOffset = offset;
+            sub.numBytes = static_cast<UINT>(numBytes);
+            sub.rowBytes = static_cast<UINT>(rowBytes);
+
+            offset += numBytes;
+        }
+    }
+
+    if (offset > fileSize)
+    {
+        DebugTrace("ERROR: '%ls' is truncated\n", fileName);
+        throw std::exception("DDSTextureStreamer");
+    }
+}
+
+
+// Creates the D3D texture starting at topMip, copying across whatever the old texture already holds.
+_Use_decl_annotations_
+void DDSTextureStreamer::Impl::CreateTexture(ID3D11DeviceContext* deviceContext, StreamingTexture& tex, UINT topMip,
+                                             const D3D11_SUBRESOURCE_DATA* initData)
+{
+    UINT mipLevels = tex.mipCount - topMip;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = tex.GetWidth(topMip);
+    desc.Height = tex.GetHeight(topMip);
+    desc.MipLevels = mipLevels;
+    desc.ArraySize = tex.arraySize;
+    desc.Format = tex.format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = tex.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0u;
+
+    ComPtr<ID3D11Texture2D> texture;
+    ThrowIfFailed(mDevice->CreateTexture2D(&desc, initData, texture.GetAddressOf()));
+
+    UINT residentMip = initData ? topMip : std::max(tex.residentMip, topMip);
+
+    if (!initData)
+    {
+        assert(deviceContext != nullptr && tex.texture != nullptr);
+
+        UINT oldLevels = tex.mipCount - tex.allocatedMip;
+
+        for (UINT slice = 0; slice < tex.arraySize; ++slice)
+        {
+            for (UINT mip = residentMip; mip < tex.mipCount; ++mip)
+            {
+                deviceContext->CopySubresourceRegion(
+                    texture.Get(), D3D11CalcSubresource(mip - topMip, slice, mipLevels), 0, 0, 0,
+                    tex.texture.Get(), D3D11CalcSubresource(mip - tex.allocatedMip, slice, oldLevels), nullptr);
+            }
+        }
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = tex.format;
+
+    if (tex.isCubeMap)
+    {
+        if (tex.arraySize > 6)
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+            srvDesc.TextureCubeArray.MipLevels = UINT(-1);
+            srvDesc.TextureCubeArray.NumCubes = tex.arraySize / 6;
+        }
+        else
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+            srvDesc.TextureCube.MipLevels = UINT(-1);
+        }
+    }
+    else if (tex.arraySize > 1)
+    {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MipLevels = UINT(-1);
+        srvDesc.Texture2DArray.ArraySize = tex.arraySize;
+    }
+    else
+    {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = UINT(-1);
+    }
+
+    ComPtr<ID3D11ShaderResourceView> textureView;
+    ThrowIfFailed(mDevice->CreateShaderResourceView(texture.Get(), &srvDesc, textureView.GetAddressOf()));
+
+    // Keep the sampler off levels whose data has not arrived yet.
+    if (deviceContext && residentMip > topMip)
+    {
+        deviceContext->SetResourceMinLOD(texture.Get(), float(residentMip - topMip));
+    }
+
+    SetDebugObjectName(texture.Get(), "DDSTextureStreamer");
+
+    if (tex.texture)
+    {
+        mAllocatedBytes -= tex.GetBytes(tex.allocatedMip);
+    }
+    mAllocatedBytes += tex.GetBytes(topMip);
+
+    tex.texture.Swap(texture);
+    tex.textureView.Swap(textureView);
+    tex.allocatedMip = topMip;
+    tex.residentMip = residentMip;
+}
+
+
+_Use_decl_annotations_
+DDSTextureStreamer::TextureId DDSTextureStreamer::Impl::Load(const wchar_t* fileName, size_t initialMaxSize, bool forceSRGB)
+{
+    if (!fileName)
+        throw std::exception("Invalid arguments");
+
+    auto tex = std::make_unique<StreamingTexture>();
+
+    ReadLayout(*tex, fileName, forceSRGB);
+
+    // Same rule as the maxsize parameter of CreateDDSTextureFromFile: skip levels larger than initialMaxSize.
+    UINT tailMip = 0;
+    if (initialMaxSize && tex->mipCount > 1)
+    {
+        while (tailMip + 1 < tex->mipCount
+               && (tex->GetWidth(tailMip) > initialMaxSize || tex->GetHeight(tailMip) > initialMaxSize))
+        {
+            ++tailMip;
+        }
+    }
+
+    // The mip tail of each slice is one contiguous run in the file.
+    UINT tailLevels = tex->mipCount - tailMip;
+
+    std::vector<std::unique_ptr<uint8_t[]>> tailData(tex->arraySize);
+    std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData(new D3D11_SUBRESOURCE_DATA[size_t(tailLevels) * tex->arraySize]);
+
+    for (UINT slice = 0; slice < tex->arraySize; ++slice)
+    {
+        auto const& first = tex->GetSubresource(tailMip, slice);
+        auto const& last = tex->GetSubresource(tex->mipCount - 1, slice);
+
+        uint64_t size = last.fileOffset + last.numBytes - first.fileOffset;
+        if (size > UINT32_MAX)
+            throw std::exception("DDSTextureStreamer");
+
+        tailData[slice].reset(new uint8_t[static_cast<size_t>(size)]);
+
+        ThrowIfFailed(ReadAt(tex->file.get(), first.fileOffset, static_cast<UINT>(size), tailData[slice].get()));
+
+        for (UINT mip = tailMip; mip < tex->mipCount; ++mip)
+        {
+            auto const& sub = tex->GetSubresource(mip, slice);
+
+            auto& init = initData[D3D11CalcSubresource(mip - tailMip, slice, tailLevels)];
+            init.pSysMem = tailData[slice].get() + (sub.fileOffset - first.fileOffset);
+            init.SysMemPitch = sub.rowBytes;
+            init.SysMemSlicePitch = sub.numBytes;
+        }
+    }
+
+    CreateTexture(nullptr, *tex, tailMip, initData.get());
+
+    tex->tailMip = tailMip;
+    tex->requestedMip = tailMip;
+
+    // Reuse the slot of an unloaded texture if there is one.
+    for (size_t j = 0; j < mTextures.size(); ++j)
+    {
+        if (!mTextures[j])
+        {
+            mTextures[j] = std::move(tex);
+            return static_cast<TextureId>(j);
+        }
+    }
+
+    mTextures.emplace_back(std::move(tex));
+    return static_cast<TextureId>(mTextures.size() - 1);
+}
+
+
+// Issues the reads for the next level up from the resident data.
+void DDSTextureStreamer::Impl::StartLevel(StreamingTexture& tex)
+{
+    assert(tex.reads.empty() && tex.residentMip > tex.allocatedMip);
+
+    UINT mip = tex.residentMip - 1;
+
+    tex.reads.resize(tex.arraySize);
+
+    for (UINT slice = 0; slice < tex.arraySize; ++slice)
+    {
+        auto const& sub = tex.GetSubresource(mip, slice);
+
+        auto& read = tex.reads[slice];
+        read.slice = slice;
+
+        HRESULT hr = StartRead(tex.file.get(), sub.fileOffset, sub.numBytes, read);
+        if (FAILED(hr))
+        {
+            tex.CancelReads();
+            throw com_exception(hr);
+        }
+    }
+
+    tex.loadingMip = mip;
+}
+
+
+// Uploads the level being read once every slice has arrived. Returns true if it did.
+_Use_decl_annotations_
+bool DDSTextureStreamer::Impl::CompleteReads(ID3D11DeviceContext* deviceContext, StreamingTexture& tex)
+{
+    if (tex.reads.empty())
+        return false;
+
+    for (auto& read : tex.reads)
+    {
+        DWORD bytesRead = 0;
+        if (!GetOverlappedResult(tex.file.get(), &read.overlapped, &bytesRead, FALSE))
+        {
+            DWORD error = GetLastError();
+            if (error == ERROR_IO_INCOMPLETE)
+                return false;
+
+            tex.CancelReads();
+            throw com_exception(HRESULT_FROM_WIN32(error));
+        }
+
+        if (bytesRead != tex.GetSubresource(tex.loadingMip, read.slice).numBytes)
+        {
+            tex.CancelReads();
+            throw std::exception("DDSTextureStreamer read past the end of the file");
+        }
+    }
+
+    UINT mip = tex.loadingMip;
+    UINT mipLevels = tex.mipCount - tex.allocatedMip;
+
+    for (auto const& read : tex.reads)
+    {
+        auto const& sub = tex.GetSubresource(mip, read.slice);
+
+        deviceContext->UpdateSubresource(tex.texture.Get(), D3D11CalcSubresource(mip - tex.allocatedMip, read.slice, mipLevels),
+            nullptr, read.data.get(), sub.rowBytes, sub.numBytes);
+    }
+
+    deviceContext->SetResourceMinLOD(tex.texture.Get(), float(mip - tex.allocatedMip));
+
+    tex.residentMip = mip;
+    tex.reads.clear();
+    tex.loadingMip = UINT_MAX;
+
+    return true;
+}
+
+
+_Use_decl_annotations_
+void DDSTextureStreamer::Impl::Update(ID3D11DeviceContext* deviceContext)
+{
+    if (!deviceContext)
+        throw std::exception("Context cannot be null");
+
+    std::vector<StreamingTexture*> promotions;
+
+    for (auto& it : mTextures)
+    {
+        if (!it)
+            continue;
+
+        auto& tex = *it;
+
+        if (CompleteReads(deviceContext, tex) && tex.residentMip > tex.allocatedMip)
+        {
+            StartLevel(tex);
+        }
+
+        if (!tex.reads.empty())
+            continue;
+
+        if (tex.requestedMip > tex.allocatedMip)
+        {
+            // Shrinking frees memory, so it happens before any texture grows.
+            CreateTexture(deviceContext, tex, tex.requestedMip, nullptr);
+        }
+        else if (tex.requestedMip < tex.allocatedMip)
+        {
+            promotions.push_back(&tex);
+        }
+    }
+
+    // Textures furthest from the detail they asked for go first.
+    std::stable_sort(promotions.begin(), promotions.end(), [](StreamingTexture const* a, StreamingTexture const* b) noexcept
+    {
+        return (a->allocatedMip - a->requestedMip) > (b->allocatedMip - b->requestedMip);
+    });
+
+    for (auto tex : promotions)
+    {
+        size_t current = tex->GetBytes(tex->allocatedMip);
+
+        // Go as far towards the requested level as the budget allows.
+        for (UINT topMip = tex->requestedMip; topMip < tex->allocatedMip; ++topMip)
+        {
+            size_t growth = tex->GetBytes(topMip) - current;
+            if (mAllocatedBytes + growth <= mBudget)
+            {
+                CreateTexture(deviceContext, *tex, topMip, nullptr);
+                StartLevel(*tex);
+                break;
+            }
+        }
+    }
+}
+
+
+// Public constructor.
+DDSTextureStreamer::DDSTextureStreamer(_In_ ID3D11Device* device, size_t budgetInBytes)
+    : pImpl(std::make_unique<Impl>(device, budgetInBytes))
+{
+}
+
+
+// Move constructor.
+DDSTextureStreamer::DDSTextureStreamer(DDSTextureStreamer&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+DDSTextureStreamer& DDSTextureStreamer::operator= (DDSTextureStreamer&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+DDSTextureStreamer::~DDSTextureStreamer()
+{
+}
+
+
+_Use_decl_annotations_
+DDSTextureStreamer::TextureId DDSTextureStreamer::Load(const wchar_t* fileName, size_t initialMaxSize, bool forceSRGB)
+{
+    return pImpl->Load(fileName, initialMaxSize, forceSRGB);
+}
+
+
+void DDSTextureStreamer::Unload(TextureId id)
+{
+    pImpl->Unload(id);
+}
+
+
+ID3D11ShaderResourceView* DDSTextureStreamer::GetShaderResourceView(TextureId id) const
+{
+    return pImpl->Get(id).textureView.Get();
+}
+
+
+void DDSTextureStreamer::SetRequestedMip(TextureId id, unsigned int mip)
+{
+    auto& tex = pImpl->Get(id);
+    tex.requestedMip = std::min(mip, tex.tailMip);
+}
+
+
+unsigned int DDSTextureStreamer::GetResidentMip(TextureId id) const
+{
+    return pImpl->Get(id).residentMip;
+}
+
+
+_Use_decl_annotations_
+void DDSTextureStreamer::Update(ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Update(deviceContext);
+}
+
+
+void DDSTextureStreamer::SetBudget(size_t budgetInBytes) noexcept
+{
+    pImpl->mBudget = budgetInBytes;
+}
+
+
+size_t DDSTextureStreamer::GetBudget() const noexcept
+{
+    return pImpl->mBudget;
+}
+
+
+size_t DDSTextureStreamer::GetAllocatedBytes() const noexcept
+{
+    return pImpl->mAllocatedBytes;
+}
+
+
+size_t DDSTextureStreamer::GetPendingReadCount() const noexcept
+{
+    return pImpl->GetPendingReadCount();
+}
@@ -120,7 +120,8 @@ struct DGSLEffectTraits
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -179,38 +180,39 @@ namespace
     #include "Shaders/Compiled/DGSLPhong_mainTxTk.inc"
 #endif
 }
+#endif
 
 
 const ShaderBytecode DGSLEffectTraits::VertexShaderBytecode[] =
 {
-    { DGSLEffect_main, sizeof(DGSLEffect_main) },
-    { DGSLEffect_mainVc, sizeof(DGSLEffect_mainVc) },
-    { DGSLEffect_main1Bones, sizeof(DGSLEffect_main1Bones) },
-    { DGSLEffect_main1BonesVc, sizeof(DGSLEffect_main1BonesVc) },
-    { DGSLEffect_main2Bones, sizeof(DGSLEffect_main2Bones) },
-    { DGSLEffect_main2BonesVc, sizeof(DGSLEffect_main2BonesVc) },
-    { DGSLEffect_main4Bones, sizeof(DGSLEffect_main4Bones) },
-    { DGSLEffect_main4BonesVc, sizeof(DGSLEffect_main4BonesVc) },
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_mainVc),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main1Bones),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main1BonesVc),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main2Bones),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main2BonesVc),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main4Bones),
+    EFFECT_SHADER_BYTECODE(DGSLEffect_main4BonesVc),
 };
 
 
 const ShaderBytecode DGSLEffectTraits::PixelShaderBytecode[] =
 {
-    { DGSLUnlit_main, sizeof(DGSLUnlit_main) },             // UNLIT (no texture)
-    { DGSLLambert_main, sizeof(DGSLLambert_main) },         // LAMBERT (no texture)
-    { DGSLPhong_main, sizeof(DGSLPhong_main) },             // PHONG (no texture)
+    EFFECT_SHADER_BYTECODE(DGSLUnlit_main),                 // UNLIT (no texture)
+    EFFECT_SHADER_BYTECODE(DGSLLambert_main),               // LAMBERT (no texture)
+    EFFECT_SHADER_BYTECODE(DGSLPhong_main),                 // PHONG (no texture)
 
-    { DGSLUnlit_mainTx, sizeof(DGSLUnlit_mainTx) },         // UNLIT (textured)
-    { DGSLLambert_mainTx, sizeof(DGSLLambert_mainTx) },     // LAMBERT (textured)
-    { DGSLPhong_mainTx, sizeof(DGSLPhong_mainTx) },         // PHONG (textured)
+    EFFECT_SHADER_BYTECODE(DGSLUnlit_mainTx),               // UNLIT (textured)
+    EFFECT_SHADER_BYTECODE(DGSLLambert_mainTx),             // LAMBERT (textured)
+    EFFECT_SHADER_BYTECODE(DGSLPhong_mainTx),               // PHONG (textured)
 
-    { DGSLUnlit_mainTk, sizeof(DGSLUnlit_mainTk) },         // UNLIT (no texture, discard)
-    { DGSLLambert_mainTk, sizeof(DGSLLambert_mainTk) },     // LAMBERT (no texture, discard)
-    { DGSLPhong_mainTk, sizeof(DGSLPhong_mainTk) },         // PHONG (no texture, discard)
+    EFFECT_SHADER_BYTECODE(DGSLUnlit_mainTk),               // UNLIT (no texture, discard)
+    EFFECT_SHADER_BYTECODE(DGSLLambert_mainTk),             // LAMBERT (no texture, discard)
+    EFFECT_SHADER_BYTECODE(DGSLPhong_mainTk),               // PHONG (no texture, discard)
 
-    { DGSLUnlit_mainTxTk, sizeof(DGSLUnlit_mainTxTk) },     // UNLIT (textured, discard)
-    { DGSLLambert_mainTxTk, sizeof(DGSLLambert_mainTxTk) }, // LAMBERT (textured, discard)
-    { DGSLPhong_mainTxTk, sizeof(DGSLPhong_mainTxTk) },     // PHONG (textured, discard)
+    EFFECT_SHADER_BYTECODE(DGSLUnlit_mainTxTk),             // UNLIT (textured, discard)
+    EFFECT_SHADER_BYTECODE(DGSLLambert_mainTxTk),           // LAMBERT (textured, discard)
+    EFFECT_SHADER_BYTECODE(DGSLPhong_mainTxTk),             // PHONG (textured, discard)
 };
 
 
@@ -273,6 +275,8 @@ public:
     void Apply(_In_ ID3D11DeviceContext* deviceContext);
     void GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength) noexcept;
 
+    static std::shared_ptr<void> CreateAllShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+
     // Fields
     DGSLEffectConstants constants;
 
@@ -310,7 +314,7 @@ private:
     {
     public:
         DeviceResources(_In_ ID3D11Device* device) noexcept
-            : EffectDeviceResources(device),
+            : EffectDeviceResources(device, BuiltInEffect_DGSL),
             mVertexShaders{},
             mPixelShaders{}
         { }
@@ -331,6 +335,26 @@ private:
             return DemandCreatePixelShader(mPixelShaders[permutation], DGSLEffectTraits::PixelShaderBytecode[permutation]);
         }
 
+        // Creates every shader up front, returning how many the device accepted.
+        size_t CreateAllShaders()
+        {
+            size_t count = 0;
+
+            for (int j = 0; j < DGSLEffectTraits::VertexShaderCount; ++j)
+            {
+                if (WarmUpVertexShader(mVertexShaders[j], DGSLEffectTraits::VertexShaderBytecode[j]))
+                    ++count;
+            }
+
+            for (int j = 0; j < DGSLEffectTraits::PixelShaderCount; ++j)
+            {
+                if (WarmUpPixelShader(mPixelShaders[j], DGSLEffectTraits::PixelShaderBytecode[j]))
+                    ++count;
+            }
+
+            return count;
+        }
+
         // Gets or lazily creates the default texture
         ID3D11ShaderResourceView* GetDefaultTexture() { return EffectDeviceResources::GetDefaultTexture(); }
 
@@ -351,15 +375,42 @@ private:
 SharedResourcePool<ID3D11Device*, DGSLEffect::Impl::DeviceResources> DGSLEffect::Impl::deviceResourcesPool;
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DGSLEffect::Impl::CreateAllShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    auto deviceResources = deviceResourcesPool.DemandCreate(device);
+
+    *shaderCount = deviceResources->CreateAllShaders();
+
+    return deviceResources;
+}
+
+
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllDGSLEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return DGSLEffect::Impl::CreateAllShaders(device, shaderCount);
+}
+
+
 void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
-    auto vertexShader = mDeviceResources->GetVertexShader(GetCurrentVSPermutation());
+    int vsPermutation = GetCurrentVSPermutation();
+    int psPermutation = GetCurrentPSPermutation();
+
+    auto vertexShader = mDeviceResources->GetVertexShader(vsPermutation);
     auto pixelShader = mPixelShader.Get();
     if (!pixelShader)
     {
-        pixelShader = mDeviceResources->GetPixelShader(GetCurrentPSPermutation());
+        pixelShader = mDeviceResources->GetPixelShader(psPermutation);
     }
 
+    CountEffectApply(BuiltInEffect_DGSL, vsPermutation * DGSLEffectTraits::PixelShaderCount + psPermutation);
+
+    // DGSLEffect binds its own shaders and constant buffers, so the other effects cannot trust what they last applied.
+    InvalidateEffectStateCache(deviceContext);
+
     deviceContext->VSSetShader(vertexShader, nullptr, 0);
     deviceContext->PSSetShader(pixelShader, nullptr, 0);
 
@@ -410,6 +461,12 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     void *grfxMemoryMisc;
     mCBMisc.SetData(deviceContext, constants.misc, &grfxMemoryMisc);
 
+    // Placement constants are written for each of the four buffers on every Apply.
+    for (int j = 0; j < 4; ++j)
+    {
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+    }
+
     ComPtr<ID3D11DeviceContextX> deviceContextX;
     ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
 
@@ -434,6 +491,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         void* grfxMemoryBone;
         mCBBone.SetData(deviceContext, constants.bones, &grfxMemoryBone);
 
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
         deviceContextX->VSSetPlacementConstantBuffer(4, mCBBone.GetBuffer(), grfxMemoryBone);
     }
 #else
@@ -442,6 +501,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         mCBMaterial.SetData(deviceContext, constants.material);
 
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
         dirtyFlags &= ~EffectDirtyFlags::ConstantBufferMaterial;
     }
 
@@ -449,6 +510,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         mCBLight.SetData(deviceContext, constants.light);
 
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
         dirtyFlags &= ~EffectDirtyFlags::ConstantBufferLight;
     }
 
@@ -456,6 +519,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         mCBObject.SetData(deviceContext, constants.object);
 
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
         dirtyFlags &= ~EffectDirtyFlags::ConstantBufferObject;
     }
 
@@ -463,6 +528,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         mCBMisc.SetData(deviceContext, constants.misc);
 
+        CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
         dirtyFlags &= ~EffectDirtyFlags::ConstantBufferMisc;
     }
 
@@ -472,6 +539,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         {
             mCBBone.SetData(deviceContext, constants.bones);
 
+            CountEffectStatistic(BuiltInEffect_DGSL, EffectCounter::ConstantBufferUpdate);
+
             dirtyFlags &= ~EffectDirtyFlags::ConstantBufferBones;
         }
 
@@ -512,9 +581,7 @@ void DGSLEffect::Impl::GetVertexShaderBytecode(_Out_ void const** pShaderByteCod
     assert(permutation < DGSLEffectTraits::VertexShaderCount);
     _Analysis_assume_(permutation < DGSLEffectTraits::VertexShaderCount);
 
-    auto shader = DGSLEffectTraits::VertexShaderBytecode[permutation];
-    *pShaderByteCode = shader.code;
-    *pByteCodeLength = shader.length;
+    GetShaderBytecode(DGSLEffectTraits::VertexShaderBytecode[permutation], pShaderByteCode, pByteCodeLength);
 }
 
 
@@ -592,6 +659,8 @@ DGSLEffect::~DGSLEffect()
 // IEffect methods.
 void DGSLEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"DGSLEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -10,12 +10,17 @@
 #include "pch.h"
 #include "Effects.h"
 #include "DemandCreate.h"
+#include "MaterialCache.h"
+#include "ResourceCache.h"
 #include "SharedResourcePool.h"
+#include "ShaderPack.h"
+#include "ThreadPool.h"
 
 #include "DDSTextureLoader.h"
 #include "WICTextureLoader.h"
 
 #include <string.h>
+#include <unordered_map>
 
 #include "BinaryReader.h"
 
@@ -24,6 +29,93 @@ using Microsoft::WRL::ComPtr;
 
 static_assert(DGSLEffect::MaxTextures == DGSLEffectFactory::DGSLEffectInfo::BaseTextureOffset + _countof(DGSLEffectFactory::DGSLEffectInfo::textures), "DGSL supports 8 textures");
 
+namespace
+{
+    // Identifies pixel shader bytecode, so materials whose shaders have different names but the same contents
+    // share one ID3D11PixelShader. DXBC already carries a checksum of its contents after the magic, which is used
+    // as is; anything else is hashed with FNV-1a.
+    struct BytecodeKey
+    {
+        uint64_t hash[2];
+        size_t size;
+
+        bool operator== (BytecodeKey const& other) const noexcept
+        {
+            return hash[0] == other.hash[0] && hash[1] == other.hash[1] && size == other.size;
+        }
+    };
+
+    struct BytecodeKeyHash
+    {
+        size_t operator()(BytecodeKey const& key) const noexcept
+        {
+            return static_cast<size_t>(key.hash[0] ^ key.hash[1] ^ key.size);
+        }
+    };
+
+    BytecodeKey GetBytecodeKey(_In_reads_bytes_(size) const void* bytecode, size_t size) noexcept
+    {
+        BytecodeKey key = {};
+        key.size = size;
+
+        auto bytes = static_cast<const uint8_t*>(bytecode);
+
+        if (size >= 20 && !memcmp(bytes, "DXBC", 4))
+        {
+            memcpy(key.hash, bytes + 4, sizeof(key.hash));
+        }
+        else
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t j = 0; j < size; ++j)
+            {
+                hash ^= bytes[j];
+                hash *= 1099511628211ull;
+            }
+
+            key.hash[0] = hash;
+        }
+
+        return key;
+    }
+
+
+    // Pack entries are keyed by file name without directory or extension, compared case-insensitively.
+    std::wstring GetShaderPackKey(_In_z_ const wchar_t* name)
+    {
+        wchar_t fname[_MAX_FNAME] = {};
+        _wsplitpath_s(name, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, nullptr, 0);
+
+        std::wstring key(fname);
+        std::transform(key.begin(), key.end(), key.begin(), towlower);
+        return key;
+    }
+
+
+    // DGSL pixel shader names end in the name of the shader they were built from, such as "foo_Lambert.cso".
+    void GetShaderRoot(_In_z_ const wchar_t* pixelShader, wchar_t (&root)[MAX_PATH])
+    {
+        auto last = wcsrchr(pixelShader, '_');
+        if (last)
+        {
+            wcscpy_s(root, last + 1);
+        }
+        else
+        {
+            wcscpy_s(root, pixelShader);
+        }
+
+        auto first = wcschr(root, '.');
+        if (first)
+            *first = 0;
+    }
+
+    bool IsBuiltInShader(_In_z_ const wchar_t* root) noexcept
+    {
+        return !_wcsicmp(root, L"lambert") || !_wcsicmp(root, L"phong") || !_wcsicmp(root, L"unlit");
+    }
+}
+
 // Internal DGSLEffectFactory implementation class. Only one of these helpers is allocated
 // per D3D device, even if there are multiple public facing DGSLEffectFactory instances.
 class DGSLEffectFactory::Impl
@@ -41,6 +133,9 @@ public:
     void CreateTexture(_In_z_ const wchar_t* texture, _In_opt_ ID3D11DeviceContext* deviceContext, _Outptr_ ID3D11ShaderResourceView** textureView);
     void CreatePixelShader(_In_z_ const wchar_t* shader, _Outptr_ ID3D11PixelShader** pixelShader);
 
+    void LoadShaderPack(_In_z_ const wchar_t* fileName);
+    std::future<void> PreloadPixelShadersAsync(const std::shared_ptr<Impl>& self, _In_reads_(count) const wchar_t* const* shaders, size_t count);
+
     void ReleaseCache();
     void SetSharing(bool enabled) noexcept { mSharing = enabled; }
     void EnableForceSRGB(bool forceSRGB) noexcept { mForceSRGB = forceSRGB; }
@@ -52,19 +147,31 @@ public:
     ComPtr<ID3D11Device> mDevice;
 
 private:
-    typedef std::map< std::wstring, std::shared_ptr<IEffect> > EffectCache;
-    typedef std::map< std::wstring, ComPtr<ID3D11ShaderResourceView> > TextureCache;
-    typedef std::map< std::wstring, ComPtr<ID3D11PixelShader> > ShaderCache;
+    typedef MaterialCache< std::shared_ptr<IEffect> > EffectCache;
+    typedef ResourceCache<ID3D11ShaderResourceView> TextureCache;
+    typedef ResourceCache<ID3D11PixelShader> ShaderCache;
 
     EffectCache  mEffectCache;
     EffectCache  mEffectCacheSkinning;
     TextureCache mTextureCache;
     ShaderCache  mShaderCache;
 
+    // Shaders by bytecode, behind the name-keyed shader cache, and the shaders from LoadShaderPack. Both are
+    // guarded by mBytecodeMutex, which is never held while a shader is created.
+    std::unordered_map<BytecodeKey, ComPtr<ID3D11PixelShader>, BytecodeKeyHash> mBytecodeCache;
+    std::unordered_map<std::wstring, ComPtr<ID3D11PixelShader>> mPackShaders;
+    std::mutex mBytecodeMutex;
+
     bool mSharing;
     bool mForceSRGB;
 
+    // Guards the effect caches, and the device context when it is passed in for WIC auto-gen mipmaps. The
+    // texture and shader caches have their own locks, so parallel model loads only meet here when they create effects.
     std::mutex mutex;
+
+    void LoadTexture(_In_z_ const wchar_t* texture, _In_opt_ ID3D11DeviceContext* deviceContext, _Outptr_ ID3D11ShaderResourceView** textureView);
+    void LoadPixelShader(_In_z_ const wchar_t* shader, _Outptr_ ID3D11PixelShader** pixelShader);
+    HRESULT CreatePixelShaderFromBytecode(_In_reads_bytes_(size) const void* bytecode, size_t size, _Outptr_ ID3D11PixelShader** pixelShader);
 };
 
 
@@ -80,23 +187,16 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateEffect(DGSLEffectFactory
         throw std::exception("DGSLEffect does not support multiple texcoords");
     }
 
-    if (mSharing && info.name && *info.name)
+    MaterialKey key(info);
+
+    if (mSharing)
     {
-        if (info.enableSkinning)
-        {
-            auto it = mEffectCacheSkinning.find(info.name);
-            if (it != mEffectCacheSkinning.end())
-            {
-                return it->second;
-            }
-        }
-        else
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto cached = (info.enableSkinning ? mEffectCacheSkinning : mEffectCache).Find(key);
+        if (cached)
         {
-            auto it = mEffectCache.find(info.name);
-            if (it != mEffectCache.end())
-            {
-                return it->second;
-            }
+            return *cached;
         }
     }
 
@@ -141,18 +241,11 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateEffect(DGSLEffectFactory
         effect->SetTextureEnabled(true);
     }
 
-    if (mSharing && info.name && *info.name)
+    if (mSharing)
     {
         std::lock_guard<std::mutex> lock(mutex);
-        EffectCache::value_type v(info.name, effect);
-        if (info.enableSkinning)
-        {
-            mEffectCacheSkinning.insert(v);
-        }
-        else
-        {
-            mEffectCache.insert(v);
-        }
+
+        return (info.enableSkinning ? mEffectCacheSkinning : mEffectCache).Insert(std::move(key), effect);
     }
 
     return std::move(effect);
@@ -162,23 +255,24 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateEffect(DGSLEffectFactory
 _Use_decl_annotations_
 std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateDGSLEffect(DGSLEffectFactory* factory, const DGSLEffectFactory::DGSLEffectInfo& info, ID3D11DeviceContext* deviceContext)
 {
-    if (mSharing && info.name && *info.name)
+    // The DGSL textures and pixel shader are part of the material too.
+    MaterialKey key(info);
+
+    for (size_t j = 0; j < _countof(info.textures); ++j)
     {
-        if (info.enableSkinning)
-        {
-            auto it = mEffectCacheSkinning.find(info.name);
-            if (it != mEffectCacheSkinning.end())
-            {
-                return it->second;
-            }
-        }
-        else
+        key.AddString(info.textures[j]);
+    }
+
+    key.AddString(info.pixelShader);
+
+    if (mSharing)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto cached = (info.enableSkinning ? mEffectCacheSkinning : mEffectCache).Find(key);
+        if (cached)
         {
-            auto it = mEffectCache.find(info.name);
-            if (it != mEffectCache.end())
-            {
-                return it->second;
-            }
+            return *cached;
         }
     }
 
@@ -194,19 +288,7 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateDGSLEffect(DGSLEffectFac
     else
     {
         wchar_t root[MAX_PATH] = {};
-        auto last = wcsrchr(info.pixelShader, '_');
-        if (last)
-        {
-            wcscpy_s(root, last + 1);
-        }
-        else
-        {
-            wcscpy_s(root, info.pixelShader);
-        }
-
-        auto first = wcschr(root, '.');
-        if (first)
-            *first = 0;
+        GetShaderRoot(info.pixelShader, root);
 
         if (!_wcsicmp(root, L"lambert"))
         {
@@ -333,18 +415,11 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateDGSLEffect(DGSLEffectFac
         }
     }
 
-    if (mSharing && info.name && *info.name)
+    if (mSharing)
     {
         std::lock_guard<std::mutex> lock(mutex);
-        EffectCache::value_type v(info.name, effect);
-        if (info.enableSkinning)
-        {
-            mEffectCacheSkinning.insert(v);
-        }
-        else
-        {
-            mEffectCache.insert(v);
-        }
+
+        return (info.enableSkinning ? mEffectCacheSkinning : mEffectCache).Insert(std::move(key), effect);
     }
 
     return std::move(effect);
@@ -357,153 +432,385 @@ void DGSLEffectFactory::Impl::CreateTexture(const wchar_t* name, ID3D11DeviceCon
     if (!name || !textureView)
         throw std::exception("invalid arguments");
 
+    if (mSharing && *name)
+    {
+        auto srv = mTextureCache.GetOrCreate(name, [&]()
+        {
+            ComPtr<ID3D11ShaderResourceView> result;
+            LoadTexture(name, deviceContext, result.GetAddressOf());
+            return result;
+        });
+
+        *textureView = srv.Detach();
+    }
+    else
+    {
+        LoadTexture(name, deviceContext, textureView);
+    }
+}
+
+_Use_decl_annotations_
+void DGSLEffectFactory::Impl::LoadTexture(const wchar_t* name, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView** textureView)
+{
 #if defined(_XBOX_ONE) && defined(_TITLE)
     UNREFERENCED_PARAMETER(deviceContext);
 #endif
 
-    auto it = mTextureCache.find(name);
+    wchar_t fullName[MAX_PATH] = {};
+    wcscpy_s(fullName, mPath);
+    wcscat_s(fullName, name);
+
+    WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+    if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+    {
+        // Try Current Working Directory (CWD)
+        wcscpy_s(fullName, name);
+        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+        {
+            DebugTrace("ERROR: DGSLEffectFactory could not find texture file '%ls'\n", name);
+            throw std::exception("CreateTexture");
+        }
+    }
+
+    wchar_t ext[_MAX_EXT];
+    _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
 
-    if (mSharing && it != mTextureCache.end())
+    if (_wcsicmp(ext, L".dds") == 0)
+    {
+        HRESULT hr = CreateDDSTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB, nullptr, textureView);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateDDSTextureFromFile");
+        }
+    }
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    else if (deviceContext)
     {
-        ID3D11ShaderResourceView* srv = it->second.Get();
-        srv->AddRef();
-        *textureView = srv;
+        std::lock_guard<std::mutex> lock(mutex);
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), deviceContext, fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateWICTextureFromFile");
+        }
     }
+#endif
     else
     {
-        wchar_t fullName[MAX_PATH] = {};
-        wcscpy_s(fullName, mPath);
-        wcscat_s(fullName, name);
-
-        WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
-        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
         {
-            // Try Current Working Directory (CWD)
-            wcscpy_s(fullName, name);
-            if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-            {
-                DebugTrace("ERROR: DGSLEffectFactory could not find texture file '%ls'\n", name);
-                throw std::exception("CreateTexture");
-            }
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateWICTextureFromFile");
         }
+    }
+}
 
-        wchar_t ext[_MAX_EXT];
-        _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
 
-        if (_wcsicmp(ext, L".dds") == 0)
+_Use_decl_annotations_
+void DGSLEffectFactory::Impl::CreatePixelShader(const wchar_t* name, ID3D11PixelShader** pixelShader)
+{
+    if (!name || !pixelShader)
+        throw std::exception("invalid arguments");
+
+    if (mSharing && *name)
+    {
+        auto ps = mShaderCache.GetOrCreate(name, [&]()
         {
-            HRESULT hr = CreateDDSTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateDDSTextureFromFile");
-            }
-        }
-    #if !defined(_XBOX_ONE) || !defined(_TITLE)
-        else if (deviceContext)
+            ComPtr<ID3D11PixelShader> result;
+            LoadPixelShader(name, result.GetAddressOf());
+            return result;
+        });
+
+        *pixelShader = ps.Detach();
+    }
+    else
+    {
+        LoadPixelShader(name, pixelShader);
+    }
+}
+
+
+_Use_decl_annotations_
+void DGSLEffectFactory::Impl::LoadPixelShader(const wchar_t* name, ID3D11PixelShader** pixelShader)
+{
+    {
+        std::lock_guard<std::mutex> lock(mBytecodeMutex);
+
+        if (!mPackShaders.empty())
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), deviceContext, fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
+            auto it = mPackShaders.find(GetShaderPackKey(name));
+            if (it != mPackShaders.end())
             {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateWICTextureFromFile");
+                *pixelShader = ComPtr<ID3D11PixelShader>(it->second).Detach();
+                return;
             }
         }
-    #endif
-        else
+    }
+
+    wchar_t fullName[MAX_PATH] = {};
+    wcscpy_s(fullName, mPath);
+    wcscat_s(fullName, name);
+
+    WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+    if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+    {
+        // Try Current Working Directory (CWD)
+        wcscpy_s(fullName, name);
+        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
         {
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateWICTextureFromFile");
-            }
+            DebugTrace("ERROR: DGSLEffectFactory could not find shader file '%ls'\n", name);
+            throw std::exception("CreatePixelShader");
         }
+    }
+
+    size_t dataSize = 0;
+    std::unique_ptr<uint8_t[]> data;
+    HRESULT hr = BinaryReader::ReadEntireFile(fullName, data, &dataSize);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: CreatePixelShader failed (%08X) to load shader file '%ls'\n", hr, fullName);
+        throw std::exception("CreatePixelShader");
+    }
+
+    ThrowIfFailed(
+        CreatePixelShaderFromBytecode(data.get(), dataSize, pixelShader));
+
+    assert(pixelShader != nullptr && *pixelShader != nullptr);
+    _Analysis_assume_(pixelShader != nullptr && *pixelShader != nullptr);
+}
+
+
+// Two threads creating the same new bytecode at once may both create it; the first one inserted is kept.
+_Use_decl_annotations_
+HRESULT DGSLEffectFactory::Impl::CreatePixelShaderFromBytecode(const void* bytecode, size_t size, ID3D11PixelShader** pixelShader)
+{
+    if (!mSharing)
+    {
+        return mDevice->CreatePixelShader(bytecode, size, nullptr, pixelShader);
+    }
+
+    auto key = GetBytecodeKey(bytecode, size);
 
-        if (mSharing && *name && it == mTextureCache.end())
+    {
+        std::lock_guard<std::mutex> lock(mBytecodeMutex);
+
+        auto it = mBytecodeCache.find(key);
+        if (it != mBytecodeCache.end())
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            TextureCache::value_type v(name, *textureView);
-            mTextureCache.insert(v);
+            *pixelShader = ComPtr<ID3D11PixelShader>(it->second).Detach();
+            return S_OK;
         }
     }
+
+    ComPtr<ID3D11PixelShader> ps;
+    HRESULT hr = mDevice->CreatePixelShader(bytecode, size, nullptr, ps.GetAddressOf());
+    if (FAILED(hr))
+        return hr;
+
+    std::lock_guard<std::mutex> lock(mBytecodeMutex);
+
+    auto result = mBytecodeCache.emplace(key, ps);
+
+    *pixelShader = ComPtr<ID3D11PixelShader>(result.first->second).Detach();
+    return S_OK;
 }
 
 
 _Use_decl_annotations_
-void DGSLEffectFactory::Impl::CreatePixelShader(const wchar_t* name, ID3D11PixelShader** pixelShader)
+void DGSLEffectFactory::Impl::LoadShaderPack(const wchar_t* fileName)
 {
-    if (!name || !pixelShader)
+    if (!fileName)
         throw std::exception("invalid arguments");
 
-    auto it = mShaderCache.find(name);
+    wchar_t fullName[MAX_PATH] = {};
+    wcscpy_s(fullName, mPath);
+    wcscat_s(fullName, fileName);
 
-    if (mSharing && it != mShaderCache.end())
+    WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+    if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
     {
-        ID3D11PixelShader* ps = it->second.Get();
-        ps->AddRef();
-        *pixelShader = ps;
+        // Try Current Working Directory (CWD)
+        wcscpy_s(fullName, fileName);
     }
-    else
+
+    ScopedMappedView view;
+    size_t dataSize = 0;
+    HRESULT hr = BinaryReader::MapEntireFile(fullName, view, &dataSize);
+    if (FAILED(hr))
     {
-        wchar_t fullName[MAX_PATH] = {};
-        wcscpy_s(fullName, mPath);
-        wcscat_s(fullName, name);
+        DebugTrace("ERROR: LoadShaderPack failed (%08X) to load shader pack '%ls'\n", hr, fullName);
+        throw std::exception("LoadShaderPack");
+    }
 
-        WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
-        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+    auto data = static_cast<const uint8_t*>(view.get());
+
+    auto header = reinterpret_cast<const ShaderPack::header_t*>(data);
+    if (dataSize < sizeof(ShaderPack::header_t)
+        || header->magic != ShaderPack::MAGIC
+        || header->version != ShaderPack::VERSION
+        || uint64_t(header->numEntries) * sizeof(ShaderPack::entry_t) > dataSize - sizeof(ShaderPack::header_t))
+    {
+        DebugTrace("ERROR: LoadShaderPack found an invalid shader pack '%ls'\n", fullName);
+        throw std::exception("LoadShaderPack");
+    }
+
+    auto entries = reinterpret_cast<const ShaderPack::entry_t*>(data + sizeof(ShaderPack::header_t));
+
+    for (uint32_t j = 0; j < header->numEntries; ++j)
+    {
+        auto const& entry = entries[j];
+
+        if (!memchr(entry.name, 0, ShaderPack::MAX_NAME_LENGTH)
+            || !entry.size
+            || uint64_t(entry.offset) + entry.size > dataSize)
         {
-            // Try Current Working Directory (CWD)
-            wcscpy_s(fullName, name);
-            if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-            {
-                DebugTrace("ERROR: DGSLEffectFactory could not find shader file '%ls'\n", name);
-                throw std::exception("CreatePixelShader");
-            }
+            DebugTrace("ERROR: LoadShaderPack found an invalid shader pack '%ls'\n", fullName);
+            throw std::exception("LoadShaderPack");
         }
+    }
 
-        size_t dataSize = 0;
-        std::unique_ptr<uint8_t[]> data;
-        HRESULT hr = BinaryReader::ReadEntireFile(fullName, data, &dataSize);
-        if (FAILED(hr))
+    // ID3D11Device is free-threaded, so the shaders are created in parallel.
+    std::vector<ComPtr<ID3D11PixelShader>> shaders(header->numEntries);
+    std::vector<HRESULT> results(header->numEntries, S_OK);
+
+    ParallelFor(header->numEntries, [&](size_t index)
+    {
+        auto const& entry = entries[index];
+        results[index] = CreatePixelShaderFromBytecode(data + entry.offset, entry.size, shaders[index].GetAddressOf());
+    });
+
+    std::unordered_map<std::wstring, ComPtr<ID3D11PixelShader>> packShaders;
+
+    for (uint32_t j = 0; j < header->numEntries; ++j)
+    {
+        if (FAILED(results[j]))
         {
-            DebugTrace("ERROR: CreatePixelShader failed (%08X) to load shader file '%ls'\n", hr, fullName);
-            throw std::exception("CreatePixelShader");
+            DebugTrace("ERROR: LoadShaderPack failed (%08X) to create shader '%hs' from '%ls'\n", results[j], entries[j].name, fullName);
+            throw std::exception("LoadShaderPack");
         }
 
-        ThrowIfFailed(
-            mDevice->CreatePixelShader(data.get(), dataSize, nullptr, pixelShader));
+        wchar_t name[ShaderPack::MAX_NAME_LENGTH] = {};
+        if (!MultiByteToWideChar(CP_UTF8, 0, entries[j].name, -1, name, static_cast<int>(_countof(name))))
+        {
+            DebugTrace("ERROR: LoadShaderPack found an invalid shader name in '%ls'\n", fullName);
+            throw std::exception("LoadShaderPack");
+        }
+
+        packShaders[GetShaderPackKey(name)] = std::move(shaders[j]);
+    }
 
-        assert(pixelShader != nullptr && *pixelShader != nullptr);
-        _Analysis_assume_(pixelShader != nullptr && *pixelShader != nullptr);
+    std::lock_guard<std::mutex> lock(mBytecodeMutex);
 
-        if (mSharing && *name && it == mShaderCache.end())
+    for (auto& it : packShaders)
+    {
+        mPackShaders[it.first] = std::move(it.second);
+    }
+}
+
+
+namespace
+{
+    using PreloadTask = std::packaged_task<void()>;
+
+    void CALLBACK PreloadCallback(PTP_CALLBACK_INSTANCE, PVOID context) noexcept
+    {
+        std::unique_ptr<PreloadTask> task(static_cast<PreloadTask*>(context));
+        (*task)();
+    }
+}
+
+
+// The work item holds a reference to the Impl and its own copy of the names, so the caller need not wait on the
+// future. The names map to files the same way CreateDGSLEffect does, so the cache entries line up with its requests.
+_Use_decl_annotations_
+std::future<void> DGSLEffectFactory::Impl::PreloadPixelShadersAsync(const std::shared_ptr<Impl>& self, const wchar_t* const* shaders, size_t count)
+{
+    std::vector<std::wstring> names;
+
+    if (mSharing && shaders)
+    {
+        bool fallback = mDevice->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0;
+
+        for (size_t j = 0; j < count; ++j)
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            ShaderCache::value_type v(name, *pixelShader);
-            mShaderCache.insert(v);
+            if (!shaders[j] || !*shaders[j])
+                continue;
+
+            wchar_t root[MAX_PATH] = {};
+            GetShaderRoot(shaders[j], root);
+
+            if (IsBuiltInShader(root))
+                continue;
+
+            if (fallback)
+            {
+                wcscat_s(root, L".cso");
+                names.emplace_back(root);
+            }
+            else
+            {
+                names.emplace_back(shaders[j]);
+            }
         }
+
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+    }
+
+    auto task = std::make_unique<PreloadTask>([self, names]()
+    {
+        ParallelFor(names.size(), [&](size_t index)
+        {
+            try
+            {
+                ComPtr<ID3D11PixelShader> ps;
+                self->CreatePixelShader(names[index].c_str(), ps.GetAddressOf());
+            }
+            catch (...)
+            {
+                // Left uncached; CreateDGSLEffect will hit the same error and report it.
+            }
+        });
+    });
+
+    auto result = task->get_future();
+
+    if (names.empty() || !TrySubmitThreadpoolCallback(PreloadCallback, task.get(), nullptr))
+    {
+        // Nothing to load, or no thread pool: just run it here.
+        (*task)();
+        return result;
     }
+
+    // The callback now owns the task.
+    task.release();
+
+    return result;
 }
 
 
 void DGSLEffectFactory::Impl::ReleaseCache()
 {
     std::lock_guard<std::mutex> lock(mutex);
-    mEffectCache.clear();
-    mEffectCacheSkinning.clear();
-    mTextureCache.clear();
-    mShaderCache.clear();
+    mEffectCache.Clear();
+    mEffectCacheSkinning.Clear();
+    mTextureCache.Clear();
+    mShaderCache.Clear();
+
+    std::lock_guard<std::mutex> bytecodeLock(mBytecodeMutex);
+    mBytecodeCache.clear();
+    mPackShaders.clear();
 }
 
 
@@ -563,6 +870,20 @@ void DGSLEffectFactory::CreatePixelShader(const wchar_t* shader, ID3D11PixelShad
 }
 
 
+_Use_decl_annotations_
+void DGSLEffectFactory::LoadShaderPack(const wchar_t* fileName)
+{
+    pImpl->LoadShaderPack(fileName);
+}
+
+
+_Use_decl_annotations_
+std::future<void> DGSLEffectFactory::PreloadPixelShadersAsync(const wchar_t* const* shaders, size_t count)
+{
+    return pImpl->PreloadPixelShadersAsync(pImpl, shaders, count);
+}
+
+
 // Settings
 void DGSLEffectFactory::ReleaseCache()
 {
@@ -35,6 +35,8 @@ struct DebugEffectTraits
     static const int VertexShaderCount = 4;
     static const int PixelShaderCount = 4;
     static const int ShaderPermutationCount = 16;
+
+    static const BuiltInEffect Effect = BuiltInEffect_Debug;
 };
 
 
@@ -54,7 +56,8 @@ public:
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -81,16 +84,17 @@ namespace
     #include "Shaders/Compiled/DebugEffect_PSRGBBiTangents.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<DebugEffectTraits>::VertexShaderBytecode[] =
 {    
-    { DebugEffect_VSDebug,      sizeof(DebugEffect_VSDebug)     },
-    { DebugEffect_VSDebugVc,    sizeof(DebugEffect_VSDebugVc)   },
+    EFFECT_SHADER_BYTECODE(DebugEffect_VSDebug),
+    EFFECT_SHADER_BYTECODE(DebugEffect_VSDebugVc),
 
-    { DebugEffect_VSDebugBn,    sizeof(DebugEffect_VSDebugBn)   },
-    { DebugEffect_VSDebugVcBn,  sizeof(DebugEffect_VSDebugVcBn) },
+    EFFECT_SHADER_BYTECODE(DebugEffect_VSDebugBn),
+    EFFECT_SHADER_BYTECODE(DebugEffect_VSDebugVcBn),
 };
 
 
@@ -122,10 +126,10 @@ const int EffectBase<DebugEffectTraits>::VertexShaderIndices[] =
 template<>
 const ShaderBytecode EffectBase<DebugEffectTraits>::PixelShaderBytecode[] =
 {
-    { DebugEffect_PSHemiAmbient,    sizeof(DebugEffect_PSHemiAmbient)          },
-    { DebugEffect_PSRGBNormals,     sizeof(DebugEffect_PSRGBNormals)     },
-    { DebugEffect_PSRGBTangents,    sizeof(DebugEffect_PSRGBTangents)    },
-    { DebugEffect_PSRGBBiTangents,  sizeof(DebugEffect_PSRGBBiTangents) },
+    EFFECT_SHADER_BYTECODE(DebugEffect_PSHemiAmbient),
+    EFFECT_SHADER_BYTECODE(DebugEffect_PSRGBNormals),
+    EFFECT_SHADER_BYTECODE(DebugEffect_PSRGBTangents),
+    EFFECT_SHADER_BYTECODE(DebugEffect_PSRGBBiTangents),
 };
 
 
@@ -159,6 +163,14 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<DebugEffectTraits>::DeviceResources> EffectBase<DebugEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllDebugEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<DebugEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 DebugEffect::Impl::Impl(_In_ ID3D11Device* device)
   : EffectBase(device),
@@ -260,6 +272,8 @@ DebugEffect::~DebugEffect()
 // IEffect methods.
 void DebugEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"DebugEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
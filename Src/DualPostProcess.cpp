@@ -9,12 +9,14 @@
 
 #include "pch.h"
 #include "PostProcess.h"
+#include "Effects.h"
 
 #include "AlignedNew.h"
 #include "CommonStates.h"
 #include "ConstantBuffer.h"
 #include "DemandCreate.h"
 #include "DirectXHelpers.h"
+#include "GpuProfiler.h"
 #include "SharedResourcePool.h"
 
 using namespace DirectX;
@@ -203,6 +205,8 @@ void DualPostProcess::Impl::Process(_In_ ID3D11DeviceContext* deviceContext, std
     deviceContext->VSSetShader(vertexShader, nullptr, 0);
     deviceContext->PSSetShader(pixelShader, nullptr, 0);
 
+    InvalidateEffectStateCache(deviceContext);
+
     // Set constants.
     if (mDirtyFlags & Dirty_Parameters)
     {
@@ -294,6 +298,8 @@ DualPostProcess::~DualPostProcess()
 // IPostProcess methods.
 void DualPostProcess::Process(_In_ ID3D11DeviceContext* deviceContext, _In_opt_ std::function<void __cdecl()> setCustomState)
 {
+    GpuProfileScope profileScope(deviceContext, L"DualPostProcess::Process");
+
     pImpl->Process(deviceContext, setCustomState);
 }
 
@@ -34,6 +34,8 @@ struct DualTextureEffectTraits
     static const int VertexShaderCount = 4;
     static const int PixelShaderCount = 2;
     static const int ShaderPermutationCount = 4;
+
+    static const BuiltInEffect Effect = BuiltInEffect_DualTexture;
 };
 
 
@@ -55,7 +57,8 @@ public:
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -76,15 +79,16 @@ namespace
     #include "Shaders/Compiled/DualTextureEffect_PSDualTextureNoFog.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<DualTextureEffectTraits>::VertexShaderBytecode[] =
 {
-    { DualTextureEffect_VSDualTexture,        sizeof(DualTextureEffect_VSDualTexture)        },
-    { DualTextureEffect_VSDualTextureNoFog,   sizeof(DualTextureEffect_VSDualTextureNoFog)   },
-    { DualTextureEffect_VSDualTextureVc,      sizeof(DualTextureEffect_VSDualTextureVc)      },
-    { DualTextureEffect_VSDualTextureVcNoFog, sizeof(DualTextureEffect_VSDualTextureVcNoFog) },
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_VSDualTexture),
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_VSDualTextureNoFog),
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_VSDualTextureVc),
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_VSDualTextureVcNoFog),
 
 };
 
@@ -102,8 +106,8 @@ const int EffectBase<DualTextureEffectTraits>::VertexShaderIndices[] =
 template<>
 const ShaderBytecode EffectBase<DualTextureEffectTraits>::PixelShaderBytecode[] =
 {
-    { DualTextureEffect_PSDualTexture,        sizeof(DualTextureEffect_PSDualTexture)        },
-    { DualTextureEffect_PSDualTextureNoFog,   sizeof(DualTextureEffect_PSDualTextureNoFog)   },
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_PSDualTexture),
+    EFFECT_SHADER_BYTECODE(DualTextureEffect_PSDualTextureNoFog),
 
 };
 
@@ -123,6 +127,14 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<DualTextureEffectTraits>::DeviceResources> EffectBase<DualTextureEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllDualTextureEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<DualTextureEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 DualTextureEffect::Impl::Impl(_In_ ID3D11Device* device)
   : EffectBase(device),
@@ -210,6 +222,8 @@ DualTextureEffect::~DualTextureEffect()
 // IEffect methods.
 void DualTextureEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"DualTextureEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
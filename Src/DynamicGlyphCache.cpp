@@ -0,0 +1,359 @@
+//--------------------------------------------------------------------------------------
+// File: DynamicGlyphCache.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "DynamicGlyphCache.h"
+
+#include "DirectXHelpers.h"
+#include "MemoryTracker.h"
+#include "PlatformHelpers.h"
+
+#include <cmath>
+#include <iterator>
+
+#pragma comment(lib,"dwrite.lib")
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+_Use_decl_annotations_
+DynamicGlyphCache::DynamicGlyphCache(ID3D11Device* device, IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize)
+    : mFontFace(fontFace),
+    mFontSize(fontSize),
+    mDesignScale(0),
+    mAscent(0),
+    mLineSpacing(0),
+    mCellSize(0),
+    mCellsPerRow(0),
+    mFrame(1),
+    mExit(false)
+{
+    if (!device || !fontFace)
+        throw std::exception("Device and font face cannot be null");
+
+    if (!(fontSize > 0.f))
+        throw std::invalid_argument("Font size must be greater than zero");
+
+    if (!atlasSize || atlasSize > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+        throw std::invalid_argument("Invalid atlas size");
+
+    // The shared factory is free-threaded, so the worker can rasterize with it too.
+    ThrowIfFailed(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), reinterpret_cast<IUnknown**>(mFactory.GetAddressOf())));
+
+    DWRITE_FONT_METRICS metrics;
+    fontFace->GetMetrics(&metrics);
+
+    mDesignScale = fontSize / float(metrics.designUnitsPerEm);
+    mAscent = std::ceil(float(metrics.ascent) * mDesignScale);
+    mLineSpacing = std::ceil(float(metrics.ascent + metrics.descent + metrics.lineGap) * mDesignScale);
+
+    // Cells fit anything up to a line high or an em wide, plus a transparent border for filtering. Larger glyphs are
+    // clipped.
+    mCellSize = static_cast<int>(std::ceil(std::max(mLineSpacing, fontSize))) + 2;
+    mCellsPerRow = static_cast<int>(atlasSize) / mCellSize;
+
+    if (!mCellsPerRow)
+        throw std::invalid_argument("Atlas size too small for the font size");
+
+    mCells.resize(size_t(mCellsPerRow) * size_t(mCellsPerRow));
+
+    for (size_t j = 0; j < mCells.size(); ++j)
+    {
+        mCells[j].owner = nullptr;
+        mCells[j].lastUsed = 0;
+        mCells[j].position = mLru.insert(mLru.end(), static_cast<int>(j));
+    }
+
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, atlasSize, atlasSize, 1, 1, D3D11_BIND_SHADER_RESOURCE);
+
+    ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, mAtlas.GetAddressOf()));
+    ThrowIfFailed(device->CreateShaderResourceView(mAtlas.Get(), nullptr, mTexture.GetAddressOf()));
+
+    SetDebugObjectName(mAtlas.Get(), "DirectXTK:SpriteFont");
+    SetDebugObjectName(mTexture.Get(), "DirectXTK:SpriteFont");
+
+    MemoryTracker::TrackResource(mAtlas.Get(), MemoryCategory_Texture, L"SpriteFont");
+
+    mWorker = std::thread([this]() noexcept { WorkerMain(); });
+}
+
+
+DynamicGlyphCache::~DynamicGlyphCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+    }
+
+    mCondition.notify_all();
+    mWorker.join();
+}
+
+
+SpriteFont::Glyph const* DynamicGlyphCache::FindGlyph(wchar_t character)
+{
+    auto it = mEntries.find(character);
+
+    if (it == mEntries.end())
+    {
+        it = mEntries.emplace(character, CreateEntry(character)).first;
+    }
+
+    return it->second ? &it->second->glyph : nullptr;
+}
+
+
+_Use_decl_annotations_
+bool DynamicGlyphCache::Touch(SpriteFont::Glyph const* glyph)
+{
+    auto it = mEntries.find(static_cast<wchar_t>(glyph->Character));
+
+    if (it == mEntries.end() || !it->second)
+        return false;
+
+    auto entry = it->second.get();
+
+    if (entry->cell >= 0)
+    {
+        auto& cell = mCells[size_t(entry->cell)];
+
+        cell.lastUsed = mFrame;
+        mLru.splice(mLru.end(), mLru, cell.position);
+
+        return true;
+    }
+
+    if (!entry->requested && entry->bounds.right > entry->bounds.left && entry->bounds.bottom > entry->bounds.top)
+    {
+        entry->requested = true;
+
+        Job job = {};
+        job.entry = entry;
+        job.glyphIndex = entry->glyphIndex;
+        job.bounds = entry->bounds;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPending.push_back(std::move(job));
+        }
+
+        mCondition.notify_one();
+    }
+
+    return false;
+}
+
+
+// Uploads finished glyphs, as long as there are cells not drawn from since the last Update to put them in.
+_Use_decl_annotations_
+void DynamicGlyphCache::Update(ID3D11DeviceContext* deviceContext)
+{
+    std::deque<Job> completed;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        completed.swap(mCompleted);
+    }
+
+    while (!completed.empty())
+    {
+        auto& job = completed.front();
+        auto entry = job.entry;
+
+        if (!job.pixels.empty())
+        {
+            int cell = AllocateCell();
+
+            if (cell < 0)
+                break;
+
+            auto width = job.bounds.right - job.bounds.left;
+            auto height = job.bounds.bottom - job.bounds.top;
+
+            auto x = static_cast<LONG>((cell % mCellsPerRow) * mCellSize);
+            auto y = static_cast<LONG>((cell / mCellsPerRow) * mCellSize);
+
+            D3D11_BOX box = { UINT(x), UINT(y), 0, UINT(x + width + 2), UINT(y + height + 2), 1 };
+
+            deviceContext->UpdateSubresource(mAtlas.Get(), 0, &box, job.pixels.data(), UINT(width + 2) * sizeof(uint32_t), 0);
+
+            entry->glyph.Subrect = { x + 1, y + 1, x + 1 + width, y + 1 + height };
+            entry->cell = cell;
+
+            auto& target = mCells[size_t(cell)];
+
+            target.owner = entry;
+            target.lastUsed = mFrame;
+            mLru.splice(mLru.end(), mLru, target.position);
+        }
+
+        // Failed glyphs are retried the next time they are drawn.
+        entry->requested = false;
+
+        completed.pop_front();
+    }
+
+    if (!completed.empty())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCompleted.insert(mCompleted.begin(), std::make_move_iterator(completed.begin()), std::make_move_iterator(completed.end()));
+    }
+
+    ++mFrame;
+}
+
+
+// Looks up the metrics for a character, returning nullptr if the font does not have it.
+std::unique_ptr<DynamicGlyphCache::Entry> DynamicGlyphCache::CreateEntry(wchar_t character)
+{
+    UINT32 codePoint = character;
+    UINT16 glyphIndex = 0;
+
+    ThrowIfFailed(mFontFace->GetGlyphIndices(&codePoint, 1, &glyphIndex));
+
+    if (!glyphIndex)
+        return nullptr;
+
+    DWRITE_GLYPH_METRICS metrics;
+    ThrowIfFailed(mFontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &metrics, FALSE));
+
+    RECT bounds;
+    ThrowIfFailed(CreateAnalysis(glyphIndex)->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, &bounds));
+
+    auto maxSize = static_cast<LONG>(mCellSize - 2);
+
+    bounds.right = std::min(bounds.right, bounds.left + maxSize);
+    bounds.bottom = std::min(bounds.bottom, bounds.top + maxSize);
+
+    auto width = std::max(bounds.right - bounds.left, 0L);
+    auto height = std::max(bounds.bottom - bounds.top, 0L);
+
+    auto entry = std::make_unique<Entry>();
+
+    entry->glyph.Character = character;
+    entry->glyph.Subrect = { 0, 0, width, height };
+    entry->glyph.XOffset = float(bounds.left);
+    entry->glyph.YOffset = mAscent + float(bounds.top);
+    entry->glyph.XAdvance = float(metrics.advanceWidth) * mDesignScale - float(bounds.left) - float(width);
+    entry->bounds = bounds;
+    entry->glyphIndex = glyphIndex;
+    entry->cell = -1;
+    entry->requested = false;
+
+    return entry;
+}
+
+
+ComPtr<IDWriteGlyphRunAnalysis> DynamicGlyphCache::CreateAnalysis(UINT16 glyphIndex) const
+{
+    FLOAT advance = 0;
+    DWRITE_GLYPH_OFFSET offset = {};
+
+    DWRITE_GLYPH_RUN run = {};
+    run.fontFace = mFontFace.Get();
+    run.fontEmSize = mFontSize;
+    run.glyphCount = 1;
+    run.glyphIndices = &glyphIndex;
+    run.glyphAdvances = &advance;
+    run.glyphOffsets = &offset;
+
+    ComPtr<IDWriteGlyphRunAnalysis> analysis;
+
+    ThrowIfFailed(mFactory->CreateGlyphRunAnalysis(&run, 1.f, nullptr,
+                                                   DWRITE_RENDERING_MODE_NATURAL, DWRITE_MEASURING_MODE_NATURAL,
+                                                   0.f, 0.f, analysis.GetAddressOf()));
+
+    return analysis;
+}
+
+
+// Takes the least recently drawn cell, unless it has been drawn from since the last Update.
+int DynamicGlyphCache::AllocateCell()
+{
+    int cell = mLru.front();
+    auto& victim = mCells[size_t(cell)];
+
+    if (victim.lastUsed >= mFrame)
+        return -1;
+
+    if (victim.owner)
+    {
+        auto& subrect = victim.owner->glyph.Subrect;
+
+        subrect = { 0, 0, subrect.right - subrect.left, subrect.bottom - subrect.top };
+
+        victim.owner->cell = -1;
+        victim.owner = nullptr;
+    }
+
+    return cell;
+}
+
+
+void DynamicGlyphCache::WorkerMain() noexcept
+{
+    for (;;)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() noexcept { return mExit || !mPending.empty(); });
+
+            if (mExit)
+                return;
+
+            job = std::move(mPending.front());
+            mPending.pop_front();
+        }
+
+        try
+        {
+            Rasterize(job);
+        }
+        catch (...)
+        {
+            DebugTrace("ERROR: SpriteFont failed to rasterize glyph %u\n", job.glyphIndex);
+            job.pixels.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCompleted.push_back(std::move(job));
+    }
+}
+
+
+// Rasterizes a glyph with ClearType-style antialiasing, averaging the subpixels into premultiplied white.
+void DynamicGlyphCache::Rasterize(Job& job) const
+{
+    auto width = static_cast<size_t>(job.bounds.right - job.bounds.left);
+    auto height = static_cast<size_t>(job.bounds.bottom - job.bounds.top);
+
+    std::vector<uint8_t> coverage(width * height * 3);
+
+    ThrowIfFailed(CreateAnalysis(job.glyphIndex)->CreateAlphaTexture(DWRITE_TEXTURE_CLEARTYPE_3x1, &job.bounds, coverage.data(), static_cast<UINT32>(coverage.size())));
+
+    size_t pitch = width + 2;
+
+    job.pixels.assign(pitch * (height + 2), 0);
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        auto source = &coverage[y * width * 3];
+        auto dest = &job.pixels[(y + 1) * pitch + 1];
+
+        for (size_t x = 0; x < width; ++x, source += 3)
+        {
+            uint32_t value = (uint32_t(source[0]) + uint32_t(source[1]) + uint32_t(source[2])) / 3;
+
+            dest[x] = value * 0x01010101u;
+        }
+    }
+}
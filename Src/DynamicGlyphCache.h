@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------------
+// File: DynamicGlyphCache.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dwrite.h>
+
+#include "SpriteFont.h"
+
+
+namespace DirectX
+{
+    // Glyph source for dynamic SpriteFonts. Metrics come from DirectWrite as soon as a character is first looked up,
+    // so layout never waits, while the bitmaps are rasterized on a worker thread and copied into an atlas of fixed
+    // size cells by Update. Cells are reused least recently drawn first, but never while drawn since the last Update,
+    // so sprites already queued keep their pixels.
+    //
+    // Apart from the worker, which only sees its own queues, everything runs on the thread using the SpriteFont.
+    class DynamicGlyphCache
+    {
+    public:
+        DynamicGlyphCache(_In_ ID3D11Device* device, _In_ IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize);
+
+        DynamicGlyphCache(DynamicGlyphCache const&) = delete;
+        DynamicGlyphCache& operator= (DynamicGlyphCache const&) = delete;
+
+        ~DynamicGlyphCache();
+
+        // Returns nullptr if the font has no glyph for the character. The glyph stays valid for the life of the cache,
+        // though its Subrect moves around the atlas as it is evicted and reloaded.
+        SpriteFont::Glyph const* FindGlyph(wchar_t character);
+
+        // Marks a glyph as drawn this frame, queuing it for rasterization if it is not in the atlas.
+        // Returns true if it can be drawn now.
+        bool Touch(_In_ SpriteFont::Glyph const* glyph);
+
+        // Uploads the glyphs the worker has finished since the last call.
+        void Update(_In_ ID3D11DeviceContext* deviceContext);
+
+        ID3D11ShaderResourceView* GetTexture() const noexcept { return mTexture.Get(); }
+
+        float GetLineSpacing() const noexcept { return mLineSpacing; }
+
+    private:
+        struct Entry
+        {
+            SpriteFont::Glyph glyph;        // Subrect left and top are only meaningful while resident
+            RECT bounds;                    // Rasterized area relative to the pen position on the baseline
+            UINT16 glyphIndex;
+            int cell;                       // -1 when not in the atlas
+            bool requested;                 // Queued for or being rasterized by the worker
+        };
+
+        struct Cell
+        {
+            Entry* owner;
+            uint64_t lastUsed;
+            std::list<int>::iterator position;
+        };
+
+        // Work handed to and back from the worker. Pixels hold the glyph with a one texel transparent border.
+        struct Job
+        {
+            Entry* entry;                   // Only dereferenced by Update
+            UINT16 glyphIndex;
+            RECT bounds;
+            std::vector<uint32_t> pixels;   // Left empty if rasterization failed
+        };
+
+        std::unique_ptr<Entry> CreateEntry(wchar_t character);
+        Microsoft::WRL::ComPtr<IDWriteGlyphRunAnalysis> CreateAnalysis(UINT16 glyphIndex) const;
+        int AllocateCell();
+
+        void WorkerMain() noexcept;
+        void Rasterize(Job& job) const;
+
+        Microsoft::WRL::ComPtr<IDWriteFontFace> mFontFace;
+        Microsoft::WRL::ComPtr<IDWriteFactory> mFactory;
+
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> mAtlas;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mTexture;
+
+        float mFontSize;
+        float mDesignScale;
+        float mAscent;
+        float mLineSpacing;
+
+        int mCellSize;
+        int mCellsPerRow;
+
+        uint64_t mFrame;
+
+        // Entries are never erased, so pointers to them stay valid. Characters the font lacks map to nullptr.
+        std::unordered_map<wchar_t, std::unique_ptr<Entry>> mEntries;
+
+        // Cells in least recently used order.
+        std::vector<Cell> mCells;
+        std::list<int> mLru;
+
+        std::deque<Job> mPending;
+        std::deque<Job> mCompleted;
+        bool mExit;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::thread mWorker;
+    };
+}
@@ -10,11 +10,401 @@
 #include "pch.h"
 #include "EffectCommon.h"
 #include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "GraphicsMemory.h"
+
+#if defined(DIRECTX_TOOLKIT_SHADER_PACK)
+#include "BinaryReader.h"
+#include "ShaderPack.h"
+#endif
+
+#include <atomic>
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
 
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+namespace
+{
+    std::atomic<bool> s_effectConstantSuballocation(false);
+
+    ID3D11DeviceContext1* GetDeviceContext1(_In_ ID3D11DeviceContext* deviceContext) noexcept;
+}
+
+
+void DirectX::SetEffectConstantSuballocation(bool enable) noexcept
+{
+    s_effectConstantSuballocation = enable;
+}
+
+
+bool DirectX::GetEffectConstantSuballocation() noexcept
+{
+    return s_effectConstantSuballocation;
+}
+
+
+_Use_decl_annotations_
+bool DirectX::SetSuballocatedConstants(ID3D11DeviceContext* deviceContext, void const* data, size_t size)
+{
+    if (!s_effectConstantSuballocation || !GraphicsMemory::IsCreated())
+        return false;
+
+    auto& graphicsMemory = GraphicsMemory::Get();
+
+    if (!graphicsMemory.IsConstantUploadSupported())
+        return false;
+
+    auto deviceContext1 = GetDeviceContext1(deviceContext);
+    if (!deviceContext1)
+        return false;
+
+    ID3D11Buffer* buffer;
+    UINT offset;
+
+    void* ptr = graphicsMemory.MapUpload(deviceContext, D3D11_BIND_CONSTANT_BUFFER, size, 256, &buffer, &offset);
+
+    memcpy(ptr, data, size);
+
+    graphicsMemory.UnmapUpload(deviceContext, D3D11_BIND_CONSTANT_BUFFER);
+
+    // Offsets and sizes are counted in 16-byte shader constants, and must be multiples of 16 constants.
+    UINT firstConstant = offset / 16;
+    UINT numConstants = static_cast<UINT>(AlignUp(size, size_t(256)) / 16);
+
+    deviceContext1->VSSetConstantBuffers1(0, 1, &buffer, &firstConstant, &numConstants);
+    deviceContext1->PSSetConstantBuffers1(0, 1, &buffer, &firstConstant, &numConstants);
+
+    return true;
+}
+#endif
+
+
+namespace
+{
+    std::atomic<bool> s_effectStateCaching(false);
+
+    // Bumped to invalidate every context's tracked state at once. Trackers compare it on each lookup.
+    std::atomic<uint32_t> s_effectStateGeneration(0);
+
+    // {5C0B7E2D-3A91-4F6E-9D48-71B2C6E0A5F3}
+    const GUID s_effectStateGuid = { 0x5c0b7e2d, 0x3a91, 0x4f6e, { 0x9d, 0x48, 0x71, 0xb2, 0xc6, 0xe0, 0xa5, 0xf3 } };
+
+
+    // Attached to each tracked context as private data, so it is found from the context without any global
+    // lock, and is destroyed along with the context.
+    class EffectStateTracker : public IUnknown
+    {
+    public:
+        EffectStateTracker() noexcept
+            : state{},
+            generation(s_effectStateGeneration),
+            deviceContext1(nullptr),
+            deviceContext1Queried(false),
+            mRefCount(1)
+        {
+        }
+
+        EffectStateTracker(EffectStateTracker const&) = delete;
+        EffectStateTracker& operator= (EffectStateTracker const&) = delete;
+
+        virtual ~EffectStateTracker() = default;
+
+        STDMETHOD(QueryInterface)(REFIID riid, _COM_Outptr_ void** ppvObject) override
+        {
+            if (!ppvObject)
+                return E_POINTER;
+
+            if (riid == __uuidof(IUnknown))
+            {
+                *ppvObject = static_cast<IUnknown*>(this);
+                AddRef();
+                return S_OK;
+            }
+
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        STDMETHOD_(ULONG, AddRef)() override
+        {
+            return static_cast<ULONG>(InterlockedIncrement(&mRefCount));
+        }
+
+        STDMETHOD_(ULONG, Release)() override
+        {
+            auto count = static_cast<ULONG>(InterlockedDecrement(&mRefCount));
+            if (!count)
+            {
+                delete this;
+            }
+            return count;
+        }
+
+        EffectAppliedState state;
+        uint32_t generation;
+
+        // Not a counted reference, which would keep the context that owns this tracker alive forever.
+        ID3D11DeviceContext1* deviceContext1;
+        bool deviceContext1Queried;
+
+    private:
+        long mRefCount;
+    };
+
+
+    // Finds the tracker attached to a context, optionally attaching a new one. The context holds the only
+    // lasting reference, so the pointer is valid for as long as the context is.
+    EffectStateTracker* GetEffectStateTracker(_In_ ID3D11DeviceContext* deviceContext, bool create) noexcept
+    {
+        IUnknown* unknown = nullptr;
+        UINT size = sizeof(unknown);
+
+        if (SUCCEEDED(deviceContext->GetPrivateData(s_effectStateGuid, &size, &unknown)) && unknown)
+        {
+            unknown->Release();
+            return static_cast<EffectStateTracker*>(unknown);
+        }
+
+        if (!create)
+            return nullptr;
+
+        auto tracker = new (std::nothrow) EffectStateTracker();
+        if (!tracker)
+            return nullptr;
+
+        HRESULT hr = deviceContext->SetPrivateDataInterface(s_effectStateGuid, tracker);
+
+        tracker->Release();
+
+        return SUCCEEDED(hr) ? tracker : nullptr;
+    }
+}
+
+
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+namespace
+{
+    // Looks up the context's ID3D11DeviceContext1 once, rather than on every Apply.
+    ID3D11DeviceContext1* GetDeviceContext1(_In_ ID3D11DeviceContext* deviceContext) noexcept
+    {
+        auto tracker = GetEffectStateTracker(deviceContext, true);
+        if (!tracker)
+            return nullptr;
+
+        if (!tracker->deviceContext1Queried)
+        {
+            ComPtr<ID3D11DeviceContext1> deviceContext1;
+            if (SUCCEEDED(deviceContext->QueryInterface(IID_PPV_ARGS(deviceContext1.GetAddressOf()))))
+            {
+                tracker->deviceContext1 = deviceContext1.Get();
+            }
+
+            tracker->deviceContext1Queried = true;
+        }
+
+        return tracker->deviceContext1;
+    }
+}
+#endif
+
+
+void DirectX::SetEffectStateCaching(bool enable) noexcept
+{
+    s_effectStateCaching = enable;
+
+    InvalidateEffectStateCache(nullptr);
+}
+
+
+bool DirectX::GetEffectStateCaching() noexcept
+{
+    return s_effectStateCaching;
+}
+
+
+_Use_decl_annotations_
+void DirectX::InvalidateEffectStateCache(ID3D11DeviceContext* deviceContext) noexcept
+{
+    if (!deviceContext)
+    {
+        ++s_effectStateGeneration;
+        return;
+    }
+
+    auto tracker = GetEffectStateTracker(deviceContext, false);
+    if (tracker)
+    {
+        tracker->state = {};
+    }
+}
+
+
+_Use_decl_annotations_
+EffectAppliedState* DirectX::GetEffectAppliedState(ID3D11DeviceContext* deviceContext) noexcept
+{
+    if (!s_effectStateCaching)
+        return nullptr;
+
+    auto tracker = GetEffectStateTracker(deviceContext, true);
+    if (!tracker)
+        return nullptr;
+
+    uint32_t generation = s_effectStateGeneration;
+    if (tracker->generation != generation)
+    {
+        tracker->state = {};
+        tracker->generation = generation;
+    }
+
+    return &tracker->state;
+}
+
+
+namespace
+{
+    std::atomic<bool> s_effectStatistics(false);
+
+    // Counters are relaxed atomics: they are only ever summed, and nothing else is ordered against them.
+    struct EffectCounters
+    {
+        std::atomic<uint64_t> counters[static_cast<int>(EffectCounter::Count)];
+        std::atomic<uint64_t> permutations[EffectStatistics::MaxPermutations];
+    };
+
+    EffectCounters s_effectCounters[BuiltInEffect_Count];
+
+    const char* const s_effectNames[BuiltInEffect_Count] =
+    {
+        "AlphaTestEffect",
+        "BasicEffect",
+        "DebugEffect",
+        "DGSLEffect",
+        "DualTextureEffect",
+        "EnvironmentMapEffect",
+        "NormalMapEffect",
+        "PBREffect",
+        "SkinnedEffect",
+    };
+}
+
+
+void DirectX::SetEffectStatisticsCollection(bool enable) noexcept
+{
+    s_effectStatistics = enable;
+}
+
+
+bool DirectX::GetEffectStatisticsCollection() noexcept
+{
+    return s_effectStatistics;
+}
+
+
+_Use_decl_annotations_
+void DirectX::GetEffectStatistics(BuiltInEffect effect, EffectStatistics* stats) noexcept
+{
+    assert(stats != nullptr);
+
+    *stats = {};
+
+    if (effect >= BuiltInEffect_Count)
+        return;
+
+    auto const& source = s_effectCounters[effect];
+
+    auto get = [&](EffectCounter counter)
+    {
+        return source.counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+    };
+
+    stats->vertexShadersCreated = get(EffectCounter::VertexShaderCreated);
+    stats->pixelShadersCreated = get(EffectCounter::PixelShaderCreated);
+    stats->applyCount = get(EffectCounter::Apply);
+    stats->constantBufferUpdates = get(EffectCounter::ConstantBufferUpdate);
+    stats->redundantShaderSkips = get(EffectCounter::RedundantShaderSkip);
+    stats->redundantConstantBufferSkips = get(EffectCounter::RedundantConstantBufferSkip);
+
+    for (size_t j = 0; j < EffectStatistics::MaxPermutations; ++j)
+    {
+        stats->permutationApplyCounts[j] = source.permutations[j].load(std::memory_order_relaxed);
+    }
+}
+
+
+void DirectX::ResetEffectStatistics() noexcept
+{
+    for (auto& effect : s_effectCounters)
+    {
+        for (auto& counter : effect.counters)
+            counter.store(0, std::memory_order_relaxed);
+
+        for (auto& counter : effect.permutations)
+            counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+void DirectX::DumpEffectStatistics() noexcept
+{
+    for (unsigned int effect = 0; effect < BuiltInEffect_Count; ++effect)
+    {
+        EffectStatistics stats;
+        GetEffectStatistics(static_cast<BuiltInEffect>(effect), &stats);
+
+        if (!stats.applyCount && !stats.vertexShadersCreated && !stats.pixelShadersCreated)
+            continue;
+
+        DebugTrace("%s: %llu applies, %llu VS created, %llu PS created, %llu constant buffer updates, %llu redundant shader skips, %llu redundant constant buffer skips\n",
+            s_effectNames[effect],
+            stats.applyCount,
+            stats.vertexShadersCreated,
+            stats.pixelShadersCreated,
+            stats.constantBufferUpdates,
+            stats.redundantShaderSkips,
+            stats.redundantConstantBufferSkips);
+
+        for (size_t j = 0; j < EffectStatistics::MaxPermutations; ++j)
+        {
+            if (stats.permutationApplyCounts[j])
+            {
+                DebugTrace("    permutation %zu: %llu applies\n", j, stats.permutationApplyCounts[j]);
+            }
+        }
+    }
+}
+
+
+void DirectX::CountEffectStatistic(BuiltInEffect effect, EffectCounter counter) noexcept
+{
+    if (!s_effectStatistics.load(std::memory_order_relaxed))
+        return;
+
+    assert(effect < BuiltInEffect_Count);
+
+    s_effectCounters[effect].counters[static_cast<int>(counter)].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void DirectX::CountEffectApply(BuiltInEffect effect, int permutation) noexcept
+{
+    if (!s_effectStatistics.load(std::memory_order_relaxed))
+        return;
+
+    assert(effect < BuiltInEffect_Count);
+
+    auto& counters = s_effectCounters[effect];
+
+    counters.counters[static_cast<int>(EffectCounter::Apply)].fetch_add(1, std::memory_order_relaxed);
+
+    if (permutation >= 0 && static_cast<size_t>(permutation) < EffectStatistics::MaxPermutations)
+    {
+        counters.permutations[permutation].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
 // IEffectMatrices default method
 void XM_CALLCONV IEffectMatrices::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
@@ -384,16 +774,127 @@ void EffectLights::EnableDefaultLighting(_In_ IEffectLights* effect)
 }
 
 
+#if defined(DIRECTX_TOOLKIT_SHADER_PACK)
+namespace
+{
+    // The mapped shader pack. It is only set once, by LoadEffectShaderPack, and never unmapped, so the bytecode
+    // handed out stays valid for the life of the process.
+    ScopedMappedView s_shaderPackView;
+    std::atomic<ShaderPack::entry_t const*> s_shaderPackEntries(nullptr);
+    uint32_t s_shaderPackCount = 0;
+    std::mutex s_shaderPackMutex;
+}
+
+
+_Use_decl_annotations_
+HRESULT DirectX::LoadEffectShaderPack(const wchar_t* fileName) noexcept
+{
+    if (!fileName)
+        return E_INVALIDARG;
+
+    std::lock_guard<std::mutex> lock(s_shaderPackMutex);
+
+    if (s_shaderPackEntries)
+        return HRESULT_FROM_WIN32(ERROR_ALREADY_INITIALIZED);
+
+    ScopedMappedView view;
+    size_t dataSize = 0;
+    HRESULT hr = BinaryReader::MapEntireFile(fileName, view, &dataSize);
+    if (FAILED(hr))
+        return hr;
+
+    auto data = static_cast<uint8_t const*>(view.get());
+
+    if (dataSize < sizeof(ShaderPack::header_t))
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    auto header = reinterpret_cast<ShaderPack::header_t const*>(data);
+    if (header->magic != ShaderPack::MAGIC || header->version != ShaderPack::VERSION)
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    uint64_t directorySize = uint64_t(header->numEntries) * sizeof(ShaderPack::entry_t);
+    if (directorySize > dataSize - sizeof(ShaderPack::header_t))
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    // Validate the directory once here so lookups can trust it.
+    auto entries = reinterpret_cast<ShaderPack::entry_t const*>(data + sizeof(ShaderPack::header_t));
+
+    for (uint32_t j = 0; j < header->numEntries; ++j)
+    {
+        auto const& entry = entries[j];
+
+        if (!memchr(entry.name, 0, ShaderPack::MAX_NAME_LENGTH))
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+        if (!entry.size || uint64_t(entry.offset) + entry.size > dataSize)
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+        if (j > 0 && strcmp(entries[j - 1].name, entry.name) >= 0)
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    }
+
+    s_shaderPackView = std::move(view);
+    s_shaderPackCount = header->numEntries;
+    s_shaderPackEntries = entries;
+
+    return S_OK;
+}
+
+
+_Use_decl_annotations_
+void DirectX::GetShaderBytecode(ShaderBytecode const& bytecode, void const** pShaderByteCode, size_t* pByteCodeLength) noexcept
+{
+    *pShaderByteCode = nullptr;
+    *pByteCodeLength = 0;
+
+    auto entries = s_shaderPackEntries.load();
+    if (!entries)
+        return;
+
+    auto end = entries + s_shaderPackCount;
+
+    auto it = std::lower_bound(entries, end, bytecode.name, [](ShaderPack::entry_t const& entry, char const* name) noexcept
+    {
+        return strcmp(entry.name, name) < 0;
+    });
+
+    if (it != end && !strcmp(it->name, bytecode.name))
+    {
+        *pShaderByteCode = static_cast<uint8_t const*>(s_shaderPackView.get()) + it->offset;
+        *pByteCodeLength = it->size;
+    }
+}
+#else
+_Use_decl_annotations_
+void DirectX::GetShaderBytecode(ShaderBytecode const& bytecode, void const** pShaderByteCode, size_t* pByteCodeLength) noexcept
+{
+    *pShaderByteCode = bytecode.code;
+    *pByteCodeLength = bytecode.length;
+}
+#endif
+
+
 // Gets or lazily creates the specified vertex shader permutation.
 ID3D11VertexShader* EffectDeviceResources::DemandCreateVertexShader(_Inout_ ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode)
 {
     return DemandCreate(vertexShader, mMutex, [&](ID3D11VertexShader** pResult) -> HRESULT
     {
-        HRESULT hr = mDevice->CreateVertexShader(bytecode.code, bytecode.length, nullptr, pResult);
+        void const* code;
+        size_t length;
+        GetShaderBytecode(bytecode, &code, &length);
+
+        if (!code)
+            throw std::exception("Shader not found in the effect shader pack; call LoadEffectShaderPack first");
+
+        HRESULT hr = mDevice->CreateVertexShader(code, length, nullptr, pResult);
 
         if (SUCCEEDED(hr))
+        {
             SetDebugObjectName(*pResult, "DirectXTK:Effect");
 
+            CountEffectStatistic(mEffect, EffectCounter::VertexShaderCreated);
+        }
+
         return hr;
     });
 }
@@ -404,16 +905,84 @@ ID3D11PixelShader* EffectDeviceResources::DemandCreatePixelShader(_Inout_ ComPtr
 {
     return DemandCreate(pixelShader, mMutex, [&](ID3D11PixelShader** pResult) -> HRESULT
     {
-        HRESULT hr = mDevice->CreatePixelShader(bytecode.code, bytecode.length, nullptr, pResult);
+        void const* code;
+        size_t length;
+        GetShaderBytecode(bytecode, &code, &length);
+
+        if (!code)
+            throw std::exception("Shader not found in the effect shader pack; call LoadEffectShaderPack first");
+
+        HRESULT hr = mDevice->CreatePixelShader(code, length, nullptr, pResult);
 
         if (SUCCEEDED(hr))
+        {
             SetDebugObjectName(*pResult, "DirectXTK:Effect");
 
+            CountEffectStatistic(mEffect, EffectCounter::PixelShaderCreated);
+        }
+
         return hr;
     });
 }
 
 
+// Creates the specified vertex shader permutation ahead of first use.
+bool EffectDeviceResources::WarmUpVertexShader(_Inout_ ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (vertexShader)
+        return true;
+
+    void const* code;
+    size_t length;
+    GetShaderBytecode(bytecode, &code, &length);
+
+    ID3D11VertexShader* result = nullptr;
+    if (!code || FAILED(mDevice->CreateVertexShader(code, length, nullptr, &result)))
+        return false;
+
+    SetDebugObjectName(result, "DirectXTK:Effect");
+
+    CountEffectStatistic(mEffect, EffectCounter::VertexShaderCreated);
+
+    // Publish the shader only once it is complete, matching the lock-free read in DemandCreate.
+    MemoryBarrier();
+
+    vertexShader.Attach(result);
+
+    return true;
+}
+
+
+// Creates the specified pixel shader permutation ahead of first use.
+bool EffectDeviceResources::WarmUpPixelShader(_Inout_ ComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (pixelShader)
+        return true;
+
+    void const* code;
+    size_t length;
+    GetShaderBytecode(bytecode, &code, &length);
+
+    ID3D11PixelShader* result = nullptr;
+    if (!code || FAILED(mDevice->CreatePixelShader(code, length, nullptr, &result)))
+        return false;
+
+    SetDebugObjectName(result, "DirectXTK:Effect");
+
+    CountEffectStatistic(mEffect, EffectCounter::PixelShaderCreated);
+
+    MemoryBarrier();
+
+    pixelShader.Attach(result);
+
+    return true;
+}
+
+
 // Gets or lazily creates the default texture
 ID3D11ShaderResourceView* EffectDeviceResources::GetDefaultTexture()
 {
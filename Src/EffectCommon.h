@@ -16,6 +16,7 @@
 #include "ConstantBuffer.h"
 #include "SharedResourcePool.h"
 #include "AlignedNew.h"
+#include "GpuProfiler.h"
 
 
 // BasicEffect, SkinnedEffect, et al, have many things in common, but also significant
@@ -109,35 +110,107 @@ namespace DirectX
     };
 
 
-    // Points to a precompiled vertex or pixel shader program.
+    // Points to a precompiled vertex or pixel shader program. Built with DIRECTX_TOOLKIT_SHADER_PACK, only the name
+    // is kept, and the bytecode is found in the shader pack when the shader is first needed.
     struct ShaderBytecode
     {
+    #if defined(DIRECTX_TOOLKIT_SHADER_PACK)
+        char const* name;
+    #else
         void const* code;
         size_t length;
+    #endif
     };
 
+    #if defined(DIRECTX_TOOLKIT_SHADER_PACK)
+    #define EFFECT_SHADER_BYTECODE(shader) { #shader }
+    #else
+    #define EFFECT_SHADER_BYTECODE(shader) { shader, sizeof(shader) }
+    #endif
+
+    // Returns null if the shader is not in the loaded shader pack.
+    void GetShaderBytecode(ShaderBytecode const& bytecode, _Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength) noexcept;
+
+
+    // Counters behind GetEffectStatistics. These do nothing unless statistics collection is on.
+    enum class EffectCounter
+    {
+        VertexShaderCreated,
+        PixelShaderCreated,
+        Apply,
+        ConstantBufferUpdate,
+        RedundantShaderSkip,
+        RedundantConstantBufferSkip,
+
+        Count
+    };
+
+    void CountEffectStatistic(BuiltInEffect effect, EffectCounter counter) noexcept;
+    void CountEffectApply(BuiltInEffect effect, int permutation) noexcept;
+
 
     // Factory for lazily instantiating shaders. BasicEffect supports many different
     // shader permutations, so we only bother creating the ones that are actually used.
     class EffectDeviceResources
     {
     public:
-        EffectDeviceResources(_In_ ID3D11Device* device) noexcept
-          : mDevice(device)
+        EffectDeviceResources(_In_ ID3D11Device* device, BuiltInEffect effect) noexcept
+          : mDevice(device),
+            mEffect(effect)
         { }
 
         ID3D11VertexShader* DemandCreateVertexShader(_Inout_ Microsoft::WRL::ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode);
         ID3D11PixelShader * DemandCreatePixelShader (_Inout_ Microsoft::WRL::ComPtr<ID3D11PixelShader> & pixelShader,  ShaderBytecode const& bytecode);
         ID3D11ShaderResourceView* GetDefaultTexture();
 
+        // Create shaders ahead of first use for EffectWarmup. These return false rather than throwing if the device
+        // cannot create the shader, as with Shader Model 4.0 permutations on feature level 9.x devices.
+        bool WarmUpVertexShader(_Inout_ Microsoft::WRL::ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode);
+        bool WarmUpPixelShader (_Inout_ Microsoft::WRL::ComPtr<ID3D11PixelShader> & pixelShader,  ShaderBytecode const& bytecode);
+
     protected:
         Microsoft::WRL::ComPtr<ID3D11Device> mDevice;
         Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mDefaultTexture;
 
+        BuiltInEffect mEffect;
+
         std::mutex mMutex;
     };
 
 
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    // Helper writes constants into the shared GraphicsMemory upload ring and binds them to VS and PS slot 0 with
+    // *SetConstantBuffers1. Returns false if constant suballocation is disabled or unavailable on this context.
+    bool SetSuballocatedConstants(_In_ ID3D11DeviceContext* deviceContext, _In_reads_bytes_(size) void const* data, size_t size);
+#endif
+
+
+    // Shaders and constant buffer a built-in effect last bound on a device context, when effect state caching is on.
+    struct EffectAppliedState
+    {
+        ID3D11VertexShader* vertexShader;
+        ID3D11PixelShader* pixelShader;
+        ID3D11Buffer* constantBuffer;
+    };
+
+    // Returns the tracked state for this context, or null if effect state caching is off. The pointer stays valid
+    // for as long as the context exists, and like the context itself must only be used by one thread at a time.
+    EffectAppliedState* GetEffectAppliedState(_In_ ID3D11DeviceContext* deviceContext) noexcept;
+
+
+    // Each built-in effect type creates all its shaders for EffectWarmup through one of these. The result keeps
+    // the shaders alive, and shaderCount receives how many the device could create.
+    std::shared_ptr<void> CreateAllAlphaTestEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllBasicEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllDebugEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllDGSLEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllDualTextureEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllEnvironmentMapEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllNormalMapEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllPBREffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    std::shared_ptr<void> CreateAllSkinnedEffectShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+
+
     // Templated base class provides functionality common to all the built-in effects.
     template<typename Traits>
     class EffectBase : public AlignedNew<typename Traits::ConstantBufferType>
@@ -174,10 +247,7 @@ namespace DirectX
             assert(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
             _Analysis_assume_(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
 
-            ShaderBytecode const& bytecode = VertexShaderBytecode[shaderIndex];
-
-            *pShaderByteCode = bytecode.code;
-            *pByteCodeLength = bytecode.length;
+            GetShaderBytecode(VertexShaderBytecode[shaderIndex], pShaderByteCode, pByteCodeLength);
         }
 
 
@@ -188,13 +258,40 @@ namespace DirectX
             auto vertexShader = mDeviceResources->GetVertexShader(permutation);
             auto pixelShader = mDeviceResources->GetPixelShader(permutation);
 
-            deviceContext->VSSetShader(vertexShader, nullptr, 0);
-            deviceContext->PSSetShader(pixelShader, nullptr, 0);
+            auto applied = GetEffectAppliedState(deviceContext);
+
+            CountEffectApply(Traits::Effect, permutation);
+
+            if (!applied || applied->vertexShader != vertexShader)
+            {
+                deviceContext->VSSetShader(vertexShader, nullptr, 0);
+            }
+            else
+            {
+                CountEffectStatistic(Traits::Effect, EffectCounter::RedundantShaderSkip);
+            }
+
+            if (!applied || applied->pixelShader != pixelShader)
+            {
+                deviceContext->PSSetShader(pixelShader, nullptr, 0);
+            }
+            else
+            {
+                CountEffectStatistic(Traits::Effect, EffectCounter::RedundantShaderSkip);
+            }
+
+            if (applied)
+            {
+                applied->vertexShader = vertexShader;
+                applied->pixelShader = pixelShader;
+            }
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
             void *grfxMemory;
             mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
 
+            CountEffectStatistic(Traits::Effect, EffectCounter::ConstantBufferUpdate);
+
             Microsoft::WRL::ComPtr<ID3D11DeviceContextX> deviceContextX;
             ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
 
@@ -202,20 +299,56 @@ namespace DirectX
 
             deviceContextX->VSSetPlacementConstantBuffer(0, buffer, grfxMemory);
             deviceContextX->PSSetPlacementConstantBuffer(0, buffer, grfxMemory);
+
+            // Placement constants are bound on every Apply, so there is no buffer to remember.
+            if (applied)
+            {
+                applied->constantBuffer = nullptr;
+            }
 #else
-            // Make sure the constant buffer is up to date.
-            if (dirtyFlags & EffectDirtyFlags::ConstantBuffer)
+            // Suballocated constants are written on every Apply, because earlier ring offsets do not
+            // survive the ring wrapping, and writing into a NO_OVERWRITE mapping is cheap.
+            if (SetSuballocatedConstants(deviceContext, &constants, sizeof(constants)))
+            {
+                CountEffectStatistic(Traits::Effect, EffectCounter::ConstantBufferUpdate);
+
+                if (applied)
+                {
+                    applied->constantBuffer = nullptr;
+                }
+
+                // mConstantBuffer was not written, so leave it marked dirty in case a later Apply falls back to it.
+                return;
+            }
+
+            // Make sure the constant buffer is up to date. A deferred context always writes its own copy, as a command
+            // list that only binds the buffer reads whatever was last written to it when the list is executed.
+            if ((dirtyFlags & EffectDirtyFlags::ConstantBuffer) || deviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
             {
                 mConstantBuffer.SetData(deviceContext, constants);
-     
+
+                CountEffectStatistic(Traits::Effect, EffectCounter::ConstantBufferUpdate);
+
                 dirtyFlags &= ~EffectDirtyFlags::ConstantBuffer;
             }
 
-            // Set the constant buffer.
+            // Set the constant buffer. Mapping it with WRITE_DISCARD above does not unbind it.
             ID3D11Buffer* buffer = mConstantBuffer.GetBuffer();
 
-            deviceContext->VSSetConstantBuffers(0, 1, &buffer);
-            deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+            if (!applied || applied->constantBuffer != buffer)
+            {
+                deviceContext->VSSetConstantBuffers(0, 1, &buffer);
+                deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+            }
+            else
+            {
+                CountEffectStatistic(Traits::Effect, EffectCounter::RedundantConstantBufferSkip);
+            }
+
+            if (applied)
+            {
+                applied->constantBuffer = buffer;
+            }
 #endif
         }
 
@@ -224,6 +357,17 @@ namespace DirectX
         ID3D11ShaderResourceView* GetDefaultTexture() { return mDeviceResources->GetDefaultTexture(); }
 
 
+        // Helper creates every shader of this effect type on the device, for EffectWarmup.
+        static std::shared_ptr<void> CreateAllShaders(_In_ ID3D11Device* device, _Out_ size_t* shaderCount)
+        {
+            auto deviceResources = deviceResourcesPool.DemandCreate(device);
+
+            *shaderCount = deviceResources->CreateAllShaders();
+
+            return deviceResources;
+        }
+
+
     protected:
         // Static arrays hold all the precompiled shader permutations.
         static const ShaderBytecode VertexShaderBytecode[Traits::VertexShaderCount];
@@ -241,7 +385,7 @@ namespace DirectX
         {
         public:
             DeviceResources(_In_ ID3D11Device* device) noexcept
-              : EffectDeviceResources(device),
+              : EffectDeviceResources(device, Traits::Effect),
                 mVertexShaders{},
                 mPixelShaders{}
             { }
@@ -260,12 +404,16 @@ namespace DirectX
             }
 
 
-            // Gets or lazily creates the specified pixel shader permutation.
+            // Gets or lazily creates the specified pixel shader permutation. An index of -1 means the permutation
+            // runs without a pixel shader, as depth-only passes do.
             ID3D11PixelShader* GetPixelShader(int permutation)
             {
                 assert(permutation >= 0 && permutation < Traits::ShaderPermutationCount);
                 _Analysis_assume_(permutation >= 0 && permutation < Traits::ShaderPermutationCount);
                 int shaderIndex = PixelShaderIndices[permutation];
+                if (shaderIndex < 0)
+                    return nullptr;
+
                 assert(shaderIndex >= 0 && shaderIndex < Traits::PixelShaderCount);
                 _Analysis_assume_(shaderIndex >= 0 && shaderIndex < Traits::PixelShaderCount);
 
@@ -273,6 +421,27 @@ namespace DirectX
             }
 
 
+            // Creates every shader up front, returning how many the device accepted.
+            size_t CreateAllShaders()
+            {
+                size_t count = 0;
+
+                for (int j = 0; j < Traits::VertexShaderCount; ++j)
+                {
+                    if (WarmUpVertexShader(mVertexShaders[j], VertexShaderBytecode[j]))
+                        ++count;
+                }
+
+                for (int j = 0; j < Traits::PixelShaderCount; ++j)
+                {
+                    if (WarmUpPixelShader(mPixelShaders[j], PixelShaderBytecode[j]))
+                        ++count;
+                }
+
+                return count;
+            }
+
+
             // Gets or lazily creates the default texture
             ID3D11ShaderResourceView* GetDefaultTexture() { return EffectDeviceResources::GetDefaultTexture(); }
 
@@ -10,6 +10,8 @@
 #include "pch.h"
 #include "Effects.h"
 #include "DemandCreate.h"
+#include "MaterialCache.h"
+#include "ResourceCache.h"
 #include "SharedResourcePool.h"
 
 #include "DDSTextureLoader.h"
@@ -46,8 +48,8 @@ public:
     ComPtr<ID3D11Device> mDevice;
 
 private:
-    typedef std::map< std::wstring, std::shared_ptr<IEffect> > EffectCache;
-    typedef std::map< std::wstring, ComPtr<ID3D11ShaderResourceView> > TextureCache;
+    typedef MaterialCache< std::shared_ptr<IEffect> > EffectCache;
+    typedef ResourceCache<ID3D11ShaderResourceView> TextureCache;
 
     EffectCache  mEffectCache;
     EffectCache  mEffectCacheSkinning;
@@ -59,7 +61,11 @@ private:
     bool mUseNormalMapEffect;
     bool mForceSRGB;
 
+    // Guards the effect caches, and the device context when it is passed in for WIC auto-gen mipmaps. The
+    // texture cache has its own locks, so parallel model loads only meet here when they create effects.
     std::mutex mutex;
+
+    void LoadTexture(_In_z_ const wchar_t* texture, _In_opt_ ID3D11DeviceContext* deviceContext, _Outptr_ ID3D11ShaderResourceView** textureView);
 };
 
 
@@ -73,12 +79,16 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
     if (info.enableSkinning)
     {
         // SkinnedEffect
-        if (mSharing && info.name && *info.name)
+        MaterialKey key(info);
+
+        if (mSharing)
         {
-            auto it = mEffectCacheSkinning.find(info.name);
-            if (mSharing && it != mEffectCacheSkinning.end())
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto cached = mEffectCacheSkinning.Find(key);
+            if (cached)
             {
-                return it->second;
+                return *cached;
             }
         }
 
@@ -124,11 +134,11 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
             effect->SetBiasedVertexNormals(true);
         }
 
-        if (mSharing && info.name && *info.name)
+        if (mSharing)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            EffectCache::value_type v(info.name, effect);
-            mEffectCacheSkinning.insert(v);
+
+            return mEffectCacheSkinning.Insert(std::move(key), effect);
         }
 
         return std::move(effect);
@@ -136,12 +146,16 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
     else if (info.enableDualTexture)
     {
         // DualTextureEffect
-        if (mSharing && info.name && *info.name)
+        MaterialKey key(info);
+
+        if (mSharing)
         {
-            auto it = mEffectCacheDualTexture.find(info.name);
-            if (mSharing && it != mEffectCacheDualTexture.end())
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto cached = mEffectCacheDualTexture.Find(key);
+            if (cached)
             {
-                return it->second;
+                return *cached;
             }
         }
 
@@ -186,11 +200,11 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
             effect->SetTexture2(srv.Get());
         }
 
-        if (mSharing && info.name && *info.name)
+        if (mSharing)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            EffectCache::value_type v(info.name, effect);
-            mEffectCacheDualTexture.insert(v);
+
+            return mEffectCacheDualTexture.Insert(std::move(key), effect);
         }
 
         return std::move(effect);
@@ -198,12 +212,16 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
     else if (info.enableNormalMaps && mUseNormalMapEffect)
     {
         // NormalMapEffect
-        if (mSharing && info.name && *info.name)
+        MaterialKey key(info);
+
+        if (mSharing)
         {
-            auto it = mEffectNormalMap.find(info.name);
-            if (mSharing && it != mEffectNormalMap.end())
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto cached = mEffectNormalMap.Find(key);
+            if (cached)
             {
-                return it->second;
+                return *cached;
             }
         }
 
@@ -272,11 +290,11 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
             effect->SetBiasedVertexNormals(true);
         }
 
-        if (mSharing && info.name && *info.name)
+        if (mSharing)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            EffectCache::value_type v(info.name, effect);
-            mEffectNormalMap.insert(v);
+
+            return mEffectNormalMap.Insert(std::move(key), effect);
         }
 
         return std::move(effect);
@@ -284,12 +302,16 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
     else
     {
         // BasicEffect
-        if (mSharing && info.name && *info.name)
+        MaterialKey key(info);
+
+        if (mSharing)
         {
-            auto it = mEffectCache.find(info.name);
-            if (mSharing && it != mEffectCache.end())
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto cached = mEffectCache.Find(key);
+            if (cached)
             {
-                return it->second;
+                return *cached;
             }
         }
 
@@ -342,11 +364,11 @@ std::shared_ptr<IEffect> EffectFactory::Impl::CreateEffect(IEffectFactory* facto
             effect->SetBiasedVertexNormals(true);
         }
 
-        if (mSharing && info.name && *info.name)
+        if (mSharing)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            EffectCache::value_type v(info.name, effect);
-            mEffectCache.insert(v);
+
+            return mEffectCache.Insert(std::move(key), effect);
         }
 
         return std::move(effect);
@@ -359,84 +381,86 @@ void EffectFactory::Impl::CreateTexture(const wchar_t* name, ID3D11DeviceContext
     if (!name || !textureView)
         throw std::exception("invalid arguments");
 
+    if (mSharing && *name)
+    {
+        auto srv = mTextureCache.GetOrCreate(name, [&]()
+        {
+            ComPtr<ID3D11ShaderResourceView> result;
+            LoadTexture(name, deviceContext, result.GetAddressOf());
+            return result;
+        });
+
+        *textureView = srv.Detach();
+    }
+    else
+    {
+        LoadTexture(name, deviceContext, textureView);
+    }
+}
+
+_Use_decl_annotations_
+void EffectFactory::Impl::LoadTexture(const wchar_t* name, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView** textureView)
+{
 #if defined(_XBOX_ONE) && defined(_TITLE)
     UNREFERENCED_PARAMETER(deviceContext);
 #endif
 
-    auto it = mTextureCache.find(name);
+    wchar_t fullName[MAX_PATH] = {};
+    wcscpy_s(fullName, mPath);
+    wcscat_s(fullName, name);
 
-    if (mSharing && it != mTextureCache.end())
-    {
-        ID3D11ShaderResourceView* srv = it->second.Get();
-        srv->AddRef();
-        *textureView = srv;
-    }
-    else
+    WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+    if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
     {
-        wchar_t fullName[MAX_PATH] = {};
-        wcscpy_s(fullName, mPath);
-        wcscat_s(fullName, name);
-
-        WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+        // Try Current Working Directory (CWD)
+        wcscpy_s(fullName, name);
         if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
         {
-            // Try Current Working Directory (CWD)
-            wcscpy_s(fullName, name);
-            if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-            {
-                DebugTrace("ERROR: EffectFactory could not find texture file '%ls'\n", name);
-                throw std::exception("CreateTexture");
-            }
+            DebugTrace("ERROR: EffectFactory could not find texture file '%ls'\n", name);
+            throw std::exception("CreateTexture");
         }
+    }
 
-        wchar_t ext[_MAX_EXT];
-        _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
+    wchar_t ext[_MAX_EXT];
+    _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
 
-        if (_wcsicmp(ext, L".dds") == 0)
+    if (_wcsicmp(ext, L".dds") == 0)
+    {
+        HRESULT hr = CreateDDSTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB, nullptr, textureView);
+        if (FAILED(hr))
         {
-            HRESULT hr = CreateDDSTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateDDSTextureFromFile");
-            }
+            DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateDDSTextureFromFile");
         }
-    #if !defined(_XBOX_ONE) || !defined(_TITLE)
-        else if (deviceContext)
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), deviceContext, fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateWICTextureFromFile");
-            }
-        }
-    #endif
-        else
+    }
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    else if (deviceContext)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), deviceContext, fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
         {
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
-                throw std::exception("CreateWICTextureFromFile");
-            }
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateWICTextureFromFile");
         }
-
-        if (mSharing && *name && it == mTextureCache.end())
+    }
+#endif
+    else
+    {
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            TextureCache::value_type v(name, *textureView);
-            mTextureCache.insert(v);
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n", hr, fullName);
+            throw std::exception("CreateWICTextureFromFile");
         }
     }
 }
@@ -444,11 +468,11 @@ void EffectFactory::Impl::CreateTexture(const wchar_t* name, ID3D11DeviceContext
 void EffectFactory::Impl::ReleaseCache()
 {
     std::lock_guard<std::mutex> lock(mutex);
-    mEffectCache.clear();
-    mEffectCacheSkinning.clear();
-    mEffectCacheDualTexture.clear();
-    mEffectNormalMap.clear();
-    mTextureCache.clear();
+    mEffectCache.Clear();
+    mEffectCacheSkinning.Clear();
+    mEffectCacheDualTexture.Clear();
+    mEffectNormalMap.Clear();
+    mTextureCache.Clear();
 }
 
 
@@ -0,0 +1,154 @@
+//--------------------------------------------------------------------------------------
+// File: EffectWarmup.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "EffectCommon.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    struct WarmupEntry
+    {
+        uint32_t flag;
+        const wchar_t* name;
+        std::shared_ptr<void> (*createAllShaders)(_In_ ID3D11Device* device, _Out_ size_t* shaderCount);
+    };
+
+    const WarmupEntry s_warmupEntries[] =
+    {
+        { EffectWarmup_AlphaTest,       L"AlphaTestEffect",         CreateAllAlphaTestEffectShaders },
+        { EffectWarmup_Basic,           L"BasicEffect",             CreateAllBasicEffectShaders },
+        { EffectWarmup_Debug,           L"DebugEffect",             CreateAllDebugEffectShaders },
+        { EffectWarmup_DGSL,            L"DGSLEffect",              CreateAllDGSLEffectShaders },
+        { EffectWarmup_DualTexture,     L"DualTextureEffect",       CreateAllDualTextureEffectShaders },
+        { EffectWarmup_EnvironmentMap,  L"EnvironmentMapEffect",    CreateAllEnvironmentMapEffectShaders },
+        { EffectWarmup_NormalMap,       L"NormalMapEffect",         CreateAllNormalMapEffectShaders },
+        { EffectWarmup_PBR,             L"PBREffect",               CreateAllPBREffectShaders },
+        { EffectWarmup_Skinned,         L"SkinnedEffect",           CreateAllSkinnedEffectShaders },
+    };
+
+    static_assert(_countof(s_warmupEntries) == 9, "EffectWarmupFlags mismatch");
+}
+
+
+// Internal EffectWarmup implementation class.
+class EffectWarmup::Impl
+{
+public:
+    explicit Impl(_In_ ID3D11Device* device)
+        : mDevice(device)
+    {
+        if (!device)
+            throw std::exception("Device cannot be null");
+    }
+
+    void Run(uint32_t effects);
+
+    std::vector<Timing> GetTimings() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mTimings;
+    }
+
+private:
+    ComPtr<ID3D11Device> mDevice;
+
+    // References keeping the created shaders alive.
+    std::vector<std::shared_ptr<void>> mResources;
+    std::vector<Timing> mTimings;
+
+    mutable std::mutex mMutex;
+};
+
+
+void EffectWarmup::Impl::Run(uint32_t effects)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    for (auto const& entry : s_warmupEntries)
+    {
+        if (!(effects & entry.flag))
+            continue;
+
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+
+        size_t shaderCount = 0;
+        auto resources = entry.createAllShaders(mDevice.Get(), &shaderCount);
+
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+
+        Timing timing;
+        timing.effectName = entry.name;
+        timing.shaderCount = shaderCount;
+        timing.milliseconds = float(double(end.QuadPart - start.QuadPart) * 1000.0 / double(frequency.QuadPart));
+
+        DebugTrace("INFO: EffectWarmup created %zu %ls shaders in %.2f ms\n", shaderCount, entry.name, timing.milliseconds);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResources.push_back(resources);
+        mTimings.push_back(timing);
+    }
+}
+
+
+// Public constructor.
+EffectWarmup::EffectWarmup(_In_ ID3D11Device* device)
+    : pImpl(std::make_shared<Impl>(device))
+{
+}
+
+
+// Move constructor.
+EffectWarmup::EffectWarmup(EffectWarmup&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+EffectWarmup& EffectWarmup::operator= (EffectWarmup&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+EffectWarmup::~EffectWarmup()
+{
+}
+
+
+void EffectWarmup::Run(uint32_t effects)
+{
+    pImpl->Run(effects);
+}
+
+
+std::future<void> EffectWarmup::RunAsync(uint32_t effects)
+{
+    // The worker holds its own reference, so the shaders it creates survive even if this object goes first.
+    auto impl = pImpl;
+
+    return std::async(std::launch::async, [impl, effects]()
+    {
+        impl->Run(effects);
+    });
+}
+
+
+std::vector<EffectWarmup::Timing> EffectWarmup::GetTimings() const
+{
+    return pImpl->GetTimings();
+}
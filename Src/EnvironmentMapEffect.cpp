@@ -49,6 +49,8 @@ struct EnvironmentMapEffectTraits
     static const int VertexShaderCount = 10;
     static const int PixelShaderCount = 8;
     static const int ShaderPermutationCount = 40;
+
+    static const BuiltInEffect Effect = BuiltInEffect_EnvironmentMap;
 };
 
 
@@ -73,7 +75,8 @@ public:
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -120,22 +123,23 @@ namespace
     #include "Shaders/Compiled/EnvironmentMapEffect_PSEnvMapPixelLightingFresnelNoFog.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<EnvironmentMapEffectTraits>::VertexShaderBytecode[] =
 {
-    { EnvironmentMapEffect_VSEnvMap,                  sizeof(EnvironmentMapEffect_VSEnvMap)                  },
-    { EnvironmentMapEffect_VSEnvMapFresnel,           sizeof(EnvironmentMapEffect_VSEnvMapFresnel)           },
-    { EnvironmentMapEffect_VSEnvMapOneLight,          sizeof(EnvironmentMapEffect_VSEnvMapOneLight)          },
-    { EnvironmentMapEffect_VSEnvMapOneLightFresnel,   sizeof(EnvironmentMapEffect_VSEnvMapOneLightFresnel)   },
-    { EnvironmentMapEffect_VSEnvMapPixelLighting,     sizeof(EnvironmentMapEffect_VSEnvMapPixelLighting)     },
-
-    { EnvironmentMapEffect_VSEnvMapBn,                sizeof(EnvironmentMapEffect_VSEnvMapBn)                },
-    { EnvironmentMapEffect_VSEnvMapFresnelBn,         sizeof(EnvironmentMapEffect_VSEnvMapFresnelBn)         },
-    { EnvironmentMapEffect_VSEnvMapOneLightBn,        sizeof(EnvironmentMapEffect_VSEnvMapOneLightBn)        },
-    { EnvironmentMapEffect_VSEnvMapOneLightFresnelBn, sizeof(EnvironmentMapEffect_VSEnvMapOneLightFresnelBn) },
-    { EnvironmentMapEffect_VSEnvMapPixelLightingBn,   sizeof(EnvironmentMapEffect_VSEnvMapPixelLightingBn)   },
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMap),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapFresnel),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapOneLight),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapOneLightFresnel),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapPixelLighting),
+
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapBn),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapFresnelBn),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapOneLightBn),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapOneLightFresnelBn),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_VSEnvMapPixelLightingBn),
 };
 
 
@@ -193,14 +197,14 @@ const int EffectBase<EnvironmentMapEffectTraits>::VertexShaderIndices[] =
 template<>
 const ShaderBytecode EffectBase<EnvironmentMapEffectTraits>::PixelShaderBytecode[] =
 {
-    { EnvironmentMapEffect_PSEnvMap,                          sizeof(EnvironmentMapEffect_PSEnvMap)                          },
-    { EnvironmentMapEffect_PSEnvMapNoFog,                     sizeof(EnvironmentMapEffect_PSEnvMapNoFog)                     },
-    { EnvironmentMapEffect_PSEnvMapSpecular,                  sizeof(EnvironmentMapEffect_PSEnvMapSpecular)                  },
-    { EnvironmentMapEffect_PSEnvMapSpecularNoFog,             sizeof(EnvironmentMapEffect_PSEnvMapSpecularNoFog)             },
-    { EnvironmentMapEffect_PSEnvMapPixelLighting,             sizeof(EnvironmentMapEffect_PSEnvMapPixelLighting)             },
-    { EnvironmentMapEffect_PSEnvMapPixelLightingNoFog,        sizeof(EnvironmentMapEffect_PSEnvMapPixelLightingNoFog)        },
-    { EnvironmentMapEffect_PSEnvMapPixelLightingFresnel,      sizeof(EnvironmentMapEffect_PSEnvMapPixelLightingFresnel)      },
-    { EnvironmentMapEffect_PSEnvMapPixelLightingFresnelNoFog, sizeof(EnvironmentMapEffect_PSEnvMapPixelLightingFresnelNoFog) },
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMap),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapNoFog),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapSpecular),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapSpecularNoFog),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapPixelLighting),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapPixelLightingNoFog),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapPixelLightingFresnel),
+    EFFECT_SHADER_BYTECODE(EnvironmentMapEffect_PSEnvMapPixelLightingFresnelNoFog),
 };
 
 
@@ -260,6 +264,14 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<EnvironmentMapEffectTraits>::DeviceResources> EffectBase<EnvironmentMapEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllEnvironmentMapEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<EnvironmentMapEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 EnvironmentMapEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -382,6 +394,8 @@ EnvironmentMapEffect::~EnvironmentMapEffect()
 // IEffect methods.
 void EnvironmentMapEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"EnvironmentMapEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
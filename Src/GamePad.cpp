@@ -923,15 +923,25 @@ GamePad::Impl* GamePad::Impl::s_gamePad = nullptr;
 
 #include <Xinput.h>
 
+#include "InputEvents.h"
+
+#include <atomic>
+#include <thread>
+
 static_assert(GamePad::MAX_PLAYER_COUNT == XUSER_MAX_COUNT, "xinput.h mismatch");
+static_assert(InputEvent::GAMEPAD_A == XINPUT_GAMEPAD_A && InputEvent::GAMEPAD_DPAD_UP == XINPUT_GAMEPAD_DPAD_UP
+    && InputEvent::GAMEPAD_RIGHT_SHOULDER == XINPUT_GAMEPAD_RIGHT_SHOULDER && InputEvent::GAMEPAD_Y == XINPUT_GAMEPAD_Y, "xinput.h mismatch");
 
 class GamePad::Impl
 {
 public:
     Impl(GamePad* owner) :
         mOwner(owner),
+        mEventQueue(nullptr),
         mConnected{},
-        mLastReadTime{}
+        mLastReadTime{},
+        mPolls{},
+        mPollInterval(0)
     #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
         , mLeftMotor{}
         , mRightMotor{}
@@ -953,6 +963,8 @@ public:
 
     ~Impl()
     {
+        StopPolling();
+
         s_gamePad = nullptr;
     }
 
@@ -963,7 +975,36 @@ public:
 
         ULONGLONG time = GetTickCount64();
 
-        if (!ThrottleRetry(player, time))
+        if (mPollThread.joinable())
+        {
+            if ((player >= 0) && (player < XUSER_MAX_COUNT))
+            {
+                XINPUT_STATE xstate;
+                if (ReadPoll(player, xstate))
+                {
+                    if (!mConnected[player])
+                        mLastReadTime[player] = time;
+
+                    mConnected[player] = true;
+
+                #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
+                    if (mSuspended)
+                    {
+                        memset(&state, 0, sizeof(State));
+                        state.connected = true;
+                        return;
+                    }
+                #endif
+
+                    ConvertState(xstate, state, deadZoneMode);
+                    return;
+                }
+
+                if (mConnected[player])
+                    ClearSlot(player, time);
+            }
+        }
+        else if (!ThrottleRetry(player, time))
         {
         #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
             if (mSuspended)
@@ -987,45 +1028,7 @@ public:
 
                 mConnected[player] = true;
 
-                state.connected = true;
-                state.packet = xstate.dwPacketNumber;
-
-                WORD xbuttons = xstate.Gamepad.wButtons;
-                state.buttons.a = (xbuttons & XINPUT_GAMEPAD_A) != 0;
-                state.buttons.b = (xbuttons & XINPUT_GAMEPAD_B) != 0;
-                state.buttons.x = (xbuttons & XINPUT_GAMEPAD_X) != 0;
-                state.buttons.y = (xbuttons & XINPUT_GAMEPAD_Y) != 0;
-                state.buttons.leftStick = (xbuttons & XINPUT_GAMEPAD_LEFT_THUMB) != 0;
-                state.buttons.rightStick = (xbuttons & XINPUT_GAMEPAD_RIGHT_THUMB) != 0;
-                state.buttons.leftShoulder = (xbuttons & XINPUT_GAMEPAD_LEFT_SHOULDER) != 0;
-                state.buttons.rightShoulder = (xbuttons & XINPUT_GAMEPAD_RIGHT_SHOULDER) != 0;
-                state.buttons.back = (xbuttons & XINPUT_GAMEPAD_BACK) != 0;
-                state.buttons.start = (xbuttons & XINPUT_GAMEPAD_START) != 0;
-
-                state.dpad.up = (xbuttons & XINPUT_GAMEPAD_DPAD_UP) != 0;
-                state.dpad.down = (xbuttons & XINPUT_GAMEPAD_DPAD_DOWN) != 0;
-                state.dpad.right = (xbuttons & XINPUT_GAMEPAD_DPAD_RIGHT) != 0;
-                state.dpad.left = (xbuttons & XINPUT_GAMEPAD_DPAD_LEFT) != 0;
-
-                if (deadZoneMode == DEAD_ZONE_NONE)
-                {
-                    state.triggers.left = ApplyLinearDeadZone(float(xstate.Gamepad.bLeftTrigger), 255.f, 0.f);
-                    state.triggers.right = ApplyLinearDeadZone(float(xstate.Gamepad.bRightTrigger), 255.f, 0.f);
-                }
-                else
-                {
-                    state.triggers.left = ApplyLinearDeadZone(float(xstate.Gamepad.bLeftTrigger), 255.f, float(XINPUT_GAMEPAD_TRIGGER_THRESHOLD));
-                    state.triggers.right = ApplyLinearDeadZone(float(xstate.Gamepad.bRightTrigger), 255.f, float(XINPUT_GAMEPAD_TRIGGER_THRESHOLD));
-                }
-
-                ApplyStickDeadZone(float(xstate.Gamepad.sThumbLX), float(xstate.Gamepad.sThumbLY),
-                                   deadZoneMode, 32767.f, float(XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE),
-                                   state.thumbSticks.leftX, state.thumbSticks.leftY);
-
-                ApplyStickDeadZone(float(xstate.Gamepad.sThumbRX), float(xstate.Gamepad.sThumbRY),
-                                   deadZoneMode, 32767.f, float(XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE),
-                                   state.thumbSticks.rightX, state.thumbSticks.rightY);
-
+                ConvertState(xstate, state, deadZoneMode);
                 return;
             }
         }
@@ -1033,6 +1036,30 @@ public:
         memset(&state, 0, sizeof(State));
     }
 
+    void SetPollingRate(unsigned int samplesPerSecond)
+    {
+        StopPolling();
+
+        if (!samplesPerSecond)
+            return;
+
+        mPollInterval = std::max(1000u / samplesPerSecond, 1u);
+
+        for (int j = 0; j < XUSER_MAX_COUNT; ++j)
+        {
+            mPolls[j].sequence = 0;
+            mPolls[j].connected[0] = mPolls[j].connected[1] = false;
+        }
+
+        mPollExit.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        if (!mPollExit)
+        {
+            throw std::exception("CreateEventEx");
+        }
+
+        mPollThread = std::thread([this]() noexcept { PollThreadMain(); });
+    }
+
     void GetCapabilities(int player, _Out_ Capabilities& caps)
     {
         if (player == -1)
@@ -1189,12 +1216,30 @@ public:
 
     GamePad*    mOwner;
 
+    // Read by the polling thread.
+    std::atomic<InputEventQueue*> mEventQueue;
+
     static GamePad::Impl* s_gamePad;
 
 private:
     bool        mConnected[XUSER_MAX_COUNT];
     ULONGLONG   mLastReadTime[XUSER_MAX_COUNT];
 
+    // Samples from the polling thread, double-buffered: the thread writes the buffer the sequence does not point at,
+    // then advances it. As soon as it has, the next sample goes into the buffer a reader may still be copying, so a
+    // reader retries whenever the sequence changed during its copy.
+    struct PolledState
+    {
+        XINPUT_STATE            xstate[2];
+        bool                    connected[2];
+        std::atomic<uint32_t>   sequence;
+    };
+
+    PolledState     mPolls[XUSER_MAX_COUNT];
+    std::thread     mPollThread;
+    ScopedHandle    mPollExit;
+    DWORD           mPollInterval;
+
 #if (_WIN32_WINNT < _WIN32_WINNT_WIN8)
     // Variables for emulating XInputEnable on XInput 9.1.0
     float       mLeftMotor[XUSER_MAX_COUNT];
@@ -1232,6 +1277,161 @@ private:
         return false;
     }
 
+    void StopPolling() noexcept
+    {
+        if (!mPollThread.joinable())
+            return;
+
+        SetEvent(mPollExit.get());
+        mPollThread.join();
+    }
+
+    bool ReadPoll(int player, XINPUT_STATE& xstate) const noexcept
+    {
+        auto& poll = mPolls[player];
+
+        for (;;)
+        {
+            uint32_t sequence = poll.sequence.load(std::memory_order_acquire);
+
+            xstate = poll.xstate[sequence & 1];
+            bool connected = poll.connected[sequence & 1];
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (poll.sequence.load(std::memory_order_relaxed) == sequence)
+                return connected;
+        }
+    }
+
+    void PollThreadMain() noexcept
+    {
+        // Slot probing is the slow part of XInput with nothing connected, so empty slots are tried only once a
+        // second, one at a time.
+        ULONGLONG lastProbe[XUSER_MAX_COUNT] = {};
+        bool connected[XUSER_MAX_COUNT] = {};
+        WORD buttons[XUSER_MAX_COUNT] = {};
+
+        while (WaitForSingleObjectEx(mPollExit.get(), mPollInterval, FALSE) == WAIT_TIMEOUT)
+        {
+            ULONGLONG time = GetTickCount64();
+            bool probed = false;
+
+            for (int j = 0; j < XUSER_MAX_COUNT; ++j)
+            {
+                if (!connected[j])
+                {
+                    if (probed || (time - lastProbe[j] < 1000))
+                        continue;
+
+                    probed = true;
+                    lastProbe[j] = time;
+                }
+
+                auto& poll = mPolls[j];
+                uint32_t sequence = poll.sequence.load(std::memory_order_relaxed) + 1;
+
+                auto& xstate = poll.xstate[sequence & 1];
+                bool wasConnected = connected[j];
+                connected[j] = (XInputGetState(DWORD(j), &xstate) == ERROR_SUCCESS);
+                poll.connected[sequence & 1] = connected[j];
+
+                if (!connected[j])
+                    lastProbe[j] = time;
+
+                poll.sequence.store(sequence, std::memory_order_release);
+
+                PushChanges(j, wasConnected, connected[j], buttons[j], connected[j] ? xstate.Gamepad.wButtons : WORD(0));
+            }
+        }
+    }
+
+    void PushChanges(int player, bool wasConnected, bool connected, WORD& lastButtons, WORD xbuttons) noexcept
+    {
+        auto queue = mEventQueue.load();
+        if (!queue)
+        {
+            lastButtons = xbuttons;
+            return;
+        }
+
+        auto const timestamp = InputEventQueue::GetTimestamp();
+
+        InputEvent event = {};
+        event.timestamp = timestamp;
+        event.player = static_cast<uint8_t>(player);
+
+        if (connected && !wasConnected)
+        {
+            event.type = InputEvent::GAMEPAD_CONNECTED;
+            queue->Push(event);
+        }
+
+        WORD changed = WORD(lastButtons ^ xbuttons);
+        for (WORD bit = 1; changed; bit = WORD(bit << 1))
+        {
+            if (changed & bit)
+            {
+                event.type = (xbuttons & bit) ? InputEvent::GAMEPAD_BUTTON_DOWN : InputEvent::GAMEPAD_BUTTON_UP;
+                event.code = bit;
+                queue->Push(event);
+
+                changed &= WORD(~bit);
+            }
+        }
+
+        lastButtons = xbuttons;
+
+        if (wasConnected && !connected)
+        {
+            event.type = InputEvent::GAMEPAD_DISCONNECTED;
+            event.code = 0;
+            queue->Push(event);
+        }
+    }
+
+    static void ConvertState(const XINPUT_STATE& xstate, State& state, DeadZone deadZoneMode) noexcept
+    {
+        state.connected = true;
+        state.packet = xstate.dwPacketNumber;
+
+        WORD xbuttons = xstate.Gamepad.wButtons;
+        state.buttons.a = (xbuttons & XINPUT_GAMEPAD_A) != 0;
+        state.buttons.b = (xbuttons & XINPUT_GAMEPAD_B) != 0;
+        state.buttons.x = (xbuttons & XINPUT_GAMEPAD_X) != 0;
+        state.buttons.y = (xbuttons & XINPUT_GAMEPAD_Y) != 0;
+        state.buttons.leftStick = (xbuttons & XINPUT_GAMEPAD_LEFT_THUMB) != 0;
+        state.buttons.rightStick = (xbuttons & XINPUT_GAMEPAD_RIGHT_THUMB) != 0;
+        state.buttons.leftShoulder = (xbuttons & XINPUT_GAMEPAD_LEFT_SHOULDER) != 0;
+        state.buttons.rightShoulder = (xbuttons & XINPUT_GAMEPAD_RIGHT_SHOULDER) != 0;
+        state.buttons.back = (xbuttons & XINPUT_GAMEPAD_BACK) != 0;
+        state.buttons.start = (xbuttons & XINPUT_GAMEPAD_START) != 0;
+
+        state.dpad.up = (xbuttons & XINPUT_GAMEPAD_DPAD_UP) != 0;
+        state.dpad.down = (xbuttons & XINPUT_GAMEPAD_DPAD_DOWN) != 0;
+        state.dpad.right = (xbuttons & XINPUT_GAMEPAD_DPAD_RIGHT) != 0;
+        state.dpad.left = (xbuttons & XINPUT_GAMEPAD_DPAD_LEFT) != 0;
+
+        if (deadZoneMode == DEAD_ZONE_NONE)
+        {
+            state.triggers.left = ApplyLinearDeadZone(float(xstate.Gamepad.bLeftTrigger), 255.f, 0.f);
+            state.triggers.right = ApplyLinearDeadZone(float(xstate.Gamepad.bRightTrigger), 255.f, 0.f);
+        }
+        else
+        {
+            state.triggers.left = ApplyLinearDeadZone(float(xstate.Gamepad.bLeftTrigger), 255.f, float(XINPUT_GAMEPAD_TRIGGER_THRESHOLD));
+            state.triggers.right = ApplyLinearDeadZone(float(xstate.Gamepad.bRightTrigger), 255.f, float(XINPUT_GAMEPAD_TRIGGER_THRESHOLD));
+        }
+
+        ApplyStickDeadZone(float(xstate.Gamepad.sThumbLX), float(xstate.Gamepad.sThumbLY),
+                           deadZoneMode, 32767.f, float(XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE),
+                           state.thumbSticks.leftX, state.thumbSticks.leftY);
+
+        ApplyStickDeadZone(float(xstate.Gamepad.sThumbRX), float(xstate.Gamepad.sThumbRY),
+                           deadZoneMode, 32767.f, float(XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE),
+                           state.thumbSticks.rightX, state.thumbSticks.rightY);
+    }
+
     void ClearSlot(int player, ULONGLONG time)
     {
         mConnected[player] = false;
@@ -1335,6 +1535,18 @@ void GamePad::RegisterEvents(HANDLE ctrlChanged, HANDLE userChanged) noexcept
     pImpl->mCtrlChanged = (!ctrlChanged) ? INVALID_HANDLE_VALUE : ctrlChanged;
     pImpl->mUserChanged = (!userChanged) ? INVALID_HANDLE_VALUE : userChanged;
 }
+#else
+void GamePad::SetPollingRate(unsigned int samplesPerSecond)
+{
+    pImpl->SetPollingRate(samplesPerSecond);
+}
+
+
+_Use_decl_annotations_
+void GamePad::SetEventQueue(InputEventQueue* queue) noexcept
+{
+    pImpl->mEventQueue = queue;
+}
 #endif
 
 
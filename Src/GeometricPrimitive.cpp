@@ -12,6 +12,8 @@
 #include "Effects.h"
 #include "CommonStates.h"
 #include "DirectXHelpers.h"
+#include "GpuProfiler.h"
+#include "GraphicsMemory.h"
 #include "SharedResourcePool.h"
 #include "Geometry.h"
 
@@ -76,6 +78,71 @@ namespace
 
         SetDebugObjectName(*pInputLayout, "DirectXTK:GeometricPrimitive");
     }
+
+
+    // Per-instance stream for DrawInstanced: the three rows of a transposed world matrix (see IEffectInstancing),
+    // then the instance color, which the instanced BasicEffect reads as its vertex color.
+    struct InstanceData
+    {
+        XMFLOAT4 transform[3];
+        XMFLOAT4 color;
+    };
+
+    static_assert(sizeof(InstanceData) == 64, "Instance stream layout mismatch");
+
+    const D3D11_INPUT_ELEMENT_DESC s_instanceElements[] =
+    {
+        { "InstMatrix", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,  D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "COLOR",      0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+
+    const UINT c_instanceStride = sizeof(InstanceData);
+
+    // Instances uploaded by one instanced draw; larger batches are split.
+    const size_t c_maxInstancesPerDraw = 65536;
+
+    // Colors are stored premultiplied, as the primitives draw with premultiplied AlphaBlend and the instanced
+    // shaders use the instance color as is, matching what SetColorAndAlpha does for a single draw.
+    inline void XM_CALLCONV StoreInstance(_Out_ InstanceData* dest, FXMMATRIX world, FXMVECTOR color) noexcept
+    {
+        XMMATRIX m = XMMatrixTranspose(world);
+
+        XMStoreFloat4(&dest->transform[0], m.r[0]);
+        XMStoreFloat4(&dest->transform[1], m.r[1]);
+        XMStoreFloat4(&dest->transform[2], m.r[2]);
+        XMStoreFloat4(&dest->color, XMVectorSelect(color, XMVectorMultiply(color, XMVectorSplatW(color)), g_XMSelect1110));
+    }
+
+
+    // Helper for creating the input layout used by DrawInstanced.
+    void CreateInstancedInputLayout(_In_ ID3D11Device* device, IEffect* effect, _Outptr_ ID3D11InputLayout** pInputLayout)
+    {
+        assert(pInputLayout != nullptr);
+
+        D3D11_INPUT_ELEMENT_DESC decl[GeometricPrimitive::VertexType::InputElementCount + _countof(s_instanceElements)];
+
+        memcpy(decl, GeometricPrimitive::VertexType::InputElements, sizeof(GeometricPrimitive::VertexType::InputElements));
+        memcpy(decl + GeometricPrimitive::VertexType::InputElementCount, s_instanceElements, sizeof(s_instanceElements));
+
+        void const* shaderByteCode;
+        size_t byteCodeLength;
+
+        effect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+        ThrowIfFailed(
+            device->CreateInputLayout(
+            decl, _countof(decl),
+            shaderByteCode, byteCodeLength,
+            pInputLayout)
+        );
+
+        assert(pInputLayout != nullptr && *pInputLayout != nullptr);
+        _Analysis_assume_(pInputLayout != nullptr && *pInputLayout != nullptr);
+
+        SetDebugObjectName(*pInputLayout, "DirectXTK:GeometricPrimitive");
+    }
 }
 
 
@@ -83,9 +150,10 @@ namespace
 class GeometricPrimitive::Impl
 {
 public:
-    Impl() noexcept : mIndexCount(0) {}
+    Impl() noexcept : mIndexCount(0), mIndexFormat(DXGI_FORMAT_R16_UINT) {}
 
     void Initialize(_In_ ID3D11DeviceContext* deviceContext, const VertexCollection& vertices, const IndexCollection& indices);
+    void Initialize(_In_ ID3D11DeviceContext* deviceContext, const VertexCollection& vertices, const IndexCollection32& indices);
 
     void XM_CALLCONV Draw(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection, FXMVECTOR color, _In_opt_ ID3D11ShaderResourceView* texture, bool wireframe, std::function<void()>& setCustomState) const;
 
@@ -93,11 +161,29 @@ public:
 
     void CreateInputLayout(_In_ IEffect* effect, _Outptr_ ID3D11InputLayout** inputLayout) const;
 
+    void XM_CALLCONV DrawInstanced(_In_reads_(instanceCount) const XMFLOAT4X4* instanceTransforms, _In_reads_opt_(instanceCount) const XMFLOAT4* instanceColors, size_t instanceCount,
+                                   FXMMATRIX view, CXMMATRIX projection, _In_opt_ ID3D11ShaderResourceView* texture, bool wireframe, std::function<void()>& setCustomState) const;
+
+    void XM_CALLCONV Accumulate(FXMMATRIX world, FXMVECTOR color);
+
+    void XM_CALLCONV Flush(FXMMATRIX view, CXMMATRIX projection, bool wireframe, std::function<void()>& setCustomState);
+
+    size_t GetAccumulatedCount() const noexcept { return mOpaqueInstances.size() + mAlphaInstances.size(); }
+
 private:
     ComPtr<ID3D11Buffer> mVertexBuffer;
     ComPtr<ID3D11Buffer> mIndexBuffer;
 
     UINT mIndexCount;
+    DXGI_FORMAT mIndexFormat;
+
+    // Instances queued by Accumulate, already in the stream layout.
+    std::vector<InstanceData> mOpaqueInstances;
+    std::vector<InstanceData> mAlphaInstances;
+
+    template<typename TFill>
+    void XM_CALLCONV DrawInstances(size_t instanceCount, TFill fill, FXMMATRIX view, CXMMATRIX projection, _In_opt_ ID3D11ShaderResourceView* texture,
+                                   bool alpha, bool wireframe, std::function<void()>& setCustomState) const;
 
     // Only one of these helpers is allocated per D3D device context, even if there are multiple GeometricPrimitive instances.
     class SharedResources
@@ -107,12 +193,28 @@ private:
 
         void PrepareForRendering(bool alpha, bool wireframe) const;
 
+        // Lazily creates the instanced effect and its input layouts.
+        BasicEffect* GetInstancedEffect();
+
+        // Binds vertex buffer slot 1 to room for the instance stream, returning where to write it.
+        InstanceData* MapInstances(size_t instanceCount);
+        void UnmapInstances();
+
         ComPtr<ID3D11DeviceContext> mDeviceContext;
         std::unique_ptr<BasicEffect> effect;
 
         ComPtr<ID3D11InputLayout> inputLayoutTextured;
         ComPtr<ID3D11InputLayout> inputLayoutUntextured;
 
+        std::unique_ptr<BasicEffect> instancedEffect;
+
+        ComPtr<ID3D11InputLayout> inputLayoutInstancedTextured;
+        ComPtr<ID3D11InputLayout> inputLayoutInstancedUntextured;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        ComPtr<ID3D11Buffer> instancePlacementBuffer;
+    #endif
+
         std::unique_ptr<CommonStates> stateObjects;
     };
 
@@ -187,6 +289,87 @@ void GeometricPrimitive::Impl::SharedResources::PrepareForRendering(bool alpha,
 }
 
 
+BasicEffect* GeometricPrimitive::Impl::SharedResources::GetInstancedEffect()
+{
+    if (!instancedEffect)
+    {
+        ComPtr<ID3D11Device> device;
+        mDeviceContext->GetDevice(&device);
+
+        auto fx = std::make_unique<BasicEffect>(device.Get());
+
+        // Instancing needs lighting, and the instance color comes in as the vertex color.
+        fx->EnableDefaultLighting();
+        fx->SetVertexColorEnabled(true);
+        fx->SetInstancingEnabled(true);
+
+        fx->SetTextureEnabled(true);
+        CreateInstancedInputLayout(device.Get(), fx.get(), inputLayoutInstancedTextured.ReleaseAndGetAddressOf());
+
+        fx->SetTextureEnabled(false);
+        CreateInstancedInputLayout(device.Get(), fx.get(), inputLayoutInstancedUntextured.ReleaseAndGetAddressOf());
+
+        instancedEffect = std::move(fx);
+    }
+
+    return instancedEffect.get();
+}
+
+
+InstanceData* GeometricPrimitive::Impl::SharedResources::MapInstances(size_t instanceCount)
+{
+    size_t size = instanceCount * c_instanceStride;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    if (!instancePlacementBuffer)
+    {
+        ComPtr<ID3D11Device> device;
+        mDeviceContext->GetDevice(&device);
+
+        ComPtr<ID3D11DeviceX> deviceX;
+        ThrowIfFailed(device.As(&deviceX));
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = static_cast<UINT>(c_maxInstancesPerDraw * c_instanceStride);
+        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        ThrowIfFailed(
+            deviceX->CreatePlacementBuffer(&desc, nullptr, instancePlacementBuffer.ReleaseAndGetAddressOf())
+        );
+
+        SetDebugObjectName(instancePlacementBuffer.Get(), "DirectXTK:GeometricPrimitive");
+    }
+
+    void* grfxMemory = GraphicsMemory::Get().Allocate(mDeviceContext.Get(), size, 16);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(mDeviceContext.As(&deviceContextX));
+
+    deviceContextX->IASetPlacementVertexBuffer(1, instancePlacementBuffer.Get(), grfxMemory, c_instanceStride);
+
+    return static_cast<InstanceData*>(grfxMemory);
+#else
+    ID3D11Buffer* buffer;
+    UINT offset;
+    void* mapped = GraphicsMemory::Get().MapUpload(mDeviceContext.Get(), D3D11_BIND_VERTEX_BUFFER, size, 16, &buffer, &offset);
+
+    mDeviceContext->IASetVertexBuffers(1, 1, &buffer, &c_instanceStride, &offset);
+
+    return static_cast<InstanceData*>(mapped);
+#endif
+}
+
+
+void GeometricPrimitive::Impl::SharedResources::UnmapInstances()
+{
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    GraphicsMemory::Get().UnmapUpload(mDeviceContext.Get(), D3D11_BIND_VERTEX_BUFFER);
+#endif
+}
+
+
 // Initializes a geometric primitive instance that will draw the specified vertex and index data.
 _Use_decl_annotations_
 void GeometricPrimitive::Impl::Initialize(ID3D11DeviceContext* deviceContext, const VertexCollection& vertices, const IndexCollection& indices)
@@ -206,6 +389,47 @@ void GeometricPrimitive::Impl::Initialize(ID3D11DeviceContext* deviceContext, co
     CreateBuffer(device.Get(), indices, D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
 
     mIndexCount = static_cast<UINT>(indices.size());
+    mIndexFormat = DXGI_FORMAT_R16_UINT;
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::Impl::Initialize(ID3D11DeviceContext* deviceContext, const VertexCollection& vertices, const IndexCollection32& indices)
+{
+    if (vertices.size() < USHRT_MAX)
+    {
+        // Use 16-bit indices whenever the vertices allow it.
+        IndexCollection indices16;
+        indices16.reserve(indices.size());
+
+        for (auto it = indices.cbegin(); it != indices.cend(); ++it)
+        {
+            indices16.push_back(static_cast<uint16_t>(*it));
+        }
+
+        Initialize(deviceContext, vertices, indices16);
+        return;
+    }
+
+    if (vertices.size() >= UINT32_MAX)
+        throw std::exception("Too many vertices for 32-bit index buffer");
+
+    if (indices.size() > UINT32_MAX)
+        throw std::exception("Too many indices");
+
+    ComPtr<ID3D11Device> device;
+    deviceContext->GetDevice(&device);
+
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_9_2)
+        throw std::exception("32-bit index buffers require Feature Level 9.2 or later");
+
+    mResources = sharedResourcesPool.DemandCreate(deviceContext);
+
+    CreateBuffer(device.Get(), vertices, D3D11_BIND_VERTEX_BUFFER, &mVertexBuffer);
+    CreateBuffer(device.Get(), indices, D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
+
+    mIndexCount = static_cast<UINT>(indices.size());
+    mIndexFormat = DXGI_FORMAT_R32_UINT;
 }
 
 
@@ -262,6 +486,8 @@ void GeometricPrimitive::Impl::Draw(
     auto deviceContext = mResources->mDeviceContext.Get();
     assert(deviceContext != nullptr);
 
+    GpuProfileScope profileScope(deviceContext, L"GeometricPrimitive::Draw");
+
     // Set state objects.
     mResources->PrepareForRendering(alpha, wireframe);
 
@@ -280,12 +506,13 @@ void GeometricPrimitive::Impl::Draw(
 
     deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
 
-    deviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    deviceContext->IASetIndexBuffer(mIndexBuffer.Get(), mIndexFormat, 0);
 
     // Hook lets the caller replace our shaders or state settings with whatever else they see fit.
     if (setCustomState)
     {
         setCustomState();
+        InvalidateEffectStateCache(deviceContext);
     }
 
     // Draw the primitive.
@@ -295,6 +522,151 @@ void GeometricPrimitive::Impl::Draw(
 }
 
 
+// Draws the primitive once per instance, with fill writing each chunk of the instance stream.
+template<typename TFill>
+void XM_CALLCONV GeometricPrimitive::Impl::DrawInstances(
+    size_t instanceCount,
+    TFill fill,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    ID3D11ShaderResourceView* texture,
+    bool alpha,
+    bool wireframe,
+    std::function<void()>& setCustomState) const
+{
+    if (!instanceCount)
+        return;
+
+    assert(mResources);
+    auto deviceContext = mResources->mDeviceContext.Get();
+    assert(deviceContext != nullptr);
+
+    auto effect = mResources->GetInstancedEffect();
+
+    ID3D11InputLayout *inputLayout;
+    if (texture)
+    {
+        effect->SetTextureEnabled(true);
+        effect->SetTexture(texture);
+
+        inputLayout = mResources->inputLayoutInstancedTextured.Get();
+    }
+    else
+    {
+        effect->SetTextureEnabled(false);
+
+        inputLayout = mResources->inputLayoutInstancedUntextured.Get();
+    }
+
+    // Each instance transform carries its own world matrix.
+    effect->SetMatrices(XMMatrixIdentity(), view, projection);
+
+    mResources->PrepareForRendering(alpha, wireframe);
+
+    deviceContext->IASetInputLayout(inputLayout);
+
+    effect->Apply(deviceContext);
+
+    auto vertexBuffer = mVertexBuffer.Get();
+    UINT vertexStride = sizeof(VertexType);
+    UINT vertexOffset = 0;
+
+    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+
+    deviceContext->IASetIndexBuffer(mIndexBuffer.Get(), mIndexFormat, 0);
+
+    if (setCustomState)
+    {
+        setCustomState();
+        InvalidateEffectStateCache(deviceContext);
+    }
+
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    for (size_t first = 0; first < instanceCount; first += c_maxInstancesPerDraw)
+    {
+        size_t count = std::min(instanceCount - first, c_maxInstancesPerDraw);
+
+        fill(mResources->MapInstances(count), first, count);
+
+        mResources->UnmapInstances();
+
+        deviceContext->DrawIndexedInstanced(mIndexCount, static_cast<UINT>(count), 0, 0, 0);
+    }
+
+    // Unbind the instance stream so it does not leak into later draws.
+    ID3D11Buffer* nullBuffer = nullptr;
+    UINT zero = 0;
+    deviceContext->IASetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV GeometricPrimitive::Impl::DrawInstanced(
+    const XMFLOAT4X4* instanceTransforms,
+    const XMFLOAT4* instanceColors,
+    size_t instanceCount,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    ID3D11ShaderResourceView* texture,
+    bool wireframe,
+    std::function<void()>& setCustomState) const
+{
+    if (!instanceTransforms && instanceCount)
+        throw std::exception("Instance transforms cannot be null");
+
+    bool alpha = false;
+    if (instanceColors)
+    {
+        for (size_t j = 0; j < instanceCount; ++j)
+        {
+            if (instanceColors[j].w < 1.f)
+            {
+                alpha = true;
+                break;
+            }
+        }
+    }
+
+    DrawInstances(instanceCount, [=](InstanceData* dest, size_t first, size_t count)
+    {
+        for (size_t j = first; j < first + count; ++j)
+        {
+            XMVECTOR color = (instanceColors) ? XMLoadFloat4(&instanceColors[j]) : g_XMOne;
+            StoreInstance(dest++, XMLoadFloat4x4(&instanceTransforms[j]), color);
+        }
+    }, view, projection, texture, alpha, wireframe, setCustomState);
+}
+
+
+void XM_CALLCONV GeometricPrimitive::Impl::Accumulate(FXMMATRIX world, FXMVECTOR color)
+{
+    auto& instances = (XMVectorGetW(color) < 1.f) ? mAlphaInstances : mOpaqueInstances;
+
+    instances.emplace_back();
+    StoreInstance(&instances.back(), world, color);
+}
+
+
+void XM_CALLCONV GeometricPrimitive::Impl::Flush(FXMMATRIX view, CXMMATRIX projection, bool wireframe, std::function<void()>& setCustomState)
+{
+    auto copy = [](std::vector<InstanceData> const& instances)
+    {
+        return [&instances](InstanceData* dest, size_t first, size_t count)
+        {
+            memcpy(dest, instances.data() + first, count * sizeof(InstanceData));
+        };
+    };
+
+    // Opaque instances first, so blended ones draw over them.
+    DrawInstances(mOpaqueInstances.size(), copy(mOpaqueInstances), view, projection, nullptr, false, wireframe, setCustomState);
+    DrawInstances(mAlphaInstances.size(), copy(mAlphaInstances), view, projection, nullptr, true, wireframe, setCustomState);
+
+    mOpaqueInstances.clear();
+    mAlphaInstances.clear();
+}
+
+
 // Create input layout for drawing with a custom effect.
 _Use_decl_annotations_
 void GeometricPrimitive::Impl::CreateInputLayout(IEffect* effect, ID3D11InputLayout** inputLayout) const
@@ -364,6 +736,44 @@ void GeometricPrimitive::CreateInputLayout(IEffect* effect, ID3D11InputLayout**
 }
 
 
+_Use_decl_annotations_
+void XM_CALLCONV GeometricPrimitive::DrawInstanced(
+    const XMFLOAT4X4* instanceTransforms,
+    const XMFLOAT4* instanceColors,
+    size_t instanceCount,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    ID3D11ShaderResourceView* texture,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    pImpl->DrawInstanced(instanceTransforms, instanceColors, instanceCount, view, projection, texture, wireframe, setCustomState);
+}
+
+
+void XM_CALLCONV GeometricPrimitive::Accumulate(FXMMATRIX world, FXMVECTOR color)
+{
+    pImpl->Accumulate(world, color);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV GeometricPrimitive::Flush(
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState)
+{
+    pImpl->Flush(view, projection, wireframe, setCustomState);
+}
+
+
+size_t GeometricPrimitive::GetAccumulatedCount() const noexcept
+{
+    return pImpl->GetAccumulatedCount();
+}
+
+
 //--------------------------------------------------------------------------------------
 // Cube (aka a Hexahedron) or Box
 //--------------------------------------------------------------------------------------
@@ -375,8 +785,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateCube(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeBox(vertices, indices, XMFLOAT3(size, size, size), rhcoords, false);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -395,6 +806,15 @@ void GeometricPrimitive::CreateCube(
     ComputeBox(vertices, indices, XMFLOAT3(size, size, size), rhcoords, false);
 }
 
+void GeometricPrimitive::CreateCube(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    bool rhcoords)
+{
+    ComputeBox(vertices, indices, XMFLOAT3(size, size, size), rhcoords, false);
+}
+
 
 // Creates a box primitive.
 _Use_decl_annotations_
@@ -405,8 +825,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateBox(
     bool invertn)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeBox(vertices, indices, size, rhcoords, invertn);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -426,6 +847,16 @@ void GeometricPrimitive::CreateBox(
     ComputeBox(vertices, indices, size, rhcoords, invertn);
 }
 
+void GeometricPrimitive::CreateBox(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    const XMFLOAT3& size,
+    bool rhcoords,
+    bool invertn)
+{
+    ComputeBox(vertices, indices, size, rhcoords, invertn);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Sphere
@@ -440,8 +871,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateSphere(
     bool invertn)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeSphere(vertices, indices, diameter, tessellation, rhcoords, invertn);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -462,6 +894,17 @@ void GeometricPrimitive::CreateSphere(
     ComputeSphere(vertices, indices, diameter, tessellation, rhcoords, invertn);
 }
 
+void GeometricPrimitive::CreateSphere(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords,
+    bool invertn)
+{
+    ComputeSphere(vertices, indices, diameter, tessellation, rhcoords, invertn);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Geodesic sphere
@@ -475,8 +918,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateGeoSphere(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeGeoSphere(vertices, indices, diameter, tessellation, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -495,6 +939,15 @@ void GeometricPrimitive::CreateGeoSphere(
     ComputeGeoSphere(vertices, indices, diameter, tessellation, rhcoords);
 }
 
+void GeometricPrimitive::CreateGeoSphere(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float diameter,
+    size_t tessellation, bool rhcoords)
+{
+    ComputeGeoSphere(vertices, indices, diameter, tessellation, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Cylinder / Cone
@@ -510,8 +963,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateCylinder(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeCylinder(vertices, indices, height, diameter, tessellation, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -532,6 +986,17 @@ void GeometricPrimitive::CreateCylinder(
     ComputeCylinder(vertices, indices, height, diameter, tessellation, rhcoords);
 }
 
+void GeometricPrimitive::CreateCylinder(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float height,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords)
+{
+    ComputeCylinder(vertices, indices, height, diameter, tessellation, rhcoords);
+}
+
 
 // Creates a cone primitive.
 _Use_decl_annotations_
@@ -543,8 +1008,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateCone(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeCone(vertices, indices, diameter, height, tessellation, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -565,6 +1031,17 @@ void GeometricPrimitive::CreateCone(
     ComputeCone(vertices, indices, diameter, height, tessellation, rhcoords);
 }
 
+void GeometricPrimitive::CreateCone(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float diameter,
+    float height,
+    size_t tessellation,
+    bool rhcoords)
+{
+    ComputeCone(vertices, indices, diameter, height, tessellation, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Torus
@@ -579,8 +1056,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateTorus(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeTorus(vertices, indices, diameter, thickness, tessellation, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -601,6 +1079,17 @@ void GeometricPrimitive::CreateTorus(
     ComputeTorus(vertices, indices, diameter, thickness, tessellation, rhcoords);
 }
 
+void GeometricPrimitive::CreateTorus(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float diameter,
+    float thickness,
+    size_t tessellation,
+    bool rhcoords)
+{
+    ComputeTorus(vertices, indices, diameter, thickness, tessellation, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Tetrahedron
@@ -613,8 +1102,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateTetrahedron(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeTetrahedron(vertices, indices, size, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -633,6 +1123,15 @@ void GeometricPrimitive::CreateTetrahedron(
     ComputeTetrahedron(vertices, indices, size, rhcoords);
 }
 
+void GeometricPrimitive::CreateTetrahedron(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    bool rhcoords)
+{
+    ComputeTetrahedron(vertices, indices, size, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Octahedron
@@ -645,8 +1144,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateOctahedron(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeOctahedron(vertices, indices, size, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -665,6 +1165,15 @@ void GeometricPrimitive::CreateOctahedron(
     ComputeOctahedron(vertices, indices, size, rhcoords);
 }
 
+void GeometricPrimitive::CreateOctahedron(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    bool rhcoords)
+{
+    ComputeOctahedron(vertices, indices, size, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Dodecahedron
@@ -677,8 +1186,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateDodecahedron(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeDodecahedron(vertices, indices, size, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -697,6 +1207,15 @@ void GeometricPrimitive::CreateDodecahedron(
     ComputeDodecahedron(vertices, indices, size, rhcoords);
 }
 
+void GeometricPrimitive::CreateDodecahedron(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    bool rhcoords)
+{
+    ComputeDodecahedron(vertices, indices, size, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Icosahedron
@@ -709,8 +1228,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateIcosahedron(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeIcosahedron(vertices, indices, size, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -729,6 +1249,15 @@ void GeometricPrimitive::CreateIcosahedron(
     ComputeIcosahedron(vertices, indices, size, rhcoords);
 }
 
+void GeometricPrimitive::CreateIcosahedron(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    bool rhcoords)
+{
+    ComputeIcosahedron(vertices, indices, size, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Teapot
@@ -742,8 +1271,9 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateTeapot(
     bool rhcoords)
 {
     VertexCollection vertices;
-    IndexCollection indices;
+    IndexCollection32 indices;
     ComputeTeapot(vertices, indices, size, tessellation, rhcoords);
+    OptimizeForVertexCache(vertices, indices);
 
     // Create the primitive object.
     std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
@@ -763,6 +1293,16 @@ void GeometricPrimitive::CreateTeapot(
     ComputeTeapot(vertices, indices, size, tessellation, rhcoords);
 }
 
+void GeometricPrimitive::CreateTeapot(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    float size,
+    size_t tessellation,
+    bool rhcoords)
+{
+    ComputeTeapot(vertices, indices, size, tessellation, rhcoords);
+}
+
 
 //--------------------------------------------------------------------------------------
 // Custom
@@ -800,3 +1340,466 @@ std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateCustom(
 
     return primitive;
 }
+
+
+_Use_decl_annotations_
+std::unique_ptr<GeometricPrimitive> GeometricPrimitive::CreateCustom(
+    ID3D11DeviceContext* deviceContext,
+    const std::vector<VertexType>& vertices,
+    const std::vector<uint32_t>& indices)
+{
+    // Extra validation
+    if (vertices.empty() || indices.empty())
+        throw std::exception("Requires both vertices and indices");
+
+    if (indices.size() % 3)
+        throw std::exception("Expected triangular faces");
+
+    size_t nVerts = vertices.size();
+    if (nVerts >= UINT32_MAX)
+        throw std::exception("Too many vertices for 32-bit index buffer");
+
+    for (auto it = indices.cbegin(); it != indices.cend(); ++it)
+    {
+        if (*it >= nVerts)
+        {
+            throw std::exception("Index not in vertices list");
+        }
+    }
+
+    // Create the primitive object.
+    std::unique_ptr<GeometricPrimitive> primitive(new GeometricPrimitive());
+
+    primitive->pImpl->Initialize(deviceContext, vertices, indices);
+
+    return primitive;
+}
+
+//--------------------------------------------------------------------------------------
+// Caller-provided memory
+//--------------------------------------------------------------------------------------
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCube(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeBox(v, i, XMFLOAT3(size, size, size), rhcoords, false);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCube(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeBox(v, i, XMFLOAT3(size, size, size), rhcoords, false);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetCubeSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetBoxSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateBox(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    const XMFLOAT3& size,
+    bool rhcoords,
+    bool invertn)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeBox(v, i, size, rhcoords, invertn);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateBox(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    const XMFLOAT3& size,
+    bool rhcoords,
+    bool invertn)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeBox(v, i, size, rhcoords, invertn);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetBoxSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetBoxSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateSphere(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords,
+    bool invertn)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeSphere(v, i, diameter, tessellation, rhcoords, invertn);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateSphere(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords,
+    bool invertn)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeSphere(v, i, diameter, tessellation, rhcoords, invertn);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetSphereSize(size_t& vertexCount, size_t& indexCount, size_t tessellation)
+{
+    GetSphereSize(tessellation, vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCylinder(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float height,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeCylinder(v, i, height, diameter, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCylinder(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float height,
+    float diameter,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeCylinder(v, i, height, diameter, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetCylinderSize(size_t& vertexCount, size_t& indexCount, size_t tessellation)
+{
+    GetCylinderSize(tessellation, vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCone(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float diameter,
+    float height,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeCone(v, i, diameter, height, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateCone(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float diameter,
+    float height,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeCone(v, i, diameter, height, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetConeSize(size_t& vertexCount, size_t& indexCount, size_t tessellation)
+{
+    GetConeSize(tessellation, vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTorus(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float diameter,
+    float thickness,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeTorus(v, i, diameter, thickness, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTorus(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float diameter,
+    float thickness,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeTorus(v, i, diameter, thickness, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetTorusSize(size_t& vertexCount, size_t& indexCount, size_t tessellation)
+{
+    GetTorusSize(tessellation, vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTetrahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeTetrahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTetrahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeTetrahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetTetrahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetTetrahedronSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateOctahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeOctahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateOctahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeOctahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetOctahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetOctahedronSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateDodecahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeDodecahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateDodecahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeDodecahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetDodecahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetDodecahedronSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateIcosahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeIcosahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateIcosahedron(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeIcosahedron(v, i, size, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetIcosahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    GetIcosahedronSize(vertexCount, indexCount);
+}
+
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTeapot(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint16_t* indices,
+    size_t indexCount,
+    float size,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan i(indices, indexCount);
+    ComputeTeapot(v, i, size, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::CreateTeapot(
+    VertexType* vertices,
+    size_t vertexCount,
+    uint32_t* indices,
+    size_t indexCount,
+    float size,
+    size_t tessellation,
+    bool rhcoords)
+{
+    VertexSpan v(vertices, vertexCount);
+    IndexSpan32 i(indices, indexCount);
+    ComputeTeapot(v, i, size, tessellation, rhcoords);
+}
+
+_Use_decl_annotations_
+void GeometricPrimitive::GetTeapotSize(size_t& vertexCount, size_t& indexCount, size_t tessellation)
+{
+    GetTeapotSize(tessellation, vertexCount, indexCount);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Vertex cache optimization
+//--------------------------------------------------------------------------------------
+
+void GeometricPrimitive::OptimizeForVertexCache(
+    std::vector<VertexType>& vertices,
+    std::vector<uint16_t>& indices,
+    size_t cacheSize)
+{
+    DirectX::OptimizeForVertexCache(vertices, indices, cacheSize);
+}
+
+void GeometricPrimitive::OptimizeForVertexCache(
+    std::vector<VertexType>& vertices,
+    std::vector<uint32_t>& indices,
+    size_t cacheSize)
+{
+    DirectX::OptimizeForVertexCache(vertices, indices, cacheSize);
+}
@@ -20,24 +20,44 @@ namespace
     const float SQRT3 = 1.73205080756887729352f;
     const float SQRT6 = 2.44948974278317809820f;
 
+    template<typename TIndex>
     inline void CheckIndexOverflow(size_t value)
     {
-        // Use >=, not > comparison, because some D3D level 9_x hardware does not support 0xFFFF index values.
-        if (value >= USHRT_MAX)
+        // Use >=, not > comparison, because the all-ones value is the strip-cut index, and some D3D level 9_x
+        // hardware does not support 0xFFFF index values.
+        if (value >= static_cast<TIndex>(-1))
             throw std::exception("Index value out of range: cannot tesselate primitive so finely");
     }
 
 
+    // Narrows generated indices for the 16-bit overloads.
+    void NarrowIndices(IndexCollection32 const& source, IndexCollection& indices)
+    {
+        indices.clear();
+        indices.reserve(source.size());
+
+        for (auto it = source.cbegin(); it != source.cend(); ++it)
+        {
+            CheckIndexOverflow<uint16_t>(*it);
+            indices.push_back(static_cast<uint16_t>(*it));
+        }
+    }
+
+
     // Collection types used when generating the geometry.
-    inline void index_push_back(IndexCollection& indices, size_t value)
+    template<typename TIndices>
+    inline void index_push_back(TIndices& indices, size_t value)
     {
-        CheckIndexOverflow(value);
-        indices.push_back(static_cast<uint16_t>(value));
+        using index_t = typename TIndices::value_type;
+
+        CheckIndexOverflow<index_t>(value);
+        indices.push_back(static_cast<index_t>(value));
     }
 
 
     // Helper for flipping winding of geometric primitives for LH vs. RH coords
-    inline void ReverseWinding(IndexCollection& indices, VertexCollection& vertices)
+    template<typename TIndices, typename TVertices>
+    inline void ReverseWinding(TIndices& indices, TVertices& vertices)
     {
         assert((indices.size() % 3) == 0);
         for (auto it = indices.begin(); it != indices.end(); it += 3)
@@ -53,7 +73,8 @@ namespace
 
 
     // Helper for inverting normals of geometric primitives for 'inside' vs. 'outside' viewing
-    inline void InvertNormals(VertexCollection& vertices)
+    template<typename TVertices>
+    inline void InvertNormals(TVertices& vertices)
     {
         for (auto it = vertices.begin(); it != vertices.end(); ++it)
         {
@@ -68,7 +89,8 @@ namespace
 //--------------------------------------------------------------------------------------
 // Cube (aka a Hexahedron) or Box
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeBox(VertexCollection& vertices, IndexCollection& indices, const XMFLOAT3& size, bool rhcoords, bool invertn)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeBox(TVertices& vertices, TIndices& indices, const XMFLOAT3& size, bool rhcoords, bool invertn)
 {
     vertices.clear();
     indices.clear();
@@ -144,7 +166,8 @@ void DirectX::ComputeBox(VertexCollection& vertices, IndexCollection& indices, c
 //--------------------------------------------------------------------------------------
 // Sphere
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeSphere(TVertices& vertices, TIndices& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn)
 {
     vertices.clear();
     indices.clear();
@@ -219,18 +242,18 @@ void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices
 //--------------------------------------------------------------------------------------
 // Geodesic sphere
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords)
+void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection32& indices, float diameter, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
 
     // An undirected edge between two vertices, represented by a pair of indexes into a vertex array.
     // Becuse this edge is undirected, (a,b) is the same as (b,a).
-    typedef std::pair<uint16_t, uint16_t> UndirectedEdge;
+    typedef std::pair<uint32_t, uint32_t> UndirectedEdge;
 
     // Makes an undirected edge. Rather than overloading comparison operators to give us the (a,b)==(b,a) property,
     // we'll just ensure that the larger of the two goes first. This'll simplify things greatly.
-    auto makeUndirectedEdge = [](uint16_t a, uint16_t b) noexcept
+    auto makeUndirectedEdge = [](uint32_t a, uint32_t b) noexcept
     {
         return std::make_pair(std::max(a, b), std::min(a, b));
     };
@@ -238,7 +261,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
     // Key: an edge
     // Value: the index of the vertex which lies midway between the two vertices pointed to by the key value
     // This map is used to avoid duplicating vertices when subdividing triangles along edges.
-    typedef std::map<UndirectedEdge, uint16_t> EdgeSubdivisionMap;
+    typedef std::map<UndirectedEdge, uint32_t> EdgeSubdivisionMap;
 
 
     static const XMFLOAT3 OctahedronVertices[] =
@@ -251,7 +274,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
         XMFLOAT3(-1,  0,  0), // 4 left
         XMFLOAT3(0, -1,  0), // 5 bottom
     };
-    static const uint16_t OctahedronIndices[] =
+    static const uint32_t OctahedronIndices[] =
     {
         0, 1, 2, // top front-right face
         0, 2, 3, // top back-right face
@@ -274,8 +297,8 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
     // We know these values by looking at the above index list for the octahedron. Despite the subdivisions that are
     // about to go on, these values aren't ever going to change because the vertices don't move around in the array.
     // We'll need these values later on to fix the singularities that show up at the poles.
-    const uint16_t northPoleIndex = 0;
-    const uint16_t southPoleIndex = 5;
+    const uint32_t northPoleIndex = 0;
+    const uint32_t southPoleIndex = 5;
 
     for (size_t iSubdivision = 0; iSubdivision < tessellation; ++iSubdivision)
     {
@@ -285,7 +308,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
         EdgeSubdivisionMap subdividedEdges;
 
         // The new index collection after subdivision.
-        IndexCollection newIndices;
+        IndexCollection32 newIndices;
 
         const size_t triangleCount = indices.size() / 3;
         for (size_t iTriangle = 0; iTriangle < triangleCount; ++iTriangle)
@@ -294,20 +317,20 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             // The winding order of the triangles we output are the same as the winding order of the inputs.
 
             // Indices of the vertices making up this triangle
-            uint16_t iv0 = indices[iTriangle * 3 + 0];
-            uint16_t iv1 = indices[iTriangle * 3 + 1];
-            uint16_t iv2 = indices[iTriangle * 3 + 2];
+            uint32_t iv0 = indices[iTriangle * 3 + 0];
+            uint32_t iv1 = indices[iTriangle * 3 + 1];
+            uint32_t iv2 = indices[iTriangle * 3 + 2];
 
             // Get the new vertices
             XMFLOAT3 v01; // vertex on the midpoint of v0 and v1
             XMFLOAT3 v12; // ditto v1 and v2
             XMFLOAT3 v20; // ditto v2 and v0
-            uint16_t iv01; // index of v01
-            uint16_t iv12; // index of v12
-            uint16_t iv20; // index of v20
+            uint32_t iv01; // index of v01
+            uint32_t iv12; // index of v12
+            uint32_t iv20; // index of v20
 
             // Function that, when given the index of two vertices, creates a new vertex at the midpoint of those vertices.
-            auto divideEdge = [&](uint16_t i0, uint16_t i1, XMFLOAT3& outVertex, uint16_t& outIndex)
+            auto divideEdge = [&](uint32_t i0, uint32_t i1, XMFLOAT3& outVertex, uint32_t& outIndex)
             {
                 const UndirectedEdge edge = makeUndirectedEdge(i0, i1);
 
@@ -332,8 +355,8 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
                     )
                     );
 
-                    outIndex = static_cast<uint16_t>(vertexPositions.size());
-                    CheckIndexOverflow(outIndex);
+                    CheckIndexOverflow<uint32_t>(vertexPositions.size());
+                    outIndex = static_cast<uint32_t>(vertexPositions.size());
                     vertexPositions.push_back(outVertex);
 
                     // Now add it to the map.
@@ -355,7 +378,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             //     /b\c/d\
             // v2 o---o---o v1
             //       v12
-            const uint16_t indicesToAdd[] =
+            const uint32_t indicesToAdd[] =
             {
                  iv0, iv01, iv20, // a
                 iv20, iv12,  iv2, // b
@@ -413,7 +436,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
         if (isOnPrimeMeridian)
         {
             size_t newIndex = vertices.size(); // the index of this vertex that we're about to add
-            CheckIndexOverflow(newIndex);
+            CheckIndexOverflow<uint32_t>(newIndex);
 
             // copy this vertex, correct the texture coordinate, and add the vertex
             VertexPositionNormalTexture v = vertices[i];
@@ -423,9 +446,9 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             // Now find all the triangles which contain this vertex and update them if necessary
             for (size_t j = 0; j < indices.size(); j += 3)
             {
-                uint16_t* triIndex0 = &indices[j + 0];
-                uint16_t* triIndex1 = &indices[j + 1];
-                uint16_t* triIndex2 = &indices[j + 2];
+                uint32_t* triIndex0 = &indices[j + 0];
+                uint32_t* triIndex1 = &indices[j + 1];
+                uint32_t* triIndex2 = &indices[j + 2];
 
                 if (*triIndex0 == i)
                 {
@@ -459,7 +482,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
                     abs(v0.textureCoordinate.x - v2.textureCoordinate.x) > 0.5f)
                 {
                     // yep; replace the specified index to point to the new, corrected vertex
-                    *triIndex0 = static_cast<uint16_t>(newIndex);
+                    *triIndex0 = static_cast<uint32_t>(newIndex);
                 }
             }
         }
@@ -480,9 +503,9 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             // These pointers point to the three indices which make up this triangle. pPoleIndex is the pointer to the
             // entry in the index array which represents the pole index, and the other two pointers point to the other
             // two indices making up this triangle.
-            uint16_t* pPoleIndex;
-            uint16_t* pOtherIndex0;
-            uint16_t* pOtherIndex1;
+            uint32_t* pPoleIndex;
+            uint32_t* pOtherIndex0;
+            uint32_t* pOtherIndex1;
             if (indices[i + 0] == poleIndex)
             {
                 pPoleIndex = &indices[i + 0];
@@ -521,9 +544,9 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             }
             else
             {
-                CheckIndexOverflow(vertices.size());
+                CheckIndexOverflow<uint32_t>(vertices.size());
 
-                *pPoleIndex = static_cast<uint16_t>(vertices.size());
+                *pPoleIndex = static_cast<uint32_t>(vertices.size());
                 vertices.push_back(newPoleVertex);
             }
         }
@@ -568,7 +591,8 @@ namespace
 
 
     // Helper creates a triangle fan to close the end of a cylinder / cone
-    void CreateCylinderCap(VertexCollection& vertices, IndexCollection& indices, size_t tessellation, float height, float radius, bool isTop)
+    template<typename TVertices, typename TIndices>
+    void CreateCylinderCap(TVertices& vertices, TIndices& indices, size_t tessellation, float height, float radius, bool isTop)
     {
         // Create cap indices.
         for (size_t i = 0; i < tessellation - 2; i++)
@@ -611,7 +635,8 @@ namespace
     }
 }
 
-void DirectX::ComputeCylinder(VertexCollection& vertices, IndexCollection& indices, float height, float diameter, size_t tessellation, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeCylinder(TVertices& vertices, TIndices& indices, float height, float diameter, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -660,7 +685,8 @@ void DirectX::ComputeCylinder(VertexCollection& vertices, IndexCollection& indic
 
 
 // Creates a cone primitive.
-void DirectX::ComputeCone(VertexCollection& vertices, IndexCollection& indices, float diameter, float height, size_t tessellation, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeCone(TVertices& vertices, TIndices& indices, float diameter, float height, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -714,7 +740,8 @@ void DirectX::ComputeCone(VertexCollection& vertices, IndexCollection& indices,
 //--------------------------------------------------------------------------------------
 // Torus
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices, float diameter, float thickness, size_t tessellation, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeTorus(TVertices& vertices, TIndices& indices, float diameter, float thickness, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -778,7 +805,8 @@ void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices,
 //--------------------------------------------------------------------------------------
 // Tetrahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeTetrahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeTetrahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -838,7 +866,8 @@ void DirectX::ComputeTetrahedron(VertexCollection& vertices, IndexCollection& in
 //--------------------------------------------------------------------------------------
 // Octahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeOctahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeOctahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -904,7 +933,8 @@ void DirectX::ComputeOctahedron(VertexCollection& vertices, IndexCollection& ind
 //--------------------------------------------------------------------------------------
 // Dodecahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeDodecahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeDodecahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -1035,7 +1065,8 @@ void DirectX::ComputeDodecahedron(VertexCollection& vertices, IndexCollection& i
 //--------------------------------------------------------------------------------------
 // Icosahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeIcosahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeIcosahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -1129,7 +1160,8 @@ namespace
 #include "TeapotData.inc"
 
     // Tessellates the specified bezier patch.
-    void XM_CALLCONV TessellatePatch(VertexCollection& vertices, IndexCollection& indices, TeapotPatch const& patch, size_t tessellation, FXMVECTOR scale, bool isMirrored)
+    template<typename TVertices, typename TIndices>
+    void XM_CALLCONV TessellatePatch(TVertices& vertices, TIndices& indices, TeapotPatch const& patch, size_t tessellation, FXMVECTOR scale, bool isMirrored)
     {
         // Look up the 16 control points for this patch.
         XMVECTOR controlPoints[16];
@@ -1156,7 +1188,8 @@ namespace
 
 
 // Creates a teapot primitive.
-void DirectX::ComputeTeapot(VertexCollection& vertices, IndexCollection& indices, float size, size_t tessellation, bool rhcoords)
+template<typename TVertices, typename TIndices>
+void DirectX::ComputeTeapot(TVertices& vertices, TIndices& indices, float size, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -1193,3 +1226,427 @@ void DirectX::ComputeTeapot(VertexCollection& vertices, IndexCollection& indices
     if (!rhcoords)
         ReverseWinding(indices, vertices);
 }
+
+
+//--------------------------------------------------------------------------------------
+// Generator instantiations
+//--------------------------------------------------------------------------------------
+
+void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords)
+{
+    // The seam and pole fixups grow the mesh as they go, so this one is built 32-bit and narrowed.
+    IndexCollection32 indices32;
+    ComputeGeoSphere(vertices, indices32, diameter, tessellation, rhcoords);
+    NarrowIndices(indices32, indices);
+}
+
+
+template void DirectX::ComputeBox(VertexCollection&, IndexCollection&, const XMFLOAT3&, bool, bool);
+template void DirectX::ComputeBox(VertexCollection&, IndexCollection32&, const XMFLOAT3&, bool, bool);
+template void DirectX::ComputeBox(VertexSpan&, IndexSpan&, const XMFLOAT3&, bool, bool);
+template void DirectX::ComputeBox(VertexSpan&, IndexSpan32&, const XMFLOAT3&, bool, bool);
+
+template void DirectX::ComputeSphere(VertexCollection&, IndexCollection&, float, size_t, bool, bool);
+template void DirectX::ComputeSphere(VertexCollection&, IndexCollection32&, float, size_t, bool, bool);
+template void DirectX::ComputeSphere(VertexSpan&, IndexSpan&, float, size_t, bool, bool);
+template void DirectX::ComputeSphere(VertexSpan&, IndexSpan32&, float, size_t, bool, bool);
+
+template void DirectX::ComputeCylinder(VertexCollection&, IndexCollection&, float, float, size_t, bool);
+template void DirectX::ComputeCylinder(VertexCollection&, IndexCollection32&, float, float, size_t, bool);
+template void DirectX::ComputeCylinder(VertexSpan&, IndexSpan&, float, float, size_t, bool);
+template void DirectX::ComputeCylinder(VertexSpan&, IndexSpan32&, float, float, size_t, bool);
+
+template void DirectX::ComputeCone(VertexCollection&, IndexCollection&, float, float, size_t, bool);
+template void DirectX::ComputeCone(VertexCollection&, IndexCollection32&, float, float, size_t, bool);
+template void DirectX::ComputeCone(VertexSpan&, IndexSpan&, float, float, size_t, bool);
+template void DirectX::ComputeCone(VertexSpan&, IndexSpan32&, float, float, size_t, bool);
+
+template void DirectX::ComputeTorus(VertexCollection&, IndexCollection&, float, float, size_t, bool);
+template void DirectX::ComputeTorus(VertexCollection&, IndexCollection32&, float, float, size_t, bool);
+template void DirectX::ComputeTorus(VertexSpan&, IndexSpan&, float, float, size_t, bool);
+template void DirectX::ComputeTorus(VertexSpan&, IndexSpan32&, float, float, size_t, bool);
+
+template void DirectX::ComputeTetrahedron(VertexCollection&, IndexCollection&, float, bool);
+template void DirectX::ComputeTetrahedron(VertexCollection&, IndexCollection32&, float, bool);
+template void DirectX::ComputeTetrahedron(VertexSpan&, IndexSpan&, float, bool);
+template void DirectX::ComputeTetrahedron(VertexSpan&, IndexSpan32&, float, bool);
+
+template void DirectX::ComputeOctahedron(VertexCollection&, IndexCollection&, float, bool);
+template void DirectX::ComputeOctahedron(VertexCollection&, IndexCollection32&, float, bool);
+template void DirectX::ComputeOctahedron(VertexSpan&, IndexSpan&, float, bool);
+template void DirectX::ComputeOctahedron(VertexSpan&, IndexSpan32&, float, bool);
+
+template void DirectX::ComputeDodecahedron(VertexCollection&, IndexCollection&, float, bool);
+template void DirectX::ComputeDodecahedron(VertexCollection&, IndexCollection32&, float, bool);
+template void DirectX::ComputeDodecahedron(VertexSpan&, IndexSpan&, float, bool);
+template void DirectX::ComputeDodecahedron(VertexSpan&, IndexSpan32&, float, bool);
+
+template void DirectX::ComputeIcosahedron(VertexCollection&, IndexCollection&, float, bool);
+template void DirectX::ComputeIcosahedron(VertexCollection&, IndexCollection32&, float, bool);
+template void DirectX::ComputeIcosahedron(VertexSpan&, IndexSpan&, float, bool);
+template void DirectX::ComputeIcosahedron(VertexSpan&, IndexSpan32&, float, bool);
+
+template void DirectX::ComputeTeapot(VertexCollection&, IndexCollection&, float, size_t, bool);
+template void DirectX::ComputeTeapot(VertexCollection&, IndexCollection32&, float, size_t, bool);
+template void DirectX::ComputeTeapot(VertexSpan&, IndexSpan&, float, size_t, bool);
+template void DirectX::ComputeTeapot(VertexSpan&, IndexSpan32&, float, size_t, bool);
+
+
+//--------------------------------------------------------------------------------------
+// Output sizes
+//--------------------------------------------------------------------------------------
+
+void DirectX::GetBoxSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    vertexCount = 6 * 4;
+    indexCount = 6 * 6;
+}
+
+void DirectX::GetSphereSize(size_t tessellation, size_t& vertexCount, size_t& indexCount)
+{
+    if (tessellation < 3)
+        throw std::out_of_range("tesselation parameter out of range");
+
+    size_t verticalSegments = tessellation;
+    size_t horizontalSegments = tessellation * 2;
+
+    vertexCount = (verticalSegments + 1) * (horizontalSegments + 1);
+    indexCount = verticalSegments * (horizontalSegments + 1) * 6;
+}
+
+void DirectX::GetCylinderSize(size_t tessellation, size_t& vertexCount, size_t& indexCount)
+{
+    if (tessellation < 3)
+        throw std::out_of_range("tesselation parameter out of range");
+
+    // Sides, then two caps.
+    vertexCount = (tessellation + 1) * 2 + tessellation * 2;
+    indexCount = (tessellation + 1) * 6 + (tessellation - 2) * 3 * 2;
+}
+
+void DirectX::GetConeSize(size_t tessellation, size_t& vertexCount, size_t& indexCount)
+{
+    if (tessellation < 3)
+        throw std::out_of_range("tesselation parameter out of range");
+
+    // Sides, then the bottom cap.
+    vertexCount = (tessellation + 1) * 2 + tessellation;
+    indexCount = (tessellation + 1) * 3 + (tessellation - 2) * 3;
+}
+
+void DirectX::GetTorusSize(size_t tessellation, size_t& vertexCount, size_t& indexCount)
+{
+    if (tessellation < 3)
+        throw std::out_of_range("tesselation parameter out of range");
+
+    size_t stride = tessellation + 1;
+
+    vertexCount = stride * stride;
+    indexCount = stride * stride * 6;
+}
+
+void DirectX::GetTetrahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    vertexCount = 4 * 3;
+    indexCount = 4 * 3;
+}
+
+void DirectX::GetOctahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    vertexCount = 8 * 3;
+    indexCount = 8 * 3;
+}
+
+void DirectX::GetDodecahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    vertexCount = 12 * 5;
+    indexCount = 12 * 3 * 3;
+}
+
+void DirectX::GetIcosahedronSize(size_t& vertexCount, size_t& indexCount) noexcept
+{
+    vertexCount = 20 * 3;
+    indexCount = 20 * 3;
+}
+
+void DirectX::GetTeapotSize(size_t tessellation, size_t& vertexCount, size_t& indexCount)
+{
+    if (tessellation < 1)
+        throw std::out_of_range("tesselation parameter out of range");
+
+    size_t patchCount = 0;
+    for (size_t i = 0; i < _countof(TeapotPatches); i++)
+    {
+        patchCount += (TeapotPatches[i].mirrorZ) ? 4 : 2;
+    }
+
+    vertexCount = patchCount * (tessellation + 1) * (tessellation + 1);
+    indexCount = patchCount * tessellation * tessellation * 6;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Vertex cache optimization
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    // Scoring from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation". The cache is modeled as an LRU list a little
+    // longer than the hardware FIFO, and each step emits the triangle whose vertices score highest.
+    const float c_cacheDecayPower = 1.5f;
+    const float c_lastTriScore = 0.75f;
+    const float c_valenceBoostScale = 2.0f;
+    const float c_valenceBoostPower = 0.5f;
+
+    inline float VertexScore(int cachePosition, size_t cacheSize, uint32_t remainingTriangles) noexcept
+    {
+        if (!remainingTriangles)
+        {
+            // No triangles left to use this vertex.
+            return -1.f;
+        }
+
+        float score = 0.f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // The vertices of the last triangle get a fixed score, so its neighbors are not favored over the
+                // triangles that share an edge with it.
+                score = c_lastTriScore;
+            }
+            else
+            {
+                float scaler = 1.f / float(cacheSize - 3);
+                score = powf(1.f - float(cachePosition - 3) * scaler, c_cacheDecayPower);
+            }
+        }
+
+        // Boost vertices with few triangles left, so lone triangles are not left behind.
+        score += c_valenceBoostScale * powf(float(remainingTriangles), -c_valenceBoostPower);
+
+        return score;
+    }
+
+
+    template<typename TIndex>
+    void OptimizeFaces(std::vector<TIndex>& indices, size_t vertexCount, size_t cacheSize)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2)
+            return;
+
+        struct VertexInfo
+        {
+            int cachePosition;
+            uint32_t remainingTriangles;
+            uint32_t firstTriangle;
+            float score;
+        };
+
+        std::vector<VertexInfo> vertexInfo(vertexCount, VertexInfo{ -1, 0, 0, 0.f });
+
+        for (auto it = indices.cbegin(); it != indices.cend(); ++it)
+        {
+            if (*it >= vertexCount)
+                throw std::out_of_range("Index value out of range");
+
+            ++vertexInfo[*it].remainingTriangles;
+        }
+
+        // Triangles adjacent to each vertex, packed by vertex.
+        uint32_t offset = 0;
+        for (auto it = vertexInfo.begin(); it != vertexInfo.end(); ++it)
+        {
+            it->firstTriangle = offset;
+            offset += it->remainingTriangles;
+        }
+
+        std::vector<uint32_t> adjacency(offset);
+        {
+            std::vector<uint32_t> fill(vertexCount, 0);
+            for (size_t j = 0; j < triangleCount * 3; ++j)
+            {
+                TIndex v = indices[j];
+                adjacency[vertexInfo[v].firstTriangle + fill[v]++] = static_cast<uint32_t>(j / 3);
+            }
+        }
+
+        for (auto it = vertexInfo.begin(); it != vertexInfo.end(); ++it)
+        {
+            it->score = VertexScore(-1, cacheSize, it->remainingTriangles);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> triangleAdded(triangleCount, false);
+
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            triangleScore[t] = vertexInfo[indices[t * 3]].score
+                             + vertexInfo[indices[t * 3 + 1]].score
+                             + vertexInfo[indices[t * 3 + 2]].score;
+        }
+
+        // LRU cache of vertex indices, with room for the three pushed by each new triangle.
+        std::vector<TIndex> cache;
+        cache.reserve(cacheSize + 3);
+
+        std::vector<TIndex> newCache;
+        newCache.reserve(cacheSize + 3);
+
+        std::vector<TIndex> result;
+        result.reserve(triangleCount * 3);
+
+        size_t bestTriangle = SIZE_MAX;
+        size_t scanStart = 0;
+
+        for (size_t emitted = 0; emitted < triangleCount; ++emitted)
+        {
+            if (bestTriangle == SIZE_MAX)
+            {
+                // Nothing in the cache has work left, so start again from the best remaining triangle.
+                float bestScore = -1.f;
+                while (triangleAdded[scanStart])
+                    ++scanStart;
+
+                for (size_t t = scanStart; t < triangleCount; ++t)
+                {
+                    if (!triangleAdded[t] && triangleScore[t] > bestScore)
+                    {
+                        bestScore = triangleScore[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            assert(bestTriangle != SIZE_MAX);
+
+            triangleAdded[bestTriangle] = true;
+
+            const TIndex tri[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+
+            result.insert(result.end(), std::begin(tri), std::end(tri));
+
+            // Retire the triangle from its vertices' adjacency.
+            for (size_t k = 0; k < 3; ++k)
+            {
+                auto& info = vertexInfo[tri[k]];
+                auto first = adjacency.begin() + info.firstTriangle;
+                auto last = first + info.remainingTriangles;
+
+                auto it = std::find(first, last, static_cast<uint32_t>(bestTriangle));
+                if (it != last)
+                {
+                    std::iter_swap(it, last - 1);
+                    --info.remainingTriangles;
+                }
+            }
+
+            // Move the triangle to the front of the cache.
+            newCache.assign(std::begin(tri), std::end(tri));
+            for (auto it = cache.cbegin(); it != cache.cend(); ++it)
+            {
+                if (*it != tri[0] && *it != tri[1] && *it != tri[2])
+                    newCache.push_back(*it);
+            }
+
+            std::swap(cache, newCache);
+
+            // Rescore everything touched, including the vertices that just fell out of the cache.
+            for (size_t j = 0; j < cache.size(); ++j)
+            {
+                auto& info = vertexInfo[cache[j]];
+                info.cachePosition = (j < cacheSize) ? static_cast<int>(j) : -1;
+                info.score = VertexScore(info.cachePosition, cacheSize, info.remainingTriangles);
+            }
+
+            bestTriangle = SIZE_MAX;
+            float bestScore = -1.f;
+
+            for (auto it = cache.cbegin(); it != cache.cend(); ++it)
+            {
+                auto const& info = vertexInfo[*it];
+                for (uint32_t a = 0; a < info.remainingTriangles; ++a)
+                {
+                    uint32_t t = adjacency[info.firstTriangle + a];
+
+                    float score = vertexInfo[indices[t * 3]].score
+                                + vertexInfo[indices[t * 3 + 1]].score
+                                + vertexInfo[indices[t * 3 + 2]].score;
+                    triangleScore[t] = score;
+
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            if (cache.size() > cacheSize)
+            {
+                cache.resize(cacheSize);
+            }
+        }
+
+        std::swap(indices, result);
+    }
+
+
+    // Renumbers vertices in the order the index buffer first uses them, so fetches walk the vertex buffer forward.
+    template<typename TIndex>
+    void OptimizeVertices(VertexCollection& vertices, std::vector<TIndex>& indices)
+    {
+        const uint32_t unused = UINT32_MAX;
+
+        std::vector<uint32_t> remap(vertices.size(), unused);
+
+        VertexCollection newVertices;
+        newVertices.reserve(vertices.size());
+
+        for (auto it = indices.begin(); it != indices.end(); ++it)
+        {
+            if (remap[*it] == unused)
+            {
+                remap[*it] = static_cast<uint32_t>(newVertices.size());
+                newVertices.push_back(vertices[*it]);
+            }
+
+            *it = static_cast<TIndex>(remap[*it]);
+        }
+
+        // Keep any vertices the indices do not reference, after the rest.
+        for (size_t j = 0; j < vertices.size(); ++j)
+        {
+            if (remap[j] == unused)
+                newVertices.push_back(vertices[j]);
+        }
+
+        std::swap(vertices, newVertices);
+    }
+
+
+    template<typename TIndex>
+    void OptimizeMesh(VertexCollection& vertices, std::vector<TIndex>& indices, size_t cacheSize)
+    {
+        if ((indices.size() % 3) != 0)
+            throw std::exception("Index count must be a multiple of 3");
+
+        if (cacheSize < 4)
+            throw std::out_of_range("cacheSize parameter out of range");
+
+        OptimizeFaces(indices, vertices.size(), cacheSize);
+        OptimizeVertices(vertices, indices);
+    }
+}
+
+
+void DirectX::OptimizeForVertexCache(VertexCollection& vertices, IndexCollection& indices, size_t cacheSize)
+{
+    OptimizeMesh(vertices, indices, cacheSize);
+}
+
+void DirectX::OptimizeForVertexCache(VertexCollection& vertices, IndexCollection32& indices, size_t cacheSize)
+{
+    OptimizeMesh(vertices, indices, cacheSize);
+}
@@ -14,16 +14,75 @@ namespace DirectX
 {
     typedef std::vector<DirectX::VertexPositionNormalTexture> VertexCollection;
     typedef std::vector<uint16_t> IndexCollection;
+    typedef std::vector<uint32_t> IndexCollection32;
 
-    void ComputeBox(VertexCollection& vertices, IndexCollection& indices, const XMFLOAT3& size, bool rhcoords, bool invertn);
-    void ComputeSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn);
+    // Fixed-capacity collection over caller memory, so the generators can write straight into a mapped buffer.
+    template<typename T>
+    class GeometrySpan
+    {
+    public:
+        using value_type = T;
+
+        GeometrySpan(_Out_writes_(capacity) T* data, size_t capacity) noexcept : mData(data), mSize(0), mCapacity(capacity) {}
+
+        void push_back(const T& value)
+        {
+            if (mSize >= mCapacity)
+                throw std::out_of_range("Output buffer too small for the requested geometry");
+
+            mData[mSize++] = value;
+        }
+
+        void clear() noexcept { mSize = 0; }
+
+        size_t size() const noexcept { return mSize; }
+
+        T& operator[](size_t index) noexcept { assert(index < mSize); return mData[index]; }
+        const T& operator[](size_t index) const noexcept { assert(index < mSize); return mData[index]; }
+
+        T* begin() noexcept { return mData; }
+        T* end() noexcept { return mData + mSize; }
+
+    private:
+        T*      mData;
+        size_t  mSize;
+        size_t  mCapacity;
+    };
+
+    typedef GeometrySpan<DirectX::VertexPositionNormalTexture> VertexSpan;
+    typedef GeometrySpan<uint16_t> IndexSpan;
+    typedef GeometrySpan<uint32_t> IndexSpan32;
+
+    // The generators are instantiated in Geometry.cpp for each pairing of VertexCollection or VertexSpan with
+    // IndexCollection, IndexCollection32, IndexSpan, or IndexSpan32.
+    template<typename TVertices, typename TIndices> void ComputeBox(TVertices& vertices, TIndices& indices, const XMFLOAT3& size, bool rhcoords, bool invertn);
+    template<typename TVertices, typename TIndices> void ComputeSphere(TVertices& vertices, TIndices& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn);
+    template<typename TVertices, typename TIndices> void ComputeCylinder(TVertices& vertices, TIndices& indices, float height, float diameter, size_t tessellation, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeCone(TVertices& vertices, TIndices& indices, float diameter, float height, size_t tessellation, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeTorus(TVertices& vertices, TIndices& indices, float diameter, float thickness, size_t tessellation, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeTetrahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeOctahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeDodecahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeIcosahedron(TVertices& vertices, TIndices& indices, float size, bool rhcoords);
+    template<typename TVertices, typename TIndices> void ComputeTeapot(TVertices& vertices, TIndices& indices, float size, size_t tessellation, bool rhcoords);
+
+    // The geodesic sphere rewrites its own output while fixing seams, so it only generates into collections.
     void ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords);
-    void ComputeCylinder(VertexCollection& vertices, IndexCollection& indices, float height, float diameter, size_t tessellation, bool rhcoords);
-    void ComputeCone(VertexCollection& vertices, IndexCollection& indices, float diameter, float height, size_t tessellation, bool rhcoords);
-    void ComputeTorus(VertexCollection& vertices, IndexCollection& indices, float diameter, float thickness, size_t tessellation, bool rhcoords);
-    void ComputeTetrahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeOctahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeDodecahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeIcosahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeTeapot(VertexCollection& vertices, IndexCollection& indices, float size, size_t tessellation, bool rhcoords);
+    void ComputeGeoSphere(VertexCollection& vertices, IndexCollection32& indices, float diameter, size_t tessellation, bool rhcoords);
+
+    // Exact output sizes of the generators, for sizing a GeometrySpan.
+    void GetBoxSize(size_t& vertexCount, size_t& indexCount) noexcept;
+    void GetSphereSize(size_t tessellation, size_t& vertexCount, size_t& indexCount);
+    void GetCylinderSize(size_t tessellation, size_t& vertexCount, size_t& indexCount);
+    void GetConeSize(size_t tessellation, size_t& vertexCount, size_t& indexCount);
+    void GetTorusSize(size_t tessellation, size_t& vertexCount, size_t& indexCount);
+    void GetTetrahedronSize(size_t& vertexCount, size_t& indexCount) noexcept;
+    void GetOctahedronSize(size_t& vertexCount, size_t& indexCount) noexcept;
+    void GetDodecahedronSize(size_t& vertexCount, size_t& indexCount) noexcept;
+    void GetIcosahedronSize(size_t& vertexCount, size_t& indexCount) noexcept;
+    void GetTeapotSize(size_t tessellation, size_t& vertexCount, size_t& indexCount);
+
+    // Reorders triangles for post-transform vertex cache reuse, then vertices into first-use order.
+    void OptimizeForVertexCache(VertexCollection& vertices, IndexCollection& indices, size_t cacheSize = 32);
+    void OptimizeForVertexCache(VertexCollection& vertices, IndexCollection32& indices, size_t cacheSize = 32);
 }
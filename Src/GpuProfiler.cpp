@@ -0,0 +1,634 @@
+//--------------------------------------------------------------------------------------
+// File: GpuProfiler.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "GpuProfiler.h"
+#include "DirectXHelpers.h"
+#include "PlatformHelpers.h"
+
+#include <atomic>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    const uint32_t c_None = uint32_t(-1);
+
+    int64_t GetTicks() noexcept
+    {
+        LARGE_INTEGER ticks;
+        QueryPerformanceCounter(&ticks);
+        return ticks.QuadPart;
+    }
+}
+
+
+class GpuProfiler::Impl
+{
+public:
+    Impl(_In_ GpuProfiler* owner, _In_ ID3D11DeviceContext* deviceContext, size_t frameLatency, size_t maxScopes);
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        s_profiler = nullptr;
+
+        // Scopes may be opened from any thread, so wait out any caller that loaded the pointer before it was cleared.
+        for (UINT attempt = 0; s_activeCallers.load() != 0; ++attempt)
+        {
+            if (attempt < 16)
+            {
+                SwitchToThread();
+            }
+            else
+            {
+                Sleep(1);
+            }
+        }
+    }
+
+    void BeginFrame();
+    void EndFrame();
+
+    bool BeginScope(_In_ ID3D11DeviceContext* deviceContext, _In_z_ const wchar_t* name) noexcept;
+    void EndScope(_In_ ID3D11DeviceContext* deviceContext) noexcept;
+
+    GpuProfiler*            mOwner;
+
+    std::vector<Scope>      results;
+    uint64_t                resultsFrame;
+    float                   frameCpuMilliseconds;
+    float                   frameGpuMilliseconds;
+    uint64_t                droppedFrames;
+
+    static std::atomic<Impl*> s_profiler;
+
+    // Number of TryBeginScope/EndActiveScope calls currently using s_profiler, which keep it alive until they return.
+    static std::atomic<uint32_t> s_activeCallers;
+
+private:
+    // Scopes merge by name under each parent, linked as a tree in first-call order.
+    struct Node
+    {
+        const wchar_t*  name;
+        uint32_t        parent;
+        uint32_t        depth;
+        uint32_t        calls;
+        uint32_t        firstChild;
+        uint32_t        lastChild;
+        uint32_t        nextSibling;
+        int64_t         cpuTicks;
+    };
+
+    // A timed call: its node, and the index of its first timestamp (the second follows it).
+    struct Interval
+    {
+        uint32_t        node;
+        uint32_t        query;
+    };
+
+    struct Frame
+    {
+        ComPtr<ID3D11Query>                 disjoint;
+        std::vector<ComPtr<ID3D11Query>>    timestamps;     // The frame's own pair, then one pair per interval
+        std::vector<Node>                   nodes;
+        std::vector<Interval>               intervals;
+        int64_t                             cpuTicks;
+        uint64_t                            number;
+        bool                                pending;
+    };
+
+    struct OpenScope
+    {
+        uint32_t        node;
+        uint32_t        interval;
+        int64_t         start;
+    };
+
+    ID3D11Query* GetTimestamp(Frame& frame, size_t index) noexcept;
+    bool Resolve(Frame& frame);
+
+    ComPtr<ID3D11Device>                mDevice;
+    ComPtr<ID3D11DeviceContext>         mDeviceContext;
+    ComPtr<ID3DUserDefinedAnnotation>   mAnnotation;
+
+    std::vector<Frame>                  mFrames;
+    size_t                              mCurrent;
+    size_t                              mMaxScopes;
+
+    std::vector<OpenScope>              mOpenScopes;
+    bool                                mInFrame;
+    uint64_t                            mFrameNumber;
+    int64_t                             mFrameStart;
+    double                              mTicksToMilliseconds;
+};
+
+
+std::atomic<GpuProfiler::Impl*> GpuProfiler::Impl::s_profiler(nullptr);
+std::atomic<uint32_t> GpuProfiler::Impl::s_activeCallers(0);
+
+
+_Use_decl_annotations_
+GpuProfiler::Impl::Impl(GpuProfiler* owner, ID3D11DeviceContext* deviceContext, size_t frameLatency, size_t maxScopes)
+    : mOwner(owner),
+    resultsFrame(0),
+    frameCpuMilliseconds(0.f),
+    frameGpuMilliseconds(0.f),
+    droppedFrames(0),
+    mDeviceContext(deviceContext),
+    mCurrent(0),
+    mMaxScopes(maxScopes),
+    mInFrame(false),
+    mFrameNumber(0),
+    mFrameStart(0)
+{
+    if (s_profiler)
+    {
+        throw std::exception("GpuProfiler is a singleton");
+    }
+
+    if (!frameLatency || frameLatency > 16)
+    {
+        throw std::out_of_range("frameLatency must be between 1 and 16");
+    }
+
+    deviceContext->GetDevice(mDevice.GetAddressOf());
+
+    // Without an annotation interface (older runtimes), there are still timings, just no events.
+    (void)deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(mAnnotation.GetAddressOf()));
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    mTicksToMilliseconds = 1000.0 / double(frequency.QuadPart);
+
+    mFrames.resize(frameLatency + 1);
+
+    for (auto& frame : mFrames)
+    {
+        D3D11_QUERY_DESC desc = {};
+        desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+        ThrowIfFailed(mDevice->CreateQuery(&desc, frame.disjoint.GetAddressOf()));
+
+        frame.cpuTicks = 0;
+        frame.number = 0;
+        frame.pending = false;
+    }
+
+    s_profiler = this;
+}
+
+
+// Timestamp queries are only created as a frame first needs them.
+ID3D11Query* GpuProfiler::Impl::GetTimestamp(Frame& frame, size_t index) noexcept
+{
+    while (frame.timestamps.size() <= index)
+    {
+        D3D11_QUERY_DESC desc = {};
+        desc.Query = D3D11_QUERY_TIMESTAMP;
+
+        ComPtr<ID3D11Query> query;
+        if (FAILED(mDevice->CreateQuery(&desc, query.GetAddressOf())))
+            return nullptr;
+
+        frame.timestamps.push_back(query);
+    }
+
+    return frame.timestamps[index].Get();
+}
+
+
+// Reads a frame's queries if the GPU is done with all of them, otherwise leaves it pending.
+bool GpuProfiler::Impl::Resolve(Frame& frame)
+{
+    auto context = mDeviceContext.Get();
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    if (context->GetData(frame.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+        return false;
+
+    size_t queryCount = 2 + frame.intervals.size() * 2;
+    std::vector<UINT64> times(queryCount);
+
+    for (size_t j = 0; j < queryCount; ++j)
+    {
+        if (context->GetData(frame.timestamps[j].Get(), &times[j], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            return false;
+    }
+
+    frame.pending = false;
+
+    // A disjoint frame has timings that cannot be trusted, so it counts as dropped.
+    if (disjoint.Disjoint || !disjoint.Frequency)
+    {
+        ++droppedFrames;
+        return true;
+    }
+
+    double toMilliseconds = 1000.0 / double(disjoint.Frequency);
+
+    std::vector<double> gpu(frame.nodes.size(), 0.0);
+    for (auto& interval : frame.intervals)
+    {
+        gpu[interval.node] += double(times[interval.query + 1] - times[interval.query]) * toMilliseconds;
+    }
+
+    // Flatten the tree depth first, so parents come before their children.
+    std::vector<uint32_t> order;
+    order.reserve(frame.nodes.size());
+
+    std::vector<uint32_t> resultIndex(frame.nodes.size(), c_None);
+    std::vector<uint32_t> stack;
+
+    for (uint32_t root = 0; root < frame.nodes.size(); ++root)
+    {
+        if (frame.nodes[root].parent != c_None)
+            continue;
+
+        stack.push_back(root);
+
+        while (!stack.empty())
+        {
+            uint32_t j = stack.back();
+            stack.pop_back();
+
+            resultIndex[j] = static_cast<uint32_t>(order.size());
+            order.push_back(j);
+
+            // Children go on in reverse, so they come off in call order.
+            std::vector<uint32_t> children;
+            for (uint32_t child = frame.nodes[j].firstChild; child != c_None; child = frame.nodes[child].nextSibling)
+            {
+                children.push_back(child);
+            }
+
+            stack.insert(stack.end(), children.rbegin(), children.rend());
+        }
+    }
+
+    results.clear();
+    results.reserve(order.size());
+
+    for (auto j : order)
+    {
+        auto& node = frame.nodes[j];
+
+        Scope scope = {};
+        scope.name = node.name;
+        scope.parent = (node.parent != c_None) ? resultIndex[node.parent] : Scope::c_NoParent;
+        scope.depth = node.depth;
+        scope.calls = node.calls;
+        scope.cpuMilliseconds = float(double(node.cpuTicks) * mTicksToMilliseconds);
+        scope.gpuMilliseconds = float(gpu[j]);
+        results.push_back(scope);
+    }
+
+    resultsFrame = frame.number;
+    frameCpuMilliseconds = float(double(frame.cpuTicks) * mTicksToMilliseconds);
+    frameGpuMilliseconds = float(double(times[1] - times[0]) * toMilliseconds);
+
+    return true;
+}
+
+
+void GpuProfiler::Impl::BeginFrame()
+{
+    if (mInFrame)
+    {
+        throw std::exception("EndFrame must be called before BeginFrame");
+    }
+
+    auto& frame = mFrames[mCurrent];
+
+    if (frame.pending && !Resolve(frame))
+    {
+        frame.pending = false;
+        ++droppedFrames;
+    }
+
+    frame.nodes.clear();
+    frame.intervals.clear();
+
+    auto start = GetTimestamp(frame, 0);
+    if (!GetTimestamp(frame, 1))
+    {
+        throw std::exception("CreateQuery failed for GpuProfiler");
+    }
+
+    mDeviceContext->Begin(frame.disjoint.Get());
+    mDeviceContext->End(start);
+
+    mOpenScopes.clear();
+    mInFrame = true;
+    mFrameStart = GetTicks();
+}
+
+
+void GpuProfiler::Impl::EndFrame()
+{
+    if (!mInFrame)
+    {
+        throw std::exception("BeginFrame must be called before EndFrame");
+    }
+
+    if (!mOpenScopes.empty())
+    {
+        throw std::exception("GpuProfiler scopes left open at EndFrame");
+    }
+
+    auto& frame = mFrames[mCurrent];
+
+    mDeviceContext->End(frame.timestamps[1].Get());
+    mDeviceContext->End(frame.disjoint.Get());
+
+    frame.cpuTicks = GetTicks() - mFrameStart;
+    frame.number = ++mFrameNumber;
+    frame.pending = true;
+
+    mInFrame = false;
+    mCurrent = (mCurrent + 1) % mFrames.size();
+
+    // Resolve whatever has finished, oldest first. This slot is the oldest, and the next to be reused.
+    for (size_t j = 0; j < mFrames.size(); ++j)
+    {
+        auto& older = mFrames[(mCurrent + j) % mFrames.size()];
+        if (older.pending && !Resolve(older))
+            break;
+    }
+}
+
+
+_Use_decl_annotations_
+bool GpuProfiler::Impl::BeginScope(ID3D11DeviceContext* deviceContext, const wchar_t* name) noexcept
+{
+    // The context check comes first: other threads may get here, and only the profiled context's thread touches frame state.
+    if (deviceContext != mDeviceContext.Get() || !mInFrame || !name)
+        return false;
+
+    auto& frame = mFrames[mCurrent];
+
+    uint32_t parent = mOpenScopes.empty() ? c_None : mOpenScopes.back().node;
+
+    uint32_t node = c_None;
+    uint32_t first = (parent != c_None) ? frame.nodes[parent].firstChild : c_None;
+
+    if (parent == c_None)
+    {
+        // Top-level scopes are the nodes without a parent.
+        for (uint32_t j = 0; j < frame.nodes.size(); ++j)
+        {
+            if (frame.nodes[j].parent == c_None && frame.nodes[j].name == name)
+            {
+                node = j;
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t child = first; child != c_None; child = frame.nodes[child].nextSibling)
+        {
+            if (frame.nodes[child].name == name)
+            {
+                node = child;
+                break;
+            }
+        }
+    }
+
+    try
+    {
+        if (node == c_None)
+        {
+            node = static_cast<uint32_t>(frame.nodes.size());
+
+            Node entry = {};
+            entry.name = name;
+            entry.parent = parent;
+            entry.depth = static_cast<uint32_t>(mOpenScopes.size());
+            entry.firstChild = entry.lastChild = entry.nextSibling = c_None;
+            frame.nodes.push_back(entry);
+
+            if (parent != c_None)
+            {
+                auto& p = frame.nodes[parent];
+                if (p.lastChild != c_None)
+                    frame.nodes[p.lastChild].nextSibling = node;
+                else
+                    p.firstChild = node;
+                p.lastChild = node;
+            }
+        }
+
+        uint32_t interval = c_None;
+
+        if (frame.intervals.size() < mMaxScopes)
+        {
+            auto query = 2 + frame.intervals.size() * 2;
+
+            auto begin = GetTimestamp(frame, query);
+            if (begin && GetTimestamp(frame, query + 1))
+            {
+                interval = static_cast<uint32_t>(frame.intervals.size());
+                frame.intervals.push_back({ node, static_cast<uint32_t>(query) });
+
+                mDeviceContext->End(begin);
+            }
+        }
+
+        mOpenScopes.push_back({ node, interval, 0 });
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    ++frame.nodes[node].calls;
+
+    if (mAnnotation)
+        mAnnotation->BeginEvent(name);
+
+    mOpenScopes.back().start = GetTicks();
+
+    return true;
+}
+
+
+_Use_decl_annotations_
+void GpuProfiler::Impl::EndScope(ID3D11DeviceContext* deviceContext) noexcept
+{
+    if (deviceContext != mDeviceContext.Get() || !mInFrame || mOpenScopes.empty())
+        return;
+
+    auto open = mOpenScopes.back();
+    mOpenScopes.pop_back();
+
+    auto& frame = mFrames[mCurrent];
+
+    frame.nodes[open.node].cpuTicks += GetTicks() - open.start;
+
+    if (open.interval != c_None)
+    {
+        auto query = frame.intervals[open.interval].query;
+        mDeviceContext->End(frame.timestamps[query + 1].Get());
+    }
+
+    if (mAnnotation)
+        mAnnotation->EndEvent();
+}
+
+
+//--------------------------------------------------------------------------------------
+// GpuProfiler
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+GpuProfiler::GpuProfiler(_In_ ID3D11DeviceContext* deviceContext, size_t frameLatency, size_t maxScopes)
+    : pImpl(std::make_unique<Impl>(this, deviceContext, frameLatency, maxScopes))
+{
+}
+
+
+// Move constructor.
+GpuProfiler::GpuProfiler(GpuProfiler&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+    if (pImpl)
+    {
+        pImpl->mOwner = this;
+    }
+}
+
+
+// Move assignment.
+GpuProfiler& GpuProfiler::operator= (GpuProfiler&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    if (pImpl)
+    {
+        pImpl->mOwner = this;
+    }
+    return *this;
+}
+
+
+// Public destructor.
+GpuProfiler::~GpuProfiler()
+{
+}
+
+
+void GpuProfiler::BeginFrame()
+{
+    pImpl->BeginFrame();
+}
+
+
+void GpuProfiler::EndFrame()
+{
+    pImpl->EndFrame();
+}
+
+
+_Use_decl_annotations_
+void GpuProfiler::BeginScope(ID3D11DeviceContext* deviceContext, const wchar_t* name)
+{
+    pImpl->BeginScope(deviceContext, name);
+}
+
+
+_Use_decl_annotations_
+void GpuProfiler::EndScope(ID3D11DeviceContext* deviceContext)
+{
+    pImpl->EndScope(deviceContext);
+}
+
+
+const std::vector<GpuProfiler::Scope>& GpuProfiler::GetResults() const noexcept
+{
+    return pImpl->results;
+}
+
+
+uint64_t GpuProfiler::GetResultsFrame() const noexcept
+{
+    return pImpl->resultsFrame;
+}
+
+
+float GpuProfiler::GetFrameCpuMilliseconds() const noexcept
+{
+    return pImpl->frameCpuMilliseconds;
+}
+
+
+float GpuProfiler::GetFrameGpuMilliseconds() const noexcept
+{
+    return pImpl->frameGpuMilliseconds;
+}
+
+
+uint64_t GpuProfiler::GetDroppedFrames() const noexcept
+{
+    return pImpl->droppedFrames;
+}
+
+
+_Use_decl_annotations_
+bool GpuProfiler::TryBeginScope(ID3D11DeviceContext* deviceContext, const wchar_t* name) noexcept
+{
+    // Cheap early out for the common case of no profiler.
+    if (!Impl::s_profiler.load(std::memory_order_relaxed))
+        return false;
+
+    // Registering before loading the pointer again means ~Impl either sees this call or it sees nullptr.
+    ++Impl::s_activeCallers;
+
+    auto profiler = Impl::s_profiler.load();
+    bool result = profiler && profiler->BeginScope(deviceContext, name);
+
+    --Impl::s_activeCallers;
+
+    return result;
+}
+
+
+_Use_decl_annotations_
+void GpuProfiler::EndActiveScope(ID3D11DeviceContext* deviceContext) noexcept
+{
+    if (!Impl::s_profiler.load(std::memory_order_relaxed))
+        return;
+
+    ++Impl::s_activeCallers;
+
+    auto profiler = Impl::s_profiler.load();
+    if (profiler)
+        profiler->EndScope(deviceContext);
+
+    --Impl::s_activeCallers;
+}
+
+
+GpuProfiler& GpuProfiler::Get()
+{
+    auto profiler = Impl::s_profiler.load();
+    if (!profiler || !profiler->mOwner)
+        throw std::exception("GpuProfiler singleton not created");
+
+    return *profiler->mOwner;
+}
+
+
+bool GpuProfiler::IsCreated() noexcept
+{
+    auto profiler = Impl::s_profiler.load();
+    return profiler && profiler->mOwner;
+}
@@ -11,11 +11,38 @@
 
 #include "GraphicsMemory.h"
 #include "DirectXHelpers.h"
+#include "MemoryTracker.h"
 #include "PlatformHelpers.h"
 
+#include <atomic>
+#include <deque>
+
+// ID3D11Fence, whose completion can signal an event, needs the Windows 10 Creators Update SDK.
+#if (!defined(_XBOX_ONE) || !defined(_TITLE)) && (_WIN32_WINNT >= _WIN32_WINNT_WIN10) && defined(NTDDI_WIN10_RS2)
+#include <d3d11_4.h>
+#define GRAPHICS_MEMORY_USE_FENCE
+#endif
+
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
+namespace
+{
+    // Yields for the first few polls of the GPU, then sleeps, so a wait that has no event to block on does not
+    // keep a core busy for the whole time the GPU takes to catch up.
+    inline void BackOff(UINT attempt) noexcept
+    {
+        if (attempt < 16)
+        {
+            SwitchToThread();
+        }
+        else
+        {
+            Sleep(1);
+        }
+    }
+}
+
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
 
@@ -28,18 +55,32 @@ class GraphicsMemory::Impl
 public:
     Impl(GraphicsMemory* owner) :
         mOwner(owner),
-        mCurrentFrame(0)
+        mMaxFrameLatency(1),
+        mFramesInFlight(0),
+        mTargetWorkingSet(SIZE_MAX),
+        mGeneration(++s_generationCounter)
     {
         if (s_graphicsMemory)
         {
             throw std::exception("GraphicsMemory is a singleton");
         }
 
+        InitializeSListHead(&mFreePages);
+
+        std::lock_guard<std::mutex> lock(s_lifetimeGuard);
+
         s_graphicsMemory = this;
     }
 
     ~Impl()
     {
+        // Threads that exit from here on no longer hand their allocators back.
+        {
+            std::lock_guard<std::mutex> lock(s_lifetimeGuard);
+
+            s_graphicsMemory = nullptr;
+        }
+
         if (mDevice && mDeviceContext)
         {
             UINT64 finalFence = mDeviceContext->InsertFence(0);
@@ -53,7 +94,26 @@ public:
             mDevice.Reset();
         }
 
-        s_graphicsMemory = nullptr;
+        for (auto& frame : mFrames)
+        {
+            for (auto page : frame.mRetiredPages)
+            {
+                MemoryPage::Destroy(page);
+            }
+        }
+
+        for (auto& allocator : mThreadAllocators)
+        {
+            for (auto page : allocator->mUsedPages)
+            {
+                MemoryPage::Destroy(page);
+            }
+        }
+
+        while (auto entry = InterlockedPopEntrySList(&mFreePages))
+        {
+            MemoryPage::Destroy(reinterpret_cast<MemoryPage*>(entry));
+        }
     }
 
     void Initialize(_In_ ID3D11DeviceX* device, UINT backBufferCount)
@@ -63,162 +123,339 @@ public:
 
         device->GetImmediateContextX(mDeviceContext.GetAddressOf());
 
-        mFrames.resize(backBufferCount);
+        // Earlier versions kept a ring of backBufferCount frames, which allowed one fewer to be in flight.
+        mMaxFrameLatency = (backBufferCount > 0) ? backBufferCount - 1 : 0;
     }
 
     void* Allocate(_In_opt_ ID3D11DeviceContext* deviceContext, size_t size, int alignment)
     {
-        // Currently use a single global allocator instead of a per-context allocator
+        // Each thread owns a linear allocator, so recording on several deferred contexts at once does not contend.
         UNREFERENCED_PARAMETER(deviceContext);
 
-        std::lock_guard<std::mutex> lock(mGuard);
-
-        return mFrames[mCurrentFrame].Allocate(size, alignment);
+        return GetThreadAllocator().Allocate(size, static_cast<size_t>(alignment), &mFreePages);
     }
 
     void Commit()
     {
-        std::lock_guard<std::mutex> lock(mGuard);
+        MemoryFrame frame;
+
+        // Retire every page handed out since the last Commit, to be recycled once the GPU passes this fence.
+        {
+            std::lock_guard<std::mutex> lock(mGuard);
+
+            for (auto& allocator : mThreadAllocators)
+            {
+                allocator->Retire(frame.mRetiredPages);
+            }
+        }
+
+        // A fence that is waited on straight away must be kicked off, or the wait would never end.
+        frame.mFence = mDeviceContext->InsertFence(mMaxFrameLatency ? D3D11_INSERT_FENCE_NO_KICKOFF : 0);
+
+        mFrames.emplace_back(std::move(frame));
+
+        // Recycle the pages of every frame the GPU has finished, then wait for the oldest ones until few enough
+        // remain in flight.
+        while (!mFrames.empty() && !mDevice->IsFencePending(mFrames.front().mFence))
+        {
+            mFrames.front().Recycle(&mFreePages);
+            mFrames.pop_front();
+        }
 
-        mFrames[mCurrentFrame].mFence = mDeviceContext->InsertFence(D3D11_INSERT_FENCE_NO_KICKOFF);
+        mFramesInFlight = static_cast<UINT>(mFrames.size());
 
-        ++mCurrentFrame;
-        if (mCurrentFrame >= mFrames.size())
+        while (mFrames.size() > mMaxFrameLatency)
         {
-            mCurrentFrame = 0;
+            mFrames.front().WaitOnFence(mDevice.Get());
+            mFrames.front().Recycle(&mFreePages);
+            mFrames.pop_front();
         }
 
-        mFrames[mCurrentFrame].WaitOnFence(mDevice.Get());
+        // Release free pages until the working set is back down to the target.
+        while (s_pageBytes > mTargetWorkingSet)
+        {
+            auto entry = InterlockedPopEntrySList(&mFreePages);
+            if (!entry)
+                break;
+
+            MemoryPage::Destroy(reinterpret_cast<MemoryPage*>(entry));
+        }
 
-        mFrames[mCurrentFrame].Clear();
+        MemoryTracker::EndFrame();
+    }
+
+    size_t GetWorkingSet() const noexcept
+    {
+        return s_pageBytes;
     }
 
     GraphicsMemory*  mOwner;
 
+    // Only guards registration and recycling of thread allocators; Allocate itself takes no locks.
     std::mutex mGuard;
 
-    struct MemoryPage
+    static const size_t StandardPageSize = 0x100000; // 1 MB general pages for Xbox One
+
+    // Pages of standard size are recycled through a lock-free SLIST, which requires entries to be aligned.
+    struct DECLSPEC_ALIGN(MEMORY_ALLOCATION_ALIGNMENT) MemoryPage
     {
-        MemoryPage() noexcept : mPageSize(0), mGrfxMemory(nullptr) {}
+        SLIST_ENTRY mListEntry;
+        size_t mPageSize;
+        void* mGrfxMemory;
+        uint64_t mTrackingHandle;
 
-        void Initialize(size_t reqSize)
+        static MemoryPage* Create(size_t reqSize)
         {
-            mPageSize = 0x100000; // 1 MB general pages for Xbox One
-            if (mPageSize < reqSize)
+            size_t pageSize = StandardPageSize;
+            if (pageSize < reqSize)
             {
-                mPageSize = AlignUp(reqSize, 65536);
+                pageSize = AlignUp(reqSize, 65536);
             }
 
-            mGrfxMemory = VirtualAlloc(nullptr, mPageSize,
-                                       MEM_LARGE_PAGES | MEM_GRAPHICS | MEM_RESERVE | MEM_COMMIT,
-                                       PAGE_WRITECOMBINE | PAGE_READWRITE | PAGE_GPU_READONLY);
-            if (!mGrfxMemory)
-                throw  std::bad_alloc();
+            auto page = static_cast<MemoryPage*>(_aligned_malloc(sizeof(MemoryPage), MEMORY_ALLOCATION_ALIGNMENT));
+            if (!page)
+                throw std::bad_alloc();
+
+            page->mPageSize = pageSize;
+            page->mGrfxMemory = VirtualAlloc(nullptr, pageSize,
+                                             MEM_LARGE_PAGES | MEM_GRAPHICS | MEM_RESERVE | MEM_COMMIT,
+                                             PAGE_WRITECOMBINE | PAGE_READWRITE | PAGE_GPU_READONLY);
+            if (!page->mGrfxMemory)
+            {
+                _aligned_free(page);
+                throw std::bad_alloc();
+            }
+
+            page->mTrackingHandle = MemoryTracker::TrackAllocation(MemoryCategory_Upload, pageSize, L"GraphicsMemory");
+
+            s_pageBytes += pageSize;
+
+            return page;
         }
 
-        size_t mPageSize;
-        void* mGrfxMemory;
+        static void Destroy(_In_ MemoryPage* page) noexcept
+        {
+            s_pageBytes -= page->mPageSize;
+
+            MemoryTracker::ReleaseAllocation(page->mTrackingHandle);
+
+            VirtualFree(page->mGrfxMemory, 0, MEM_RELEASE);
+            _aligned_free(page);
+        }
     };
 
-    struct MemoryFrame
-    {
-        MemoryFrame() noexcept : mCurOffset(0), mFence(0) {}
+    static_assert(offsetof(MemoryPage, mListEntry) == 0, "SLIST entry must come first");
 
-        ~MemoryFrame() { Clear(); }
+    // Linear allocator used by a single thread.
+    struct ThreadAllocator
+    {
+        ThreadAllocator() noexcept : mCurrentPage(nullptr), mCurOffset(0) {}
 
-        UINT mCurOffset;
+        MemoryPage* mCurrentPage;
+        size_t mCurOffset;
 
-        UINT64 mFence;
+        // Pages this thread has handed out since the last Commit, including the current one.
+        std::vector<MemoryPage*> mUsedPages;
 
-        void* Allocate(size_t size, size_t alignment)
+        void* Allocate(size_t size, size_t alignment, _Inout_ PSLIST_HEADER freePages)
         {
             size_t alignedSize = AlignUp(size, alignment);
 
-            if (mPages.empty())
+            MemoryTracker::AddFrameUsage(MemoryCategory_Upload, alignedSize);
+
+            if (mCurrentPage)
             {
-                MemoryPage newPage;
-                newPage.Initialize(alignedSize);
+                size_t offset = AlignUp(mCurOffset, alignment);
 
-                mCurOffset = 0;
+                if (offset + alignedSize <= mCurrentPage->mPageSize)
+                {
+                    mCurOffset = offset + alignedSize;
 
-                mPages.emplace_back(newPage);
+                    return static_cast<uint8_t*>(mCurrentPage->mGrfxMemory) + offset;
+                }
             }
-            else
-            {
-                mCurOffset = AlignUp(mCurOffset, alignment);
 
-                if (mCurOffset + alignedSize > mPages.front().mPageSize)
-                {
-                    MemoryPage newPage;
-                    newPage.Initialize(alignedSize);
+            MemoryPage* page = nullptr;
 
-                    mCurOffset = 0;
+            if (alignedSize <= StandardPageSize)
+            {
+                page = reinterpret_cast<MemoryPage*>(InterlockedPopEntrySList(freePages));
+            }
 
-                    mPages.emplace_front(newPage);
-                }
+            if (!page)
+            {
+                page = MemoryPage::Create(alignedSize);
             }
 
-            void* ptr = static_cast<uint8_t*>(mPages.front().mGrfxMemory) + mCurOffset;
+            mUsedPages.push_back(page);
+
+            mCurrentPage = page;
+            mCurOffset = alignedSize;
+
+            return page->mGrfxMemory;
+        }
 
-            mCurOffset += static_cast<UINT>(alignedSize);
+        void Retire(std::vector<MemoryPage*>& retiredPages)
+        {
+            retiredPages.insert(retiredPages.end(), mUsedPages.begin(), mUsedPages.end());
 
-            return ptr;
+            mUsedPages.clear();
+            mCurrentPage = nullptr;
+            mCurOffset = 0;
         }
+    };
+
+    struct MemoryFrame
+    {
+        MemoryFrame() noexcept : mFence(0) {}
+
+        UINT64 mFence;
+
+        std::vector<MemoryPage*> mRetiredPages;
 
+        // D3D11.x fences have no event to wait on, so this polls with a back-off.
         void WaitOnFence(ID3D11DeviceX* device)
         {
             if (mFence)
             {
-                while (device->IsFencePending(mFence))
+                for (UINT attempt = 0; device->IsFencePending(mFence); ++attempt)
                 {
-                    SwitchToThread();
+                    BackOff(attempt);
                 }
 
                 mFence = 0;
             }
         }
 
-        void Clear()
+        // Returns pages the GPU has finished with to the free list, releasing any oversized ones.
+        void Recycle(_Inout_ PSLIST_HEADER freePages)
         {
-            for (auto it = mPages.begin(); it != mPages.end(); ++it)
+            for (auto page : mRetiredPages)
             {
-                if (it->mGrfxMemory)
+                if (page->mPageSize == StandardPageSize)
+                {
+                    InterlockedPushEntrySList(freePages, &page->mListEntry);
+                }
+                else
                 {
-                    VirtualFree(it->mGrfxMemory, 0, MEM_RELEASE);
-                    it->mGrfxMemory = nullptr;
+                    MemoryPage::Destroy(page);
                 }
             }
 
-            mPages.clear();
+            mRetiredPages.clear();
+        }
+    };
+
+    // Thread-local handle on an allocator, which hands it back to the idle list when its thread exits.
+    struct ThreadAllocatorLease
+    {
+        ThreadAllocatorLease() noexcept : mAllocator(nullptr), mGeneration(0) {}
 
-            mCurOffset = 0;
+        ThreadAllocatorLease(ThreadAllocatorLease const&) = delete;
+        ThreadAllocatorLease& operator= (ThreadAllocatorLease const&) = delete;
+
+        ~ThreadAllocatorLease()
+        {
+            if (!mAllocator)
+                return;
+
+            std::lock_guard<std::mutex> lifetimeLock(s_lifetimeGuard);
+
+            // An allocator from an earlier instance was freed along with it.
+            auto impl = s_graphicsMemory;
+            if (impl && impl->mGeneration == mGeneration)
+            {
+                std::lock_guard<std::mutex> lock(impl->mGuard);
+
+                impl->mIdleAllocators.push_back(mAllocator);
+            }
         }
 
-        std::list<MemoryPage> mPages;
+        ThreadAllocator* mAllocator;
+        uint32_t mGeneration;
     };
 
-    UINT mCurrentFrame;
-    std::vector<MemoryFrame> mFrames;
+    // Looks up the calling thread's allocator. The first time a thread allocates, it takes one left behind by an
+    // exited thread, or registers a new one.
+    ThreadAllocator& GetThreadAllocator()
+    {
+        thread_local ThreadAllocatorLease s_lease;
+
+        if (!s_lease.mAllocator || s_lease.mGeneration != mGeneration)
+        {
+            std::lock_guard<std::mutex> lock(mGuard);
+
+            if (!mIdleAllocators.empty())
+            {
+                s_lease.mAllocator = mIdleAllocators.back();
+                mIdleAllocators.pop_back();
+            }
+            else
+            {
+                mThreadAllocators.emplace_back(std::make_unique<ThreadAllocator>());
+
+                s_lease.mAllocator = mThreadAllocators.back().get();
+            }
+
+            s_lease.mGeneration = mGeneration;
+        }
+
+        return *s_lease.mAllocator;
+    }
+
+    // Frames committed that the GPU may not have finished, oldest first.
+    std::deque<MemoryFrame> mFrames;
+
+    UINT mMaxFrameLatency;
+    UINT mFramesInFlight;
+    size_t mTargetWorkingSet;
+
+    std::vector<std::unique_ptr<ThreadAllocator>> mThreadAllocators;
+
+    // Allocators whose threads have exited, ready for the next new thread. Their pages stay in use until the
+    // next Commit retires them as usual.
+    std::vector<ThreadAllocator*> mIdleAllocators;
+
+    DECLSPEC_ALIGN(MEMORY_ALLOCATION_ALIGNMENT) SLIST_HEADER mFreePages;
+
+    // Distinguishes this instance from earlier ones, so stale thread-local allocator pointers are not reused.
+    uint32_t mGeneration;
 
     ComPtr<ID3D11DeviceX> mDevice;
     ComPtr<ID3D11DeviceContextX> mDeviceContext;
 
     static GraphicsMemory::Impl* s_graphicsMemory;
+    static std::atomic<uint32_t> s_generationCounter;
+
+    // Orders setting and clearing s_graphicsMemory against exiting threads handing back their allocators.
+    static std::mutex s_lifetimeGuard;
+
+    // Total size of every page, whether free, in use, or waiting on the GPU.
+    static std::atomic<size_t> s_pageBytes;
 };
 
+std::atomic<uint32_t> GraphicsMemory::Impl::s_generationCounter(0);
+std::atomic<size_t> GraphicsMemory::Impl::s_pageBytes(0);
 GraphicsMemory::Impl* GraphicsMemory::Impl::s_graphicsMemory = nullptr;
+std::mutex GraphicsMemory::Impl::s_lifetimeGuard;
 
 #else
 
 //======================================================================================
-// Null allocator for standard Direct3D
+// Dynamic upload rings for standard Direct3D
 //======================================================================================
 
 class GraphicsMemory::Impl
 {
 public:
     Impl(GraphicsMemory* owner) :
-        mOwner(owner)
+        mOwner(owner),
+        mMaxFrameLatency(3),
+        mFramesInFlight(0),
+        mTargetWorkingSet(SIZE_MAX),
+        mFrameNumber(0),
+        mConstantUploadSupported(false),
+        mFenceValue(0)
     {
         if (s_graphicsMemory)
         {
@@ -233,10 +470,40 @@ public:
         s_graphicsMemory = nullptr;
     }
 
-    void Initialize(_In_ ID3D11Device* device, UINT backBufferCount) noexcept
+    void Initialize(_In_ ID3D11Device* device, UINT backBufferCount)
     {
-        UNREFERENCED_PARAMETER(device);
         UNREFERENCED_PARAMETER(backBufferCount);
+
+        assert(device != nullptr);
+        mDevice = device;
+
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+
+        if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+        {
+            mConstantUploadSupported = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+        }
+
+        device->GetImmediateContext(mDeviceContext.GetAddressOf());
+
+    #if defined(GRAPHICS_MEMORY_USE_FENCE)
+        // Frames are marked with a fence where the device has them, so waits can block on an event.
+        ComPtr<ID3D11Device5> device5;
+        if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(device5.GetAddressOf())))
+            && SUCCEEDED(mDeviceContext.As(&mDeviceContext4))
+            && SUCCEEDED(device5->CreateFence(0, D3D11_FENCE_FLAG_NONE, IID_PPV_ARGS(mFence.GetAddressOf()))))
+        {
+            mFenceEvent.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+            if (!mFenceEvent)
+            {
+                throw std::exception("CreateEventEx");
+            }
+        }
+        else
+        {
+            mDeviceContext4.Reset();
+        }
+    #endif
     }
 
     void* Allocate(_In_opt_ ID3D11DeviceContext* context, size_t size, int alignment) noexcept
@@ -247,12 +514,386 @@ public:
         return nullptr;
     }
 
-    void Commit() noexcept
+    void Commit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mGuard);
+
+            for (auto& it : mContextRings)
+            {
+                it.second->geometry.position = 0;
+                it.second->constants.position = 0;
+            }
+
+            TrimRings();
+
+            ++mFrameNumber;
+        }
+
+        // Mark the end of the frame, count the frames the GPU has not finished, then wait for the oldest ones
+        // until few enough remain in flight.
+        mFrames.emplace_back(EndFrame());
+
+        while (!mFrames.empty() && IsFrameComplete(mFrames.front()))
+        {
+            RetireFrame();
+        }
+
+        mFramesInFlight = static_cast<UINT>(mFrames.size());
+
+        while (mFrames.size() > mMaxFrameLatency)
+        {
+            WaitForFrame(mFrames.front());
+            RetireFrame();
+        }
+
+        MemoryTracker::EndFrame();
+    }
+
+    size_t GetWorkingSet() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mGuard);
+
+        size_t total = 0;
+
+        for (auto& it : mContextRings)
+        {
+            total += it.second->geometry.size + it.second->constants.size;
+        }
+
+        return total;
+    }
+
+    void* MapUpload(_In_ ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag, size_t size, int alignment, _Outptr_ ID3D11Buffer** buffer, _Out_ UINT* offset)
+    {
+        if (!context || !buffer || !offset)
+            throw std::exception("Invalid arguments");
+
+        auto& ring = GetRing(context, bindFlag);
+
+        if (ring.mapped)
+            throw std::exception("Upload ring is already mapped");
+
+        if (bindFlag == D3D11_BIND_CONSTANT_BUFFER && alignment < ConstantAlignment)
+        {
+            // *SetConstantBuffers1 offsets are counted in whole 16-constant (256 byte) blocks.
+            alignment = ConstantAlignment;
+        }
+
+        if (alignment <= 0 || (alignment & (alignment - 1)) != 0)
+            throw std::exception("Alignment must be a power of 2");
+
+        size_t alignedSize = AlignUp(size, static_cast<size_t>(alignment));
+
+        if (!alignedSize || alignedSize > ring.size)
+            throw std::out_of_range("Upload size out of range");
+
+        size_t position = AlignUp(ring.position, static_cast<size_t>(alignment));
+
+        // Wrapping uses WRITE_DISCARD, so the driver renames the buffer instead of waiting for the GPU.
+        D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+
+        if (!ring.position || position + alignedSize > ring.size)
+        {
+            position = 0;
+            mapType = D3D11_MAP_WRITE_DISCARD;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        ThrowIfFailed(context->Map(ring.buffer.Get(), 0, mapType, 0, &mapped));
+
+        ring.mapped = true;
+        ring.position = position + alignedSize;
+
+        MemoryTracker::AddFrameUsage(MemoryCategory_Upload, alignedSize);
+
+        *buffer = ring.buffer.Get();
+        *offset = static_cast<UINT>(position);
+
+        return static_cast<uint8_t*>(mapped.pData) + position;
+    }
+
+    void UnmapUpload(_In_ ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag)
     {
+        auto& ring = GetRing(context, bindFlag);
+
+        if (!ring.mapped)
+            throw std::exception("Upload ring is not mapped");
+
+        context->Unmap(ring.buffer.Get(), 0);
+
+        ring.mapped = false;
+    }
+
+    void ResetUploads(_In_ ID3D11DeviceContext* context)
+    {
+        std::lock_guard<std::mutex> lock(mGuard);
+
+        auto it = mContextRings.find(context);
+
+        if (it != mContextRings.end())
+        {
+            it->second->geometry.position = 0;
+            it->second->constants.position = 0;
+        }
     }
 
     GraphicsMemory*  mOwner;
 
+    static const size_t GeometryRingSize = 4 * 1024 * 1024;
+    static const size_t ConstantRingSize = 1024 * 1024;
+    static const int ConstantAlignment = 256;
+
+    // One dynamic buffer, written front to back and discarded when it wraps.
+    struct UploadRing
+    {
+        UploadRing() noexcept : size(0), position(0), mapped(false) {}
+
+        ComPtr<ID3D11Buffer> buffer;
+        size_t size;
+        size_t position;
+        bool mapped;
+    };
+
+    // Dynamic buffers cannot combine the constant buffer bind flag with others, so each context has two rings.
+    struct ContextRings
+    {
+        ContextRings() noexcept : lastUsedFrame(0) {}
+
+        ComPtr<ID3D11DeviceContext> context;
+        UploadRing geometry;
+        UploadRing constants;
+        uint64_t lastUsedFrame;
+    };
+
+    // The end of a committed frame: a fence value, or an event query where the device has no fences.
+    struct FrameMarker
+    {
+        FrameMarker() noexcept : fenceValue(0) {}
+
+        UINT64 fenceValue;
+        ComPtr<ID3D11Query> query;
+    };
+
+    FrameMarker EndFrame()
+    {
+        FrameMarker frame;
+
+    #if defined(GRAPHICS_MEMORY_USE_FENCE)
+        if (mFence)
+        {
+            frame.fenceValue = ++mFenceValue;
+            ThrowIfFailed(mDeviceContext4->Signal(mFence.Get(), frame.fenceValue));
+            return frame;
+        }
+    #endif
+
+        if (!mFreeQueries.empty())
+        {
+            frame.query.Swap(mFreeQueries.back());
+            mFreeQueries.pop_back();
+        }
+        else
+        {
+            D3D11_QUERY_DESC desc = {};
+            desc.Query = D3D11_QUERY_EVENT;
+
+            ThrowIfFailed(mDevice->CreateQuery(&desc, frame.query.GetAddressOf()));
+
+            SetDebugObjectName(frame.query.Get(), "DirectXTK:GraphicsMemory");
+        }
+
+        mDeviceContext->End(frame.query.Get());
+
+        return frame;
+    }
+
+    bool IsFrameComplete(FrameMarker const& frame, UINT getDataFlags = D3D11_ASYNC_GETDATA_DONOTFLUSH) const
+    {
+    #if defined(GRAPHICS_MEMORY_USE_FENCE)
+        if (!frame.query)
+        {
+            // Reports UINT64_MAX once the device is removed, so this never waits on a lost device.
+            return mFence->GetCompletedValue() >= frame.fenceValue;
+        }
+    #endif
+
+        BOOL done = FALSE;
+        HRESULT hr = mDeviceContext->GetData(frame.query.Get(), &done, sizeof(done), getDataFlags);
+
+        // Any failure, such as device removal, means there is nothing left to wait for.
+        return (hr != S_FALSE);
+    }
+
+    void WaitForFrame(FrameMarker const& frame)
+    {
+    #if defined(GRAPHICS_MEMORY_USE_FENCE)
+        if (!frame.query)
+        {
+            if (mFence->GetCompletedValue() < frame.fenceValue)
+            {
+                ThrowIfFailed(mFence->SetEventOnCompletion(frame.fenceValue, mFenceEvent.get()));
+
+                // The signal may not have been submitted yet.
+                mDeviceContext->Flush();
+
+                (void)WaitForSingleObjectEx(mFenceEvent.get(), INFINITE, FALSE);
+            }
+            return;
+        }
+    #endif
+
+        // Event queries have nothing to block on. The first poll flushes, so the query is sure to be submitted.
+        if (IsFrameComplete(frame, 0))
+            return;
+
+        for (UINT attempt = 0; !IsFrameComplete(frame); ++attempt)
+        {
+            BackOff(attempt);
+        }
+    }
+
+    void RetireFrame()
+    {
+        auto& frame = mFrames.front();
+
+        if (frame.query)
+        {
+            mFreeQueries.emplace_back(std::move(frame.query));
+        }
+
+        mFrames.pop_front();
+    }
+
+    // Releases the rings of contexts that did not upload during the frame, least recently used first, until the
+    // working set is no more than the target. Called with the lock held.
+    void TrimRings()
+    {
+        if (mTargetWorkingSet == SIZE_MAX)
+            return;
+
+        size_t total = 0;
+        std::vector<std::pair<uint64_t, ID3D11DeviceContext*>> idle;
+
+        for (auto& it : mContextRings)
+        {
+            auto& rings = *it.second;
+
+            total += rings.geometry.size + rings.constants.size;
+
+            if (rings.lastUsedFrame < mFrameNumber && !rings.geometry.mapped && !rings.constants.mapped)
+            {
+                idle.emplace_back(rings.lastUsedFrame, it.first);
+            }
+        }
+
+        if (total <= mTargetWorkingSet)
+            return;
+
+        std::sort(idle.begin(), idle.end());
+
+        for (auto& candidate : idle)
+        {
+            if (total <= mTargetWorkingSet)
+                break;
+
+            auto it = mContextRings.find(candidate.second);
+
+            total -= it->second->geometry.size + it->second->constants.size;
+
+            mContextRings.erase(it);
+        }
+    }
+
+    // Finds or creates the requested ring for a context.
+    UploadRing& GetRing(_In_ ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag)
+    {
+        if (bindFlag != D3D11_BIND_VERTEX_BUFFER && bindFlag != D3D11_BIND_INDEX_BUFFER && bindFlag != D3D11_BIND_CONSTANT_BUFFER)
+            throw std::exception("Upload rings support vertex, index, or constant buffers");
+
+        ContextRings* rings;
+
+        {
+            std::lock_guard<std::mutex> lock(mGuard);
+
+            auto& entry = mContextRings[context];
+
+            if (!entry)
+            {
+                entry = std::make_unique<ContextRings>();
+                entry->context = context;
+            }
+
+            entry->lastUsedFrame = mFrameNumber;
+
+            rings = entry.get();
+        }
+
+        if (bindFlag == D3D11_BIND_CONSTANT_BUFFER)
+        {
+            if (!rings->constants.buffer)
+            {
+                if (!mConstantUploadSupported)
+                    throw std::exception("Constant upload requires Direct3D 11.1 constant buffer offsetting");
+
+                CreateRing(rings->constants, ConstantRingSize, D3D11_BIND_CONSTANT_BUFFER);
+            }
+
+            return rings->constants;
+        }
+
+        if (!rings->geometry.buffer)
+        {
+            CreateRing(rings->geometry, GeometryRingSize, D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER);
+        }
+
+        return rings->geometry;
+    }
+
+    void CreateRing(UploadRing& ring, size_t size, UINT bindFlags)
+    {
+        D3D11_BUFFER_DESC desc = {};
+
+        desc.ByteWidth = static_cast<UINT>(size);
+        desc.BindFlags = bindFlags;
+        desc.Usage = D3D11_USAGE_DYNAMIC;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        ThrowIfFailed(mDevice->CreateBuffer(&desc, nullptr, ring.buffer.ReleaseAndGetAddressOf()));
+
+        SetDebugObjectName(ring.buffer.Get(), "DirectXTK:GraphicsMemory");
+
+        MemoryTracker::TrackResource(ring.buffer.Get(), MemoryCategory_Upload, L"GraphicsMemory");
+
+        ring.size = size;
+        ring.position = 0;
+        ring.mapped = false;
+    }
+
+    std::mutex mGuard;
+
+    UINT mMaxFrameLatency;
+    UINT mFramesInFlight;
+    size_t mTargetWorkingSet;
+    uint64_t mFrameNumber;
+
+    ComPtr<ID3D11Device> mDevice;
+    ComPtr<ID3D11DeviceContext> mDeviceContext;
+    bool mConstantUploadSupported;
+
+    std::map<ID3D11DeviceContext*, std::unique_ptr<ContextRings>> mContextRings;
+
+    // Frames committed that the GPU may not have finished, oldest first.
+    std::deque<FrameMarker> mFrames;
+    std::vector<ComPtr<ID3D11Query>> mFreeQueries;
+
+#if defined(GRAPHICS_MEMORY_USE_FENCE)
+    ComPtr<ID3D11DeviceContext4> mDeviceContext4;
+    ComPtr<ID3D11Fence> mFence;
+    ScopedHandle mFenceEvent;
+#endif
+    UINT64 mFenceValue;
+
     static GraphicsMemory::Impl* s_graphicsMemory;
 };
 
@@ -312,6 +953,65 @@ void GraphicsMemory::Commit()
 }
 
 
+void GraphicsMemory::SetMaximumFrameLatency(UINT maxFrameLatency) noexcept
+{
+    pImpl->mMaxFrameLatency = maxFrameLatency;
+}
+
+
+UINT GraphicsMemory::GetMaximumFrameLatency() const noexcept
+{
+    return pImpl->mMaxFrameLatency;
+}
+
+
+UINT GraphicsMemory::GetFramesInFlight() const noexcept
+{
+    return pImpl->mFramesInFlight;
+}
+
+
+void GraphicsMemory::SetTargetWorkingSet(size_t bytes) noexcept
+{
+    pImpl->mTargetWorkingSet = bytes;
+}
+
+
+size_t GraphicsMemory::GetWorkingSet() const noexcept
+{
+    return pImpl->GetWorkingSet();
+}
+
+
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+_Use_decl_annotations_
+void* GraphicsMemory::MapUpload(ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag, size_t size, int alignment, ID3D11Buffer** buffer, UINT* offset)
+{
+    return pImpl->MapUpload(context, bindFlag, size, alignment, buffer, offset);
+}
+
+
+_Use_decl_annotations_
+void GraphicsMemory::UnmapUpload(ID3D11DeviceContext* context, D3D11_BIND_FLAG bindFlag)
+{
+    pImpl->UnmapUpload(context, bindFlag);
+}
+
+
+_Use_decl_annotations_
+void GraphicsMemory::ResetUploads(ID3D11DeviceContext* context)
+{
+    pImpl->ResetUploads(context);
+}
+
+
+bool GraphicsMemory::IsConstantUploadSupported() const noexcept
+{
+    return pImpl->mConstantUploadSupported;
+}
+#endif
+
+
 GraphicsMemory& GraphicsMemory::Get()
 {
     if (!Impl::s_graphicsMemory || !Impl::s_graphicsMemory->mOwner)
@@ -319,3 +1019,9 @@ GraphicsMemory& GraphicsMemory::Get()
 
     return *Impl::s_graphicsMemory->mOwner;
 }
+
+
+bool GraphicsMemory::IsCreated() noexcept
+{
+    return Impl::s_graphicsMemory && Impl::s_graphicsMemory->mOwner;
+}
@@ -0,0 +1,720 @@
+//--------------------------------------------------------------------------------------
+// File: IBLBaker.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "IBLBaker.h"
+
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "GpuProfiler.h"
+#include "MemoryTracker.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneIBLBaker_CSCopySource.inc"
+    #include "Shaders/Compiled/XboxOneIBLBaker_CSPrefilterSpecular.inc"
+    #include "Shaders/Compiled/XboxOneIBLBaker_CSIrradiance.inc"
+#else
+    #include "Shaders/Compiled/IBLBaker_CSCopySource.inc"
+    #include "Shaders/Compiled/IBLBaker_CSPrefilterSpecular.inc"
+    #include "Shaders/Compiled/IBLBaker_CSIrradiance.inc"
+#endif
+
+    // Must match the shader!
+    const UINT GroupSize = 8;
+
+    // Constant buffer layout. Must match the shader!
+    struct BakeConstants
+    {
+        uint32_t outputSize;
+        uint32_t firstFace;
+        uint32_t firstRow;
+        uint32_t sampleCount;
+        float roughness;
+        float sourceSize;
+        float sourceMipLevels;
+        float sourceLod;
+    };
+
+    static_assert((sizeof(BakeConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Work items are split into bands of rows of about this many samples, which sets how finely a budget is kept.
+    const double SamplesPerItem = 256.0 * 1024.0;
+
+    // Starting guess at GPU cost, until timestamps come back.
+    const double InitialMillisecondsPerSample = 1e-6;
+
+    const size_t TimingQueryCount = 4;
+
+    // Filtered source the prefilters sample from, in a format that can be written, mipmapped and filtered everywhere.
+    const DXGI_FORMAT SourceFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+    enum WorkKind
+    {
+        WORK_COPY_SOURCE,       // Environment into the top of the filtered source
+        WORK_GENERATE_MIPS,     // Rest of the filtered source
+        WORK_RADIANCE,          // One band of a radiance mip; mip 0 is an unfiltered copy
+        WORK_IRRADIANCE,
+    };
+
+    struct WorkItem
+    {
+        WorkKind kind;
+        UINT mip;
+        UINT face;
+        UINT firstRow;
+        UINT rowCount;
+        UINT sampleCount;       // Per texel, fixed when the bake begins
+        double cost;            // In samples
+    };
+
+    UINT CountMips(UINT size) noexcept
+    {
+        UINT mips = 1;
+
+        while (size > 1)
+        {
+            size >>= 1;
+            ++mips;
+        }
+
+        return mips;
+    }
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mMutex{}
+        { }
+
+        ID3D11ComputeShader* GetShader(WorkKind kind)
+        {
+            switch (kind)
+            {
+                case WORK_RADIANCE:
+                    return DemandCreateShader(mPrefilterSpecular, IBLBaker_CSPrefilterSpecular, sizeof(IBLBaker_CSPrefilterSpecular));
+
+                case WORK_IRRADIANCE:
+                    return DemandCreateShader(mIrradiance, IBLBaker_CSIrradiance, sizeof(IBLBaker_CSIrradiance));
+
+                default:
+                    return DemandCreateShader(mCopySource, IBLBaker_CSCopySource, sizeof(IBLBaker_CSCopySource));
+            }
+        }
+
+    private:
+        ID3D11ComputeShader* DemandCreateShader(ComPtr<ID3D11ComputeShader>& shader, void const* bytecode, size_t length)
+        {
+            return DemandCreate(shader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(bytecode, length, nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "IBLBaker");
+
+                return hr;
+            });
+        }
+
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11ComputeShader> mCopySource;
+        ComPtr<ID3D11ComputeShader> mPrefilterSpecular;
+        ComPtr<ID3D11ComputeShader> mIrradiance;
+        std::mutex mMutex;
+    };
+}
+
+
+// Internal IBLBaker implementation class.
+class IBLBaker::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, unsigned int radianceSize, unsigned int irradianceSize, DXGI_FORMAT format);
+
+    void Begin(_In_ ID3D11ShaderResourceView* environment);
+    bool Process(_In_ ID3D11DeviceContext* deviceContext, float budgetMilliseconds);
+
+    bool IsBaking() const noexcept { return mNextItem < mItems.size(); }
+
+    float GetProgress() const noexcept
+    {
+        if (mItems.empty())
+            return 1.f;
+
+        return float(mIssuedCost / mTotalCost);
+    }
+
+    // The radiance and irradiance cubemaps for one side of the double buffer.
+    struct Targets
+    {
+        ComPtr<ID3D11Texture2D>                         radiance;
+        ComPtr<ID3D11ShaderResourceView>                radianceSRV;
+        std::vector<ComPtr<ID3D11UnorderedAccessView>>  radianceUAVs;   // One per mip
+
+        ComPtr<ID3D11Texture2D>                         irradiance;
+        ComPtr<ID3D11ShaderResourceView>                irradianceSRV;
+        ComPtr<ID3D11UnorderedAccessView>               irradianceUAV;
+    };
+
+    Targets                             targets[2];
+    size_t                              front;
+    uint64_t                            generation;
+
+    UINT                                radianceMips;
+    UINT                                specularSamples;
+    UINT                                irradianceSamples;
+
+private:
+    struct TimingQuery
+    {
+        ComPtr<ID3D11Query> disjoint;
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+        double              cost;
+        bool                pending;
+    };
+
+    void CreateTargets(Targets& result);
+    void AddItems(WorkKind kind, UINT mip, UINT size, UINT samplesPerTexel);
+    void Execute(_In_ ID3D11DeviceContext* deviceContext, WorkItem const& item);
+    void SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, BakeConstants const& value);
+    void ReadTimings(_In_ ID3D11DeviceContext* deviceContext);
+
+    ComPtr<ID3D11Device>                mDevice;
+
+    UINT                                mRadianceSize;
+    UINT                                mIrradianceSize;
+    DXGI_FORMAT                         mFormat;
+
+    ComPtr<ID3D11Texture2D>             mSource;
+    ComPtr<ID3D11ShaderResourceView>    mSourceSRV;
+    ComPtr<ID3D11UnorderedAccessView>   mSourceUAV;
+
+    ComPtr<ID3D11SamplerState>          mSampler;
+
+    // The bake in progress.
+    ComPtr<ID3D11ShaderResourceView>    mEnvironment;
+    float                               mEnvironmentLod;
+
+    std::vector<WorkItem>               mItems;
+    size_t                              mNextItem;
+    double                              mIssuedCost;
+    double                              mTotalCost;
+
+    TimingQuery                         mQueries[TimingQueryCount];
+    double                              mMillisecondsPerSample;
+
+    ConstantBuffer<BakeConstants>       mConstantBuffer;
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>    mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device IBLBaker resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> IBLBaker::Impl::deviceResourcesPool;
+
+
+// Constructor.
+IBLBaker::Impl::Impl(_In_ ID3D11Device* device, unsigned int radianceSize, unsigned int irradianceSize, DXGI_FORMAT format)
+    : front(0),
+    generation(0),
+    radianceMips(CountMips(radianceSize)),
+    specularSamples(64),
+    irradianceSamples(256),
+    mDevice(device),
+    mRadianceSize(radianceSize),
+    mIrradianceSize(irradianceSize),
+    mFormat(format),
+    mEnvironmentLod(0),
+    mNextItem(0),
+    mIssuedCost(0),
+    mTotalCost(0),
+    mQueries{},
+    mMillisecondsPerSample(InitialMillisecondsPerSample),
+    mConstantBuffer(device),
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("IBLBaker requires Feature Level 11.0 or later");
+    }
+
+    if (!radianceSize || !irradianceSize
+        || radianceSize > D3D11_REQ_TEXTURECUBE_DIMENSION || irradianceSize > D3D11_REQ_TEXTURECUBE_DIMENSION)
+    {
+        throw std::invalid_argument("Invalid IBLBaker cubemap size");
+    }
+
+    UINT support = 0;
+    if (FAILED(device->CheckFormatSupport(format, &support))
+        || !(support & D3D11_FORMAT_SUPPORT_TEXTURECUBE)
+        || !(support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW))
+    {
+        DebugTrace("ERROR: IBLBaker needs a cubemap format with typed UAV stores (format %u)\n", format);
+        throw std::invalid_argument("Format not supported by IBLBaker");
+    }
+
+    // Filtered source, written at the top and then mipmapped.
+    {
+        CD3D11_TEXTURE2D_DESC desc(SourceFormat, radianceSize, radianceSize, 6, 0,
+            D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET, D3D11_USAGE_DEFAULT, 0, 1, 0,
+            D3D11_RESOURCE_MISC_TEXTURECUBE | D3D11_RESOURCE_MISC_GENERATE_MIPS);
+
+        ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, mSource.GetAddressOf()));
+
+        SetDebugObjectName(mSource.Get(), "IBLBaker");
+
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURECUBE, SourceFormat);
+        ThrowIfFailed(device->CreateShaderResourceView(mSource.Get(), &srvDesc, mSourceSRV.GetAddressOf()));
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_TEXTURE2DARRAY, SourceFormat, 0, 0, 6);
+        ThrowIfFailed(device->CreateUnorderedAccessView(mSource.Get(), &uavDesc, mSourceUAV.GetAddressOf()));
+
+        MemoryTracker::TrackResource(mSource.Get(), MemoryCategory_Texture, L"IBLBaker");
+    }
+
+    CreateTargets(targets[0]);
+    CreateTargets(targets[1]);
+
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    ThrowIfFailed(device->CreateSamplerState(&samplerDesc, mSampler.GetAddressOf()));
+
+    SetDebugObjectName(mSampler.Get(), "IBLBaker");
+
+    for (auto& query : mQueries)
+    {
+        CD3D11_QUERY_DESC disjointDesc(D3D11_QUERY_TIMESTAMP_DISJOINT);
+        CD3D11_QUERY_DESC timestampDesc(D3D11_QUERY_TIMESTAMP);
+
+        ThrowIfFailed(device->CreateQuery(&disjointDesc, query.disjoint.GetAddressOf()));
+        ThrowIfFailed(device->CreateQuery(&timestampDesc, query.begin.GetAddressOf()));
+        ThrowIfFailed(device->CreateQuery(&timestampDesc, query.end.GetAddressOf()));
+    }
+}
+
+
+void IBLBaker::Impl::CreateTargets(Targets& result)
+{
+    CD3D11_TEXTURE2D_DESC desc(mFormat, mRadianceSize, mRadianceSize, 6, radianceMips,
+        D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, D3D11_USAGE_DEFAULT, 0, 1, 0, D3D11_RESOURCE_MISC_TEXTURECUBE);
+
+    ThrowIfFailed(mDevice->CreateTexture2D(&desc, nullptr, result.radiance.GetAddressOf()));
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURECUBE, mFormat);
+    ThrowIfFailed(mDevice->CreateShaderResourceView(result.radiance.Get(), &srvDesc, result.radianceSRV.GetAddressOf()));
+
+    result.radianceUAVs.resize(radianceMips);
+
+    for (UINT mip = 0; mip < radianceMips; ++mip)
+    {
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_TEXTURE2DARRAY, mFormat, mip, 0, 6);
+        ThrowIfFailed(mDevice->CreateUnorderedAccessView(result.radiance.Get(), &uavDesc, result.radianceUAVs[mip].GetAddressOf()));
+    }
+
+    desc.Width = desc.Height = mIrradianceSize;
+    desc.MipLevels = 1;
+
+    ThrowIfFailed(mDevice->CreateTexture2D(&desc, nullptr, result.irradiance.GetAddressOf()));
+    ThrowIfFailed(mDevice->CreateShaderResourceView(result.irradiance.Get(), &srvDesc, result.irradianceSRV.GetAddressOf()));
+
+    CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_TEXTURE2DARRAY, mFormat, 0, 0, 6);
+    ThrowIfFailed(mDevice->CreateUnorderedAccessView(result.irradiance.Get(), &uavDesc, result.irradianceUAV.GetAddressOf()));
+
+    SetDebugObjectName(result.radiance.Get(), "IBLBaker");
+    SetDebugObjectName(result.irradiance.Get(), "IBLBaker");
+
+    MemoryTracker::TrackResource(result.radiance.Get(), MemoryCategory_Texture, L"IBLBaker");
+    MemoryTracker::TrackResource(result.irradiance.Get(), MemoryCategory_Texture, L"IBLBaker");
+}
+
+
+_Use_decl_annotations_
+void IBLBaker::Impl::Begin(ID3D11ShaderResourceView* environment)
+{
+    if (!environment)
+        throw std::exception("Environment cannot be null");
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    environment->GetDesc(&srvDesc);
+
+    if (srvDesc.ViewDimension != D3D11_SRV_DIMENSION_TEXTURECUBE)
+        throw std::invalid_argument("IBLBaker environment must be a cubemap view");
+
+    ComPtr<ID3D11Resource> resource;
+    environment->GetResource(resource.GetAddressOf());
+
+    ComPtr<ID3D11Texture2D> texture;
+    ThrowIfFailed(resource.As(&texture));
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+
+    // Sample the environment mip nearest the filtered source size, so large sources are not aliased.
+    UINT viewMips = (srvDesc.TextureCube.MipLevels == UINT(-1))
+        ? desc.MipLevels - srvDesc.TextureCube.MostDetailedMip
+        : srvDesc.TextureCube.MipLevels;
+
+    float lod = std::log2(float(std::max(desc.Width >> srvDesc.TextureCube.MostDetailedMip, 1u)) / float(mRadianceSize));
+
+    mEnvironment = environment;
+    mEnvironmentLod = std::min(std::max(lod, 0.f), float(viewMips - 1));
+
+    mItems.clear();
+    mNextItem = 0;
+    mIssuedCost = 0;
+
+    AddItems(WORK_COPY_SOURCE, 0, mRadianceSize, 1);
+
+    WorkItem mips = { WORK_GENERATE_MIPS, 0, 0, 0, 0, 1, double(mRadianceSize) * double(mRadianceSize) * 2.0 };
+    mItems.push_back(mips);
+
+    AddItems(WORK_RADIANCE, 0, mRadianceSize, 1);
+
+    for (UINT mip = 1; mip < radianceMips; ++mip)
+    {
+        AddItems(WORK_RADIANCE, mip, std::max(mRadianceSize >> mip, 1u), specularSamples);
+    }
+
+    AddItems(WORK_IRRADIANCE, 0, mIrradianceSize, irradianceSamples);
+
+    mTotalCost = 0;
+
+    for (auto const& item : mItems)
+    {
+        mTotalCost += item.cost;
+    }
+}
+
+
+// Splits each face of a pass into bands of about SamplesPerItem samples.
+void IBLBaker::Impl::AddItems(WorkKind kind, UINT mip, UINT size, UINT samplesPerTexel)
+{
+    double rowCost = double(size) * double(samplesPerTexel);
+
+    auto rows = static_cast<UINT>(std::max(SamplesPerItem / rowCost, 1.0));
+    rows = std::min(AlignUp(rows, GroupSize), AlignUp(size, GroupSize));
+
+    for (UINT face = 0; face < 6; ++face)
+    {
+        for (UINT row = 0; row < size; row += rows)
+        {
+            UINT count = std::min(rows, size - row);
+
+            WorkItem item = { kind, mip, face, row, count, samplesPerTexel, rowCost * count };
+            mItems.push_back(item);
+        }
+    }
+}
+
+
+// Issues work until the next item would pass the budget, always making some progress.
+_Use_decl_annotations_
+bool IBLBaker::Impl::Process(ID3D11DeviceContext* deviceContext, float budgetMilliseconds)
+{
+    if (!IsBaking())
+        return false;
+
+    GpuProfileScope profileScope(deviceContext, L"IBLBaker::Process");
+
+    ReadTimings(deviceContext);
+
+    TimingQuery* query = nullptr;
+
+    for (auto& candidate : mQueries)
+    {
+        if (!candidate.pending)
+        {
+            query = &candidate;
+            break;
+        }
+    }
+
+    if (query)
+    {
+        deviceContext->Begin(query->disjoint.Get());
+        deviceContext->End(query->begin.Get());
+    }
+
+    ID3D11SamplerState* sampler = mSampler.Get();
+    deviceContext->CSSetSamplers(0, 1, &sampler);
+
+    double budget = std::max(double(budgetMilliseconds), 0.0) / mMillisecondsPerSample;
+    double issued = 0;
+
+    while (mNextItem < mItems.size())
+    {
+        auto const& item = mItems[mNextItem];
+
+        if (issued > 0 && issued + item.cost > budget)
+            break;
+
+        Execute(deviceContext, item);
+
+        issued += item.cost;
+        ++mNextItem;
+    }
+
+    mIssuedCost += issued;
+
+    if (query)
+    {
+        deviceContext->End(query->end.Get());
+        deviceContext->End(query->disjoint.Get());
+
+        query->cost = issued;
+        query->pending = true;
+    }
+
+    ID3D11SamplerState* nullSampler = nullptr;
+    deviceContext->CSSetSamplers(0, 1, &nullSampler);
+
+    if (IsBaking())
+        return false;
+
+    front ^= 1;
+    ++generation;
+
+    mEnvironment.Reset();
+    mItems.clear();
+    mNextItem = 0;
+
+    return true;
+}
+
+
+void IBLBaker::Impl::Execute(_In_ ID3D11DeviceContext* deviceContext, WorkItem const& item)
+{
+    auto& back = targets[front ^ 1];
+
+    if (item.kind == WORK_GENERATE_MIPS)
+    {
+        deviceContext->GenerateMips(mSourceSRV.Get());
+        return;
+    }
+
+    ID3D11ShaderResourceView* srv = mSourceSRV.Get();
+    ID3D11UnorderedAccessView* uav = nullptr;
+
+    BakeConstants constants = {};
+    constants.firstFace = item.face;
+    constants.firstRow = item.firstRow;
+    constants.sourceSize = float(mRadianceSize);
+    constants.sourceMipLevels = float(radianceMips);
+
+    WorkKind shader = item.kind;
+
+    switch (item.kind)
+    {
+        case WORK_COPY_SOURCE:
+            srv = mEnvironment.Get();
+            uav = mSourceUAV.Get();
+            constants.outputSize = mRadianceSize;
+            constants.sourceLod = mEnvironmentLod;
+            break;
+
+        case WORK_RADIANCE:
+            uav = back.radianceUAVs[item.mip].Get();
+            constants.outputSize = std::max(mRadianceSize >> item.mip, 1u);
+            constants.sampleCount = item.sampleCount;
+
+            // As sampled by PBREffect, which picks the mip as roughness times the mip count.
+            constants.roughness = float(item.mip) / float(radianceMips);
+
+            // Mip 0 has no blur to apply, so it is copied texel for texel.
+            if (!item.mip)
+            {
+                shader = WORK_COPY_SOURCE;
+            }
+            break;
+
+        default:
+            uav = back.irradianceUAV.Get();
+            constants.outputSize = mIrradianceSize;
+            constants.sampleCount = item.sampleCount;
+            break;
+    }
+
+    SetComputeConstants(deviceContext, constants);
+
+    deviceContext->CSSetShader(mDeviceResources->GetShader(shader), nullptr, 0);
+    deviceContext->CSSetShaderResources(0, 1, &srv);
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+    deviceContext->Dispatch((constants.outputSize + GroupSize - 1) / GroupSize, (item.rowCount + GroupSize - 1) / GroupSize, 1);
+
+    // The filtered source is mipmapped and sampled by the passes that follow.
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    deviceContext->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    deviceContext->CSSetShaderResources(0, 1, &nullSRV);
+}
+
+
+void IBLBaker::Impl::SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, BakeConstants const& value)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, value, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->CSSetPlacementConstantBuffer(0, mConstantBuffer.GetBuffer(), grfxMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, value);
+
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->CSSetConstantBuffers(0, 1, &buffer);
+#endif
+}
+
+
+// Folds finished timings into the cost estimate, without waiting for the GPU.
+void IBLBaker::Impl::ReadTimings(_In_ ID3D11DeviceContext* deviceContext)
+{
+    for (auto& query : mQueries)
+    {
+        if (!query.pending)
+            continue;
+
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+        if (deviceContext->GetData(query.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            continue;
+
+        UINT64 begin, end;
+        if (deviceContext->GetData(query.begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK
+            || deviceContext->GetData(query.end.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            continue;
+
+        query.pending = false;
+
+        if (disjoint.Disjoint || !disjoint.Frequency || end <= begin || query.cost <= 0)
+            continue;
+
+        double milliseconds = double(end - begin) * 1000.0 / double(disjoint.Frequency);
+
+        mMillisecondsPerSample = (mMillisecondsPerSample + milliseconds / query.cost) * 0.5;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// IBLBaker
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+IBLBaker::IBLBaker(_In_ ID3D11Device* device, unsigned int radianceSize, unsigned int irradianceSize, DXGI_FORMAT format)
+  : pImpl(std::make_unique<Impl>(device, radianceSize, irradianceSize, format))
+{
+}
+
+
+// Move constructor.
+IBLBaker::IBLBaker(IBLBaker&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+IBLBaker& IBLBaker::operator= (IBLBaker&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+IBLBaker::~IBLBaker()
+{
+}
+
+
+_Use_decl_annotations_
+void IBLBaker::Begin(ID3D11ShaderResourceView* environment)
+{
+    pImpl->Begin(environment);
+}
+
+
+_Use_decl_annotations_
+bool IBLBaker::Process(ID3D11DeviceContext* deviceContext, float budgetMilliseconds)
+{
+    return pImpl->Process(deviceContext, budgetMilliseconds);
+}
+
+
+_Use_decl_annotations_
+void IBLBaker::Bake(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* environment)
+{
+    pImpl->Begin(environment);
+    pImpl->Process(deviceContext, FLT_MAX);
+}
+
+
+bool IBLBaker::IsBaking() const noexcept
+{
+    return pImpl->IsBaking();
+}
+
+
+float IBLBaker::GetProgress() const noexcept
+{
+    return pImpl->GetProgress();
+}
+
+
+uint64_t IBLBaker::GetGeneration() const noexcept
+{
+    return pImpl->generation;
+}
+
+
+ID3D11ShaderResourceView* IBLBaker::GetRadianceTexture() const noexcept
+{
+    return pImpl->generation ? pImpl->targets[pImpl->front].radianceSRV.Get() : nullptr;
+}
+
+
+ID3D11ShaderResourceView* IBLBaker::GetIrradianceTexture() const noexcept
+{
+    return pImpl->generation ? pImpl->targets[pImpl->front].irradianceSRV.Get() : nullptr;
+}
+
+
+int IBLBaker::GetRadianceMipLevels() const noexcept
+{
+    return static_cast<int>(pImpl->radianceMips);
+}
+
+
+void IBLBaker::SetSampleCounts(unsigned int specularSamples, unsigned int irradianceSamples)
+{
+    if (!specularSamples || !irradianceSamples)
+        throw std::invalid_argument("Sample counts must be greater than zero");
+
+    pImpl->specularSamples = specularSamples;
+    pImpl->irradianceSamples = irradianceSamples;
+}
@@ -0,0 +1,637 @@
+//--------------------------------------------------------------------------------------
+// File: IndirectModelScene.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "IndirectModelScene.h"
+
+#include "CommonStates.h"
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneIndirectModelScene_CSCull.inc"
+#else
+    #include "Shaders/Compiled/IndirectModelScene_CSCull.inc"
+#endif
+
+    // Must match the shader!
+    const UINT GroupSize = 64;
+
+    // Three rows of the transposed transform, as read by the IEffectInstancing shaders.
+    const UINT InstanceStride = sizeof(XMFLOAT4) * 3;
+
+    // Must match the SceneInstance struct in IndirectModelScene.fx.
+    struct SceneInstance
+    {
+        XMFLOAT4 transform[3];
+        XMFLOAT4 sphere;
+        XMFLOAT3 boxCenter;
+        uint32_t draw;
+        XMFLOAT3 boxExtents;
+        uint32_t instanceBase;
+    };
+
+    static_assert(sizeof(SceneInstance) == 96, "SceneInstance size mismatch");
+
+    // DrawIndexedInstancedIndirect arguments.
+    struct DrawArgs
+    {
+        uint32_t indexCountPerInstance;
+        uint32_t instanceCount;
+        uint32_t startIndexLocation;
+        int32_t  baseVertexLocation;
+        uint32_t startInstanceLocation;
+    };
+
+    static_assert(sizeof(DrawArgs) == 20, "DrawArgs size mismatch");
+
+    // Constant buffer layout. Must match the shader!
+    struct CullConstants
+    {
+        XMFLOAT4 frustumPlanes[6];
+        XMFLOAT4X4 viewProjection;
+        XMFLOAT2 hiZSize;
+        uint32_t hiZMipCount;
+        uint32_t instanceCount;
+    };
+
+    static_assert((sizeof(CullConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mCullShader{},
+            mMutex{}
+        { }
+
+        // Gets or lazily creates the culling compute shader.
+        ID3D11ComputeShader* GetCullShader()
+        {
+            return DemandCreate(mCullShader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(IndirectModelScene_CSCull, sizeof(IndirectModelScene_CSCull), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "IndirectModelScene");
+
+                return hr;
+            });
+        }
+
+    protected:
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11ComputeShader> mCullShader;
+        std::mutex mMutex;
+    };
+}
+
+
+// Internal IndirectModelScene implementation class.
+class IndirectModelScene::Impl
+{
+public:
+    explicit Impl(_In_ ID3D11Device* device);
+
+    void XM_CALLCONV Add(const Model& model, FXMMATRIX world);
+    void XM_CALLCONV Cull(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection, _In_opt_ ID3D11ShaderResourceView* hiZ);
+    void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+                          bool wireframe, const std::function<void __cdecl()>& setCustomState);
+    void Clear() noexcept;
+
+    // One indirect draw per distinct mesh part.
+    struct PartDraw
+    {
+        const ModelMesh*    mesh;
+        ModelMeshPart*      part;
+        uint32_t            instanceCount;
+    };
+
+    std::vector<PartDraw>                   draws;
+    std::vector<SceneInstance>              instances;
+
+private:
+    void Build();
+    void SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, const CullConstants& value);
+
+    std::unordered_map<const ModelMeshPart*, uint32_t> mDrawIndices;
+    bool                                    mDirty;
+
+    ComPtr<ID3D11Buffer>                    mInstances;
+    ComPtr<ID3D11ShaderResourceView>        mInstancesSRV;
+
+    ComPtr<ID3D11Buffer>                    mArgs;
+    ComPtr<ID3D11UnorderedAccessView>       mArgsUAV;
+    ComPtr<ID3D11Buffer>                    mInitialArgs;
+
+    ComPtr<ID3D11Buffer>                    mVisible;
+    ComPtr<ID3D11UnorderedAccessView>       mVisibleUAV;
+
+    ComPtr<ID3D11Device>                    mDevice;
+    ConstantBuffer<CullConstants>           mConstantBuffer;
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>        mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device IndirectModelScene resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> IndirectModelScene::Impl::deviceResourcesPool;
+
+
+// Constructor.
+IndirectModelScene::Impl::Impl(_In_ ID3D11Device* device)
+    : mDirty(false),
+    mDevice(device),
+    mConstantBuffer(device),
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("IndirectModelScene requires Feature Level 11.0 or later");
+    }
+}
+
+
+// Records one placement per opaque part. Parts have no bounds of their own, so each uses its mesh's.
+void XM_CALLCONV IndirectModelScene::Impl::Add(const Model& model, FXMMATRIX world)
+{
+    const size_t maxInstances = size_t(D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION) * GroupSize;
+
+    XMMATRIX transform = XMMatrixTranspose(world);
+
+    for (auto mit = model.meshes.cbegin(); mit != model.meshes.cend(); ++mit)
+    {
+        auto mesh = mit->get();
+        assert(mesh != nullptr);
+
+        BoundingSphere sphere;
+        mesh->boundingSphere.Transform(sphere, world);
+
+        BoundingBox box;
+        mesh->boundingBox.Transform(box, world);
+
+        for (auto it = mesh->meshParts.cbegin(); it != mesh->meshParts.cend(); ++it)
+        {
+            auto part = it->get();
+            assert(part != nullptr);
+
+            if (part->isAlpha)
+                continue;
+
+            if (!dynamic_cast<IEffectInstancing*>(part->effect.get()))
+            {
+                throw std::exception("IndirectModelScene requires effects that support IEffectInstancing");
+            }
+
+            if (instances.size() >= maxInstances)
+            {
+                throw std::out_of_range("Too many placements for IndirectModelScene");
+            }
+
+            auto entry = mDrawIndices.emplace(part, static_cast<uint32_t>(draws.size()));
+            if (entry.second)
+            {
+                draws.push_back({ mesh, part, 0 });
+            }
+
+            SceneInstance instance = {};
+            XMStoreFloat4(&instance.transform[0], transform.r[0]);
+            XMStoreFloat4(&instance.transform[1], transform.r[1]);
+            XMStoreFloat4(&instance.transform[2], transform.r[2]);
+            instance.sphere = XMFLOAT4(sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius);
+            instance.boxCenter = box.Center;
+            instance.boxExtents = box.Extents;
+            instance.draw = entry.first->second;
+
+            instances.push_back(instance);
+
+            ++draws[entry.first->second].instanceCount;
+        }
+    }
+
+    mDirty = true;
+}
+
+
+// Orders the draws to keep state changes down, gives each a run of instance slots, and creates the GPU table.
+void IndirectModelScene::Impl::Build()
+{
+    mDirty = false;
+
+    mInstancesSRV.Reset();
+    mInstances.Reset();
+    mArgsUAV.Reset();
+    mArgs.Reset();
+    mInitialArgs.Reset();
+    mVisibleUAV.Reset();
+    mVisible.Reset();
+
+    if (instances.empty())
+        return;
+
+    std::vector<uint32_t> order(draws.size());
+    for (size_t j = 0; j < order.size(); ++j)
+    {
+        order[j] = static_cast<uint32_t>(j);
+    }
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        auto& pa = *draws[a].part;
+        auto& pb = *draws[b].part;
+
+        if (pa.effect != pb.effect)
+            return pa.effect < pb.effect;
+
+        if (pa.vertexBuffer != pb.vertexBuffer)
+            return pa.vertexBuffer < pb.vertexBuffer;
+
+        return pa.indexBuffer < pb.indexBuffer;
+    });
+
+    std::vector<PartDraw> sorted;
+    sorted.reserve(draws.size());
+
+    std::vector<uint32_t> remap(draws.size());
+    std::vector<uint32_t> instanceBases(draws.size());
+    std::vector<DrawArgs> args;
+    args.reserve(draws.size());
+
+    uint32_t instanceBase = 0;
+
+    for (size_t j = 0; j < order.size(); ++j)
+    {
+        auto& draw = draws[order[j]];
+        auto part = draw.part;
+
+        remap[order[j]] = static_cast<uint32_t>(j);
+        instanceBases[j] = instanceBase;
+
+        args.push_back({ part->indexCount, 0, part->startIndex, part->vertexOffset, instanceBase });
+
+        instanceBase += draw.instanceCount;
+        sorted.push_back(draw);
+    }
+
+    draws.swap(sorted);
+
+    mDrawIndices.clear();
+    for (size_t j = 0; j < draws.size(); ++j)
+    {
+        mDrawIndices[draws[j].part] = static_cast<uint32_t>(j);
+    }
+
+    for (auto& instance : instances)
+    {
+        instance.draw = remap[instance.draw];
+        instance.instanceBase = instanceBases[instance.draw];
+    }
+
+    auto instanceCount = static_cast<UINT>(instances.size());
+    auto drawCount = static_cast<UINT>(draws.size());
+
+    // Placement table, read by the culling shader.
+    {
+        CD3D11_BUFFER_DESC desc(instanceCount * sizeof(SceneInstance), D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE, 0,
+            D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(SceneInstance));
+
+        D3D11_SUBRESOURCE_DATA initData = { instances.data(), 0, 0 };
+
+        ThrowIfFailed(mDevice->CreateBuffer(&desc, &initData, mInstances.GetAddressOf()));
+
+        SetDebugObjectName(mInstances.Get(), "IndirectModelScene");
+
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, instanceCount);
+        ThrowIfFailed(mDevice->CreateShaderResourceView(mInstances.Get(), &srvDesc, mInstancesSRV.GetAddressOf()));
+    }
+
+    // Indirect arguments, with a copy that starts every instance count at zero for resetting them each Cull.
+    {
+        D3D11_SUBRESOURCE_DATA initData = { args.data(), 0, 0 };
+
+        CD3D11_BUFFER_DESC desc(drawCount * sizeof(DrawArgs), D3D11_BIND_UNORDERED_ACCESS, D3D11_USAGE_DEFAULT, 0,
+            D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+
+        ThrowIfFailed(mDevice->CreateBuffer(&desc, &initData, mArgs.GetAddressOf()));
+
+        SetDebugObjectName(mArgs.Get(), "IndirectModelScene");
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_R32_TYPELESS, 0, desc.ByteWidth / sizeof(uint32_t), 0, D3D11_BUFFER_UAV_FLAG_RAW);
+        ThrowIfFailed(mDevice->CreateUnorderedAccessView(mArgs.Get(), &uavDesc, mArgsUAV.GetAddressOf()));
+
+        CD3D11_BUFFER_DESC initialDesc(desc.ByteWidth, 0, D3D11_USAGE_DEFAULT);
+        ThrowIfFailed(mDevice->CreateBuffer(&initialDesc, &initData, mInitialArgs.GetAddressOf()));
+
+        SetDebugObjectName(mInitialArgs.Get(), "IndirectModelScene");
+    }
+
+    // Visible transforms, written by the culling shader and drawn as the instance stream.
+    {
+        CD3D11_BUFFER_DESC desc(instanceCount * InstanceStride, D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_UNORDERED_ACCESS,
+            D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+
+        ThrowIfFailed(mDevice->CreateBuffer(&desc, nullptr, mVisible.GetAddressOf()));
+
+        SetDebugObjectName(mVisible.Get(), "IndirectModelScene");
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_R32_TYPELESS, 0, desc.ByteWidth / sizeof(uint32_t), 0, D3D11_BUFFER_UAV_FLAG_RAW);
+        ThrowIfFailed(mDevice->CreateUnorderedAccessView(mVisible.Get(), &uavDesc, mVisibleUAV.GetAddressOf()));
+    }
+}
+
+
+void IndirectModelScene::Impl::SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext, const CullConstants& value)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, value, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->CSSetPlacementConstantBuffer(0, mConstantBuffer.GetBuffer(), grfxMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, value);
+
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->CSSetConstantBuffers(0, 1, &buffer);
+#endif
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV IndirectModelScene::Impl::Cull(ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection, ID3D11ShaderResourceView* hiZ)
+{
+    if (mDirty)
+        Build();
+
+    if (instances.empty())
+        return;
+
+    CullConstants constants = {};
+
+    XMMATRIX viewProj = XMMatrixMultiply(view, projection);
+    XMStoreFloat4x4(&constants.viewProjection, XMMatrixTranspose(viewProj));
+
+    // Normalized, inward-facing world space planes, from the columns of the clip transform.
+    {
+        XMMATRIX m = XMMatrixTranspose(viewProj);
+
+        XMStoreFloat4(&constants.frustumPlanes[0], XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[0])));
+        XMStoreFloat4(&constants.frustumPlanes[1], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[0])));
+        XMStoreFloat4(&constants.frustumPlanes[2], XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[1])));
+        XMStoreFloat4(&constants.frustumPlanes[3], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[1])));
+        XMStoreFloat4(&constants.frustumPlanes[4], XMPlaneNormalize(m.r[2]));
+        XMStoreFloat4(&constants.frustumPlanes[5], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[2])));
+    }
+
+    if (hiZ)
+    {
+        ComPtr<ID3D11Resource> resource;
+        hiZ->GetResource(resource.GetAddressOf());
+
+        ComPtr<ID3D11Texture2D> texture;
+        if (FAILED(resource.As(&texture)))
+        {
+            throw std::exception("IndirectModelScene Hi-Z buffer must be a 2D texture");
+        }
+
+        D3D11_TEXTURE2D_DESC desc;
+        texture->GetDesc(&desc);
+
+        constants.hiZSize = XMFLOAT2(float(desc.Width), float(desc.Height));
+        constants.hiZMipCount = desc.MipLevels;
+    }
+
+    constants.instanceCount = static_cast<uint32_t>(instances.size());
+
+    // Every part starts the frame with no instances.
+    deviceContext->CopyResource(mArgs.Get(), mInitialArgs.Get());
+
+    SetComputeConstants(deviceContext, constants);
+
+    deviceContext->CSSetShader(mDeviceResources->GetCullShader(), nullptr, 0);
+
+    ID3D11ShaderResourceView* srvs[2] = { mInstancesSRV.Get(), hiZ };
+    deviceContext->CSSetShaderResources(0, 2, srvs);
+
+    ID3D11UnorderedAccessView* uavs[2] = { mArgsUAV.Get(), mVisibleUAV.Get() };
+    deviceContext->CSSetUnorderedAccessViews(0, 2, uavs, nullptr);
+
+    deviceContext->Dispatch((constants.instanceCount + GroupSize - 1) / GroupSize, 1, 1);
+
+    // Both outputs are read by the input assembler next.
+    ID3D11UnorderedAccessView* nullUAV[2] = {};
+    deviceContext->CSSetUnorderedAccessViews(0, 2, nullUAV, nullptr);
+
+    ID3D11ShaderResourceView* nullSRV[2] = {};
+    deviceContext->CSSetShaderResources(0, 2, nullSRV);
+}
+
+
+// Issues one indirect draw per part. State, effect matrices, and buffers are only set when they change from the
+// draw before, which the ordering from Build makes the rare case.
+_Use_decl_annotations_
+void XM_CALLCONV IndirectModelScene::Impl::Draw(ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+    bool wireframe, const std::function<void __cdecl()>& setCustomState)
+{
+    if (mDirty)
+    {
+        throw std::exception("IndirectModelScene changed since the last Cull");
+    }
+
+    if (draws.empty())
+        return;
+
+    ModelRenderState renderState;
+
+    IEffect* lastEffect = nullptr;
+    ID3D11InputLayout* lastInputLayout = nullptr;
+    ID3D11Buffer* lastVertexBuffer = nullptr;
+    ID3D11Buffer* lastIndexBuffer = nullptr;
+
+    auto visible = mVisible.Get();
+    UINT visibleOffset = 0;
+    deviceContext->IASetVertexBuffers(1, 1, &visible, &InstanceStride, &visibleOffset);
+
+    for (size_t j = 0; j < draws.size(); ++j)
+    {
+        auto mesh = draws[j].mesh;
+        auto part = draws[j].part;
+
+        mesh->PrepareForRendering(deviceContext, states, renderState, false, wireframe);
+
+        auto effect = part->effect.get();
+        auto iinstancing = dynamic_cast<IEffectInstancing*>(effect);
+        assert(iinstancing != nullptr);
+
+        if (effect != lastEffect)
+        {
+            auto imatrices = part->GetEffectMatrices();
+            if (imatrices)
+            {
+                imatrices->SetMatrices(XMMatrixIdentity(), view, projection);
+            }
+
+            iinstancing->SetInstancingEnabled(true);
+        }
+
+        if (!part->instancedInputLayout)
+        {
+            part->CreateInstancedInputLayout(mDevice.Get(), effect, part->instancedInputLayout.ReleaseAndGetAddressOf());
+        }
+
+        auto inputLayout = part->instancedInputLayout.Get();
+        if (inputLayout != lastInputLayout)
+        {
+            deviceContext->IASetInputLayout(inputLayout);
+            lastInputLayout = inputLayout;
+        }
+
+        auto vb = part->vertexBuffer.Get();
+        if (vb != lastVertexBuffer)
+        {
+            UINT vbStride = part->vertexStride;
+            UINT vbOffset = 0;
+            deviceContext->IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
+            lastVertexBuffer = vb;
+        }
+
+        auto ib = part->indexBuffer.Get();
+        if (ib != lastIndexBuffer)
+        {
+            deviceContext->IASetIndexBuffer(ib, part->indexFormat, 0);
+            lastIndexBuffer = ib;
+        }
+
+        effect->Apply(deviceContext);
+
+        if (setCustomState)
+        {
+            setCustomState();
+            InvalidateEffectStateCache(deviceContext);
+            renderState.Reset();
+        }
+
+        deviceContext->IASetPrimitiveTopology(part->primitiveType);
+
+        deviceContext->DrawIndexedInstancedIndirect(mArgs.Get(), static_cast<UINT>(j * sizeof(DrawArgs)));
+
+        // Shared effects go back to their regular shaders once their last draw here is done.
+        if (j + 1 == draws.size() || draws[j + 1].part->effect.get() != effect)
+        {
+            iinstancing->SetInstancingEnabled(false);
+        }
+
+        lastEffect = effect;
+    }
+
+    // Unbind the instance stream so it does not leak into later draws.
+    ID3D11Buffer* nullBuffer = nullptr;
+    UINT zero = 0;
+    deviceContext->IASetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+}
+
+
+void IndirectModelScene::Impl::Clear() noexcept
+{
+    draws.clear();
+    instances.clear();
+    mDrawIndices.clear();
+    mDirty = true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// IndirectModelScene
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+IndirectModelScene::IndirectModelScene(_In_ ID3D11Device* device)
+  : pImpl(std::make_unique<Impl>(device))
+{
+}
+
+
+// Move constructor.
+IndirectModelScene::IndirectModelScene(IndirectModelScene&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+IndirectModelScene& IndirectModelScene::operator= (IndirectModelScene&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+IndirectModelScene::~IndirectModelScene()
+{
+}
+
+
+void XM_CALLCONV IndirectModelScene::Add(const Model& model, FXMMATRIX world)
+{
+    pImpl->Add(model, world);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV IndirectModelScene::Cull(ID3D11DeviceContext* deviceContext, FXMMATRIX view, CXMMATRIX projection, ID3D11ShaderResourceView* hiZ)
+{
+    pImpl->Cull(deviceContext, view, projection, hiZ);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV IndirectModelScene::Draw(ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+    bool wireframe, std::function<void __cdecl()> setCustomState)
+{
+    pImpl->Draw(deviceContext, states, view, projection, wireframe, setCustomState);
+}
+
+
+void IndirectModelScene::Clear() noexcept
+{
+    pImpl->Clear();
+}
+
+
+size_t IndirectModelScene::GetInstanceCount() const noexcept
+{
+    return pImpl->instances.size();
+}
+
+
+size_t IndirectModelScene::GetDrawCount() const noexcept
+{
+    return pImpl->draws.size();
+}
@@ -0,0 +1,199 @@
+//--------------------------------------------------------------------------------------
+// File: InputEvents.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "InputEvents.h"
+
+#include <atomic>
+
+using namespace DirectX;
+
+
+// Internal InputEventQueue implementation class. A bounded ring where each cell carries a sequence number: a
+// producer claims a cell by advancing the tail, then publishes it by bumping the cell's sequence, which is what
+// the consumer waits for before reading it.
+class InputEventQueue::Impl
+{
+public:
+    explicit Impl(size_t capacity) :
+        mMask(0),
+        mHead(0),
+        mTail(0),
+        mDropped(0)
+    {
+        if (!capacity || capacity > (size_t(1) << 24))
+            throw std::invalid_argument("InputEventQueue capacity is out of range");
+
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+
+        for (size_t j = 0; j < size; ++j)
+        {
+            mCells[j].sequence.store(j, std::memory_order_relaxed);
+        }
+    }
+
+    bool Push(const InputEvent& event) noexcept
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell& cell = mCells[tail & mMask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+
+            if (!diff)
+            {
+                if (mTail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    cell.event = event;
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                tail = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Pop(InputEvent& event, int64_t before) noexcept
+    {
+        Cell& cell = mCells[mHead & mMask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+        if (sequence != mHead + 1)
+            return false;
+
+        if (cell.event.timestamp >= before)
+            return false;
+
+        event = cell.event;
+        cell.sequence.store(mHead + mMask + 1, std::memory_order_release);
+        ++mHead;
+        return true;
+    }
+
+    size_t GetCapacity() const noexcept { return mMask + 1; }
+    size_t GetDroppedCount() const noexcept { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        InputEvent          event;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t                  mMask;
+
+    // The head is only touched by the consumer.
+    size_t                  mHead;
+    std::atomic<size_t>     mTail;
+    std::atomic<size_t>     mDropped;
+};
+
+
+//--------------------------------------------------------------------------------------
+// InputEventQueue
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+InputEventQueue::InputEventQueue(size_t capacity)
+    : pImpl(std::make_unique<Impl>(capacity))
+{
+}
+
+
+// Move constructor.
+InputEventQueue::InputEventQueue(InputEventQueue&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+InputEventQueue& InputEventQueue::operator= (InputEventQueue&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+InputEventQueue::~InputEventQueue()
+{
+}
+
+
+bool InputEventQueue::Push(InputEvent::Type type, uint16_t code, int32_t x, int32_t y, uint8_t player) noexcept
+{
+    InputEvent event;
+    event.timestamp = GetTimestamp();
+    event.type = type;
+    event.player = player;
+    event.code = code;
+    event.x = x;
+    event.y = y;
+
+    return pImpl->Push(event);
+}
+
+
+bool InputEventQueue::Push(const InputEvent& event) noexcept
+{
+    return pImpl->Push(event);
+}
+
+
+bool InputEventQueue::Pop(InputEvent& event, int64_t before) noexcept
+{
+    return pImpl->Pop(event, before);
+}
+
+
+void InputEventQueue::Clear() noexcept
+{
+    InputEvent event;
+    while (pImpl->Pop(event, INT64_MAX))
+    {
+    }
+}
+
+
+size_t InputEventQueue::GetCapacity() const noexcept
+{
+    return pImpl->GetCapacity();
+}
+
+
+size_t InputEventQueue::GetDroppedCount() const noexcept
+{
+    return pImpl->GetDroppedCount();
+}
+
+
+int64_t InputEventQueue::GetTimestamp() noexcept
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
@@ -10,6 +10,7 @@
 
 #include "pch.h"
 #include "Keyboard.h"
+#include "InputEvents.h"
 
 #include "PlatformHelpers.h"
 
@@ -78,7 +79,8 @@ class Keyboard::Impl
 public:
     Impl(Keyboard* owner) :
         mState{},
-        mOwner(owner)
+        mOwner(owner),
+        mEventQueue(nullptr)
     {
         if (s_keyboard)
         {
@@ -108,8 +110,9 @@ public:
         return true;
     }
 
-    State           mState;
-    Keyboard*       mOwner;
+    State               mState;
+    Keyboard*           mOwner;
+    InputEventQueue*    mEventQueue;
 
     static Keyboard::Impl* s_keyboard;
 };
@@ -178,6 +181,12 @@ void Keyboard::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
     {
         KeyUp(vk, pImpl->mState);
     }
+
+    // Auto-repeat is not a new press
+    if (pImpl->mEventQueue && (!down || !(static_cast<UINT>(lParam) & 0x40000000)))
+    {
+        pImpl->mEventQueue->Push(down ? InputEvent::KEY_DOWN : InputEvent::KEY_UP, static_cast<uint16_t>(vk));
+    }
 }
 
 #else
@@ -203,6 +212,7 @@ public:
     Impl(Keyboard* owner) :
         mState{},
         mOwner(owner),
+        mEventQueue(nullptr),
         mAcceleratorKeyToken{},
         mActivatedToken{}
     {
@@ -284,8 +294,9 @@ public:
         ThrowIfFailed(hr);
     }
 
-    State       mState;
-    Keyboard*   mOwner;
+    State               mState;
+    Keyboard*           mOwner;
+    InputEventQueue*    mEventQueue;
 
     static Keyboard::Impl* s_keyboard;
 
@@ -400,6 +411,11 @@ private:
             KeyUp(vk, pImpl->mState);
         }
 
+        if (pImpl->mEventQueue && (!down || !status.WasKeyDown))
+        {
+            pImpl->mEventQueue->Push(down ? InputEvent::KEY_DOWN : InputEvent::KEY_UP, static_cast<uint16_t>(vk));
+        }
+
         return S_OK;
     }
 };
@@ -466,6 +482,13 @@ bool Keyboard::IsConnected() const
     return pImpl->IsConnected();
 }
 
+
+_Use_decl_annotations_
+void Keyboard::SetEventQueue(InputEventQueue* queue) noexcept
+{
+    pImpl->mEventQueue = queue;
+}
+
 Keyboard& Keyboard::Get()
 {
     if (!Impl::s_keyboard || !Impl::s_keyboard->mOwner)
@@ -0,0 +1,205 @@
+//--------------------------------------------------------------------------------------
+// File: MaterialCache.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Effects.h"
+
+
+namespace DirectX
+{
+    // Content key for an effect factory material. This is a flat copy of every field that shapes the effect,
+    // with strings copied by value, so two EffectInfo structures compare equal whenever they would build the
+    // same effect, whatever their names are. The hash is accumulated (FNV-1a) as fields are added.
+    class MaterialKey
+    {
+    public:
+        MaterialKey() noexcept
+            : mHash(14695981039346656037ull)
+        { }
+
+        // Adds the fields of the base EffectInfo, except for its name.
+        explicit MaterialKey(IEffectFactory::EffectInfo const& info)
+            : MaterialKey()
+        {
+            Add(info.perVertexColor);
+            Add(info.enableSkinning);
+            Add(info.enableDualTexture);
+            Add(info.enableNormalMaps);
+            Add(info.biasedVertexNormals);
+            Add(info.specularPower);
+            Add(info.alpha);
+            Add(info.ambientColor);
+            Add(info.diffuseColor);
+            Add(info.specularColor);
+            Add(info.emissiveColor);
+            AddString(info.diffuseTexture);
+            AddString(info.specularTexture);
+            AddString(info.normalTexture);
+            AddString(info.emissiveTexture);
+        }
+
+        template<typename T>
+        void Add(T const& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "MaterialKey fields must be plain data");
+
+            AddBytes(&value, sizeof(T));
+        }
+
+        // Null and empty strings are the same to the factories, so both add just the zero length.
+        void AddString(_In_opt_z_ const wchar_t* value)
+        {
+            uint32_t length = value ? static_cast<uint32_t>(wcslen(value)) : 0u;
+
+            Add(length);
+            AddBytes(value, length * sizeof(wchar_t));
+        }
+
+        size_t GetHash() const noexcept { return static_cast<size_t>(mHash); }
+
+        bool operator== (MaterialKey const& other) const noexcept
+        {
+            return mHash == other.mHash
+                && mData.size() == other.mData.size()
+                && (mData.empty() || memcmp(mData.data(), other.mData.data(), mData.size()) == 0);
+        }
+
+    private:
+        void AddBytes(_In_reads_bytes_(size) void const* data, size_t size)
+        {
+            auto bytes = static_cast<uint8_t const*>(data);
+
+            mData.insert(mData.end(), bytes, bytes + size);
+
+            for (size_t j = 0; j < size; ++j)
+            {
+                mHash = (mHash ^ bytes[j]) * 1099511628211ull;
+            }
+        }
+
+        std::vector<uint8_t> mData;
+        uint64_t mHash;
+    };
+
+
+    // Open addressing hash table from MaterialKey to a cached value, using linear probing. Entries are only
+    // removed all at once by Clear, so no tombstones are needed. Not thread safe; the factories lock around it.
+    template<typename TValue>
+    class MaterialCache
+    {
+    public:
+        MaterialCache() noexcept
+            : mCount(0)
+        { }
+
+        MaterialCache(MaterialCache const&) = delete;
+        MaterialCache& operator= (MaterialCache const&) = delete;
+
+        // Returns the cached value, or null if there is none for this material.
+        TValue const* Find(MaterialKey const& key) const noexcept
+        {
+            if (mEntries.empty())
+                return nullptr;
+
+            size_t mask = mEntries.size() - 1;
+
+            for (size_t j = key.GetHash() & mask; ; j = (j + 1) & mask)
+            {
+                auto const& entry = mEntries[j];
+
+                if (!entry.used)
+                    return nullptr;
+
+                if (entry.key == key)
+                    return &entry.value;
+            }
+        }
+
+        // Adds a value unless one is already cached for this material, and returns whichever is now in the cache.
+        TValue const& Insert(MaterialKey&& key, TValue const& value)
+        {
+            if (auto existing = Find(key))
+                return *existing;
+
+            // Keep the load factor at or below 3/4.
+            if ((mCount + 1) * 4 > mEntries.size() * 3)
+            {
+                Rehash(mEntries.empty() ? 16 : mEntries.size() * 2);
+            }
+
+            auto& entry = Place(key.GetHash());
+
+            entry.key = std::move(key);
+            entry.value = value;
+            entry.used = true;
+
+            ++mCount;
+
+            return entry.value;
+        }
+
+        void Clear() noexcept
+        {
+            mEntries.clear();
+            mCount = 0;
+        }
+
+    private:
+        struct Entry
+        {
+            Entry() noexcept : value{}, used(false) { }
+
+            MaterialKey key;
+            TValue value;
+            bool used;
+        };
+
+        // Finds the free slot for a key that is known not to be in the table.
+        Entry& Place(size_t hash) noexcept
+        {
+            size_t mask = mEntries.size() - 1;
+
+            size_t j = hash & mask;
+            while (mEntries[j].used)
+            {
+                j = (j + 1) & mask;
+            }
+
+            return mEntries[j];
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::vector<Entry> entries(capacity);
+            std::swap(mEntries, entries);
+
+            for (auto& entry : entries)
+            {
+                if (entry.used)
+                {
+                    auto& target = Place(entry.key.GetHash());
+
+                    target.key = std::move(entry.key);
+                    target.value = std::move(entry.value);
+                    target.used = true;
+                }
+            }
+        }
+
+        std::vector<Entry> mEntries;
+        size_t mCount;
+    };
+}
@@ -0,0 +1,381 @@
+//--------------------------------------------------------------------------------------
+// File: MemoryTracker.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "MemoryTracker.h"
+#include "LoaderHelpers.h"
+
+#include <atomic>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+    // {6A1C1D0E-8F3B-4C55-9E27-3B4D2F61A7C8}
+    const GUID WKPDID_DirectXTKMemoryTracker = { 0x6a1c1d0e, 0x8f3b, 0x4c55, { 0x9e, 0x27, 0x3b, 0x4d, 0x2f, 0x61, 0xa7, 0xc8 } };
+
+    const uint32_t TotalIndex = MemoryCategory_Count;
+
+    struct Counters
+    {
+        uint64_t    bytes;
+        uint64_t    allocations;
+        uint64_t    peakBytes;
+        uint64_t    frameHighWater;
+        uint64_t    lastFrameHighWater;
+        uint64_t    lastFrameTransient;
+    };
+
+    struct Entry
+    {
+        MemoryCategory  category;
+        uint64_t        bytes;
+        std::wstring    owner;
+    };
+
+    struct TrackerState
+    {
+        std::mutex                              mutex;
+        std::unordered_map<uint64_t, Entry>     entries;
+        uint64_t                                nextHandle = 1;
+
+        Counters                                counters[MemoryCategory_Count + 1] = {};
+        std::atomic<uint64_t>                   transient[MemoryCategory_Count + 1] = {};
+
+        void Add(uint32_t index, uint64_t bytes) noexcept
+        {
+            auto& c = counters[index];
+            c.bytes += bytes;
+            ++c.allocations;
+            c.peakBytes = std::max(c.peakBytes, c.bytes);
+            c.frameHighWater = std::max(c.frameHighWater, c.bytes);
+        }
+
+        void Remove(uint32_t index, uint64_t bytes) noexcept
+        {
+            auto& c = counters[index];
+            c.bytes -= bytes;
+            --c.allocations;
+        }
+    };
+
+    TrackerState& GetState()
+    {
+        static TrackerState s_state;
+        return s_state;
+    }
+
+    std::atomic<bool> s_enabled(false);
+
+
+    // Size of every subresource, from the description.
+    uint64_t EstimateSize(_In_ ID3D11Resource* resource) noexcept
+    {
+        D3D11_RESOURCE_DIMENSION dimension;
+        resource->GetType(&dimension);
+
+        uint64_t total = 0;
+
+        switch (dimension)
+        {
+            case D3D11_RESOURCE_DIMENSION_BUFFER:
+            {
+                D3D11_BUFFER_DESC desc;
+                static_cast<ID3D11Buffer*>(resource)->GetDesc(&desc);
+                total = desc.ByteWidth;
+                break;
+            }
+
+            case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+            {
+                D3D11_TEXTURE1D_DESC desc;
+                static_cast<ID3D11Texture1D*>(resource)->GetDesc(&desc);
+
+                for (UINT level = 0; level < desc.MipLevels; ++level)
+                {
+                    size_t numBytes = 0;
+                    if (SUCCEEDED(LoaderHelpers::GetSurfaceInfo(std::max<size_t>(desc.Width >> level, 1), 1, desc.Format, &numBytes, nullptr, nullptr)))
+                        total += numBytes;
+                }
+
+                total *= desc.ArraySize;
+                break;
+            }
+
+            case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+            {
+                D3D11_TEXTURE2D_DESC desc;
+                static_cast<ID3D11Texture2D*>(resource)->GetDesc(&desc);
+
+                for (UINT level = 0; level < desc.MipLevels; ++level)
+                {
+                    size_t numBytes = 0;
+                    if (SUCCEEDED(LoaderHelpers::GetSurfaceInfo(std::max<size_t>(desc.Width >> level, 1), std::max<size_t>(desc.Height >> level, 1), desc.Format, &numBytes, nullptr, nullptr)))
+                        total += numBytes;
+                }
+
+                total *= uint64_t(desc.ArraySize) * std::max(desc.SampleDesc.Count, 1u);
+                break;
+            }
+
+            case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+            {
+                D3D11_TEXTURE3D_DESC desc;
+                static_cast<ID3D11Texture3D*>(resource)->GetDesc(&desc);
+
+                for (UINT level = 0; level < desc.MipLevels; ++level)
+                {
+                    size_t numBytes = 0;
+                    if (SUCCEEDED(LoaderHelpers::GetSurfaceInfo(std::max<size_t>(desc.Width >> level, 1), std::max<size_t>(desc.Height >> level, 1), desc.Format, &numBytes, nullptr, nullptr)))
+                        total += uint64_t(numBytes) * std::max<size_t>(desc.Depth >> level, 1);
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        return total;
+    }
+
+
+    // Attached to a tracked resource as private data: the resource releases it when destroyed, which ends the record.
+    class ResourceToken : public IUnknown
+    {
+    public:
+        explicit ResourceToken(uint64_t handle) noexcept : mRefCount(1), mHandle(handle) {}
+
+        ResourceToken(ResourceToken const&) = delete;
+        ResourceToken& operator= (ResourceToken const&) = delete;
+
+        STDMETHOD(QueryInterface)(REFIID riid, _COM_Outptr_ void** ppvObject) override
+        {
+            if (!ppvObject)
+                return E_POINTER;
+
+            if (riid == __uuidof(IUnknown))
+            {
+                AddRef();
+                *ppvObject = static_cast<IUnknown*>(this);
+                return S_OK;
+            }
+
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        STDMETHOD_(ULONG, AddRef)() override
+        {
+            return InterlockedIncrement(&mRefCount);
+        }
+
+        STDMETHOD_(ULONG, Release)() override
+        {
+            ULONG count = InterlockedDecrement(&mRefCount);
+            if (!count)
+            {
+                MemoryTracker::ReleaseAllocation(mHandle);
+                delete this;
+            }
+            return count;
+        }
+
+    private:
+        virtual ~ResourceToken() = default;
+
+        ULONG       mRefCount;
+        uint64_t    mHandle;
+    };
+}
+
+
+void MemoryTracker::SetEnabled(bool enabled) noexcept
+{
+    s_enabled = enabled;
+}
+
+
+bool MemoryTracker::IsEnabled() noexcept
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+
+_Use_decl_annotations_
+void MemoryTracker::TrackResource(ID3D11Resource* resource, MemoryCategory category, const wchar_t* owner) noexcept
+{
+    if (!resource || !IsEnabled())
+        return;
+
+    uint64_t handle = TrackAllocation(category, static_cast<size_t>(EstimateSize(resource)), owner);
+    if (!handle)
+        return;
+
+    auto token = new (std::nothrow) ResourceToken(handle);
+    if (!token)
+    {
+        ReleaseAllocation(handle);
+        return;
+    }
+
+    // Replacing an earlier token releases it, and so drops the earlier record.
+    if (FAILED(resource->SetPrivateDataInterface(WKPDID_DirectXTKMemoryTracker, token)))
+    {
+        ReleaseAllocation(handle);
+    }
+
+    token->Release();
+}
+
+
+_Use_decl_annotations_
+uint64_t MemoryTracker::TrackAllocation(MemoryCategory category, size_t bytes, const wchar_t* owner) noexcept
+{
+    if (!IsEnabled() || category >= MemoryCategory_Count)
+        return 0;
+
+    auto& state = GetState();
+
+    try
+    {
+        Entry entry = { category, bytes, owner ? owner : L"" };
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        uint64_t handle = state.nextHandle++;
+        state.entries.emplace(handle, std::move(entry));
+
+        state.Add(category, bytes);
+        state.Add(TotalIndex, bytes);
+
+        return handle;
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+
+void MemoryTracker::ReleaseAllocation(uint64_t handle) noexcept
+{
+    if (!handle)
+        return;
+
+    auto& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    auto it = state.entries.find(handle);
+    if (it == state.entries.end())
+        return;
+
+    state.Remove(it->second.category, it->second.bytes);
+    state.Remove(TotalIndex, it->second.bytes);
+
+    state.entries.erase(it);
+}
+
+
+void MemoryTracker::AddFrameUsage(MemoryCategory category, size_t bytes) noexcept
+{
+    if (!IsEnabled() || category >= MemoryCategory_Count)
+        return;
+
+    auto& state = GetState();
+
+    state.transient[category].fetch_add(bytes, std::memory_order_relaxed);
+    state.transient[TotalIndex].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void MemoryTracker::EndFrame() noexcept
+{
+    if (!IsEnabled())
+        return;
+
+    auto& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    for (uint32_t j = 0; j <= TotalIndex; ++j)
+    {
+        auto& c = state.counters[j];
+        c.lastFrameHighWater = c.frameHighWater;
+        c.frameHighWater = c.bytes;
+        c.lastFrameTransient = state.transient[j].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+
+namespace
+{
+    MemoryTracker::Usage GetCounters(uint32_t index) noexcept
+    {
+        auto& state = GetState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        auto& c = state.counters[index];
+
+        MemoryTracker::Usage usage;
+        usage.bytes = c.bytes;
+        usage.allocations = c.allocations;
+        usage.peakBytes = c.peakBytes;
+        usage.frameHighWaterBytes = c.lastFrameHighWater;
+        usage.frameTransientBytes = c.lastFrameTransient;
+        return usage;
+    }
+}
+
+
+MemoryTracker::Usage MemoryTracker::GetUsage(MemoryCategory category) noexcept
+{
+    if (category >= MemoryCategory_Count)
+        return Usage{};
+
+    return GetCounters(category);
+}
+
+
+MemoryTracker::Usage MemoryTracker::GetTotalUsage() noexcept
+{
+    return GetCounters(TotalIndex);
+}
+
+
+void MemoryTracker::GetAllocations(std::vector<Allocation>& allocations)
+{
+    auto& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    allocations.clear();
+    allocations.reserve(state.entries.size());
+
+    for (auto& it : state.entries)
+    {
+        allocations.push_back({ it.second.category, it.second.bytes, it.second.owner });
+    }
+}
+
+
+void MemoryTracker::ResetPeaks() noexcept
+{
+    auto& state = GetState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    for (auto& c : state.counters)
+    {
+        c.peakBytes = c.bytes;
+    }
+}
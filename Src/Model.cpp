@@ -13,14 +13,32 @@
 #include "CommonStates.h"
 #include "DirectXHelpers.h"
 #include "Effects.h"
+#include "GpuProfiler.h"
+#include "GraphicsMemory.h"
+#include "MemoryTracker.h"
+#include "ModelDraw.h"
 #include "PlatformHelpers.h"
 
 using namespace DirectX;
+using Microsoft::WRL::ComPtr;
 
 #ifndef _CPPRTTI 
 #error Model requires RTTI
 #endif
 
+namespace
+{
+    // Per-instance transform stream read by the IEffectInstancing shaders: three rows of an XMFLOAT3X4.
+    const D3D11_INPUT_ELEMENT_DESC s_instanceElements[] =
+    {
+        { "InstMatrix", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,  D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+
+    const UINT c_instanceStride = sizeof(XMFLOAT4) * 3;
+}
+
 //--------------------------------------------------------------------------------------
 // ModelMeshPart
 //--------------------------------------------------------------------------------------
@@ -32,7 +50,8 @@ ModelMeshPart::ModelMeshPart() noexcept :
     vertexStride(0),
     primitiveType(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST),
     indexFormat(DXGI_FORMAT_R16_UINT),
-    isAlpha(false)
+    isAlpha(false),
+    mEffectMatrices(nullptr)
 {
 }
 
@@ -66,6 +85,7 @@ void ModelMeshPart::Draw(
     if (setCustomState)
     {
         setCustomState();
+        InvalidateEffectStateCache(deviceContext);
     }
 
     // Draw the primitive.
@@ -75,6 +95,46 @@ void ModelMeshPart::Draw(
 }
 
 
+_Use_decl_annotations_
+void ModelMeshPart::DrawLod(
+    ID3D11DeviceContext* deviceContext,
+    IEffect* ieffect,
+    ID3D11InputLayout* iinputLayout,
+    size_t level,
+    std::function<void()> setCustomState) const
+{
+    if (!level || lods.empty())
+    {
+        Draw(deviceContext, ieffect, iinputLayout, setCustomState);
+        return;
+    }
+
+    auto& lod = lods[std::min(level, lods.size()) - 1];
+
+    deviceContext->IASetInputLayout(iinputLayout);
+
+    auto vb = vertexBuffer.Get();
+    UINT vbStride = vertexStride;
+    UINT vbOffset = 0;
+    deviceContext->IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
+
+    deviceContext->IASetIndexBuffer(lodIndexBuffer.Get(), indexFormat, 0);
+
+    assert(ieffect != nullptr);
+    ieffect->Apply(deviceContext);
+
+    if (setCustomState)
+    {
+        setCustomState();
+        InvalidateEffectStateCache(deviceContext);
+    }
+
+    deviceContext->IASetPrimitiveTopology(primitiveType);
+
+    deviceContext->DrawIndexed(lod.indexCount, lod.startIndex, vertexOffset);
+}
+
+
 _Use_decl_annotations_
 void ModelMeshPart::DrawInstanced(
     ID3D11DeviceContext* deviceContext,
@@ -100,6 +160,7 @@ void ModelMeshPart::DrawInstanced(
     if (setCustomState)
     {
         setCustomState();
+        InvalidateEffectStateCache(deviceContext);
     }
 
     // Draw the primitive.
@@ -141,6 +202,38 @@ void ModelMeshPart::CreateInputLayout(ID3D11Device* d3dDevice, IEffect* ieffect,
 }
 
 
+_Use_decl_annotations_
+void ModelMeshPart::CreateInstancedInputLayout(ID3D11Device* d3dDevice, IEffect* ieffect, ID3D11InputLayout** iinputLayout) const
+{
+    if (!vbDecl || vbDecl->empty())
+        throw std::exception("Model mesh part missing vertex buffer input elements data");
+
+    if (vbDecl->size() + _countof(s_instanceElements) > D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT)
+        throw std::exception("Model mesh part input layout size is too large for DirectX 11 instancing");
+
+    std::vector<D3D11_INPUT_ELEMENT_DESC> decl(vbDecl->cbegin(), vbDecl->cend());
+    decl.insert(decl.end(), std::begin(s_instanceElements), std::end(s_instanceElements));
+
+    void const* shaderByteCode;
+    size_t byteCodeLength;
+
+    assert(ieffect != nullptr);
+    ieffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+    assert(d3dDevice != nullptr);
+
+    ThrowIfFailed(
+        d3dDevice->CreateInputLayout(decl.data(),
+        static_cast<UINT>(decl.size()),
+        shaderByteCode, byteCodeLength,
+        iinputLayout)
+    );
+
+    assert(iinputLayout != nullptr && *iinputLayout != nullptr);
+    _Analysis_assume_(iinputLayout != nullptr && *iinputLayout != nullptr);
+}
+
+
 _Use_decl_annotations_
 void ModelMeshPart::ModifyEffect(ID3D11Device* d3dDevice, std::shared_ptr<IEffect>& ieffect, bool isalpha)
 {
@@ -154,6 +247,9 @@ void ModelMeshPart::ModifyEffect(ID3D11Device* d3dDevice, std::shared_ptr<IEffec
     this->effect = ieffect;
     this->isAlpha = isalpha;
 
+    // Recreated on demand by the next instanced draw.
+    instancedInputLayout.Reset();
+
     void const* shaderByteCode;
     size_t byteCodeLength;
 
@@ -170,13 +266,28 @@ void ModelMeshPart::ModifyEffect(ID3D11Device* d3dDevice, std::shared_ptr<IEffec
 }
 
 
+IEffectMatrices* ModelMeshPart::GetEffectMatrices() const
+{
+    // Comparing ownership rather than addresses catches a replacement effect that reuses a freed effect's address,
+    // because the weak reference keeps the old control block alive.
+    if (mMatricesEffect.owner_before(effect) || effect.owner_before(mMatricesEffect))
+    {
+        mMatricesEffect = effect;
+        mEffectMatrices = dynamic_cast<IEffectMatrices*>(effect.get());
+    }
+
+    return mEffectMatrices;
+}
+
+
 //--------------------------------------------------------------------------------------
 // ModelMesh
 //--------------------------------------------------------------------------------------
 
 ModelMesh::ModelMesh() noexcept :
     ccw(true),
-    pmalpha(true)
+    pmalpha(true),
+    boneIndex(ModelBone::c_Invalid)
 {
 }
 
@@ -192,6 +303,19 @@ void ModelMesh::PrepareForRendering(
     const CommonStates& states,
     bool alpha,
     bool wireframe) const
+{
+    ModelRenderState renderState;
+    PrepareForRendering(deviceContext, states, renderState, alpha, wireframe);
+}
+
+
+_Use_decl_annotations_
+void ModelMesh::PrepareForRendering(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    ModelRenderState& renderState,
+    bool alpha,
+    bool wireframe) const
 {
     assert(deviceContext != nullptr);
 
@@ -218,23 +342,46 @@ void ModelMesh::PrepareForRendering(
         depthStencilState = states.DepthDefault();
     }
 
-    deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
-    deviceContext->OMSetDepthStencilState(depthStencilState, 0);
+    if (blendState != renderState.blendState)
+    {
+        deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+        renderState.blendState = blendState;
+    }
+
+    if (depthStencilState != renderState.depthStencilState)
+    {
+        deviceContext->OMSetDepthStencilState(depthStencilState, 0);
+        renderState.depthStencilState = depthStencilState;
+    }
 
     // Set the rasterizer state.
+    ID3D11RasterizerState* rasterizerState;
+
     if (wireframe)
-        deviceContext->RSSetState(states.Wireframe());
+        rasterizerState = states.Wireframe();
     else
-        deviceContext->RSSetState(ccw ? states.CullCounterClockwise() : states.CullClockwise());
+        rasterizerState = ccw ? states.CullCounterClockwise() : states.CullClockwise();
+
+    if (rasterizerState != renderState.rasterizerState)
+    {
+        deviceContext->RSSetState(rasterizerState);
+        renderState.rasterizerState = rasterizerState;
+    }
 
     // Set sampler state.
-    ID3D11SamplerState* samplers[] =
+    ID3D11SamplerState* samplerState = states.LinearWrap();
+
+    if (samplerState != renderState.samplerState)
     {
-        states.LinearWrap(),
-        states.LinearWrap(),
-    };
+        ID3D11SamplerState* samplers[] =
+        {
+            samplerState,
+            samplerState,
+        };
 
-    deviceContext->PSSetSamplers(0, 2, samplers);
+        deviceContext->PSSetSamplers(0, 2, samplers);
+        renderState.samplerState = samplerState;
+    }
 }
 
 
@@ -260,7 +407,7 @@ void XM_CALLCONV ModelMesh::Draw(
             continue;
         }
 
-        auto imatrices = dynamic_cast<IEffectMatrices*>(part->effect.get());
+        auto imatrices = part->GetEffectMatrices();
         if (imatrices)
         {
             imatrices->SetMatrices(world, view, projection);
@@ -271,6 +418,59 @@ void XM_CALLCONV ModelMesh::Draw(
 }
 
 
+_Use_decl_annotations_
+void XM_CALLCONV ModelMesh::DrawInstanced(
+    ID3D11DeviceContext* deviceContext,
+    uint32_t instanceCount,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool alpha,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    for (auto it = meshParts.cbegin(); it != meshParts.cend(); ++it)
+    {
+        auto part = (*it).get();
+        assert(part != nullptr);
+
+        if (part->isAlpha != alpha)
+        {
+            // Skip alpha parts when drawing opaque or skip opaque parts if drawing alpha
+            continue;
+        }
+
+        auto iinstancing = dynamic_cast<IEffectInstancing*>(part->effect.get());
+        if (!iinstancing)
+        {
+            throw std::exception("ModelMesh::DrawInstanced requires effects that support IEffectInstancing");
+        }
+
+        auto imatrices = part->GetEffectMatrices();
+        if (imatrices)
+        {
+            imatrices->SetMatrices(world, view, projection);
+        }
+
+        iinstancing->SetInstancingEnabled(true);
+
+        if (!part->instancedInputLayout)
+        {
+            ComPtr<ID3D11Device> device;
+            deviceContext->GetDevice(device.GetAddressOf());
+
+            part->CreateInstancedInputLayout(device.Get(), part->effect.get(), part->instancedInputLayout.ReleaseAndGetAddressOf());
+        }
+
+        part->DrawInstanced(deviceContext, part->effect.get(), part->instancedInputLayout.Get(), instanceCount, 0, setCustomState);
+
+        // Shared effects go back to their regular shaders for non-instanced draws.
+        iinstancing->SetInstancingEnabled(false);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------
 // Model
 //--------------------------------------------------------------------------------------
@@ -288,30 +488,658 @@ void XM_CALLCONV Model::Draw(
     CXMMATRIX view,
     CXMMATRIX projection,
     bool wireframe, std::function<void()> setCustomState) const
+{
+    ModelRenderState renderState;
+    Draw(deviceContext, states, renderState, world, view, projection, wireframe, setCustomState);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    ModelRenderState& renderState,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe, std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::Draw");
+
+    DrawMeshesOpaqueThenAlpha(deviceContext, states, renderState, meshes, nullptr, wireframe, setCustomState,
+        [&](size_t, ModelMesh const& mesh, bool alpha)
+        {
+            mesh.Draw(deviceContext, world, view, projection, alpha, setCustomState);
+        });
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawSkinned(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    size_t nbones,
+    const XMMATRIX* boneTransforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    if (!nbones || !boneTransforms)
+        throw std::exception("Bone transforms are required");
+
+    if (nbones > IEffectSkinning::MaxBones)
+        throw std::exception("Too many bones for skinning");
+
+    // Effects are shared between parts, so each is only given the palette once.
+    std::set<IEffect*> updated;
+
+    for (auto const& mesh : meshes)
+    {
+        for (auto const& part : mesh->meshParts)
+        {
+            auto effect = part->effect.get();
+            if (!updated.insert(effect).second)
+                continue;
+
+            auto iskinning = dynamic_cast<IEffectSkinning*>(effect);
+            if (iskinning)
+            {
+                iskinning->SetBoneTransforms(boneTransforms, nbones);
+            }
+        }
+    }
+
+    ModelRenderState renderState;
+    Draw(deviceContext, states, renderState, world, view, projection, wireframe, setCustomState);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawPass(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    EffectPass pass,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    std::function<void()> setCustomState) const
 {
     assert(deviceContext != nullptr);
 
-    // Draw opaque parts
-    for (auto it = meshes.cbegin(); it != meshes.cend(); ++it)
+    ModelRenderState renderState;
+
+    for (auto const& mesh : meshes)
     {
-        auto mesh = it->get();
         assert(mesh != nullptr);
 
-        mesh->PrepareForRendering(deviceContext, states, false, wireframe);
+        mesh->PrepareForRendering(deviceContext, states, renderState, false, false);
+
+        for (auto const& part : mesh->meshParts)
+        {
+            assert(part != nullptr);
+
+            if (part->isAlpha)
+                continue;
 
-        mesh->Draw(deviceContext, world, view, projection, false, setCustomState);
+            auto ipass = dynamic_cast<IEffectPass*>(part->effect.get());
+            if (!ipass && pass == EffectPass_VelocityOnly)
+                continue;
+
+            auto imatrices = part->GetEffectMatrices();
+            if (imatrices)
+            {
+                imatrices->SetMatrices(world, view, projection);
+            }
+
+            if (ipass)
+            {
+                ipass->SetPass(pass);
+            }
+
+            part->Draw(deviceContext, part->effect.get(), part->inputLayout.Get(), setCustomState);
+
+            if (ipass)
+            {
+                ipass->SetPass(EffectPass_Default);
+            }
+        }
+
+        if (setCustomState)
+            renderState.Reset();
     }
+}
+
 
-    // Draw alpha parts
-    for (auto it = meshes.cbegin(); it != meshes.cend(); ++it)
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawMultiView(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    MultiView& multiView,
+    FXMMATRIX world,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::DrawMultiView");
+
+    auto viewCount = static_cast<uint32_t>(multiView.GetViewCount());
+    if (!viewCount)
+        throw std::exception("MultiView::SetViews must be called before drawing");
+
+    // View 0 stands in for the eye position used for specular and fog.
+    XMMATRIX view = multiView.GetView(0);
+    XMMATRIX projection = multiView.GetProjection(0);
+
+    ModelRenderState renderState;
+
+    DrawMeshesOpaqueThenAlpha(deviceContext, states, renderState, meshes, nullptr, wireframe, setCustomState,
+        [&](size_t, ModelMesh const& mesh, bool alpha)
+        {
+            for (auto const& part : mesh.meshParts)
+            {
+                assert(part != nullptr);
+
+                if (part->isAlpha != alpha)
+                    continue;
+
+                auto imultiview = dynamic_cast<IEffectMultiView*>(part->effect.get());
+                if (!imultiview)
+                {
+                    throw std::exception("Model::DrawMultiView requires effects that support IEffectMultiView");
+                }
+
+                auto imatrices = part->GetEffectMatrices();
+                if (imatrices)
+                {
+                    imatrices->SetMatrices(world, view, projection);
+                }
+
+                imultiview->SetMultiView(&multiView);
+
+                part->DrawInstanced(deviceContext, part->effect.get(), part->inputLayout.Get(), viewCount, 0, setCustomState);
+
+                imultiview->SetMultiView(nullptr);
+            }
+        });
+}
+
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    // Placement buffer object describing the instance stream; the memory itself comes from GraphicsMemory.
+    ID3D11Buffer* DemandCreatePlacementBuffer(_In_ ID3D11DeviceContext* deviceContext, ComPtr<ID3D11Buffer>& placementBuffer)
     {
-        auto mesh = it->get();
-        assert(mesh != nullptr);
+        if (!placementBuffer)
+        {
+            ComPtr<ID3D11Device> device;
+            deviceContext->GetDevice(device.GetAddressOf());
+
+            ComPtr<ID3D11DeviceX> deviceX;
+            ThrowIfFailed(device.As(&deviceX));
 
-        mesh->PrepareForRendering(deviceContext, states, true, wireframe);
+            D3D11_BUFFER_DESC desc = {};
+            desc.ByteWidth = static_cast<UINT>(Model::MaxInstanceCount * c_instanceStride);
+            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-        mesh->Draw(deviceContext, world, view, projection, true, setCustomState);
+            ThrowIfFailed(
+                deviceX->CreatePlacementBuffer(&desc, nullptr, placementBuffer.ReleaseAndGetAddressOf())
+            );
+
+            SetDebugObjectName(placementBuffer.Get(), "DirectXTK:Model");
+        }
+
+        return placementBuffer.Get();
+    }
+#endif
+
+
+    // Sets up vertex buffer slot 1 with room for the instance transforms, returning where to write them.
+    XMFLOAT4* MapInstanceTransforms(_In_ ID3D11DeviceContext* deviceContext, size_t instanceCount, _In_opt_ ID3D11Buffer* placementBuffer)
+    {
+        if (!instanceCount || instanceCount > Model::MaxInstanceCount)
+            throw std::out_of_range("Model instance count out of range");
+
+        size_t size = instanceCount * c_instanceStride;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        void* grfxMemory = GraphicsMemory::Get().Allocate(deviceContext, size, 16);
+
+        ComPtr<ID3D11DeviceContextX> deviceContextX;
+        ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+        deviceContextX->IASetPlacementVertexBuffer(1, placementBuffer, grfxMemory, c_instanceStride);
+
+        return static_cast<XMFLOAT4*>(grfxMemory);
+    #else
+        UNREFERENCED_PARAMETER(placementBuffer);
+
+        ID3D11Buffer* buffer;
+        UINT offset;
+        void* mapped = GraphicsMemory::Get().MapUpload(deviceContext, D3D11_BIND_VERTEX_BUFFER, size, 16, &buffer, &offset);
+
+        deviceContext->IASetVertexBuffers(1, 1, &buffer, &c_instanceStride, &offset);
+
+        return static_cast<XMFLOAT4*>(mapped);
+    #endif
+    }
+
+
+    void UnmapInstanceTransforms(_In_ ID3D11DeviceContext* deviceContext)
+    {
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        UNREFERENCED_PARAMETER(deviceContext);
+    #else
+        GraphicsMemory::Get().UnmapUpload(deviceContext, D3D11_BIND_VERTEX_BUFFER);
+    #endif
+    }
+
+
+    void XM_CALLCONV DrawMeshesInstanced(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const CommonStates& states,
+        ModelMesh::Collection const& meshes,
+        uint32_t instanceCount,
+        FXMMATRIX world,
+        CXMMATRIX view,
+        CXMMATRIX projection,
+        bool wireframe,
+        std::function<void()> const& setCustomState)
+    {
+        ModelRenderState renderState;
+
+        DrawMeshesOpaqueThenAlpha(deviceContext, states, renderState, meshes, nullptr, wireframe, setCustomState,
+            [&](size_t, ModelMesh const& mesh, bool alpha)
+            {
+                mesh.DrawInstanced(deviceContext, instanceCount, world, view, projection, alpha, setCustomState);
+            });
+
+        // Unbind the instance stream so it does not leak into later draws.
+        ID3D11Buffer* nullBuffer = nullptr;
+        UINT zero = 0;
+        deviceContext->IASetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+    }
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawInstanced(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const XMFLOAT4X4* instanceTransforms,
+    size_t instanceCount,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe, std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+    assert(instanceTransforms != nullptr);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    auto dest = MapInstanceTransforms(deviceContext, instanceCount, DemandCreatePlacementBuffer(deviceContext, mInstancePlacementBuffer));
+#else
+    auto dest = MapInstanceTransforms(deviceContext, instanceCount, nullptr);
+#endif
+
+    // The shaders take the transposed upper three columns, which is the layout of XMFLOAT3X4.
+    for (size_t j = 0; j < instanceCount; ++j)
+    {
+        XMMATRIX m = XMMatrixTranspose(XMLoadFloat4x4(&instanceTransforms[j]));
+
+        XMStoreFloat4(dest++, m.r[0]);
+        XMStoreFloat4(dest++, m.r[1]);
+        XMStoreFloat4(dest++, m.r[2]);
     }
+
+    UnmapInstanceTransforms(deviceContext);
+
+    DrawMeshesInstanced(deviceContext, states, meshes, static_cast<uint32_t>(instanceCount), world, view, projection, wireframe, setCustomState);
+}
+
+
+#if (DIRECTX_MATH_VERSION >= 313)
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawInstanced(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const XMFLOAT3X4* instanceTransforms,
+    size_t instanceCount,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe, std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+    assert(instanceTransforms != nullptr);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    auto dest = MapInstanceTransforms(deviceContext, instanceCount, DemandCreatePlacementBuffer(deviceContext, mInstancePlacementBuffer));
+#else
+    auto dest = MapInstanceTransforms(deviceContext, instanceCount, nullptr);
+#endif
+
+    memcpy(dest, instanceTransforms, instanceCount * c_instanceStride);
+
+    UnmapInstanceTransforms(deviceContext);
+
+    DrawMeshesInstanced(deviceContext, states, meshes, static_cast<uint32_t>(instanceCount), world, view, projection, wireframe, setCustomState);
+}
+#endif
+
+
+namespace
+{
+    // Normalized, inward-facing frustum planes of a world * view * projection matrix, in model space.
+    void XM_CALLCONV ExtractFrustumPlanes(FXMMATRIX worldViewProj, _Out_writes_(6) XMVECTOR* planes) noexcept
+    {
+        // Rows of the transpose are the columns of the clip transform.
+        XMMATRIX m = XMMatrixTranspose(worldViewProj);
+
+        planes[0] = XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[0]));         // left
+        planes[1] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[0]));    // right
+        planes[2] = XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[1]));         // bottom
+        planes[3] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[1]));    // top
+        planes[4] = XMPlaneNormalize(m.r[2]);                              // near
+        planes[5] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[2]));    // far
+    }
+
+
+    // World matrix of a mesh, taking in the absolute transform of the bone it is attached to.
+    XMMATRIX XM_CALLCONV GetMeshWorld(const ModelMesh& mesh, _In_opt_ const ModelTransforms* transforms, FXMMATRIX world)
+    {
+        if (transforms && mesh.boneIndex != ModelBone::c_Invalid)
+            return XMMatrixMultiply(transforms->GetAbsoluteTransform(mesh.boneIndex), world);
+
+        return world;
+    }
+
+
+    void CheckMeshBones(ModelMesh::Collection const& meshes, const ModelTransforms& transforms)
+    {
+        for (auto it = meshes.cbegin(); it != meshes.cend(); ++it)
+        {
+            auto boneIndex = (*it)->boneIndex;
+            if (boneIndex != ModelBone::c_Invalid && boneIndex >= transforms.GetBoneCount())
+                throw std::out_of_range("ModelTransforms has fewer bones than the model's meshes use");
+        }
+    }
+
+
+    // Marks each mesh whose bounding sphere is not entirely outside one of the model-space planes,
+    // testing four spheres against each plane at a time. With a transform hierarchy, spheres of meshes
+    // attached to a bone are first moved by its absolute transform.
+    void CullMeshSpheres(ModelMesh::Collection const& meshes, _In_opt_ const ModelTransforms* transforms,
+                         _In_reads_(6) XMVECTOR const* planes, std::vector<uint8_t>& visible)
+    {
+        XMVECTOR px[6], py[6], pz[6], pw[6];
+        for (size_t p = 0; p < 6; ++p)
+        {
+            px[p] = XMVectorSplatX(planes[p]);
+            py[p] = XMVectorSplatY(planes[p]);
+            pz[p] = XMVectorSplatZ(planes[p]);
+            pw[p] = XMVectorSplatW(planes[p]);
+        }
+
+        size_t count = meshes.size();
+        visible.resize(count);
+
+        for (size_t j = 0; j < count; j += 4)
+        {
+            XMFLOAT4A x(0.f, 0.f, 0.f, 0.f), y(0.f, 0.f, 0.f, 0.f), z(0.f, 0.f, 0.f, 0.f), r(0.f, 0.f, 0.f, 0.f);
+
+            size_t lanes = std::min<size_t>(4, count - j);
+            for (size_t k = 0; k < lanes; ++k)
+            {
+                auto mesh = meshes[j + k].get();
+
+                BoundingSphere sphere = mesh->boundingSphere;
+                if (transforms && mesh->boneIndex != ModelBone::c_Invalid)
+                {
+                    mesh->boundingSphere.Transform(sphere, transforms->GetAbsoluteTransform(mesh->boneIndex));
+                }
+
+                (&x.x)[k] = sphere.Center.x;
+                (&y.x)[k] = sphere.Center.y;
+                (&z.x)[k] = sphere.Center.z;
+                (&r.x)[k] = sphere.Radius;
+            }
+
+            XMVECTOR vx = XMLoadFloat4A(&x);
+            XMVECTOR vy = XMLoadFloat4A(&y);
+            XMVECTOR vz = XMLoadFloat4A(&z);
+            XMVECTOR negRadius = XMVectorNegate(XMLoadFloat4A(&r));
+
+            XMVECTOR outside = XMVectorFalseInt();
+            for (size_t p = 0; p < 6; ++p)
+            {
+                XMVECTOR dist = XMVectorMultiplyAdd(px[p], vx, XMVectorMultiplyAdd(py[p], vy, XMVectorMultiplyAdd(pz[p], vz, pw[p])));
+                outside = XMVectorOrInt(outside, XMVectorLess(dist, negRadius));
+            }
+
+            XMUINT4 result;
+            XMStoreUInt4(&result, outside);
+
+            for (size_t k = 0; k < lanes; ++k)
+            {
+                visible[j + k] = ((&result.x)[k] == 0) ? 1 : 0;
+            }
+        }
+    }
+
+
+    size_t XM_CALLCONV DrawVisibleMeshes(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const CommonStates& states,
+        ModelMesh::Collection const& meshes,
+        _In_opt_ const ModelTransforms* transforms,
+        std::vector<uint8_t>& visible,
+        FXMMATRIX world,
+        CXMMATRIX view,
+        CXMMATRIX projection,
+        bool wireframe,
+        std::function<void()> const& setCustomState,
+        ModelOcclusionTest const& isOccluded)
+    {
+        size_t drawn = 0;
+
+        for (size_t j = 0; j < meshes.size(); ++j)
+        {
+            if (visible[j] && isOccluded)
+            {
+                BoundingBox worldBounds;
+                meshes[j]->boundingBox.Transform(worldBounds, GetMeshWorld(*meshes[j], transforms, world));
+
+                if (isOccluded(*meshes[j], worldBounds))
+                    visible[j] = 0;
+            }
+
+            if (visible[j])
+                ++drawn;
+        }
+
+        if (!drawn)
+            return 0;
+
+        ModelRenderState renderState;
+
+        DrawMeshesOpaqueThenAlpha(deviceContext, states, renderState, meshes, visible.data(), wireframe, setCustomState,
+            [&](size_t, ModelMesh const& mesh, bool alpha)
+            {
+                mesh.Draw(deviceContext, GetMeshWorld(mesh, transforms, world), view, projection, alpha, setCustomState);
+            });
+
+        return drawn;
+    }
+
+
+    size_t XM_CALLCONV DrawMeshesCulled(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const CommonStates& states,
+        ModelMesh::Collection const& meshes,
+        _In_opt_ const ModelTransforms* transforms,
+        FXMMATRIX world,
+        CXMMATRIX view,
+        CXMMATRIX projection,
+        bool wireframe,
+        std::function<void()> const& setCustomState,
+        ModelOcclusionTest const& isOccluded)
+    {
+        // Planes taken from the combined matrix are already in model space, so the spheres need no transforming.
+        XMVECTOR planes[6];
+        ExtractFrustumPlanes(XMMatrixMultiply(XMMatrixMultiply(world, view), projection), planes);
+
+        std::vector<uint8_t> visible;
+        CullMeshSpheres(meshes, transforms, planes, visible);
+
+        return DrawVisibleMeshes(deviceContext, states, meshes, transforms, visible, world, view, projection, wireframe, setCustomState, isOccluded);
+    }
+
+
+    size_t XM_CALLCONV DrawMeshesCulled(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const CommonStates& states,
+        ModelMesh::Collection const& meshes,
+        _In_opt_ const ModelTransforms* transforms,
+        const BoundingFrustum& frustum,
+        FXMMATRIX world,
+        CXMMATRIX view,
+        CXMMATRIX projection,
+        bool wireframe,
+        std::function<void()> const& setCustomState,
+        ModelOcclusionTest const& isOccluded)
+    {
+        // BoundingFrustum planes face outward in world space. Flip them, and take them into model space
+        // (a plane transforms by the transpose of the matrix that maps model space to world space).
+        XMVECTOR planes[6];
+        frustum.GetPlanes(&planes[4], &planes[5], &planes[1], &planes[0], &planes[3], &planes[2]);
+
+        XMMATRIX toModel = XMMatrixTranspose(world);
+
+        for (size_t p = 0; p < 6; ++p)
+        {
+            planes[p] = XMPlaneNormalize(XMPlaneTransform(XMVectorNegate(planes[p]), toModel));
+        }
+
+        std::vector<uint8_t> visible;
+        CullMeshSpheres(meshes, transforms, planes, visible);
+
+        return DrawVisibleMeshes(deviceContext, states, meshes, transforms, visible, world, view, projection, wireframe, setCustomState, isOccluded);
+    }
+}
+
+
+_Use_decl_annotations_
+size_t XM_CALLCONV Model::DrawCulled(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState,
+    ModelOcclusionTest isOccluded) const
+{
+    assert(deviceContext != nullptr);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::DrawCulled");
+
+    return DrawMeshesCulled(deviceContext, states, meshes, nullptr, world, view, projection, wireframe, setCustomState, isOccluded);
+}
+
+
+_Use_decl_annotations_
+size_t XM_CALLCONV Model::DrawCulled(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const BoundingFrustum& frustum,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState,
+    ModelOcclusionTest isOccluded) const
+{
+    assert(deviceContext != nullptr);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::DrawCulled");
+
+    return DrawMeshesCulled(deviceContext, states, meshes, nullptr, frustum, world, view, projection, wireframe, setCustomState, isOccluded);
+}
+
+
+_Use_decl_annotations_
+size_t XM_CALLCONV Model::DrawCulled(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const ModelTransforms& transforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState,
+    ModelOcclusionTest isOccluded) const
+{
+    assert(deviceContext != nullptr);
+
+    CheckMeshBones(meshes, transforms);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::DrawCulled");
+
+    return DrawMeshesCulled(deviceContext, states, meshes, &transforms, world, view, projection, wireframe, setCustomState, isOccluded);
+}
+
+
+_Use_decl_annotations_
+size_t XM_CALLCONV Model::DrawCulled(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const BoundingFrustum& frustum,
+    const ModelTransforms& transforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState,
+    ModelOcclusionTest isOccluded) const
+{
+    assert(deviceContext != nullptr);
+
+    CheckMeshBones(meshes, transforms);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::DrawCulled");
+
+    return DrawMeshesCulled(deviceContext, states, meshes, &transforms, frustum, world, view, projection, wireframe, setCustomState, isOccluded);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const ModelTransforms& transforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe, std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    CheckMeshBones(meshes, transforms);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::Draw");
+
+    std::vector<uint8_t> visible(meshes.size(), 1);
+    (void)DrawVisibleMeshes(deviceContext, states, meshes, &transforms, visible, world, view, projection, wireframe, setCustomState, nullptr);
 }
 
 
@@ -340,3 +1168,43 @@ void Model::UpdateEffects(_In_ std::function<void(IEffect*)> setEffect)
         setEffect(*it);
     }
 }
+
+
+void Model::TrackMemory() const noexcept
+{
+    if (!MemoryTracker::IsEnabled())
+        return;
+
+    const wchar_t* owner = name.empty() ? L"Model" : name.c_str();
+
+    // Parts usually share buffers, so each is recorded once.
+    std::set<ID3D11Buffer*> tracked;
+
+    auto track = [&](ID3D11Buffer* buffer, MemoryCategory category)
+    {
+        if (buffer && tracked.insert(buffer).second)
+            MemoryTracker::TrackResource(buffer, category, owner);
+    };
+
+    try
+    {
+        for (auto mit = meshes.cbegin(); mit != meshes.cend(); ++mit)
+        {
+            auto mesh = mit->get();
+            assert(mesh != nullptr);
+
+            for (auto it = mesh->meshParts.cbegin(); it != mesh->meshParts.cend(); ++it)
+            {
+                auto part = it->get();
+                assert(part != nullptr);
+
+                track(part->vertexBuffer.Get(), MemoryCategory_VertexBuffer);
+                track(part->indexBuffer.Get(), MemoryCategory_IndexBuffer);
+                track(part->lodIndexBuffer.Get(), MemoryCategory_IndexBuffer);
+            }
+        }
+    }
+    catch (...)
+    {
+    }
+}
@@ -0,0 +1,318 @@
+//--------------------------------------------------------------------------------------
+// File: ModelAnimation.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ModelAnimation.h"
+
+#include "PlatformHelpers.h"
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // Normalized linear quaternion interpolation, taking the shorter way round. Much cheaper than a slerp, and
+    // indistinguishable from one between neighbouring frames or for blending similar poses.
+    inline XMVECTOR XM_CALLCONV QuaternionNlerp(FXMVECTOR q0, FXMVECTOR q1, float t) noexcept
+    {
+        XMVECTOR dot = XMVector4Dot(q0, q1);
+        XMVECTOR target = XMVectorSelect(q1, XMVectorNegate(q1), XMVectorLess(dot, XMVectorZero()));
+
+        return XMQuaternionNormalize(XMVectorLerp(q0, target, t));
+    }
+
+
+    void XM_CALLCONV DecomposeTransform(FXMMATRIX transform, XMFLOAT3& scale, XMFLOAT4& rotation, XMFLOAT3& translation)
+    {
+        XMVECTOR s, r, t;
+        if (!XMMatrixDecompose(&s, &r, &t, transform))
+        {
+            // Degenerate matrices (such as a zero scale) keep their translation.
+            s = XMVectorZero();
+            r = XMQuaternionIdentity();
+            t = transform.r[3];
+        }
+
+        XMStoreFloat3(&scale, s);
+        XMStoreFloat4(&rotation, r);
+        XMStoreFloat3(&translation, t);
+    }
+
+
+    void LerpPose(size_t count,
+        const XMFLOAT3* scales0, const XMFLOAT4* rotations0, const XMFLOAT3* translations0,
+        const XMFLOAT3* scales1, const XMFLOAT4* rotations1, const XMFLOAT3* translations1,
+        float t,
+        XMFLOAT3* scales, XMFLOAT4* rotations, XMFLOAT3* translations) noexcept
+    {
+        for (size_t j = 0; j < count; ++j)
+        {
+            XMStoreFloat3(&scales[j], XMVectorLerp(XMLoadFloat3(&scales0[j]), XMLoadFloat3(&scales1[j]), t));
+        }
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            XMStoreFloat4(&rotations[j], QuaternionNlerp(XMLoadFloat4(&rotations0[j]), XMLoadFloat4(&rotations1[j]), t));
+        }
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            XMStoreFloat3(&translations[j], XMVectorLerp(XMLoadFloat3(&translations0[j]), XMLoadFloat3(&translations1[j]), t));
+        }
+    }
+}
+
+
+//======================================================================================
+// AnimationPose
+//======================================================================================
+
+AnimationPose::AnimationPose(size_t boneCount)
+{
+    Resize(boneCount);
+}
+
+
+void AnimationPose::Resize(size_t boneCount)
+{
+    scales.resize(boneCount, XMFLOAT3(1.f, 1.f, 1.f));
+    rotations.resize(boneCount, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+    translations.resize(boneCount, XMFLOAT3(0.f, 0.f, 0.f));
+}
+
+
+void AnimationPose::SetBindPose(const ModelBone::Collection& bones)
+{
+    Resize(bones.size());
+
+    for (size_t j = 0; j < bones.size(); ++j)
+    {
+        DecomposeTransform(XMLoadFloat4x4(&bones[j].localTransform), scales[j], rotations[j], translations[j]);
+    }
+}
+
+
+void AnimationPose::Blend(const AnimationPose& a, const AnimationPose& b, float weight, AnimationPose& result)
+{
+    size_t count = a.GetBoneCount();
+    if (b.GetBoneCount() != count)
+        throw std::exception("Poses to blend must have the same bone count");
+
+    result.Resize(count);
+
+    LerpPose(count,
+        a.scales.data(), a.rotations.data(), a.translations.data(),
+        b.scales.data(), b.rotations.data(), b.translations.data(),
+        weight,
+        result.scales.data(), result.rotations.data(), result.translations.data());
+}
+
+
+_Use_decl_annotations_
+void AnimationPose::GetBonePalette(const ModelBone::Collection& bones, XMMATRIX* palette, size_t count) const
+{
+    if (!palette || count < bones.size())
+        throw std::exception("Bone palette too small");
+
+    if (GetBoneCount() != bones.size())
+        throw std::exception("Pose does not match skeleton");
+
+    // Model space transform of each bone goes into the palette first; parents precede children,
+    // so a parent's entry is always final by the time its children read it.
+    for (size_t j = 0; j < bones.size(); ++j)
+    {
+        XMMATRIX local = XMMatrixAffineTransformation(XMLoadFloat3(&scales[j]), g_XMZero, XMLoadFloat4(&rotations[j]), XMLoadFloat3(&translations[j]));
+
+        uint32_t parent = bones[j].parentIndex;
+        if (parent != ModelBone::c_Invalid)
+        {
+            assert(parent < j);
+            local = XMMatrixMultiply(local, palette[parent]);
+        }
+
+        palette[j] = local;
+    }
+
+    // Then skinning transform: vertices go from bind pose to model space.
+    for (size_t j = 0; j < bones.size(); ++j)
+    {
+        palette[j] = XMMatrixMultiply(XMLoadFloat4x4(&bones[j].invBindPose), palette[j]);
+    }
+}
+
+
+//======================================================================================
+// AnimationClip
+//======================================================================================
+
+_Use_decl_annotations_
+AnimationClip::AnimationClip(const wchar_t* name, const ModelBone::Collection& bones, float startTime, float endTime,
+                             const Keyframe* keyframes, size_t keyframeCount, float sampleRate) :
+    mName(name ? name : L""),
+    mDuration(std::max(endTime - startTime, 0.f)),
+    mSampleRate(sampleRate),
+    mBoneCount(bones.size()),
+    mFrameCount(0)
+{
+    if (sampleRate <= 0.f)
+        throw std::out_of_range("Sample rate must be positive");
+
+    if (keyframeCount > 0 && !keyframes)
+        throw std::exception("Keyframes are required");
+
+    // Sort each bone's keyframes by time.
+    std::vector<std::vector<const Keyframe*>> tracks(mBoneCount);
+
+    size_t dropped = 0;
+
+    for (size_t j = 0; j < keyframeCount; ++j)
+    {
+        if (keyframes[j].boneIndex >= mBoneCount)
+        {
+            ++dropped;
+            continue;
+        }
+
+        tracks[keyframes[j].boneIndex].push_back(&keyframes[j]);
+    }
+
+    if (dropped)
+    {
+        DebugTrace("WARNING: AnimationClip '%ls' ignored %zu keyframes for bones the skeleton does not have\n", mName.c_str(), dropped);
+    }
+
+    for (auto& track : tracks)
+    {
+        std::stable_sort(track.begin(), track.end(), [](const Keyframe* a, const Keyframe* b) noexcept
+        {
+            return a->time < b->time;
+        });
+    }
+
+    // One frame at each sample point, plus a final one at the end of the clip.
+    mFrameCount = static_cast<size_t>(std::ceil(mDuration * sampleRate)) + 1;
+
+    mScales.resize(mFrameCount * mBoneCount);
+    mRotations.resize(mFrameCount * mBoneCount);
+    mTranslations.resize(mFrameCount * mBoneCount);
+
+    for (size_t bone = 0; bone < mBoneCount; ++bone)
+    {
+        auto& track = tracks[bone];
+
+        // Keyframes are decomposed once, then interpolated for each frame between them.
+        XMFLOAT3 bindScale;
+        XMFLOAT4 bindRotation;
+        XMFLOAT3 bindTranslation;
+        DecomposeTransform(XMLoadFloat4x4(&bones[bone].localTransform), bindScale, bindRotation, bindTranslation);
+
+        std::vector<XMFLOAT3> keyScales(track.size());
+        std::vector<XMFLOAT4> keyRotations(track.size());
+        std::vector<XMFLOAT3> keyTranslations(track.size());
+
+        for (size_t k = 0; k < track.size(); ++k)
+        {
+            DecomposeTransform(XMLoadFloat4x4(&track[k]->transform), keyScales[k], keyRotations[k], keyTranslations[k]);
+        }
+
+        size_t key = 0;
+
+        for (size_t frame = 0; frame < mFrameCount; ++frame)
+        {
+            size_t index = frame * mBoneCount + bone;
+
+            if (track.empty())
+            {
+                mScales[index] = bindScale;
+                mRotations[index] = bindRotation;
+                mTranslations[index] = bindTranslation;
+                continue;
+            }
+
+            float time = startTime + std::min(float(frame) / sampleRate, mDuration);
+
+            while (key + 1 < track.size() && track[key + 1]->time <= time)
+                ++key;
+
+            size_t next = std::min(key + 1, track.size() - 1);
+
+            float t = 0.f;
+            if (next != key && time > track[key]->time)
+            {
+                t = std::min((time - track[key]->time) / (track[next]->time - track[key]->time), 1.f);
+            }
+
+            LerpPose(1,
+                &keyScales[key], &keyRotations[key], &keyTranslations[key],
+                &keyScales[next], &keyRotations[next], &keyTranslations[next],
+                t,
+                &mScales[index], &mRotations[index], &mTranslations[index]);
+        }
+    }
+}
+
+
+void AnimationClip::Sample(float time, bool loop, AnimationPose& pose) const
+{
+    if (loop && mDuration > 0.f)
+    {
+        time = fmodf(time, mDuration);
+        if (time < 0.f)
+            time += mDuration;
+    }
+    else
+    {
+        time = std::min(std::max(time, 0.f), mDuration);
+    }
+
+    float frame = time * mSampleRate;
+    size_t frame0 = std::min(static_cast<size_t>(frame), mFrameCount - 1);
+    size_t frame1 = std::min(frame0 + 1, mFrameCount - 1);
+    float t = std::min(frame - float(frame0), 1.f);
+
+    pose.Resize(mBoneCount);
+
+    size_t base0 = frame0 * mBoneCount;
+    size_t base1 = frame1 * mBoneCount;
+
+    LerpPose(mBoneCount,
+        &mScales[base0], &mRotations[base0], &mTranslations[base0],
+        &mScales[base1], &mRotations[base1], &mTranslations[base1],
+        t,
+        pose.scales.data(), pose.rotations.data(), pose.translations.data());
+}
+
+
+//======================================================================================
+// Bone palettes
+//======================================================================================
+
+_Use_decl_annotations_
+void DirectX::BuildBonePalettes(const ModelBone::Collection& bones, const AnimationPose* poses, size_t poseCount, XMMATRIX* palettes)
+{
+    if (!poseCount)
+        return;
+
+    if (!poses || !palettes)
+        throw std::exception("Poses and palettes are required");
+
+    size_t boneCount = bones.size();
+
+    for (size_t j = 0; j < poseCount; ++j)
+    {
+        if (poses[j].GetBoneCount() != boneCount)
+            throw std::exception("Pose does not match skeleton");
+    }
+
+    // Work items may not throw; the checks above cover everything GetBonePalette would reject.
+    ParallelFor(poseCount, [&](size_t index)
+    {
+        poses[index].GetBonePalette(bones, palettes + index * boneCount, boneCount);
+    });
+}
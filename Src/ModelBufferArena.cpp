@@ -0,0 +1,294 @@
+//--------------------------------------------------------------------------------------
+// File: ModelBufferArena.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "DirectXHelpers.h"
+#include "MemoryTracker.h"
+#include "PlatformHelpers.h"
+
+#include <map>
+#include <set>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    const uint32_t c_maxPageSize = D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u;
+
+    struct ArenaPage
+    {
+        ComPtr<ID3D11Buffer> buffer;
+        uint32_t capacity;
+        uint32_t used;
+    };
+
+    // Vertex data is grouped by stride and index data by index size, so every copy in a page lands on a
+    // whole element and parts can be addressed with vertexOffset and startIndex alone.
+    typedef std::pair<UINT, uint32_t> GroupKey;
+
+    struct SourceBuffer
+    {
+        ID3D11Buffer* buffer;
+        GroupKey group;
+        uint32_t size;
+
+        // Where the copy landed.
+        ID3D11Buffer* dest;
+        uint32_t elementOffset;
+    };
+
+    uint32_t AlignToElement(uint32_t offset, uint32_t elementSize) noexcept
+    {
+        return ((offset + elementSize - 1) / elementSize) * elementSize;
+    }
+}
+
+
+// Internal ModelBufferArena implementation class.
+class ModelBufferArena::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t pageSize)
+        : mDevice(device),
+        mPageSize(static_cast<uint32_t>(std::min<size_t>(pageSize, c_maxPageSize)))
+    {
+        if (!device)
+            throw std::exception("Device cannot be null");
+    }
+
+    void Pack(_In_ ID3D11DeviceContext* deviceContext, Model& model);
+
+    size_t GetPageCount() const noexcept
+    {
+        size_t count = 0;
+        for (auto const& it : mGroups)
+        {
+            count += it.second.size();
+        }
+        return count;
+    }
+
+    size_t GetBytesUsed() const noexcept
+    {
+        size_t bytes = 0;
+        for (auto const& it : mGroups)
+        {
+            for (auto const& page : it.second)
+            {
+                bytes += page.used;
+            }
+        }
+        return bytes;
+    }
+
+private:
+    ArenaPage& GetPage(GroupKey const& group, uint32_t size, uint32_t groupRemaining);
+
+    ComPtr<ID3D11Device> mDevice;
+    uint32_t mPageSize;
+
+    std::map<GroupKey, std::vector<ArenaPage>> mGroups;
+    std::set<ID3D11Buffer*> mPageBuffers;
+};
+
+
+// Returns a page of the group with room for size more bytes, creating one if needed. New pages are
+// sized for everything else still to be packed into the group, up to the largest buffer D3D11 allows.
+ArenaPage& ModelBufferArena::Impl::GetPage(GroupKey const& group, uint32_t size, uint32_t groupRemaining)
+{
+    auto& pages = mGroups[group];
+
+    if (!pages.empty())
+    {
+        auto& page = pages.back();
+        uint64_t offset = AlignToElement(page.used, group.second);
+        if (offset + size <= page.capacity)
+            return page;
+    }
+
+    ArenaPage page;
+    page.capacity = std::max(size, std::min(std::max(mPageSize, groupRemaining), c_maxPageSize));
+    page.used = 0;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = page.capacity;
+    desc.BindFlags = group.first;
+
+    ThrowIfFailed(
+        mDevice->CreateBuffer(&desc, nullptr, page.buffer.GetAddressOf())
+    );
+
+    SetDebugObjectName(page.buffer.Get(), "ModelBufferArena");
+
+    MemoryTracker::TrackResource(page.buffer.Get(),
+        (group.first & D3D11_BIND_VERTEX_BUFFER) ? MemoryCategory_VertexBuffer : MemoryCategory_IndexBuffer,
+        L"ModelBufferArena");
+
+    mPageBuffers.insert(page.buffer.Get());
+
+    pages.push_back(page);
+
+    return pages.back();
+}
+
+
+_Use_decl_annotations_
+void ModelBufferArena::Impl::Pack(ID3D11DeviceContext* deviceContext, Model& model)
+{
+    if (!deviceContext)
+        throw std::exception("Context cannot be null");
+
+    // Find each distinct buffer the parts use. A buffer read with two different strides is copied once for each.
+    std::vector<SourceBuffer> sources;
+    std::map<std::pair<ID3D11Buffer*, GroupKey>, size_t> sourceIndices;
+    std::map<GroupKey, uint32_t> groupSizes;
+
+    auto addSource = [&](ID3D11Buffer* buffer, GroupKey const& group)
+    {
+        // Buffers already in an arena stay where they are.
+        if (!buffer || mPageBuffers.find(buffer) != mPageBuffers.end())
+            return;
+
+        auto key = std::make_pair(buffer, group);
+        if (sourceIndices.find(key) != sourceIndices.end())
+            return;
+
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+
+        SourceBuffer source = { buffer, group, desc.ByteWidth, nullptr, 0 };
+
+        sourceIndices[key] = sources.size();
+        sources.push_back(source);
+
+        auto& groupSize = groupSizes[group];
+        groupSize = static_cast<uint32_t>(std::min<uint64_t>(uint64_t(groupSize) + desc.ByteWidth + group.second, c_maxPageSize));
+    };
+
+    for (auto const& mesh : model.meshes)
+    {
+        assert(mesh != nullptr);
+
+        for (auto const& part : mesh->meshParts)
+        {
+            assert(part != nullptr);
+
+            if (!part->vertexStride)
+                throw std::exception("ModelBufferArena requires a vertex stride for every mesh part");
+
+            addSource(part->vertexBuffer.Get(), GroupKey(D3D11_BIND_VERTEX_BUFFER, part->vertexStride));
+            addSource(part->indexBuffer.Get(), GroupKey(D3D11_BIND_INDEX_BUFFER, (part->indexFormat == DXGI_FORMAT_R32_UINT) ? 4u : 2u));
+        }
+    }
+
+    // Copy on the GPU, so no data comes back to the CPU.
+    for (auto& source : sources)
+    {
+        auto& remaining = groupSizes[source.group];
+
+        auto& page = GetPage(source.group, source.size, remaining);
+
+        uint32_t offset = AlignToElement(page.used, source.group.second);
+
+        D3D11_BOX box = { 0, 0, 0, source.size, 1, 1 };
+        deviceContext->CopySubresourceRegion(page.buffer.Get(), 0, offset, 0, 0, source.buffer, 0, &box);
+
+        page.used = offset + source.size;
+
+        source.dest = page.buffer.Get();
+        source.elementOffset = offset / source.group.second;
+
+        remaining -= std::min(remaining, source.size + source.group.second);
+    }
+
+    // Point the parts at their new homes.
+    for (auto const& mesh : model.meshes)
+    {
+        for (auto const& part : mesh->meshParts)
+        {
+            auto vb = sourceIndices.find(std::make_pair(part->vertexBuffer.Get(), GroupKey(D3D11_BIND_VERTEX_BUFFER, part->vertexStride)));
+            auto ib = sourceIndices.find(std::make_pair(part->indexBuffer.Get(), GroupKey(D3D11_BIND_INDEX_BUFFER, (part->indexFormat == DXGI_FORMAT_R32_UINT) ? 4u : 2u)));
+
+            if (vb != sourceIndices.end())
+            {
+                auto& source = sources[vb->second];
+
+                int64_t vertexOffset = int64_t(part->vertexOffset) + source.elementOffset;
+                if (vertexOffset > INT32_MAX)
+                    throw std::exception("ModelBufferArena vertex offset overflow");
+
+                part->vertexOffset = static_cast<int32_t>(vertexOffset);
+                part->vertexBuffer = source.dest;
+            }
+
+            if (ib != sourceIndices.end())
+            {
+                auto& source = sources[ib->second];
+
+                uint64_t startIndex = uint64_t(part->startIndex) + source.elementOffset;
+                if (startIndex > UINT32_MAX)
+                    throw std::exception("ModelBufferArena start index overflow");
+
+                part->startIndex = static_cast<uint32_t>(startIndex);
+                part->indexBuffer = source.dest;
+            }
+        }
+    }
+}
+
+
+// Public constructor.
+ModelBufferArena::ModelBufferArena(_In_ ID3D11Device* device, size_t pageSize)
+    : pImpl(std::make_unique<Impl>(device, pageSize))
+{
+}
+
+
+// Move constructor.
+ModelBufferArena::ModelBufferArena(ModelBufferArena&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ModelBufferArena& ModelBufferArena::operator= (ModelBufferArena&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ModelBufferArena::~ModelBufferArena()
+{
+}
+
+
+_Use_decl_annotations_
+void ModelBufferArena::Pack(ID3D11DeviceContext* deviceContext, Model& model)
+{
+    pImpl->Pack(deviceContext, model);
+}
+
+
+size_t ModelBufferArena::GetPageCount() const noexcept
+{
+    return pImpl->GetPageCount();
+}
+
+
+size_t ModelBufferArena::GetBytesUsed() const noexcept
+{
+    return pImpl->GetBytesUsed();
+}
@@ -0,0 +1,488 @@
+//--------------------------------------------------------------------------------------
+// File: ModelCooker.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "Effects.h"
+
+#include "PlatformHelpers.h"
+#include "LoaderHelpers.h"
+
+#include "CookedModel.h"
+
+#include <map>
+#include <mutex>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Copy of an EffectInfo that owns its strings.
+    struct MaterialInfo
+    {
+        IEffectFactory::EffectInfo  info;
+        std::wstring                name;
+        std::wstring                diffuseTexture;
+        std::wstring                specularTexture;
+        std::wstring                normalTexture;
+        std::wstring                emissiveTexture;
+        std::shared_ptr<IEffect>    effect;
+    };
+
+
+    // Builds the file image in memory, keeping each table and blob on its required alignment.
+    class CookedWriter
+    {
+    public:
+        uint32_t Append(_In_reads_bytes_(size) void const* data, size_t size, uint32_t alignment)
+        {
+            AlignTo(alignment);
+
+            uint64_t offset = mData.size();
+            if (offset + size > UINT32_MAX)
+                throw std::exception("Cooked model too large");
+
+            auto bytes = static_cast<uint8_t const*>(data);
+            mData.insert(mData.end(), bytes, bytes + size);
+
+            return static_cast<uint32_t>(offset);
+        }
+
+        template<typename T>
+        uint32_t AppendTable(std::vector<T> const& table)
+        {
+            return Append(table.data(), table.size() * sizeof(T), 4);
+        }
+
+        void AlignTo(uint32_t alignment)
+        {
+            mData.resize((mData.size() + alignment - 1) & ~size_t(alignment - 1));
+        }
+
+        std::vector<uint8_t> mData;
+    };
+
+
+    class StringTable
+    {
+    public:
+        uint32_t Add(_In_opt_z_ const wchar_t* str)
+        {
+            if (!str)
+                return CookedModel::NO_STRING;
+
+            auto it = mOffsets.find(str);
+            if (it != mOffsets.end())
+                return it->second;
+
+            auto offset = static_cast<uint32_t>(mChars.size() * sizeof(wchar_t));
+            mChars.insert(mChars.end(), str, str + wcslen(str) + 1);
+
+            mOffsets.insert(std::make_pair(std::wstring(str), offset));
+
+            return offset;
+        }
+
+        std::vector<wchar_t> mChars;
+
+    private:
+        std::map<std::wstring, uint32_t> mOffsets;
+    };
+
+
+    uint32_t GetSemantic(_In_z_ const char* semanticName)
+    {
+        for (uint32_t j = 0; CookedModel::GetSemanticName(j); ++j)
+        {
+            if (!_stricmp(semanticName, CookedModel::GetSemanticName(j)))
+                return j;
+        }
+
+        DebugTrace("ERROR: ModelCooker does not support vertex semantic '%s'\n", semanticName);
+        throw std::exception("Unknown vertex semantic");
+    }
+
+
+    // Copies a GPU buffer back into memory through a staging buffer.
+    void ReadBuffer(_In_ ID3D11DeviceContext* context, _In_ ID3D11Buffer* buffer, std::vector<uint8_t>& data)
+    {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+
+        ComPtr<ID3D11Device> device;
+        context->GetDevice(device.GetAddressOf());
+
+        D3D11_BUFFER_DESC stagingDesc = {};
+        stagingDesc.ByteWidth = desc.ByteWidth;
+        stagingDesc.Usage = D3D11_USAGE_STAGING;
+        stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        ComPtr<ID3D11Buffer> staging;
+        ThrowIfFailed(device->CreateBuffer(&stagingDesc, nullptr, staging.GetAddressOf()));
+
+        context->CopyResource(staging.Get(), buffer);
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        ThrowIfFailed(context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped));
+
+        auto bytes = static_cast<uint8_t const*>(mapped.pData);
+        data.assign(bytes, bytes + desc.ByteWidth);
+
+        context->Unmap(staging.Get(), 0);
+    }
+
+
+    template<typename T>
+    uint32_t IndexOf(std::vector<T>& items, T const& item)
+    {
+        auto it = std::find(items.begin(), items.end(), item);
+        if (it != items.end())
+            return static_cast<uint32_t>(it - items.begin());
+
+        items.push_back(item);
+        return static_cast<uint32_t>(items.size() - 1);
+    }
+}
+
+
+// Internal ModelCooker implementation class. It passes itself to the model loaders as the
+// effect factory, so it can remember which material each effect was built from.
+class ModelCooker::Impl : public IEffectFactory
+{
+public:
+    explicit Impl(IEffectFactory& fxFactory) noexcept
+        : mFactory(&fxFactory)
+    {
+    }
+
+    std::shared_ptr<IEffect> __cdecl CreateEffect(_In_ const EffectInfo& info, _In_opt_ ID3D11DeviceContext* deviceContext) override;
+
+    void __cdecl CreateTexture(_In_z_ const wchar_t* name, _In_opt_ ID3D11DeviceContext* deviceContext, _Outptr_ ID3D11ShaderResourceView** textureView) override
+    {
+        mFactory->CreateTexture(name, deviceContext, textureView);
+    }
+
+    void Save(_In_ ID3D11DeviceContext* deviceContext, const Model& model, _In_z_ const wchar_t* szFileName);
+
+private:
+    IEffectFactory* mFactory;
+
+    std::map<IEffect*, MaterialInfo> mMaterials;
+    std::mutex mMutex;
+};
+
+
+_Use_decl_annotations_
+std::shared_ptr<IEffect> ModelCooker::Impl::CreateEffect(const EffectInfo& info, ID3D11DeviceContext* deviceContext)
+{
+    auto effect = mFactory->CreateEffect(info, deviceContext);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto& mat = mMaterials[effect.get()];
+    if (!mat.effect)
+    {
+        // Holding the effect keeps its address from being reused by another one.
+        mat.effect = effect;
+        mat.info = info;
+
+        auto copy = [](std::wstring& str, const wchar_t*& ptr)
+        {
+            if (ptr)
+            {
+                str = ptr;
+                ptr = str.c_str();
+            }
+        };
+
+        copy(mat.name, mat.info.name);
+        copy(mat.diffuseTexture, mat.info.diffuseTexture);
+        copy(mat.specularTexture, mat.info.specularTexture);
+        copy(mat.normalTexture, mat.info.normalTexture);
+        copy(mat.emissiveTexture, mat.info.emissiveTexture);
+    }
+
+    return effect;
+}
+
+
+_Use_decl_annotations_
+void ModelCooker::Impl::Save(ID3D11DeviceContext* deviceContext, const Model& model, const wchar_t* szFileName)
+{
+    using namespace CookedModel;
+
+    if (!deviceContext || !szFileName)
+        throw std::exception("Context and file name cannot be null");
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Gather the unique buffers, layouts and materials used by the model.
+    std::vector<ID3D11Buffer*> vbs;
+    std::vector<ID3D11Buffer*> ibs;
+    std::vector<std::vector<D3D11_INPUT_ELEMENT_DESC> const*> layouts;
+    std::vector<MaterialInfo const*> materials;
+
+    std::vector<MeshRecord> meshRecords;
+    std::vector<PartRecord> partRecords;
+
+    StringTable strings;
+
+    for (auto const& mesh : model.meshes)
+    {
+        assert(mesh != nullptr);
+
+        MeshRecord mh = {};
+        mh.name = mesh->name.empty() ? NO_STRING : strings.Add(mesh->name.c_str());
+        mh.flags = (mesh->ccw ? MESH_CCW : 0u) | (mesh->pmalpha ? MESH_PMALPHA : 0u);
+
+        auto& sphere = mesh->boundingSphere;
+        mh.sphereCenter[0] = sphere.Center.x;
+        mh.sphereCenter[1] = sphere.Center.y;
+        mh.sphereCenter[2] = sphere.Center.z;
+        mh.sphereRadius = sphere.Radius;
+
+        auto& box = mesh->boundingBox;
+        mh.boxCenter[0] = box.Center.x;
+        mh.boxCenter[1] = box.Center.y;
+        mh.boxCenter[2] = box.Center.z;
+        mh.boxExtents[0] = box.Extents.x;
+        mh.boxExtents[1] = box.Extents.y;
+        mh.boxExtents[2] = box.Extents.z;
+
+        mh.firstPart = static_cast<uint32_t>(partRecords.size());
+        mh.partCount = static_cast<uint32_t>(mesh->meshParts.size());
+
+        for (auto const& part : mesh->meshParts)
+        {
+            assert(part != nullptr);
+
+            if (!part->vertexBuffer || !part->indexBuffer || !part->vbDecl)
+                throw std::exception("ModelCooker requires every mesh part to have buffers and a vertex declaration");
+
+            auto it = mMaterials.find(part->effect.get());
+            if (it == mMaterials.end())
+                throw std::exception("ModelCooker requires every effect to be created through its effect factory");
+
+            // Layouts are shared by content, since loaders may build the same declaration more than once.
+            uint32_t layout = 0;
+            for (; layout < layouts.size(); ++layout)
+            {
+                auto& decl = *layouts[layout];
+                auto& other = *part->vbDecl;
+
+                if (decl.size() == other.size()
+                    && std::equal(decl.cbegin(), decl.cend(), other.cbegin(), [](D3D11_INPUT_ELEMENT_DESC const& a, D3D11_INPUT_ELEMENT_DESC const& b)
+                    {
+                        return !_stricmp(a.SemanticName, b.SemanticName)
+                            && a.SemanticIndex == b.SemanticIndex
+                            && a.Format == b.Format
+                            && a.InputSlot == b.InputSlot
+                            && a.AlignedByteOffset == b.AlignedByteOffset
+                            && a.InputSlotClass == b.InputSlotClass
+                            && a.InstanceDataStepRate == b.InstanceDataStepRate;
+                    }))
+                    break;
+            }
+
+            if (layout == layouts.size())
+                layouts.push_back(part->vbDecl.get());
+
+            PartRecord ph = {};
+            ph.indexCount = part->indexCount;
+            ph.startIndex = part->startIndex;
+            ph.vertexOffset = part->vertexOffset;
+            ph.vertexStride = part->vertexStride;
+            ph.primitiveType = static_cast<uint32_t>(part->primitiveType);
+            ph.indexFormat = static_cast<uint32_t>(part->indexFormat);
+            ph.vertexBuffer = IndexOf(vbs, part->vertexBuffer.Get());
+            ph.indexBuffer = IndexOf(ibs, part->indexBuffer.Get());
+            ph.layout = layout;
+            ph.material = IndexOf(materials, static_cast<MaterialInfo const*>(&it->second));
+            ph.flags = part->isAlpha ? PART_ALPHA : 0u;
+
+            partRecords.push_back(ph);
+        }
+
+        meshRecords.push_back(mh);
+    }
+
+    std::vector<LayoutRecord> layoutRecords;
+    std::vector<ElementRecord> elementRecords;
+
+    for (auto decl : layouts)
+    {
+        LayoutRecord lh;
+        lh.firstElement = static_cast<uint32_t>(elementRecords.size());
+        lh.elementCount = static_cast<uint32_t>(decl->size());
+        layoutRecords.push_back(lh);
+
+        for (auto const& desc : *decl)
+        {
+            ElementRecord eh;
+            eh.semantic = GetSemantic(desc.SemanticName);
+            eh.semanticIndex = desc.SemanticIndex;
+            eh.format = static_cast<uint32_t>(desc.Format);
+            eh.inputSlot = desc.InputSlot;
+            eh.alignedByteOffset = desc.AlignedByteOffset;
+            eh.inputSlotClass = static_cast<uint32_t>(desc.InputSlotClass);
+            eh.instanceDataStepRate = desc.InstanceDataStepRate;
+            elementRecords.push_back(eh);
+        }
+    }
+
+    std::vector<MaterialRecord> materialRecords;
+
+    for (auto mat : materials)
+    {
+        auto& info = mat->info;
+
+        MaterialRecord mr = {};
+        mr.name = strings.Add(info.name);
+        mr.flags = (info.perVertexColor ? MATERIAL_PER_VERTEX_COLOR : 0u)
+            | (info.enableSkinning ? MATERIAL_SKINNING : 0u)
+            | (info.enableDualTexture ? MATERIAL_DUAL_TEXTURE : 0u)
+            | (info.enableNormalMaps ? MATERIAL_NORMAL_MAPS : 0u)
+            | (info.biasedVertexNormals ? MATERIAL_BIASED_VERTEX_NORMALS : 0u);
+        mr.specularPower = info.specularPower;
+        mr.alpha = info.alpha;
+        memcpy(mr.ambientColor, &info.ambientColor, sizeof(mr.ambientColor));
+        memcpy(mr.diffuseColor, &info.diffuseColor, sizeof(mr.diffuseColor));
+        memcpy(mr.specularColor, &info.specularColor, sizeof(mr.specularColor));
+        memcpy(mr.emissiveColor, &info.emissiveColor, sizeof(mr.emissiveColor));
+        mr.diffuseTexture = strings.Add(info.diffuseTexture);
+        mr.specularTexture = strings.Add(info.specularTexture);
+        mr.normalTexture = strings.Add(info.normalTexture);
+        mr.emissiveTexture = strings.Add(info.emissiveTexture);
+
+        materialRecords.push_back(mr);
+    }
+
+    // Write the file image: header and tables first, then the strings, then the aligned buffer data.
+    CookedWriter writer;
+
+    Header header = {};
+    writer.Append(&header, sizeof(header), 4);
+
+    std::vector<BufferRecord> vbRecords(vbs.size());
+    std::vector<BufferRecord> ibRecords(ibs.size());
+
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.numVertexBuffers = static_cast<uint32_t>(vbRecords.size());
+    header.numIndexBuffers = static_cast<uint32_t>(ibRecords.size());
+    header.numLayouts = static_cast<uint32_t>(layoutRecords.size());
+    header.numElements = static_cast<uint32_t>(elementRecords.size());
+    header.numMaterials = static_cast<uint32_t>(materialRecords.size());
+    header.numMeshes = static_cast<uint32_t>(meshRecords.size());
+    header.numParts = static_cast<uint32_t>(partRecords.size());
+
+    // Buffer records are filled in once the data offsets are known.
+    header.vertexBuffersOffset = writer.AppendTable(vbRecords);
+    header.indexBuffersOffset = writer.AppendTable(ibRecords);
+    header.layoutsOffset = writer.AppendTable(layoutRecords);
+    header.elementsOffset = writer.AppendTable(elementRecords);
+    header.materialsOffset = writer.AppendTable(materialRecords);
+    header.meshesOffset = writer.AppendTable(meshRecords);
+    header.partsOffset = writer.AppendTable(partRecords);
+    header.stringsOffset = writer.AppendTable(strings.mChars);
+    header.stringsSize = static_cast<uint32_t>(strings.mChars.size() * sizeof(wchar_t));
+
+    std::vector<uint8_t> data;
+
+    for (size_t j = 0; j < vbs.size(); ++j)
+    {
+        ReadBuffer(deviceContext, vbs[j], data);
+        vbRecords[j].dataOffset = writer.Append(data.data(), data.size(), DATA_ALIGNMENT);
+        vbRecords[j].dataSize = static_cast<uint32_t>(data.size());
+    }
+
+    for (size_t j = 0; j < ibs.size(); ++j)
+    {
+        ReadBuffer(deviceContext, ibs[j], data);
+        ibRecords[j].dataOffset = writer.Append(data.data(), data.size(), DATA_ALIGNMENT);
+        ibRecords[j].dataSize = static_cast<uint32_t>(data.size());
+    }
+
+    header.fileSize = static_cast<uint32_t>(writer.mData.size());
+
+    memcpy(writer.mData.data(), &header, sizeof(header));
+
+    if (!vbRecords.empty())
+        memcpy(writer.mData.data() + header.vertexBuffersOffset, vbRecords.data(), vbRecords.size() * sizeof(BufferRecord));
+
+    if (!ibRecords.empty())
+        memcpy(writer.mData.data() + header.indexBuffersOffset, ibRecords.data(), ibRecords.size() * sizeof(BufferRecord));
+
+    // Create file
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile(safe_handle(CreateFile2(szFileName, GENERIC_WRITE | DELETE, 0, CREATE_ALWAYS, nullptr)));
+#else
+    ScopedHandle hFile(safe_handle(CreateFileW(szFileName, GENERIC_WRITE | DELETE, 0, nullptr, CREATE_ALWAYS, 0, nullptr)));
+#endif
+    if (!hFile)
+    {
+        DebugTrace("ERROR: ModelCooker failed (%08X) creating '%ls'\n", static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())), szFileName);
+        throw std::exception("CreateFile");
+    }
+
+    LoaderHelpers::auto_delete_file delonfail(hFile.get());
+
+    DWORD bytesWritten;
+    if (!WriteFile(hFile.get(), writer.mData.data(), header.fileSize, &bytesWritten, nullptr)
+        || bytesWritten != header.fileSize)
+    {
+        DebugTrace("ERROR: ModelCooker failed (%08X) writing '%ls'\n", static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())), szFileName);
+        throw std::exception("WriteFile");
+    }
+
+    delonfail.clear();
+}
+
+
+// Public constructor.
+ModelCooker::ModelCooker(IEffectFactory& fxFactory)
+    : pImpl(std::make_unique<Impl>(fxFactory))
+{
+}
+
+
+// Move constructor.
+ModelCooker::ModelCooker(ModelCooker&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ModelCooker& ModelCooker::operator= (ModelCooker&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ModelCooker::~ModelCooker()
+{
+}
+
+
+IEffectFactory& ModelCooker::GetEffectFactory() noexcept
+{
+    return *pImpl;
+}
+
+
+_Use_decl_annotations_
+void ModelCooker::Save(ID3D11DeviceContext* deviceContext, const Model& model, const wchar_t* szFileName)
+{
+    pImpl->Save(deviceContext, model, szFileName);
+}
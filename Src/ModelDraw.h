@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------------------
+// File: ModelDraw.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "CommonStates.h"
+#include "Model.h"
+
+#include <functional>
+
+
+namespace DirectX
+{
+    // Helper draws the opaque parts of every mesh, then the alpha parts, preparing the shared state before each mesh.
+    // drawMesh(index, mesh, alpha) issues the draws for one mesh. Meshes whose visible entry is zero are skipped.
+    template<typename TDrawMesh>
+    inline void DrawMeshesOpaqueThenAlpha(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const CommonStates& states,
+        ModelRenderState& renderState,
+        ModelMesh::Collection const& meshes,
+        _In_opt_ const uint8_t* visible,
+        bool wireframe,
+        std::function<void()> const& setCustomState,
+        TDrawMesh&& drawMesh)
+    {
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            bool alpha = (pass != 0);
+
+            for (size_t j = 0; j < meshes.size(); ++j)
+            {
+                if (visible && !visible[j])
+                    continue;
+
+                auto mesh = meshes[j].get();
+                assert(mesh != nullptr);
+
+                mesh->PrepareForRendering(deviceContext, states, renderState, alpha, wireframe);
+
+                drawMesh(j, *mesh, alpha);
+
+                // The hook may have changed any state behind our back.
+                if (setCustomState)
+                    renderState.Reset();
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLoadAsync.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "Effects.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    using LoadTask = std::packaged_task<std::unique_ptr<Model>()>;
+
+    void CALLBACK LoadCallback(PTP_CALLBACK_INSTANCE, PVOID context) noexcept
+    {
+        std::unique_ptr<LoadTask> task(static_cast<LoadTask*>(context));
+
+        // Any exception thrown by the loader is captured in the future.
+        (*task)();
+    }
+
+
+    // Queues a load on the system thread pool, so many models can be read and built at once
+    // without a thread of their own each.
+    std::future<std::unique_ptr<Model>> SubmitLoad(std::function<std::unique_ptr<Model>()>&& load)
+    {
+        auto task = std::make_unique<LoadTask>(std::move(load));
+
+        auto result = task->get_future();
+
+        if (!TrySubmitThreadpoolCallback(LoadCallback, task.get(), nullptr))
+        {
+            DebugTrace("ERROR: Model async load failed to queue work (%08X)\n", static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())));
+            throw std::exception("TrySubmitThreadpoolCallback");
+        }
+
+        // The callback now owns the task.
+        task.release();
+
+        return result;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Each load runs entirely on a thread pool worker: the file read, the parse, and the buffer, input
+// layout and effect creation, which is safe because ID3D11Device is free-threaded. The device is
+// kept alive by the work item; the file name is copied.
+_Use_decl_annotations_
+std::future<std::unique_ptr<Model>> DirectX::Model::CreateFromCMOAsync(ID3D11Device* d3dDevice, const wchar_t* szFileName,
+                                                                       IEffectFactory& fxFactory, bool ccw, bool pmalpha, bool quantize)
+{
+    if (!d3dDevice || !szFileName)
+        throw std::exception("Device and file name are required");
+
+    ComPtr<ID3D11Device> device(d3dDevice);
+    std::wstring fileName(szFileName);
+    IEffectFactory* factory = &fxFactory;
+
+    return SubmitLoad([device, fileName, factory, ccw, pmalpha, quantize]()
+    {
+        return CreateFromCMO(device.Get(), fileName.c_str(), *factory, ccw, pmalpha, quantize);
+    });
+}
+
+
+_Use_decl_annotations_
+std::future<std::unique_ptr<Model>> DirectX::Model::CreateFromSDKMESHAsync(ID3D11Device* d3dDevice, const wchar_t* szFileName,
+                                                                           IEffectFactory& fxFactory, bool ccw, bool pmalpha)
+{
+    if (!d3dDevice || !szFileName)
+        throw std::exception("Device and file name are required");
+
+    ComPtr<ID3D11Device> device(d3dDevice);
+    std::wstring fileName(szFileName);
+    IEffectFactory* factory = &fxFactory;
+
+    return SubmitLoad([device, fileName, factory, ccw, pmalpha]()
+    {
+        return CreateFromSDKMESH(device.Get(), fileName.c_str(), *factory, ccw, pmalpha);
+    });
+}
+
+
+_Use_decl_annotations_
+std::future<std::unique_ptr<Model>> DirectX::Model::CreateFromVBOAsync(ID3D11Device* d3dDevice, const wchar_t* szFileName,
+                                                                       std::shared_ptr<IEffect> ieffect, bool ccw, bool pmalpha, bool quantize)
+{
+    if (!d3dDevice || !szFileName)
+        throw std::exception("Device and file name are required");
+
+    ComPtr<ID3D11Device> device(d3dDevice);
+    std::wstring fileName(szFileName);
+
+    return SubmitLoad([device, fileName, ieffect, ccw, pmalpha, quantize]()
+    {
+        return CreateFromVBO(device.Get(), fileName.c_str(), ieffect, ccw, pmalpha, quantize);
+    });
+}
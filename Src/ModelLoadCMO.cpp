@@ -9,6 +9,7 @@
 
 #include "pch.h"
 #include "Model.h"
+#include "ModelAnimation.h"
 
 #include "DDSTextureLoader.h"
 #include "Effects.h"
@@ -195,31 +196,20 @@ namespace
     };
 
     // Helper for creating a D3D input layout.
-    void CreateInputLayout(_In_ ID3D11Device* device, IEffect* effect, _Out_ ID3D11InputLayout** pInputLayout, bool skinning)
+    void CreateInputLayout(_In_ ID3D11Device* device, IEffect* effect, _Out_ ID3D11InputLayout** pInputLayout,
+                           const std::vector<D3D11_INPUT_ELEMENT_DESC>& decl)
     {
         void const* shaderByteCode;
         size_t byteCodeLength;
 
         effect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
 
-        if (skinning)
-        {
-            ThrowIfFailed(
-                device->CreateInputLayout(VertexPositionNormalTangentColorTextureSkinning::InputElements,
-                VertexPositionNormalTangentColorTextureSkinning::InputElementCount,
-                shaderByteCode, byteCodeLength,
-                pInputLayout)
-            );
-        }
-        else
-        {
-            ThrowIfFailed(
-                device->CreateInputLayout(VertexPositionNormalTangentColorTexture::InputElements,
-                VertexPositionNormalTangentColorTexture::InputElementCount,
-                shaderByteCode, byteCodeLength,
-                pInputLayout)
-            );
-        }
+        ThrowIfFailed(
+            device->CreateInputLayout(decl.data(),
+            static_cast<UINT>(decl.size()),
+            shaderByteCode, byteCodeLength,
+            pInputLayout)
+        );
 
         assert(pInputLayout != nullptr && *pInputLayout != nullptr);
         _Analysis_assume_(pInputLayout != nullptr && *pInputLayout != nullptr);
@@ -231,6 +221,8 @@ namespace
     INIT_ONCE g_InitOnce = INIT_ONCE_STATIC_INIT;
     std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdecl;
     std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdeclSkinning;
+    std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdeclPacked;
+    std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdeclSkinningPacked;
 
     BOOL CALLBACK InitializeDecl(PINIT_ONCE initOnce, PVOID Parameter, PVOID *lpContext)
     {
@@ -245,6 +237,14 @@ namespace
         g_vbdeclSkinning = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
             VertexPositionNormalTangentColorTextureSkinning::InputElements,
             VertexPositionNormalTangentColorTextureSkinning::InputElements + VertexPositionNormalTangentColorTextureSkinning::InputElementCount);
+
+        g_vbdeclPacked = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+            VertexPositionNormalTangentColorTexturePacked::InputElements,
+            VertexPositionNormalTangentColorTexturePacked::InputElements + VertexPositionNormalTangentColorTexturePacked::InputElementCount);
+
+        g_vbdeclSkinningPacked = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+            VertexPositionNormalTangentColorTextureSkinningPacked::InputElements,
+            VertexPositionNormalTangentColorTextureSkinningPacked::InputElements + VertexPositionNormalTangentColorTextureSkinningPacked::InputElementCount);
         return TRUE;
     }
 }
@@ -255,7 +255,7 @@ namespace
 //======================================================================================
 
 _Use_decl_annotations_
-std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, const uint8_t* meshData, size_t dataSize, IEffectFactory& fxFactory, bool ccw, bool pmalpha)
+std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, const uint8_t* meshData, size_t dataSize, IEffectFactory& fxFactory, bool ccw, bool pmalpha, bool quantize)
 {
     if (!InitOnceExecuteOnce(&g_InitOnce, InitializeDecl, nullptr, nullptr))
         throw std::exception("One-time initialization failed");
@@ -373,6 +373,20 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
             materials.emplace_back(m);
         }
 
+        // Start loading the DGSL pixel shaders while the buffers are read and created.
+        std::future<void> shaderPreload;
+        if (fxFactoryDGSL)
+        {
+            std::vector<const wchar_t*> shaders;
+            shaders.reserve(materials.size());
+            for (auto const& m : materials)
+            {
+                shaders.push_back(m.pixelShader.c_str());
+            }
+
+            shaderPreload = fxFactoryDGSL->PreloadPixelShadersAsync(shaders.data(), shaders.size());
+        }
+
         // Skeletal data?
         const BYTE* bSkeleton = meshData + usedSize;
         usedSize += sizeof(BYTE);
@@ -553,8 +567,7 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
         XMVECTOR max = XMVectorSet(extents->MaxX, extents->MaxY, extents->MaxZ, 0.f);
         BoundingBox::CreateFromPoints(mesh->boundingBox, min, max);
 
-    #if 0
-            // Animation data
+        // Animation data
         if (*bSkeleton)
         {
             // Bones
@@ -566,6 +579,13 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
             if (!*nBones)
                 throw std::exception("Animation bone data is missing\n");
 
+            // Every skinned mesh in a file carries the same skeleton, so the model keeps the first one.
+            bool keepSkeleton = model->bones.empty();
+            bool parentsFirst = true;
+
+            ModelBone::Collection bones;
+            bones.reserve(*nBones);
+
             for (UINT j = 0; j < *nBones; ++j)
             {
                 // Bone name
@@ -580,17 +600,35 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
                 if (dataSize < usedSize)
                     throw std::exception("End of file");
 
-                // TODO - What to do with bone name?
-                boneName;
-
                 // Bone settings
-                auto bones = reinterpret_cast<const VSD3DStarter::Bone*>(meshData + usedSize);
+                auto bone = reinterpret_cast<const VSD3DStarter::Bone*>(meshData + usedSize);
                 usedSize += sizeof(VSD3DStarter::Bone);
                 if (dataSize < usedSize)
                     throw std::exception("End of file");
 
-                // TODO - What to do with bone data?
-                bones;
+                // Palettes are built in one pass, which needs each parent ahead of its children.
+                if (bone->ParentIndex >= static_cast<INT>(j))
+                    parentsFirst = false;
+
+                ModelBone mb;
+                mb.parentIndex = (bone->ParentIndex < 0) ? ModelBone::c_Invalid : static_cast<uint32_t>(bone->ParentIndex);
+                mb.name.assign(boneName, wcsnlen(boneName, *nName));
+                mb.invBindPose = bone->InvBindPos;
+                mb.localTransform = bone->LocalTransform;
+                bones.emplace_back(std::move(mb));
+            }
+
+            // Skinned vertices index the bones as stored, so a skeleton that is not stored parent-first cannot be
+            // reordered; the mesh still loads, just without animation data.
+            if (keepSkeleton && !parentsFirst)
+            {
+                DebugTrace("WARNING: %ls - bones are not stored parent-first; skipping animation data\n", mesh->name.c_str());
+                keepSkeleton = false;
+            }
+
+            if (keepSkeleton)
+            {
+                model->bones = std::move(bones);
             }
 
             // Animation Clips
@@ -599,6 +637,8 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
             if (dataSize < usedSize)
                 throw std::exception("End of file");
 
+            std::vector<AnimationClip::Keyframe> keyframes;
+
             for (UINT j = 0; j < *nClips; ++j)
             {
                 // Clip name
@@ -613,9 +653,6 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
                 if (dataSize < usedSize)
                     throw std::exception("End of file");
 
-                // TODO - What to do with clip name?
-                clipName;
-
                 auto clip = reinterpret_cast<const VSD3DStarter::Clip*>(meshData + usedSize);
                 usedSize += sizeof(VSD3DStarter::Clip);
                 if (dataSize < usedSize)
@@ -629,13 +666,23 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
                 if (dataSize < usedSize)
                     throw std::exception("End of file");
 
-                // TODO - What to do with keys and clip->StartTime, clip->EndTime?
-                keys;
+                if (!keepSkeleton)
+                    continue;
+
+                keyframes.resize(clip->keys);
+                for (UINT k = 0; k < clip->keys; ++k)
+                {
+                    keyframes[k].boneIndex = keys[k].BoneIndex;
+                    keyframes[k].time = keys[k].Time;
+                    keyframes[k].transform = keys[k].Transform;
+                }
+
+                std::wstring name(clipName, wcsnlen(clipName, *nName));
+
+                model->animations.emplace_back(std::make_shared<AnimationClip>(name.c_str(), model->bones,
+                    clip->StartTime, clip->EndTime, keyframes.data(), keyframes.size()));
             }
         }
-    #else
-        UNREFERENCED_PARAMETER(bSkeleton);
-    #endif
 
         bool enableSkinning = (*nSkinVBs) != 0;
 
@@ -646,6 +693,18 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
         const size_t stride = enableSkinning ? sizeof(VertexPositionNormalTangentColorTextureSkinning)
             : sizeof(VertexPositionNormalTangentColorTexture);
 
+        // Stride of the vertex buffers themselves, which hold packed vertices when quantizing
+        size_t vbStride = stride;
+        if (quantize)
+        {
+            vbStride = enableSkinning ? sizeof(VertexPositionNormalTangentColorTextureSkinningPacked)
+                : sizeof(VertexPositionNormalTangentColorTexturePacked);
+        }
+
+        auto vbDecl = enableSkinning
+            ? (quantize ? g_vbdeclSkinningPacked : g_vbdeclSkinning)
+            : (quantize ? g_vbdeclPacked : g_vbdecl);
+
         for (UINT j = 0; j < *nVBs; ++j)
         {
             size_t nVerts = vbData[j].nVerts;
@@ -661,7 +720,7 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
             desc.ByteWidth = static_cast<UINT>(bytes);
             desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
-            if (fxFactoryDGSL && !enableSkinning)
+            if (fxFactoryDGSL && !enableSkinning && !quantize)
             {
                 // Can use CMO vertex data directly
                 D3D11_SUBRESOURCE_DATA initData = {};
@@ -768,6 +827,32 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
                 D3D11_SUBRESOURCE_DATA initData = {};
                 initData.pSysMem = temp.get();
 
+                std::unique_ptr<uint8_t[]> packed;
+                if (quantize)
+                {
+                    packed.reset(new uint8_t[vbStride * nVerts]);
+
+                    for (size_t v = 0; v < nVerts; ++v)
+                    {
+                        const uint8_t* src = temp.get() + v * stride;
+                        uint8_t* dest = packed.get() + v * vbStride;
+
+                        if (enableSkinning)
+                        {
+                            *reinterpret_cast<VertexPositionNormalTangentColorTextureSkinningPacked*>(dest)
+                                = VertexPositionNormalTangentColorTextureSkinningPacked(*reinterpret_cast<const VertexPositionNormalTangentColorTextureSkinning*>(src));
+                        }
+                        else
+                        {
+                            *reinterpret_cast<VertexPositionNormalTangentColorTexturePacked*>(dest)
+                                = VertexPositionNormalTangentColorTexturePacked(*reinterpret_cast<const VertexPositionNormalTangentColorTexture*>(src));
+                        }
+                    }
+
+                    desc.ByteWidth = static_cast<UINT>(vbStride * nVerts);
+                    initData.pSysMem = packed.get();
+                }
+
                 ThrowIfFailed(
                     d3dDevice->CreateBuffer(&desc, &initData, &vbs[j])
                 );
@@ -779,6 +864,11 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
         assert(vbs.size() == *nVBs);
 
         // Create Effects
+        if (shaderPreload.valid())
+        {
+            shaderPreload.wait();
+        }
+
         for (size_t j = 0; j < materials.size(); ++j)
         {
             auto& m = materials[j];
@@ -829,7 +919,7 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
                 m.effect = fxFactory.CreateEffect(info, nullptr);
             }
 
-            CreateInputLayout(d3dDevice, m.effect.get(), &m.il, enableSkinning);
+            CreateInputLayout(d3dDevice, m.effect.get(), &m.il, *vbDecl);
         }
 
         // Build mesh parts
@@ -851,12 +941,12 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
 
             part->indexCount = sm.PrimCount * 3;
             part->startIndex = sm.StartIndex;
-            part->vertexStride = static_cast<UINT>(stride);
+            part->vertexStride = static_cast<UINT>(vbStride);
             part->inputLayout = mat.il;
             part->indexBuffer = ibs[sm.IndexBufferIndex];
             part->vertexBuffer = vbs[sm.VertexBufferIndex];
             part->effect = mat.effect;
-            part->vbDecl = enableSkinning ? g_vbdeclSkinning : g_vbdecl;
+            part->vbDecl = vbDecl;
 
             mesh->meshParts.emplace_back(part);
         }
@@ -864,26 +954,30 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, co
         model->meshes.emplace_back(mesh);
     }
 
+    model->TrackMemory();
+
     return model;
 }
 
 
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
-std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, const wchar_t* szFileName, IEffectFactory& fxFactory, bool ccw, bool pmalpha)
+std::unique_ptr<Model> DirectX::Model::CreateFromCMO(ID3D11Device* d3dDevice, const wchar_t* szFileName, IEffectFactory& fxFactory, bool ccw, bool pmalpha, bool quantize)
 {
     size_t dataSize = 0;
-    std::unique_ptr<uint8_t[]> data;
-    HRESULT hr = BinaryReader::ReadEntireFile(szFileName, data, &dataSize);
+    ScopedMappedView data;
+    HRESULT hr = BinaryReader::MapEntireFile(szFileName, data, &dataSize);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: CreateFromCMO failed (%08X) loading '%ls'\n", hr, szFileName);
         throw std::exception("CreateFromCMO");
     }
 
-    auto model = CreateFromCMO(d3dDevice, data.get(), dataSize, fxFactory, ccw, pmalpha);
+    auto model = CreateFromCMO(d3dDevice, static_cast<const uint8_t*>(data.get()), dataSize, fxFactory, ccw, pmalpha, quantize);
 
     model->name = szFileName;
 
+    model->TrackMemory();
+
     return model;
 }
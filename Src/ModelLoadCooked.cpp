@@ -0,0 +1,318 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLoadCooked.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "Effects.h"
+
+#include "DirectXHelpers.h"
+#include "PlatformHelpers.h"
+#include "BinaryReader.h"
+
+#include "CookedModel.h"
+
+#include <map>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Returns a table of the header, after checking it lies within the file.
+    template<typename T>
+    const T* GetTable(const uint8_t* meshData, size_t dataSize, uint32_t offset, uint32_t count)
+    {
+        if ((offset % 4) != 0
+            || dataSize < offset
+            || (dataSize - offset) < uint64_t(count) * sizeof(T))
+            throw std::exception("End of file");
+
+        return reinterpret_cast<const T*>(meshData + offset);
+    }
+
+
+    const wchar_t* GetString(const wchar_t* strings, size_t stringCount, uint32_t offset)
+    {
+        if (offset == CookedModel::NO_STRING)
+            return nullptr;
+
+        if ((offset % sizeof(wchar_t)) != 0 || (offset / sizeof(wchar_t)) >= stringCount)
+            throw std::exception("Invalid string found");
+
+        return strings + offset / sizeof(wchar_t);
+    }
+
+
+    // Helper for creating a D3D vertex or index buffer straight from the file data.
+    void CreateBuffer(_In_ ID3D11Device* device, const uint8_t* meshData, size_t dataSize, const CookedModel::BufferRecord& record,
+                      D3D11_BIND_FLAG bindFlag, _Outptr_ ID3D11Buffer** pBuffer)
+    {
+        if (!record.dataSize
+            || (record.dataOffset % CookedModel::DATA_ALIGNMENT) != 0
+            || dataSize < record.dataOffset
+            || (dataSize - record.dataOffset) < record.dataSize)
+            throw std::exception("Invalid buffer found");
+
+        if (record.dataSize > (D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
+            throw std::exception("Buffer too large for DirectX 11");
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.ByteWidth = record.dataSize;
+        desc.BindFlags = static_cast<UINT>(bindFlag);
+
+        D3D11_SUBRESOURCE_DATA initData = {};
+        initData.pSysMem = meshData + record.dataOffset;
+
+        ThrowIfFailed(
+            device->CreateBuffer(&desc, &initData, pBuffer)
+        );
+
+        SetDebugObjectName(*pBuffer, "ModelCooked");
+    }
+}
+
+
+//======================================================================================
+// Model Loader
+//======================================================================================
+
+_Use_decl_annotations_
+std::unique_ptr<Model> DirectX::Model::CreateFromCooked(ID3D11Device* d3dDevice, const uint8_t* meshData, size_t dataSize, IEffectFactory& fxFactory)
+{
+    using namespace CookedModel;
+
+    if (!d3dDevice || !meshData)
+        throw std::exception("Device and meshData cannot be null");
+
+    // The cooker has already validated the content, so only the file structure is checked here.
+    if (dataSize < sizeof(Header))
+        throw std::exception("End of file");
+
+    auto header = reinterpret_cast<const Header*>(meshData);
+
+    if (header->magic != MAGIC)
+        throw std::exception("Not a cooked model file");
+
+    if (header->version != VERSION)
+        throw std::exception("Unsupported cooked model version");
+
+    if (header->fileSize > dataSize)
+        throw std::exception("End of file");
+
+    auto vbArray = GetTable<BufferRecord>(meshData, dataSize, header->vertexBuffersOffset, header->numVertexBuffers);
+    auto ibArray = GetTable<BufferRecord>(meshData, dataSize, header->indexBuffersOffset, header->numIndexBuffers);
+    auto layoutArray = GetTable<LayoutRecord>(meshData, dataSize, header->layoutsOffset, header->numLayouts);
+    auto elementArray = GetTable<ElementRecord>(meshData, dataSize, header->elementsOffset, header->numElements);
+    auto materialArray = GetTable<MaterialRecord>(meshData, dataSize, header->materialsOffset, header->numMaterials);
+    auto meshArray = GetTable<MeshRecord>(meshData, dataSize, header->meshesOffset, header->numMeshes);
+    auto partArray = GetTable<PartRecord>(meshData, dataSize, header->partsOffset, header->numParts);
+
+    size_t stringCount = header->stringsSize / sizeof(wchar_t);
+    auto strings = GetTable<wchar_t>(meshData, dataSize, header->stringsOffset, static_cast<uint32_t>(stringCount));
+
+    // The string table ends with a terminator, so no string can run off the end of it.
+    if (stringCount > 0 && strings[stringCount - 1] != 0)
+        throw std::exception("Invalid string table");
+
+    // Create vertex and index buffers
+    std::vector<ComPtr<ID3D11Buffer>> vbs;
+    vbs.resize(header->numVertexBuffers);
+
+    for (uint32_t j = 0; j < header->numVertexBuffers; ++j)
+    {
+        CreateBuffer(d3dDevice, meshData, dataSize, vbArray[j], D3D11_BIND_VERTEX_BUFFER, vbs[j].GetAddressOf());
+    }
+
+    std::vector<ComPtr<ID3D11Buffer>> ibs;
+    ibs.resize(header->numIndexBuffers);
+
+    for (uint32_t j = 0; j < header->numIndexBuffers; ++j)
+    {
+        CreateBuffer(d3dDevice, meshData, dataSize, ibArray[j], D3D11_BIND_INDEX_BUFFER, ibs[j].GetAddressOf());
+    }
+
+    // Input element descriptions
+    std::vector<std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>>> vbDecls;
+    vbDecls.resize(header->numLayouts);
+
+    for (uint32_t j = 0; j < header->numLayouts; ++j)
+    {
+        auto& layout = layoutArray[j];
+
+        if (!layout.elementCount
+            || layout.elementCount > D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT
+            || layout.firstElement >= header->numElements
+            || layout.elementCount > (header->numElements - layout.firstElement))
+            throw std::exception("Invalid input layout found");
+
+        auto decl = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>();
+        decl->reserve(layout.elementCount);
+
+        for (uint32_t k = 0; k < layout.elementCount; ++k)
+        {
+            auto& element = elementArray[layout.firstElement + k];
+
+            D3D11_INPUT_ELEMENT_DESC desc;
+            desc.SemanticName = GetSemanticName(element.semantic);
+            if (!desc.SemanticName)
+                throw std::exception("Unknown vertex semantic found");
+
+            desc.SemanticIndex = element.semanticIndex;
+            desc.Format = static_cast<DXGI_FORMAT>(element.format);
+            desc.InputSlot = element.inputSlot;
+            desc.AlignedByteOffset = element.alignedByteOffset;
+            desc.InputSlotClass = static_cast<D3D11_INPUT_CLASSIFICATION>(element.inputSlotClass);
+            desc.InstanceDataStepRate = element.instanceDataStepRate;
+
+            decl->push_back(desc);
+        }
+
+        vbDecls[j] = decl;
+    }
+
+    // Effects are created on first use, so materials not referenced by any part cost nothing.
+    std::vector<std::shared_ptr<IEffect>> effects;
+    effects.resize(header->numMaterials);
+
+    // Parts that share both a layout and a material share an input layout.
+    std::map<std::pair<uint32_t, uint32_t>, ComPtr<ID3D11InputLayout>> inputLayouts;
+
+    std::unique_ptr<Model> model(new Model());
+    model->meshes.reserve(header->numMeshes);
+
+    for (uint32_t meshIndex = 0; meshIndex < header->numMeshes; ++meshIndex)
+    {
+        auto& mh = meshArray[meshIndex];
+
+        if (mh.firstPart > header->numParts
+            || mh.partCount > (header->numParts - mh.firstPart))
+            throw std::exception("Invalid mesh found");
+
+        auto mesh = std::make_shared<ModelMesh>();
+
+        auto meshName = GetString(strings, stringCount, mh.name);
+        if (meshName)
+            mesh->name = meshName;
+
+        mesh->ccw = (mh.flags & MESH_CCW) != 0;
+        mesh->pmalpha = (mh.flags & MESH_PMALPHA) != 0;
+
+        // Extents
+        mesh->boundingSphere.Center = XMFLOAT3(mh.sphereCenter);
+        mesh->boundingSphere.Radius = mh.sphereRadius;
+        mesh->boundingBox.Center = XMFLOAT3(mh.boxCenter);
+        mesh->boundingBox.Extents = XMFLOAT3(mh.boxExtents);
+
+        // Create parts
+        mesh->meshParts.reserve(mh.partCount);
+        for (uint32_t j = 0; j < mh.partCount; ++j)
+        {
+            auto& ph = partArray[mh.firstPart + j];
+
+            if (ph.vertexBuffer >= header->numVertexBuffers
+                || ph.indexBuffer >= header->numIndexBuffers
+                || ph.layout >= header->numLayouts
+                || ph.material >= header->numMaterials)
+                throw std::exception("Invalid mesh part found");
+
+            auto& effect = effects[ph.material];
+            if (!effect)
+            {
+                auto& mat = materialArray[ph.material];
+
+                IEffectFactory::EffectInfo info;
+                info.name = GetString(strings, stringCount, mat.name);
+                info.perVertexColor = (mat.flags & MATERIAL_PER_VERTEX_COLOR) != 0;
+                info.enableSkinning = (mat.flags & MATERIAL_SKINNING) != 0;
+                info.enableDualTexture = (mat.flags & MATERIAL_DUAL_TEXTURE) != 0;
+                info.enableNormalMaps = (mat.flags & MATERIAL_NORMAL_MAPS) != 0;
+                info.biasedVertexNormals = (mat.flags & MATERIAL_BIASED_VERTEX_NORMALS) != 0;
+                info.specularPower = mat.specularPower;
+                info.alpha = mat.alpha;
+                info.ambientColor = XMFLOAT3(mat.ambientColor);
+                info.diffuseColor = XMFLOAT3(mat.diffuseColor);
+                info.specularColor = XMFLOAT3(mat.specularColor);
+                info.emissiveColor = XMFLOAT3(mat.emissiveColor);
+                info.diffuseTexture = GetString(strings, stringCount, mat.diffuseTexture);
+                info.specularTexture = GetString(strings, stringCount, mat.specularTexture);
+                info.normalTexture = GetString(strings, stringCount, mat.normalTexture);
+                info.emissiveTexture = GetString(strings, stringCount, mat.emissiveTexture);
+
+                effect = fxFactory.CreateEffect(info, nullptr);
+            }
+
+            auto& il = inputLayouts[std::make_pair(ph.layout, ph.material)];
+            if (!il)
+            {
+                auto& decl = *vbDecls[ph.layout];
+
+                void const* shaderByteCode;
+                size_t byteCodeLength;
+                effect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+                ThrowIfFailed(
+                    d3dDevice->CreateInputLayout(decl.data(),
+                    static_cast<UINT>(decl.size()),
+                    shaderByteCode, byteCodeLength,
+                    il.GetAddressOf())
+                );
+
+                SetDebugObjectName(il.Get(), "ModelCooked");
+            }
+
+            auto part = new ModelMeshPart();
+            part->isAlpha = (ph.flags & PART_ALPHA) != 0;
+
+            part->indexCount = ph.indexCount;
+            part->startIndex = ph.startIndex;
+            part->vertexOffset = ph.vertexOffset;
+            part->vertexStride = ph.vertexStride;
+            part->indexFormat = static_cast<DXGI_FORMAT>(ph.indexFormat);
+            part->primitiveType = static_cast<D3D11_PRIMITIVE_TOPOLOGY>(ph.primitiveType);
+            part->inputLayout = il;
+            part->indexBuffer = ibs[ph.indexBuffer];
+            part->vertexBuffer = vbs[ph.vertexBuffer];
+            part->effect = effect;
+            part->vbDecl = vbDecls[ph.layout];
+
+            mesh->meshParts.emplace_back(part);
+        }
+
+        model->meshes.emplace_back(mesh);
+    }
+
+    model->TrackMemory();
+
+    return model;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+std::unique_ptr<Model> DirectX::Model::CreateFromCooked(ID3D11Device* d3dDevice, const wchar_t* szFileName, IEffectFactory& fxFactory)
+{
+    size_t dataSize = 0;
+    ScopedMappedView data;
+    HRESULT hr = BinaryReader::MapEntireFile(szFileName, data, &dataSize);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: CreateFromCooked failed (%08X) loading '%ls'\n", hr, szFileName);
+        throw std::exception("CreateFromCooked");
+    }
+
+    auto model = CreateFromCooked(d3dDevice, static_cast<const uint8_t*>(data.get()), dataSize, fxFactory);
+
+    model->name = szFileName;
+
+    model->TrackMemory();
+
+    return model;
+}
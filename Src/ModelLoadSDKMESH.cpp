@@ -367,6 +367,82 @@ namespace
 
         SetDebugObjectName(*pInputLayout, "ModelSDKMESH");
     }
+
+
+    // Turns the frame hierarchy into bones, placing each parent before its children by walking the child and
+    // sibling links breadth first from the root frames. Each mesh is attached to the first frame that references
+    // it. Frame lists that don't form a tree are left out with a warning, as the meshes draw fine without them.
+    void LoadFrames(_In_reads_(numFrames) const DXUT::SDKMESH_FRAME* frames, uint32_t numFrames, Model& model)
+    {
+        std::vector<uint32_t> order;
+        order.reserve(numFrames);
+
+        std::vector<uint32_t> remap(numFrames, ModelBone::c_Invalid);
+
+        for (uint32_t j = 0; j < numFrames; ++j)
+        {
+            if (frames[j].ParentFrame == DXUT::INVALID_FRAME)
+            {
+                remap[j] = static_cast<uint32_t>(order.size());
+                order.push_back(j);
+            }
+        }
+
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            for (uint32_t child = frames[order[k]].ChildFrame; child != DXUT::INVALID_FRAME; child = frames[child].SiblingFrame)
+            {
+                if (child >= numFrames || remap[child] != ModelBone::c_Invalid || frames[child].ParentFrame != order[k])
+                {
+                    DebugTrace("WARNING: SDKMESH frame hierarchy is invalid and will be ignored\n");
+                    return;
+                }
+
+                remap[child] = static_cast<uint32_t>(order.size());
+                order.push_back(child);
+            }
+        }
+
+        if (order.size() != numFrames)
+        {
+            DebugTrace("WARNING: SDKMESH frame hierarchy is invalid and will be ignored\n");
+            return;
+        }
+
+        ModelBone::Collection bones(numFrames);
+        std::vector<XMFLOAT4X4> absolute(numFrames);
+
+        for (size_t k = 0; k < numFrames; ++k)
+        {
+            auto& frame = frames[order[k]];
+            auto& bone = bones[k];
+
+            wchar_t frameName[DXUT::MAX_FRAME_NAME] = {};
+            MultiByteToWideChar(CP_UTF8, 0, frame.Name, -1, frameName, DXUT::MAX_FRAME_NAME);
+            bone.name = frameName;
+
+            bone.parentIndex = (frame.ParentFrame == DXUT::INVALID_FRAME) ? ModelBone::c_Invalid : remap[frame.ParentFrame];
+            bone.localTransform = frame.Matrix;
+
+            XMMATRIX world = XMLoadFloat4x4(&frame.Matrix);
+            if (bone.parentIndex != ModelBone::c_Invalid)
+            {
+                world = XMMatrixMultiply(world, XMLoadFloat4x4(&absolute[bone.parentIndex]));
+            }
+
+            XMStoreFloat4x4(&absolute[k], world);
+            XMStoreFloat4x4(&bone.invBindPose, XMMatrixInverse(nullptr, world));
+
+            if (frame.Mesh != DXUT::INVALID_MESH && frame.Mesh < model.meshes.size())
+            {
+                auto& mesh = model.meshes[frame.Mesh];
+                if (mesh->boneIndex == ModelBone::c_Invalid)
+                    mesh->boneIndex = static_cast<uint32_t>(k);
+            }
+        }
+
+        model.bones = std::move(bones);
+    }
 }
 
 
@@ -441,7 +517,7 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(ID3D11Device* d3dDevice
     if (dataSize < header->FrameDataOffset
         || (dataSize < (header->FrameDataOffset + uint64_t(header->NumFrames) * sizeof(DXUT::SDKMESH_FRAME))))
         throw std::exception("End of file");
-    // TODO - auto frameArray = reinterpret_cast<const DXUT::SDKMESH_FRAME*>( meshData + header->FrameDataOffset );
+    auto frameArray = reinterpret_cast<const DXUT::SDKMESH_FRAME*>(meshData + header->FrameDataOffset);
 
     if (dataSize < header->MaterialDataOffset
         || (dataSize < (header->MaterialDataOffset + uint64_t(header->NumMaterials) * sizeof(DXUT::SDKMESH_MATERIAL))))
@@ -692,6 +768,13 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(ID3D11Device* d3dDevice
         model->meshes.emplace_back(mesh);
     }
 
+    if (header->NumFrames > 0)
+    {
+        LoadFrames(frameArray, header->NumFrames, *model);
+    }
+
+    model->TrackMemory();
+
     return model;
 }
 
@@ -701,17 +784,19 @@ _Use_decl_annotations_
 std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(ID3D11Device* d3dDevice, const wchar_t* szFileName, IEffectFactory& fxFactory, bool ccw, bool pmalpha)
 {
     size_t dataSize = 0;
-    std::unique_ptr<uint8_t[]> data;
-    HRESULT hr = BinaryReader::ReadEntireFile(szFileName, data, &dataSize);
+    ScopedMappedView data;
+    HRESULT hr = BinaryReader::MapEntireFile(szFileName, data, &dataSize);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: CreateFromSDKMESH failed (%08X) loading '%ls'\n", hr, szFileName);
         throw std::exception("CreateFromSDKMESH");
     }
 
-    auto model = CreateFromSDKMESH(d3dDevice, data.get(), dataSize, fxFactory, ccw, pmalpha);
+    auto model = CreateFromSDKMESH(d3dDevice, static_cast<const uint8_t*>(data.get()), dataSize, fxFactory, ccw, pmalpha);
 
     model->name = szFileName;
 
+    model->TrackMemory();
+
     return model;
 }
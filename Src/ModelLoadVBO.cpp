@@ -30,6 +30,7 @@ namespace
     // Shared VB input element description
     INIT_ONCE g_InitOnce = INIT_ONCE_STATIC_INIT;
     std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdecl;
+    std::shared_ptr<std::vector<D3D11_INPUT_ELEMENT_DESC>> g_vbdeclPacked;
 
     BOOL CALLBACK InitializeDecl(PINIT_ONCE initOnce, PVOID Parameter, PVOID *lpContext)
     {
@@ -41,6 +42,10 @@ namespace
             VertexPositionNormalTexture::InputElements,
             VertexPositionNormalTexture::InputElements + VertexPositionNormalTexture::InputElementCount);
 
+        g_vbdeclPacked = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+            VertexPositionNormalTexturePacked::InputElements,
+            VertexPositionNormalTexturePacked::InputElements + VertexPositionNormalTexturePacked::InputElementCount);
+
         return TRUE;
     }
 }
@@ -49,7 +54,7 @@ namespace
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, const uint8_t* meshData, size_t dataSize,
-                                                     std::shared_ptr<IEffect> ieffect, bool ccw, bool pmalpha)
+                                                     std::shared_ptr<IEffect> ieffect, bool ccw, bool pmalpha, bool quantize)
 {
     if (!InitOnceExecuteOnce(&g_InitOnce, InitializeDecl, nullptr, nullptr))
         throw std::exception("One-time initialization failed");
@@ -88,13 +93,21 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, co
     // Create vertex buffer
     ComPtr<ID3D11Buffer> vb;
     {
+        std::vector<VertexPositionNormalTexturePacked> packed;
+        if (quantize)
+        {
+            packed.reserve(header->numVertices);
+            for (size_t j = 0; j < header->numVertices; ++j)
+                packed.emplace_back(verts[j]);
+        }
+
         D3D11_BUFFER_DESC desc = {};
         desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.ByteWidth = static_cast<UINT>(vertSize);
+        desc.ByteWidth = quantize ? static_cast<UINT>(packed.size() * sizeof(VertexPositionNormalTexturePacked)) : static_cast<UINT>(vertSize);
         desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
         D3D11_SUBRESOURCE_DATA initData = {};
-        initData.pSysMem = verts;
+        initData.pSysMem = quantize ? static_cast<const void*>(packed.data()) : verts;
 
         ThrowIfFailed(
             d3dDevice->CreateBuffer(&desc, &initData, vb.GetAddressOf())
@@ -138,9 +151,11 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, co
 
         ieffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
 
+        auto& decl = quantize ? *g_vbdeclPacked : *g_vbdecl;
+
         ThrowIfFailed(
-            d3dDevice->CreateInputLayout(VertexPositionNormalTexture::InputElements,
-            VertexPositionNormalTexture::InputElementCount,
+            d3dDevice->CreateInputLayout(decl.data(),
+            static_cast<UINT>(decl.size()),
             shaderByteCode, byteCodeLength,
             il.GetAddressOf()));
 
@@ -150,12 +165,12 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, co
     auto part = new ModelMeshPart();
     part->indexCount = header->numIndices;
     part->startIndex = 0;
-    part->vertexStride = static_cast<UINT>(sizeof(VertexPositionNormalTexture));
+    part->vertexStride = quantize ? static_cast<UINT>(sizeof(VertexPositionNormalTexturePacked)) : static_cast<UINT>(sizeof(VertexPositionNormalTexture));
     part->inputLayout = il;
     part->indexBuffer = ib;
     part->vertexBuffer = vb;
     part->effect = ieffect;
-    part->vbDecl = g_vbdecl;
+    part->vbDecl = quantize ? g_vbdeclPacked : g_vbdecl;
 
     auto mesh = std::make_shared<ModelMesh>();
     mesh->ccw = ccw;
@@ -167,6 +182,8 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, co
     std::unique_ptr<Model> model(new Model());
     model->meshes.emplace_back(mesh);
 
+    model->TrackMemory();
+
     return model;
 }
 
@@ -174,20 +191,22 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, co
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 std::unique_ptr<Model> DirectX::Model::CreateFromVBO(ID3D11Device* d3dDevice, const wchar_t* szFileName,
-                                                     std::shared_ptr<IEffect> ieffect, bool ccw, bool pmalpha)
+                                                     std::shared_ptr<IEffect> ieffect, bool ccw, bool pmalpha, bool quantize)
 {
     size_t dataSize = 0;
-    std::unique_ptr<uint8_t[]> data;
-    HRESULT hr = BinaryReader::ReadEntireFile(szFileName, data, &dataSize);
+    ScopedMappedView data;
+    HRESULT hr = BinaryReader::MapEntireFile(szFileName, data, &dataSize);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: CreateFromVBO failed (%08X) loading '%ls'\n", hr, szFileName);
         throw std::exception("CreateFromVBO");
     }
 
-    auto model = CreateFromVBO(d3dDevice, data.get(), dataSize, ieffect, ccw, pmalpha);
+    auto model = CreateFromVBO(d3dDevice, static_cast<const uint8_t*>(data.get()), dataSize, ieffect, ccw, pmalpha, quantize);
 
     model->name = szFileName;
 
+    model->TrackMemory();
+
     return model;
 }
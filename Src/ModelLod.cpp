@@ -0,0 +1,591 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLod.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "CommonStates.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "GpuProfiler.h"
+#include "LoaderHelpers.h"
+#include "MemoryTracker.h"
+#include "ModelDraw.h"
+#include "PlatformHelpers.h"
+
+#include <DirectXPackedVector.h>
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // ModelLodState keeps levels in bytes.
+    const size_t c_MaxLevels = 255;
+
+    // Projected size of the first threshold made by GenerateLods: the sphere spans about a quarter of the screen height.
+    const float c_FirstScreenSize = 0.125f;
+
+    // Grid coordinates are packed into 21 bits each.
+    const uint32_t c_MaxCell = (1u << 21) - 1;
+
+
+    // Copies a GPU buffer back into memory through a staging buffer.
+    void ReadBuffer(_In_ ID3D11DeviceContext* context, _In_ ID3D11Buffer* buffer, std::vector<uint8_t>& data)
+    {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+
+        ComPtr<ID3D11Device> device;
+        context->GetDevice(device.GetAddressOf());
+
+        D3D11_BUFFER_DESC stagingDesc = {};
+        stagingDesc.ByteWidth = desc.ByteWidth;
+        stagingDesc.Usage = D3D11_USAGE_STAGING;
+        stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        ComPtr<ID3D11Buffer> staging;
+        ThrowIfFailed(device->CreateBuffer(&stagingDesc, nullptr, staging.GetAddressOf()));
+
+        context->CopyResource(staging.Get(), buffer);
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        ThrowIfFailed(context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped));
+
+        auto bytes = static_cast<uint8_t const*>(mapped.pData);
+        data.assign(bytes, bytes + desc.ByteWidth);
+
+        context->Unmap(staging.Get(), 0);
+    }
+
+
+    // Finds the position element of the part's vertex declaration, in one of the formats the loaders write.
+    bool FindPosition(const ModelMeshPart& part, _Out_ UINT& offset, _Out_ DXGI_FORMAT& format)
+    {
+        offset = 0;
+        format = DXGI_FORMAT_UNKNOWN;
+
+        if (!part.vbDecl)
+            return false;
+
+        UINT next = 0;
+        for (auto& element : *part.vbDecl)
+        {
+            if (element.InputSlot != 0)
+                continue;
+
+            UINT elementOffset = (element.AlignedByteOffset == D3D11_APPEND_ALIGNED_ELEMENT) ? next : element.AlignedByteOffset;
+            next = elementOffset + static_cast<UINT>(LoaderHelpers::BitsPerPixel(element.Format) / 8);
+
+            if (element.SemanticIndex == 0 && !_stricmp(element.SemanticName, "SV_Position"))
+            {
+                switch (element.Format)
+                {
+                    case DXGI_FORMAT_R32G32B32_FLOAT:
+                    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+                        offset = elementOffset;
+                        format = element.Format;
+                        return true;
+
+                    default:
+                        return false;
+                }
+            }
+        }
+
+        return false;
+    }
+
+
+    XMFLOAT3 ReadPosition(_In_ const uint8_t* vertex, DXGI_FORMAT format) noexcept
+    {
+        XMFLOAT3 result;
+
+        if (format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+        {
+            PackedVector::XMHALF4 half;
+            memcpy(&half, vertex, sizeof(half));
+            XMStoreFloat3(&result, PackedVector::XMLoadHalf4(&half));
+        }
+        else
+        {
+            memcpy(&result, vertex, sizeof(result));
+        }
+
+        return result;
+    }
+
+
+    // Simplifies a triangle list by vertex clustering. Vertices are snapped to a grid, each occupied cell is
+    // represented by its vertex nearest the mean of the cell, and triangles that collapse or repeat are dropped.
+    // Representatives are existing vertices, so the result indexes the original vertex buffer.
+    class VertexClusterer
+    {
+    public:
+        VertexClusterer() noexcept :
+            mMin(0.f, 0.f, 0.f),
+            mExtent(0.f)
+        {
+        }
+
+        // Adds a triangle corner, given its value in the index buffer and its position.
+        void AddCorner(uint32_t index, const XMFLOAT3& position)
+        {
+            auto it = mVertexMap.find(index);
+            if (it == mVertexMap.end())
+            {
+                it = mVertexMap.emplace(index, static_cast<uint32_t>(mVertices.size())).first;
+                mVertices.push_back(index);
+                mPositions.push_back(position);
+            }
+
+            mCorners.push_back(it->second);
+        }
+
+        void Finish()
+        {
+            if (mPositions.empty())
+                return;
+
+            XMVECTOR vmin = XMLoadFloat3(&mPositions[0]);
+            XMVECTOR vmax = vmin;
+
+            for (auto& p : mPositions)
+            {
+                XMVECTOR v = XMLoadFloat3(&p);
+                vmin = XMVectorMin(vmin, v);
+                vmax = XMVectorMax(vmax, v);
+            }
+
+            XMStoreFloat3(&mMin, vmin);
+
+            XMFLOAT3 size;
+            XMStoreFloat3(&size, XMVectorSubtract(vmax, vmin));
+            mExtent = std::max(size.x, std::max(size.y, size.z));
+
+            mVertexMap.clear();
+        }
+
+        size_t GetVertexCount() const noexcept { return mVertices.size(); }
+        size_t GetTriangleCount() const noexcept { return mCorners.size() / 3; }
+        float GetExtent() const noexcept { return mExtent; }
+
+        // Clusters with the given number of cells along the longest side, appending the kept triangles
+        // (as index buffer values) and returning how many there were.
+        size_t Cluster(float resolution, std::vector<uint32_t>& result)
+        {
+            float cellScale = (mExtent > 0.f) ? resolution / mExtent : 0.f;
+
+            std::unordered_map<uint64_t, uint32_t> cells;
+            cells.reserve(mVertices.size());
+
+            std::vector<uint32_t> cellOf(mVertices.size());
+            std::vector<XMFLOAT4> sums;
+
+            for (size_t j = 0; j < mPositions.size(); ++j)
+            {
+                auto& p = mPositions[j];
+
+                auto cellIndex = [=](float value, float origin) noexcept
+                {
+                    float cell = (value - origin) * cellScale;
+                    return std::min(static_cast<uint32_t>(std::max(cell, 0.f)), c_MaxCell);
+                };
+
+                uint64_t key = uint64_t(cellIndex(p.x, mMin.x))
+                    | (uint64_t(cellIndex(p.y, mMin.y)) << 21)
+                    | (uint64_t(cellIndex(p.z, mMin.z)) << 42);
+
+                auto it = cells.emplace(key, static_cast<uint32_t>(sums.size())).first;
+                if (it->second == sums.size())
+                    sums.emplace_back(0.f, 0.f, 0.f, 0.f);
+
+                cellOf[j] = it->second;
+
+                auto& sum = sums[it->second];
+                sum.x += p.x;
+                sum.y += p.y;
+                sum.z += p.z;
+                sum.w += 1.f;
+            }
+
+            std::vector<uint32_t> representative(sums.size(), 0);
+            std::vector<float> nearest(sums.size(), FLT_MAX);
+
+            for (size_t j = 0; j < mPositions.size(); ++j)
+            {
+                auto cell = cellOf[j];
+                auto& sum = sums[cell];
+
+                XMVECTOR mean = XMVectorScale(XMLoadFloat4(&sum), 1.f / sum.w);
+                float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&mPositions[j]), mean)));
+
+                if (distance < nearest[cell])
+                {
+                    nearest[cell] = distance;
+                    representative[cell] = static_cast<uint32_t>(j);
+                }
+            }
+
+            // Triangles are compared rotated to start at their smallest vertex, which keeps the winding.
+            std::unordered_set<uint64_t> seen;
+            bool findRepeats = mVertices.size() <= c_MaxCell;
+
+            size_t kept = 0;
+
+            for (size_t j = 0; j + 2 < mCorners.size(); j += 3)
+            {
+                uint32_t a = representative[cellOf[mCorners[j]]];
+                uint32_t b = representative[cellOf[mCorners[j + 1]]];
+                uint32_t c = representative[cellOf[mCorners[j + 2]]];
+
+                if (a == b || b == c || a == c)
+                    continue;
+
+                if (findRepeats)
+                {
+                    uint32_t r0 = a, r1 = b, r2 = c;
+                    if (b < a && b < c)
+                    {
+                        r0 = b; r1 = c; r2 = a;
+                    }
+                    else if (c < a && c < b)
+                    {
+                        r0 = c; r1 = a; r2 = b;
+                    }
+
+                    if (!seen.insert(uint64_t(r0) | (uint64_t(r1) << 21) | (uint64_t(r2) << 42)).second)
+                        continue;
+                }
+
+                result.push_back(mVertices[a]);
+                result.push_back(mVertices[b]);
+                result.push_back(mVertices[c]);
+                ++kept;
+            }
+
+            return kept;
+        }
+
+    private:
+        std::vector<uint32_t>                   mVertices;
+        std::vector<XMFLOAT3>                   mPositions;
+        std::vector<uint32_t>                   mCorners;
+        std::unordered_map<uint32_t, uint32_t>  mVertexMap;
+        XMFLOAT3                                mMin;
+        float                                   mExtent;
+    };
+
+
+    void CreateLods(
+        _In_ ID3D11Device* device,
+        ModelMeshPart& part,
+        std::vector<uint8_t> const& indexData,
+        std::vector<uint8_t> const& vertexData,
+        UINT positionOffset,
+        DXGI_FORMAT positionFormat,
+        size_t maxLevels,
+        float ratio)
+    {
+        size_t indexSize = (part.indexFormat == DXGI_FORMAT_R32_UINT) ? sizeof(uint32_t) : sizeof(uint16_t);
+        size_t positionSize = LoaderHelpers::BitsPerPixel(positionFormat) / 8;
+
+        if ((uint64_t(part.startIndex) + part.indexCount) * indexSize > indexData.size())
+            throw std::exception("Mesh part index range is outside its index buffer");
+
+        VertexClusterer clusterer;
+
+        auto indices = indexData.data() + size_t(part.startIndex) * indexSize;
+        size_t cornerCount = part.indexCount - (part.indexCount % 3);
+
+        for (size_t j = 0; j < cornerCount; ++j)
+        {
+            uint32_t index;
+            if (indexSize == sizeof(uint32_t))
+            {
+                memcpy(&index, indices + j * sizeof(uint32_t), sizeof(uint32_t));
+            }
+            else
+            {
+                uint16_t index16;
+                memcpy(&index16, indices + j * sizeof(uint16_t), sizeof(uint16_t));
+                index = index16;
+            }
+
+            int64_t vertex = int64_t(index) + part.vertexOffset;
+            uint64_t offset = uint64_t(vertex) * part.vertexStride + positionOffset;
+
+            if (vertex < 0 || offset + positionSize > vertexData.size())
+                throw std::exception("Mesh part index refers outside its vertex buffer");
+
+            clusterer.AddCorner(index, ReadPosition(vertexData.data() + offset, positionFormat));
+        }
+
+        clusterer.Finish();
+
+        if (clusterer.GetExtent() <= 0.f)
+            return;
+
+        std::vector<uint32_t> lodIndices;
+        std::vector<ModelMeshPart::LodLevel> lods;
+
+        size_t triangles = clusterer.GetTriangleCount();
+
+        // A surface of n vertices needs roughly sqrt(n) cells along a side to keep its detail.
+        float resolution = std::min(2.f * sqrtf(float(clusterer.GetVertexCount())), float(c_MaxCell));
+
+        while (lods.size() < maxLevels && triangles > 1 && resolution > 1.f)
+        {
+            auto target = static_cast<size_t>(float(triangles) * ratio);
+
+            size_t start = lodIndices.size();
+            size_t kept = triangles;
+
+            while (resolution > 1.f)
+            {
+                resolution = std::max(resolution / 1.2f, 1.f);
+
+                lodIndices.resize(start);
+                kept = clusterer.Cluster(resolution, lodIndices);
+
+                if (kept <= target)
+                    break;
+            }
+
+            if (!kept || kept >= triangles)
+            {
+                lodIndices.resize(start);
+                break;
+            }
+
+            ModelMeshPart::LodLevel lod = { static_cast<uint32_t>(start), static_cast<uint32_t>(kept * 3) };
+            lods.push_back(lod);
+
+            triangles = kept;
+        }
+
+        if (lods.empty())
+            return;
+
+        D3D11_SUBRESOURCE_DATA initData = {};
+        std::vector<uint16_t> indices16;
+
+        if (indexSize == sizeof(uint16_t))
+        {
+            indices16.assign(lodIndices.cbegin(), lodIndices.cend());
+            initData.pSysMem = indices16.data();
+        }
+        else
+        {
+            initData.pSysMem = lodIndices.data();
+        }
+
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(lodIndices.size() * indexSize), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_DEFAULT);
+
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, part.lodIndexBuffer.ReleaseAndGetAddressOf()));
+
+        SetDebugObjectName(part.lodIndexBuffer.Get(), "ModelMeshPart LOD");
+
+        MemoryTracker::TrackResource(part.lodIndexBuffer.Get(), MemoryCategory_IndexBuffer, L"ModelMeshPart LOD");
+
+        part.lods = std::move(lods);
+    }
+
+
+    void XM_CALLCONV DrawMeshLod(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const ModelMesh& mesh,
+        size_t level,
+        FXMMATRIX world,
+        CXMMATRIX view,
+        CXMMATRIX projection,
+        bool alpha,
+        std::function<void()> const& setCustomState)
+    {
+        for (auto it = mesh.meshParts.cbegin(); it != mesh.meshParts.cend(); ++it)
+        {
+            auto part = (*it).get();
+            assert(part != nullptr);
+
+            if (part->isAlpha != alpha)
+                continue;
+
+            auto imatrices = part->GetEffectMatrices();
+            if (imatrices)
+            {
+                imatrices->SetMatrices(world, view, projection);
+            }
+
+            part->DrawLod(deviceContext, part->effect.get(), part->inputLayout.Get(), level, setCustomState);
+        }
+    }
+}
+
+
+_Use_decl_annotations_
+void Model::GenerateLods(ID3D11DeviceContext* deviceContext, size_t maxLevels, float ratio)
+{
+    assert(deviceContext != nullptr);
+
+    if (maxLevels > c_MaxLevels)
+        throw std::out_of_range("maxLevels too large for GenerateLods");
+
+    if (!(ratio > 0.f && ratio < 1.f))
+        throw std::invalid_argument("ratio must be between 0 and 1");
+
+    ComPtr<ID3D11Device> device;
+    deviceContext->GetDevice(device.GetAddressOf());
+
+    // Parts usually share their mesh's or model's buffers, so each is read back once.
+    std::map<ID3D11Buffer*, std::vector<uint8_t>> buffers;
+
+    auto readBuffer = [&](ID3D11Buffer* buffer) -> std::vector<uint8_t> const&
+    {
+        auto it = buffers.find(buffer);
+        if (it == buffers.end())
+        {
+            it = buffers.emplace(buffer, std::vector<uint8_t>()).first;
+            ReadBuffer(deviceContext, buffer, it->second);
+        }
+
+        return it->second;
+    };
+
+    for (auto mit = meshes.cbegin(); mit != meshes.cend(); ++mit)
+    {
+        auto mesh = mit->get();
+        assert(mesh != nullptr);
+
+        size_t meshLevels = 0;
+
+        for (auto it = mesh->meshParts.cbegin(); it != mesh->meshParts.cend(); ++it)
+        {
+            auto part = it->get();
+            assert(part != nullptr);
+
+            part->lods.clear();
+            part->lodIndexBuffer.Reset();
+
+            if (!maxLevels
+                || part->primitiveType != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+                || !part->indexBuffer
+                || !part->vertexBuffer
+                || part->indexCount < 3)
+                continue;
+
+            UINT positionOffset;
+            DXGI_FORMAT positionFormat;
+            if (!FindPosition(*part, positionOffset, positionFormat))
+            {
+                DebugTrace("WARNING: GenerateLods skipping a mesh part without a readable position\n");
+                continue;
+            }
+
+            auto& indexData = readBuffer(part->indexBuffer.Get());
+            auto& vertexData = readBuffer(part->vertexBuffer.Get());
+
+            CreateLods(device.Get(), *part, indexData, vertexData, positionOffset, positionFormat, maxLevels, ratio);
+
+            meshLevels = std::max(meshLevels, part->lods.size());
+        }
+
+        // Each level has about ratio of the triangles of the one before, so stepping the size by sqrt(ratio)
+        // keeps the triangles per pixel roughly even.
+        if (mesh->lodScreenSizes.empty() && meshLevels > 0)
+        {
+            float step = sqrtf(ratio);
+            float size = c_FirstScreenSize;
+
+            for (size_t j = 0; j < meshLevels; ++j)
+            {
+                mesh->lodScreenSizes.push_back(size);
+                size *= step;
+            }
+        }
+    }
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV Model::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    ModelLodState& lodState,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe, std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    GpuProfileScope profileScope(deviceContext, L"Model::Draw");
+
+    lodState.levels.resize(meshes.size());
+
+    XMMATRIX worldView = XMMatrixMultiply(world, view);
+
+    // The view is rigid, so the longest axis of worldView gives the scale of the bounding spheres.
+    XMVECTOR axisLength = XMVectorMax(XMVector3LengthSq(worldView.r[0]),
+                                      XMVectorMax(XMVector3LengthSq(worldView.r[1]), XMVector3LengthSq(worldView.r[2])));
+    float scale = sqrtf(XMVectorGetX(axisLength));
+
+    XMFLOAT4X4 proj;
+    XMStoreFloat4x4(&proj, projection);
+
+    float hysteresis = lodState.hysteresis;
+
+    for (size_t j = 0; j < meshes.size(); ++j)
+    {
+        auto mesh = meshes[j].get();
+        assert(mesh != nullptr);
+
+        auto& thresholds = mesh->lodScreenSizes;
+        size_t maxLevel = std::min(thresholds.size(), c_MaxLevels);
+        size_t level = std::min<size_t>(lodState.levels[j], maxLevel);
+
+        if (maxLevel > 0)
+        {
+            XMVECTOR center = XMVector3Transform(XMLoadFloat3(&mesh->boundingSphere.Center), worldView);
+
+            // Clip space w of the center: _34 is 1 or -1 (by handedness) for a perspective projection, and _44 is
+            // 1 for an orthographic one.
+            float w = XMVectorGetZ(center) * proj._34 + proj._44;
+
+            if (w <= FLT_EPSILON)
+            {
+                level = 0;
+            }
+            else
+            {
+                float size = mesh->boundingSphere.Radius * scale * fabsf(proj._22) / w;
+
+                while (level < maxLevel && size < thresholds[level] * (1.f - hysteresis))
+                    ++level;
+
+                while (level > 0 && size > thresholds[level - 1] * (1.f + hysteresis))
+                    --level;
+            }
+        }
+
+        lodState.levels[j] = static_cast<uint8_t>(level);
+    }
+
+    ModelRenderState renderState;
+
+    DrawMeshesOpaqueThenAlpha(deviceContext, states, renderState, meshes, nullptr, wireframe, setCustomState,
+        [&](size_t j, ModelMesh const& mesh, bool alpha)
+        {
+            DrawMeshLod(deviceContext, mesh, lodState.levels[j], world, view, projection, alpha, setCustomState);
+        });
+}
@@ -0,0 +1,332 @@
+//--------------------------------------------------------------------------------------
+// File: ModelRenderQueue.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "CommonStates.h"
+#include "Effects.h"
+
+#include <tuple>
+
+using namespace DirectX;
+
+
+namespace
+{
+    struct QueuedPart
+    {
+        ModelMeshPart const* part;
+        ModelMesh const* mesh;
+        size_t worldIndex;
+        float distanceSq;
+    };
+
+
+    // Opaque parts are grouped by rasterizer state, then effect, then world matrix (each change of
+    // effect or world needs another Apply), then input layout and buffers.
+    bool OpaqueLess(QueuedPart const& a, QueuedPart const& b) noexcept
+    {
+        auto key = [](QueuedPart const& q)
+        {
+            return std::make_tuple(
+                q.mesh->ccw,
+                reinterpret_cast<uintptr_t>(q.part->effect.get()),
+                q.worldIndex,
+                reinterpret_cast<uintptr_t>(q.part->inputLayout.Get()),
+                reinterpret_cast<uintptr_t>(q.part->vertexBuffer.Get()),
+                reinterpret_cast<uintptr_t>(q.part->indexBuffer.Get()));
+        };
+
+        return key(a) < key(b);
+    }
+
+
+    // Tracks what the previous part bound, so identical input assembler state and effect applies are skipped.
+    struct SubmitState
+    {
+        SubmitState() noexcept { Reset(); }
+
+        void Reset() noexcept
+        {
+            inputLayout = nullptr;
+            vertexBuffer = nullptr;
+            vertexStride = 0;
+            indexBuffer = nullptr;
+            indexFormat = DXGI_FORMAT_UNKNOWN;
+            effect = nullptr;
+            worldIndex = size_t(-1);
+        }
+
+        ID3D11InputLayout* inputLayout;
+        ID3D11Buffer* vertexBuffer;
+        UINT vertexStride;
+        ID3D11Buffer* indexBuffer;
+        DXGI_FORMAT indexFormat;
+        IEffect* effect;
+        size_t worldIndex;
+    };
+}
+
+
+// Internal ModelRenderQueue implementation class.
+class ModelRenderQueue::Impl
+{
+public:
+    void Add(const ModelMesh& mesh, size_t worldIndex);
+
+    void XM_CALLCONV Draw(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, FXMMATRIX view, CXMMATRIX projection,
+                          bool wireframe, std::function<void()> const& setCustomState);
+
+    void Clear() noexcept
+    {
+        mWorlds.clear();
+        mOpaqueParts.clear();
+        mAlphaParts.clear();
+    }
+
+    std::vector<XMFLOAT4X4> mWorlds;
+    std::vector<QueuedPart> mOpaqueParts;
+    std::vector<QueuedPart> mAlphaParts;
+
+private:
+    void XM_CALLCONV DrawPart(_In_ ID3D11DeviceContext* deviceContext, const CommonStates& states, QueuedPart const& queued,
+                              FXMMATRIX view, CXMMATRIX projection, bool alpha, bool wireframe,
+                              std::function<void()> const& setCustomState);
+
+    ModelRenderState mRenderState;
+    SubmitState mSubmitState;
+};
+
+
+void ModelRenderQueue::Impl::Add(const ModelMesh& mesh, size_t worldIndex)
+{
+    for (auto it = mesh.meshParts.cbegin(); it != mesh.meshParts.cend(); ++it)
+    {
+        auto part = it->get();
+        assert(part != nullptr && part->effect != nullptr);
+
+        QueuedPart queued = { part, &mesh, worldIndex, 0.f };
+
+        if (part->isAlpha)
+            mAlphaParts.push_back(queued);
+        else
+            mOpaqueParts.push_back(queued);
+    }
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV ModelRenderQueue::Impl::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> const& setCustomState)
+{
+    assert(deviceContext != nullptr);
+
+    std::sort(mOpaqueParts.begin(), mOpaqueParts.end(), OpaqueLess);
+
+    // Alpha parts are drawn furthest first, measured from the eye to the center of each mesh's bounding sphere.
+    // Stable sorting keeps the parts of one mesh in their file order.
+    XMMATRIX viewInverse = XMMatrixInverse(nullptr, view);
+    XMVECTOR eyePosition = viewInverse.r[3];
+
+    for (auto& queued : mAlphaParts)
+    {
+        XMVECTOR center = XMLoadFloat3(&queued.mesh->boundingSphere.Center);
+        center = XMVector3Transform(center, XMLoadFloat4x4(&mWorlds[queued.worldIndex]));
+
+        queued.distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(center, eyePosition)));
+    }
+
+    std::stable_sort(mAlphaParts.begin(), mAlphaParts.end(), [](QueuedPart const& a, QueuedPart const& b) noexcept
+    {
+        return a.distanceSq > b.distanceSq;
+    });
+
+    // Other code may have changed any state since the last Draw.
+    mRenderState.Reset();
+    mSubmitState.Reset();
+
+    for (auto const& queued : mOpaqueParts)
+    {
+        DrawPart(deviceContext, states, queued, view, projection, false, wireframe, setCustomState);
+    }
+
+    for (auto const& queued : mAlphaParts)
+    {
+        DrawPart(deviceContext, states, queued, view, projection, true, wireframe, setCustomState);
+    }
+
+    Clear();
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV ModelRenderQueue::Impl::DrawPart(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    QueuedPart const& queued,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    bool alpha,
+    bool wireframe,
+    std::function<void()> const& setCustomState)
+{
+    queued.mesh->PrepareForRendering(deviceContext, states, mRenderState, alpha, wireframe);
+
+    auto part = queued.part;
+
+    auto inputLayout = part->inputLayout.Get();
+    if (inputLayout != mSubmitState.inputLayout)
+    {
+        deviceContext->IASetInputLayout(inputLayout);
+        mSubmitState.inputLayout = inputLayout;
+    }
+
+    auto vb = part->vertexBuffer.Get();
+    if (vb != mSubmitState.vertexBuffer || part->vertexStride != mSubmitState.vertexStride)
+    {
+        UINT vbStride = part->vertexStride;
+        UINT vbOffset = 0;
+        deviceContext->IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
+
+        mSubmitState.vertexBuffer = vb;
+        mSubmitState.vertexStride = vbStride;
+    }
+
+    auto ib = part->indexBuffer.Get();
+    if (ib != mSubmitState.indexBuffer || part->indexFormat != mSubmitState.indexFormat)
+    {
+        deviceContext->IASetIndexBuffer(ib, part->indexFormat, 0);
+
+        mSubmitState.indexBuffer = ib;
+        mSubmitState.indexFormat = part->indexFormat;
+    }
+
+    // Nothing else touches the effect between parts, so it is only set up and applied again when the
+    // effect or the world matrix changes.
+    auto effect = part->effect.get();
+    if (effect != mSubmitState.effect || queued.worldIndex != mSubmitState.worldIndex)
+    {
+        auto imatrices = part->GetEffectMatrices();
+        if (imatrices)
+        {
+            imatrices->SetMatrices(XMLoadFloat4x4(&mWorlds[queued.worldIndex]), view, projection);
+        }
+
+        effect->Apply(deviceContext);
+
+        mSubmitState.effect = effect;
+        mSubmitState.worldIndex = queued.worldIndex;
+    }
+
+    // Hook lets the caller replace our shaders or state settings with whatever else they see fit.
+    if (setCustomState)
+    {
+        setCustomState();
+        InvalidateEffectStateCache(deviceContext);
+    }
+
+    // Draw the primitive.
+    deviceContext->IASetPrimitiveTopology(part->primitiveType);
+
+    deviceContext->DrawIndexed(part->indexCount, part->startIndex, part->vertexOffset);
+
+    if (setCustomState)
+    {
+        // The hook may have changed anything, so assume nothing about the next part.
+        mRenderState.Reset();
+        mSubmitState.Reset();
+    }
+}
+
+
+// Public constructor.
+ModelRenderQueue::ModelRenderQueue() noexcept(false)
+    : pImpl(std::make_unique<Impl>())
+{
+}
+
+
+// Move constructor.
+ModelRenderQueue::ModelRenderQueue(ModelRenderQueue&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ModelRenderQueue& ModelRenderQueue::operator= (ModelRenderQueue&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ModelRenderQueue::~ModelRenderQueue()
+{
+}
+
+
+void XM_CALLCONV ModelRenderQueue::Add(const Model& model, FXMMATRIX world)
+{
+    size_t worldIndex = pImpl->mWorlds.size();
+
+    XMFLOAT4X4 w;
+    XMStoreFloat4x4(&w, world);
+    pImpl->mWorlds.push_back(w);
+
+    for (auto it = model.meshes.cbegin(); it != model.meshes.cend(); ++it)
+    {
+        assert(*it != nullptr);
+        pImpl->Add(**it, worldIndex);
+    }
+}
+
+
+void XM_CALLCONV ModelRenderQueue::Add(const ModelMesh& mesh, FXMMATRIX world)
+{
+    size_t worldIndex = pImpl->mWorlds.size();
+
+    XMFLOAT4X4 w;
+    XMStoreFloat4x4(&w, world);
+    pImpl->mWorlds.push_back(w);
+
+    pImpl->Add(mesh, worldIndex);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV ModelRenderQueue::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    FXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState)
+{
+    pImpl->Draw(deviceContext, states, view, projection, wireframe, setCustomState);
+}
+
+
+void ModelRenderQueue::Clear() noexcept
+{
+    pImpl->Clear();
+}
+
+
+size_t ModelRenderQueue::GetPartCount() const noexcept
+{
+    return pImpl->mOpaqueParts.size() + pImpl->mAlphaParts.size();
+}
@@ -0,0 +1,161 @@
+//--------------------------------------------------------------------------------------
+// File: ModelTransforms.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// ModelTransforms
+//--------------------------------------------------------------------------------------
+
+ModelTransforms::ModelTransforms() noexcept :
+    mFirstDirty(0)
+{
+}
+
+
+ModelTransforms::ModelTransforms(const ModelBone::Collection& bones) :
+    mFirstDirty(0)
+{
+    Reset(bones);
+}
+
+
+void ModelTransforms::Reset(const ModelBone::Collection& bones)
+{
+    size_t count = bones.size();
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        if (bones[j].parentIndex != ModelBone::c_Invalid && bones[j].parentIndex >= j)
+            throw std::exception("ModelTransforms requires each parent bone before its children");
+    }
+
+    mParents.resize(count);
+    mLocal.resize(count);
+    mAbsolute.resize(count);
+    mDirty.assign(count, 1);
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        mParents[j] = bones[j].parentIndex;
+        mLocal[j] = bones[j].localTransform;
+    }
+
+    mFirstDirty = 0;
+    Update();
+}
+
+
+void XM_CALLCONV ModelTransforms::SetLocalTransform(size_t bone, FXMMATRIX transform)
+{
+    if (bone >= mParents.size())
+        throw std::out_of_range("Bone index out of range");
+
+    XMStoreFloat4x4(&mLocal[bone], transform);
+
+    mDirty[bone] = 1;
+    mFirstDirty = std::min(mFirstDirty, bone);
+}
+
+
+_Use_decl_annotations_
+void ModelTransforms::SetLocalTransforms(size_t firstBone, const XMMATRIX* transforms, size_t count)
+{
+    if (firstBone > mParents.size() || count > mParents.size() - firstBone)
+        throw std::out_of_range("Bone range out of range");
+
+    if (!count)
+        return;
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        XMStoreFloat4x4(&mLocal[firstBone + j], transforms[j]);
+        mDirty[firstBone + j] = 1;
+    }
+
+    mFirstDirty = std::min(mFirstDirty, firstBone);
+}
+
+
+XMMATRIX ModelTransforms::GetLocalTransform(size_t bone) const
+{
+    if (bone >= mParents.size())
+        throw std::out_of_range("Bone index out of range");
+
+    return XMLoadFloat4x4(&mLocal[bone]);
+}
+
+
+XMMATRIX ModelTransforms::GetAbsoluteTransform(size_t bone) const
+{
+    if (bone >= mParents.size())
+        throw std::out_of_range("Bone index out of range");
+
+    return XMLoadFloat4x4(&mAbsolute[bone]);
+}
+
+
+// Parents come first, so one pass from the first dirty bone sees every parent settled before its children. A bone
+// is recomputed if it or its parent is dirty, and stays marked for the rest of the pass so its own children follow.
+void ModelTransforms::Update() noexcept
+{
+    size_t count = mParents.size();
+
+    for (size_t j = mFirstDirty; j < count; ++j)
+    {
+        uint32_t parent = mParents[j];
+
+        if (parent != ModelBone::c_Invalid && mDirty[parent])
+            mDirty[j] = 1;
+
+        if (!mDirty[j])
+            continue;
+
+        XMMATRIX local = XMLoadFloat4x4(&mLocal[j]);
+
+        if (parent != ModelBone::c_Invalid)
+        {
+            XMStoreFloat4x4(&mAbsolute[j], XMMatrixMultiply(local, XMLoadFloat4x4(&mAbsolute[parent])));
+        }
+        else
+        {
+            XMStoreFloat4x4(&mAbsolute[j], local);
+        }
+    }
+
+    if (mFirstDirty < count)
+    {
+        memset(mDirty.data() + mFirstDirty, 0, count - mFirstDirty);
+    }
+
+    mFirstDirty = count;
+}
+
+
+_Use_decl_annotations_
+void DirectX::UpdateModelTransforms(ModelTransforms* transforms, size_t count)
+{
+    if (!count)
+        return;
+
+    if (!transforms)
+        throw std::invalid_argument("transforms");
+
+    ParallelFor(count, [=](size_t index)
+    {
+        if (transforms[index].IsDirty())
+            transforms[index].Update();
+    });
+}
@@ -10,9 +10,13 @@
 
 #include "pch.h"
 #include "Mouse.h"
+#include "InputEvents.h"
 
 #include "PlatformHelpers.h"
 
+#include <atomic>
+#include <thread>
+
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
@@ -66,7 +70,16 @@ public:
         mLastY(0),
         mRelativeX(INT32_MAX),
         mRelativeY(INT32_MAX),
-        mInFocus(true)
+        mInFocus(true),
+        mRawInputMode(RAW_INPUT_MESSAGES),
+        mRawX(0),
+        mRawY(0),
+        mRawWheel(0),
+        mRawLastX(INT32_MAX),
+        mRawLastY(INT32_MAX),
+        mRawDataOffset(0),
+        mRawThreadFailed(false),
+        mEventQueue(nullptr)
     {
         if (s_mouse)
         {
@@ -75,6 +88,15 @@ public:
 
         s_mouse = this;
 
+    #if !defined(_WIN64)
+        // A 32-bit process on 64-bit Windows gets GetRawInputBuffer data laid out with the 64-bit header.
+        BOOL wow64 = FALSE;
+        if (IsWow64Process(GetCurrentProcess(), &wow64) && wow64)
+        {
+            mRawDataOffset = 8;
+        }
+    #endif
+
         mScrollWheelValue.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
         mRelativeRead.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
         mAbsoluteMode.reset(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
@@ -90,11 +112,28 @@ public:
 
     ~Impl()
     {
+        StopRawInputThread();
+
         s_mouse = nullptr;
     }
 
-    void GetState(State& state) const
+    void GetState(State& state)
     {
+        int rawX = 0;
+        int rawY = 0;
+
+        if (mRawInputMode != RAW_INPUT_MESSAGES)
+        {
+            if (mRawInputMode == RAW_INPUT_BUFFERED)
+            {
+                DrainRawInput();
+            }
+
+            rawX = mRawX.exchange(0);
+            rawY = mRawY.exchange(0);
+            mState.scrollWheelValue += mRawWheel.exchange(0);
+        }
+
         memcpy(&state, &mState, sizeof(State));
         state.positionMode = mMode;
 
@@ -107,7 +146,12 @@ public:
             state.scrollWheelValue = 0;
         }
 
-        if (state.positionMode == MODE_RELATIVE)
+        if (state.positionMode == MODE_RELATIVE && mRawInputMode != RAW_INPUT_MESSAGES)
+        {
+            state.x = rawX;
+            state.y = rawY;
+        }
+        else if (state.positionMode == MODE_RELATIVE)
         {
             result = WaitForSingleObjectEx(mRelativeRead.get(), 0, FALSE);
 
@@ -195,12 +239,8 @@ public:
 
         assert(window != nullptr);
 
-        RAWINPUTDEVICE Rid;
-        Rid.usUsagePage = 0x1 /* HID_USAGE_PAGE_GENERIC */;
-        Rid.usUsage = 0x2 /* HID_USAGE_GENERIC_MOUSE */;
-        Rid.dwFlags = RIDEV_INPUTSINK;
-        Rid.hwndTarget = window;
-        if (!RegisterRawInputDevices(&Rid, 1, sizeof(RAWINPUTDEVICE)))
+        // The raw input thread keeps the registration for its own window.
+        if (mRawInputMode != RAW_INPUT_THREAD && !RegisterRawInput(window))
         {
             throw std::exception("RegisterRawInputDevices");
         }
@@ -208,6 +248,32 @@ public:
         mWindow = window;
     }
 
+    void SetRawInputMode(RawInputMode mode)
+    {
+        if (mRawInputMode == mode)
+            return;
+
+        if (mRawInputMode == RAW_INPUT_THREAD)
+        {
+            StopRawInputThread();
+
+            if (mWindow && !RegisterRawInput(mWindow))
+            {
+                throw std::exception("RegisterRawInputDevices");
+            }
+        }
+
+        mRawX = 0;
+        mRawY = 0;
+        mRawWheel = 0;
+        mRawInputMode = mode;
+
+        if (mode == RAW_INPUT_THREAD)
+        {
+            StartRawInputThread();
+        }
+    }
+
     State           mState;
 
     Mouse*          mOwner;
@@ -228,10 +294,236 @@ private:
     int             mRelativeX;
     int             mRelativeY;
 
-    bool            mInFocus;
+    std::atomic<bool> mInFocus;
+
+    // Buffered raw input, summed by whichever thread drains it until GetState takes it.
+    std::atomic<RawInputMode> mRawInputMode;
+    std::atomic<int> mRawX;
+    std::atomic<int> mRawY;
+    std::atomic<int> mRawWheel;
+
+    // Only touched by the draining thread.
+    int             mRawLastX;
+    int             mRawLastY;
+    size_t          mRawDataOffset;
+    std::unique_ptr<uint64_t[]> mRawBuffer;
+
+    std::thread     mRawThread;
+    ScopedHandle    mRawThreadExit;
+    ScopedHandle    mRawThreadReady;
+    bool            mRawThreadFailed;
+
+    // Read by the raw input thread as well.
+    std::atomic<InputEventQueue*> mEventQueue;
+
+    static const UINT RawBufferSize = 16384;
 
     friend void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam);
 
+    void PushEvent(InputEvent::Type type, uint16_t code, int32_t x = 0, int32_t y = 0) noexcept
+    {
+        auto queue = mEventQueue.load();
+        if (queue)
+            queue->Push(type, code, x, y);
+    }
+
+    void PushButtonChanges(const State& previous) noexcept
+    {
+        const bool before[] = { previous.leftButton, previous.rightButton, previous.middleButton, previous.xButton1, previous.xButton2 };
+        const bool after[] = { mState.leftButton, mState.rightButton, mState.middleButton, mState.xButton1, mState.xButton2 };
+
+        for (size_t j = 0; j < _countof(before); ++j)
+        {
+            if (before[j] != after[j])
+            {
+                PushEvent(after[j] ? InputEvent::MOUSE_BUTTON_DOWN : InputEvent::MOUSE_BUTTON_UP, static_cast<uint16_t>(InputEvent::MOUSE_LEFT + j));
+            }
+        }
+    }
+
+    static bool RegisterRawInput(HWND window) noexcept
+    {
+        RAWINPUTDEVICE Rid;
+        Rid.usUsagePage = 0x1 /* HID_USAGE_PAGE_GENERIC */;
+        Rid.usUsage = 0x2 /* HID_USAGE_GENERIC_MOUSE */;
+        Rid.dwFlags = RIDEV_INPUTSINK;
+        Rid.hwndTarget = window;
+        return RegisterRawInputDevices(&Rid, 1, sizeof(RAWINPUTDEVICE)) != FALSE;
+    }
+
+    // Reads every raw input event queued for the calling thread, a buffer at a time.
+    void DrainRawInput() noexcept
+    {
+        if (!mRawBuffer)
+        {
+            mRawBuffer.reset(new (std::nothrow) uint64_t[RawBufferSize / sizeof(uint64_t)]);
+            if (!mRawBuffer)
+                return;
+        }
+
+        for (;;)
+        {
+            UINT size = RawBufferSize;
+            UINT count = GetRawInputBuffer(reinterpret_cast<PRAWINPUT>(mRawBuffer.get()), &size, sizeof(RAWINPUTHEADER));
+            if (!count || count == UINT(-1))
+                break;
+
+            auto raw = reinterpret_cast<PRAWINPUT>(mRawBuffer.get());
+            for (UINT j = 0; j < count; ++j)
+            {
+                if (raw->header.dwType == RIM_TYPEMOUSE)
+                {
+                    AddRawMouse(*reinterpret_cast<const RAWMOUSE*>(reinterpret_cast<const uint8_t*>(&raw->data) + mRawDataOffset));
+                }
+
+                raw = NEXTRAWINPUTBLOCK(raw);
+            }
+        }
+    }
+
+    // Reads the input of a WM_INPUT message that has already been taken off the queue, which GetRawInputBuffer no
+    // longer returns.
+    void AddRawInput(HRAWINPUT input) noexcept
+    {
+        RAWINPUT raw;
+        UINT rawSize = sizeof(raw);
+
+        UINT resultData = GetRawInputData(input, RID_INPUT, &raw, &rawSize, sizeof(RAWINPUTHEADER));
+        if (resultData != UINT(-1) && raw.header.dwType == RIM_TYPEMOUSE)
+        {
+            AddRawMouse(raw.data.mouse);
+        }
+    }
+
+    void AddRawMouse(const RAWMOUSE& mouse) noexcept
+    {
+        if (!mInFocus)
+            return;
+
+        auto queue = mEventQueue.load();
+
+        if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
+        {
+            mRawWheel += static_cast<short>(mouse.usButtonData);
+
+            if (queue)
+                queue->Push(InputEvent::MOUSE_WHEEL, 0, static_cast<short>(mouse.usButtonData));
+        }
+
+        if (!(mouse.usFlags & MOUSE_MOVE_ABSOLUTE))
+        {
+            mRawX += mouse.lLastX;
+            mRawY += mouse.lLastY;
+
+            if (queue && mMode == MODE_RELATIVE && (mouse.lLastX || mouse.lLastY))
+                queue->Push(InputEvent::MOUSE_DELTA, 0, mouse.lLastX, mouse.lLastY);
+        }
+        else if (mouse.usFlags & MOUSE_VIRTUAL_DESKTOP)
+        {
+            // This is used to make Remote Desktop sessons work
+            const int width = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+            const int height = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+
+            int x = static_cast<int>((float(mouse.lLastX) / 65535.0f) * width);
+            int y = static_cast<int>((float(mouse.lLastY) / 65535.0f) * height);
+
+            if (mRawLastX != INT32_MAX)
+            {
+                mRawX += x - mRawLastX;
+                mRawY += y - mRawLastY;
+
+                if (queue && mMode == MODE_RELATIVE)
+                    queue->Push(InputEvent::MOUSE_DELTA, 0, x - mRawLastX, y - mRawLastY);
+            }
+
+            mRawLastX = x;
+            mRawLastY = y;
+        }
+    }
+
+    void StartRawInputThread()
+    {
+        mRawThreadExit.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        mRawThreadReady.reset(CreateEventEx(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        if (!mRawThreadExit || !mRawThreadReady)
+        {
+            throw std::exception("CreateEventEx");
+        }
+
+        mRawThreadFailed = false;
+        mRawThread = std::thread([this]() noexcept { RawInputThreadMain(); });
+
+        (void)WaitForSingleObjectEx(mRawThreadReady.get(), INFINITE, FALSE);
+
+        if (mRawThreadFailed)
+        {
+            mRawThread.join();
+            mRawInputMode = RAW_INPUT_MESSAGES;
+
+            if (mWindow)
+            {
+                (void)RegisterRawInput(mWindow);
+            }
+
+            throw std::exception("RegisterRawInputDevices");
+        }
+    }
+
+    void StopRawInputThread() noexcept
+    {
+        if (!mRawThread.joinable())
+            return;
+
+        SetEvent(mRawThreadExit.get());
+        mRawThread.join();
+    }
+
+    // Owns a message-only window that the raw input is registered to, and sleeps until input arrives.
+    void RawInputThreadMain() noexcept
+    {
+        WNDCLASSEXW wcex = {};
+        wcex.cbSize = sizeof(WNDCLASSEXW);
+        wcex.lpfnWndProc = DefWindowProcW;
+        wcex.hInstance = GetModuleHandleW(nullptr);
+        wcex.lpszClassName = L"DirectXTKMouseRawInput";
+        (void)RegisterClassExW(&wcex);
+
+        HWND window = CreateWindowExW(0, wcex.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wcex.hInstance, nullptr);
+
+        mRawThreadFailed = !window || !RegisterRawInput(window);
+        SetEvent(mRawThreadReady.get());
+
+        if (!mRawThreadFailed)
+        {
+            HANDLE exitEvent = mRawThreadExit.get();
+
+            for (;;)
+            {
+                DWORD result = MsgWaitForMultipleObjectsEx(1, &exitEvent, INFINITE, QS_RAWINPUT, MWMO_INPUTAVAILABLE);
+                if (result != WAIT_OBJECT_0 + 1)
+                    break;
+
+                DrainRawInput();
+
+                MSG msg;
+                while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+                {
+                    if (msg.message == WM_INPUT)
+                    {
+                        AddRawInput(reinterpret_cast<HRAWINPUT>(msg.lParam));
+                    }
+
+                    DispatchMessageW(&msg);
+                }
+            }
+        }
+
+        if (window)
+        {
+            DestroyWindow(window);
+        }
+    }
+
     void ClipToWindow() noexcept
     {
         assert(mWindow != nullptr);
@@ -270,6 +562,19 @@ void Mouse::SetWindow(HWND window)
 }
 
 
+void Mouse::SetRawInputMode(RawInputMode mode)
+{
+    pImpl->SetRawInputMode(mode);
+}
+
+
+_Use_decl_annotations_
+void Mouse::SetEventQueue(InputEventQueue* queue) noexcept
+{
+    pImpl->mEventQueue = queue;
+}
+
+
 void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
 {
     auto pImpl = Impl::s_mouse;
@@ -318,6 +623,9 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
             pImpl->mRelativeX = INT32_MAX;
             pImpl->mRelativeY = INT32_MAX;
 
+            pImpl->mRawX = 0;
+            pImpl->mRawY = 0;
+
             ShowCursor(FALSE);
 
             pImpl->ClipToWindow();
@@ -328,6 +636,8 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
             throw std::exception("WaitForMultipleObjectsEx");
     }
 
+    const State previous = pImpl->mState;
+
     switch (message)
     {
         case WM_ACTIVATEAPP:
@@ -355,7 +665,13 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
             return;
 
         case WM_INPUT:
-            if (pImpl->mInFocus && pImpl->mMode == MODE_RELATIVE)
+            if (pImpl->mRawInputMode == RAW_INPUT_BUFFERED)
+            {
+                // This message's input is already off the queue, so read it first, then everything queued behind it.
+                pImpl->AddRawInput(reinterpret_cast<HRAWINPUT>(lParam));
+                pImpl->DrainRawInput();
+            }
+            else if (pImpl->mInFocus && pImpl->mMode == MODE_RELATIVE)
             {
                 RAWINPUT raw;
                 UINT rawSize = sizeof(raw);
@@ -373,6 +689,8 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
                         pImpl->mState.x = raw.data.mouse.lLastX;
                         pImpl->mState.y = raw.data.mouse.lLastY;
 
+                        pImpl->PushEvent(InputEvent::MOUSE_DELTA, 0, raw.data.mouse.lLastX, raw.data.mouse.lLastY);
+
                         ResetEvent(pImpl->mRelativeRead.get());
                     }
                     else if (raw.data.mouse.usFlags & MOUSE_VIRTUAL_DESKTOP)
@@ -392,6 +710,8 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
                         {
                             pImpl->mState.x = x - pImpl->mRelativeX;
                             pImpl->mState.y = y - pImpl->mRelativeY;
+
+                            pImpl->PushEvent(InputEvent::MOUSE_DELTA, 0, pImpl->mState.x, pImpl->mState.y);
                         }
 
                         pImpl->mRelativeX = x;
@@ -431,7 +751,13 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
             break;
 
         case WM_MOUSEWHEEL:
-            pImpl->mState.scrollWheelValue += GET_WHEEL_DELTA_WPARAM(wParam);
+            // Buffered raw input counts the wheel itself.
+            if (pImpl->mRawInputMode == RAW_INPUT_MESSAGES)
+            {
+                pImpl->mState.scrollWheelValue += GET_WHEEL_DELTA_WPARAM(wParam);
+
+                pImpl->PushEvent(InputEvent::MOUSE_WHEEL, 0, GET_WHEEL_DELTA_WPARAM(wParam));
+            }
             return;
 
         case WM_XBUTTONDOWN:
@@ -474,9 +800,19 @@ void Mouse::ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam)
         int xPos = static_cast<short>(LOWORD(lParam)); // GET_X_LPARAM(lParam);
         int yPos = static_cast<short>(HIWORD(lParam)); // GET_Y_LPARAM(lParam);
 
+        if (message == WM_MOUSEMOVE)
+        {
+            pImpl->PushEvent(InputEvent::MOUSE_MOVE, 0, xPos, yPos);
+        }
+
         pImpl->mState.x = pImpl->mLastX = xPos;
         pImpl->mState.y = pImpl->mLastY = yPos;
     }
+
+    if (pImpl->mEventQueue.load())
+    {
+        pImpl->PushButtonChanges(previous);
+    }
 }
 
 
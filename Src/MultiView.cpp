@@ -0,0 +1,230 @@
+//--------------------------------------------------------------------------------------
+// File: MultiView.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Effects.h"
+#include "ConstantBuffer.h"
+#include "DirectXHelpers.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    static_assert(MultiView::MaxViews == 4, "MaxViews mismatch");
+
+    // Constant buffer layout. Must match MultiView.fxh!
+    struct MultiViewConstants
+    {
+        XMMATRIX viewProjection[MultiView::MaxViews];
+        XMVECTOR clipPlanes[MultiView::MaxViews * 4];
+    };
+
+    static_assert((sizeof(MultiViewConstants) % 16) == 0, "CB size not padded correctly");
+}
+
+
+// Internal MultiView implementation class.
+class MultiView::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device);
+
+    void SetViews(_In_ ID3D11DeviceContext* deviceContext, size_t count,
+                  _In_reads_(count) const XMMATRIX* views,
+                  _In_reads_(count) const XMMATRIX* projections,
+                  _In_reads_(count) const D3D11_VIEWPORT* viewports,
+                  const D3D11_VIEWPORT& targetViewport);
+    void Apply(_In_ ID3D11DeviceContext* deviceContext) const;
+
+    size_t                                  viewCount;
+
+    XMFLOAT4X4                              views[MaxViews];
+    XMFLOAT4X4                              projections[MaxViews];
+
+private:
+    ConstantBuffer<MultiViewConstants>      mConstantBuffer;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    // Placement memory of the constants written by the last SetViews.
+    void*                                   mConstantMemory;
+#endif
+};
+
+
+// Constructor.
+MultiView::Impl::Impl(_In_ ID3D11Device* device)
+    : viewCount(0),
+    views{},
+    projections{},
+    mConstantBuffer(device)
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    , mConstantMemory(nullptr)
+#endif
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+    {
+        throw std::exception("MultiView requires Feature Level 10.0 or later");
+    }
+}
+
+
+// Each view's projection is followed by a scale and offset that maps the full clip space onto the view's rectangle
+// of the target viewport, and four planes drop whatever falls outside that rectangle.
+_Use_decl_annotations_
+void MultiView::Impl::SetViews(ID3D11DeviceContext* deviceContext, size_t count,
+                               const XMMATRIX* viewMatrices, const XMMATRIX* projectionMatrices, const D3D11_VIEWPORT* viewports,
+                               const D3D11_VIEWPORT& targetViewport)
+{
+    if (!count || count > MaxViews)
+        throw std::out_of_range("MultiView view count out of range");
+
+    if (!viewMatrices || !projectionMatrices || !viewports)
+        throw std::invalid_argument("views, projections, and viewports are required");
+
+    if (targetViewport.Width <= 0 || targetViewport.Height <= 0)
+        throw std::invalid_argument("Invalid target viewport");
+
+    MultiViewConstants constants = {};
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const& vp = viewports[i];
+
+        if (vp.Width <= 0 || vp.Height <= 0
+            || vp.TopLeftX < targetViewport.TopLeftX
+            || vp.TopLeftY < targetViewport.TopLeftY
+            || vp.TopLeftX + vp.Width > targetViewport.TopLeftX + targetViewport.Width
+            || vp.TopLeftY + vp.Height > targetViewport.TopLeftY + targetViewport.Height)
+        {
+            throw std::invalid_argument("MultiView viewports must lie within the target viewport");
+        }
+
+        // The view's rectangle in the target's normalized device coordinates.
+        float left = (vp.TopLeftX - targetViewport.TopLeftX) * 2.f / targetViewport.Width - 1.f;
+        float right = (vp.TopLeftX + vp.Width - targetViewport.TopLeftX) * 2.f / targetViewport.Width - 1.f;
+        float top = 1.f - (vp.TopLeftY - targetViewport.TopLeftY) * 2.f / targetViewport.Height;
+        float bottom = 1.f - (vp.TopLeftY + vp.Height - targetViewport.TopLeftY) * 2.f / targetViewport.Height;
+
+        XMMATRIX placement(
+            (right - left) * 0.5f, 0.f,                   0.f, 0.f,
+            0.f,                   (top - bottom) * 0.5f, 0.f, 0.f,
+            0.f,                   0.f,                   1.f, 0.f,
+            (right + left) * 0.5f, (top + bottom) * 0.5f, 0.f, 1.f);
+
+        XMMATRIX viewProjection = XMMatrixMultiply(XMMatrixMultiply(viewMatrices[i], projectionMatrices[i]), placement);
+
+        constants.viewProjection[i] = XMMatrixTranspose(viewProjection);
+
+        constants.clipPlanes[i * 4] = XMVectorSet(1.f, 0.f, 0.f, -left);
+        constants.clipPlanes[i * 4 + 1] = XMVectorSet(-1.f, 0.f, 0.f, right);
+        constants.clipPlanes[i * 4 + 2] = XMVectorSet(0.f, 1.f, 0.f, -bottom);
+        constants.clipPlanes[i * 4 + 3] = XMVectorSet(0.f, -1.f, 0.f, top);
+
+        XMStoreFloat4x4(&views[i], viewMatrices[i]);
+        XMStoreFloat4x4(&projections[i], projectionMatrices[i]);
+    }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    mConstantBuffer.SetData(deviceContext, constants, &mConstantMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+#endif
+
+    viewCount = count;
+}
+
+
+void MultiView::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+    if (!viewCount)
+        throw std::exception("MultiView::SetViews must be called before drawing");
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->VSSetPlacementConstantBuffer(3, mConstantBuffer.GetBuffer(), mConstantMemory);
+#else
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->VSSetConstantBuffers(3, 1, &buffer);
+#endif
+}
+
+
+//--------------------------------------------------------------------------------------
+// MultiView
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+MultiView::MultiView(_In_ ID3D11Device* device)
+  : pImpl(std::make_unique<Impl>(device))
+{
+}
+
+
+// Move constructor.
+MultiView::MultiView(MultiView&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+MultiView& MultiView::operator= (MultiView&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+MultiView::~MultiView()
+{
+}
+
+
+_Use_decl_annotations_
+void MultiView::SetViews(ID3D11DeviceContext* deviceContext, size_t count,
+                         const XMMATRIX* views, const XMMATRIX* projections, const D3D11_VIEWPORT* viewports,
+                         const D3D11_VIEWPORT& targetViewport)
+{
+    pImpl->SetViews(deviceContext, count, views, projections, viewports, targetViewport);
+}
+
+
+size_t MultiView::GetViewCount() const noexcept
+{
+    return pImpl->viewCount;
+}
+
+
+XMMATRIX MultiView::GetView(size_t index) const
+{
+    if (index >= pImpl->viewCount)
+        throw std::out_of_range("View index out of range");
+
+    return XMLoadFloat4x4(&pImpl->views[index]);
+}
+
+
+XMMATRIX MultiView::GetProjection(size_t index) const
+{
+    if (index >= pImpl->viewCount)
+        throw std::out_of_range("View index out of range");
+
+    return XMLoadFloat4x4(&pImpl->projections[index]);
+}
+
+
+void MultiView::Apply(_In_ ID3D11DeviceContext* deviceContext) const
+{
+    pImpl->Apply(deviceContext);
+}
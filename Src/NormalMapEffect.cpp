@@ -32,6 +32,10 @@ struct NormalMapEffectConstants
     XMMATRIX world;
     XMVECTOR worldInverseTranspose[3];
     XMMATRIX worldViewProj;
+
+    XMMATRIX prevWorldViewProj; // for velocity generation
+    float    targetWidth;
+    float    targetHeight;
 };
 
 static_assert((sizeof(NormalMapEffectConstants) % 16) == 0, "CB size not padded correctly");
@@ -42,9 +46,11 @@ struct NormalMapEffectTraits
 {
     using ConstantBufferType = NormalMapEffectConstants;
 
-    static const int VertexShaderCount = 4;
-    static const int PixelShaderCount = 4;
-    static const int ShaderPermutationCount = 16;
+    static const int VertexShaderCount = 16;
+    static const int PixelShaderCount = 11;
+    static const int ShaderPermutationCount = 136;
+
+    static const BuiltInEffect Effect = BuiltInEffect_NormalMap;
 };
 
 
@@ -59,6 +65,18 @@ public:
 
     bool vertexColorEnabled;
     bool biasedVertexNormals;
+    bool instancingEnabled;
+
+    EffectPass pass;
+
+    // World-view-projection as of the last velocity-only Apply.
+    XMMATRIX velocityWorldViewProj;
+    bool velocityHistory;
+
+    bool shaderModel5Supported;
+    ClusteredLights* clusteredLights;
+
+    CascadedShadowMap* shadowMap;
   
     EffectLights lights;
 
@@ -68,7 +86,8 @@ public:
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -78,10 +97,35 @@ namespace
     #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxBn.inc"
     #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxVcBn.inc"
 
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxInst.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxVcInst.inc"
+
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxInstBn.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSNormalPixelLightingTxVcInstBn.inc"
+
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSDepthOnlyTx.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSDepthOnlyTxVc.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSDepthOnlyTxInst.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSDepthOnlyTxVcInst.inc"
+
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSVelocityOnlyTx.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSVelocityOnlyTxVc.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSVelocityOnlyTxInst.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_VSVelocityOnlyTxVcInst.inc"
+
     #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTx.inc"
     #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoFog.inc"
     #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoSpec.inc"
     #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoFogSpec.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSVelocityOnly.inc"
+
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxClustered.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoSpecClustered.inc"
+
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxShadow.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoSpecShadow.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxClusteredShadow.inc"
+    #include "Shaders/Compiled/XboxOneNormalMapEffect_PSNormalPixelLightingTxNoSpecClusteredShadow.inc"
 #else    
     #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTx.inc"
     #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxVc.inc"
@@ -89,22 +133,64 @@ namespace
     #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxBn.inc"
     #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxVcBn.inc"
 
+    #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxInst.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxVcInst.inc"
+
+    #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxInstBn.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSNormalPixelLightingTxVcInstBn.inc"
+
+    #include "Shaders/Compiled/NormalMapEffect_VSDepthOnlyTx.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSDepthOnlyTxVc.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSDepthOnlyTxInst.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSDepthOnlyTxVcInst.inc"
+
+    #include "Shaders/Compiled/NormalMapEffect_VSVelocityOnlyTx.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSVelocityOnlyTxVc.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSVelocityOnlyTxInst.inc"
+    #include "Shaders/Compiled/NormalMapEffect_VSVelocityOnlyTxVcInst.inc"
+
     #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTx.inc"
     #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoFog.inc"
     #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoSpec.inc"
     #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoFogSpec.inc"
+    #include "Shaders/Compiled/NormalMapEffect_PSVelocityOnly.inc"
+
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxClustered.inc"
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoSpecClustered.inc"
+
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxShadow.inc"
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoSpecShadow.inc"
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxClusteredShadow.inc"
+    #include "Shaders/Compiled/NormalMapEffect_PSNormalPixelLightingTxNoSpecClusteredShadow.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<NormalMapEffectTraits>::VertexShaderBytecode[] =
 {    
-    { NormalMapEffect_VSNormalPixelLightingTx,     sizeof(NormalMapEffect_VSNormalPixelLightingTx)     },
-    { NormalMapEffect_VSNormalPixelLightingTxVc,   sizeof(NormalMapEffect_VSNormalPixelLightingTxVc)   },
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTx),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxVc),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxBn),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxVcBn),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxInst),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxVcInst),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxInstBn),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSNormalPixelLightingTxVcInstBn),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSDepthOnlyTx),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSDepthOnlyTxVc),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSDepthOnlyTxInst),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSDepthOnlyTxVcInst),
 
-    { NormalMapEffect_VSNormalPixelLightingTxBn,   sizeof(NormalMapEffect_VSNormalPixelLightingTxBn)   },
-    { NormalMapEffect_VSNormalPixelLightingTxVcBn, sizeof(NormalMapEffect_VSNormalPixelLightingTxVcBn) },
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSVelocityOnlyTx),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSVelocityOnlyTxVc),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSVelocityOnlyTxInst),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_VSVelocityOnlyTxVcInst),
 };
 
 
@@ -130,16 +216,175 @@ const int EffectBase<NormalMapEffectTraits>::VertexShaderIndices[] =
     2,      // pixel lighting (biased vertex normal) + texture, no fog or specular
     3,      // pixel lighting (biased vertex normal) + texture + vertex color, no specular
     3,      // pixel lighting (biased vertex normal) + texture + vertex color, no fog or specular
+
+    4,      // pixel lighting (instancing) + texture
+    4,      // pixel lighting (instancing) + texture, no fog
+    5,      // pixel lighting (instancing) + texture + vertex color
+    5,      // pixel lighting (instancing) + texture + vertex color, no fog
+
+    4,      // pixel lighting (instancing) + texture, no specular
+    4,      // pixel lighting (instancing) + texture, no fog or specular
+    5,      // pixel lighting (instancing) + texture + vertex color, no specular
+    5,      // pixel lighting (instancing) + texture + vertex color, no fog or specular
+
+    6,      // pixel lighting (instancing, biased vertex normal) + texture
+    6,      // pixel lighting (instancing, biased vertex normal) + texture, no fog
+    7,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color
+    7,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    6,      // pixel lighting (instancing, biased vertex normal) + texture, no specular
+    6,      // pixel lighting (instancing, biased vertex normal) + texture, no fog or specular
+    7,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no specular
+    7,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    8,      // depth only
+    9,      // depth only + vertex color
+    10,     // depth only (instancing)
+    11,     // depth only (instancing) + vertex color
+
+    12,     // velocity only
+    13,     // velocity only + vertex color
+    14,     // velocity only (instancing)
+    15,     // velocity only (instancing) + vertex color
+
+    0,      // clustered + texture
+    0,      // clustered + texture, no fog
+    1,      // clustered + texture + vertex color
+    1,      // clustered + texture + vertex color, no fog
+
+    0,      // clustered + texture, no specular
+    0,      // clustered + texture, no fog or specular
+    1,      // clustered + texture + vertex color, no specular
+    1,      // clustered + texture + vertex color, no fog or specular
+
+    2,      // clustered (biased vertex normal) + texture
+    2,      // clustered (biased vertex normal) + texture, no fog
+    3,      // clustered (biased vertex normal) + texture + vertex color
+    3,      // clustered (biased vertex normal) + texture + vertex color, no fog
+
+    2,      // clustered (biased vertex normal) + texture, no specular
+    2,      // clustered (biased vertex normal) + texture, no fog or specular
+    3,      // clustered (biased vertex normal) + texture + vertex color, no specular
+    3,      // clustered (biased vertex normal) + texture + vertex color, no fog or specular
+
+    4,      // clustered (instancing) + texture
+    4,      // clustered (instancing) + texture, no fog
+    5,      // clustered (instancing) + texture + vertex color
+    5,      // clustered (instancing) + texture + vertex color, no fog
+
+    4,      // clustered (instancing) + texture, no specular
+    4,      // clustered (instancing) + texture, no fog or specular
+    5,      // clustered (instancing) + texture + vertex color, no specular
+    5,      // clustered (instancing) + texture + vertex color, no fog or specular
+
+    6,      // clustered (instancing, biased vertex normal) + texture
+    6,      // clustered (instancing, biased vertex normal) + texture, no fog
+    7,      // clustered (instancing, biased vertex normal) + texture + vertex color
+    7,      // clustered (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    6,      // clustered (instancing, biased vertex normal) + texture, no specular
+    6,      // clustered (instancing, biased vertex normal) + texture, no fog or specular
+    7,      // clustered (instancing, biased vertex normal) + texture + vertex color, no specular
+    7,      // clustered (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    0,      // shadows + texture
+    0,      // shadows + texture, no fog
+    1,      // shadows + texture + vertex color
+    1,      // shadows + texture + vertex color, no fog
+
+    0,      // shadows + texture, no specular
+    0,      // shadows + texture, no fog or specular
+    1,      // shadows + texture + vertex color, no specular
+    1,      // shadows + texture + vertex color, no fog or specular
+
+    2,      // shadows (biased vertex normal) + texture
+    2,      // shadows (biased vertex normal) + texture, no fog
+    3,      // shadows (biased vertex normal) + texture + vertex color
+    3,      // shadows (biased vertex normal) + texture + vertex color, no fog
+
+    2,      // shadows (biased vertex normal) + texture, no specular
+    2,      // shadows (biased vertex normal) + texture, no fog or specular
+    3,      // shadows (biased vertex normal) + texture + vertex color, no specular
+    3,      // shadows (biased vertex normal) + texture + vertex color, no fog or specular
+
+    4,      // shadows (instancing) + texture
+    4,      // shadows (instancing) + texture, no fog
+    5,      // shadows (instancing) + texture + vertex color
+    5,      // shadows (instancing) + texture + vertex color, no fog
+
+    4,      // shadows (instancing) + texture, no specular
+    4,      // shadows (instancing) + texture, no fog or specular
+    5,      // shadows (instancing) + texture + vertex color, no specular
+    5,      // shadows (instancing) + texture + vertex color, no fog or specular
+
+    6,      // shadows (instancing, biased vertex normal) + texture
+    6,      // shadows (instancing, biased vertex normal) + texture, no fog
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    6,      // shadows (instancing, biased vertex normal) + texture, no specular
+    6,      // shadows (instancing, biased vertex normal) + texture, no fog or specular
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color, no specular
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    0,      // clustered + shadows + texture
+    0,      // clustered + shadows + texture, no fog
+    1,      // clustered + shadows + texture + vertex color
+    1,      // clustered + shadows + texture + vertex color, no fog
+
+    0,      // clustered + shadows + texture, no specular
+    0,      // clustered + shadows + texture, no fog or specular
+    1,      // clustered + shadows + texture + vertex color, no specular
+    1,      // clustered + shadows + texture + vertex color, no fog or specular
+
+    2,      // clustered + shadows (biased vertex normal) + texture
+    2,      // clustered + shadows (biased vertex normal) + texture, no fog
+    3,      // clustered + shadows (biased vertex normal) + texture + vertex color
+    3,      // clustered + shadows (biased vertex normal) + texture + vertex color, no fog
+
+    2,      // clustered + shadows (biased vertex normal) + texture, no specular
+    2,      // clustered + shadows (biased vertex normal) + texture, no fog or specular
+    3,      // clustered + shadows (biased vertex normal) + texture + vertex color, no specular
+    3,      // clustered + shadows (biased vertex normal) + texture + vertex color, no fog or specular
+
+    4,      // clustered + shadows (instancing) + texture
+    4,      // clustered + shadows (instancing) + texture, no fog
+    5,      // clustered + shadows (instancing) + texture + vertex color
+    5,      // clustered + shadows (instancing) + texture + vertex color, no fog
+
+    4,      // clustered + shadows (instancing) + texture, no specular
+    4,      // clustered + shadows (instancing) + texture, no fog or specular
+    5,      // clustered + shadows (instancing) + texture + vertex color, no specular
+    5,      // clustered + shadows (instancing) + texture + vertex color, no fog or specular
+
+    6,      // clustered + shadows (instancing, biased vertex normal) + texture
+    6,      // clustered + shadows (instancing, biased vertex normal) + texture, no fog
+    7,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color
+    7,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    6,      // clustered + shadows (instancing, biased vertex normal) + texture, no specular
+    6,      // clustered + shadows (instancing, biased vertex normal) + texture, no fog or specular
+    7,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no specular
+    7,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no fog or specular
 };
 
 
 template<>
 const ShaderBytecode EffectBase<NormalMapEffectTraits>::PixelShaderBytecode[] =
 {
-    { NormalMapEffect_PSNormalPixelLightingTx,          sizeof(NormalMapEffect_PSNormalPixelLightingTx)          },
-    { NormalMapEffect_PSNormalPixelLightingTxNoFog,     sizeof(NormalMapEffect_PSNormalPixelLightingTxNoFog)     },
-    { NormalMapEffect_PSNormalPixelLightingTxNoSpec,    sizeof(NormalMapEffect_PSNormalPixelLightingTxNoSpec)    },
-    { NormalMapEffect_PSNormalPixelLightingTxNoFogSpec, sizeof(NormalMapEffect_PSNormalPixelLightingTxNoFogSpec) },
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTx),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoFog),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoSpec),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoFogSpec),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSVelocityOnly),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxClustered),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoSpecClustered),
+
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxShadow),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoSpecShadow),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxClusteredShadow),
+    EFFECT_SHADER_BYTECODE(NormalMapEffect_PSNormalPixelLightingTxNoSpecClusteredShadow),
 };
 
 
@@ -165,6 +410,156 @@ const int EffectBase<NormalMapEffectTraits>::PixelShaderIndices[] =
     3,      // pixel lighting (biased vertex normal) + texture, no fog or specular
     2,      // pixel lighting (biased vertex normal) + texture + vertex color, no specular
     3,      // pixel lighting (biased vertex normal) + texture + vertex color, no fog or specular
+
+    0,      // pixel lighting (instancing) + texture
+    1,      // pixel lighting (instancing) + texture, no fog
+    0,      // pixel lighting (instancing) + texture + vertex color
+    1,      // pixel lighting (instancing) + texture + vertex color, no fog
+
+    2,      // pixel lighting (instancing) + texture, no specular
+    3,      // pixel lighting (instancing) + texture, no fog or specular
+    2,      // pixel lighting (instancing) + texture + vertex color, no specular
+    3,      // pixel lighting (instancing) + texture + vertex color, no fog or specular
+
+    0,      // pixel lighting (instancing, biased vertex normal) + texture
+    1,      // pixel lighting (instancing, biased vertex normal) + texture, no fog
+    0,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color
+    1,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    2,      // pixel lighting (instancing, biased vertex normal) + texture, no specular
+    3,      // pixel lighting (instancing, biased vertex normal) + texture, no fog or specular
+    2,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no specular
+    3,      // pixel lighting (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    -1,     // depth only
+    -1,     // depth only + vertex color
+    -1,     // depth only (instancing)
+    -1,     // depth only (instancing) + vertex color
+
+    4,      // velocity only
+    4,      // velocity only + vertex color
+    4,      // velocity only (instancing)
+    4,      // velocity only (instancing) + vertex color
+
+    5,      // clustered + texture
+    5,      // clustered + texture, no fog
+    5,      // clustered + texture + vertex color
+    5,      // clustered + texture + vertex color, no fog
+
+    6,      // clustered + texture, no specular
+    6,      // clustered + texture, no fog or specular
+    6,      // clustered + texture + vertex color, no specular
+    6,      // clustered + texture + vertex color, no fog or specular
+
+    5,      // clustered (biased vertex normal) + texture
+    5,      // clustered (biased vertex normal) + texture, no fog
+    5,      // clustered (biased vertex normal) + texture + vertex color
+    5,      // clustered (biased vertex normal) + texture + vertex color, no fog
+
+    6,      // clustered (biased vertex normal) + texture, no specular
+    6,      // clustered (biased vertex normal) + texture, no fog or specular
+    6,      // clustered (biased vertex normal) + texture + vertex color, no specular
+    6,      // clustered (biased vertex normal) + texture + vertex color, no fog or specular
+
+    5,      // clustered (instancing) + texture
+    5,      // clustered (instancing) + texture, no fog
+    5,      // clustered (instancing) + texture + vertex color
+    5,      // clustered (instancing) + texture + vertex color, no fog
+
+    6,      // clustered (instancing) + texture, no specular
+    6,      // clustered (instancing) + texture, no fog or specular
+    6,      // clustered (instancing) + texture + vertex color, no specular
+    6,      // clustered (instancing) + texture + vertex color, no fog or specular
+
+    5,      // clustered (instancing, biased vertex normal) + texture
+    5,      // clustered (instancing, biased vertex normal) + texture, no fog
+    5,      // clustered (instancing, biased vertex normal) + texture + vertex color
+    5,      // clustered (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    6,      // clustered (instancing, biased vertex normal) + texture, no specular
+    6,      // clustered (instancing, biased vertex normal) + texture, no fog or specular
+    6,      // clustered (instancing, biased vertex normal) + texture + vertex color, no specular
+    6,      // clustered (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    7,      // shadows + texture
+    7,      // shadows + texture, no fog
+    7,      // shadows + texture + vertex color
+    7,      // shadows + texture + vertex color, no fog
+
+    8,      // shadows + texture, no specular
+    8,      // shadows + texture, no fog or specular
+    8,      // shadows + texture + vertex color, no specular
+    8,      // shadows + texture + vertex color, no fog or specular
+
+    7,      // shadows (biased vertex normal) + texture
+    7,      // shadows (biased vertex normal) + texture, no fog
+    7,      // shadows (biased vertex normal) + texture + vertex color
+    7,      // shadows (biased vertex normal) + texture + vertex color, no fog
+
+    8,      // shadows (biased vertex normal) + texture, no specular
+    8,      // shadows (biased vertex normal) + texture, no fog or specular
+    8,      // shadows (biased vertex normal) + texture + vertex color, no specular
+    8,      // shadows (biased vertex normal) + texture + vertex color, no fog or specular
+
+    7,      // shadows (instancing) + texture
+    7,      // shadows (instancing) + texture, no fog
+    7,      // shadows (instancing) + texture + vertex color
+    7,      // shadows (instancing) + texture + vertex color, no fog
+
+    8,      // shadows (instancing) + texture, no specular
+    8,      // shadows (instancing) + texture, no fog or specular
+    8,      // shadows (instancing) + texture + vertex color, no specular
+    8,      // shadows (instancing) + texture + vertex color, no fog or specular
+
+    7,      // shadows (instancing, biased vertex normal) + texture
+    7,      // shadows (instancing, biased vertex normal) + texture, no fog
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color
+    7,      // shadows (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    8,      // shadows (instancing, biased vertex normal) + texture, no specular
+    8,      // shadows (instancing, biased vertex normal) + texture, no fog or specular
+    8,      // shadows (instancing, biased vertex normal) + texture + vertex color, no specular
+    8,      // shadows (instancing, biased vertex normal) + texture + vertex color, no fog or specular
+
+    9,      // clustered + shadows + texture
+    9,      // clustered + shadows + texture, no fog
+    9,      // clustered + shadows + texture + vertex color
+    9,      // clustered + shadows + texture + vertex color, no fog
+
+    10,     // clustered + shadows + texture, no specular
+    10,     // clustered + shadows + texture, no fog or specular
+    10,     // clustered + shadows + texture + vertex color, no specular
+    10,     // clustered + shadows + texture + vertex color, no fog or specular
+
+    9,      // clustered + shadows (biased vertex normal) + texture
+    9,      // clustered + shadows (biased vertex normal) + texture, no fog
+    9,      // clustered + shadows (biased vertex normal) + texture + vertex color
+    9,      // clustered + shadows (biased vertex normal) + texture + vertex color, no fog
+
+    10,     // clustered + shadows (biased vertex normal) + texture, no specular
+    10,     // clustered + shadows (biased vertex normal) + texture, no fog or specular
+    10,     // clustered + shadows (biased vertex normal) + texture + vertex color, no specular
+    10,     // clustered + shadows (biased vertex normal) + texture + vertex color, no fog or specular
+
+    9,      // clustered + shadows (instancing) + texture
+    9,      // clustered + shadows (instancing) + texture, no fog
+    9,      // clustered + shadows (instancing) + texture + vertex color
+    9,      // clustered + shadows (instancing) + texture + vertex color, no fog
+
+    10,     // clustered + shadows (instancing) + texture, no specular
+    10,     // clustered + shadows (instancing) + texture, no fog or specular
+    10,     // clustered + shadows (instancing) + texture + vertex color, no specular
+    10,     // clustered + shadows (instancing) + texture + vertex color, no fog or specular
+
+    9,      // clustered + shadows (instancing, biased vertex normal) + texture
+    9,      // clustered + shadows (instancing, biased vertex normal) + texture, no fog
+    9,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color
+    9,      // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no fog
+
+    10,     // clustered + shadows (instancing, biased vertex normal) + texture, no specular
+    10,     // clustered + shadows (instancing, biased vertex normal) + texture, no fog or specular
+    10,     // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no specular
+    10,     // clustered + shadows (instancing, biased vertex normal) + texture + vertex color, no fog or specular
 };
 
 
@@ -173,11 +568,26 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<NormalMapEffectTraits>::DeviceResources> EffectBase<NormalMapEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllNormalMapEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<NormalMapEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 NormalMapEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
     vertexColorEnabled(false),
-    biasedVertexNormals(false)
+    biasedVertexNormals(false),
+    instancingEnabled(false),
+    pass(EffectPass_Default),
+    velocityWorldViewProj(XMMatrixIdentity()),
+    velocityHistory(false),
+    shaderModel5Supported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0),
+    clusteredLights(nullptr),
+    shadowMap(nullptr)
 {
     if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
     {
@@ -195,6 +605,24 @@ NormalMapEffect::Impl::Impl(_In_ ID3D11Device* device)
 
 int NormalMapEffect::Impl::GetCurrentShaderPermutation() const noexcept
 {
+    // Reduced passes only vary by vertex input.
+    if (pass != EffectPass_Default)
+    {
+        int permutation = (pass == EffectPass_VelocityOnly) ? 36 : 32;
+
+        if (vertexColorEnabled)
+        {
+            permutation += 1;
+        }
+
+        if (instancingEnabled)
+        {
+            permutation += 2;
+        }
+
+        return permutation;
+    }
+
     int permutation = 0;
 
     // Use optimized shaders if fog is disabled.
@@ -221,6 +649,23 @@ int NormalMapEffect::Impl::GetCurrentShaderPermutation() const noexcept
         permutation += 8;
     }
 
+    if (instancingEnabled)
+    {
+        // Vertex shader reads the per-instance transform.
+        permutation += 16;
+    }
+
+    if (shadowMap)
+    {
+        // Pixel shader attenuates light 0 by the shadow map, with or without the clustered lights, and always applies fog.
+        permutation += clusteredLights ? 104 : 72;
+    }
+    else if (clusteredLights)
+    {
+        // Pixel shader adds the clustered lights, and always applies fog.
+        permutation += 40;
+    }
+
     return permutation;
 }
 
@@ -231,6 +676,23 @@ void NormalMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
+    if (pass != EffectPass_Default)
+    {
+        if (pass == EffectPass_VelocityOnly)
+        {
+            constants.prevWorldViewProj = velocityHistory ? velocityWorldViewProj : constants.worldViewProj;
+
+            velocityWorldViewProj = constants.worldViewProj;
+            velocityHistory = true;
+
+            dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+        }
+
+        // Fog, lighting, and textures are left dirty for the next full Apply.
+        ApplyShaders(deviceContext, GetCurrentShaderPermutation());
+        return;
+    }
+
     fog.SetConstants(dirtyFlags, matrices.worldView, constants.fogVector);
             
     lights.SetConstants(dirtyFlags, matrices, constants.world, constants.worldInverseTranspose, constants.eyePosition, constants.diffuseColor, constants.emissiveColor, true);
@@ -238,6 +700,16 @@ void NormalMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     // Set the textures
     ID3D11ShaderResourceView* textures[] = { texture.Get(), specularTexture.Get(), normalTexture.Get()};
     deviceContext->PSSetShaderResources(0, _countof(textures), textures);
+
+    if (clusteredLights)
+    {
+        clusteredLights->Apply(deviceContext);
+    }
+
+    if (shadowMap)
+    {
+        shadowMap->Apply(deviceContext);
+    }
     
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
@@ -275,6 +747,8 @@ NormalMapEffect::~NormalMapEffect()
 // IEffect methods.
 void NormalMapEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"NormalMapEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -505,3 +979,58 @@ void NormalMapEffect::SetBiasedVertexNormals(bool value)
 {
     pImpl->biasedVertexNormals = value;
 }
+
+
+// Instancing settings.
+void NormalMapEffect::SetInstancingEnabled(bool value)
+{
+    pImpl->instancingEnabled = value;
+}
+
+
+// Clustered light settings.
+void NormalMapEffect::SetClusteredLights(_In_opt_ ClusteredLights* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("NormalMapEffect clustered lights require Feature Level 11.0 or later");
+    }
+
+    pImpl->clusteredLights = value;
+}
+
+
+void NormalMapEffect::SetShadowMap(_In_opt_ CascadedShadowMap* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("NormalMapEffect shadows require Feature Level 11.0 or later");
+    }
+
+    pImpl->shadowMap = value;
+}
+
+
+// Pass settings.
+void NormalMapEffect::SetPass(EffectPass pass)
+{
+    if (pass > EffectPass_VelocityOnly)
+        throw std::invalid_argument("Invalid effect pass");
+
+    pImpl->pass = pass;
+}
+
+
+EffectPass NormalMapEffect::GetPass() const noexcept
+{
+    return pImpl->pass;
+}
+
+
+void NormalMapEffect::SetRenderTargetSizeInPixels(int width, int height)
+{
+    pImpl->constants.targetWidth = static_cast<float>(width);
+    pImpl->constants.targetHeight = static_cast<float>(height);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+}
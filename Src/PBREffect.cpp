@@ -44,9 +44,11 @@ struct PBREffectTraits
 {
     using ConstantBufferType = PBREffectConstants;
 
-    static const int VertexShaderCount = 4;
-    static const int PixelShaderCount = 5;
-    static const int ShaderPermutationCount = 10;
+    static const int VertexShaderCount = 12;
+    static const int PixelShaderCount = 15;
+    static const int ShaderPermutationCount = 60;
+
+    static const BuiltInEffect Effect = BuiltInEffect_PBR;
     static const int RootSignatureCount = 1;
 };
 
@@ -67,16 +69,28 @@ public:
 
     bool biasedVertexNormals;
     bool velocityEnabled;
+    bool instancingEnabled;
+
+    EffectPass pass;
+
+    bool shaderModel5Supported;
+    ClusteredLights* clusteredLights;
+    CascadedShadowMap* shadowMap;
 
     XMVECTOR lightColor[MaxDirectionalLights];
 
+    // World-view-projection as of the last Apply that wrote velocity.
+    XMMATRIX velocityWorldViewProj;
+    bool velocityHistory;
+
     int GetCurrentShaderPermutation() const noexcept;
 
     void Apply(_In_ ID3D11DeviceContext* deviceContext);
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -85,33 +99,88 @@ namespace
     #include "Shaders/Compiled/XboxOnePBREffect_VSConstantBn.inc"
     #include "Shaders/Compiled/XboxOnePBREffect_VSConstantVelocityBn.inc"
 
+    #include "Shaders/Compiled/XboxOnePBREffect_VSConstantInst.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_VSConstantVelocityInst.inc"
+
+    #include "Shaders/Compiled/XboxOnePBREffect_VSConstantInstBn.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_VSConstantVelocityInstBn.inc"
+
+    #include "Shaders/Compiled/XboxOnePBREffect_VSDepthOnly.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_VSVelocityOnly.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_VSDepthOnlyInst.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_VSVelocityOnlyInst.inc"
+
     #include "Shaders/Compiled/XboxOnePBREffect_PSConstant.inc"
     #include "Shaders/Compiled/XboxOnePBREffect_PSTextured.inc"
     #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedEmissive.inc"
     #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedVelocity.inc"
     #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedEmissiveVelocity.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSVelocityOnly.inc"
+
+    #include "Shaders/Compiled/XboxOnePBREffect_PSConstantClustered.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedClustered.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedEmissiveClustered.inc"
+
+    #include "Shaders/Compiled/XboxOnePBREffect_PSConstantShadow.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedShadow.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedEmissiveShadow.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSConstantClusteredShadow.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedClusteredShadow.inc"
+    #include "Shaders/Compiled/XboxOnePBREffect_PSTexturedEmissiveClusteredShadow.inc"
 #else    
     #include "Shaders/Compiled/PBREffect_VSConstant.inc"
     #include "Shaders/Compiled/PBREffect_VSConstantVelocity.inc"
     #include "Shaders/Compiled/PBREffect_VSConstantBn.inc"
     #include "Shaders/Compiled/PBREffect_VSConstantVelocityBn.inc"
 
+    #include "Shaders/Compiled/PBREffect_VSConstantInst.inc"
+    #include "Shaders/Compiled/PBREffect_VSConstantVelocityInst.inc"
+
+    #include "Shaders/Compiled/PBREffect_VSConstantInstBn.inc"
+    #include "Shaders/Compiled/PBREffect_VSConstantVelocityInstBn.inc"
+
+    #include "Shaders/Compiled/PBREffect_VSDepthOnly.inc"
+    #include "Shaders/Compiled/PBREffect_VSVelocityOnly.inc"
+    #include "Shaders/Compiled/PBREffect_VSDepthOnlyInst.inc"
+    #include "Shaders/Compiled/PBREffect_VSVelocityOnlyInst.inc"
+
     #include "Shaders/Compiled/PBREffect_PSConstant.inc"
     #include "Shaders/Compiled/PBREffect_PSTextured.inc"
     #include "Shaders/Compiled/PBREffect_PSTexturedEmissive.inc"
     #include "Shaders/Compiled/PBREffect_PSTexturedVelocity.inc"
     #include "Shaders/Compiled/PBREffect_PSTexturedEmissiveVelocity.inc"
+    #include "Shaders/Compiled/PBREffect_PSVelocityOnly.inc"
+
+    #include "Shaders/Compiled/PBREffect_PSConstantClustered.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedClustered.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedEmissiveClustered.inc"
+
+    #include "Shaders/Compiled/PBREffect_PSConstantShadow.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedShadow.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedEmissiveShadow.inc"
+    #include "Shaders/Compiled/PBREffect_PSConstantClusteredShadow.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedClusteredShadow.inc"
+    #include "Shaders/Compiled/PBREffect_PSTexturedEmissiveClusteredShadow.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<PBREffectTraits>::VertexShaderBytecode[] =
 {
-    { PBREffect_VSConstant, sizeof(PBREffect_VSConstant) },
-    { PBREffect_VSConstantVelocity, sizeof(PBREffect_VSConstantVelocity) },
-    { PBREffect_VSConstantBn, sizeof(PBREffect_VSConstantBn) },
-    { PBREffect_VSConstantVelocityBn, sizeof(PBREffect_VSConstantVelocityBn) },
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstant),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantVelocity),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantBn),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantVelocityBn),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantInst),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantVelocityInst),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantInstBn),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSConstantVelocityInstBn),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSDepthOnly),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSVelocityOnly),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSDepthOnlyInst),
+    EFFECT_SHADER_BYTECODE(PBREffect_VSVelocityOnlyInst),
 };
 
 
@@ -129,17 +198,92 @@ const int EffectBase<PBREffectTraits>::VertexShaderIndices[] =
     2,      // textured + emissive (biased vertex normals)
     3,      // textured + velocity (biased vertex normals)
     3,      // textured + emissive + velocity (biasoed vertex normals)
+
+    4,      // constant (instancing)
+    4,      // textured (instancing)
+    4,      // textured + emissive (instancing)
+    5,      // textured + velocity (instancing)
+    5,      // textured + emissive + velocity (instancing)
+
+    6,      // constant (instancing, biased vertex normals)
+    6,      // textured (instancing, biased vertex normals)
+    6,      // textured + emissive (instancing, biased vertex normals)
+    7,      // textured + velocity (instancing, biased vertex normals)
+    7,      // textured + emissive + velocity (instancing, biased vertex normals)
+
+    8,      // depth only
+    10,     // depth only (instancing)
+    9,      // velocity only
+    11,     // velocity only (instancing)
+
+    0,      // constant + clustered
+    0,      // textured + clustered
+    0,      // textured + emissive + clustered
+
+    2,      // constant + clustered (biased vertex normals)
+    2,      // textured + clustered (biased vertex normals)
+    2,      // textured + emissive + clustered (biased vertex normals)
+
+    4,      // constant + clustered (instancing)
+    4,      // textured + clustered (instancing)
+    4,      // textured + emissive + clustered (instancing)
+
+    6,      // constant + clustered (instancing, biased vertex normals)
+    6,      // textured + clustered (instancing, biased vertex normals)
+    6,      // textured + emissive + clustered (instancing, biased vertex normals)
+
+    0,      // constant + shadows
+    0,      // textured + shadows
+    0,      // textured + emissive + shadows
+
+    2,      // constant + shadows (biased vertex normals)
+    2,      // textured + shadows (biased vertex normals)
+    2,      // textured + emissive + shadows (biased vertex normals)
+
+    4,      // constant + shadows (instancing)
+    4,      // textured + shadows (instancing)
+    4,      // textured + emissive + shadows (instancing)
+
+    6,      // constant + shadows (instancing, biased vertex normals)
+    6,      // textured + shadows (instancing, biased vertex normals)
+    6,      // textured + emissive + shadows (instancing, biased vertex normals)
+
+    0,      // constant + clustered + shadows
+    0,      // textured + clustered + shadows
+    0,      // textured + emissive + clustered + shadows
+
+    2,      // constant + clustered + shadows (biased vertex normals)
+    2,      // textured + clustered + shadows (biased vertex normals)
+    2,      // textured + emissive + clustered + shadows (biased vertex normals)
+
+    4,      // constant + clustered + shadows (instancing)
+    4,      // textured + clustered + shadows (instancing)
+    4,      // textured + emissive + clustered + shadows (instancing)
+
+    6,      // constant + clustered + shadows (instancing, biased vertex normals)
+    6,      // textured + clustered + shadows (instancing, biased vertex normals)
+    6,      // textured + emissive + clustered + shadows (instancing, biased vertex normals)
 };
 
 
 template<>
 const ShaderBytecode EffectBase<PBREffectTraits>::PixelShaderBytecode[] =
 {
-    { PBREffect_PSConstant, sizeof(PBREffect_PSConstant) },
-    { PBREffect_PSTextured, sizeof(PBREffect_PSTextured) },
-    { PBREffect_PSTexturedEmissive, sizeof(PBREffect_PSTexturedEmissive) },
-    { PBREffect_PSTexturedVelocity, sizeof(PBREffect_PSTexturedVelocity) },
-    { PBREffect_PSTexturedEmissiveVelocity, sizeof(PBREffect_PSTexturedEmissiveVelocity) }
+    EFFECT_SHADER_BYTECODE(PBREffect_PSConstant),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTextured),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedEmissive),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedVelocity),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedEmissiveVelocity),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSVelocityOnly),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSConstantClustered),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedClustered),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedEmissiveClustered),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSConstantShadow),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedShadow),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedEmissiveShadow),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSConstantClusteredShadow),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedClusteredShadow),
+    EFFECT_SHADER_BYTECODE(PBREffect_PSTexturedEmissiveClusteredShadow),
 };
 
 
@@ -157,18 +301,98 @@ const int EffectBase<PBREffectTraits>::PixelShaderIndices[] =
     2,      // textured + emissive (biased vertex normals)
     3,      // textured + velocity (biased vertex normals)
     4,      // textured + emissive + velocity (biased vertex normals)
+
+    0,      // constant (instancing)
+    1,      // textured (instancing)
+    2,      // textured + emissive (instancing)
+    3,      // textured + velocity (instancing)
+    4,      // textured + emissive + velocity (instancing)
+
+    0,      // constant (instancing, biased vertex normals)
+    1,      // textured (instancing, biased vertex normals)
+    2,      // textured + emissive (instancing, biased vertex normals)
+    3,      // textured + velocity (instancing, biased vertex normals)
+    4,      // textured + emissive + velocity (instancing, biased vertex normals)
+
+    -1,     // depth only
+    -1,     // depth only (instancing)
+    5,      // velocity only
+    5,      // velocity only (instancing)
+
+    6,      // constant + clustered
+    7,      // textured + clustered
+    8,      // textured + emissive + clustered
+
+    6,      // constant + clustered (biased vertex normals)
+    7,      // textured + clustered (biased vertex normals)
+    8,      // textured + emissive + clustered (biased vertex normals)
+
+    6,      // constant + clustered (instancing)
+    7,      // textured + clustered (instancing)
+    8,      // textured + emissive + clustered (instancing)
+
+    6,      // constant + clustered (instancing, biased vertex normals)
+    7,      // textured + clustered (instancing, biased vertex normals)
+    8,      // textured + emissive + clustered (instancing, biased vertex normals)
+
+    9,      // constant + shadows
+    10,     // textured + shadows
+    11,     // textured + emissive + shadows
+
+    9,      // constant + shadows (biased vertex normals)
+    10,     // textured + shadows (biased vertex normals)
+    11,     // textured + emissive + shadows (biased vertex normals)
+
+    9,      // constant + shadows (instancing)
+    10,     // textured + shadows (instancing)
+    11,     // textured + emissive + shadows (instancing)
+
+    9,      // constant + shadows (instancing, biased vertex normals)
+    10,     // textured + shadows (instancing, biased vertex normals)
+    11,     // textured + emissive + shadows (instancing, biased vertex normals)
+
+    12,     // constant + clustered + shadows
+    13,     // textured + clustered + shadows
+    14,     // textured + emissive + clustered + shadows
+
+    12,     // constant + clustered + shadows (biased vertex normals)
+    13,     // textured + clustered + shadows (biased vertex normals)
+    14,     // textured + emissive + clustered + shadows (biased vertex normals)
+
+    12,     // constant + clustered + shadows (instancing)
+    13,     // textured + clustered + shadows (instancing)
+    14,     // textured + emissive + clustered + shadows (instancing)
+
+    12,     // constant + clustered + shadows (instancing, biased vertex normals)
+    13,     // textured + clustered + shadows (instancing, biased vertex normals)
+    14,     // textured + emissive + clustered + shadows (instancing, biased vertex normals)
 };
 
 // Global pool of per-device PBREffect resources. Required by EffectBase<>, but not used.
 template<>
 SharedResourcePool<ID3D11Device*, EffectBase<PBREffectTraits>::DeviceResources> EffectBase<PBREffectTraits>::deviceResourcesPool = {};
 
+
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllPBREffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<PBREffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
 // Constructor.
 PBREffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
     biasedVertexNormals(false),
     velocityEnabled(false),
-    lightColor{}
+    instancingEnabled(false),
+    pass(EffectPass_Default),
+    shaderModel5Supported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0),
+    clusteredLights(nullptr),
+    shadowMap(nullptr),
+    lightColor{},
+    velocityWorldViewProj(XMMatrixIdentity()),
+    velocityHistory(false)
 {
     if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
     {
@@ -199,6 +423,42 @@ PBREffect::Impl::Impl(_In_ ID3D11Device* device)
 
 int PBREffect::Impl::GetCurrentShaderPermutation() const noexcept
 {
+    // Reduced passes ignore the material; only instancing changes the vertex shader.
+    if (pass != EffectPass_Default)
+    {
+        int permutation = (pass == EffectPass_VelocityOnly) ? 22 : 20;
+
+        if (instancingEnabled)
+        {
+            permutation += 1;
+        }
+
+        return permutation;
+    }
+
+    // Clustered lights and shadows have their own blocks, without the velocity shaders.
+    if ((clusteredLights || shadowMap) && !velocityEnabled)
+    {
+        int permutation = shadowMap ? (clusteredLights ? 48 : 36) : 24;
+
+        if (albedoTexture)
+        {
+            permutation += emissiveTexture ? 2 : 1;
+        }
+
+        if (biasedVertexNormals)
+        {
+            permutation += 3;
+        }
+
+        if (instancingEnabled)
+        {
+            permutation += 6;
+        }
+
+        return permutation;
+    }
+
     int permutation = 0;
 
     // Textured RMA vs. constant albedo/roughness/metalness?
@@ -224,6 +484,12 @@ int PBREffect::Impl::GetCurrentShaderPermutation() const noexcept
         permutation += 5;
     }
 
+    if (instancingEnabled)
+    {
+        // Vertex shader reads the per-instance transform.
+        permutation += 10;
+    }
+
     return permutation;
 }
 
@@ -231,11 +497,26 @@ int PBREffect::Impl::GetCurrentShaderPermutation() const noexcept
 // Sets our state onto the D3D device.
 void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
-    // Store old wvp for velocity calculation in shader
-    constants.prevWorldViewProj = constants.worldViewProj;
-
     // Compute derived parameter values.
-    matrices.SetConstants(dirtyFlags, constants.worldViewProj);        
+    matrices.SetConstants(dirtyFlags, constants.worldViewProj);
+
+    // The previous wvp only moves on when velocity is written, so a depth pass
+    // or a second pass in the same frame doesn't zero the velocity.
+    if (pass == EffectPass_VelocityOnly || (pass == EffectPass_Default && velocityEnabled))
+    {
+        constants.prevWorldViewProj = velocityHistory ? velocityWorldViewProj : constants.worldViewProj;
+
+        velocityWorldViewProj = constants.worldViewProj;
+        velocityHistory = true;
+
+        dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+    }
+
+    if (pass != EffectPass_Default)
+    {
+        ApplyShaders(deviceContext, GetCurrentShaderPermutation());
+        return;
+    }
 
     // World inverse transpose matrix.
     if (dirtyFlags & EffectDirtyFlags::WorldInverseTranspose)
@@ -281,6 +562,16 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         deviceContext->PSSetShaderResources(0, _countof(textures), textures);
     }
 
+    if (clusteredLights && !velocityEnabled)
+    {
+        clusteredLights->Apply(deviceContext);
+    }
+
+    if (shadowMap && !velocityEnabled)
+    {
+        shadowMap->Apply(deviceContext);
+    }
+
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
 }
@@ -316,6 +607,8 @@ PBREffect::~PBREffect()
 // IEffect methods.
 void PBREffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"PBREffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -516,6 +809,52 @@ void PBREffect::SetBiasedVertexNormals(bool value)
 }
 
 
+// Instancing settings.
+void PBREffect::SetInstancingEnabled(bool value)
+{
+    pImpl->instancingEnabled = value;
+}
+
+
+// Clustered light settings.
+void PBREffect::SetClusteredLights(_In_opt_ ClusteredLights* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("PBREffect clustered lights require Feature Level 11.0 or later");
+    }
+
+    pImpl->clusteredLights = value;
+}
+
+
+void PBREffect::SetShadowMap(_In_opt_ CascadedShadowMap* value)
+{
+    if (value && !pImpl->shaderModel5Supported)
+    {
+        throw std::exception("PBREffect shadows require Feature Level 11.0 or later");
+    }
+
+    pImpl->shadowMap = value;
+}
+
+
+// Pass settings.
+void PBREffect::SetPass(EffectPass pass)
+{
+    if (pass > EffectPass_VelocityOnly)
+        throw std::invalid_argument("Invalid effect pass");
+
+    pImpl->pass = pass;
+}
+
+
+EffectPass PBREffect::GetPass() const noexcept
+{
+    return pImpl->pass;
+}
+
+
 // Additional settings.
 void PBREffect::SetVelocityGeneration(bool value)
 {
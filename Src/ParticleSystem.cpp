@@ -0,0 +1,714 @@
+//--------------------------------------------------------------------------------------
+// File: ParticleSystem.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ParticleSystem.h"
+
+#include "AlignedNew.h"
+#include "ConstantBuffer.h"
+#include "DemandCreate.h"
+#include "DirectXHelpers.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneParticleSystem_CSInitDeadList.inc"
+    #include "Shaders/Compiled/XboxOneParticleSystem_CSEmit.inc"
+    #include "Shaders/Compiled/XboxOneParticleSystem_CSPrepareSimulate.inc"
+    #include "Shaders/Compiled/XboxOneParticleSystem_CSSimulate.inc"
+    #include "Shaders/Compiled/XboxOneParticleSystem_VSParticle.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpritePixelShader.inc"
+#else
+    #include "Shaders/Compiled/ParticleSystem_CSInitDeadList.inc"
+    #include "Shaders/Compiled/ParticleSystem_CSEmit.inc"
+    #include "Shaders/Compiled/ParticleSystem_CSPrepareSimulate.inc"
+    #include "Shaders/Compiled/ParticleSystem_CSSimulate.inc"
+    #include "Shaders/Compiled/ParticleSystem_VSParticle.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpritePixelShader.inc"
+#endif
+
+    // Must match the shader!
+    const UINT GroupSize = 256;
+
+    // Must match the Particle struct in ParticleSystem.fx.
+    struct Particle
+    {
+        XMFLOAT3 position;
+        float age;
+        XMFLOAT3 velocity;
+        float lifetime;
+    };
+
+    static_assert(sizeof(Particle) == 32, "Particle size mismatch");
+
+    // Constant buffer layout. Must match the shader!
+    XM_ALIGNED_STRUCT(16) ParticleConstants
+    {
+        XMMATRIX world;
+        XMMATRIX view;
+        XMMATRIX projection;
+        XMVECTOR emitterPosition;
+        XMVECTOR positionVariance;
+        XMVECTOR velocity;
+        XMVECTOR velocityVariance;
+        XMVECTOR acceleration;      // drag is .w
+        XMVECTOR startColor;
+        XMVECTOR endColor;
+        XMVECTOR lifeSize;          // minimum lifetime, maximum lifetime, start size, end size
+        float elapsedTime;
+        uint32_t emitCount;
+        uint32_t randomSeed;
+        uint32_t maxParticles;
+    };
+
+    static_assert((sizeof(ParticleConstants) % 16) == 0, "CB size not padded correctly");
+
+    // The indirect dispatch arguments for the simulate pass, followed by the draw arguments.
+    const UINT DispatchArgsOffset = 0;
+    const UINT DrawArgsOffset = 3 * sizeof(uint32_t);
+    const UINT DrawInstanceCountOffset = DrawArgsOffset + sizeof(uint32_t);
+    const UINT IndirectArgsSize = 7 * sizeof(uint32_t);
+
+    // Factory for lazily instantiating shaders.
+    class DeviceResources
+    {
+    public:
+        DeviceResources(_In_ ID3D11Device* device)
+            : mDevice(device),
+            mInitDeadListShader{},
+            mEmitShader{},
+            mPrepareSimulateShader{},
+            mSimulateShader{},
+            mVertexShader{},
+            mPixelShader{},
+            mDefaultTexture{},
+            mMutex{}
+        { }
+
+        ID3D11ComputeShader* GetInitDeadListShader()
+        {
+            return GetComputeShader(mInitDeadListShader, ParticleSystem_CSInitDeadList, sizeof(ParticleSystem_CSInitDeadList));
+        }
+
+        ID3D11ComputeShader* GetEmitShader()
+        {
+            return GetComputeShader(mEmitShader, ParticleSystem_CSEmit, sizeof(ParticleSystem_CSEmit));
+        }
+
+        ID3D11ComputeShader* GetPrepareSimulateShader()
+        {
+            return GetComputeShader(mPrepareSimulateShader, ParticleSystem_CSPrepareSimulate, sizeof(ParticleSystem_CSPrepareSimulate));
+        }
+
+        ID3D11ComputeShader* GetSimulateShader()
+        {
+            return GetComputeShader(mSimulateShader, ParticleSystem_CSSimulate, sizeof(ParticleSystem_CSSimulate));
+        }
+
+        // Gets or lazily creates the vertex shader.
+        ID3D11VertexShader* GetVertexShader()
+        {
+            return DemandCreate(mVertexShader, mMutex, [&](ID3D11VertexShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateVertexShader(ParticleSystem_VSParticle, sizeof(ParticleSystem_VSParticle), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ParticleSystem");
+
+                return hr;
+            });
+        }
+
+        // Gets or lazily creates the pixel shader, which is the one SpriteBatch uses.
+        ID3D11PixelShader* GetPixelShader()
+        {
+            return DemandCreate(mPixelShader, mMutex, [&](ID3D11PixelShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreatePixelShader(SpriteEffect_SpritePixelShader, sizeof(SpriteEffect_SpritePixelShader), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ParticleSystem");
+
+                return hr;
+            });
+        }
+
+        // Gets or lazily creates the white texture used when none is set.
+        ID3D11ShaderResourceView* GetDefaultTexture()
+        {
+            return DemandCreate(mDefaultTexture, mMutex, [&](ID3D11ShaderResourceView** pResult) -> HRESULT
+            {
+                static const uint32_t s_pixel = 0xffffffff;
+
+                D3D11_SUBRESOURCE_DATA initData = { &s_pixel, sizeof(uint32_t), 0 };
+
+                CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+
+                ComPtr<ID3D11Texture2D> tex;
+                HRESULT hr = mDevice->CreateTexture2D(&desc, &initData, tex.GetAddressOf());
+
+                if (SUCCEEDED(hr))
+                {
+                    SetDebugObjectName(tex.Get(), "ParticleSystem");
+
+                    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 1);
+
+                    hr = mDevice->CreateShaderResourceView(tex.Get(), &srvDesc, pResult);
+                    if (SUCCEEDED(hr))
+                        SetDebugObjectName(*pResult, "ParticleSystem");
+                }
+
+                return hr;
+            });
+        }
+
+    protected:
+        ComPtr<ID3D11Device> mDevice;
+        ComPtr<ID3D11ComputeShader> mInitDeadListShader;
+        ComPtr<ID3D11ComputeShader> mEmitShader;
+        ComPtr<ID3D11ComputeShader> mPrepareSimulateShader;
+        ComPtr<ID3D11ComputeShader> mSimulateShader;
+        ComPtr<ID3D11VertexShader> mVertexShader;
+        ComPtr<ID3D11PixelShader> mPixelShader;
+        ComPtr<ID3D11ShaderResourceView> mDefaultTexture;
+        std::mutex mMutex;
+
+        ID3D11ComputeShader* GetComputeShader(ComPtr<ID3D11ComputeShader>& shader, void const* code, size_t length)
+        {
+            return DemandCreate(shader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(code, length, nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ParticleSystem");
+
+                return hr;
+            });
+        }
+    };
+}
+
+
+// Internal ParticleSystem implementation class.
+class ParticleSystem::Impl : public AlignedNew<ParticleConstants>
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t maxParticles);
+
+    void Apply(_In_ ID3D11DeviceContext* deviceContext);
+    void Update(_In_ ID3D11DeviceContext* deviceContext, float elapsedTime);
+    void Draw(_In_ ID3D11DeviceContext* deviceContext);
+
+    // Fields.
+    ParticleConstants                       constants;
+    ComPtr<ID3D11ShaderResourceView>        texture;
+    float                                   emissionRate;
+    float                                   emissionRemainder;
+    size_t                                  pendingEmit;
+    bool                                    reset;
+
+private:
+    void CreateList(_Outptr_ ID3D11Buffer** buffer, _Outptr_ ID3D11UnorderedAccessView** uav, _Outptr_opt_ ID3D11ShaderResourceView** srv);
+
+    void SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext);
+    void SetVertexConstants(_In_ ID3D11DeviceContext* deviceContext);
+
+    size_t                                  mMaxParticles;
+    uint32_t                                mFrame;
+    int                                     mCurrent;
+
+    ComPtr<ID3D11Buffer>                    mParticles;
+    ComPtr<ID3D11UnorderedAccessView>       mParticlesUAV;
+    ComPtr<ID3D11ShaderResourceView>        mParticlesSRV;
+
+    // Free slots, and the live slots for this frame and the next.
+    ComPtr<ID3D11Buffer>                    mDeadList;
+    ComPtr<ID3D11UnorderedAccessView>       mDeadListUAV;
+    ComPtr<ID3D11Buffer>                    mAliveLists[2];
+    ComPtr<ID3D11UnorderedAccessView>       mAliveListUAVs[2];
+    ComPtr<ID3D11ShaderResourceView>        mAliveListSRVs[2];
+
+    ComPtr<ID3D11Buffer>                    mIndirectArgs;
+    ComPtr<ID3D11UnorderedAccessView>       mIndirectArgsUAV;
+
+    // List counts copied in on the GPU.
+    ComPtr<ID3D11Buffer>                    mCounts;
+
+    ComPtr<ID3D11Device>                    mDevice;
+    ConstantBuffer<ParticleConstants>       mConstantBuffer;
+
+    // Per-device resources.
+    std::shared_ptr<DeviceResources>        mDeviceResources;
+
+    static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+};
+
+
+// Global pool of per-device ParticleSystem resources.
+SharedResourcePool<ID3D11Device*, DeviceResources> ParticleSystem::Impl::deviceResourcesPool;
+
+
+// Constructor.
+ParticleSystem::Impl::Impl(_In_ ID3D11Device* device, size_t maxParticles)
+    : constants{},
+    emissionRate(0.f),
+    emissionRemainder(0.f),
+    pendingEmit(0),
+    reset(true),
+    mMaxParticles(maxParticles),
+    mFrame(0),
+    mCurrent(0),
+    mDevice(device),
+    mConstantBuffer(device),
+    mDeviceResources(deviceResourcesPool.DemandCreate(device))
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        throw std::exception("ParticleSystem requires Feature Level 11.0 or later");
+    }
+
+    if (!maxParticles)
+    {
+        throw std::exception("maxParticles must be greater than 0");
+    }
+
+    // Limited by the largest single dispatch.
+    if (maxParticles > size_t(D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION) * GroupSize)
+    {
+        throw std::exception("maxParticles too large for ParticleSystem");
+    }
+
+    constants.world = XMMatrixIdentity();
+    constants.view = XMMatrixIdentity();
+    constants.projection = XMMatrixIdentity();
+    constants.startColor = g_XMOne;
+    constants.endColor = g_XMZero;
+    constants.lifeSize = XMVectorSet(1.f, 1.f, 1.f, 1.f);
+    constants.maxParticles = static_cast<uint32_t>(maxParticles);
+
+    // Particle storage.
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(maxParticles * sizeof(Particle)),
+            D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE,
+            D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(Particle));
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mParticles.GetAddressOf()));
+
+        SetDebugObjectName(mParticles.Get(), "ParticleSystem");
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, static_cast<UINT>(maxParticles));
+        ThrowIfFailed(device->CreateUnorderedAccessView(mParticles.Get(), &uavDesc, mParticlesUAV.GetAddressOf()));
+
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, static_cast<UINT>(maxParticles));
+        ThrowIfFailed(device->CreateShaderResourceView(mParticles.Get(), &srvDesc, mParticlesSRV.GetAddressOf()));
+    }
+
+    CreateList(mDeadList.GetAddressOf(), mDeadListUAV.GetAddressOf(), nullptr);
+
+    for (int j = 0; j < 2; ++j)
+    {
+        CreateList(mAliveLists[j].GetAddressOf(), mAliveListUAVs[j].GetAddressOf(), mAliveListSRVs[j].GetAddressOf());
+    }
+
+    // Indirect arguments start out drawing nothing.
+    {
+        static const uint32_t s_args[IndirectArgsSize / sizeof(uint32_t)] = { 0, 1, 1, 4, 0, 0, 0 };
+
+        D3D11_SUBRESOURCE_DATA initData = { s_args, 0, 0 };
+
+        CD3D11_BUFFER_DESC desc(IndirectArgsSize, D3D11_BIND_UNORDERED_ACCESS, D3D11_USAGE_DEFAULT, 0,
+            D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, mIndirectArgs.GetAddressOf()));
+
+        SetDebugObjectName(mIndirectArgs.Get(), "ParticleSystem");
+
+        CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_R32_TYPELESS, 0, IndirectArgsSize / sizeof(uint32_t), 0, D3D11_BUFFER_UAV_FLAG_RAW);
+        ThrowIfFailed(device->CreateUnorderedAccessView(mIndirectArgs.Get(), &uavDesc, mIndirectArgsUAV.GetAddressOf()));
+    }
+
+    {
+        CD3D11_BUFFER_DESC desc(16, D3D11_BIND_CONSTANT_BUFFER);
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mCounts.GetAddressOf()));
+
+        SetDebugObjectName(mCounts.Get(), "ParticleSystem");
+    }
+}
+
+
+// Creates an append/consume list of particle indices.
+_Use_decl_annotations_
+void ParticleSystem::Impl::CreateList(ID3D11Buffer** buffer, ID3D11UnorderedAccessView** uav, ID3D11ShaderResourceView** srv)
+{
+    auto count = static_cast<UINT>(mMaxParticles);
+
+    CD3D11_BUFFER_DESC desc(count * sizeof(uint32_t),
+        D3D11_BIND_UNORDERED_ACCESS | ((srv) ? D3D11_BIND_SHADER_RESOURCE : 0u),
+        D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(uint32_t));
+
+    ThrowIfFailed(mDevice->CreateBuffer(&desc, nullptr, buffer));
+
+    SetDebugObjectName(*buffer, "ParticleSystem");
+
+    CD3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count, 0, D3D11_BUFFER_UAV_FLAG_APPEND);
+    ThrowIfFailed(mDevice->CreateUnorderedAccessView(*buffer, &uavDesc, uav));
+
+    if (srv)
+    {
+        CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+        ThrowIfFailed(mDevice->CreateShaderResourceView(*buffer, &srvDesc, srv));
+    }
+}
+
+
+void ParticleSystem::Impl::SetComputeConstants(_In_ ID3D11DeviceContext* deviceContext)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->CSSetPlacementConstantBuffer(0, mConstantBuffer.GetBuffer(), grfxMemory);
+
+    auto counts = mCounts.Get();
+    deviceContext->CSSetConstantBuffers(1, 1, &counts);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+
+    ID3D11Buffer* buffers[2] = { mConstantBuffer.GetBuffer(), mCounts.Get() };
+    deviceContext->CSSetConstantBuffers(0, 2, buffers);
+#endif
+}
+
+
+void ParticleSystem::Impl::SetVertexConstants(_In_ ID3D11DeviceContext* deviceContext)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mConstantBuffer.SetData(deviceContext, constants, &grfxMemory);
+
+    ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->VSSetPlacementConstantBuffer(0, mConstantBuffer.GetBuffer(), grfxMemory);
+#else
+    mConstantBuffer.SetData(deviceContext, constants);
+
+    auto buffer = mConstantBuffer.GetBuffer();
+    deviceContext->VSSetConstantBuffers(0, 1, &buffer);
+#endif
+}
+
+
+// Runs the emit and simulate passes. The CPU only decides how many particles to try to emit; the GPU clamps that to
+// the free slots, and sizes the simulate dispatch and the draw from the list counts itself.
+void ParticleSystem::Impl::Update(_In_ ID3D11DeviceContext* deviceContext, float elapsedTime)
+{
+    if (elapsedTime < 0.f)
+        throw std::out_of_range("elapsedTime must not be negative");
+
+    emissionRemainder += emissionRate * elapsedTime;
+
+    size_t emitCount = static_cast<size_t>(emissionRemainder);
+    emissionRemainder -= static_cast<float>(emitCount);
+
+    emitCount = std::min(emitCount + pendingEmit, mMaxParticles);
+    pendingEmit = 0;
+
+    constants.elapsedTime = elapsedTime;
+    constants.emitCount = static_cast<uint32_t>(emitCount);
+    constants.randomSeed = (++mFrame) * 0x9E3779B9u;
+
+    SetComputeConstants(deviceContext);
+
+    auto groupCount = [](size_t count) noexcept
+    {
+        return static_cast<UINT>((count + GroupSize - 1) / GroupSize);
+    };
+
+    // Keeps the existing hidden counter of an append/consume list.
+    const UINT keep = UINT(-1);
+
+    UINT resetCount = keep;
+
+    if (reset)
+    {
+        reset = false;
+        resetCount = 0;
+
+        ID3D11UnorderedAccessView* uavs[2] = { nullptr, mDeadListUAV.Get() };
+        UINT initialCounts[2] = { keep, 0 };
+        deviceContext->CSSetUnorderedAccessViews(0, 2, uavs, initialCounts);
+
+        deviceContext->CSSetShader(mDeviceResources->GetInitDeadListShader(), nullptr, 0);
+        deviceContext->Dispatch(groupCount(mMaxParticles), 1, 1);
+    }
+
+    auto aliveUAV = mAliveListUAVs[mCurrent].Get();
+    auto nextAliveUAV = mAliveListUAVs[1 - mCurrent].Get();
+
+    // Emit.
+    deviceContext->CopyStructureCount(mCounts.Get(), 0, mDeadListUAV.Get());
+
+    {
+        ID3D11UnorderedAccessView* uavs[3] = { mParticlesUAV.Get(), mDeadListUAV.Get(), aliveUAV };
+        UINT initialCounts[3] = { keep, keep, resetCount };
+        deviceContext->CSSetUnorderedAccessViews(0, 3, uavs, initialCounts);
+    }
+
+    if (emitCount > 0)
+    {
+        deviceContext->CSSetShader(mDeviceResources->GetEmitShader(), nullptr, 0);
+        deviceContext->Dispatch(groupCount(emitCount), 1, 1);
+    }
+
+    // Simulate, sized from the live count.
+    deviceContext->CopyStructureCount(mCounts.Get(), sizeof(uint32_t), aliveUAV);
+
+    {
+        ID3D11UnorderedAccessView* uavs[3] = { mIndirectArgsUAV.Get(), nullptr, nullptr };
+        deviceContext->CSSetUnorderedAccessViews(0, 3, uavs, nullptr);
+
+        deviceContext->CSSetShader(mDeviceResources->GetPrepareSimulateShader(), nullptr, 0);
+        deviceContext->Dispatch(1, 1, 1);
+    }
+
+    {
+        ID3D11UnorderedAccessView* uavs[4] = { mParticlesUAV.Get(), mDeadListUAV.Get(), aliveUAV, nextAliveUAV };
+        UINT initialCounts[4] = { keep, keep, keep, 0 };
+        deviceContext->CSSetUnorderedAccessViews(0, 4, uavs, initialCounts);
+
+        deviceContext->CSSetShader(mDeviceResources->GetSimulateShader(), nullptr, 0);
+        deviceContext->DispatchIndirect(mIndirectArgs.Get(), DispatchArgsOffset);
+    }
+
+    ID3D11UnorderedAccessView* nullUAV[4] = {};
+    deviceContext->CSSetUnorderedAccessViews(0, 4, nullUAV, nullptr);
+
+    // Survivors are drawn.
+    deviceContext->CopyStructureCount(mIndirectArgs.Get(), DrawInstanceCountOffset, nextAliveUAV);
+
+    mCurrent = 1 - mCurrent;
+}
+
+
+// Sets our state onto the D3D device.
+void ParticleSystem::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
+{
+    deviceContext->VSSetShader(mDeviceResources->GetVertexShader(), nullptr, 0);
+    deviceContext->PSSetShader(mDeviceResources->GetPixelShader(), nullptr, 0);
+
+    InvalidateEffectStateCache(deviceContext);
+
+    ID3D11ShaderResourceView* buffers[2] = { mParticlesSRV.Get(), mAliveListSRVs[mCurrent].Get() };
+    deviceContext->VSSetShaderResources(0, 2, buffers);
+
+    ID3D11ShaderResourceView* textures[1] = { (texture) ? texture.Get() : mDeviceResources->GetDefaultTexture() };
+    deviceContext->PSSetShaderResources(0, 1, textures);
+
+    SetVertexConstants(deviceContext);
+}
+
+
+void ParticleSystem::Impl::Draw(_In_ ID3D11DeviceContext* deviceContext)
+{
+    Apply(deviceContext);
+
+    deviceContext->IASetInputLayout(nullptr);
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+    deviceContext->DrawInstancedIndirect(mIndirectArgs.Get(), DrawArgsOffset);
+
+    // The alive lists are bound for writing by the next Update.
+    ID3D11ShaderResourceView* nullSRV[2] = {};
+    deviceContext->VSSetShaderResources(0, 2, nullSRV);
+}
+
+
+//--------------------------------------------------------------------------------------
+// ParticleSystem
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+ParticleSystem::ParticleSystem(_In_ ID3D11Device* device, size_t maxParticles)
+  : pImpl(std::make_unique<Impl>(device, maxParticles))
+{
+}
+
+
+// Move constructor.
+ParticleSystem::ParticleSystem(ParticleSystem&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ParticleSystem& ParticleSystem::operator= (ParticleSystem&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ParticleSystem::~ParticleSystem()
+{
+}
+
+
+// IEffect methods.
+void ParticleSystem::Apply(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Apply(deviceContext);
+}
+
+
+void ParticleSystem::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out_ size_t* pByteCodeLength)
+{
+    assert(pShaderByteCode != nullptr && pByteCodeLength != nullptr);
+
+    *pShaderByteCode = ParticleSystem_VSParticle;
+    *pByteCodeLength = sizeof(ParticleSystem_VSParticle);
+}
+
+
+// Camera settings.
+void XM_CALLCONV ParticleSystem::SetWorld(FXMMATRIX value)
+{
+    pImpl->constants.world = value;
+}
+
+
+void XM_CALLCONV ParticleSystem::SetView(FXMMATRIX value)
+{
+    pImpl->constants.view = value;
+}
+
+
+void XM_CALLCONV ParticleSystem::SetProjection(FXMMATRIX value)
+{
+    pImpl->constants.projection = value;
+}
+
+
+void XM_CALLCONV ParticleSystem::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
+{
+    pImpl->constants.world = world;
+    pImpl->constants.view = view;
+    pImpl->constants.projection = projection;
+}
+
+
+// Emitter settings.
+void XM_CALLCONV ParticleSystem::SetEmitterPosition(FXMVECTOR position, FXMVECTOR variance)
+{
+    pImpl->constants.emitterPosition = position;
+    pImpl->constants.positionVariance = variance;
+}
+
+
+void XM_CALLCONV ParticleSystem::SetVelocity(FXMVECTOR velocity, FXMVECTOR variance)
+{
+    pImpl->constants.velocity = velocity;
+    pImpl->constants.velocityVariance = variance;
+}
+
+
+void ParticleSystem::SetLifetime(float minSeconds, float maxSeconds)
+{
+    if (minSeconds <= 0.f || maxSeconds < minSeconds)
+        throw std::out_of_range("Lifetime must be positive, with min no greater than max");
+
+    pImpl->constants.lifeSize = XMVectorSetX(pImpl->constants.lifeSize, minSeconds);
+    pImpl->constants.lifeSize = XMVectorSetY(pImpl->constants.lifeSize, maxSeconds);
+}
+
+
+void ParticleSystem::SetEmissionRate(float particlesPerSecond)
+{
+    if (particlesPerSecond < 0.f)
+        throw std::out_of_range("Emission rate must not be negative");
+
+    pImpl->emissionRate = particlesPerSecond;
+}
+
+
+// Simulation settings.
+void XM_CALLCONV ParticleSystem::SetAcceleration(FXMVECTOR value)
+{
+    pImpl->constants.acceleration = XMVectorSelect(pImpl->constants.acceleration, value, g_XMSelect1110);
+}
+
+
+void ParticleSystem::SetDrag(float value)
+{
+    pImpl->constants.acceleration = XMVectorSetW(pImpl->constants.acceleration, value);
+}
+
+
+// Appearance settings.
+void ParticleSystem::SetSize(float startSize, float endSize)
+{
+    pImpl->constants.lifeSize = XMVectorSetZ(pImpl->constants.lifeSize, startSize);
+    pImpl->constants.lifeSize = XMVectorSetW(pImpl->constants.lifeSize, endSize);
+}
+
+
+void XM_CALLCONV ParticleSystem::SetColors(FXMVECTOR startColor, FXMVECTOR endColor)
+{
+    pImpl->constants.startColor = startColor;
+    pImpl->constants.endColor = endColor;
+}
+
+
+void ParticleSystem::SetTexture(_In_opt_ ID3D11ShaderResourceView* value)
+{
+    pImpl->texture = value;
+}
+
+
+// Simulation.
+void ParticleSystem::Emit(size_t count)
+{
+    pImpl->pendingEmit = std::min(pImpl->pendingEmit + count, GetMaxParticles());
+}
+
+
+void ParticleSystem::Update(_In_ ID3D11DeviceContext* deviceContext, float elapsedTime)
+{
+    pImpl->Update(deviceContext, elapsedTime);
+}
+
+
+void ParticleSystem::Draw(_In_ ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Draw(deviceContext);
+}
+
+
+void ParticleSystem::Reset() noexcept
+{
+    pImpl->reset = true;
+    pImpl->pendingEmit = 0;
+    pImpl->emissionRemainder = 0.f;
+}
+
+
+size_t ParticleSystem::GetMaxParticles() const noexcept
+{
+    return pImpl->constants.maxParticles;
+}
@@ -0,0 +1,288 @@
+//--------------------------------------------------------------------------------------
+// File: PixelConvert.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "PixelConvert.h"
+
+#include "ThreadPool.h"
+
+#if defined(_XM_SSE_INTRINSICS_)
+#include <intrin.h>
+#include <tmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    struct ConversionInfo
+    {
+        size_t sourceSize;
+        size_t destSize;
+    };
+
+    // Indexed by PIXEL_CONVERSION.
+    const ConversionInfo g_Conversions[] =
+    {
+        { 3, 4 },   // RGB24_TO_RGBA32
+        { 3, 4 },   // BGR24_TO_RGBA32
+        { 4, 4 },   // RGBX32_TO_RGBA32
+        { 4, 4 },   // BGRX32_TO_RGBA32
+        { 4, 4 },   // BGRA32_TO_RGBA32
+        { 6, 8 },   // RGB48_TO_RGBA64
+        { 6, 8 },   // BGR48_TO_RGBA64
+        { 8, 8 },   // BGRA64_TO_RGBA64
+    };
+
+    // Converts pixels [first, width) of one row.
+    void ConvertRowScalar(PIXEL_CONVERSION conversion, _In_ const uint8_t* src, _In_ uint8_t* dest, size_t first, size_t width) noexcept
+    {
+        // Rows of the 16-bit formats always start on an even address, as every pitch is a multiple of the pixel size.
+        auto src16 = reinterpret_cast<const uint16_t*>(src);
+        auto dest16 = reinterpret_cast<uint16_t*>(dest);
+
+        for (size_t x = first; x < width; ++x)
+        {
+            switch (conversion)
+            {
+                case PIXEL_CONVERSION_RGB24_TO_RGBA32:
+                    dest[x * 4] = src[x * 3];
+                    dest[x * 4 + 1] = src[x * 3 + 1];
+                    dest[x * 4 + 2] = src[x * 3 + 2];
+                    dest[x * 4 + 3] = 0xFF;
+                    break;
+
+                case PIXEL_CONVERSION_BGR24_TO_RGBA32:
+                    dest[x * 4] = src[x * 3 + 2];
+                    dest[x * 4 + 1] = src[x * 3 + 1];
+                    dest[x * 4 + 2] = src[x * 3];
+                    dest[x * 4 + 3] = 0xFF;
+                    break;
+
+                case PIXEL_CONVERSION_RGBX32_TO_RGBA32:
+                    dest[x * 4] = src[x * 4];
+                    dest[x * 4 + 1] = src[x * 4 + 1];
+                    dest[x * 4 + 2] = src[x * 4 + 2];
+                    dest[x * 4 + 3] = 0xFF;
+                    break;
+
+                case PIXEL_CONVERSION_BGRX32_TO_RGBA32:
+                case PIXEL_CONVERSION_BGRA32_TO_RGBA32:
+                    dest[x * 4] = src[x * 4 + 2];
+                    dest[x * 4 + 1] = src[x * 4 + 1];
+                    dest[x * 4 + 2] = src[x * 4];
+                    dest[x * 4 + 3] = (conversion == PIXEL_CONVERSION_BGRA32_TO_RGBA32) ? src[x * 4 + 3] : uint8_t(0xFF);
+                    break;
+
+                case PIXEL_CONVERSION_RGB48_TO_RGBA64:
+                    dest16[x * 4] = src16[x * 3];
+                    dest16[x * 4 + 1] = src16[x * 3 + 1];
+                    dest16[x * 4 + 2] = src16[x * 3 + 2];
+                    dest16[x * 4 + 3] = 0xFFFF;
+                    break;
+
+                case PIXEL_CONVERSION_BGR48_TO_RGBA64:
+                    dest16[x * 4] = src16[x * 3 + 2];
+                    dest16[x * 4 + 1] = src16[x * 3 + 1];
+                    dest16[x * 4 + 2] = src16[x * 3];
+                    dest16[x * 4 + 3] = 0xFFFF;
+                    break;
+
+                case PIXEL_CONVERSION_BGRA64_TO_RGBA64:
+                    dest16[x * 4] = src16[x * 4 + 2];
+                    dest16[x * 4 + 1] = src16[x * 4 + 1];
+                    dest16[x * 4 + 2] = src16[x * 4];
+                    dest16[x * 4 + 3] = src16[x * 4 + 3];
+                    break;
+            }
+        }
+    }
+
+
+#if defined(_XM_SSE_INTRINSICS_)
+    bool HasSSSE3() noexcept
+    {
+        static const bool s_ssse3 = []() noexcept
+        {
+            int info[4] = {};
+            __cpuid(info, 1);
+            return (info[2] & 0x200) != 0;
+        }();
+
+        return s_ssse3;
+    }
+
+
+    // Converts as much of one row as fits whole steps, and returns the number of pixels done. The 3-channel
+    // expansions take 48 source bytes a step and split them into four 12 byte groups, each shuffled out to 16 bytes.
+    // The rest are plain 16 byte swizzles. Alpha is then OR'd into the slots the shuffle left zero.
+    size_t ConvertRowSSSE3(PIXEL_CONVERSION conversion, _In_ const uint8_t* src, _In_ uint8_t* dest, size_t width) noexcept
+    {
+        const __m128i opaque32 = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        const __m128i opaque64 = _mm_set_epi32(static_cast<int>(0xFFFF0000), 0, static_cast<int>(0xFFFF0000), 0);
+
+        __m128i mask;
+        __m128i alpha;
+        bool expand;
+
+        switch (conversion)
+        {
+            case PIXEL_CONVERSION_RGB24_TO_RGBA32:
+                mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+                alpha = opaque32;
+                expand = true;
+                break;
+
+            case PIXEL_CONVERSION_BGR24_TO_RGBA32:
+                mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+                alpha = opaque32;
+                expand = true;
+                break;
+
+            case PIXEL_CONVERSION_RGBX32_TO_RGBA32:
+                mask = _mm_setr_epi8(0, 1, 2, -1, 4, 5, 6, -1, 8, 9, 10, -1, 12, 13, 14, -1);
+                alpha = opaque32;
+                expand = false;
+                break;
+
+            case PIXEL_CONVERSION_BGRX32_TO_RGBA32:
+                mask = _mm_setr_epi8(2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+                alpha = opaque32;
+                expand = false;
+                break;
+
+            case PIXEL_CONVERSION_BGRA32_TO_RGBA32:
+                mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+                alpha = _mm_setzero_si128();
+                expand = false;
+                break;
+
+            case PIXEL_CONVERSION_RGB48_TO_RGBA64:
+                mask = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+                alpha = opaque64;
+                expand = true;
+                break;
+
+            case PIXEL_CONVERSION_BGR48_TO_RGBA64:
+                mask = _mm_setr_epi8(4, 5, 2, 3, 0, 1, -1, -1, 10, 11, 8, 9, 6, 7, -1, -1);
+                alpha = opaque64;
+                expand = true;
+                break;
+
+            case PIXEL_CONVERSION_BGRA64_TO_RGBA64:
+                mask = _mm_setr_epi8(4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15);
+                alpha = _mm_setzero_si128();
+                expand = false;
+                break;
+
+            default:
+                return 0;
+        }
+
+        size_t sourceSize = g_Conversions[conversion].sourceSize;
+        size_t rowBytes = width * sourceSize;
+
+        if (expand)
+        {
+            size_t steps = rowBytes / 48;
+
+            for (size_t i = 0; i < steps; ++i, src += 48, dest += 64)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+                // Source bytes 0-11, 12-23, 24-35 and 36-47 in the low 12 bytes of each register.
+                __m128i g1 = _mm_alignr_epi8(b, a, 12);
+                __m128i g2 = _mm_alignr_epi8(c, b, 8);
+                __m128i g3 = _mm_srli_si128(c, 4);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_or_si128(_mm_shuffle_epi8(a, mask), alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 16), _mm_or_si128(_mm_shuffle_epi8(g1, mask), alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 32), _mm_or_si128(_mm_shuffle_epi8(g2, mask), alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 48), _mm_or_si128(_mm_shuffle_epi8(g3, mask), alpha));
+            }
+
+            return steps * 48 / sourceSize;
+        }
+        else
+        {
+            size_t steps = rowBytes / 16;
+
+            for (size_t i = 0; i < steps; ++i, src += 16, dest += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+            }
+
+            return steps * 16 / sourceSize;
+        }
+    }
+#endif
+}
+
+
+size_t DirectX::GetPixelConversionSourceSize(PIXEL_CONVERSION conversion) noexcept
+{
+    return g_Conversions[conversion].sourceSize;
+}
+
+
+size_t DirectX::GetPixelConversionDestSize(PIXEL_CONVERSION conversion) noexcept
+{
+    return g_Conversions[conversion].destSize;
+}
+
+
+_Use_decl_annotations_
+void DirectX::ConvertPixels(PIXEL_CONVERSION conversion,
+                            const uint8_t* src, size_t srcPitch,
+                            uint8_t* dest, size_t destPitch,
+                            size_t width, size_t height) noexcept
+{
+    assert(static_cast<size_t>(conversion) < _countof(g_Conversions));
+
+#if defined(_XM_SSE_INTRINSICS_)
+    bool ssse3 = HasSSSE3();
+#endif
+
+    auto convertRows = [=](size_t first, size_t last) noexcept
+    {
+        for (size_t y = first; y < last; ++y)
+        {
+            auto srcRow = src + y * srcPitch;
+            auto destRow = dest + y * destPitch;
+
+            size_t done = 0;
+
+        #if defined(_XM_SSE_INTRINSICS_)
+            if (ssse3)
+                done = ConvertRowSSSE3(conversion, srcRow, destRow, width);
+        #endif
+
+            ConvertRowScalar(conversion, srcRow, destRow, done, width);
+        }
+    };
+
+    // Bands of around 256KB of output keep each work item well above the cost of dispatching it.
+    size_t bandRows = std::max<size_t>(1, (256 * 1024) / std::max<size_t>(destPitch, 1));
+    size_t bandCount = (height + bandRows - 1) / bandRows;
+
+    if (bandCount <= 1)
+    {
+        convertRows(0, height);
+        return;
+    }
+
+    ParallelFor(bandCount, [&](size_t band)
+    {
+        convertRows(band * bandRows, std::min(height, (band + 1) * bandRows));
+    });
+}
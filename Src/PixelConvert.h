@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// File: PixelConvert.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+namespace DirectX
+{
+    // Scanline conversions done in place of IWICFormatConverter for the common expansions and swizzles.
+    // Opaque sources get an alpha of all ones, matching what WIC produces.
+    enum PIXEL_CONVERSION
+    {
+        PIXEL_CONVERSION_RGB24_TO_RGBA32 = 0,
+        PIXEL_CONVERSION_BGR24_TO_RGBA32,
+        PIXEL_CONVERSION_RGBX32_TO_RGBA32,
+        PIXEL_CONVERSION_BGRX32_TO_RGBA32,
+        PIXEL_CONVERSION_BGRA32_TO_RGBA32,
+        PIXEL_CONVERSION_RGB48_TO_RGBA64,
+        PIXEL_CONVERSION_BGR48_TO_RGBA64,
+        PIXEL_CONVERSION_BGRA64_TO_RGBA64,
+    };
+
+    // Bytes per pixel of the source and destination of a conversion.
+    size_t GetPixelConversionSourceSize(PIXEL_CONVERSION conversion) noexcept;
+    size_t GetPixelConversionDestSize(PIXEL_CONVERSION conversion) noexcept;
+
+    // Converts an image row by row, using SSSE3 shuffles where the CPU has them and plain loops otherwise.
+    // Large images are split into bands of rows spread over the system thread pool.
+    void ConvertPixels(PIXEL_CONVERSION conversion,
+                       _In_reads_bytes_(srcPitch * height) const uint8_t* src, size_t srcPitch,
+                       _Out_writes_bytes_(destPitch * height) uint8_t* dest, size_t destPitch,
+                       size_t width, size_t height) noexcept;
+}
@@ -81,4 +81,8 @@ namespace DirectX
     typedef std::unique_ptr<void, handle_closer> ScopedHandle;
 
     inline HANDLE safe_handle(HANDLE h) noexcept { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
+
+    struct view_unmapper { void operator()(void const* p) noexcept { if (p) UnmapViewOfFile(p); } };
+
+    typedef std::unique_ptr<void const, view_unmapper> ScopedMappedView;
 }
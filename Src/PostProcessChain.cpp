@@ -0,0 +1,505 @@
+//--------------------------------------------------------------------------------------
+// File: PostProcessChain.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "PostProcess.h"
+
+#include "DirectXHelpers.h"
+#include "GpuProfiler.h"
+#include "LoaderHelpers.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    const size_t c_Destination = size_t(-1);
+
+    inline UINT ScaleDimension(UINT value, UINT divisor) noexcept
+    {
+        return std::max(value / divisor, 1u);
+    }
+}
+
+
+class PostProcessChain::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, _In_reads_(count) const Pass* passList, size_t count);
+
+    void Process(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl()>& setCustomState);
+
+    void ReleaseTargets() noexcept
+    {
+        mTargets.clear();
+        mPlanned = false;
+    }
+
+    size_t GetTargetCount() const noexcept { return mTargets.size(); }
+    size_t GetTargetMemory() const noexcept;
+
+    // Fields.
+    ComPtr<ID3D11ShaderResourceView>    source;
+    ComPtr<ID3D11RenderTargetView>      renderTarget;
+    std::vector<Pass>                   passes;
+
+private:
+    // Intermediate render targets, shared by passes whose outputs are not alive at the same time.
+    struct Target
+    {
+        ComPtr<ID3D11Texture2D>             texture;
+        ComPtr<ID3D11RenderTargetView>      rtv;
+        ComPtr<ID3D11ShaderResourceView>    srv;
+        UINT                                width;
+        UINT                                height;
+        DXGI_FORMAT                         format;
+    };
+
+    struct Step
+    {
+        UINT            width;
+        UINT            height;
+        DXGI_FORMAT     format;
+        size_t          lastUse;
+        size_t          target;
+    };
+
+    void Plan(UINT sourceWidth, UINT sourceHeight, DXGI_FORMAT sourceFormat, UINT destWidth, UINT destHeight);
+
+    ID3D11ShaderResourceView* GetInput(unsigned int input) const noexcept
+    {
+        if (input == Input_Source)
+            return source.Get();
+
+        return mTargets[mSteps[input].target].srv.Get();
+    }
+
+    ComPtr<ID3D11Device>                mDevice;
+    std::vector<Step>                   mSteps;
+    std::vector<Target>                 mTargets;
+
+    // The sizes the current plan was made for.
+    bool                                mPlanned;
+    UINT                                mSourceWidth;
+    UINT                                mSourceHeight;
+    DXGI_FORMAT                         mSourceFormat;
+    UINT                                mDestWidth;
+    UINT                                mDestHeight;
+};
+
+
+// Constructor.
+PostProcessChain::Impl::Impl(_In_ ID3D11Device* device, _In_reads_(count) const Pass* passList, size_t count)
+    : mDevice(device),
+    mPlanned(false),
+    mSourceWidth(0),
+    mSourceHeight(0),
+    mSourceFormat(DXGI_FORMAT_UNKNOWN),
+    mDestWidth(0),
+    mDestHeight(0)
+{
+    if (!passList || !count)
+        throw std::exception("PostProcessChain needs at least one pass");
+
+    if (count >= Input_None)
+        throw std::out_of_range("Too many passes");
+
+    passes.assign(passList, passList + count);
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        auto& pass = passes[j];
+
+        if (!pass.effect)
+            throw std::exception("Pass effect cannot be null");
+
+        if (pass.scale >= Scale_Max)
+            throw std::out_of_range("Scale not defined");
+
+        if (pass.input != Input_Source && pass.input >= j)
+            throw std::out_of_range("Pass input must be the source or an earlier pass");
+
+        bool dual = dynamic_cast<DualPostProcess*>(pass.effect) != nullptr;
+
+        if (dual)
+        {
+            if (pass.input2 != Input_Source && pass.input2 >= j)
+                throw std::out_of_range("Pass input must be the source or an earlier pass");
+        }
+        else if (pass.input2 != Input_None)
+        {
+            throw std::exception("Only DualPostProcess takes a second input");
+        }
+
+        if (!dual
+            && !dynamic_cast<BasicPostProcess*>(pass.effect)
+            && !dynamic_cast<ToneMapPostProcess*>(pass.effect))
+        {
+            throw std::exception("PostProcessChain does not know how to bind this effect");
+        }
+    }
+
+    mSteps.resize(count);
+}
+
+
+// Works out the size and format of each pass and assigns its output to a pooled target.
+void PostProcessChain::Impl::Plan(UINT sourceWidth, UINT sourceHeight, DXGI_FORMAT sourceFormat, UINT destWidth, UINT destHeight)
+{
+    const size_t count = passes.size();
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        auto& pass = passes[j];
+        auto& step = mSteps[j];
+
+        step.lastUse = j;
+        step.target = c_Destination;
+
+        if (j + 1 == count)
+        {
+            step.width = destWidth;
+            step.height = destHeight;
+            step.format = DXGI_FORMAT_UNKNOWN;
+            break;
+        }
+
+        UINT inWidth = sourceWidth;
+        UINT inHeight = sourceHeight;
+        DXGI_FORMAT inFormat = sourceFormat;
+
+        if (pass.input != Input_Source)
+        {
+            auto& in = mSteps[pass.input];
+            inWidth = in.width;
+            inHeight = in.height;
+            inFormat = in.format;
+        }
+
+        switch (pass.scale)
+        {
+        case Scale_Full:
+            step.width = sourceWidth;
+            step.height = sourceHeight;
+            break;
+
+        case Scale_Half:
+            step.width = ScaleDimension(sourceWidth, 2);
+            step.height = ScaleDimension(sourceHeight, 2);
+            break;
+
+        case Scale_Quarter:
+            step.width = ScaleDimension(sourceWidth, 4);
+            step.height = ScaleDimension(sourceHeight, 4);
+            break;
+
+        default:
+            {
+                UINT divisor = 1;
+
+                auto basic = dynamic_cast<BasicPostProcess*>(pass.effect);
+                if (basic)
+                {
+                    switch (basic->GetEffect())
+                    {
+                    case BasicPostProcess::DownScale_2x2:
+                        divisor = 2;
+                        break;
+
+                    case BasicPostProcess::DownScale_4x4:
+                        divisor = 4;
+                        break;
+
+                    case BasicPostProcess::BloomExtract:
+                        // Only blurred afterwards, so half resolution loses nothing visible.
+                        divisor = 2;
+                        break;
+
+                    default:
+                        break;
+                    }
+                }
+
+                step.width = ScaleDimension(inWidth, divisor);
+                step.height = ScaleDimension(inHeight, divisor);
+
+                if (pass.input2 != Input_None && pass.input2 != Input_Source)
+                {
+                    auto& in2 = mSteps[pass.input2];
+                    step.width = std::max(step.width, in2.width);
+                    step.height = std::max(step.height, in2.height);
+                }
+                else if (pass.input2 == Input_Source)
+                {
+                    step.width = std::max(step.width, sourceWidth);
+                    step.height = std::max(step.height, sourceHeight);
+                }
+            }
+            break;
+        }
+
+        step.format = (pass.format != DXGI_FORMAT_UNKNOWN) ? pass.format : inFormat;
+    }
+
+    for (size_t j = 0; j < count; ++j)
+    {
+        auto& pass = passes[j];
+
+        if (pass.input != Input_Source)
+            mSteps[pass.input].lastUse = std::max(mSteps[pass.input].lastUse, j);
+
+        if (pass.input2 != Input_Source && pass.input2 != Input_None)
+            mSteps[pass.input2].lastUse = std::max(mSteps[pass.input2].lastUse, j);
+    }
+
+    // Hand out targets in pass order, reusing any whose contents are no longer read.
+    std::vector<size_t> busyUntil(mTargets.size(), 0);
+    std::vector<bool> used(mTargets.size(), false);
+
+    for (size_t j = 0; j + 1 < count; ++j)
+    {
+        auto& step = mSteps[j];
+
+        size_t index = c_Destination;
+        for (size_t k = 0; k < mTargets.size(); ++k)
+        {
+            auto& target = mTargets[k];
+
+            if ((!used[k] || busyUntil[k] < j)
+                && target.width == step.width
+                && target.height == step.height
+                && target.format == step.format)
+            {
+                index = k;
+                break;
+            }
+        }
+
+        if (index == c_Destination)
+        {
+            Target target = {};
+            target.width = step.width;
+            target.height = step.height;
+            target.format = step.format;
+
+            CD3D11_TEXTURE2D_DESC desc(step.format, step.width, step.height, 1, 1, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE);
+
+            // Lets BasicPostProcess run its compute versions into the target.
+            UINT support = 0;
+            if (mDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0
+                && SUCCEEDED(mDevice->CheckFormatSupport(step.format, &support))
+                && (support & D3D11_FORMAT_SUPPORT_TYPED_UNORDERED_ACCESS_VIEW))
+            {
+                desc.BindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+            }
+
+            ThrowIfFailed(mDevice->CreateTexture2D(&desc, nullptr, target.texture.GetAddressOf()));
+
+            SetDebugObjectName(target.texture.Get(), "PostProcessChain");
+
+            ThrowIfFailed(mDevice->CreateRenderTargetView(target.texture.Get(), nullptr, target.rtv.GetAddressOf()));
+            ThrowIfFailed(mDevice->CreateShaderResourceView(target.texture.Get(), nullptr, target.srv.GetAddressOf()));
+
+            index = mTargets.size();
+            mTargets.emplace_back(std::move(target));
+            busyUntil.push_back(0);
+            used.push_back(false);
+        }
+
+        used[index] = true;
+        busyUntil[index] = step.lastUse;
+        step.target = index;
+    }
+
+    // Drop targets the new plan has no use for.
+    std::vector<size_t> remap(mTargets.size(), c_Destination);
+    size_t kept = 0;
+    for (size_t k = 0; k < mTargets.size(); ++k)
+    {
+        if (used[k])
+        {
+            if (kept != k)
+                mTargets[kept] = std::move(mTargets[k]);
+
+            remap[k] = kept++;
+        }
+    }
+    mTargets.resize(kept);
+
+    for (auto& step : mSteps)
+    {
+        if (step.target != c_Destination)
+            step.target = remap[step.target];
+    }
+
+    mSourceWidth = sourceWidth;
+    mSourceHeight = sourceHeight;
+    mSourceFormat = sourceFormat;
+    mDestWidth = destWidth;
+    mDestHeight = destHeight;
+    mPlanned = true;
+}
+
+
+// Runs every pass.
+void PostProcessChain::Impl::Process(_In_ ID3D11DeviceContext* deviceContext, std::function<void __cdecl()>& setCustomState)
+{
+    if (!source || !renderTarget)
+        throw std::exception("Call SetSourceTexture and SetRenderTarget before Process");
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    source->GetDesc(&srvDesc);
+
+    ComPtr<ID3D11Resource> res;
+    source->GetResource(res.GetAddressOf());
+
+    ComPtr<ID3D11Texture2D> tex;
+    if (FAILED(res.As(&tex)))
+        throw std::exception("Source must be a 2D texture");
+
+    D3D11_TEXTURE2D_DESC sourceDesc;
+    tex->GetDesc(&sourceDesc);
+
+    renderTarget->GetResource(res.ReleaseAndGetAddressOf());
+
+    if (FAILED(res.As(&tex)))
+        throw std::exception("Render target must be a 2D texture");
+
+    D3D11_TEXTURE2D_DESC destDesc;
+    tex->GetDesc(&destDesc);
+
+    if (!mPlanned
+        || sourceDesc.Width != mSourceWidth || sourceDesc.Height != mSourceHeight || srvDesc.Format != mSourceFormat
+        || destDesc.Width != mDestWidth || destDesc.Height != mDestHeight)
+    {
+        Plan(sourceDesc.Width, sourceDesc.Height, srvDesc.Format, destDesc.Width, destDesc.Height);
+    }
+
+    for (size_t j = 0; j < passes.size(); ++j)
+    {
+        auto& pass = passes[j];
+        auto& step = mSteps[j];
+
+        // Unbind the previous inputs, one of which may be this pass's target.
+        ID3D11ShaderResourceView* nullSRV[2] = {};
+        deviceContext->PSSetShaderResources(0, 2, nullSRV);
+
+        auto rtv = (step.target == c_Destination) ? renderTarget.Get() : mTargets[step.target].rtv.Get();
+        deviceContext->OMSetRenderTargets(1, &rtv, nullptr);
+
+        auto vp = CD3D11_VIEWPORT(0.f, 0.f, float(step.width), float(step.height));
+        deviceContext->RSSetViewports(1, &vp);
+
+        auto input = GetInput(pass.input);
+
+        auto dual = dynamic_cast<DualPostProcess*>(pass.effect);
+        if (dual)
+        {
+            dual->SetSourceTexture(input);
+            dual->SetSourceTexture2(GetInput(pass.input2));
+        }
+        else
+        {
+            auto basic = dynamic_cast<BasicPostProcess*>(pass.effect);
+            if (basic)
+            {
+                basic->SetSourceTexture(input);
+            }
+            else
+            {
+                static_cast<ToneMapPostProcess*>(pass.effect)->SetHDRSourceTexture(input);
+            }
+        }
+
+        pass.effect->Process(deviceContext, setCustomState);
+    }
+}
+
+
+size_t PostProcessChain::Impl::GetTargetMemory() const noexcept
+{
+    size_t total = 0;
+
+    for (auto& target : mTargets)
+    {
+        total += (size_t(target.width) * target.height * LoaderHelpers::BitsPerPixel(target.format)) / 8;
+    }
+
+    return total;
+}
+
+
+// Public constructor.
+PostProcessChain::PostProcessChain(_In_ ID3D11Device* device, _In_reads_(count) const Pass* passes, size_t count)
+    : pImpl(std::make_unique<Impl>(device, passes, count))
+{
+}
+
+
+// Move constructor.
+PostProcessChain::PostProcessChain(PostProcessChain&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+PostProcessChain& PostProcessChain::operator= (PostProcessChain&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+PostProcessChain::~PostProcessChain()
+{
+}
+
+
+// IPostProcess methods.
+void PostProcessChain::Process(_In_ ID3D11DeviceContext* deviceContext, _In_opt_ std::function<void __cdecl()> setCustomState)
+{
+    GpuProfileScope profileScope(deviceContext, L"PostProcessChain::Process");
+
+    pImpl->Process(deviceContext, setCustomState);
+}
+
+
+// Properties
+void PostProcessChain::SetSourceTexture(_In_opt_ ID3D11ShaderResourceView* value)
+{
+    pImpl->source = value;
+}
+
+
+void PostProcessChain::SetRenderTarget(_In_opt_ ID3D11RenderTargetView* value)
+{
+    pImpl->renderTarget = value;
+}
+
+
+void PostProcessChain::ReleaseTargets() noexcept
+{
+    pImpl->ReleaseTargets();
+}
+
+
+size_t PostProcessChain::GetTargetCount() const noexcept
+{
+    return pImpl->GetTargetCount();
+}
+
+
+size_t PostProcessChain::GetTargetMemory() const noexcept
+{
+    return pImpl->GetTargetMemory();
+}
@@ -18,20 +18,62 @@ using namespace DirectX::Internal;
 using Microsoft::WRL::ComPtr;
 
 
+// Internal PrimitiveRecorder implementation class.
+class PrimitiveRecorderBase::Impl
+{
+public:
+    explicit Impl(size_t vertexSize);
+
+    template<typename TIndex>
+    void Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) TIndex const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+
+    void Clear() noexcept;
+
+    bool IsEmpty() const noexcept;
+
+    // Recorded geometry for one topology, with indices rebased onto the stream's vertices.
+    struct Stream
+    {
+        std::vector<uint8_t> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    // One non-indexed and one indexed stream for each list topology, in the order PrimitiveBatch draws them.
+    static const size_t StreamCount = 6;
+
+    static D3D11_PRIMITIVE_TOPOLOGY GetStreamTopology(size_t stream) noexcept;
+    static size_t GetPrimitiveSize(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept;
+
+    size_t mVertexSize;
+    Stream mStreams[StreamCount];
+};
+
+
 // Internal PrimitiveBatch implementation class.
 class PrimitiveBatchBase::Impl
 {
 public:
-    Impl(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize);
+    Impl(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize, uint32_t flags);
 
     void Begin();
     void End();
 
-    void Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) uint16_t const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+    template<typename TIndex>
+    void Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) TIndex const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+
+    void Submit(_In_ PrimitiveRecorderBase::Impl const* recorder);
 
 private:
     void FlushBatch();
 
+    void DrawSubmitted();
+    void GetDrawLimits(bool isIndexed, _Out_ size_t* maxVertices, _Out_ size_t* maxIndices) const noexcept;
+
+    template<typename TIndex>
+    void StageDraw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, _In_opt_count_(indexCount) TIndex const* indices, size_t indexCount, size_t vertexCount, _Out_ void** pMappedVertices);
+
+    void FlushStaged();
+
 #if defined(_XBOX_ONE) && defined(_TITLE)
     ComPtr<ID3D11DeviceContextX> mDeviceContext;
 #else
@@ -43,6 +85,9 @@ private:
     size_t mMaxIndices;
     size_t mMaxVertices;
     size_t mVertexSize;
+    size_t mIndexSize;
+    DXGI_FORMAT mIndexFormat;
+    bool mGrowable;
 
     D3D11_PRIMITIVE_TOPOLOGY mCurrentTopology;
     bool mInBeginEndPair;
@@ -61,11 +106,167 @@ private:
     D3D11_MAPPED_SUBRESOURCE mMappedIndices;
     D3D11_MAPPED_SUBRESOURCE mMappedVertices;
 #endif
+
+    // Growable mode stages the current batch in system memory and uploads it when flushed.
+    std::vector<uint8_t> mStagedIndices;
+    std::vector<uint8_t> mStagedVertices;
+
+    // Recorders to merge at End.
+    std::vector<PrimitiveRecorderBase::Impl const*> mSubmitted;
+    std::vector<uint32_t> mScratchIndices;
 };
 
 
+PrimitiveRecorderBase::Impl::Impl(size_t vertexSize)
+    : mVertexSize(vertexSize)
+{
+    if (!vertexSize)
+        throw std::exception("Vertex size must be greater than 0");
+
+    if (vertexSize > D3D11_REQ_MULTI_ELEMENT_STRUCTURE_SIZE_IN_BYTES)
+        throw std::exception("Vertex size is too large for DirectX 11");
+}
+
+
+D3D11_PRIMITIVE_TOPOLOGY PrimitiveRecorderBase::Impl::GetStreamTopology(size_t stream) noexcept
+{
+    static const D3D11_PRIMITIVE_TOPOLOGY s_topologies[] =
+    {
+        D3D11_PRIMITIVE_TOPOLOGY_POINTLIST,
+        D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
+        D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+    };
+
+    static_assert(_countof(s_topologies) * 2 == StreamCount, "Stream table mismatch");
+
+    assert(stream < StreamCount);
+    return s_topologies[stream / 2];
+}
+
+
+size_t PrimitiveRecorderBase::Impl::GetPrimitiveSize(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept
+{
+    switch (topology)
+    {
+    case D3D11_PRIMITIVE_TOPOLOGY_POINTLIST:    return 1;
+    case D3D11_PRIMITIVE_TOPOLOGY_LINELIST:     return 2;
+    case D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST: return 3;
+    default:                                    return 0;
+    }
+}
+
+
+// Appends geometry to the stream for its topology.
+template<typename TIndex>
+_Use_decl_annotations_
+void PrimitiveRecorderBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, TIndex const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+{
+    if (isIndexed && !indices)
+        throw std::exception("Indices cannot be null");
+
+    size_t primitiveSize = GetPrimitiveSize(topology);
+    if (!primitiveSize)
+        throw std::exception("PrimitiveRecorder only supports point, line, and triangle lists");
+
+    size_t streamIndex = 0;
+    while (GetStreamTopology(streamIndex) != topology)
+        streamIndex += 2;
+
+    auto& stream = mStreams[streamIndex + (isIndexed ? 1 : 0)];
+
+    size_t baseVertex = stream.vertices.size() / mVertexSize;
+
+    if (uint64_t(baseVertex) + vertexCount > UINT32_MAX)
+        throw std::exception("Too many vertices");
+
+    // Copy over the index data.
+    if (isIndexed)
+    {
+        if (indexCount % primitiveSize)
+            throw std::exception("Index count must be a whole number of primitives");
+
+        size_t offset = stream.indices.size();
+        stream.indices.resize(offset + indexCount);
+
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            if (indices[i] >= vertexCount)
+                throw std::out_of_range("Index not in vertices list");
+
+            stream.indices[offset + i] = static_cast<uint32_t>(indices[i] + baseVertex);
+        }
+    }
+
+    // Return the output vertex data location.
+    size_t offset = stream.vertices.size();
+    stream.vertices.resize(offset + vertexCount * mVertexSize);
+
+    *pMappedVertices = stream.vertices.data() + offset;
+}
+
+
+void PrimitiveRecorderBase::Impl::Clear() noexcept
+{
+    for (auto& stream : mStreams)
+    {
+        stream.vertices.clear();
+        stream.indices.clear();
+    }
+}
+
+
+bool PrimitiveRecorderBase::Impl::IsEmpty() const noexcept
+{
+    for (auto const& stream : mStreams)
+    {
+        if (!stream.vertices.empty())
+            return false;
+    }
+
+    return true;
+}
+
+
 namespace
 {
+    // Largest batch a growable PrimitiveBatch stages before flushing, which is half of the GraphicsMemory geometry
+    // ring so that an upload always fits without wrapping.
+    const size_t c_maxGrowableBatchBytes = 2 * 1024 * 1024;
+
+    const size_t c_growableIndexAlignment = 16;
+
+    inline size_t AlignIndexData(size_t offset) noexcept
+    {
+        return (offset + c_growableIndexAlignment - 1) & ~(c_growableIndexAlignment - 1);
+    }
+
+
+    // Helper for writing indices rebased onto the current batch, widening or narrowing them to the batch format.
+    template<typename TIndex>
+    void CopyIndices(_Out_writes_bytes_(indexCount * indexSize) void* dest, size_t indexSize, _In_reads_(indexCount) TIndex const* indices, size_t indexCount, size_t baseVertex)
+    {
+        if (indexSize == sizeof(uint32_t))
+        {
+            auto outputIndices = static_cast<uint32_t*>(dest);
+
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                outputIndices[i] = static_cast<uint32_t>(indices[i] + baseVertex);
+            }
+        }
+        else
+        {
+            auto outputIndices = static_cast<uint16_t*>(dest);
+
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                assert((indices[i] + baseVertex) <= USHRT_MAX);
+                outputIndices[i] = static_cast<uint16_t>(indices[i] + baseVertex);
+            }
+        }
+    }
+
+
     // Helper for creating a D3D vertex or index buffer.
 #if defined(_XBOX_ONE) && defined(_TITLE)
     void CreateBuffer(_In_ ID3D11DeviceX* device, size_t bufferSize, D3D11_BIND_FLAG bindFlag, _Out_ ID3D11Buffer** pBuffer)
@@ -107,10 +308,13 @@ namespace
 
 
 // Constructor.
-PrimitiveBatchBase::Impl::Impl(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize)
+PrimitiveBatchBase::Impl::Impl(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize, uint32_t flags)
   : mMaxIndices(maxIndices),
     mMaxVertices(maxVertices),
     mVertexSize(vertexSize),
+    mIndexSize((flags & PRIMITIVE_BATCH_INDEX32) ? sizeof(uint32_t) : sizeof(uint16_t)),
+    mIndexFormat((flags & PRIMITIVE_BATCH_INDEX32) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT),
+    mGrowable((flags & PRIMITIVE_BATCH_GROWABLE) != 0),
     mCurrentTopology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED),
     mInBeginEndPair(false),
     mCurrentlyIndexed(false),
@@ -135,35 +339,55 @@ PrimitiveBatchBase::Impl::Impl(_In_ ID3D11DeviceContext* deviceContext, size_t m
     if (vertexSize > D3D11_REQ_MULTI_ELEMENT_STRUCTURE_SIZE_IN_BYTES)
         throw std::exception("Vertex size is too large for DirectX 11");
 
-    if ((uint64_t(maxIndices) * sizeof(uint16_t)) > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
+    if ((uint64_t(maxIndices) * mIndexSize) > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
         throw std::exception("IB too large for DirectX 11");
 
     if ((uint64_t(maxVertices) * uint64_t(vertexSize)) > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
         throw std::exception("VB too large for DirectX 11");
 
+    if ((flags & PRIMITIVE_BATCH_INDEX32) && device->GetFeatureLevel() < D3D_FEATURE_LEVEL_9_2)
+        throw std::exception("32-bit indices require Feature Level 9.2 or later");
+
+    if (mGrowable)
+    {
+        if (uint64_t(maxIndices) * mIndexSize + uint64_t(maxVertices) * uint64_t(vertexSize) + c_growableIndexAlignment > c_maxGrowableBatchBytes)
+            throw std::exception("Growable batch reservation is larger than 2MB");
+
+        mStagedIndices.reserve(maxIndices * mIndexSize);
+        mStagedVertices.reserve(maxVertices * vertexSize);
+    }
+
 #if defined(_XBOX_ONE) && defined(_TITLE)
     ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(mDeviceContext.GetAddressOf())));
 
     ComPtr<ID3D11DeviceX> deviceX;
     ThrowIfFailed(device.As(&deviceX));
 
+    // Growable batches place their data anywhere in a flush-sized allocation.
+    size_t indexBufferSize = (mGrowable) ? c_maxGrowableBatchBytes : maxIndices * mIndexSize;
+    size_t vertexBufferSize = (mGrowable) ? c_maxGrowableBatchBytes : maxVertices * vertexSize;
+
     // If you only intend to draw non-indexed geometry, specify maxIndices = 0 to skip creating the index buffer.
-    if (maxIndices > 0)
+    if (maxIndices > 0 || mGrowable)
     {
-        CreateBuffer(deviceX.Get(), maxIndices * sizeof(uint16_t), D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
+        CreateBuffer(deviceX.Get(), indexBufferSize, D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
     }
 
     // Create the vertex buffer.
-    CreateBuffer(deviceX.Get(), maxVertices * vertexSize, D3D11_BIND_VERTEX_BUFFER, &mVertexBuffer);
+    CreateBuffer(deviceX.Get(), vertexBufferSize, D3D11_BIND_VERTEX_BUFFER, &mVertexBuffer);
 
     grfxMemoryIB = grfxMemoryVB = nullptr;
 #else
     mDeviceContext = deviceContext;
 
+    // Growable batches upload through GraphicsMemory instead of owning buffers.
+    if (mGrowable)
+        return;
+
     // If you only intend to draw non-indexed geometry, specify maxIndices = 0 to skip creating the index buffer.
     if (maxIndices > 0)
     {
-        CreateBuffer(device.Get(), maxIndices * sizeof(uint16_t), D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
+        CreateBuffer(device.Get(), maxIndices * mIndexSize, D3D11_BIND_INDEX_BUFFER, &mIndexBuffer);
     }
 
     // Create the vertex buffer.
@@ -181,18 +405,22 @@ void PrimitiveBatchBase::Impl::Begin()
 #if defined(_XBOX_ONE) && defined(_TITLE)
     mDeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
 #else
-    // Bind the index buffer.
-    if (mMaxIndices > 0)
+    // Growable batches bind their upload range when they flush.
+    if (!mGrowable)
     {
-        mDeviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
-    }
+        // Bind the index buffer.
+        if (mMaxIndices > 0)
+        {
+            mDeviceContext->IASetIndexBuffer(mIndexBuffer.Get(), mIndexFormat, 0);
+        }
 
-    // Bind the vertex buffer.
-    auto vertexBuffer = mVertexBuffer.Get();
-    UINT vertexStride = static_cast<UINT>(mVertexSize);
-    UINT vertexOffset = 0;
+        // Bind the vertex buffer.
+        auto vertexBuffer = mVertexBuffer.Get();
+        UINT vertexStride = static_cast<UINT>(mVertexSize);
+        UINT vertexOffset = 0;
 
-    mDeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+        mDeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    }
 #endif
      
     // If this is a deferred D3D context, reset position so the first Map calls will use D3D11_MAP_WRITE_DISCARD.
@@ -212,6 +440,8 @@ void PrimitiveBatchBase::Impl::End()
     if (!mInBeginEndPair)
         throw std::exception("Begin must be called before End");
 
+    DrawSubmitted();
+
     FlushBatch();
 
     mInBeginEndPair = false;
@@ -258,12 +488,29 @@ namespace
 
 
 // Adds new geometry to the batch.
+template<typename TIndex>
 _Use_decl_annotations_
-void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, uint16_t const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, TIndex const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
 {
     if (isIndexed && !indices)
         throw std::exception("Indices cannot be null");
 
+    // 32-bit indices are narrowed on a 16-bit batch, so check they fit before anything is written.
+    if (isIndexed && sizeof(TIndex) > mIndexSize)
+    {
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            if (indices[i] > USHRT_MAX)
+                throw std::out_of_range("Index does not fit the batch's 16-bit index format");
+        }
+    }
+
+    if (mGrowable)
+    {
+        StageDraw(topology, isIndexed, indices, indexCount, vertexCount, pMappedVertices);
+        return;
+    }
+
     if (indexCount >= mMaxIndices)
         throw std::exception("Too many indices");
 
@@ -292,7 +539,7 @@ void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIn
 
         if (isIndexed)
         {
-            grfxMemoryIB = grfxMem.Allocate(mDeviceContext.Get(), mMaxIndices * sizeof(uint16_t), 64);
+            grfxMemoryIB = grfxMem.Allocate(mDeviceContext.Get(), mMaxIndices * mIndexSize, 64);
         }
 
         grfxMemoryVB = grfxMem.Allocate(mDeviceContext.Get(), mMaxVertices * mVertexSize, 64);
@@ -306,12 +553,9 @@ void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIn
     if (isIndexed)
     {
         assert(grfxMemoryIB != nullptr);
-        auto outputIndices = reinterpret_cast<uint16_t*>(grfxMemoryIB) + mCurrentIndex;
+        auto outputIndices = reinterpret_cast<uint8_t*>(grfxMemoryIB) + (mCurrentIndex * mIndexSize);
 
-        for (size_t i = 0; i < indexCount; i++)
-        {
-            outputIndices[i] = (uint16_t)(indices[i] + mCurrentVertex);
-        }
+        CopyIndices(outputIndices, mIndexSize, indices, indexCount, mCurrentVertex);
 
         mCurrentIndex += indexCount;
     }
@@ -345,13 +589,10 @@ void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIn
     // Copy over the index data.
     if (isIndexed)
     {
-        auto outputIndices = static_cast<uint16_t*>(mMappedIndices.pData) + mCurrentIndex;
-        
-        for (size_t i = 0; i < indexCount; i++)
-        {
-            outputIndices[i] = static_cast<uint16_t>(indices[i] + mCurrentVertex - mBaseVertex);
-        }
- 
+        auto outputIndices = static_cast<uint8_t*>(mMappedIndices.pData) + (mCurrentIndex * mIndexSize);
+
+        CopyIndices(outputIndices, mIndexSize, indices, indexCount, mCurrentVertex - mBaseVertex);
+
         mCurrentIndex += indexCount;
     }
 
@@ -363,6 +604,259 @@ void PrimitiveBatchBase::Impl::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIn
 }
 
 
+// Adds new geometry to a growable batch.
+template<typename TIndex>
+_Use_decl_annotations_
+void PrimitiveBatchBase::Impl::StageDraw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, TIndex const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+{
+    size_t indexBytes = indexCount * mIndexSize;
+    size_t vertexBytes = vertexCount * mVertexSize;
+
+    if (indexBytes + vertexBytes + c_growableIndexAlignment > c_maxGrowableBatchBytes)
+        throw std::exception("Too many vertices");
+
+    if (!mInBeginEndPair)
+        throw std::exception("Begin must be called before Draw");
+
+    // Flush when the batch cannot take this draw: a different topology, past the upload limit, or with 16-bit indices
+    // past the vertices they can address.
+    bool full = (AlignIndexData(mStagedVertices.size() + vertexBytes) + mStagedIndices.size() + indexBytes > c_maxGrowableBatchBytes);
+
+    if (isIndexed && mIndexSize == sizeof(uint16_t) && (mCurrentVertex + vertexCount > USHRT_MAX))
+        full = true;
+
+    if ((topology != mCurrentTopology) ||
+        (isIndexed != mCurrentlyIndexed) ||
+        !CanBatchPrimitives(topology) ||
+        full)
+    {
+        FlushBatch();
+    }
+
+    if (mCurrentTopology == D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
+    {
+        mCurrentTopology = topology;
+        mCurrentlyIndexed = isIndexed;
+        mCurrentIndex = mCurrentVertex = 0;
+
+        mStagedIndices.clear();
+        mStagedVertices.clear();
+    }
+
+    // Copy over the index data.
+    if (isIndexed)
+    {
+        size_t offset = mStagedIndices.size();
+        mStagedIndices.resize(offset + indexBytes);
+
+        CopyIndices(mStagedIndices.data() + offset, mIndexSize, indices, indexCount, mCurrentVertex);
+
+        mCurrentIndex += indexCount;
+    }
+
+    // Return the output vertex data location.
+    size_t offset = mStagedVertices.size();
+    mStagedVertices.resize(offset + vertexBytes);
+
+    *pMappedVertices = mStagedVertices.data() + offset;
+
+    mCurrentVertex += vertexCount;
+}
+
+
+// Uploads and draws a growable batch.
+void PrimitiveBatchBase::Impl::FlushStaged()
+{
+    // Vertices and indices share one allocation, so the ring cannot wrap between them.
+    size_t indexOffset = AlignIndexData(mStagedVertices.size());
+    size_t totalSize = indexOffset + mStagedIndices.size();
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    auto grfxMemory = static_cast<uint8_t*>(GraphicsMemory::Get().Allocate(mDeviceContext.Get(), totalSize, 64));
+
+    memcpy(grfxMemory, mStagedVertices.data(), mStagedVertices.size());
+
+    mDeviceContext->IASetPlacementVertexBuffer(0, mVertexBuffer.Get(), grfxMemory, static_cast<UINT>(mVertexSize));
+
+    if (mCurrentlyIndexed)
+    {
+        memcpy(grfxMemory + indexOffset, mStagedIndices.data(), mStagedIndices.size());
+
+        mDeviceContext->IASetPlacementIndexBuffer(mIndexBuffer.Get(), grfxMemory + indexOffset, mIndexFormat);
+
+        mDeviceContext->DrawIndexed(static_cast<UINT>(mCurrentIndex), 0, 0);
+    }
+    else
+    {
+        mDeviceContext->Draw(static_cast<UINT>(mCurrentVertex), 0);
+    }
+#else
+    auto& grfxMem = GraphicsMemory::Get();
+
+    ID3D11Buffer* buffer;
+    UINT offset;
+    auto mapped = static_cast<uint8_t*>(grfxMem.MapUpload(mDeviceContext.Get(), D3D11_BIND_VERTEX_BUFFER, totalSize, static_cast<int>(c_growableIndexAlignment), &buffer, &offset));
+
+    memcpy(mapped, mStagedVertices.data(), mStagedVertices.size());
+
+    if (mCurrentlyIndexed)
+    {
+        memcpy(mapped + indexOffset, mStagedIndices.data(), mStagedIndices.size());
+    }
+
+    grfxMem.UnmapUpload(mDeviceContext.Get(), D3D11_BIND_VERTEX_BUFFER);
+
+    UINT vertexStride = static_cast<UINT>(mVertexSize);
+    mDeviceContext->IASetVertexBuffers(0, 1, &buffer, &vertexStride, &offset);
+
+    if (mCurrentlyIndexed)
+    {
+        mDeviceContext->IASetIndexBuffer(buffer, mIndexFormat, offset + static_cast<UINT>(indexOffset));
+
+        mDeviceContext->DrawIndexed(static_cast<UINT>(mCurrentIndex), 0, 0);
+    }
+    else
+    {
+        mDeviceContext->Draw(static_cast<UINT>(mCurrentVertex), 0);
+    }
+#endif
+
+    mStagedIndices.clear();
+    mStagedVertices.clear();
+}
+
+
+// Queues a recorder to be merged at End.
+_Use_decl_annotations_
+void PrimitiveBatchBase::Impl::Submit(PrimitiveRecorderBase::Impl const* recorder)
+{
+    if (!mInBeginEndPair)
+        throw std::exception("Begin must be called before Submit");
+
+    if (recorder->mVertexSize != mVertexSize)
+        throw std::exception("Recorder vertex size does not match the batch");
+
+    mSubmitted.push_back(recorder);
+}
+
+
+// Largest single draw the batch accepts.
+_Use_decl_annotations_
+void PrimitiveBatchBase::Impl::GetDrawLimits(bool isIndexed, size_t* maxVertices, size_t* maxIndices) const noexcept
+{
+    if (mGrowable)
+    {
+        size_t budget = (c_maxGrowableBatchBytes - c_growableIndexAlignment) / 2;
+
+        *maxVertices = budget / mVertexSize;
+        *maxIndices = budget / mIndexSize;
+    }
+    else
+    {
+        *maxVertices = mMaxVertices - 1;
+        *maxIndices = (mMaxIndices > 0) ? mMaxIndices - 1 : 0;
+    }
+
+    if (isIndexed && mIndexSize == sizeof(uint16_t))
+    {
+        *maxVertices = std::min<size_t>(*maxVertices, USHRT_MAX);
+    }
+}
+
+
+// Draws everything submitted, stream by stream across the recorders, so each topology becomes a contiguous run of
+// geometry that the batch merges into as few draws as its buffers allow.
+void PrimitiveBatchBase::Impl::DrawSubmitted()
+{
+    if (mSubmitted.empty())
+        return;
+
+    for (size_t s = 0; s < PrimitiveRecorderBase::Impl::StreamCount; ++s)
+    {
+        auto topology = PrimitiveRecorderBase::Impl::GetStreamTopology(s);
+        size_t primitiveSize = PrimitiveRecorderBase::Impl::GetPrimitiveSize(topology);
+        bool isIndexed = (s & 1) != 0;
+
+        size_t maxVertices, maxIndices;
+        GetDrawLimits(isIndexed, &maxVertices, &maxIndices);
+
+        for (auto recorder : mSubmitted)
+        {
+            auto const& stream = recorder->mStreams[s];
+
+            auto vertices = stream.vertices.data();
+            size_t vertexCount = stream.vertices.size() / mVertexSize;
+
+            void* mappedVertices;
+
+            if (!isIndexed)
+            {
+                // Split on whole primitives.
+                size_t chunk = (maxVertices / primitiveSize) * primitiveSize;
+
+                for (size_t first = 0; first < vertexCount; first += chunk)
+                {
+                    size_t count = std::min(chunk, vertexCount - first);
+
+                    Draw(topology, false, static_cast<uint32_t const*>(nullptr), 0, count, &mappedVertices);
+
+                    memcpy(mappedVertices, vertices + first * mVertexSize, count * mVertexSize);
+                }
+            }
+            else
+            {
+                auto const& indices = stream.indices;
+
+                size_t start = 0;
+                while (start < indices.size())
+                {
+                    // Take whole primitives while the vertices they span and their indices fit in one draw.
+                    uint32_t low = indices[start];
+                    uint32_t high = low;
+
+                    size_t end = start;
+                    while (end < indices.size())
+                    {
+                        uint32_t primitiveLow = low;
+                        uint32_t primitiveHigh = high;
+
+                        for (size_t k = 0; k < primitiveSize; ++k)
+                        {
+                            primitiveLow = std::min(primitiveLow, indices[end + k]);
+                            primitiveHigh = std::max(primitiveHigh, indices[end + k]);
+                        }
+
+                        if (end > start
+                            && (size_t(primitiveHigh - primitiveLow) + 1 > maxVertices || end + primitiveSize - start > maxIndices))
+                            break;
+
+                        low = primitiveLow;
+                        high = primitiveHigh;
+                        end += primitiveSize;
+                    }
+
+                    mScratchIndices.resize(end - start);
+                    for (size_t i = start; i < end; ++i)
+                    {
+                        mScratchIndices[i - start] = indices[i] - low;
+                    }
+
+                    size_t count = size_t(high - low) + 1;
+
+                    Draw(topology, true, mScratchIndices.data(), end - start, count, &mappedVertices);
+
+                    memcpy(mappedVertices, vertices + low * mVertexSize, count * mVertexSize);
+
+                    start = end;
+                }
+            }
+        }
+    }
+
+    mSubmitted.clear();
+}
+
+
 // Sends queued primitives to the graphics device.
 void PrimitiveBatchBase::Impl::FlushBatch()
 {
@@ -372,11 +866,19 @@ void PrimitiveBatchBase::Impl::FlushBatch()
 
     mDeviceContext->IASetPrimitiveTopology(mCurrentTopology);
 
+    if (mGrowable)
+    {
+        FlushStaged();
+
+        mCurrentTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+        return;
+    }
+
 #if defined(_XBOX_ONE) && defined(_TITLE)
     if (mCurrentlyIndexed)
     {
         // Draw indexed geometry.
-        mDeviceContext->IASetPlacementIndexBuffer(mIndexBuffer.Get(), grfxMemoryIB, DXGI_FORMAT_R16_UINT);
+        mDeviceContext->IASetPlacementIndexBuffer(mIndexBuffer.Get(), grfxMemoryIB, mIndexFormat);
         mDeviceContext->IASetPlacementVertexBuffer(0, mVertexBuffer.Get(), grfxMemoryVB, (UINT)mVertexSize);
 
         mDeviceContext->DrawIndexed((UINT)mCurrentIndex, 0, 0);
@@ -414,9 +916,78 @@ void PrimitiveBatchBase::Impl::FlushBatch()
 }
 
 
+_Use_decl_annotations_
+void PrimitiveBatchBase::Submit(PrimitiveRecorderBase const& recorder)
+{
+    pImpl->Submit(recorder.pImpl.get());
+}
+
+
+//--------------------------------------------------------------------------------------
+// PrimitiveRecorder
+//--------------------------------------------------------------------------------------
+
+// Public constructor.
+PrimitiveRecorderBase::PrimitiveRecorderBase(size_t vertexSize)
+  : pImpl(std::make_unique<Impl>(vertexSize))
+{
+}
+
+
+// Move constructor.
+PrimitiveRecorderBase::PrimitiveRecorderBase(PrimitiveRecorderBase&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+PrimitiveRecorderBase& PrimitiveRecorderBase::operator= (PrimitiveRecorderBase&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+PrimitiveRecorderBase::~PrimitiveRecorderBase()
+{
+}
+
+
+void PrimitiveRecorderBase::Clear() noexcept
+{
+    pImpl->Clear();
+}
+
+
+bool PrimitiveRecorderBase::IsEmpty() const noexcept
+{
+    return pImpl->IsEmpty();
+}
+
+
+_Use_decl_annotations_
+void PrimitiveRecorderBase::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed, uint16_t const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+{
+    pImpl->Draw(topology, isIndexed, indices, indexCount, vertexCount, pMappedVertices);
+}
+
+
+_Use_decl_annotations_
+void PrimitiveRecorderBase::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, uint32_t const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+{
+    pImpl->Draw(topology, true, indices, indexCount, vertexCount, pMappedVertices);
+}
+
+
+//--------------------------------------------------------------------------------------
+// PrimitiveBatch
+//--------------------------------------------------------------------------------------
+
 // Public constructor.
-PrimitiveBatchBase::PrimitiveBatchBase(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize)
-  : pImpl(std::make_unique<Impl>(deviceContext, maxIndices, maxVertices, vertexSize))
+PrimitiveBatchBase::PrimitiveBatchBase(_In_ ID3D11DeviceContext* deviceContext, size_t maxIndices, size_t maxVertices, size_t vertexSize, uint32_t flags)
+  : pImpl(std::make_unique<Impl>(deviceContext, maxIndices, maxVertices, vertexSize, flags))
 {
 }
 
@@ -459,3 +1030,10 @@ void PrimitiveBatchBase::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, bool isIndexed,
 {
     pImpl->Draw(topology, isIndexed, indices, indexCount, vertexCount, pMappedVertices);
 }
+
+
+_Use_decl_annotations_
+void PrimitiveBatchBase::Draw(D3D11_PRIMITIVE_TOPOLOGY topology, uint32_t const* indices, size_t indexCount, size_t vertexCount, void** pMappedVertices)
+{
+    pImpl->Draw(topology, true, indices, indexCount, vertexCount, pMappedVertices);
+}
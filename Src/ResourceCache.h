@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------------------------
+// File: ResourceCache.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <wrl/client.h>
+
+
+namespace DirectX
+{
+    // Thread-safe cache of named D3D resources for the effect factories. Names are spread over a fixed set of
+    // lock stripes, so threads loading different resources rarely contend, and each lock is only held to look up
+    // or add an entry, never while a resource loads. A name that is still being loaded has an in-flight entry, and
+    // other threads asking for it wait for that load rather than starting their own.
+    template<typename T>
+    class ResourceCache
+    {
+    public:
+        ResourceCache() = default;
+
+        ResourceCache(ResourceCache const&) = delete;
+        ResourceCache& operator= (ResourceCache const&) = delete;
+
+        // Returns the cached resource, calling create to make it if this is the first request for the name. If
+        // create throws, the exception goes to every waiting caller and the name is left uncached.
+        template<typename TCreate>
+        Microsoft::WRL::ComPtr<T> GetOrCreate(_In_z_ const wchar_t* name, TCreate&& create)
+        {
+            std::wstring key(name);
+
+            auto& stripe = mStripes[std::hash<std::wstring>()(key) % StripeCount];
+
+            std::shared_ptr<Entry> entry;
+            std::promise<Microsoft::WRL::ComPtr<T>> promise;
+            bool loader = false;
+
+            {
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+
+                auto it = stripe.entries.find(key);
+                if (it != stripe.entries.end())
+                {
+                    entry = it->second;
+                }
+                else
+                {
+                    auto newEntry = std::make_shared<Entry>();
+                    newEntry->result = promise.get_future().share();
+
+                    stripe.entries.emplace(key, newEntry);
+
+                    entry = std::move(newEntry);
+                    loader = true;
+                }
+            }
+
+            if (!loader)
+            {
+                // Waits if the resource is still in flight, and rethrows if its load failed.
+                return entry->result.get();
+            }
+
+            try
+            {
+                promise.set_value(create());
+            }
+            catch (...)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+                    // ReleaseCache may have removed or replaced the entry in the meantime.
+                    auto it = stripe.entries.find(key);
+                    if (it != stripe.entries.end() && it->second == entry)
+                    {
+                        stripe.entries.erase(it);
+                    }
+                }
+
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+
+            return entry->result.get();
+        }
+
+        // Drops every entry. Loads still in flight finish for the threads waiting on them, but are not cached.
+        void Clear()
+        {
+            for (auto& stripe : mStripes)
+            {
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                stripe.entries.clear();
+            }
+        }
+
+    private:
+        static const size_t StripeCount = 16;
+
+        struct Entry
+        {
+            std::shared_future<Microsoft::WRL::ComPtr<T>> result;
+        };
+
+        struct Stripe
+        {
+            std::mutex mutex;
+            std::unordered_map<std::wstring, std::shared_ptr<Entry>> entries;
+        };
+
+        Stripe mStripes[StripeCount];
+    };
+}
@@ -169,21 +169,38 @@ namespace
 
 
 //--------------------------------------------------------------------------------------
-_Use_decl_annotations_
-HRESULT DirectX::SaveDDSTextureToFile(
-    ID3D11DeviceContext* pContext,
-    ID3D11Resource* pSource,
-    const wchar_t* fileName) noexcept
+namespace DirectX
 {
-    if (!fileName)
-        return E_INVALIDARG;
+    extern bool _IsWIC2() noexcept;
+    extern IWICImagingFactory* _GetWIC() noexcept;
+
+    // Write the top level of a captured texture from CPU memory. Also used by ScreenGrabQueue.
+    HRESULT _WriteDDSFile(
+        _In_z_ const wchar_t* fileName,
+        const D3D11_TEXTURE2D_DESC& desc,
+        _In_ const void* pixels,
+        size_t srcRowPitch) noexcept;
+
+    HRESULT _WriteWICFile(
+        _In_z_ const wchar_t* fileName,
+        const D3D11_TEXTURE2D_DESC& desc,
+        _In_ const void* pixels,
+        size_t srcRowPitch,
+        REFGUID guidContainerFormat,
+        _In_opt_ const GUID* targetFormat,
+        std::function<void(IPropertyBag2*)> const& setCustomProps,
+        bool forceSRGB) noexcept;
+}
 
-    D3D11_TEXTURE2D_DESC desc = {};
-    ComPtr<ID3D11Texture2D> pStaging;
-    HRESULT hr = CaptureTexture(pContext, pSource, desc, pStaging);
-    if (FAILED(hr))
-        return hr;
 
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::_WriteDDSFile(
+    const wchar_t* fileName,
+    const D3D11_TEXTURE2D_DESC& desc,
+    const void* pixels,
+    size_t srcRowPitch) noexcept
+{
     // Create file
 #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
     ScopedHandle hFile(safe_handle(CreateFile2(fileName, GENERIC_WRITE | DELETE, 0, CREATE_ALWAYS, nullptr)));
@@ -270,7 +287,7 @@ HRESULT DirectX::SaveDDSTextureToFile(
     }
 
     size_t rowPitch, slicePitch, rowCount;
-    hr = GetSurfaceInfo(desc.Width, desc.Height, desc.Format, &slicePitch, &rowPitch, &rowCount);
+    HRESULT hr = GetSurfaceInfo(desc.Width, desc.Height, desc.Format, &slicePitch, &rowPitch, &rowCount);
     if (FAILED(hr))
         return hr;
 
@@ -289,34 +306,21 @@ HRESULT DirectX::SaveDDSTextureToFile(
     }
 
     // Setup pixels
-    std::unique_ptr<uint8_t[]> pixels(new (std::nothrow) uint8_t[slicePitch]);
-    if (!pixels)
+    std::unique_ptr<uint8_t[]> dest(new (std::nothrow) uint8_t[slicePitch]);
+    if (!dest)
         return E_OUTOFMEMORY;
 
-    D3D11_MAPPED_SUBRESOURCE mapped;
-    hr = pContext->Map(pStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
-    if (FAILED(hr))
-        return hr;
-
-    auto sptr = static_cast<const uint8_t*>(mapped.pData);
-    if (!sptr)
-    {
-        pContext->Unmap(pStaging.Get(), 0);
-        return E_POINTER;
-    }
-
-    uint8_t* dptr = pixels.get();
+    auto sptr = static_cast<const uint8_t*>(pixels);
+    uint8_t* dptr = dest.get();
 
-    size_t msize = std::min<size_t>(rowPitch, mapped.RowPitch);
+    size_t msize = std::min<size_t>(rowPitch, srcRowPitch);
     for (size_t h = 0; h < rowCount; ++h)
     {
         memcpy_s(dptr, rowPitch, sptr, msize);
-        sptr += mapped.RowPitch;
+        sptr += srcRowPitch;
         dptr += rowPitch;
     }
 
-    pContext->Unmap(pStaging.Get(), 0);
-
     // Write header & pixels
     DWORD bytesWritten;
     if (!WriteFile(hFile.get(), fileHeader, static_cast<DWORD>(headerSize), &bytesWritten, nullptr))
@@ -325,7 +329,7 @@ HRESULT DirectX::SaveDDSTextureToFile(
     if (bytesWritten != headerSize)
         return E_FAIL;
 
-    if (!WriteFile(hFile.get(), pixels.get(), static_cast<DWORD>(slicePitch), &bytesWritten, nullptr))
+    if (!WriteFile(hFile.get(), dest.get(), static_cast<DWORD>(slicePitch), &bytesWritten, nullptr))
         return HRESULT_FROM_WIN32(GetLastError());
 
     if (bytesWritten != slicePitch)
@@ -337,31 +341,17 @@ HRESULT DirectX::SaveDDSTextureToFile(
 }
 
 //--------------------------------------------------------------------------------------
-namespace DirectX
-{
-    extern bool _IsWIC2() noexcept;
-    extern IWICImagingFactory* _GetWIC() noexcept;
-}
-
 _Use_decl_annotations_
-HRESULT DirectX::SaveWICTextureToFile(
-    ID3D11DeviceContext* pContext,
-    ID3D11Resource* pSource,
-    REFGUID guidContainerFormat,
+HRESULT DirectX::_WriteWICFile(
     const wchar_t* fileName,
+    const D3D11_TEXTURE2D_DESC& desc,
+    const void* pixels,
+    size_t srcRowPitch,
+    REFGUID guidContainerFormat,
     const GUID* targetFormat,
-    std::function<void(IPropertyBag2*)> setCustomProps,
+    std::function<void(IPropertyBag2*)> const& setCustomProps,
     bool forceSRGB) noexcept
 {
-    if (!fileName)
-        return E_INVALIDARG;
-
-    D3D11_TEXTURE2D_DESC desc = {};
-    ComPtr<ID3D11Texture2D> pStaging;
-    HRESULT hr = CaptureTexture(pContext, pSource, desc, pStaging);
-    if (FAILED(hr))
-        return hr;
-
     // Determine source format's WIC equivalent
     WICPixelFormatGUID pfGuid;
     bool sRGB = forceSRGB;
@@ -417,7 +407,7 @@ HRESULT DirectX::SaveWICTextureToFile(
         return E_NOINTERFACE;
 
     ComPtr<IWICStream> stream;
-    hr = pWIC->CreateStream(stream.GetAddressOf());
+    HRESULT hr = pWIC->CreateStream(stream.GetAddressOf());
     if (FAILED(hr))
         return hr;
 
@@ -601,31 +591,20 @@ HRESULT DirectX::SaveWICTextureToFile(
     #endif
     }
 
-    D3D11_MAPPED_SUBRESOURCE mapped;
-    hr = pContext->Map(pStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
-    if (FAILED(hr))
-        return hr;
-
     if (memcmp(&targetGuid, &pfGuid, sizeof(WICPixelFormatGUID)) != 0)
     {
         // Conversion required to write
         ComPtr<IWICBitmap> source;
         hr = pWIC->CreateBitmapFromMemory(desc.Width, desc.Height, pfGuid,
-            mapped.RowPitch, mapped.RowPitch * desc.Height,
-            static_cast<BYTE*>(mapped.pData), source.GetAddressOf());
+            static_cast<UINT>(srcRowPitch), static_cast<UINT>(srcRowPitch * desc.Height),
+            static_cast<BYTE*>(const_cast<void*>(pixels)), source.GetAddressOf());
         if (FAILED(hr))
-        {
-            pContext->Unmap(pStaging.Get(), 0);
             return hr;
-        }
 
         ComPtr<IWICFormatConverter> FC;
         hr = pWIC->CreateFormatConverter(FC.GetAddressOf());
         if (FAILED(hr))
-        {
-            pContext->Unmap(pStaging.Get(), 0);
             return hr;
-        }
 
         BOOL canConvert = FALSE;
         hr = FC->CanConvert(pfGuid, targetGuid, &canConvert);
@@ -636,29 +615,21 @@ HRESULT DirectX::SaveWICTextureToFile(
 
         hr = FC->Initialize(source.Get(), targetGuid, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeMedianCut);
         if (FAILED(hr))
-        {
-            pContext->Unmap(pStaging.Get(), 0);
             return hr;
-        }
 
         WICRect rect = { 0, 0, static_cast<INT>(desc.Width), static_cast<INT>(desc.Height) };
         hr = frame->WriteSource(FC.Get(), &rect);
         if (FAILED(hr))
-        {
-            pContext->Unmap(pStaging.Get(), 0);
             return hr;
-        }
     }
     else
     {
         // No conversion required
-        hr = frame->WritePixels(desc.Height, mapped.RowPitch, mapped.RowPitch * desc.Height, static_cast<BYTE*>(mapped.pData));
+        hr = frame->WritePixels(desc.Height, static_cast<UINT>(srcRowPitch), static_cast<UINT>(srcRowPitch * desc.Height), static_cast<BYTE*>(const_cast<void*>(pixels)));
         if (FAILED(hr))
             return hr;
     }
 
-    pContext->Unmap(pStaging.Get(), 0);
-
     hr = frame->Commit();
     if (FAILED(hr))
         return hr;
@@ -671,3 +642,70 @@ HRESULT DirectX::SaveWICTextureToFile(
 
     return S_OK;
 }
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::SaveDDSTextureToFile(
+    ID3D11DeviceContext* pContext,
+    ID3D11Resource* pSource,
+    const wchar_t* fileName) noexcept
+{
+    if (!fileName)
+        return E_INVALIDARG;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    ComPtr<ID3D11Texture2D> pStaging;
+    HRESULT hr = CaptureTexture(pContext, pSource, desc, pStaging);
+    if (FAILED(hr))
+        return hr;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = pContext->Map(pStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+        return hr;
+
+    if (!mapped.pData)
+    {
+        pContext->Unmap(pStaging.Get(), 0);
+        return E_POINTER;
+    }
+
+    hr = _WriteDDSFile(fileName, desc, mapped.pData, mapped.RowPitch);
+
+    pContext->Unmap(pStaging.Get(), 0);
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::SaveWICTextureToFile(
+    ID3D11DeviceContext* pContext,
+    ID3D11Resource* pSource,
+    REFGUID guidContainerFormat,
+    const wchar_t* fileName,
+    const GUID* targetFormat,
+    std::function<void(IPropertyBag2*)> setCustomProps,
+    bool forceSRGB) noexcept
+{
+    if (!fileName)
+        return E_INVALIDARG;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    ComPtr<ID3D11Texture2D> pStaging;
+    HRESULT hr = CaptureTexture(pContext, pSource, desc, pStaging);
+    if (FAILED(hr))
+        return hr;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = pContext->Map(pStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+        return hr;
+
+    hr = _WriteWICFile(fileName, desc, mapped.pData, mapped.RowPitch,
+        guidContainerFormat, targetFormat, setCustomProps, forceSRGB);
+
+    pContext->Unmap(pStaging.Get(), 0);
+
+    return hr;
+}
@@ -0,0 +1,620 @@
+//--------------------------------------------------------------------------------------
+// File: ScreenGrabQueue.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ScreenGrabQueue.h"
+
+#include "DirectXHelpers.h"
+#include "LoaderHelpers.h"
+#include "PlatformHelpers.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace DirectX
+{
+    // Implemented in ScreenGrab.cpp
+    HRESULT _WriteDDSFile(
+        _In_z_ const wchar_t* fileName,
+        const D3D11_TEXTURE2D_DESC& desc,
+        _In_ const void* pixels,
+        size_t srcRowPitch) noexcept;
+
+    HRESULT _WriteWICFile(
+        _In_z_ const wchar_t* fileName,
+        const D3D11_TEXTURE2D_DESC& desc,
+        _In_ const void* pixels,
+        size_t srcRowPitch,
+        REFGUID guidContainerFormat,
+        _In_opt_ const GUID* targetFormat,
+        std::function<void(IPropertyBag2*)> const& setCustomProps,
+        bool forceSRGB) noexcept;
+}
+
+namespace
+{
+    enum CaptureKind
+    {
+        CAPTURE_DDS,
+        CAPTURE_WIC,
+        CAPTURE_CALLBACK,
+    };
+
+    enum SlotState
+    {
+        SLOT_FREE,
+        SLOT_COPYING,   // Waiting for the GPU copy to the staging texture.
+        SLOT_WRITING,   // Copied out to memory, queued for or being handled by the worker.
+    };
+}
+
+
+// Internal ScreenGrabQueue implementation class.
+class ScreenGrabQueue::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t ringSize)
+        : mSlots(ringSize),
+        mNextFrame(0),
+        mDropped(0),
+        mExit(false)
+    {
+        if (!device)
+            throw std::exception("Device cannot be null");
+
+        if (!ringSize)
+            throw std::out_of_range("Ring size must be at least 1");
+
+        mDevice = device;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        if (device->GetCreationFlags() & D3D11_CREATE_DEVICE_IMMEDIATE_CONTEXT_FAST_SEMANTICS)
+        {
+            ThrowIfFailed(device->QueryInterface(IID_GRAPHICS_PPV_ARGS(mDeviceX.GetAddressOf())));
+        }
+#endif
+
+        mWorker = std::thread([this]() noexcept { WorkerMain(); });
+    }
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mExit = true;
+        }
+
+        mCondition.notify_all();
+        mWorker.join();
+    }
+
+    // Describes what to do with a capture once it has been read back.
+    struct Job
+    {
+        CaptureKind kind;
+        const wchar_t* fileName;
+        const GUID* guidContainerFormat;
+        const GUID* targetFormat;
+        bool forceSRGB;
+        Callback* callback;
+    };
+
+    bool Capture(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source, Job const& job);
+
+    void Update(_In_ ID3D11DeviceContext* context, bool wait);
+
+    void Flush(_In_ ID3D11DeviceContext* context)
+    {
+        Update(context, true);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() noexcept
+        {
+            return std::all_of(mSlots.cbegin(), mSlots.cend(), [](Slot const& slot) noexcept { return slot.state == SLOT_FREE; });
+        });
+    }
+
+    size_t GetPendingCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        return static_cast<size_t>(std::count_if(mSlots.cbegin(), mSlots.cend(), [](Slot const& slot) noexcept { return slot.state != SLOT_FREE; }));
+    }
+
+    uint64_t GetDroppedCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDropped;
+    }
+
+    size_t GetRingSize() const noexcept
+    {
+        return mSlots.size();
+    }
+
+private:
+    struct Slot
+    {
+        Slot() noexcept :
+            state(SLOT_FREE),
+            desc{},
+            pixelsSize(0),
+            rowPitch(0),
+            kind(CAPTURE_DDS),
+            guidContainerFormat{},
+            targetFormat{},
+            hasTargetFormat(false),
+            forceSRGB(false),
+            frameNumber(0)
+        #if defined(_XBOX_ONE) && defined(_TITLE)
+            , fence(0)
+        #endif
+        {
+        }
+
+        SlotState state;
+
+        // Reused while the captured size and format stay the same.
+        ComPtr<ID3D11Texture2D> staging;
+        ComPtr<ID3D11Texture2D> resolve;
+        D3D11_TEXTURE2D_DESC desc;
+
+        std::unique_ptr<uint8_t[]> pixels;
+        size_t pixelsSize;
+        size_t rowPitch;
+
+        CaptureKind kind;
+        std::wstring fileName;
+        GUID guidContainerFormat;
+        GUID targetFormat;
+        bool hasTargetFormat;
+        bool forceSRGB;
+        Callback callback;
+        uint64_t frameNumber;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        UINT64 fence;
+    #endif
+    };
+
+    void CopyToStaging(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source, Slot& slot);
+
+    void WorkerMain() noexcept;
+    static void Write(Slot& slot) noexcept;
+
+    ComPtr<ID3D11Device> mDevice;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    ComPtr<ID3D11DeviceX> mDeviceX;
+#endif
+
+    std::vector<Slot> mSlots;
+
+    // Slots copying on the GPU, oldest first. Only touched by the thread that owns the context.
+    std::deque<size_t> mCopying;
+
+    // Slots read back and waiting for the worker, oldest first.
+    std::deque<size_t> mReady;
+
+    uint64_t mNextFrame;
+    uint64_t mDropped;
+    bool mExit;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mWorker;
+};
+
+
+_Use_decl_annotations_
+bool ScreenGrabQueue::Impl::Capture(ID3D11DeviceContext* context, ID3D11Resource* source, Job const& job)
+{
+    if (!context || !source)
+        throw std::exception("Context and source cannot be null");
+
+    size_t index = mSlots.size();
+    uint64_t frameNumber;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        frameNumber = mNextFrame++;
+
+        for (size_t j = 0; j < mSlots.size(); ++j)
+        {
+            if (mSlots[j].state == SLOT_FREE)
+            {
+                index = j;
+                break;
+            }
+        }
+
+        if (index == mSlots.size())
+        {
+            ++mDropped;
+            return false;
+        }
+    }
+
+    // The slot is free, so the worker will not touch it until it is queued as ready.
+    auto& slot = mSlots[index];
+
+    CopyToStaging(context, source, slot);
+
+    slot.kind = job.kind;
+    slot.fileName = (job.fileName) ? job.fileName : L"";
+    slot.guidContainerFormat = (job.guidContainerFormat) ? *job.guidContainerFormat : GUID{};
+    slot.hasTargetFormat = (job.targetFormat != nullptr);
+    slot.targetFormat = (job.targetFormat) ? *job.targetFormat : GUID{};
+    slot.forceSRGB = job.forceSRGB;
+    slot.callback = (job.callback) ? std::move(*job.callback) : nullptr;
+    slot.frameNumber = frameNumber;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        slot.state = SLOT_COPYING;
+    }
+
+    mCopying.push_back(index);
+
+    return true;
+}
+
+
+// Copies the top level of the source into the slot's staging texture, resolving MSAA content first.
+_Use_decl_annotations_
+void ScreenGrabQueue::Impl::CopyToStaging(ID3D11DeviceContext* context, ID3D11Resource* source, Slot& slot)
+{
+    D3D11_RESOURCE_DIMENSION resType = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    source->GetType(&resType);
+
+    if (resType != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+    {
+        DebugTrace("ERROR: ScreenGrabQueue does not support 1D or volume textures.\n");
+        throw std::exception("ScreenGrabQueue");
+    }
+
+    ComPtr<ID3D11Texture2D> texture;
+    ThrowIfFailed(source->QueryInterface(IID_GRAPHICS_PPV_ARGS(texture.GetAddressOf())));
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+
+    bool msaa = desc.SampleDesc.Count > 1;
+
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.BindFlags = 0;
+    desc.MiscFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.Usage = D3D11_USAGE_STAGING;
+
+    if (!slot.staging || memcmp(&desc, &slot.desc, sizeof(desc)) != 0)
+    {
+        slot.resolve.Reset();
+        slot.staging.Reset();
+
+        ThrowIfFailed(mDevice->CreateTexture2D(&desc, nullptr, slot.staging.GetAddressOf()));
+
+        SetDebugObjectName(slot.staging.Get(), "ScreenGrabQueue");
+
+        slot.desc = desc;
+    }
+
+    if (msaa)
+    {
+        DXGI_FORMAT fmt = EnsureNotTypeless(desc.Format);
+
+        if (!slot.resolve)
+        {
+            UINT support = 0;
+            ThrowIfFailed(mDevice->CheckFormatSupport(fmt, &support));
+
+            if (!(support & D3D11_FORMAT_SUPPORT_MULTISAMPLE_RESOLVE))
+                throw std::exception("ScreenGrabQueue cannot resolve this format");
+
+            D3D11_TEXTURE2D_DESC resolveDesc = desc;
+            resolveDesc.CPUAccessFlags = 0;
+            resolveDesc.Usage = D3D11_USAGE_DEFAULT;
+
+            ThrowIfFailed(mDevice->CreateTexture2D(&resolveDesc, nullptr, slot.resolve.GetAddressOf()));
+
+            SetDebugObjectName(slot.resolve.Get(), "ScreenGrabQueue");
+        }
+
+        context->ResolveSubresource(slot.resolve.Get(), 0, source, 0, fmt);
+        context->CopySubresourceRegion(slot.staging.Get(), 0, 0, 0, 0, slot.resolve.Get(), 0, nullptr);
+    }
+    else
+    {
+        context->CopySubresourceRegion(slot.staging.Get(), 0, 0, 0, 0, source, 0, nullptr);
+    }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    slot.fence = 0;
+
+    if (mDeviceX)
+    {
+        ComPtr<ID3D11DeviceContextX> contextX;
+        ThrowIfFailed(context->QueryInterface(IID_GRAPHICS_PPV_ARGS(contextX.GetAddressOf())));
+
+        slot.fence = contextX->InsertFence(0);
+    }
+#endif
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabQueue::Impl::Update(ID3D11DeviceContext* context, bool wait)
+{
+    if (!context)
+        throw std::exception("Context cannot be null");
+
+    // Captures are read back in order, so a callback never sees frames out of sequence.
+    while (!mCopying.empty())
+    {
+        size_t index = mCopying.front();
+        auto& slot = mSlots[index];
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        if (slot.fence)
+        {
+            while (mDeviceX->IsFencePending(slot.fence))
+            {
+                if (!wait)
+                    return;
+
+                SwitchToThread();
+            }
+        }
+    #endif
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = context->Map(slot.staging.Get(), 0, D3D11_MAP_READ, (wait) ? 0u : static_cast<UINT>(D3D11_MAP_FLAG_DO_NOT_WAIT), &mapped);
+        if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+            return;
+
+        mCopying.pop_front();
+
+        SlotState nextState = SLOT_FREE;
+
+        if (SUCCEEDED(hr))
+        {
+            size_t rowCount;
+            hr = LoaderHelpers::GetSurfaceInfo(slot.desc.Width, slot.desc.Height, slot.desc.Format, nullptr, nullptr, &rowCount);
+
+            size_t size = size_t(mapped.RowPitch) * rowCount;
+            if (SUCCEEDED(hr) && size > slot.pixelsSize)
+            {
+                slot.pixels.reset(new (std::nothrow) uint8_t[size]);
+                slot.pixelsSize = (slot.pixels) ? size : 0;
+                if (!slot.pixels)
+                    hr = E_OUTOFMEMORY;
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                memcpy(slot.pixels.get(), mapped.pData, size);
+                slot.rowPitch = mapped.RowPitch;
+                nextState = SLOT_WRITING;
+            }
+
+            context->Unmap(slot.staging.Get(), 0);
+        }
+
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: ScreenGrabQueue failed (%08X) to read back frame %llu\n", static_cast<unsigned int>(hr), slot.frameNumber);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            slot.state = nextState;
+
+            if (nextState == SLOT_WRITING)
+            {
+                mReady.push_back(index);
+            }
+            else
+            {
+                ++mDropped;
+                slot.callback = nullptr;
+            }
+        }
+
+        mCondition.notify_all();
+    }
+}
+
+
+void ScreenGrabQueue::Impl::WorkerMain() noexcept
+{
+    // WIC encoders need COM on this thread.
+    HRESULT hrCOM = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    for (;;)
+    {
+        size_t index;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() noexcept { return mExit || !mReady.empty(); });
+
+            // Anything already read back is still written before exiting.
+            if (mReady.empty())
+                break;
+
+            index = mReady.front();
+            mReady.pop_front();
+        }
+
+        auto& slot = mSlots[index];
+
+        Write(slot);
+
+        slot.callback = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            slot.state = SLOT_FREE;
+        }
+
+        mCondition.notify_all();
+    }
+
+    if (SUCCEEDED(hrCOM))
+    {
+        CoUninitialize();
+    }
+}
+
+
+void ScreenGrabQueue::Impl::Write(Slot& slot) noexcept
+{
+    HRESULT hr = S_OK;
+
+    switch (slot.kind)
+    {
+        case CAPTURE_DDS:
+            hr = _WriteDDSFile(slot.fileName.c_str(), slot.desc, slot.pixels.get(), slot.rowPitch);
+            break;
+
+        case CAPTURE_WIC:
+            hr = _WriteWICFile(slot.fileName.c_str(), slot.desc, slot.pixels.get(), slot.rowPitch,
+                slot.guidContainerFormat, (slot.hasTargetFormat) ? &slot.targetFormat : nullptr, nullptr, slot.forceSRGB);
+            break;
+
+        case CAPTURE_CALLBACK:
+            {
+                Frame frame = {};
+                frame.frameNumber = slot.frameNumber;
+                frame.format = slot.desc.Format;
+                frame.width = slot.desc.Width;
+                frame.height = slot.desc.Height;
+                frame.rowPitch = slot.rowPitch;
+                frame.pixels = slot.pixels.get();
+
+                slot.callback(frame);
+            }
+            break;
+    }
+
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: ScreenGrabQueue failed (%08X) to write '%ls'\n", static_cast<unsigned int>(hr), slot.fileName.c_str());
+    }
+}
+
+
+// Public constructor.
+ScreenGrabQueue::ScreenGrabQueue(_In_ ID3D11Device* device, size_t ringSize)
+    : pImpl(std::make_unique<Impl>(device, ringSize))
+{
+}
+
+
+// Move constructor.
+ScreenGrabQueue::ScreenGrabQueue(ScreenGrabQueue&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ScreenGrabQueue& ScreenGrabQueue::operator= (ScreenGrabQueue&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ScreenGrabQueue::~ScreenGrabQueue()
+{
+}
+
+
+_Use_decl_annotations_
+bool ScreenGrabQueue::CaptureDDS(ID3D11DeviceContext* context, ID3D11Resource* source, const wchar_t* fileName)
+{
+    if (!fileName)
+        throw std::exception("File name cannot be null");
+
+    Impl::Job job = { CAPTURE_DDS, fileName, nullptr, nullptr, false, nullptr };
+
+    return pImpl->Capture(context, source, job);
+}
+
+
+_Use_decl_annotations_
+bool ScreenGrabQueue::CaptureWIC(ID3D11DeviceContext* context, ID3D11Resource* source,
+                                 REFGUID guidContainerFormat, const wchar_t* fileName,
+                                 const GUID* targetFormat, bool forceSRGB)
+{
+    if (!fileName)
+        throw std::exception("File name cannot be null");
+
+    Impl::Job job = { CAPTURE_WIC, fileName, &guidContainerFormat, targetFormat, forceSRGB, nullptr };
+
+    return pImpl->Capture(context, source, job);
+}
+
+
+_Use_decl_annotations_
+bool ScreenGrabQueue::Capture(ID3D11DeviceContext* context, ID3D11Resource* source, Callback callback)
+{
+    if (!callback)
+        throw std::exception("Callback cannot be null");
+
+    Impl::Job job = { CAPTURE_CALLBACK, nullptr, nullptr, nullptr, false, &callback };
+
+    return pImpl->Capture(context, source, job);
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabQueue::Update(ID3D11DeviceContext* context)
+{
+    pImpl->Update(context, false);
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabQueue::Flush(ID3D11DeviceContext* context)
+{
+    pImpl->Flush(context);
+}
+
+
+size_t ScreenGrabQueue::GetPendingCount() const noexcept
+{
+    return pImpl->GetPendingCount();
+}
+
+
+uint64_t ScreenGrabQueue::GetDroppedCount() const noexcept
+{
+    return pImpl->GetDroppedCount();
+}
+
+
+size_t ScreenGrabQueue::GetRingSize() const noexcept
+{
+    return pImpl->GetRingSize();
+}
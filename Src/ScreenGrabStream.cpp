@@ -0,0 +1,800 @@
+//--------------------------------------------------------------------------------------
+// File: ScreenGrabStream.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ScreenGrabStream.h"
+
+#include "DirectXHelpers.h"
+#include "LoaderHelpers.h"
+#include "PlatformHelpers.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    #include "Shaders/Compiled/XboxOneScreenGrabStream_CSConvertNV12.inc"
+#else
+    #include "Shaders/Compiled/ScreenGrabStream_CSConvertNV12.inc"
+#endif
+
+    const char c_frameTag[] = "FRAME\n";
+
+    // Must match the Parameters cbuffer in ScreenGrabStream.fx.
+    XM_ALIGNED_STRUCT(16) ConvertParameters
+    {
+        UINT width;
+        UINT height;
+        UINT pitch;
+        UINT linearSource;
+    };
+
+    static_assert((sizeof(ConvertParameters) % 16) == 0, "CB size not padded correctly");
+
+    enum SlotState
+    {
+        SLOT_FREE,
+        SLOT_CONVERTING,    // Waiting for the GPU to convert and copy the frame.
+        SLOT_MAPPED,        // Mapped, queued for or being written by the worker.
+        SLOT_DONE,          // Written, waiting to be unmapped by the thread that owns the context.
+    };
+
+    // Formats whose views return linear values rather than the gamma encoded values video expects.
+    bool IsLinear(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            case DXGI_FORMAT_R32G32B32_FLOAT:
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            case DXGI_FORMAT_R11G11B10_FLOAT:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+}
+
+
+// Internal ScreenGrabStream implementation class.
+class ScreenGrabStream::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, _In_z_ const wchar_t* fileName, UINT width, UINT height,
+         Container container, UINT frameRate, size_t ringSize);
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mExit = true;
+        }
+
+        mCondition.notify_all();
+        mWorker.join();
+    }
+
+    bool AddFrame(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source);
+
+    void Update(_In_ ID3D11DeviceContext* context, bool wait);
+
+    void Flush(_In_ ID3D11DeviceContext* context)
+    {
+        Update(context, true);
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() noexcept
+            {
+                return std::none_of(mSlots.cbegin(), mSlots.cend(), [](Slot const& slot) noexcept { return slot.state == SLOT_MAPPED; });
+            });
+        }
+
+        Update(context, false);
+    }
+
+    void Close(_In_ ID3D11DeviceContext* context)
+    {
+        if (!mFile)
+            return;
+
+        Flush(context);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFile.reset();
+    }
+
+    uint64_t GetFrameCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mFrames;
+    }
+
+    uint64_t GetDroppedCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDropped;
+    }
+
+    size_t GetPendingCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        return static_cast<size_t>(std::count_if(mSlots.cbegin(), mSlots.cend(), [](Slot const& slot) noexcept { return slot.state != SLOT_FREE; }));
+    }
+
+private:
+    struct Slot
+    {
+        Slot() noexcept :
+            state(SLOT_FREE),
+            data(nullptr)
+        #if defined(_XBOX_ONE) && defined(_TITLE)
+            , fence(0)
+        #endif
+        {
+        }
+
+        SlotState state;
+        ComPtr<ID3D11Buffer> staging;
+
+        // Set while mapped; the worker reads the frame from here without copying it out first.
+        const uint8_t* data;
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        UINT64 fence;
+    #endif
+    };
+
+    ID3D11ShaderResourceView* GetSourceView(_In_ ID3D11DeviceContext* context, _In_ ID3D11Resource* source, _Out_ bool* linear);
+
+    void WorkerMain() noexcept;
+    HRESULT Write(_In_ const uint8_t* data) noexcept;
+
+    ComPtr<ID3D11Device> mDevice;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    ComPtr<ID3D11DeviceX> mDeviceX;
+#endif
+
+    ComPtr<ID3D11ComputeShader> mConvert;
+    ComPtr<ID3D11Buffer> mParameters[2];
+    ComPtr<ID3D11Buffer> mOutput;
+    ComPtr<ID3D11UnorderedAccessView> mOutputUAV;
+
+    // The view of the last source, plus a copy target for sources that cannot be read directly.
+    ComPtr<ID3D11Resource> mSource;
+    ComPtr<ID3D11ShaderResourceView> mSourceSRV;
+    bool mSourceLinear;
+    ComPtr<ID3D11Texture2D> mIntermediate;
+    bool mSourceResolve;
+    DXGI_FORMAT mSourceFormat;
+
+    Container mContainer;
+    UINT mWidth;
+    UINT mHeight;
+    UINT mPitch;
+    size_t mFrameBytes;
+
+    ScopedHandle mFile;
+
+    // The packed frame, only touched by the worker.
+    std::unique_ptr<uint8_t[]> mPacked;
+    size_t mPackedSize;
+
+    std::vector<Slot> mSlots;
+
+    // Slots converting on the GPU, oldest first. Only touched by the thread that owns the context.
+    std::deque<size_t> mConverting;
+
+    // Slots mapped and waiting for the worker, oldest first.
+    std::deque<size_t> mReady;
+
+    uint64_t mFrames;
+    uint64_t mDropped;
+    bool mExit;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mWorker;
+};
+
+
+_Use_decl_annotations_
+ScreenGrabStream::Impl::Impl(ID3D11Device* device, const wchar_t* fileName, UINT width, UINT height,
+                             Container container, UINT frameRate, size_t ringSize)
+    : mSourceLinear(false),
+    mSourceResolve(false),
+    mSourceFormat(DXGI_FORMAT_UNKNOWN),
+    mContainer(container),
+    mWidth(width),
+    mHeight(height),
+    mPitch((width + 3u) & ~3u),
+    mFrameBytes(0),
+    mPackedSize(0),
+    mSlots(ringSize),
+    mFrames(0),
+    mDropped(0),
+    mExit(false)
+{
+    if (!device)
+        throw std::exception("Device cannot be null");
+
+    if (!fileName)
+        throw std::exception("File name cannot be null");
+
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+    {
+        DebugTrace("ERROR: ScreenGrabStream requires Feature Level 11.0 or later\n");
+        throw std::exception("ScreenGrabStream");
+    }
+
+    if (!width || !height || (width & 1) || (height & 1) || width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION || height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+        throw std::out_of_range("Width and height must be even and within the texture size limit");
+
+    if (!frameRate)
+        throw std::out_of_range("Frame rate must be at least 1");
+
+    if (!ringSize)
+        throw std::out_of_range("Ring size must be at least 1");
+
+    if (container != Y4M && container != RawNV12)
+        throw std::out_of_range("Unknown container");
+
+    mDevice = device;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    if (device->GetCreationFlags() & D3D11_CREATE_DEVICE_IMMEDIATE_CONTEXT_FAST_SEMANTICS)
+    {
+        ThrowIfFailed(device->QueryInterface(IID_GRAPHICS_PPV_ARGS(mDeviceX.GetAddressOf())));
+    }
+#endif
+
+    // Luma rows followed by half as many interleaved chroma rows, both with the same 4 byte aligned pitch.
+    mFrameBytes = size_t(mPitch) * height + size_t(mPitch) * (height / 2);
+
+    ThrowIfFailed(device->CreateComputeShader(ScreenGrabStream_CSConvertNV12, sizeof(ScreenGrabStream_CSConvertNV12), nullptr, mConvert.GetAddressOf()));
+
+    SetDebugObjectName(mConvert.Get(), "ScreenGrabStream");
+
+    for (UINT j = 0; j < 2; ++j)
+    {
+        ConvertParameters parameters = { width, height, mPitch, j };
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = sizeof(ConvertParameters);
+        desc.Usage = D3D11_USAGE_IMMUTABLE;
+        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA initData = { &parameters, 0, 0 };
+
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, mParameters[j].GetAddressOf()));
+
+        SetDebugObjectName(mParameters[j].Get(), "ScreenGrabStream");
+    }
+
+    {
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = static_cast<UINT>(mFrameBytes);
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+        desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+        ThrowIfFailed(device->CreateBuffer(&desc, nullptr, mOutput.GetAddressOf()));
+
+        SetDebugObjectName(mOutput.Get(), "ScreenGrabStream");
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+        uavDesc.Buffer.NumElements = static_cast<UINT>(mFrameBytes / 4);
+        uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+
+        ThrowIfFailed(device->CreateUnorderedAccessView(mOutput.Get(), &uavDesc, mOutputUAV.GetAddressOf()));
+
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.MiscFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        for (auto& slot : mSlots)
+        {
+            ThrowIfFailed(device->CreateBuffer(&desc, nullptr, slot.staging.GetAddressOf()));
+
+            SetDebugObjectName(slot.staging.Get(), "ScreenGrabStream");
+        }
+    }
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    mFile.reset(safe_handle(CreateFile2(fileName, GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr)));
+#else
+    mFile.reset(safe_handle(CreateFileW(fileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)));
+#endif
+    if (!mFile)
+    {
+        DebugTrace("ERROR: ScreenGrabStream failed to create '%ls'\n", fileName);
+        throw std::exception("CreateFile");
+    }
+
+    if (container == Y4M)
+    {
+        char header[128] = {};
+        int length = sprintf_s(header, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420mpeg2\n", width, height, frameRate);
+        if (length <= 0)
+            throw std::exception("sprintf_s");
+
+        DWORD bytesWritten;
+        if (!WriteFile(mFile.get(), header, static_cast<DWORD>(length), &bytesWritten, nullptr)
+            || bytesWritten != static_cast<DWORD>(length))
+        {
+            throw std::exception("WriteFile");
+        }
+    }
+
+    mWorker = std::thread([this]() noexcept { WorkerMain(); });
+}
+
+
+_Use_decl_annotations_
+bool ScreenGrabStream::Impl::AddFrame(ID3D11DeviceContext* context, ID3D11Resource* source)
+{
+    if (!context || !source)
+        throw std::exception("Context and source cannot be null");
+
+    if (!mFile)
+        throw std::exception("ScreenGrabStream has been closed");
+
+    // Recycle what the worker has finished with before looking for a buffer.
+    Update(context, false);
+
+    size_t index = mSlots.size();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (size_t j = 0; j < mSlots.size(); ++j)
+        {
+            if (mSlots[j].state == SLOT_FREE)
+            {
+                index = j;
+                break;
+            }
+        }
+
+        if (index == mSlots.size())
+        {
+            ++mDropped;
+            return false;
+        }
+    }
+
+    auto& slot = mSlots[index];
+
+    bool linear;
+    ID3D11ShaderResourceView* srv = GetSourceView(context, source, &linear);
+
+    ID3D11Buffer* parameters = mParameters[linear ? 1 : 0].Get();
+    ID3D11UnorderedAccessView* uav = mOutputUAV.Get();
+
+    context->CSSetShader(mConvert.Get(), nullptr, 0);
+    context->CSSetConstantBuffers(0, 1, &parameters);
+    context->CSSetShaderResources(0, 1, &srv);
+    context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+    // Each thread packs a 4 x 2 block of pixels.
+    context->Dispatch((mPitch / 4 + 7) / 8, (mHeight / 2 + 7) / 8, 1);
+
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    context->CSSetShaderResources(0, 1, &nullSRV);
+    context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+
+    context->CopyResource(slot.staging.Get(), mOutput.Get());
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    slot.fence = 0;
+
+    if (mDeviceX)
+    {
+        ComPtr<ID3D11DeviceContextX> contextX;
+        ThrowIfFailed(context->QueryInterface(IID_GRAPHICS_PPV_ARGS(contextX.GetAddressOf())));
+
+        slot.fence = contextX->InsertFence(0);
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        slot.state = SLOT_CONVERTING;
+    }
+
+    mConverting.push_back(index);
+
+    return true;
+}
+
+
+// Returns a view of the top level of source, resolving or copying it first if it cannot be bound directly.
+_Use_decl_annotations_
+ID3D11ShaderResourceView* ScreenGrabStream::Impl::GetSourceView(ID3D11DeviceContext* context, ID3D11Resource* source, bool* linear)
+{
+    *linear = mSourceLinear;
+
+    if (mSource.Get() == source)
+    {
+        if (mIntermediate)
+        {
+            if (mSourceResolve)
+                context->ResolveSubresource(mIntermediate.Get(), 0, source, 0, mSourceFormat);
+            else
+                context->CopySubresourceRegion(mIntermediate.Get(), 0, 0, 0, 0, source, 0, nullptr);
+        }
+
+        return mSourceSRV.Get();
+    }
+
+    D3D11_RESOURCE_DIMENSION resType = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    source->GetType(&resType);
+
+    if (resType != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+    {
+        DebugTrace("ERROR: ScreenGrabStream does not support 1D or volume textures.\n");
+        throw std::exception("ScreenGrabStream");
+    }
+
+    ComPtr<ID3D11Texture2D> texture;
+    ThrowIfFailed(source->QueryInterface(IID_GRAPHICS_PPV_ARGS(texture.GetAddressOf())));
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+
+    if (desc.Width != mWidth || desc.Height != mHeight)
+        throw std::exception("Frame size does not match the stream");
+
+    DXGI_FORMAT fmt = EnsureNotTypeless(desc.Format);
+
+    mSource.Reset();
+    mSourceSRV.Reset();
+
+    bool resolve = desc.SampleDesc.Count > 1;
+
+    if (resolve || !(desc.BindFlags & D3D11_BIND_SHADER_RESOURCE))
+    {
+        D3D11_TEXTURE2D_DESC intermediateDesc = desc;
+        intermediateDesc.MipLevels = 1;
+        intermediateDesc.ArraySize = 1;
+        intermediateDesc.SampleDesc.Count = 1;
+        intermediateDesc.SampleDesc.Quality = 0;
+        intermediateDesc.Usage = D3D11_USAGE_DEFAULT;
+        intermediateDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        intermediateDesc.CPUAccessFlags = 0;
+        intermediateDesc.MiscFlags = 0;
+
+        D3D11_TEXTURE2D_DESC current = {};
+        if (mIntermediate)
+        {
+            mIntermediate->GetDesc(&current);
+        }
+
+        if (!mIntermediate || memcmp(&current, &intermediateDesc, sizeof(current)) != 0)
+        {
+            mIntermediate.Reset();
+
+            if (resolve)
+            {
+                UINT support = 0;
+                ThrowIfFailed(mDevice->CheckFormatSupport(fmt, &support));
+
+                if (!(support & D3D11_FORMAT_SUPPORT_MULTISAMPLE_RESOLVE))
+                    throw std::exception("ScreenGrabStream cannot resolve this format");
+            }
+
+            ThrowIfFailed(mDevice->CreateTexture2D(&intermediateDesc, nullptr, mIntermediate.GetAddressOf()));
+
+            SetDebugObjectName(mIntermediate.Get(), "ScreenGrabStream");
+        }
+
+        if (resolve)
+            context->ResolveSubresource(mIntermediate.Get(), 0, source, 0, fmt);
+        else
+            context->CopySubresourceRegion(mIntermediate.Get(), 0, 0, 0, 0, source, 0, nullptr);
+
+        texture = mIntermediate;
+    }
+    else
+    {
+        mIntermediate.Reset();
+    }
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURE2D, fmt, 0, 1);
+    ThrowIfFailed(mDevice->CreateShaderResourceView(texture.Get(), &srvDesc, mSourceSRV.GetAddressOf()));
+
+    mSource = source;
+    mSourceResolve = resolve;
+    mSourceFormat = fmt;
+    mSourceLinear = IsLinear(fmt);
+
+    *linear = mSourceLinear;
+
+    return mSourceSRV.Get();
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabStream::Impl::Update(ID3D11DeviceContext* context, bool wait)
+{
+    if (!context)
+        throw std::exception("Context cannot be null");
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (auto& slot : mSlots)
+        {
+            if (slot.state == SLOT_DONE)
+            {
+                context->Unmap(slot.staging.Get(), 0);
+                slot.data = nullptr;
+                slot.state = SLOT_FREE;
+            }
+        }
+    }
+
+    // Frames are mapped in order, so the worker writes them in sequence.
+    while (!mConverting.empty())
+    {
+        size_t index = mConverting.front();
+        auto& slot = mSlots[index];
+
+    #if defined(_XBOX_ONE) && defined(_TITLE)
+        if (slot.fence)
+        {
+            while (mDeviceX->IsFencePending(slot.fence))
+            {
+                if (!wait)
+                    return;
+
+                SwitchToThread();
+            }
+        }
+    #endif
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = context->Map(slot.staging.Get(), 0, D3D11_MAP_READ, (wait) ? 0u : static_cast<UINT>(D3D11_MAP_FLAG_DO_NOT_WAIT), &mapped);
+        if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+            return;
+
+        mConverting.pop_front();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (SUCCEEDED(hr))
+            {
+                slot.data = static_cast<const uint8_t*>(mapped.pData);
+                slot.state = SLOT_MAPPED;
+                mReady.push_back(index);
+            }
+            else
+            {
+                DebugTrace("ERROR: ScreenGrabStream failed (%08X) to read back a frame\n", static_cast<unsigned int>(hr));
+                slot.state = SLOT_FREE;
+                ++mDropped;
+            }
+        }
+
+        mCondition.notify_all();
+    }
+}
+
+
+void ScreenGrabStream::Impl::WorkerMain() noexcept
+{
+    for (;;)
+    {
+        size_t index;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() noexcept { return mExit || !mReady.empty(); });
+
+            // Anything already mapped is still written before exiting.
+            if (mReady.empty())
+                break;
+
+            index = mReady.front();
+            mReady.pop_front();
+        }
+
+        auto& slot = mSlots[index];
+
+        HRESULT hr = Write(slot.data);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: ScreenGrabStream failed (%08X) to write a frame\n", static_cast<unsigned int>(hr));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            slot.state = SLOT_DONE;
+
+            if (SUCCEEDED(hr))
+                ++mFrames;
+            else
+                ++mDropped;
+        }
+
+        mCondition.notify_all();
+    }
+}
+
+
+// Packs one NV12 frame for the container and writes it with a single call.
+_Use_decl_annotations_
+HRESULT ScreenGrabStream::Impl::Write(const uint8_t* data) noexcept
+{
+    const size_t lumaBytes = size_t(mWidth) * mHeight;
+    const size_t tagBytes = (mContainer == Y4M) ? (sizeof(c_frameTag) - 1) : 0;
+    const size_t frameBytes = tagBytes + lumaBytes + lumaBytes / 2;
+
+    const uint8_t* pFrame = data;
+
+    // Raw NV12 without row padding is already in file order.
+    if (mContainer != RawNV12 || mPitch != mWidth)
+    {
+        if (!mPacked || mPackedSize < frameBytes)
+        {
+            mPacked.reset(new (std::nothrow) uint8_t[frameBytes]);
+            mPackedSize = (mPacked) ? frameBytes : 0;
+            if (!mPacked)
+                return E_OUTOFMEMORY;
+        }
+
+        uint8_t* dest = mPacked.get();
+
+        memcpy(dest, c_frameTag, tagBytes);
+        dest += tagBytes;
+
+        const uint8_t* sptr = data;
+        for (size_t y = 0; y < mHeight; ++y)
+        {
+            memcpy(dest, sptr, mWidth);
+            dest += mWidth;
+            sptr += mPitch;
+        }
+
+        if (mContainer == Y4M)
+        {
+            // Y4M stores the chroma planes separately.
+            const size_t chromaWidth = mWidth / 2;
+            uint8_t* uptr = dest;
+            uint8_t* vptr = dest + chromaWidth * (mHeight / 2);
+
+            for (size_t y = 0; y < mHeight / 2; ++y)
+            {
+                for (size_t x = 0; x < chromaWidth; ++x)
+                {
+                    *uptr++ = sptr[x * 2];
+                    *vptr++ = sptr[x * 2 + 1];
+                }
+
+                sptr += mPitch;
+            }
+        }
+        else
+        {
+            for (size_t y = 0; y < mHeight / 2; ++y)
+            {
+                memcpy(dest, sptr, mWidth);
+                dest += mWidth;
+                sptr += mPitch;
+            }
+        }
+
+        pFrame = mPacked.get();
+    }
+
+    DWORD bytesWritten;
+    if (!WriteFile(mFile.get(), pFrame, static_cast<DWORD>(frameBytes), &bytesWritten, nullptr))
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    if (bytesWritten != frameBytes)
+        return E_FAIL;
+
+    return S_OK;
+}
+
+
+// Public constructor.
+_Use_decl_annotations_
+ScreenGrabStream::ScreenGrabStream(ID3D11Device* device, const wchar_t* fileName, UINT width, UINT height,
+                                   Container container, UINT frameRate, size_t ringSize)
+    : pImpl(std::make_unique<Impl>(device, fileName, width, height, container, frameRate, ringSize))
+{
+}
+
+
+// Move constructor.
+ScreenGrabStream::ScreenGrabStream(ScreenGrabStream&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+ScreenGrabStream& ScreenGrabStream::operator= (ScreenGrabStream&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+ScreenGrabStream::~ScreenGrabStream()
+{
+}
+
+
+_Use_decl_annotations_
+bool ScreenGrabStream::AddFrame(ID3D11DeviceContext* context, ID3D11Resource* source)
+{
+    return pImpl->AddFrame(context, source);
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabStream::Update(ID3D11DeviceContext* context)
+{
+    pImpl->Update(context, false);
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabStream::Flush(ID3D11DeviceContext* context)
+{
+    pImpl->Flush(context);
+}
+
+
+_Use_decl_annotations_
+void ScreenGrabStream::Close(ID3D11DeviceContext* context)
+{
+    pImpl->Close(context);
+}
+
+
+uint64_t ScreenGrabStream::GetFrameCount() const noexcept
+{
+    return pImpl->GetFrameCount();
+}
+
+
+uint64_t ScreenGrabStream::GetDroppedCount() const noexcept
+{
+    return pImpl->GetDroppedCount();
+}
+
+
+size_t ScreenGrabStream::GetPendingCount() const noexcept
+{
+    return pImpl->GetPendingCount();
+}
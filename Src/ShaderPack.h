@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------------------
+// File: ShaderPack.h
+//
+// The shader pack file holds the built-in effect shaders outside the library, for builds
+// with DIRECTX_TOOLKIT_SHADER_PACK. Each shader is keyed by the name of the array that
+// CompileShaders.cmd generates for it, such as BasicEffect_VSBasic. The shaderpack tool
+// builds the file from the .cso outputs of CompileShaders.cmd.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+
+namespace ShaderPack
+{
+    const uint32_t MAGIC = 0x50535844; // "DXSP"
+    const uint32_t VERSION = 1;
+
+    const size_t MAX_NAME_LENGTH = 64;
+
+    // Bytecode is aligned to this within the file.
+    const uint32_t DATA_ALIGNMENT = 16;
+
+#pragma pack(push,1)
+
+    struct header_t
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numEntries;
+        uint32_t reserved;
+    };
+
+    // Follows the header, sorted by name with strcmp so shaders can be found with a binary search.
+    struct entry_t
+    {
+        char     name[MAX_NAME_LENGTH];     // Null terminated
+        uint32_t offset;                    // From the start of the file
+        uint32_t size;
+    };
+
+#pragma pack(pop)
+
+} // namespace
+
+static_assert(sizeof(ShaderPack::header_t) == 16, "Shader pack header size mismatch");
+static_assert(sizeof(ShaderPack::entry_t) == 72, "Shader pack entry size mismatch");
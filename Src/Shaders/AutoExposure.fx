@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Auto-exposure for ToneMapPostProcess: a luminance histogram of the HDR source, reduced to an exposure that
+// adapts over time. The result is laid out like the ToneMap.fx constants, so it is copied straight into them.
+
+static const uint HISTOGRAM_BINS = 256;
+
+Texture2D<float4> HDRTexture : register(t0);
+
+RWByteAddressBuffer Histogram : register(u0);
+RWByteAddressBuffer Exposure : register(u1);    // linearExposure, paperWhiteNits, adapted luminance, unused
+
+
+cbuffer Parameters : register(b0)
+{
+    float minLogLuminance;
+    float inverseLogLuminanceRange;
+    float logLuminanceRange;
+    float adaptation;               // 1 - exp(-elapsedTime * rate), or 1 to jump straight to the target.
+    float exposureCompensation;
+    float paperWhiteNits;
+    float targetLuminance;
+};
+
+
+groupshared uint HistogramShared[HISTOGRAM_BINS];
+groupshared float WeightShared[HISTOGRAM_BINS];
+
+
+// Bin 0 holds black pixels, which are left out of the average.
+uint LuminanceBin(float3 color)
+{
+    float luminance = dot(color, float3(0.2126, 0.7152, 0.0722));
+
+    if (luminance < 0.0001)
+        return 0;
+
+    float logLuminance = saturate((log2(luminance) - minLogLuminance) * inverseLogLuminanceRange);
+    return uint(logLuminance * 254.0 + 1.0);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: accumulate the histogram, per group first to keep global atomics to one per bin.
+[numthreads(16, 16, 1)]
+void CSHistogram(uint3 id : SV_DispatchThreadID, uint gi : SV_GroupIndex)
+{
+    HistogramShared[gi] = 0;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 size;
+    HDRTexture.GetDimensions(size.x, size.y);
+
+    if (all(id.xy < size))
+    {
+        uint bin = LuminanceBin(HDRTexture.Load(int3(id.xy, 0)).rgb);
+        InterlockedAdd(HistogramShared[bin], 1);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (HistogramShared[gi])
+    {
+        Histogram.InterlockedAdd(gi * 4, HistogramShared[gi]);
+    }
+}
+
+
+// Compute shader: average the histogram, adapt toward it, and clear it for the next frame. One group.
+[numthreads(HISTOGRAM_BINS, 1, 1)]
+void CSAdaptExposure(uint gi : SV_GroupIndex)
+{
+    uint count = Histogram.Load(gi * 4);
+    Histogram.Store(gi * 4, 0);
+
+    // Weighted sum of bin indices, excluding the black bin.
+    WeightShared[gi] = (gi > 0) ? float(count) * float(gi) : 0;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = HISTOGRAM_BINS / 2; stride > 0; stride >>= 1)
+    {
+        if (gi < stride)
+        {
+            WeightShared[gi] += WeightShared[gi + stride];
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (gi == 0)
+    {
+        // The first thread's count is the black pixels, so it can tell how many were lit.
+        uint2 size;
+        HDRTexture.GetDimensions(size.x, size.y);
+
+        float lit = max(float(size.x * size.y) - float(count), 1.0);
+        float averageBin = WeightShared[0] / lit;
+
+        float averageLogLuminance = (averageBin - 1.0) / 254.0 * logLuminanceRange + minLogLuminance;
+        float averageLuminance = exp2(averageLogLuminance);
+
+        float previous = asfloat(Exposure.Load(8));
+        float adapted = (previous > 0.0) ? lerp(previous, averageLuminance, adaptation) : averageLuminance;
+
+        float linearExposure = targetLuminance / max(adapted, 0.0001) * exposureCompensation;
+
+        Exposure.Store4(0, asuint(float4(linearExposure, paperWhiteNits, adapted, 0)));
+    }
+}
@@ -34,6 +34,7 @@ cbuffer Parameters : register(b0)
 #include "Structures.fxh"
 #include "Common.fxh"
 #include "Lighting.fxh"
+#include "MultiView.fxh"
 #include "Utilities.fxh"
 
 
@@ -487,6 +488,285 @@ VSOutputPixelLightingTx VSBasicPixelLightingTxVcBn(VSInputNmTxVc vin)
 }
 
 
+// Vertex shader: pixel lighting (instancing).
+VSOutputPixelLighting VSBasicPixelLightingInst(VSInputNmInst vin)
+{
+    VSOutputPixelLighting vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+
+    return vout;
+}
+
+VSOutputPixelLighting VSBasicPixelLightingInstBn(VSInputNmInst vin)
+{
+    VSOutputPixelLighting vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + vertex color (instancing).
+VSOutputPixelLighting VSBasicPixelLightingVcInst(VSInputNmVcInst vin)
+{
+    VSOutputPixelLighting vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+
+    return vout;
+}
+
+VSOutputPixelLighting VSBasicPixelLightingVcInstBn(VSInputNmVcInst vin)
+{
+    VSOutputPixelLighting vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + texture (instancing).
+VSOutputPixelLightingTx VSBasicPixelLightingTxInst(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSBasicPixelLightingTxInstBn(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + texture + vertex color (instancing).
+VSOutputPixelLightingTx VSBasicPixelLightingTxVcInst(VSInputNmTxVcInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSBasicPixelLightingTxVcInstBn(VSInputNmTxVcInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+// Vertex shader: pixel lighting (multi-view).
+VSOutputPixelLightingMultiView VSBasicPixelLightingMultiView(VSInputNm vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingMultiView vout;
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, vin.Normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+
+    return vout;
+}
+
+VSOutputPixelLightingMultiView VSBasicPixelLightingMultiViewBn(VSInputNm vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingMultiView vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + vertex color (multi-view).
+VSOutputPixelLightingMultiView VSBasicPixelLightingVcMultiView(VSInputNmVc vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingMultiView vout;
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, vin.Normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+
+    return vout;
+}
+
+VSOutputPixelLightingMultiView VSBasicPixelLightingVcMultiViewBn(VSInputNmVc vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingMultiView vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + texture (multi-view).
+VSOutputPixelLightingTxMultiView VSBasicPixelLightingTxMultiView(VSInputNmTx vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingTxMultiView vout;
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, vin.Normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTxMultiView VSBasicPixelLightingTxMultiViewBn(VSInputNmTx vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingTxMultiView vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + texture + vertex color (multi-view).
+VSOutputPixelLightingTxMultiView VSBasicPixelLightingTxVcMultiView(VSInputNmTxVc vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingTxMultiView vout;
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, vin.Normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTxMultiView VSBasicPixelLightingTxVcMultiViewBn(VSInputNmTxVc vin, uint instanceID : SV_InstanceID)
+{
+    VSOutputPixelLightingTxMultiView vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    ApplyMultiView(cout, instanceID, vout.ClipDistances);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
 // Pixel shader: basic.
 float4 PSBasic(PSInput pin) : SV_Target0
 {
@@ -605,3 +885,140 @@ float4 PSBasicPixelLightingTx(PSInputPixelLightingTx pin) : SV_Target0
 
     return color;
 }
+
+
+#if __SHADER_TARGET_MAJOR >= 5
+
+#include "ClusteredLighting.fxh"
+
+// Adds the clustered point and spot lights to the directional lights.
+void AddClusteredLights(inout ColorPair lightResult, float4 positionPS, float3 positionWS, float3 eyeVector, float3 worldNormal)
+{
+    float3 diffuse, specular;
+    ComputeClusteredLights(positionPS, positionWS, eyeVector, worldNormal, SpecularPower, diffuse, specular);
+
+    lightResult.Diffuse += diffuse * DiffuseColor.rgb;
+    lightResult.Specular += specular * SpecularColor;
+}
+
+
+// Pixel shader: pixel lighting + clustered lights.
+float4 PSBasicPixelLightingClustered(VSOutputPixelLighting pin) : SV_Target0
+{
+    float4 color = pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLights(eyeVector, worldNormal, 3);
+    AddClusteredLights(lightResult, pin.PositionPS, pin.PositionWS.xyz, eyeVector, worldNormal);
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + clustered lights.
+float4 PSBasicPixelLightingTxClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLights(eyeVector, worldNormal, 3);
+    AddClusteredLights(lightResult, pin.PositionPS, pin.PositionWS.xyz, eyeVector, worldNormal);
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+
+#include "Shadows.fxh"
+
+// Pixel shader: pixel lighting + shadows.
+float4 PSBasicPixelLightingShadow(PSInputPixelLighting pin) : SV_Target0
+{
+    float4 color = pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, worldNormal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + shadows.
+float4 PSBasicPixelLightingTxShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, worldNormal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + clustered lights + shadows.
+float4 PSBasicPixelLightingClusteredShadow(VSOutputPixelLighting pin) : SV_Target0
+{
+    float4 color = pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, worldNormal, 3, ComputeShadow(pin.PositionWS.xyz));
+    AddClusteredLights(lightResult, pin.PositionPS, pin.PositionWS.xyz, eyeVector, worldNormal);
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + clustered lights + shadows.
+float4 PSBasicPixelLightingTxClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+    float3 worldNormal = normalize(pin.NormalWS);
+
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, worldNormal, 3, ComputeShadow(pin.PositionWS.xyz));
+    AddClusteredLights(lightResult, pin.PositionPS, pin.PositionWS.xyz, eyeVector, worldNormal);
+
+    color.rgb *= lightResult.Diffuse;
+
+    AddSpecular(color, lightResult.Specular);
+    ApplyFog(color, pin.PositionWS.w);
+
+    return color;
+}
+
+#endif
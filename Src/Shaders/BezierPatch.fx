@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// GPU tessellation for BezierPatchMesh. Each patch is sixteen control points in rows of four, with u running along a
+// row and v from row to row, as in Bezier.h. The hull shader picks each edge's factor from the distance of its
+// midpoint to the eye, and the domain shader evaluates the bicubic patch into the vertex that BasicEffect's
+// per pixel lighting shader reads, so the constant buffer keeps BasicEffect's layout.
+
+
+cbuffer Parameters : register(b0)
+{
+    float4 DiffuseColor             : packoffset(c0);
+    float3 EmissiveColor            : packoffset(c1);
+    float3 SpecularColor            : packoffset(c2);
+    float  SpecularPower            : packoffset(c2.w);
+
+    float3 LightDirection[3]        : packoffset(c3);
+    float3 LightDiffuseColor[3]     : packoffset(c6);
+    float3 LightSpecularColor[3]    : packoffset(c9);
+
+    float3 EyePosition              : packoffset(c12);
+
+    float3 FogColor                 : packoffset(c13);
+    float4 FogVector                : packoffset(c14);
+
+    float4x4 World                  : packoffset(c15);
+    float3x3 WorldInverseTranspose  : packoffset(c19);
+    float4x4 WorldViewProj          : packoffset(c22);
+
+    float4 TessellationRange        : packoffset(c26);  // near distance, far distance, near factor, far factor
+    float  NormalSign               : packoffset(c27);
+};
+
+
+#include "Structures.fxh"
+
+
+struct ControlPoint
+{
+    float3 Position : POSITION;
+};
+
+struct PatchConstants
+{
+    float Edges[4]  : SV_TessFactor;
+    float Inside[2] : SV_InsideTessFactor;
+};
+
+
+ControlPoint VSControlPoint(float4 position : SV_Position)
+{
+    ControlPoint cp;
+    cp.Position = position.xyz;
+    return cp;
+}
+
+
+// Depends only on the two end points, so neighboring patches agree on the factor for an edge they share.
+float EdgeFactor(float3 a, float3 b)
+{
+    float3 midpoint = mul(float4((a + b) * 0.5, 1), World).xyz;
+
+    float range = max(TessellationRange.y - TessellationRange.x, 1e-5);
+    float t = saturate((distance(midpoint, EyePosition) - TessellationRange.x) / range);
+
+    return lerp(TessellationRange.z, TessellationRange.w, t);
+}
+
+
+PatchConstants HSPatchConstants(InputPatch<ControlPoint, 16> patch)
+{
+    PatchConstants pc;
+
+    pc.Edges[0] = EdgeFactor(patch[0].Position, patch[12].Position);    // u = 0
+    pc.Edges[1] = EdgeFactor(patch[0].Position, patch[3].Position);     // v = 0
+    pc.Edges[2] = EdgeFactor(patch[3].Position, patch[15].Position);    // u = 1
+    pc.Edges[3] = EdgeFactor(patch[12].Position, patch[15].Position);   // v = 1
+
+    pc.Inside[0] = max(pc.Edges[1], pc.Edges[3]);
+    pc.Inside[1] = max(pc.Edges[0], pc.Edges[2]);
+
+    return pc;
+}
+
+
+[domain("quad")]
+[partitioning("fractional_odd")]
+[outputtopology("triangle_cw")]
+[outputcontrolpoints(16)]
+[patchconstantfunc("HSPatchConstants")]
+[maxtessfactor(64.0)]
+ControlPoint HSBezier(InputPatch<ControlPoint, 16> patch, uint i : SV_OutputControlPointID)
+{
+    return patch[i];
+}
+
+
+float4 BernsteinBasis(float t)
+{
+    float s = 1 - t;
+
+    return float4(s * s * s, 3 * t * s * s, 3 * t * t * s, t * t * t);
+}
+
+float4 BernsteinDerivative(float t)
+{
+    float s = 1 - t;
+
+    return float4(-3 * s * s, 3 * s * s - 6 * t * s, 6 * t * s - 3 * t * t, 3 * t * t);
+}
+
+
+[domain("quad")]
+VSOutputPixelLightingTx DSBezier(PatchConstants pc, float2 uv : SV_DomainLocation, const OutputPatch<ControlPoint, 16> patch)
+{
+    float4 bu = BernsteinBasis(uv.x);
+    float4 bv = BernsteinBasis(uv.y);
+    float4 du = BernsteinDerivative(uv.x);
+    float4 dv = BernsteinDerivative(uv.y);
+
+    float3 position = 0;
+    float3 tangentU = 0;
+    float3 tangentV = 0;
+
+    [unroll]
+    for (uint row = 0; row < 4; row++)
+    {
+        // This row evaluated at u, and its derivative along u.
+        float3 p = 0;
+        float3 pu = 0;
+
+        [unroll]
+        for (uint col = 0; col < 4; col++)
+        {
+            p += patch[row * 4 + col].Position * bu[col];
+            pu += patch[row * 4 + col].Position * du[col];
+        }
+
+        position += p * bv[row];
+        tangentU += pu * bv[row];
+        tangentV += p * dv[row];
+    }
+
+    float3 normal = cross(tangentV, tangentU);
+
+    // Degenerate corners, such as the top and bottom of the teapot, point straight up or down as in Bezier.h.
+    if (all(abs(normal) <= 1.192092896e-7))
+    {
+        normal = float3(0, (position.y < 0) ? -1 : 1, 0);
+    }
+    else
+    {
+        normal = normalize(normal) * NormalSign;
+    }
+
+    float4 pos = float4(position, 1);
+
+    VSOutputPixelLightingTx vout;
+
+    vout.PositionPS = mul(pos, WorldViewProj);
+    vout.PositionWS = float4(mul(pos, World).xyz, 0);
+    vout.NormalWS = normalize(mul(normal, WorldInverseTranspose));
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = uv;
+
+    return vout;
+}
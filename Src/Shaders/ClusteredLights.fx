@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Light binning for ClusteredLights. One group per cluster tests every light's bounding sphere against the
+// cluster's view-space box, and writes up to CLUSTER_MAX_LIGHTS indices into the cluster's slot of the index list.
+
+#define CLUSTER_BUILD
+#include "ClusteredLighting.fxh"
+
+static const uint GROUP_SIZE = 64;
+
+RWStructuredBuffer<uint> OutputCounts  : register(u0);
+RWStructuredBuffer<uint> OutputIndices : register(u1);
+
+groupshared uint ClusterCount;
+
+
+// View-space direction through a point on the screen, scaled to unit depth.
+float3 GetScreenRay(float2 ndc)
+{
+    float4 p = mul(float4(ndc, 0.5, 1), ClusterInvProjection);
+
+    return p.xyz / p.z;
+}
+
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSBuildClusters(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    if (groupIndex == 0)
+        ClusterCount = 0;
+
+    // Box around the froxel: the tile's corner rays cut at the slice's near and far depths.
+    float2 tileMin = float2(groupId.xy) / float2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    float2 tileMax = float2(groupId.xy + 1) / float2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+
+    float3 ray0 = GetScreenRay(float2(tileMin.x * 2 - 1, 1 - tileMin.y * 2));
+    float3 ray1 = GetScreenRay(float2(tileMax.x * 2 - 1, 1 - tileMin.y * 2));
+    float3 ray2 = GetScreenRay(float2(tileMin.x * 2 - 1, 1 - tileMax.y * 2));
+    float3 ray3 = GetScreenRay(float2(tileMax.x * 2 - 1, 1 - tileMax.y * 2));
+
+    float depthRatio = ClusterFar / ClusterNear;
+    float nearDepth = ClusterNear * pow(depthRatio, float(groupId.z) / CLUSTER_SLICES);
+    float farDepth = ClusterNear * pow(depthRatio, float(groupId.z + 1) / CLUSTER_SLICES);
+
+    // Pixels beyond the far depth all fall in the last slice.
+    if (groupId.z == CLUSTER_SLICES - 1)
+        farDepth = 1e30;
+
+    float3 rayMin = min(min(ray0, ray1), min(ray2, ray3));
+    float3 rayMax = max(max(ray0, ray1), max(ray2, ray3));
+
+    float3 boxMin = min(rayMin * nearDepth, rayMin * farDepth);
+    float3 boxMax = max(rayMax * nearDepth, rayMax * farDepth);
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint cluster = GetClusterIndex(groupId);
+
+    for (uint i = groupIndex; i < ClusterLightCount; i += GROUP_SIZE)
+    {
+        ClusterLight light = ClusterLights[i];
+
+        float3 center = mul(float4(light.Position, 1), ClusterView).xyz;
+        float3 offset = center - clamp(center, boxMin, boxMax);
+
+        if (dot(offset, offset) <= light.Range * light.Range)
+        {
+            uint slot;
+            InterlockedAdd(ClusterCount, 1, slot);
+
+            if (slot < CLUSTER_MAX_LIGHTS)
+                OutputIndices[cluster * CLUSTER_MAX_LIGHTS + slot] = i;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupIndex == 0)
+        OutputCounts[cluster] = min(ClusterCount, CLUSTER_MAX_LIGHTS);
+}
@@ -87,6 +87,24 @@ call :CompileShader%1 BasicEffect vs VSBasicPixelLightingTxBn
 call :CompileShader%1 BasicEffect vs VSBasicPixelLightingTxVc
 call :CompileShader%1 BasicEffect vs VSBasicPixelLightingTxVcBn
 
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingInst
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingInstBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingVcInst
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingVcInstBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxInst
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxInstBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxVcInst
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxVcInstBn
+
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingMultiView
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingMultiViewBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingVcMultiView
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingVcMultiViewBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxMultiView
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxMultiViewBn
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxVcMultiView
+call :CompileShaderSM4%1 BasicEffect vs VSBasicPixelLightingTxVcMultiViewBn
+
 call :CompileShader%1 BasicEffect ps PSBasic
 call :CompileShader%1 BasicEffect ps PSBasicNoFog
 call :CompileShader%1 BasicEffect ps PSBasicTx
@@ -100,6 +118,14 @@ call :CompileShader%1 BasicEffect ps PSBasicVertexLightingTxNoFog
 call :CompileShader%1 BasicEffect ps PSBasicPixelLighting
 call :CompileShader%1 BasicEffect ps PSBasicPixelLightingTx
 
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingClustered
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingTxClustered
+
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingShadow
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingTxShadow
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingClusteredShadow
+call :CompileShaderSM5%1 BasicEffect ps PSBasicPixelLightingTxClusteredShadow
+
 call :CompileShader%1 DualTextureEffect vs VSDualTexture
 call :CompileShader%1 DualTextureEffect vs VSDualTextureNoFog
 call :CompileShader%1 DualTextureEffect vs VSDualTextureVc
@@ -153,20 +179,67 @@ call :CompileShader%1 SkinnedEffect ps PSSkinnedVertexLighting
 call :CompileShader%1 SkinnedEffect ps PSSkinnedVertexLightingNoFog
 call :CompileShader%1 SkinnedEffect ps PSSkinnedPixelLighting
 
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingOneBonePalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingOneBonePaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingTwoBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingTwoBonesPaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingFourBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedVertexLightingFourBonesPaletteBn
+
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightOneBonePalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightOneBonePaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightTwoBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightTwoBonesPaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightFourBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedOneLightFourBonesPaletteBn
+
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingOneBonePalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingOneBonePaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingTwoBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingTwoBonesPaletteBn
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingFourBonesPalette
+call :CompileShaderSM4%1 SkinnedEffect vs VSSkinnedPixelLightingFourBonesPaletteBn
+
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTx
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxBn
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxVc
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxVcBn
+call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxInst
+call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxInstBn
+call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxVcInst
+call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxVcInstBn
 
 call :CompileShaderSM4%1 NormalMapEffect ps PSNormalPixelLightingTx
 call :CompileShaderSM4%1 NormalMapEffect ps PSNormalPixelLightingTxNoFog
 call :CompileShaderSM4%1 NormalMapEffect ps PSNormalPixelLightingTxNoSpec
 call :CompileShaderSM4%1 NormalMapEffect ps PSNormalPixelLightingTxNoFogSpec
 
+call :CompileShaderSM4%1 NormalMapEffect vs VSDepthOnlyTx
+call :CompileShaderSM4%1 NormalMapEffect vs VSDepthOnlyTxVc
+call :CompileShaderSM4%1 NormalMapEffect vs VSDepthOnlyTxInst
+call :CompileShaderSM4%1 NormalMapEffect vs VSDepthOnlyTxVcInst
+call :CompileShaderSM4%1 NormalMapEffect vs VSVelocityOnlyTx
+call :CompileShaderSM4%1 NormalMapEffect vs VSVelocityOnlyTxVc
+call :CompileShaderSM4%1 NormalMapEffect vs VSVelocityOnlyTxInst
+call :CompileShaderSM4%1 NormalMapEffect vs VSVelocityOnlyTxVcInst
+call :CompileShaderSM4%1 NormalMapEffect ps PSVelocityOnly
+
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxClustered
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxNoSpecClustered
+
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxShadow
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxNoSpecShadow
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxClusteredShadow
+call :CompileShaderSM5%1 NormalMapEffect ps PSNormalPixelLightingTxNoSpecClusteredShadow
+
 call :CompileShaderSM4%1 PBREffect vs VSConstant
 call :CompileShaderSM4%1 PBREffect vs VSConstantVelocity
 call :CompileShaderSM4%1 PBREffect vs VSConstantBn
 call :CompileShaderSM4%1 PBREffect vs VSConstantVelocityBn
+call :CompileShaderSM4%1 PBREffect vs VSConstantInst
+call :CompileShaderSM4%1 PBREffect vs VSConstantVelocityInst
+call :CompileShaderSM4%1 PBREffect vs VSConstantInstBn
+call :CompileShaderSM4%1 PBREffect vs VSConstantVelocityInstBn
 
 call :CompileShaderSM4%1 PBREffect ps PSConstant
 call :CompileShaderSM4%1 PBREffect ps PSTextured
@@ -174,6 +247,23 @@ call :CompileShaderSM4%1 PBREffect ps PSTexturedEmissive
 call :CompileShaderSM4%1 PBREffect ps PSTexturedVelocity
 call :CompileShaderSM4%1 PBREffect ps PSTexturedEmissiveVelocity
 
+call :CompileShaderSM4%1 PBREffect vs VSDepthOnly
+call :CompileShaderSM4%1 PBREffect vs VSVelocityOnly
+call :CompileShaderSM4%1 PBREffect vs VSDepthOnlyInst
+call :CompileShaderSM4%1 PBREffect vs VSVelocityOnlyInst
+call :CompileShaderSM4%1 PBREffect ps PSVelocityOnly
+
+call :CompileShaderSM5%1 PBREffect ps PSConstantClustered
+call :CompileShaderSM5%1 PBREffect ps PSTexturedClustered
+call :CompileShaderSM5%1 PBREffect ps PSTexturedEmissiveClustered
+
+call :CompileShaderSM5%1 PBREffect ps PSConstantShadow
+call :CompileShaderSM5%1 PBREffect ps PSTexturedShadow
+call :CompileShaderSM5%1 PBREffect ps PSTexturedEmissiveShadow
+call :CompileShaderSM5%1 PBREffect ps PSConstantClusteredShadow
+call :CompileShaderSM5%1 PBREffect ps PSTexturedClusteredShadow
+call :CompileShaderSM5%1 PBREffect ps PSTexturedEmissiveClusteredShadow
+
 call :CompileShaderSM4%1 DebugEffect vs VSDebug
 call :CompileShaderSM4%1 DebugEffect vs VSDebugBn
 call :CompileShaderSM4%1 DebugEffect vs VSDebugVc
@@ -186,6 +276,12 @@ call :CompileShaderSM4%1 DebugEffect ps PSRGBBiTangents
 
 call :CompileShader%1 SpriteEffect vs SpriteVertexShader
 call :CompileShader%1 SpriteEffect ps SpritePixelShader
+call :CompileShaderSM4%1 SpriteEffect vs SpriteInstancedVertexShader
+call :CompileShaderSM4%1 SpriteEffect vs SpriteArrayVertexShader
+call :CompileShaderSM4%1 SpriteEffect ps SpriteArrayPixelShader
+call :CompileShaderSM4%1 SpriteEffect vs SpriteMultiViewVertexShader
+call :CompileShaderSM4%1 SpriteEffect ps SpriteDistanceFieldPixelShader
+call :CompileShaderSM4%1 SpriteEffect ps SpriteMultiChannelDistanceFieldPixelShader
 
 call :CompileShader%1 DGSLEffect vs main
 call :CompileShader%1 DGSLEffect vs mainVc
@@ -235,6 +331,36 @@ call :CompileShaderSM4%1 ToneMap ps PSReinhard_SRGB
 call :CompileShaderSM4%1 ToneMap ps PSACESFilmic_SRGB
 call :CompileShaderSM4%1 ToneMap ps PSHDR10
 
+call :CompileShaderSM5%1 PostProcessCompute cs CSDownScale2x2
+call :CompileShaderSM5%1 PostProcessCompute cs CSDownScale4x4
+call :CompileShaderSM5%1 PostProcessCompute cs CSGaussianBlur5x5
+call :CompileShaderSM5%1 PostProcessCompute cs CSBloomBlur
+
+call :CompileShaderSM5%1 AutoExposure cs CSHistogram
+call :CompileShaderSM5%1 AutoExposure cs CSAdaptExposure
+
+call :CompileShaderSM5%1 ScreenGrabStream cs CSConvertNV12
+
+call :CompileShaderSM5%1 ParticleSystem cs CSInitDeadList
+call :CompileShaderSM5%1 ParticleSystem cs CSEmit
+call :CompileShaderSM5%1 ParticleSystem cs CSPrepareSimulate
+call :CompileShaderSM5%1 ParticleSystem cs CSSimulate
+call :CompileShaderSM5%1 ParticleSystem vs VSParticle
+
+call :CompileShaderSM5%1 ComputeSkinning cs CSSkin
+
+call :CompileShaderSM5%1 ClusteredLights cs CSBuildClusters
+
+call :CompileShaderSM5%1 BezierPatch vs VSControlPoint
+call :CompileShaderSM5%1 BezierPatch hs HSBezier
+call :CompileShaderSM5%1 BezierPatch ds DSBezier
+
+call :CompileShaderSM5%1 IndirectModelScene cs CSCull
+
+call :CompileShaderSM5%1 IBLBaker cs CSCopySource
+call :CompileShaderSM5%1 IBLBaker cs CSPrefilterSpecular
+call :CompileShaderSM5%1 IBLBaker cs CSIrradiance
+
 if NOT %1.==xbox. goto skipxboxonly
 
 call :CompileShaderSM4xbox ToneMap ps PSHDR10_Saturate
@@ -254,25 +380,31 @@ if %error% == 0 (
     echo There were shader compilation errors!
 )
 
-endlocal
-exit /b
+endlocal & exit /b %error%
 
 :CompileShader
-set fxc=%PCFXC% %1.fx %FXCOPTS% /T%2_4_0_level_9_1 /E%3 /FhCompiled\%1_%3.inc /FdCompiled\%1_%3.pdb /Vn%1_%3
+set fxc=%PCFXC% %1.fx %FXCOPTS% /T%2_4_0_level_9_1 /E%3 /FhCompiled\%1_%3.inc /FoCompiled\%1_%3.cso /FdCompiled\%1_%3.pdb /Vn%1_%3
 echo.
 echo %fxc%
 %fxc% || set error=1
 exit /b
 
 :CompileShaderSM4
-set fxc=%PCFXC% %1.fx %FXCOPTS% /T%2_4_0 /E%3 /FhCompiled\%1_%3.inc /FdCompiled\%1_%3.pdb /Vn%1_%3
+set fxc=%PCFXC% %1.fx %FXCOPTS% /T%2_4_0 /E%3 /FhCompiled\%1_%3.inc /FoCompiled\%1_%3.cso /FdCompiled\%1_%3.pdb /Vn%1_%3
+echo.
+echo %fxc%
+%fxc% || set error=1
+exit /b
+
+:CompileShaderSM5
+set fxc=%PCFXC% %1.fx %FXCOPTS% /T%2_5_0 /E%3 /FhCompiled\%1_%3.inc /FoCompiled\%1_%3.cso /FdCompiled\%1_%3.pdb /Vn%1_%3
 echo.
 echo %fxc%
 %fxc% || set error=1
 exit /b
 
 :CompileShaderHLSL
-set fxc=%PCFXC% %1.hlsl %FXCOPTS% /T%2_4_0_level_9_1 /E%3 /FhCompiled\%1_%3.inc /FdCompiled\%1_%3.pdb /Vn%1_%3
+set fxc=%PCFXC% %1.hlsl %FXCOPTS% /T%2_4_0_level_9_1 /E%3 /FhCompiled\%1_%3.inc /FoCompiled\%1_%3.cso /FdCompiled\%1_%3.pdb /Vn%1_%3
 echo.
 echo %fxc%
 %fxc% || set error=1
@@ -280,14 +412,15 @@ exit /b
 
 :CompileShaderxbox
 :CompileShaderSM4xbox
-set fxc=%XBOXFXC% %1.fx %FXCOPTS% /T%2_5_0 %XBOXOPTS% /E%3 /FhCompiled\XboxOne%1_%3.inc /FdCompiled\XboxOne%1_%3.pdb /Vn%1_%3
+:CompileShaderSM5xbox
+set fxc=%XBOXFXC% %1.fx %FXCOPTS% /T%2_5_0 %XBOXOPTS% /E%3 /FhCompiled\XboxOne%1_%3.inc /FoCompiled\XboxOne%1_%3.cso /FdCompiled\XboxOne%1_%3.pdb /Vn%1_%3
 echo.
 echo %fxc%
 %fxc% || set error=1
 exit /b
 
 :CompileShaderHLSLxbox
-set fxc=%XBOXFXC% %1.hlsl %FXCOPTS% /T%2_5_0 %XBOXOPTS% /E%3 /FhCompiled\XboxOne%1_%3.inc /FdCompiled\XboxOne%1_%3.pdb /Vn%1_%3
+set fxc=%XBOXFXC% %1.hlsl %FXCOPTS% /T%2_5_0 %XBOXOPTS% /E%3 /FhCompiled\XboxOne%1_%3.inc /FoCompiled\XboxOne%1_%3.cso /FdCompiled\XboxOne%1_%3.pdb /Vn%1_%3
 echo.
 echo %fxc%
 %fxc% || set error=1
@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Compute skinning for ComputeSkinning. Each job skins one run of vertices with one bone palette, and every job
+// for the frame goes into a single dispatch: a group finds its job by binary search on the jobs' first groups.
+// Reads VertexPositionNormalTangentColorTextureSkinning and writes VertexPositionNormalTangentColorTexture.
+
+static const uint GROUP_SIZE = 64;
+
+static const uint SOURCE_STRIDE = 60;
+static const uint OUTPUT_STRIDE = 52;
+
+struct SkinJob
+{
+    uint firstGroup;
+    uint vertexStart;
+    uint vertexCount;
+    uint paletteStart;
+};
+
+
+cbuffer Parameters : register(b0)
+{
+    uint JobCount;
+    uint GroupOffset;
+};
+
+
+ByteAddressBuffer SourceVertices : register(t0);
+
+// Three rows of the transposed bone matrix per bone, as in SkinnedEffect.
+StructuredBuffer<float4> Bones : register(t1);
+
+StructuredBuffer<SkinJob> Jobs : register(t2);
+
+RWByteAddressBuffer OutputVertices : register(u0);
+
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSSkin(uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID)
+{
+    uint group = GroupOffset + groupId.x;
+
+    uint first = 0;
+    uint last = JobCount - 1;
+
+    while (first < last)
+    {
+        uint middle = (first + last + 1) / 2;
+
+        if (Jobs[middle].firstGroup <= group)
+            first = middle;
+        else
+            last = middle - 1;
+    }
+
+    SkinJob job = Jobs[first];
+
+    uint index = (group - job.firstGroup) * GROUP_SIZE + groupThreadId.x;
+    if (index >= job.vertexCount)
+        return;
+
+    uint vertex = job.vertexStart + index;
+    uint source = vertex * SOURCE_STRIDE;
+    uint output = vertex * OUTPUT_STRIDE;
+
+    float3 position = asfloat(SourceVertices.Load3(source));
+    float3 normal = asfloat(SourceVertices.Load3(source + 12));
+    float4 tangent = asfloat(SourceVertices.Load4(source + 24));
+    uint color = SourceVertices.Load(source + 40);
+    uint2 texCoord = SourceVertices.Load2(source + 44);
+    uint indices = SourceVertices.Load(source + 52);
+    uint weights = SourceVertices.Load(source + 56);
+
+    float4 row0 = 0;
+    float4 row1 = 0;
+    float4 row2 = 0;
+
+    [unroll]
+    for (uint i = 0; i < 4; i++)
+    {
+        uint shift = i * 8;
+        uint bone = (job.paletteStart + ((indices >> shift) & 0xff)) * 3;
+        float weight = float((weights >> shift) & 0xff) / 255;
+
+        row0 += Bones[bone] * weight;
+        row1 += Bones[bone + 1] * weight;
+        row2 += Bones[bone + 2] * weight;
+    }
+
+    float4 p = float4(position, 1);
+
+    position = float3(dot(row0, p), dot(row1, p), dot(row2, p));
+    normal = normalize(float3(dot(row0.xyz, normal), dot(row1.xyz, normal), dot(row2.xyz, normal)));
+
+    // Models without tangents carry zeros, which must stay zero rather than become NaNs.
+    float3 t = float3(dot(row0.xyz, tangent.xyz), dot(row1.xyz, tangent.xyz), dot(row2.xyz, tangent.xyz));
+    tangent.xyz = t * rsqrt(max(dot(t, t), 1e-20));
+
+    OutputVertices.Store3(output, asuint(position));
+    OutputVertices.Store3(output + 12, asuint(normal));
+    OutputVertices.Store4(output + 24, asuint(tangent));
+    OutputVertices.Store(output + 40, color);
+    OutputVertices.Store2(output + 44, texCoord);
+}
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Image based lighting prefilters for IBLBaker. Each dispatch writes a band of rows on one or more faces of a single
+// cubemap mip. Filtering uses importance sampling from the mips of the source cube ("GPU-Based Importance Sampling",
+// GPU Gems 3 chapter 20), so a few dozen samples per texel are enough.
+
+static const uint GROUP_SIZE = 8;
+
+static const float PI = 3.14159265f;
+
+
+cbuffer Parameters : register(b0)
+{
+    uint  OutputSize;
+    uint  FirstFace;
+    uint  FirstRow;
+    uint  SampleCount;
+    float Roughness;
+    float SourceSize;
+    float SourceMipLevels;
+    float SourceLod;
+};
+
+
+TextureCube<float4> Source : register(t0);
+sampler LinearSampler : register(s0);
+
+RWTexture2DArray<float4> Output : register(u0);
+
+
+// Direction through the center of a cubemap texel, using the D3D face layout.
+float3 TexelDirection(uint3 id)
+{
+    float2 uv = (float2(id.xy) + 0.5) / OutputSize * 2 - 1;
+
+    float3 dir;
+
+    switch (id.z)
+    {
+        case 0:  dir = float3(1, -uv.y, -uv.x); break;
+        case 1:  dir = float3(-1, -uv.y, uv.x); break;
+        case 2:  dir = float3(uv.x, 1, uv.y); break;
+        case 3:  dir = float3(uv.x, -1, -uv.y); break;
+        case 4:  dir = float3(uv.x, -uv.y, 1); break;
+        default: dir = float3(-uv.x, -uv.y, -1); break;
+    }
+
+    return normalize(dir);
+}
+
+
+float2 Hammersley(uint i, uint count)
+{
+    return float2(float(i) / count, reversebits(i) * 2.3283064365386963e-10);
+}
+
+
+float3 TangentToWorld(float3 v, float3 N)
+{
+    float3 up = abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+    float3 tangentX = normalize(cross(up, N));
+    float3 tangentY = cross(N, tangentX);
+
+    return tangentX * v.x + tangentY * v.y + N * v.z;
+}
+
+
+// Source mip whose texels cover about the solid angle of one sample with the given probability density.
+float SampleLod(float pdf)
+{
+    float sampleSolidAngle = 1 / (SampleCount * pdf + 1e-6);
+    float texelSolidAngle = 4 * PI / (6 * SourceSize * SourceSize);
+
+    return clamp(0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1, 0, SourceMipLevels - 1);
+}
+
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSCopySource(uint3 dispatchId : SV_DispatchThreadID)
+{
+    uint3 id = uint3(dispatchId.x, dispatchId.y + FirstRow, dispatchId.z + FirstFace);
+
+    if (id.x >= OutputSize || id.y >= OutputSize)
+        return;
+
+    Output[id] = float4(Source.SampleLevel(LinearSampler, TexelDirection(id), SourceLod).rgb, 1);
+}
+
+
+// GGX prefiltered radiance, assuming the view and reflection directions match the normal.
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSPrefilterSpecular(uint3 dispatchId : SV_DispatchThreadID)
+{
+    uint3 id = uint3(dispatchId.x, dispatchId.y + FirstRow, dispatchId.z + FirstFace);
+
+    if (id.x >= OutputSize || id.y >= OutputSize)
+        return;
+
+    float3 N = TexelDirection(id);
+
+    // Matches the alpha of the PBREffect specular term.
+    float alpha = Roughness * Roughness;
+    float a2 = alpha * alpha;
+
+    float3 color = 0;
+    float weight = 0;
+
+    for (uint i = 0; i < SampleCount; i++)
+    {
+        float2 xi = Hammersley(i, SampleCount);
+
+        float phi = 2 * PI * xi.x;
+        float cosTheta = sqrt((1 - xi.y) / (1 + (a2 - 1) * xi.y));
+        float sinTheta = sqrt(1 - cosTheta * cosTheta);
+
+        float3 H = TangentToWorld(float3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta), N);
+        float3 L = 2 * dot(N, H) * H - N;
+
+        float NdotL = dot(N, L);
+
+        if (NdotL > 0)
+        {
+            // With N = V, the pdf of L reduces to D / 4.
+            float d = (cosTheta * cosTheta) * (a2 - 1) + 1;
+            float D = a2 / (PI * d * d);
+
+            color += Source.SampleLevel(LinearSampler, L, SampleLod(D * 0.25)).rgb * NdotL;
+            weight += NdotL;
+        }
+    }
+
+    Output[id] = float4(color / max(weight, 1e-6), 1);
+}
+
+
+// Cosine weighted irradiance, divided by pi so that albedo times the result is the diffuse radiance.
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSIrradiance(uint3 dispatchId : SV_DispatchThreadID)
+{
+    uint3 id = uint3(dispatchId.x, dispatchId.y + FirstRow, dispatchId.z + FirstFace);
+
+    if (id.x >= OutputSize || id.y >= OutputSize)
+        return;
+
+    float3 N = TexelDirection(id);
+
+    float3 color = 0;
+
+    for (uint i = 0; i < SampleCount; i++)
+    {
+        float2 xi = Hammersley(i, SampleCount);
+
+        float phi = 2 * PI * xi.x;
+        float cosTheta = sqrt(1 - xi.y);
+        float sinTheta = sqrt(xi.y);
+
+        float3 L = TangentToWorld(float3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta), N);
+
+        color += Source.SampleLevel(LinearSampler, L, SampleLod(cosTheta / PI)).rgb;
+    }
+
+    Output[id] = float4(color / SampleCount, 1);
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Culling for IndirectModelScene. One thread tests one placement against the frustum and the optional Hi-Z
+// buffer; a survivor takes the next instance slot of its part's indirect draw and copies its transform there.
+
+static const uint GROUP_SIZE = 64;
+
+static const uint INSTANCE_STRIDE = 48;
+static const uint ARGS_STRIDE = 20;
+
+struct SceneInstance
+{
+    float4 transform[3];
+    float4 sphere;
+    float3 boxCenter;
+    uint draw;
+    float3 boxExtents;
+    uint instanceBase;
+};
+
+
+cbuffer Parameters : register(b0)
+{
+    float4 FrustumPlanes[6];
+    float4x4 ViewProjection;
+    float2 HiZSize;
+    uint HiZMipCount;
+    uint InstanceCount;
+};
+
+
+StructuredBuffer<SceneInstance> Instances : register(t0);
+
+Texture2D<float> HiZ : register(t1);
+
+// DrawIndexedInstancedIndirect arguments, one set per part. Instance counts start at zero.
+RWByteAddressBuffer IndirectArgs : register(u0);
+
+// Transforms of the visible placements, read as the IEffectInstancing vertex stream.
+RWByteAddressBuffer VisibleInstances : register(u1);
+
+
+// Compares the nearest depth of the box with the farthest depth in the Hi-Z texels under its screen rectangle,
+// using the mip where the rectangle spans at most 2x2 texels.
+bool IsOccluded(float3 center, float3 extents)
+{
+    float2 lo = 1;
+    float2 hi = 0;
+    float nearest = 1;
+
+    [unroll]
+    for (uint i = 0; i < 8; i++)
+    {
+        float3 corner = center + extents * float3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+        float4 clip = mul(float4(corner, 1), ViewProjection);
+
+        // Boxes crossing the near plane are always drawn.
+        if (clip.w <= 0)
+            return false;
+
+        float3 ndc = clip.xyz / clip.w;
+        float2 uv = ndc.xy * float2(0.5, -0.5) + 0.5;
+
+        lo = min(lo, uv);
+        hi = max(hi, uv);
+        nearest = min(nearest, ndc.z);
+    }
+
+    lo = saturate(lo);
+    hi = saturate(hi);
+
+    float2 size = (hi - lo) * HiZSize;
+    uint mip = min(uint(ceil(log2(max(max(size.x, size.y), 1)))), HiZMipCount - 1);
+
+    uint2 mipSize = max(uint2(HiZSize) >> mip, 1);
+    int2 t0 = min(uint2(lo * mipSize), mipSize - 1);
+    int2 t1 = min(uint2(hi * mipSize), mipSize - 1);
+
+    float farthest = max(max(HiZ.Load(int3(t0.x, t0.y, mip)), HiZ.Load(int3(t1.x, t0.y, mip))),
+                         max(HiZ.Load(int3(t0.x, t1.y, mip)), HiZ.Load(int3(t1.x, t1.y, mip))));
+
+    return nearest > farthest;
+}
+
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSCull(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    if (dispatchThreadId.x >= InstanceCount)
+        return;
+
+    SceneInstance instance = Instances[dispatchThreadId.x];
+
+    [unroll]
+    for (uint p = 0; p < 6; p++)
+    {
+        if (dot(FrustumPlanes[p].xyz, instance.sphere.xyz) + FrustumPlanes[p].w < -instance.sphere.w)
+            return;
+    }
+
+    if (HiZMipCount && IsOccluded(instance.boxCenter, instance.boxExtents))
+        return;
+
+    uint slot;
+    IndirectArgs.InterlockedAdd(instance.draw * ARGS_STRIDE + 4, 1, slot);
+
+    uint output = (instance.instanceBase + slot) * INSTANCE_STRIDE;
+
+    VisibleInstances.Store4(output, asuint(instance.transform[0]));
+    VisibleInstances.Store4(output + 16, asuint(instance.transform[1]));
+    VisibleInstances.Store4(output + 32, asuint(instance.transform[2]));
+}
@@ -29,6 +29,11 @@ cbuffer Parameters : register(b0)
     float4x4 World                  : packoffset(c15);
     float3x3 WorldInverseTranspose  : packoffset(c19);
     float4x4 WorldViewProj          : packoffset(c22);
+
+    // Velocity-only pass
+    float4x4 PrevWorldViewProj      : packoffset(c26);
+    float TargetWidth               : packoffset(c30.x);
+    float TargetHeight              : packoffset(c30.y);
 };
 
 
@@ -99,6 +104,85 @@ VSOutputPixelLightingTx VSNormalPixelLightingTxVcBn(VSInputNmTxVc vin)
     return vout;
 }
 
+
+// Vertex shader: pixel lighting + texture (instancing).
+VSOutputPixelLightingTx VSNormalPixelLightingTxInst(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSNormalPixelLightingTxInstBn(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting + texture + vertex color (instancing).
+VSOutputPixelLightingTx VSNormalPixelLightingTxVcInst(VSInputNmTxVcInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSNormalPixelLightingTxVcInstBn(VSInputNmTxVcInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse.rgb = vin.Color.rgb;
+    vout.Diffuse.a = vin.Color.a * DiffuseColor.a;
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
 // Pixel shader: pixel lighting + texture + no fog
 float4 PSNormalPixelLightingTxNoFog(PSInputPixelLightingTx pin) : SV_Target0
 {
@@ -191,3 +275,234 @@ float4 PSNormalPixelLightingTxNoSpec(PSInputPixelLightingTx pin) : SV_Target0
     ApplyFog(color, pin.PositionWS.w);
     return color;
 }
+
+
+// Reduced passes
+#include "DepthVelocity.fxh"
+
+// Vertex shader: depth only
+float4 VSDepthOnlyTx(VSInputNmTx vin) : SV_Position
+{
+    return ComputeDepthOnly(vin.Position);
+}
+
+float4 VSDepthOnlyTxVc(VSInputNmTxVc vin) : SV_Position
+{
+    return ComputeDepthOnly(vin.Position);
+}
+
+
+// Vertex shader: depth only (instancing)
+float4 VSDepthOnlyTxInst(VSInputNmTxInst vin) : SV_Position
+{
+    return ComputeDepthOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+float4 VSDepthOnlyTxVcInst(VSInputNmTxVcInst vin) : SV_Position
+{
+    return ComputeDepthOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+
+// Vertex shader: velocity only
+VSOutputVelocityOnly VSVelocityOnlyTx(VSInputNmTx vin)
+{
+    return ComputeVelocityOnly(vin.Position);
+}
+
+VSOutputVelocityOnly VSVelocityOnlyTxVc(VSInputNmTxVc vin)
+{
+    return ComputeVelocityOnly(vin.Position);
+}
+
+
+// Vertex shader: velocity only (instancing)
+VSOutputVelocityOnly VSVelocityOnlyTxInst(VSInputNmTxInst vin)
+{
+    // Instance transforms are assumed not to have changed since the previous frame.
+    return ComputeVelocityOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+VSOutputVelocityOnly VSVelocityOnlyTxVcInst(VSInputNmTxVcInst vin)
+{
+    return ComputeVelocityOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+
+#if __SHADER_TARGET_MAJOR >= 5
+
+#include "ClusteredLighting.fxh"
+
+// Pixel shader: pixel lighting + texture + clustered lights
+float4 PSNormalPixelLightingTxClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting, adding the point and spot lights of the pixel's cluster to the directional lights
+    ColorPair lightResult = ComputeLights(eyeVector, normal, 3);
+
+    float3 clusterDiffuse, clusterSpecular;
+    ComputeClusteredLights(pin.PositionPS, pin.PositionWS.xyz, eyeVector, normal, SpecularPower, clusterDiffuse, clusterSpecular);
+
+    lightResult.Diffuse += clusterDiffuse * DiffuseColor.rgb;
+    lightResult.Specular += clusterSpecular * SpecularColor;
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular, modulated by the intensity given in the specular map
+    float3 specIntensity = SpecularTexture.Sample(Sampler, pin.TexCoord);
+    AddSpecular(color, lightResult.Specular * specIntensity);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + clustered lights, no specular map
+float4 PSNormalPixelLightingTxNoSpecClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting
+    ColorPair lightResult = ComputeLights(eyeVector, normal, 3);
+
+    float3 clusterDiffuse, clusterSpecular;
+    ComputeClusteredLights(pin.PositionPS, pin.PositionWS.xyz, eyeVector, normal, SpecularPower, clusterDiffuse, clusterSpecular);
+
+    lightResult.Diffuse += clusterDiffuse * DiffuseColor.rgb;
+    lightResult.Specular += clusterSpecular * SpecularColor;
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular
+    AddSpecular(color, lightResult.Specular);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+
+#include "Shadows.fxh"
+
+// Pixel shader: pixel lighting + texture + shadows
+float4 PSNormalPixelLightingTxShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting, with the first light attenuated by the shadow map
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, normal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular, modulated by the intensity given in the specular map
+    float3 specIntensity = SpecularTexture.Sample(Sampler, pin.TexCoord);
+    AddSpecular(color, lightResult.Specular * specIntensity);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + shadows, no specular map
+float4 PSNormalPixelLightingTxNoSpecShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting, with the first light attenuated by the shadow map
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, normal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular
+    AddSpecular(color, lightResult.Specular);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + clustered lights + shadows
+float4 PSNormalPixelLightingTxClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting, with the first light attenuated by the shadow map
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, normal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    float3 clusterDiffuse, clusterSpecular;
+    ComputeClusteredLights(pin.PositionPS, pin.PositionWS.xyz, eyeVector, normal, SpecularPower, clusterDiffuse, clusterSpecular);
+
+    lightResult.Diffuse += clusterDiffuse * DiffuseColor.rgb;
+    lightResult.Specular += clusterSpecular * SpecularColor;
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular, modulated by the intensity given in the specular map
+    float3 specIntensity = SpecularTexture.Sample(Sampler, pin.TexCoord);
+    AddSpecular(color, lightResult.Specular * specIntensity);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+
+// Pixel shader: pixel lighting + texture + clustered lights + shadows, no specular map
+float4 PSNormalPixelLightingTxNoSpecClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    float3 eyeVector = normalize(EyePosition - pin.PositionWS.xyz);
+
+    // Before lighting, peturb the surface's normal by the one given in normal map.
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(Sampler, pin.TexCoord).xy);
+    float3 normal = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    // Do lighting, with the first light attenuated by the shadow map
+    ColorPair lightResult = ComputeLightsShadowed(eyeVector, normal, 3, ComputeShadow(pin.PositionWS.xyz));
+
+    float3 clusterDiffuse, clusterSpecular;
+    ComputeClusteredLights(pin.PositionPS, pin.PositionWS.xyz, eyeVector, normal, SpecularPower, clusterDiffuse, clusterSpecular);
+
+    lightResult.Diffuse += clusterDiffuse * DiffuseColor.rgb;
+    lightResult.Specular += clusterSpecular * SpecularColor;
+
+    // Get color from albedo texture
+    float4 color = Texture.Sample(Sampler, pin.TexCoord) * pin.Diffuse;
+    color.rgb *= lightResult.Diffuse;
+
+    // Apply specular
+    AddSpecular(color, lightResult.Specular);
+
+    ApplyFog(color, pin.PositionWS.w);
+    return color;
+}
+
+#endif
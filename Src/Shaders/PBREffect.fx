@@ -120,6 +120,100 @@ VSOut_Velocity VSConstantVelocityBn(VSInputNmTx vin)
 }
 
 
+// Vertex shader: pbr (instancing)
+VSOutputPixelLightingTx VSConstantInst(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+
+    vout.PositionPS = cout.Pos_ps;
+    vout.PositionWS = float4(cout.Pos_ws, 1);
+    vout.NormalWS = cout.Normal_ws;
+    vout.Diffuse = float4(ConstantAlbedo, Alpha);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pbr + velocity (instancing)
+VSOut_Velocity VSConstantVelocityInst(VSInputNmTxInst vin)
+{
+    VSOut_Velocity vout;
+
+    float4 position = vin.Position;
+    float3 normal = vin.Normal;
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+
+    vout.current.PositionPS = cout.Pos_ps;
+    vout.current.PositionWS = float4(cout.Pos_ws, 1);
+    vout.current.NormalWS = cout.Normal_ws;
+    vout.current.Diffuse = float4(ConstantAlbedo, Alpha);
+    vout.current.TexCoord = vin.TexCoord;
+
+    // Instance transforms are assumed not to have changed since the previous frame.
+    vout.prevPosition = mul(position, PrevWorldViewProj);
+
+    return vout;
+}
+
+
+// Vertex shader: pbr (instancing, biased normal)
+VSOutputPixelLightingTx VSConstantInstBn(VSInputNmTxInst vin)
+{
+    VSOutputPixelLightingTx vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+
+    vout.PositionPS = cout.Pos_ps;
+    vout.PositionWS = float4(cout.Pos_ws, 1);
+    vout.NormalWS = cout.Normal_ws;
+    vout.Diffuse = float4(ConstantAlbedo, Alpha);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pbr + velocity (instancing, biased normal)
+VSOut_Velocity VSConstantVelocityInstBn(VSInputNmTxInst vin)
+{
+    VSOut_Velocity vout;
+
+    float4 position = vin.Position;
+    float3 normal = BiasX2(vin.Normal);
+
+    ApplyInstanceTransform(position, normal, vin.Transform);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(position, normal);
+
+    vout.current.PositionPS = cout.Pos_ps;
+    vout.current.PositionWS = float4(cout.Pos_ws, 1);
+    vout.current.NormalWS = cout.Normal_ws;
+    vout.current.Diffuse = float4(ConstantAlbedo, Alpha);
+    vout.current.TexCoord = vin.TexCoord;
+
+    // Instance transforms are assumed not to have changed since the previous frame.
+    vout.prevPosition = mul(position, PrevWorldViewProj);
+
+    return vout;
+}
+
+
 // Pixel shader: pbr (constants) + image-based lighting
 float4 PSConstant(PSInputPixelLightingTx pin) : SV_Target0
 {
@@ -270,3 +364,263 @@ PSOut_Velocity PSTexturedEmissiveVelocity(VSOut_Velocity pin)
 
     return output;
 }
+
+
+// Reduced passes
+#include "DepthVelocity.fxh"
+
+// Vertex shader: depth only
+float4 VSDepthOnly(VSInputNmTx vin) : SV_Position
+{
+    return ComputeDepthOnly(vin.Position);
+}
+
+
+// Vertex shader: velocity only
+VSOutputVelocityOnly VSVelocityOnly(VSInputNmTx vin)
+{
+    return ComputeVelocityOnly(vin.Position);
+}
+
+
+// Vertex shader: depth only (instancing)
+float4 VSDepthOnlyInst(VSInputNmTxInst vin) : SV_Position
+{
+    return ComputeDepthOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+
+// Vertex shader: velocity only (instancing)
+VSOutputVelocityOnly VSVelocityOnlyInst(VSInputNmTxInst vin)
+{
+    // Instance transforms are assumed not to have changed since the previous frame.
+    return ComputeVelocityOnly(float4(ApplyInstancePosition(vin.Position, vin.Transform), 1));
+}
+
+
+#if __SHADER_TARGET_MAJOR >= 5
+
+#include "ClusteredLighting.fxh"
+
+// Point and spot lights of the pixel's cluster, shaded with the same BRDF as the directional lights in LightSurface.
+float3 LightClusters(
+    in float4 positionPS, in float3 positionWS, in float3 V, in float3 N,
+    in float3 albedo, in float roughness, in float metallic, in float ambientOcclusion)
+{
+    static const float kSpecularCoefficient = 0.04;
+
+    const float NdotV = saturate(dot(N, V));
+    const float alpha = roughness * roughness;
+
+    const float3 c_diff = lerp(albedo, float3(0, 0, 0), metallic)       * ambientOcclusion;
+    const float3 c_spec = lerp(kSpecularCoefficient, albedo, metallic)  * ambientOcclusion;
+
+    float3 acc_color = 0;
+
+    uint cluster = GetPixelCluster(positionPS);
+    uint count = ClusterLightCounts[cluster];
+    uint first = cluster * CLUSTER_MAX_LIGHTS;
+
+    for (uint i = 0; i < count; i++)
+    {
+        float3 L;
+        float3 radiance = EvaluateClusterLight(ClusterLights[ClusterLightIndices[first + i]], positionWS, L);
+
+        const float3 H = normalize(L + V);
+
+        const float NdotL = saturate(dot(N, L));
+        const float LdotH = saturate(dot(L, H));
+        const float NdotH = saturate(dot(N, H));
+
+        float diffuse_factor = Diffuse_Burley(NdotL, NdotV, LdotH, roughness);
+        float3 specular      = Specular_BRDF(alpha, c_spec, NdotV, NdotL, LdotH, NdotH);
+
+        acc_color += NdotL * radiance * ((c_diff * diffuse_factor) + specular);
+    }
+
+    return acc_color;
+}
+
+
+// Pixel shader: pbr (constants) + image-based lighting + clustered lights
+float4 PSConstantClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+    const float3 N = normalize(pin.NormalWS);
+    const float AO = 1;
+
+    float3 color = LightSurface(V, N, 3,
+        LightColor, LightDirection,
+        ConstantAlbedo, ConstantRoughness, ConstantMetallic, AO);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N,
+        ConstantAlbedo, ConstantRoughness, ConstantMetallic, AO);
+
+    return float4(color, Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + image-based lighting + clustered lights
+float4 PSTexturedClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 color = LightSurface(V, N, 3, LightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    return float4(color, albedo.w * Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + emissive + image-based lighting + clustered lights
+float4 PSTexturedEmissiveClustered(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 color = LightSurface(V, N, 3, LightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += EmissiveTexture.Sample(SurfaceSampler, pin.TexCoord).rgb;
+
+    return float4(color, albedo.w * Alpha);
+}
+
+
+#include "Shadows.fxh"
+
+// Pixel shader: pbr (constants) + image-based lighting + shadows
+float4 PSConstantShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+    const float3 N = normalize(pin.NormalWS);
+    const float AO = 1;
+
+    // The first directional light is the one the shadow map is rendered for.
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3,
+        lightColor, LightDirection,
+        ConstantAlbedo, ConstantRoughness, ConstantMetallic, AO);
+
+    return float4(color, Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + image-based lighting + shadows
+float4 PSTexturedShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3, lightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    return float4(color, albedo.w * Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + emissive + image-based lighting + shadows
+float4 PSTexturedEmissiveShadow(PSInputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3, lightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += EmissiveTexture.Sample(SurfaceSampler, pin.TexCoord).rgb;
+
+    return float4(color, albedo.w * Alpha);
+}
+
+
+// Pixel shader: pbr (constants) + image-based lighting + clustered lights + shadows
+float4 PSConstantClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+    const float3 N = normalize(pin.NormalWS);
+    const float AO = 1;
+
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3,
+        lightColor, LightDirection,
+        ConstantAlbedo, ConstantRoughness, ConstantMetallic, AO);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N,
+        ConstantAlbedo, ConstantRoughness, ConstantMetallic, AO);
+
+    return float4(color, Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + image-based lighting + clustered lights + shadows
+float4 PSTexturedClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3, lightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    return float4(color, albedo.w * Alpha);
+}
+
+
+// Pixel shader: pbr (textures) + emissive + image-based lighting + clustered lights + shadows
+float4 PSTexturedEmissiveClusteredShadow(VSOutputPixelLightingTx pin) : SV_Target0
+{
+    const float3 V = normalize(EyePosition - pin.PositionWS.xyz);
+
+    float3 localNormal = TwoChannelNormalX2(NormalTexture.Sample(SurfaceSampler, pin.TexCoord).xy);
+    float3 N = PeturbNormal(localNormal, pin.PositionWS.xyz, pin.NormalWS, pin.TexCoord);
+
+    float4 albedo = AlbedoTexture.Sample(SurfaceSampler, pin.TexCoord);
+    float3 RMA = RMATexture.Sample(SurfaceSampler, pin.TexCoord);
+
+    float3 lightColor[3] = { LightColor[0] * ComputeShadow(pin.PositionWS.xyz), LightColor[1], LightColor[2] };
+
+    float3 color = LightSurface(V, N, 3, lightColor, LightDirection, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += LightClusters(pin.PositionPS, pin.PositionWS.xyz, V, N, albedo.rgb, RMA.g, RMA.b, RMA.r);
+
+    color += EmissiveTexture.Sample(SurfaceSampler, pin.TexCoord).rgb;
+
+    return float4(color, albedo.w * Alpha);
+}
+
+#endif
@@ -0,0 +1,189 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// GPU particles for ParticleSystem. Free particle slots live in a dead list, and live ones in a pair of alive lists
+// that swap each frame: emit moves slots from the dead list to the current alive list, and simulate consumes it,
+// appending survivors to the other alive list and returning the rest to the dead list. The vertex shader pairs with
+// SpriteEffect's pixel shader.
+
+static const uint GROUP_SIZE = 256;
+
+struct Particle
+{
+    float3 position;
+    float age;
+    float3 velocity;
+    float lifetime;
+};
+
+
+cbuffer Parameters : register(b0)
+{
+    row_major float4x4 World;
+    row_major float4x4 View;
+    row_major float4x4 Projection;
+    float4 EmitterPosition;
+    float4 PositionVariance;
+    float4 Velocity;
+    float4 VelocityVariance;
+    float4 Acceleration;        // xyz, drag in w
+    float4 StartColor;
+    float4 EndColor;
+    float4 LifeSize;            // minimum lifetime, maximum lifetime, start size, end size
+    float ElapsedTime;
+    uint EmitCount;
+    uint RandomSeed;
+    uint MaxParticles;
+};
+
+
+// Filled by CopyStructureCount.
+cbuffer Counts : register(b1)
+{
+    uint DeadCount;
+    uint AliveCount;
+};
+
+
+RWStructuredBuffer<Particle> Particles : register(u0);
+
+AppendStructuredBuffer<uint> DeadListAppend : register(u1);
+ConsumeStructuredBuffer<uint> DeadListConsume : register(u1);
+
+AppendStructuredBuffer<uint> AliveListAppend : register(u2);
+ConsumeStructuredBuffer<uint> AliveListConsume : register(u2);
+
+AppendStructuredBuffer<uint> NextAliveList : register(u3);
+
+RWByteAddressBuffer IndirectArgs : register(u0);
+
+StructuredBuffer<Particle> ParticleData : register(t0);
+StructuredBuffer<uint> AliveIndices : register(t1);
+
+
+uint Hash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+
+// Uniform in [0, 1).
+float Random(inout uint seed)
+{
+    seed = Hash(seed);
+    return float(seed >> 8) * (1.0 / 16777216.0);
+}
+
+
+float3 RandomSigned3(inout uint seed)
+{
+    float3 result;
+    result.x = Random(seed);
+    result.y = Random(seed);
+    result.z = Random(seed);
+    return result * 2 - 1;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: put every particle slot on the dead list.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSInitDeadList(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x < MaxParticles)
+    {
+        DeadListAppend.Append(id.x);
+    }
+}
+
+
+// Compute shader: start new particles in free slots.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSEmit(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= EmitCount || id.x >= DeadCount)
+        return;
+
+    uint seed = Hash(id.x ^ RandomSeed);
+
+    float3 position = EmitterPosition.xyz + RandomSigned3(seed) * PositionVariance.xyz;
+    float3 velocity = Velocity.xyz + RandomSigned3(seed) * VelocityVariance.xyz;
+
+    Particle particle;
+    particle.position = mul(float4(position, 1), World).xyz;
+    particle.age = 0;
+    particle.velocity = mul(velocity, (float3x3)World);
+    particle.lifetime = lerp(LifeSize.x, LifeSize.y, Random(seed));
+
+    uint index = DeadListConsume.Consume();
+    Particles[index] = particle;
+
+    AliveListAppend.Append(index);
+}
+
+
+// Compute shader: size the simulate dispatch from the live count, and reset the draw arguments that follow it.
+[numthreads(1, 1, 1)]
+void CSPrepareSimulate()
+{
+    IndirectArgs.Store3(0, uint3((AliveCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1));
+    IndirectArgs.Store4(12, uint4(4, 0, 0, 0));
+}
+
+
+// Compute shader: age and move the live particles, compacting the survivors into the next alive list.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSSimulate(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= AliveCount)
+        return;
+
+    uint index = AliveListConsume.Consume();
+
+    Particle particle = Particles[index];
+
+    particle.age += ElapsedTime;
+
+    if (particle.age < particle.lifetime)
+    {
+        particle.velocity += Acceleration.xyz * ElapsedTime;
+        particle.velocity *= saturate(1 - Acceleration.w * ElapsedTime);
+        particle.position += particle.velocity * ElapsedTime;
+
+        Particles[index] = particle;
+
+        NextAliveList.Append(index);
+    }
+    else
+    {
+        DeadListAppend.Append(index);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Vertex shader: expands each live particle into a camera facing quad, drawn as a four vertex strip.
+void VSParticle(uint vertexId : SV_VertexID,
+                uint instanceId : SV_InstanceID,
+                out float4 color    : COLOR0,
+                out float2 texCoord : TEXCOORD0,
+                out float4 position : SV_Position)
+{
+    Particle particle = ParticleData[AliveIndices[instanceId]];
+
+    float life = saturate(particle.age / particle.lifetime);
+    float size = lerp(LifeSize.z, LifeSize.w, life);
+
+    float2 corner = float2(vertexId & 1, vertexId >> 1);
+
+    float3 viewPosition = mul(float4(particle.position, 1), View).xyz;
+    viewPosition.xy += float2(corner.x - 0.5, 0.5 - corner.y) * size;
+
+    position = mul(float4(viewPosition, 1), Projection);
+    color = lerp(StartColor, EndColor, life);
+    texCoord = corner;
+}
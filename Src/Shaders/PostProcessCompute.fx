@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//
+// Compute versions of the BasicPostProcess filters. They read the same constants as PostProcess.fx.
+
+static const int MAX_SAMPLES = 16;
+
+
+Texture2D<float4> Texture : register(t0);
+sampler Sampler : register(s0);
+
+RWTexture2D<float4> Output : register(u0);
+
+
+cbuffer Parameters : register(b0)
+{
+    float4 sampleOffsets[MAX_SAMPLES];
+    float4 sampleWeights[MAX_SAMPLES];
+};
+
+
+float2 OutputTexCoord(uint2 position, out bool inside)
+{
+    uint2 size;
+    Output.GetDimensions(size.x, size.y);
+
+    inside = all(position < size);
+
+    return (float2(position) + 0.5) / float2(size);
+}
+
+
+int2 TexelOffset(int i)
+{
+    float2 size;
+    Texture.GetDimensions(size.x, size.y);
+
+    return int2(round(sampleOffsets[i].xy * size));
+}
+
+
+float4 LoadClamped(int2 position)
+{
+    int2 size;
+    Texture.GetDimensions(size.x, size.y);
+
+    return Texture.Load(int3(clamp(position, 0, size - 1), 0));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: down-sample 2x2.
+[numthreads(8, 8, 1)]
+void CSDownScale2x2(uint3 id : SV_DispatchThreadID)
+{
+    bool inside;
+    float2 texcoord = OutputTexCoord(id.xy, inside);
+
+    // The output texel center lies between 4 source texels, so one bilinear fetch averages them.
+    if (inside)
+    {
+        Output[id.xy] = Texture.SampleLevel(Sampler, texcoord, 0);
+    }
+}
+
+
+// Compute shader: down-sample 4x4.
+[numthreads(8, 8, 1)]
+void CSDownScale4x4(uint3 id : SV_DispatchThreadID)
+{
+    bool inside;
+    float2 texcoord = OutputTexCoord(id.xy, inside);
+
+    if (inside)
+    {
+        // Goes through the 2x2 level in place: a bilinear fetch at the center of each 2x2 block stands in
+        // for 4 of the 16 point samples the pixel shader takes.
+        float2 texel = sampleOffsets[5].xy - sampleOffsets[0].xy;
+
+        float4 vColor = Texture.SampleLevel(Sampler, texcoord + float2(-texel.x, -texel.y), 0);
+        vColor += Texture.SampleLevel(Sampler, texcoord + float2(texel.x, -texel.y), 0);
+        vColor += Texture.SampleLevel(Sampler, texcoord + float2(-texel.x, texel.y), 0);
+        vColor += Texture.SampleLevel(Sampler, texcoord + float2(texel.x, texel.y), 0);
+
+        Output[id.xy] = vColor / 4;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: gaussian blur 5x5. Each group caches its tile plus a 2 texel apron.
+static const int BLUR_TILE = 8;
+static const int BLUR_APRON = 2;
+static const int BLUR_CACHE = BLUR_TILE + 2 * BLUR_APRON;
+
+groupshared float4 BlurCache[BLUR_CACHE * BLUR_CACHE];
+
+[numthreads(BLUR_TILE, BLUR_TILE, 1)]
+void CSGaussianBlur5x5(uint3 id : SV_DispatchThreadID, uint3 gid : SV_GroupID, uint gi : SV_GroupIndex, uint3 gtid : SV_GroupThreadID)
+{
+    int2 origin = int2(gid.xy) * BLUR_TILE - BLUR_APRON;
+
+    for (uint j = gi; j < BLUR_CACHE * BLUR_CACHE; j += BLUR_TILE * BLUR_TILE)
+    {
+        BlurCache[j] = LoadClamped(origin + int2(j % BLUR_CACHE, j / BLUR_CACHE));
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    bool inside;
+    OutputTexCoord(id.xy, inside);
+
+    if (inside)
+    {
+        float4 vColor = 0.0f;
+
+        [unroll]
+        for (int i = 0; i < 13; i++)
+        {
+            int2 p = int2(gtid.xy) + BLUR_APRON + TexelOffset(i);
+            vColor += sampleWeights[i] * BlurCache[p.y * BLUR_CACHE + p.x];
+        }
+
+        Output[id.xy] = vColor;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: bloom (blur). Each group caches a run of texels along the blur direction plus a 7 texel apron.
+static const int BLOOM_RUN = 128;
+static const int BLOOM_APRON = 7;
+
+groupshared float4 BloomCache[BLOOM_RUN + 2 * BLOOM_APRON];
+
+[numthreads(BLOOM_RUN, 1, 1)]
+void CSBloomBlur(uint3 gid : SV_GroupID, uint gi : SV_GroupIndex)
+{
+    // Offsets along x mean a horizontal blur; the group axes are swapped for a vertical one.
+    bool horizontal = sampleOffsets[1].x != 0;
+
+    int2 axis = horizontal ? int2(1, 0) : int2(0, 1);
+    int2 across = horizontal ? int2(0, 1) : int2(1, 0);
+    int2 origin = axis * (int(gid.x) * BLOOM_RUN - BLOOM_APRON) + across * int(gid.y);
+
+    for (uint j = gi; j < BLOOM_RUN + 2 * BLOOM_APRON; j += BLOOM_RUN)
+    {
+        BloomCache[j] = LoadClamped(origin + axis * int(j));
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 position = uint2(origin + axis * int(gi + BLOOM_APRON));
+
+    bool inside;
+    OutputTexCoord(position, inside);
+
+    if (inside)
+    {
+        float4 vColor = sampleWeights[0] * BloomCache[gi + BLOOM_APRON];
+
+        [unroll]
+        for (int i = 1; i < 8; i++)
+        {
+            vColor += sampleWeights[i] * BloomCache[gi + BLOOM_APRON + i];
+            vColor += sampleWeights[i + 7] * BloomCache[gi + BLOOM_APRON - i];
+        }
+
+        Output[position] = vColor;
+    }
+}
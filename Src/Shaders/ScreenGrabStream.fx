@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+
+
+Texture2D<float4> Source : register(t0);
+RWByteAddressBuffer Output : register(u0);
+
+
+cbuffer Parameters : register(b0)
+{
+    uint2 Size;             // In pixels, both even.
+    uint Pitch;             // Bytes per row of either plane, a multiple of 4.
+    uint LinearSource;      // Non-zero if Source returns linear values, which are gamma encoded first.
+};
+
+
+float3 FetchColor(int2 position)
+{
+    float3 color = saturate(Source.Load(int3(min(position, int2(Size) - 1), 0)).rgb);
+
+    if (LinearSource)
+    {
+        color = (color <= 0.0031308) ? color * 12.92 : 1.055 * pow(color, 1.0 / 2.4) - 0.055;
+    }
+
+    return color;
+}
+
+
+// BT.709 weights.
+float Luma(float3 color)
+{
+    return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+
+// Studio range: luma covers 16 to 235, chroma 16 to 240.
+uint LumaByte(float3 color)
+{
+    return (uint)(16.5 + 219 * Luma(color));
+}
+
+
+uint ChromaBytes(float3 color)
+{
+    float y = Luma(color);
+    uint u = (uint)(128.5 + 224 * (color.b - y) / 1.8556);
+    uint v = (uint)(128.5 + 224 * (color.r - y) / 1.5748);
+    return u | (v << 8);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compute shader: RGB to NV12. Each thread converts a 4x2 block of pixels into one word of luma for each of its two
+// rows and one word of interleaved chroma, so every store is a whole aligned word.
+[numthreads(8, 8, 1)]
+void CSConvertNV12(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x * 4 >= Pitch || id.y * 2 >= Size.y)
+        return;
+
+    int2 origin = int2(id.x * 4, id.y * 2);
+
+    uint luma0 = 0;
+    uint luma1 = 0;
+    uint chroma = 0;
+
+    [unroll]
+    for (uint pair = 0; pair < 2; ++pair)
+    {
+        int2 position = origin + int2(pair * 2, 0);
+
+        float3 c00 = FetchColor(position);
+        float3 c10 = FetchColor(position + int2(1, 0));
+        float3 c01 = FetchColor(position + int2(0, 1));
+        float3 c11 = FetchColor(position + int2(1, 1));
+
+        uint shift = pair * 16;
+
+        luma0 |= (LumaByte(c00) | (LumaByte(c10) << 8)) << shift;
+        luma1 |= (LumaByte(c01) | (LumaByte(c11) << 8)) << shift;
+        chroma |= ChromaBytes((c00 + c10 + c01 + c11) * 0.25) << shift;
+    }
+
+    uint offset = origin.y * Pitch + id.x * 4;
+
+    Output.Store(offset, luma0);
+    Output.Store(offset + Pitch, luma1);
+    Output.Store(Size.y * Pitch + id.y * Pitch + id.x * 4, chroma);
+}
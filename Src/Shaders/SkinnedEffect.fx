@@ -30,9 +30,14 @@ cbuffer Parameters : register(b0)
     float4x4 WorldViewProj          : packoffset(c22);
 
     float4x3 Bones[72]              : packoffset(c26);
+
+    uint2 BonePaletteOffset         : packoffset(c242);
 };
 
 
+Buffer<float4> BonePalette : register(t1);
+
+
 #include "Structures.fxh"
 #include "Common.fxh"
 #include "Lighting.fxh"
@@ -54,6 +59,27 @@ float3 Skin(inout VSInputNmTxWeights vin, float3 normal, uniform int boneCount)
 }
 
 
+// Bone palette mode reads the bones from a buffer instead, three rows of the transposed matrix per bone. Bone
+// indices are relative to the first bone, plus the per-instance stride times the instance ID for instanced draws.
+float3 SkinPalette(inout VSInputNmTxWeights vin, float3 normal, uint instanceId, uniform int boneCount)
+{
+    uint firstBone = BonePaletteOffset.x + instanceId * BonePaletteOffset.y;
+
+    float4x3 skinning = 0;
+
+    [unroll]
+    for (int i = 0; i < boneCount; i++)
+    {
+        uint row = (firstBone + vin.Indices[i]) * 3;
+
+        skinning += transpose(float3x4(BonePalette[row], BonePalette[row + 1], BonePalette[row + 2])) * vin.Weights[i];
+    }
+
+    vin.Position.xyz = mul(vin.Position, skinning);
+    return mul(normal, (float3x3)skinning);
+}
+
+
 // Vertex shader: vertex lighting, one bone.
 VSOutputTx VSSkinnedVertexLightingOneBone(VSInputNmTxWeights vin)
 {
@@ -347,6 +373,299 @@ VSOutputPixelLightingTx VSSkinnedPixelLightingFourBonesBn(VSInputNmTxWeights vin
 }
 
 
+// Vertex shader: vertex lighting, one bone, bone palette.
+VSOutputTx VSSkinnedVertexLightingOneBonePalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 1);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedVertexLightingOneBonePaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 1);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: vertex lighting, two bones, bone palette.
+VSOutputTx VSSkinnedVertexLightingTwoBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 2);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedVertexLightingTwoBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 2);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: vertex lighting, four bones, bone palette.
+VSOutputTx VSSkinnedVertexLightingFourBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 4);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedVertexLightingFourBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 4);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 3);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: one light, one bone, bone palette.
+VSOutputTx VSSkinnedOneLightOneBonePalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 1);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedOneLightOneBonePaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 1);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: one light, two bones, bone palette.
+VSOutputTx VSSkinnedOneLightTwoBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 2);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedOneLightTwoBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 2);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+// Vertex shader: one light, four bones, bone palette.
+VSOutputTx VSSkinnedOneLightFourBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 4);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputTx VSSkinnedOneLightFourBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 4);
+
+    CommonVSOutput cout = ComputeCommonVSOutputWithLighting(vin.Position, normal, 1);
+    SetCommonVSOutputParams;
+
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting, one bone, bone palette.
+VSOutputPixelLightingTx VSSkinnedPixelLightingOneBonePalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 1);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSSkinnedPixelLightingOneBonePaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 1);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting, two bones, bone palette.
+VSOutputPixelLightingTx VSSkinnedPixelLightingTwoBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 2);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSSkinnedPixelLightingTwoBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 2);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
+// Vertex shader: pixel lighting, four bones, bone palette.
+VSOutputPixelLightingTx VSSkinnedPixelLightingFourBonesPalette(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = SkinPalette(vin, vin.Normal, instanceId, 4);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+VSOutputPixelLightingTx VSSkinnedPixelLightingFourBonesPaletteBn(VSInputNmTxWeights vin, uint instanceId : SV_InstanceID)
+{
+    VSOutputPixelLightingTx vout;
+
+    float3 normal = BiasX2(vin.Normal);
+
+    normal = SkinPalette(vin, normal, instanceId, 4);
+
+    CommonVSOutputPixelLighting cout = ComputeCommonVSOutputPixelLighting(vin.Position, normal);
+    SetCommonVSOutputParamsPixelLighting;
+
+    vout.Diffuse = float4(1, 1, 1, DiffuseColor.a);
+    vout.TexCoord = vin.TexCoord;
+
+    return vout;
+}
+
+
 // Pixel shader: vertex lighting.
 float4 PSSkinnedVertexLighting(PSInputTx pin) : SV_Target0
 {
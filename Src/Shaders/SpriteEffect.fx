@@ -6,6 +6,7 @@
 
 
 Texture2D<float4> Texture : register(t0);
+Texture2DArray<float4> TextureArray : register(t0);
 sampler TextureSampler : register(s0);
 
 
@@ -23,8 +24,154 @@ void SpriteVertexShader(inout float4 color    : COLOR0,
 }
 
 
+// Expands one per-sprite instance record into the four corners of its quad.
+// Matches the CPU vertex generation in SpriteBatch::Impl::RenderSprite.
+void SpriteInstancedVertexShader(uint vertexId : SV_VertexID,
+                                 float4 destination : TEXCOORD1,
+                                 float4 source : TEXCOORD2,
+                                 float4 instanceColor : COLOR0,
+                                 float4 originRotationDepth : TEXCOORD3,
+                                 out float4 color    : COLOR0,
+                                 out float2 texCoord : TEXCOORD0,
+                                 out float4 position : SV_Position)
+{
+    float2 corner = float2(vertexId & 1, vertexId >> 1);
+
+    float2 cornerOffset = (corner - originRotationDepth.xy) * destination.zw;
+
+    float sinRotation, cosRotation;
+    sincos(originRotationDepth.z, sinRotation, cosRotation);
+
+    float2 xy = destination.xy
+              + cornerOffset.x * float2(cosRotation, sinRotation)
+              + cornerOffset.y * float2(-sinRotation, cosRotation);
+
+    position = mul(float4(xy, originRotationDepth.w, 1), MatrixTransform);
+    color = instanceColor;
+    texCoord = source.xy + corner * source.zw;
+}
+
+
 float4 SpritePixelShader(float4 color    : COLOR0,
                          float2 texCoord : TEXCOORD0) : SV_Target0
 {
     return Texture.Sample(TextureSampler, texCoord) * color;
 }
+
+
+// Texture array variant: texCoord.z holds the array slice of each sprite.
+void SpriteArrayVertexShader(inout float4 color    : COLOR0,
+                             inout float3 texCoord : TEXCOORD0,
+                             inout float4 position : SV_Position)
+{
+    position = mul(position, MatrixTransform);
+}
+
+
+float4 SpriteArrayPixelShader(float4 color    : COLOR0,
+                              float3 texCoord : TEXCOORD0) : SV_Target0
+{
+    return TextureArray.Sample(TextureSampler, texCoord) * color;
+}
+
+
+// Multi-view variant, drawn once per view: instance i uses the transform of view i, which already places the sprites in
+// that view's rectangle of the viewport, and is clipped to the rectangle by the four planes of the view.
+cbuffer MultiViewParameters : register(b1)
+{
+    row_major float4x4 ViewTransforms[4];
+    float4 ViewClipPlanes[16];
+};
+
+
+void SpriteMultiViewVertexShader(uint instanceId : SV_InstanceID,
+                                 inout float4 color    : COLOR0,
+                                 inout float2 texCoord : TEXCOORD0,
+                                 inout float4 position : SV_Position,
+                                 out float4 clipDistances : SV_ClipDistance0)
+{
+    position = mul(position, ViewTransforms[instanceId]);
+
+    [unroll]
+    for (int i = 0; i < 4; ++i)
+    {
+        clipDistances[i] = dot(position, ViewClipPlanes[instanceId * 4 + i]);
+    }
+}
+
+
+// Distance field variants, drawn with the regular sprite vertex shaders. Fields store 0.5 on the edge of the glyph,
+// rising to 1 inside and falling to 0 outside over DistanceRange texels.
+cbuffer DistanceFieldParameters : register(b0)
+{
+    float4 OutlineColor;
+    float4 ShadowColor;
+    float2 ShadowOffset;
+    float  DistanceRange;
+    float  Weight;
+    float  OutlineWidth;
+    float  ShadowSoftness;
+};
+
+
+float Median(float3 value)
+{
+    return max(min(value.r, value.g), min(max(value.r, value.g), value.b));
+}
+
+
+// How many screen pixels the full distance range covers at this scale, never less than one so minified text fades
+// rather than aliasing.
+float ScreenPixelRange(float2 texCoord)
+{
+    float2 size;
+    Texture.GetDimensions(size.x, size.y);
+
+    float2 unitRange = DistanceRange / size;
+    float2 screenTexSize = 1 / fwidth(texCoord);
+
+    return max(0.5 * dot(unitRange, screenTexSize), 1);
+}
+
+
+// Composites the shadow, outline and fill layers from distances already offset so the edges sit at 0.
+float4 ShadeDistanceField(float4 color, float distance, float shadowDistance, float pixelRange)
+{
+    float fill = saturate((distance + Weight) * pixelRange + 0.5);
+    float outline = saturate((distance + Weight + OutlineWidth) * pixelRange + 0.5);
+
+    float softness = max(ShadowSoftness, 1 / pixelRange);
+    float shadow = saturate((shadowDistance + Weight + OutlineWidth) / softness + 0.5);
+
+    float4 result = ShadowColor * shadow;
+    result = OutlineColor * outline + result * (1 - OutlineColor.a * outline);
+    result = color * fill + result * (1 - color.a * fill);
+
+    return result;
+}
+
+
+float4 SpriteDistanceFieldPixelShader(float4 color    : COLOR0,
+                                      float2 texCoord : TEXCOORD0) : SV_Target0
+{
+    float2 size;
+    Texture.GetDimensions(size.x, size.y);
+
+    float distance = Texture.Sample(TextureSampler, texCoord).a - 0.5;
+    float shadowDistance = Texture.Sample(TextureSampler, texCoord - ShadowOffset / size).a - 0.5;
+
+    return ShadeDistanceField(color, distance, shadowDistance, ScreenPixelRange(texCoord));
+}
+
+
+float4 SpriteMultiChannelDistanceFieldPixelShader(float4 color    : COLOR0,
+                                                  float2 texCoord : TEXCOORD0) : SV_Target0
+{
+    float2 size;
+    Texture.GetDimensions(size.x, size.y);
+
+    float distance = Median(Texture.Sample(TextureSampler, texCoord).rgb) - 0.5;
+    float shadowDistance = Median(Texture.Sample(TextureSampler, texCoord - ShadowOffset / size).rgb) - 0.5;
+
+    return ShadeDistanceField(color, distance, shadowDistance, ScreenPixelRange(texCoord));
+}
@@ -10,8 +10,9 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "PlatformHelpers.h"
 
@@ -35,6 +36,57 @@ namespace DirectX
 
         // Allocates or looks up the shared TData instance for the specified key.
         std::shared_ptr<TData> DemandCreate(TKey key, TConstructorArgs... args)
+        {
+            // Fast path: the same thread asking again for the key it asked for last, which is what
+            // creating many effects or batches on one device looks like. Needs no lock.
+            auto& recent = RecentLookup();
+
+            if (recent.owner == mResourceMap.get() && recent.key == key)
+            {
+                auto recentValue = recent.value.lock();
+
+                if (recentValue)
+                    return recentValue;
+            }
+
+            auto result = LockedDemandCreate(key, args...);
+
+            recent.owner = mResourceMap.get();
+            recent.key = key;
+            recent.value = result;
+
+            return result;
+        }
+
+
+    private:
+        // Keep track of all allocated TData instances.
+        struct ResourceMap : public std::unordered_map<TKey, std::weak_ptr<TData>>
+        {
+            std::mutex mutex;
+        };
+
+        std::shared_ptr<ResourceMap> mResourceMap;
+
+
+        // The last lookup made by this thread on a pool of this type. The entry only holds a weak reference, so
+        // it never keeps an instance alive, and matching the owning map tells pools of the same type apart. A map
+        // outlives every instance it created, so a later map reusing its address finds only expired entries.
+        struct RecentEntry
+        {
+            ResourceMap const* owner;
+            TKey key;
+            std::weak_ptr<TData> value;
+        };
+
+        static RecentEntry& RecentLookup() noexcept
+        {
+            static thread_local RecentEntry recent = {};
+            return recent;
+        }
+
+
+        std::shared_ptr<TData> LockedDemandCreate(TKey key, TConstructorArgs... args)
         {
             std::lock_guard<std::mutex> lock(mResourceMap->mutex);
 
@@ -61,16 +113,6 @@ namespace DirectX
         }
 
 
-    private:
-        // Keep track of all allocated TData instances.
-        struct ResourceMap : public std::map<TKey, std::weak_ptr<TData>>
-        {
-            std::mutex mutex;
-        };
-
-        std::shared_ptr<ResourceMap> mResourceMap;
-
-
         // Wrap TData with our own subclass, so we can hook the destructor
         // to remove instances from our pool before they are freed.
         struct WrappedData : public TData
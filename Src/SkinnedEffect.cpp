@@ -34,6 +34,8 @@ struct SkinnedEffectConstants
     XMMATRIX worldViewProj;
 
     XMVECTOR bones[SkinnedEffect::MaxBones][3];
+
+    uint32_t bonePaletteOffset[4];
 };
 
 static_assert((sizeof(SkinnedEffectConstants) % 16) == 0, "CB size not padded correctly");
@@ -44,9 +46,11 @@ struct SkinnedEffectTraits
 {
     using ConstantBufferType = SkinnedEffectConstants;
 
-    static const int VertexShaderCount = 18;
+    static const int VertexShaderCount = 36;
     static const int PixelShaderCount = 3;
-    static const int ShaderPermutationCount = 36;
+    static const int ShaderPermutationCount = 72;
+
+    static const BuiltInEffect Effect = BuiltInEffect_Skinned;
 };
 
 
@@ -58,17 +62,21 @@ public:
 
     bool preferPerPixelLighting;
     bool biasedVertexNormals;
+    bool bonePaletteSupported;
     int weightsPerVertex;
 
     EffectLights lights;
 
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bonePalette;
+
     int GetCurrentShaderPermutation() const noexcept;
 
     void Apply(_In_ ID3D11DeviceContext* deviceContext);
 };
 
 
-// Include the precompiled shader code.
+// Include the precompiled shader code, unless it is loaded from a shader pack.
+#if !defined(DIRECTX_TOOLKIT_SHADER_PACK)
 namespace
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -96,6 +104,30 @@ namespace
     #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingTwoBonesBn.inc"
     #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingFourBonesBn.inc"
 
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingOneBonePalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingTwoBonesPalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightOneBonePalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightTwoBonesPalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingOneBonePalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingTwoBonesPalette.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedVertexLightingFourBonesPaletteBn.inc"
+
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedOneLightFourBonesPaletteBn.inc"
+
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/XboxOneSkinnedEffect_VSSkinnedPixelLightingFourBonesPaletteBn.inc"
+
     #include "Shaders/Compiled/XboxOneSkinnedEffect_PSSkinnedVertexLighting.inc"
     #include "Shaders/Compiled/XboxOneSkinnedEffect_PSSkinnedVertexLightingNoFog.inc"
     #include "Shaders/Compiled/XboxOneSkinnedEffect_PSSkinnedPixelLighting.inc"
@@ -124,40 +156,88 @@ namespace
     #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn.inc"
     #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingFourBonesBn.inc"
 
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingOneBonePalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingTwoBonesPalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightOneBonePalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightTwoBonesPalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingOneBonePalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingTwoBonesPalette.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingFourBonesPalette.inc"
+
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedVertexLightingFourBonesPaletteBn.inc"
+
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedOneLightFourBonesPaletteBn.inc"
+
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingOneBonePaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingTwoBonesPaletteBn.inc"
+    #include "Shaders/Compiled/SkinnedEffect_VSSkinnedPixelLightingFourBonesPaletteBn.inc"
+
     #include "Shaders/Compiled/SkinnedEffect_PSSkinnedVertexLighting.inc"
     #include "Shaders/Compiled/SkinnedEffect_PSSkinnedVertexLightingNoFog.inc"
     #include "Shaders/Compiled/SkinnedEffect_PSSkinnedPixelLighting.inc"
 #endif
 }
+#endif
 
 
 template<>
 const ShaderBytecode EffectBase<SkinnedEffectTraits>::VertexShaderBytecode[] =
 {
-    { SkinnedEffect_VSSkinnedVertexLightingOneBone,     sizeof(SkinnedEffect_VSSkinnedVertexLightingOneBone)     },
-    { SkinnedEffect_VSSkinnedVertexLightingTwoBones,    sizeof(SkinnedEffect_VSSkinnedVertexLightingTwoBones)    },
-    { SkinnedEffect_VSSkinnedVertexLightingFourBones,   sizeof(SkinnedEffect_VSSkinnedVertexLightingFourBones)   },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingOneBone),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingTwoBones),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingFourBones),
+
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightOneBone),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightTwoBones),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightFourBones),
+
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingOneBone),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingTwoBones),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingFourBones),
+
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingOneBoneBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingTwoBonesBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingFourBonesBn),
+
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightOneBoneBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightTwoBonesBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightFourBonesBn),
 
-    { SkinnedEffect_VSSkinnedOneLightOneBone,           sizeof(SkinnedEffect_VSSkinnedOneLightOneBone)           },
-    { SkinnedEffect_VSSkinnedOneLightTwoBones,          sizeof(SkinnedEffect_VSSkinnedOneLightTwoBones)          },
-    { SkinnedEffect_VSSkinnedOneLightFourBones,         sizeof(SkinnedEffect_VSSkinnedOneLightFourBones)         },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingOneBoneBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingFourBonesBn),
 
-    { SkinnedEffect_VSSkinnedPixelLightingOneBone,      sizeof(SkinnedEffect_VSSkinnedPixelLightingOneBone)      },
-    { SkinnedEffect_VSSkinnedPixelLightingTwoBones,     sizeof(SkinnedEffect_VSSkinnedPixelLightingTwoBones)     },
-    { SkinnedEffect_VSSkinnedPixelLightingFourBones,    sizeof(SkinnedEffect_VSSkinnedPixelLightingFourBones)    },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingOneBonePalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingTwoBonesPalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingFourBonesPalette),
 
-    { SkinnedEffect_VSSkinnedVertexLightingOneBoneBn,   sizeof(SkinnedEffect_VSSkinnedVertexLightingOneBoneBn)   },
-    { SkinnedEffect_VSSkinnedVertexLightingTwoBonesBn,  sizeof(SkinnedEffect_VSSkinnedVertexLightingTwoBonesBn)  },
-    { SkinnedEffect_VSSkinnedVertexLightingFourBonesBn, sizeof(SkinnedEffect_VSSkinnedVertexLightingFourBonesBn) },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightOneBonePalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightTwoBonesPalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightFourBonesPalette),
 
-    { SkinnedEffect_VSSkinnedOneLightOneBoneBn,         sizeof(SkinnedEffect_VSSkinnedOneLightOneBoneBn)         },
-    { SkinnedEffect_VSSkinnedOneLightTwoBonesBn,        sizeof(SkinnedEffect_VSSkinnedOneLightTwoBonesBn)        },
-    { SkinnedEffect_VSSkinnedOneLightFourBonesBn,       sizeof(SkinnedEffect_VSSkinnedOneLightFourBonesBn)       },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingOneBonePalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingTwoBonesPalette),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingFourBonesPalette),
 
-    { SkinnedEffect_VSSkinnedPixelLightingOneBoneBn,    sizeof(SkinnedEffect_VSSkinnedPixelLightingOneBoneBn)    },
-    { SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn,   sizeof(SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn)   },
-    { SkinnedEffect_VSSkinnedPixelLightingFourBonesBn,  sizeof(SkinnedEffect_VSSkinnedPixelLightingFourBonesBn)  },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingOneBonePaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingTwoBonesPaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedVertexLightingFourBonesPaletteBn),
 
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightOneBonePaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightTwoBonesPaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedOneLightFourBonesPaletteBn),
+
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingOneBonePaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingTwoBonesPaletteBn),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_VSSkinnedPixelLightingFourBonesPaletteBn),
 };
 
 
@@ -170,14 +250,14 @@ const int EffectBase<SkinnedEffectTraits>::VertexShaderIndices[] =
     1,      // vertex lighting, two bones, no fog
     2,      // vertex lighting, four bones
     2,      // vertex lighting, four bones, no fog
-    
+
     3,      // one light, one bone
     3,      // one light, one bone, no fog
     4,      // one light, two bones
     4,      // one light, two bones, no fog
     5,      // one light, four bones
     5,      // one light, four bones, no fog
-    
+
     6,      // pixel lighting, one bone
     6,      // pixel lighting, one bone, no fog
     7,      // pixel lighting, two bones
@@ -205,15 +285,57 @@ const int EffectBase<SkinnedEffectTraits>::VertexShaderIndices[] =
     16,     // pixel lighting (biased vertex normals), two bones, no fog
     17,     // pixel lighting (biased vertex normals), four bones
     17,     // pixel lighting (biased vertex normals), four bones, no fog
+
+    18,     // vertex lighting, one bone, bone palette
+    18,     // vertex lighting, one bone, bone palette, no fog
+    19,     // vertex lighting, two bones, bone palette
+    19,     // vertex lighting, two bones, bone palette, no fog
+    20,     // vertex lighting, four bones, bone palette
+    20,     // vertex lighting, four bones, bone palette, no fog
+
+    21,     // one light, one bone, bone palette
+    21,     // one light, one bone, bone palette, no fog
+    22,     // one light, two bones, bone palette
+    22,     // one light, two bones, bone palette, no fog
+    23,     // one light, four bones, bone palette
+    23,     // one light, four bones, bone palette, no fog
+
+    24,     // pixel lighting, one bone, bone palette
+    24,     // pixel lighting, one bone, bone palette, no fog
+    25,     // pixel lighting, two bones, bone palette
+    25,     // pixel lighting, two bones, bone palette, no fog
+    26,     // pixel lighting, four bones, bone palette
+    26,     // pixel lighting, four bones, bone palette, no fog
+
+    27,     // vertex lighting (biased vertex normals), one bone, bone palette
+    27,     // vertex lighting (biased vertex normals), one bone, bone palette, no fog
+    28,     // vertex lighting (biased vertex normals), two bones, bone palette
+    28,     // vertex lighting (biased vertex normals), two bones, bone palette, no fog
+    29,     // vertex lighting (biased vertex normals), four bones, bone palette
+    29,     // vertex lighting (biased vertex normals), four bones, bone palette, no fog
+
+    30,     // one light (biased vertex normals), one bone, bone palette
+    30,     // one light (biased vertex normals), one bone, bone palette, no fog
+    31,     // one light (biased vertex normals), two bones, bone palette
+    31,     // one light (biased vertex normals), two bones, bone palette, no fog
+    32,     // one light (biased vertex normals), four bones, bone palette
+    32,     // one light (biased vertex normals), four bones, bone palette, no fog
+
+    33,     // pixel lighting (biased vertex normals), one bone, bone palette
+    33,     // pixel lighting (biased vertex normals), one bone, bone palette, no fog
+    34,     // pixel lighting (biased vertex normals), two bones, bone palette
+    34,     // pixel lighting (biased vertex normals), two bones, bone palette, no fog
+    35,     // pixel lighting (biased vertex normals), four bones, bone palette
+    35,     // pixel lighting (biased vertex normals), four bones, bone palette, no fog
 };
 
 
 template<>
 const ShaderBytecode EffectBase<SkinnedEffectTraits>::PixelShaderBytecode[] =
 {
-    { SkinnedEffect_PSSkinnedVertexLighting,      sizeof(SkinnedEffect_PSSkinnedVertexLighting)      },
-    { SkinnedEffect_PSSkinnedVertexLightingNoFog, sizeof(SkinnedEffect_PSSkinnedVertexLightingNoFog) },
-    { SkinnedEffect_PSSkinnedPixelLighting,       sizeof(SkinnedEffect_PSSkinnedPixelLighting)       },
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_PSSkinnedVertexLighting),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_PSSkinnedVertexLightingNoFog),
+    EFFECT_SHADER_BYTECODE(SkinnedEffect_PSSkinnedPixelLighting),
 };
 
 
@@ -226,14 +348,14 @@ const int EffectBase<SkinnedEffectTraits>::PixelShaderIndices[] =
     1,      // vertex lighting, two bones, no fog
     0,      // vertex lighting, four bones
     1,      // vertex lighting, four bones, no fog
-    
+
     0,      // one light, one bone
     1,      // one light, one bone, no fog
     0,      // one light, two bones
     1,      // one light, two bones, no fog
     0,      // one light, four bones
     1,      // one light, four bones, no fog
-    
+
     2,      // pixel lighting, one bone
     2,      // pixel lighting, one bone, no fog
     2,      // pixel lighting, two bones
@@ -261,6 +383,48 @@ const int EffectBase<SkinnedEffectTraits>::PixelShaderIndices[] =
     2,      // pixel lighting (biased vertex normals), two bones, no fog
     2,      // pixel lighting (biased vertex normals), four bones
     2,      // pixel lighting (biased vertex normals), four bones, no fog
+
+    0,      // vertex lighting, one bone, bone palette
+    1,      // vertex lighting, one bone, bone palette, no fog
+    0,      // vertex lighting, two bones, bone palette
+    1,      // vertex lighting, two bones, bone palette, no fog
+    0,      // vertex lighting, four bones, bone palette
+    1,      // vertex lighting, four bones, bone palette, no fog
+
+    0,      // one light, one bone, bone palette
+    1,      // one light, one bone, bone palette, no fog
+    0,      // one light, two bones, bone palette
+    1,      // one light, two bones, bone palette, no fog
+    0,      // one light, four bones, bone palette
+    1,      // one light, four bones, bone palette, no fog
+
+    2,      // pixel lighting, one bone, bone palette
+    2,      // pixel lighting, one bone, bone palette, no fog
+    2,      // pixel lighting, two bones, bone palette
+    2,      // pixel lighting, two bones, bone palette, no fog
+    2,      // pixel lighting, four bones, bone palette
+    2,      // pixel lighting, four bones, bone palette, no fog
+
+    0,      // vertex lighting (biased vertex normals), one bone, bone palette
+    1,      // vertex lighting (biased vertex normals), one bone, bone palette, no fog
+    0,      // vertex lighting (biased vertex normals), two bones, bone palette
+    1,      // vertex lighting (biased vertex normals), two bones, bone palette, no fog
+    0,      // vertex lighting (biased vertex normals), four bones, bone palette
+    1,      // vertex lighting (biased vertex normals), four bones, bone palette, no fog
+
+    0,      // one light (biased vertex normals), one bone, bone palette
+    1,      // one light (biased vertex normals), one bone, bone palette, no fog
+    0,      // one light (biased vertex normals), two bones, bone palette
+    1,      // one light (biased vertex normals), two bones, bone palette, no fog
+    0,      // one light (biased vertex normals), four bones, bone palette
+    1,      // one light (biased vertex normals), four bones, bone palette, no fog
+
+    2,      // pixel lighting (biased vertex normals), one bone, bone palette
+    2,      // pixel lighting (biased vertex normals), one bone, bone palette, no fog
+    2,      // pixel lighting (biased vertex normals), two bones, bone palette
+    2,      // pixel lighting (biased vertex normals), two bones, bone palette, no fog
+    2,      // pixel lighting (biased vertex normals), four bones, bone palette
+    2,      // pixel lighting (biased vertex normals), four bones, bone palette, no fog
 };
 
 
@@ -269,11 +433,20 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<SkinnedEffectTraits>::DeviceResources> EffectBase<SkinnedEffectTraits>::deviceResourcesPool = {};
 
 
+// Creates every shader permutation for EffectWarmup.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::CreateAllSkinnedEffectShaders(ID3D11Device* device, size_t* shaderCount)
+{
+    return EffectBase<SkinnedEffectTraits>::CreateAllShaders(device, shaderCount);
+}
+
+
 // Constructor.
 SkinnedEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
     preferPerPixelLighting(false),
     biasedVertexNormals(false),
+    bonePaletteSupported(device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0),
     weightsPerVertex(4)
 {
     static_assert(_countof(EffectBase<SkinnedEffectTraits>::VertexShaderIndices) == SkinnedEffectTraits::ShaderPermutationCount, "array/max mismatch");
@@ -329,6 +502,12 @@ int SkinnedEffect::Impl::GetCurrentShaderPermutation() const noexcept
         permutation += 18;
     }
 
+    if (bonePalette)
+    {
+        // Read the bones from the palette buffer.
+        permutation += 36;
+    }
+
     return permutation;
 }
 
@@ -350,6 +529,12 @@ void SkinnedEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 
     deviceContext->PSSetShaderResources(0, 1, &textures);
 
+    if (bonePalette)
+    {
+        auto palette = bonePalette.Get();
+        deviceContext->VSSetShaderResources(1, 1, &palette);
+    }
+
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
 }
@@ -386,6 +571,8 @@ SkinnedEffect::~SkinnedEffect()
 // IEffect methods.
 void SkinnedEffect::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
+    GpuProfileScope profileScope(deviceContext, L"SkinnedEffect::Apply");
+
     pImpl->Apply(deviceContext);
 }
 
@@ -646,3 +833,20 @@ void SkinnedEffect::SetBiasedVertexNormals(bool value)
 {
     pImpl->biasedVertexNormals = value;
 }
+
+
+// Bone palette settings.
+void SkinnedEffect::SetBonePalette(_In_opt_ ID3D11ShaderResourceView* value, uint32_t firstBone, uint32_t bonesPerInstance)
+{
+    if (value && !pImpl->bonePaletteSupported)
+    {
+        throw std::exception("SkinnedEffect bone palettes require Feature Level 10.0 or later");
+    }
+
+    pImpl->bonePalette = value;
+
+    pImpl->constants.bonePaletteOffset[0] = firstBone;
+    pImpl->constants.bonePaletteOffset[1] = bonesPerInstance;
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+}
@@ -10,11 +10,14 @@
 #include "pch.h"
 
 #include "SpriteBatch.h"
+#include "Effects.h"
 #include "ConstantBuffer.h"
 #include "CommonStates.h"
 #include "VertexTypes.h"
 #include "SharedResourcePool.h"
+#include "ThreadPool.h"
 #include "AlignedNew.h"
+#include "GpuProfiler.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -25,9 +28,21 @@ namespace
     #if defined(_XBOX_ONE) && defined(_TITLE)
     #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteVertexShader.inc"
     #include "Shaders/Compiled/XboxOneSpriteEffect_SpritePixelShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteInstancedVertexShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteArrayVertexShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteArrayPixelShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteMultiViewVertexShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteDistanceFieldPixelShader.inc"
+    #include "Shaders/Compiled/XboxOneSpriteEffect_SpriteMultiChannelDistanceFieldPixelShader.inc"
     #else
     #include "Shaders/Compiled/SpriteEffect_SpriteVertexShader.inc"
     #include "Shaders/Compiled/SpriteEffect_SpritePixelShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteInstancedVertexShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteArrayVertexShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteArrayPixelShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteMultiViewVertexShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteDistanceFieldPixelShader.inc"
+    #include "Shaders/Compiled/SpriteEffect_SpriteMultiChannelDistanceFieldPixelShader.inc"
     #endif
 
 
@@ -57,11 +72,40 @@ namespace
 }
 
 
+// Internal SpriteList implementation class.
+class SpriteList::Impl
+{
+public:
+    Impl() noexcept
+      : spriteCount(0),
+        updatable(false)
+    {
+    }
+
+    // Run of consecutive sprites that share a texture, drawn with a single texture binding.
+    struct Batch
+    {
+        ComPtr<ID3D11ShaderResourceView> texture;
+        size_t start;
+        size_t count;
+    };
+
+    ComPtr<ID3D11Buffer> vertexBuffer;
+    std::vector<Batch> batches;
+
+    // Texture of each sprite in baked order, kept for updatable lists so replacements can be validated.
+    std::vector<ID3D11ShaderResourceView*> spriteTextures;
+
+    size_t spriteCount;
+    bool updatable;
+};
+
+
 // Internal SpriteBatch implementation class.
 __declspec(align(16)) class SpriteBatch::Impl : public AlignedNew<SpriteBatch::Impl>
 {
 public:
-    Impl(_In_ ID3D11DeviceContext* deviceContext);
+    Impl(_In_ ID3D11DeviceContext* deviceContext, SPRITEBATCH_FLAGS flags);
 
     void XM_CALLCONV Begin(SpriteSortMode sortMode,
         _In_opt_ ID3D11BlendState* blendState,
@@ -77,7 +121,19 @@ public:
         _In_opt_ RECT const* sourceRectangle,
         FXMVECTOR color,
         FXMVECTOR originRotationDepth,
-        unsigned int flags);
+        unsigned int flags,
+        unsigned int arraySlice = 0);
+
+    void XM_CALLCONV Draw(SpriteList::Impl const& spriteList, FXMMATRIX transformMatrix);
+
+    void BeginRecording(SpriteSortMode sortMode);
+    std::unique_ptr<SpriteList::Impl> EndRecording(bool allowUpdates);
+    void EndRecording(SpriteList::Impl& spriteList, size_t firstSprite);
+    void FinishRecording() noexcept;
+
+    void SetDistanceField(_In_opt_ SpriteDistanceFieldSettings const* settings);
+    void SetClipRectangle(_In_opt_ RECT const* clipRectangle);
+    void SetMultiView(size_t count, _In_reads_opt_(count) D3D11_VIEWPORT const* viewports, _In_reads_opt_(count) XMMATRIX const* viewTransforms);
 
 
     // Info about a single sprite that is waiting to be drawn.
@@ -89,6 +145,7 @@ public:
         XMFLOAT4A originRotationDepth;
         ID3D11ShaderResourceView* texture;
         unsigned int flags;
+        unsigned int arraySlice;
 
 
         // Combine values from the public SpriteEffects enum with these internal-only flags.
@@ -98,27 +155,107 @@ public:
         static_assert((SpriteEffects_FlipBoth & (SourceInTexels | DestSizeInPixels)) == 0, "Flag bits must not overlap");
     };
 
+
+    // Per-sprite record consumed by the instanced vertex shader, which expands it into four corners.
+    // Mirroring is folded into the source region by negating its extent, so no flags are needed.
+    struct SpriteInstance
+    {
+        XMFLOAT4 destination;           // x, y, width, height in pixels
+        XMFLOAT4 source;                // u, v, width, height in texture coordinates
+        XMFLOAT4 color;
+        XMFLOAT4 originRotationDepth;   // origin as a fraction of the sprite size, rotation, depth
+
+        static const D3D11_INPUT_ELEMENT_DESC InputElements[4];
+    };
+
+
+    // Vertex used when drawing slices of a texture array, with the slice in textureCoordinate.z.
+    struct SpriteArrayVertex
+    {
+        XMFLOAT3 position;
+        XMFLOAT4 color;
+        XMFLOAT3 textureCoordinate;
+
+        static const D3D11_INPUT_ELEMENT_DESC InputElements[3];
+    };
+
+
+    // Pixel shader constants for distance field sprites, matching DistanceFieldParameters in SpriteEffect.fx.
+    struct DistanceFieldConstants
+    {
+        XMFLOAT4 outlineColor;
+        XMFLOAT4 shadowColor;
+        XMFLOAT2 shadowOffset;
+        float distanceRange;
+        float weight;
+        float outlineWidth;
+        float shadowSoftness;
+        float padding[2];
+    };
+
+    static_assert((sizeof(DistanceFieldConstants) % 16) == 0, "DistanceFieldConstants size alignment");
+
+
+    // Vertex shader constants for multi-view sprites, matching MultiViewParameters in SpriteEffect.fx.
+    struct MultiViewConstants
+    {
+        XMMATRIX viewTransforms[MaxViews];
+        XMVECTOR clipPlanes[MaxViews * 4];
+    };
+
+    static_assert((sizeof(MultiViewConstants) % 16) == 0, "MultiViewConstants size alignment");
+
     DXGI_MODE_ROTATION mRotation;
 
     bool mSetViewport;
     D3D11_VIEWPORT mViewPort;
 
+    bool mParallelVertexGeneration;
+    TaskScheduler mTaskScheduler;
+
 private:
     // Implementation helper methods.
     void GrowSpriteQueue();
     void PrepareForRendering();
+    void SetShaders(bool textureArray);
+    void XM_CALLCONV SetTransform(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX transformMatrix);
+    void SetDistanceFieldConstants(_In_ ID3D11DeviceContext* deviceContext);
+    void XM_CALLCONV SetMultiViewConstants(_In_ ID3D11DeviceContext* deviceContext, FXMMATRIX transformMatrix, CXMMATRIX viewportTransform);
+    void DrawSprites(_In_ ID3D11DeviceContext* deviceContext, UINT indexCount, UINT startIndex, INT baseVertex) const;
+    ID3D11PixelShader* GetPixelShader() const noexcept;
     void FlushBatch();
+    void ResetSpriteQueue();
     void SortSprites();
+    void RadixSortSprites();
     void GrowSortedSprites();
+    bool ClipSprite(_Inout_ SpriteInfo* sprite) const;
 
     void RenderBatch(_In_ ID3D11ShaderResourceView* texture, _In_reads_(count) SpriteInfo const* const* sprites, size_t count);
+    void RenderBatchInstanced(_In_ ID3D11ShaderResourceView* texture, _In_reads_(count) SpriteInfo const* const* sprites, size_t count);
+    void RenderBatchArray(_In_ ID3D11ShaderResourceView* texture, _In_reads_(count) SpriteInfo const* const* sprites, size_t count);
+
+    void RenderSortedSprites(_Out_writes_(mSpriteQueueCount * VerticesPerSprite) VertexPositionColorTexture* vertices,
+        std::function<void(ID3D11ShaderResourceView* texture, size_t start, size_t count)> const& visitBatch);
+
+    void ForEachSpriteChunk(size_t bufferPosition, size_t count, std::function<void(size_t begin, size_t end)> const& generate);
 
     static void XM_CALLCONV RenderSprite(_In_ SpriteInfo const* sprite,
         _Out_writes_(VerticesPerSprite) VertexPositionColorTexture* vertices,
         FXMVECTOR textureSize,
         FXMVECTOR inverseTextureSize);
 
+    static void XM_CALLCONV RenderSpriteArray(_In_ SpriteInfo const* sprite,
+        _Out_writes_(VerticesPerSprite) SpriteArrayVertex* vertices,
+        FXMVECTOR textureSize,
+        FXMVECTOR inverseTextureSize);
+
+    static void XM_CALLCONV RenderSpriteInstance(_In_ SpriteInfo const* sprite,
+        _Out_ SpriteInstance* instance,
+        FXMVECTOR textureSize,
+        FXMVECTOR inverseTextureSize);
+
     static XMVECTOR GetTextureSize(_In_ ID3D11ShaderResourceView* texture);
+    bool IsTextureArray(_In_ ID3D11ShaderResourceView* texture);
     XMMATRIX GetViewportTransform(_In_ ID3D11DeviceContext* deviceContext, DXGI_MODE_ROTATION rotation );
 
 
@@ -129,6 +266,10 @@ private:
     static const size_t VerticesPerSprite = 4;
     static const size_t IndicesPerSprite = 6;
 
+    // Parallel vertex generation splits batches into chunks of this many sprites.
+    static const size_t ParallelChunkSize = 256;
+    static const size_t ParallelMinBatchSize = ParallelChunkSize * 2;
+
 
     // Queue of sprites waiting to be drawn.
     std::unique_ptr<SpriteInfo[]> mSpriteQueue;
@@ -144,14 +285,51 @@ private:
     std::vector<SpriteInfo const*> mSortedSprites;
 
 
+    // Scratch storage for the radix sort. Sprites are sorted by a 32-bit key holding either their
+    // quantized depth or a texture slot id, along with their index in the mSpriteQueue array.
+    // These only ever grow, so steady state frames do not allocate.
+    struct SortKey
+    {
+        uint32_t key;
+        uint32_t index;
+    };
+
+    std::vector<SortKey> mSortKeys;
+    std::vector<ID3D11ShaderResourceView*> mTextureSlots;
+
+
     // If each SpriteInfo instance held a refcount on its texture, could end up with
     // many redundant AddRef/Release calls on the same object, so instead we use
     // this separate list to hold just a single refcount each time we change texture.
     std::vector<ComPtr<ID3D11ShaderResourceView>> mSpriteTextureReferences;
 
 
+    // Mode settings chosen at construction.
+    bool mUseInstancing;
+
+    // Whether the texture array shaders and vertex buffer are currently bound in place of the regular ones.
+    bool mTextureArrayShadersBound;
+
+    // Last texture checked by IsTextureArray, so runs of sprites sharing a texture skip the view query.
+    ComPtr<ID3D11ShaderResourceView> mArrayQueryTexture;
+    bool mArrayQueryResult;
+
+    // Distance field shading for regular sprites, or type SpriteDistanceField_None for plain coverage.
+    SpriteDistanceFieldSettings mDistanceField;
+
+    // Clip rectangle (left, top, right, bottom) applied to sprites as they are queued.
+    bool mClipEnabled;
+    XMFLOAT4 mClipRectangle;
+
+    // Views each batch is drawn into, one instance per view, or a count of 0 to draw once as usual.
+    size_t mMultiViewCount;
+    D3D11_VIEWPORT mMultiViewports[MaxViews];
+    XMFLOAT4X4 mMultiViewTransforms[MaxViews];
+
+
     // Mode settings from the last Begin call.
     bool mInBeginEndPair;
+    bool mRecording;
 
     SpriteSortMode mSortMode;
     ComPtr<ID3D11BlendState> mBlendState;
@@ -172,10 +350,27 @@ private:
         ComPtr<ID3D11InputLayout> inputLayout;
         ComPtr<ID3D11Buffer> indexBuffer;
 
+        // Only created on Feature Level 10.0 or later devices.
+        ComPtr<ID3D11VertexShader> instancedVertexShader;
+        ComPtr<ID3D11InputLayout> instancedInputLayout;
+
+        ComPtr<ID3D11VertexShader> arrayVertexShader;
+        ComPtr<ID3D11PixelShader> arrayPixelShader;
+        ComPtr<ID3D11InputLayout> arrayInputLayout;
+
+        ComPtr<ID3D11PixelShader> distanceFieldPixelShader;
+        ComPtr<ID3D11PixelShader> multiChannelDistanceFieldPixelShader;
+
+        ComPtr<ID3D11VertexShader> multiViewVertexShader;
+
         CommonStates stateObjects;
 
     private:
         void CreateShaders(_In_ ID3D11Device* device);
+        void CreateInstancedShaders(_In_ ID3D11Device* device);
+        void CreateArrayShaders(_In_ ID3D11Device* device);
+        void CreateDistanceFieldShaders(_In_ ID3D11Device* device);
+        void CreateMultiViewShaders(_In_ ID3D11Device* device);
         void CreateIndexBuffer(_In_ ID3D11Device* device);
 
         static std::vector<short> CreateIndexValues();
@@ -194,15 +389,26 @@ private:
 #endif
 
         ComPtr<ID3D11Buffer> vertexBuffer;
+        ComPtr<ID3D11Buffer> instanceBuffer;
+        ComPtr<ID3D11Buffer> arrayVertexBuffer;
 
         ConstantBuffer<XMMATRIX> constantBuffer;
+        ConstantBuffer<DistanceFieldConstants> distanceFieldConstants;
+        ConstantBuffer<MultiViewConstants> multiViewConstants;
 
         size_t vertexBufferPosition;
+        size_t instanceBufferPosition;
+        size_t arrayVertexBufferPosition;
 
         bool inImmediateMode;
 
+        ID3D11Buffer* GetInstanceBuffer();
+        ID3D11Buffer* GetArrayVertexBuffer();
+
     private:
         void CreateVertexBuffer();
+        void CreateInstanceBuffer();
+        void CreateArrayVertexBuffer();
     };
 
 
@@ -224,12 +430,35 @@ SharedResourcePool<ID3D11DeviceContext*, SpriteBatch::Impl::ContextResources> Sp
 const XMMATRIX SpriteBatch::MatrixIdentity = XMMatrixIdentity();
 const XMFLOAT2 SpriteBatch::Float2Zero(0, 0);
 
+const D3D11_INPUT_ELEMENT_DESC SpriteBatch::Impl::SpriteInstance::InputElements[4] =
+{
+    { "TEXCOORD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "TEXCOORD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "TEXCOORD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
+const D3D11_INPUT_ELEMENT_DESC SpriteBatch::Impl::SpriteArrayVertex::InputElements[3] =
+{
+    { "SV_Position", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "COLOR",       0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD",    0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
 // Per-device constructor.
 SpriteBatch::Impl::DeviceResources::DeviceResources(_In_ ID3D11Device* device)
   : stateObjects(device)
 {
     CreateShaders(device);
     CreateIndexBuffer(device);
+
+    if (device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0)
+    {
+        CreateInstancedShaders(device);
+        CreateArrayShaders(device);
+        CreateDistanceFieldShaders(device);
+        CreateMultiViewShaders(device);
+    }
 }
 
 
@@ -264,6 +493,101 @@ void SpriteBatch::Impl::DeviceResources::CreateShaders(_In_ ID3D11Device* device
 }
 
 
+// Creates the vertex shader and input layout used by SpriteBatch_Instancing.
+void SpriteBatch::Impl::DeviceResources::CreateInstancedShaders(_In_ ID3D11Device* device)
+{
+    static_assert(sizeof(SpriteInstance) == 64, "SpriteInstance must match the InputElements layout");
+
+    ThrowIfFailed(
+        device->CreateVertexShader(SpriteEffect_SpriteInstancedVertexShader,
+                                   sizeof(SpriteEffect_SpriteInstancedVertexShader),
+                                   nullptr,
+                                   &instancedVertexShader)
+    );
+
+    ThrowIfFailed(
+        device->CreateInputLayout(SpriteInstance::InputElements,
+                                  _countof(SpriteInstance::InputElements),
+                                  SpriteEffect_SpriteInstancedVertexShader,
+                                  sizeof(SpriteEffect_SpriteInstancedVertexShader),
+                                  &instancedInputLayout)
+    );
+
+    SetDebugObjectName(instancedVertexShader.Get(), "DirectXTK:SpriteBatch");
+    SetDebugObjectName(instancedInputLayout.Get(),  "DirectXTK:SpriteBatch");
+}
+
+
+// Creates the shaders and input layout used to draw slices of a texture array.
+void SpriteBatch::Impl::DeviceResources::CreateArrayShaders(_In_ ID3D11Device* device)
+{
+    static_assert(sizeof(SpriteArrayVertex) == 40, "SpriteArrayVertex must match the InputElements layout");
+
+    ThrowIfFailed(
+        device->CreateVertexShader(SpriteEffect_SpriteArrayVertexShader,
+                                   sizeof(SpriteEffect_SpriteArrayVertexShader),
+                                   nullptr,
+                                   &arrayVertexShader)
+    );
+
+    ThrowIfFailed(
+        device->CreatePixelShader(SpriteEffect_SpriteArrayPixelShader,
+                                  sizeof(SpriteEffect_SpriteArrayPixelShader),
+                                  nullptr,
+                                  &arrayPixelShader)
+    );
+
+    ThrowIfFailed(
+        device->CreateInputLayout(SpriteArrayVertex::InputElements,
+                                  _countof(SpriteArrayVertex::InputElements),
+                                  SpriteEffect_SpriteArrayVertexShader,
+                                  sizeof(SpriteEffect_SpriteArrayVertexShader),
+                                  &arrayInputLayout)
+    );
+
+    SetDebugObjectName(arrayVertexShader.Get(), "DirectXTK:SpriteBatch");
+    SetDebugObjectName(arrayPixelShader.Get(),  "DirectXTK:SpriteBatch");
+    SetDebugObjectName(arrayInputLayout.Get(),  "DirectXTK:SpriteBatch");
+}
+
+
+// Creates the pixel shaders used to draw single and multi-channel distance field sprites.
+void SpriteBatch::Impl::DeviceResources::CreateDistanceFieldShaders(_In_ ID3D11Device* device)
+{
+    ThrowIfFailed(
+        device->CreatePixelShader(SpriteEffect_SpriteDistanceFieldPixelShader,
+                                  sizeof(SpriteEffect_SpriteDistanceFieldPixelShader),
+                                  nullptr,
+                                  &distanceFieldPixelShader)
+    );
+
+    ThrowIfFailed(
+        device->CreatePixelShader(SpriteEffect_SpriteMultiChannelDistanceFieldPixelShader,
+                                  sizeof(SpriteEffect_SpriteMultiChannelDistanceFieldPixelShader),
+                                  nullptr,
+                                  &multiChannelDistanceFieldPixelShader)
+    );
+
+    SetDebugObjectName(distanceFieldPixelShader.Get(),             "DirectXTK:SpriteBatch");
+    SetDebugObjectName(multiChannelDistanceFieldPixelShader.Get(), "DirectXTK:SpriteBatch");
+}
+
+
+// Creates the vertex shader used to draw each batch into several views. It reads the same vertices as the regular
+// vertex shader, so shares its input layout.
+void SpriteBatch::Impl::DeviceResources::CreateMultiViewShaders(_In_ ID3D11Device* device)
+{
+    ThrowIfFailed(
+        device->CreateVertexShader(SpriteEffect_SpriteMultiViewVertexShader,
+                                   sizeof(SpriteEffect_SpriteMultiViewVertexShader),
+                                   nullptr,
+                                   &multiViewVertexShader)
+    );
+
+    SetDebugObjectName(multiViewVertexShader.Get(), "DirectXTK:SpriteBatch");
+}
+
+
 // Creates the SpriteBatch index buffer.
 void SpriteBatch::Impl::DeviceResources::CreateIndexBuffer(_In_ ID3D11Device* device)
 {
@@ -316,7 +640,11 @@ std::vector<short> SpriteBatch::Impl::DeviceResources::CreateIndexValues()
 // Per-context constructor.
 SpriteBatch::Impl::ContextResources::ContextResources(_In_ ID3D11DeviceContext* context)
   :constantBuffer(GetDevice(context).Get()),
+    distanceFieldConstants(GetDevice(context).Get()),
+    multiViewConstants(GetDevice(context).Get()),
     vertexBufferPosition(0),
+    instanceBufferPosition(0),
+    arrayVertexBufferPosition(0),
     inImmediateMode(false)
 {
 #if defined(_XBOX_ONE) && defined(_TITLE)
@@ -367,19 +695,122 @@ void SpriteBatch::Impl::ContextResources::CreateVertexBuffer()
 }
 
 
+// Gets or lazily creates the per-instance vertex buffer used by SpriteBatch_Instancing.
+ID3D11Buffer* SpriteBatch::Impl::ContextResources::GetInstanceBuffer()
+{
+    if (!instanceBuffer)
+    {
+        CreateInstanceBuffer();
+    }
+
+    return instanceBuffer.Get();
+}
+
+
+// Creates the per-instance vertex buffer.
+void SpriteBatch::Impl::ContextResources::CreateInstanceBuffer()
+{
+    D3D11_BUFFER_DESC instanceBufferDesc = {};
+
+    instanceBufferDesc.ByteWidth = sizeof(SpriteInstance) * MaxBatchSize;
+    instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    instanceBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+
+    auto device = GetDevice(deviceContext.Get());
+
+    ComPtr<ID3D11DeviceX> deviceX;
+    ThrowIfFailed(device.As(&deviceX));
+
+    ThrowIfFailed(
+        deviceX->CreatePlacementBuffer(&instanceBufferDesc, nullptr, &instanceBuffer)
+        );
+#else
+    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+
+    ThrowIfFailed(
+        GetDevice(deviceContext.Get())->CreateBuffer(&instanceBufferDesc, nullptr, &instanceBuffer)
+    );
+#endif
+
+    SetDebugObjectName(instanceBuffer.Get(), "DirectXTK:SpriteBatch");
+}
+
+
+// Gets or lazily creates the vertex buffer used for texture array sprites.
+ID3D11Buffer* SpriteBatch::Impl::ContextResources::GetArrayVertexBuffer()
+{
+    if (!arrayVertexBuffer)
+    {
+        CreateArrayVertexBuffer();
+    }
+
+    return arrayVertexBuffer.Get();
+}
+
+
+// Creates the texture array vertex buffer.
+void SpriteBatch::Impl::ContextResources::CreateArrayVertexBuffer()
+{
+    D3D11_BUFFER_DESC vertexBufferDesc = {};
+
+    vertexBufferDesc.ByteWidth = sizeof(SpriteArrayVertex) * MaxBatchSize * VerticesPerSprite;
+    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+
+    auto device = GetDevice(deviceContext.Get());
+
+    ComPtr<ID3D11DeviceX> deviceX;
+    ThrowIfFailed(device.As(&deviceX));
+
+    ThrowIfFailed(
+        deviceX->CreatePlacementBuffer(&vertexBufferDesc, nullptr, &arrayVertexBuffer)
+        );
+#else
+    vertexBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+
+    ThrowIfFailed(
+        GetDevice(deviceContext.Get())->CreateBuffer(&vertexBufferDesc, nullptr, &arrayVertexBuffer)
+    );
+#endif
+
+    SetDebugObjectName(arrayVertexBuffer.Get(), "DirectXTK:SpriteBatch");
+}
+
+
 // Per-SpriteBatch constructor.
-SpriteBatch::Impl::Impl(_In_ ID3D11DeviceContext* deviceContext)
+SpriteBatch::Impl::Impl(_In_ ID3D11DeviceContext* deviceContext, SPRITEBATCH_FLAGS flags)
   : mRotation(DXGI_MODE_ROTATION_IDENTITY),
     mSetViewport(false),
     mViewPort{},
+    mParallelVertexGeneration(false),
     mSpriteQueueCount(0),
     mSpriteQueueArraySize(0),
+    mUseInstancing((flags & SpriteBatch_Instancing) != 0),
+    mTextureArrayShadersBound(false),
+    mArrayQueryResult(false),
+    mDistanceField{},
+    mClipEnabled(false),
+    mClipRectangle{},
+    mMultiViewCount(0),
+    mMultiViewports{},
+    mMultiViewTransforms{},
     mInBeginEndPair(false),
+    mRecording(false),
     mSortMode(SpriteSortMode_Deferred),
     mTransformMatrix(MatrixIdentity),
     mDeviceResources(deviceResourcesPool.DemandCreate(GetDevice(deviceContext).Get())),
     mContextResources(contextResourcesPool.DemandCreate(deviceContext))
 {
+    if (mUseInstancing && !mDeviceResources->instancedVertexShader)
+    {
+        throw std::exception("SpriteBatch_Instancing requires Feature Level 10.0 or later");
+    }
 }
 
 
@@ -393,6 +824,9 @@ void XM_CALLCONV SpriteBatch::Impl::Begin(SpriteSortMode sortMode,
     std::function<void()>& setCustomShaders,
     FXMMATRIX transformMatrix)
 {
+    if (mRecording)
+        throw std::exception("Cannot call Begin while recording a SpriteList");
+
     if (mInBeginEndPair)
         throw std::exception("Cannot nest Begin calls on a single SpriteBatch");
 
@@ -422,9 +856,14 @@ void XM_CALLCONV SpriteBatch::Impl::Begin(SpriteSortMode sortMode,
 // Ends a batch of sprite drawing operations.
 void SpriteBatch::Impl::End()
 {
+    if (mRecording)
+        throw std::exception("EndRecording must be used to finish recording a SpriteList");
+
     if (!mInBeginEndPair)
         throw std::exception("Begin must be called before End");
 
+    GpuProfileScope profileScope(mContextResources->deviceContext.Get(), L"SpriteBatch::End");
+
     if (mSortMode == SpriteSortMode_Immediate)
     {
         // If we are in immediate mode, sprites have already been drawn.
@@ -455,7 +894,8 @@ void XM_CALLCONV SpriteBatch::Impl::Draw(ID3D11ShaderResourceView* texture,
     RECT const* sourceRectangle,
     FXMVECTOR color,
     FXMVECTOR originRotationDepth,
-    unsigned int flags)
+    unsigned int flags,
+    unsigned int arraySlice)
 {
     if (!texture)
         throw std::exception("Texture cannot be null");
@@ -463,6 +903,9 @@ void XM_CALLCONV SpriteBatch::Impl::Draw(ID3D11ShaderResourceView* texture,
     if (!mInBeginEndPair)
         throw std::exception("Begin must be called before Draw");
 
+    if (mRecording && IsTextureArray(texture))
+        throw std::exception("SpriteList cannot record texture array sprites");
+
     // Get a pointer to the output sprite.
     if (mSpriteQueueCount >= mSpriteQueueArraySize)
     {
@@ -503,6 +946,13 @@ void XM_CALLCONV SpriteBatch::Impl::Draw(ID3D11ShaderResourceView* texture,
 
     sprite->texture = texture;
     sprite->flags = flags;
+    sprite->arraySlice = arraySlice;
+
+    if (mClipEnabled && !ClipSprite(sprite))
+    {
+        // Entirely outside the clip rectangle.
+        return;
+    }
 
     if (mSortMode == SpriteSortMode_Immediate)
     {
@@ -526,92 +976,698 @@ void XM_CALLCONV SpriteBatch::Impl::Draw(ID3D11ShaderResourceView* texture,
 }
 
 
-// Dynamically expands the array used to store pending sprite information.
-void SpriteBatch::Impl::GrowSpriteQueue()
+// Draws a retained sprite list.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Impl::Draw(SpriteList::Impl const& spriteList, FXMMATRIX transformMatrix)
 {
-    // Grow by a factor of 2.
-    size_t newSize = std::max(InitialQueueSize, mSpriteQueueArraySize * 2);
+    if (mRecording)
+        throw std::exception("Cannot draw a SpriteList while recording");
 
-    // Allocate the new array.
-    std::unique_ptr<SpriteInfo[]> newArray(new SpriteInfo[newSize]);
+    if (!mInBeginEndPair)
+        throw std::exception("Begin must be called before Draw");
 
-    // Copy over any existing sprites.
-    for (size_t i = 0; i < mSpriteQueueCount; i++)
+    if (mSortMode != SpriteSortMode_Immediate)
     {
-        newArray[i] = mSpriteQueue[i];
-    }
-
-    // Replace the previous array with the new one.
-    mSpriteQueue = std::move(newArray);
-    mSpriteQueueArraySize = newSize;
+        // Draw anything queued so far, so the list lands on top of it. This also sets device state.
+        if (mContextResources->inImmediateMode)
+            throw std::exception("Cannot draw a SpriteList while another SpriteBatch is using SpriteSortMode_Immediate");
 
-    // Clear any dangling SpriteInfo pointers left over from previous rendering.
-    mSortedSprites.clear();
-}
+        PrepareForRendering();
+        FlushBatch();
+    }
 
+    if (!spriteList.spriteCount)
+        return;
 
-// Sets up D3D device state ready for drawing sprites.
-void SpriteBatch::Impl::PrepareForRendering()
-{
     auto deviceContext = mContextResources->deviceContext.Get();
 
-    // Set state objects.
-    auto blendState = mBlendState ? mBlendState.Get() : mDeviceResources->stateObjects.AlphaBlend();
-    auto depthStencilState = mDepthStencilState ? mDepthStencilState.Get() : mDeviceResources->stateObjects.DepthNone();
-    auto rasterizerState = mRasterizerState ? mRasterizerState.Get() : mDeviceResources->stateObjects.CullCounterClockwise();
-    auto samplerState = mSamplerState ? mSamplerState.Get() : mDeviceResources->stateObjects.LinearClamp();
-
-    deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
-    deviceContext->OMSetDepthStencilState(depthStencilState, 0);
-    deviceContext->RSSetState(rasterizerState);
-    deviceContext->PSSetSamplers(0, 1, &samplerState);
+    // Lists always hold four vertices per sprite, even if this batch was created with SpriteBatch_Instancing.
+    if (mUseInstancing || mTextureArrayShadersBound)
+    {
+        auto vertexShader = mMultiViewCount ? mDeviceResources->multiViewVertexShader.Get() : mDeviceResources->vertexShader.Get();
 
-    // Set shaders.
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    deviceContext->IASetInputLayout(mDeviceResources->inputLayout.Get());
-    deviceContext->VSSetShader(mDeviceResources->vertexShader.Get(), nullptr, 0);
-    deviceContext->PSSetShader(mDeviceResources->pixelShader.Get(), nullptr, 0);
+        deviceContext->IASetInputLayout(mDeviceResources->inputLayout.Get());
+        deviceContext->VSSetShader(vertexShader, nullptr, 0);
+        deviceContext->PSSetShader(GetPixelShader(), nullptr, 0);
+    }
 
-    // Set the vertex and index buffer.
-#if !defined(_XBOX_ONE) || !defined(_TITLE)
-    auto vertexBuffer = mContextResources->vertexBuffer.Get();
+    auto vertexBuffer = spriteList.vertexBuffer.Get();
     UINT vertexStride = sizeof(VertexPositionColorTexture);
     UINT vertexOffset = 0;
 
     deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
-#endif
 
-    deviceContext->IASetIndexBuffer(mDeviceResources->indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    SetTransform(deviceContext, XMMatrixMultiply(transformMatrix, mTransformMatrix));
 
-    // Set the transform matrix.
-    XMMATRIX transformMatrix = (mRotation == DXGI_MODE_ROTATION_UNSPECIFIED)
-        ? mTransformMatrix
-        : (mTransformMatrix * GetViewportTransform(deviceContext, mRotation));
+    for (auto const& batch : spriteList.batches)
+    {
+        auto texture = batch.texture.Get();
 
-#if defined(_XBOX_ONE) && defined(_TITLE)
-    void* grfxMemory;
-    mContextResources->constantBuffer.SetData(deviceContext, transformMatrix, &grfxMemory);
+        deviceContext->PSSetShaderResources(0, 1, &texture);
 
-    deviceContext->VSSetPlacementConstantBuffer(0, mContextResources->constantBuffer.GetBuffer(), grfxMemory);
-#else
-    mContextResources->constantBuffer.SetData(deviceContext, transformMatrix);
+        // The shared index buffer covers MaxBatchSize sprites, so longer runs are split, offsetting the base vertex.
+        for (size_t pos = 0; pos < batch.count; pos += MaxBatchSize)
+        {
+            size_t batchSize = std::min(batch.count - pos, MaxBatchSize);
 
-    ID3D11Buffer* constantBuffer = mContextResources->constantBuffer.GetBuffer();
+            auto indexCount = static_cast<UINT>(batchSize * IndicesPerSprite);
+            auto baseVertex = static_cast<INT>((batch.start + pos) * VerticesPerSprite);
 
-    deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer);
-#endif
+            DrawSprites(deviceContext, indexCount, 0, baseVertex);
+        }
+    }
 
-    // If this is a deferred D3D context, reset position so the first Map call will use D3D11_MAP_WRITE_DISCARD.
-    if (deviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+    // Put back our own vertex buffer and transform. Otherwise End takes care of this.
+    if (mSortMode == SpriteSortMode_Immediate)
     {
-        mContextResources->vertexBufferPosition = 0;
+        PrepareForRendering();
     }
+}
 
-    // Hook lets the caller replace our settings with their own custom shaders.
-    if (mSetCustomShaders)
+
+// Starts recording sprites into a retained SpriteList.
+void SpriteBatch::Impl::BeginRecording(SpriteSortMode sortMode)
+{
+    if (mInBeginEndPair)
+        throw std::exception("Cannot begin recording a SpriteList inside a Begin/End pair");
+
+    if (sortMode == SpriteSortMode_Immediate)
+        throw std::exception("SpriteSortMode_Immediate cannot be used to record a SpriteList");
+
+    mSortMode = sortMode;
+    mRecording = true;
+    mInBeginEndPair = true;
+}
+
+
+// Finishes recording, baking the sorted sprites into a new vertex buffer.
+std::unique_ptr<SpriteList::Impl> SpriteBatch::Impl::EndRecording(bool allowUpdates)
+{
+    if (!mRecording)
+        throw std::exception("BeginRecording must be called before EndRecording");
+
+    std::unique_ptr<SpriteList::Impl> spriteList;
+
+    // Recording ends here even if baking fails, or every later Begin would be refused.
+    try
+    {
+        spriteList = std::make_unique<SpriteList::Impl>();
+
+        spriteList->spriteCount = mSpriteQueueCount;
+        spriteList->updatable = allowUpdates;
+
+        if (mSpriteQueueCount)
+        {
+            std::vector<VertexPositionColorTexture> vertices(mSpriteQueueCount * VerticesPerSprite);
+
+            RenderSortedSprites(vertices.data(), [&](ID3D11ShaderResourceView* texture, size_t start, size_t count)
+            {
+                SpriteList::Impl::Batch batch;
+
+                batch.texture = texture;
+                batch.start = start;
+                batch.count = count;
+
+                spriteList->batches.push_back(std::move(batch));
+
+                if (allowUpdates)
+                {
+                    spriteList->spriteTextures.insert(spriteList->spriteTextures.end(), count, texture);
+                }
+            });
+
+            D3D11_BUFFER_DESC vertexBufferDesc = {};
+
+            vertexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(VertexPositionColorTexture) * vertices.size());
+            vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            vertexBufferDesc.Usage = allowUpdates ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE;
+
+            D3D11_SUBRESOURCE_DATA vertexDataDesc = {};
+
+            vertexDataDesc.pSysMem = vertices.data();
+
+            ThrowIfFailed(
+                GetDevice(mContextResources->deviceContext.Get())->CreateBuffer(&vertexBufferDesc, &vertexDataDesc, &spriteList->vertexBuffer)
+            );
+
+            SetDebugObjectName(spriteList->vertexBuffer.Get(), "DirectXTK:SpriteList");
+        }
+    }
+    catch (...)
+    {
+        FinishRecording();
+        throw;
+    }
+
+    FinishRecording();
+
+    return spriteList;
+}
+
+
+// Finishes recording, replacing a range of sprites in an existing updatable list.
+void SpriteBatch::Impl::EndRecording(SpriteList::Impl& spriteList, size_t firstSprite)
+{
+    if (!mRecording)
+        throw std::exception("BeginRecording must be called before EndRecording");
+
+    if (!spriteList.updatable)
+        throw std::exception("SpriteList was not created with allowUpdates");
+
+    if (firstSprite > spriteList.spriteCount || mSpriteQueueCount > spriteList.spriteCount - firstSprite)
+        throw std::out_of_range("SpriteList update out of range");
+
+    try
+    {
+        if (mSpriteQueueCount)
+        {
+            std::vector<VertexPositionColorTexture> vertices(mSpriteQueueCount * VerticesPerSprite);
+
+            // Batches were fixed when the list was baked, so each replacement must keep the texture of the sprite it replaces.
+            RenderSortedSprites(vertices.data(), [&](ID3D11ShaderResourceView* texture, size_t start, size_t count)
+            {
+                auto existing = spriteList.spriteTextures.cbegin() + static_cast<ptrdiff_t>(firstSprite + start);
+
+                if (std::any_of(existing, existing + static_cast<ptrdiff_t>(count), [=](ID3D11ShaderResourceView* t) { return t != texture; }))
+                {
+                    throw std::exception("SpriteList updates must use the same textures as the sprites they replace");
+                }
+            });
+
+            auto deviceContext = mContextResources->deviceContext.Get();
+
+            D3D11_BOX box = {};
+
+            box.left = static_cast<UINT>(sizeof(VertexPositionColorTexture) * firstSprite * VerticesPerSprite);
+            box.right = box.left + static_cast<UINT>(sizeof(VertexPositionColorTexture) * vertices.size());
+            box.bottom = 1;
+            box.back = 1;
+
+            auto data = reinterpret_cast<uint8_t const*>(vertices.data());
+
+            // Deferred contexts without driver command list support apply the box offset to the source pointer as well.
+            if (deviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+            {
+                D3D11_FEATURE_DATA_THREADING threading = {};
+
+                if (SUCCEEDED(GetDevice(deviceContext)->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading)))
+                    && !threading.DriverCommandLists)
+                {
+                    data -= box.left;
+                }
+            }
+
+            deviceContext->UpdateSubresource(spriteList.vertexBuffer.Get(), 0, &box, data, 0, 0);
+        }
+    }
+    catch (...)
+    {
+        FinishRecording();
+        throw;
+    }
+
+    FinishRecording();
+}
+
+
+// Leaves recording mode, dropping whatever sprites were queued.
+void SpriteBatch::Impl::FinishRecording() noexcept
+{
+    ResetSpriteQueue();
+
+    mRecording = false;
+    mInBeginEndPair = false;
+}
+
+
+// Dynamically expands the array used to store pending sprite information.
+void SpriteBatch::Impl::GrowSpriteQueue()
+{
+    // Grow by a factor of 2.
+    size_t newSize = std::max(InitialQueueSize, mSpriteQueueArraySize * 2);
+
+    // Allocate the new array.
+    std::unique_ptr<SpriteInfo[]> newArray(new SpriteInfo[newSize]);
+
+    // Copy over any existing sprites.
+    for (size_t i = 0; i < mSpriteQueueCount; i++)
+    {
+        newArray[i] = mSpriteQueue[i];
+    }
+
+    // Replace the previous array with the new one.
+    mSpriteQueue = std::move(newArray);
+    mSpriteQueueArraySize = newSize;
+
+    // Clear any dangling SpriteInfo pointers left over from previous rendering.
+    mSortedSprites.clear();
+}
+
+
+// Sets up D3D device state ready for drawing sprites.
+void SpriteBatch::Impl::PrepareForRendering()
+{
+    auto deviceContext = mContextResources->deviceContext.Get();
+
+    // Set state objects.
+    auto blendState = mBlendState ? mBlendState.Get() : mDeviceResources->stateObjects.AlphaBlend();
+    auto depthStencilState = mDepthStencilState ? mDepthStencilState.Get() : mDeviceResources->stateObjects.DepthNone();
+    auto rasterizerState = mRasterizerState ? mRasterizerState.Get() : mDeviceResources->stateObjects.CullCounterClockwise();
+    auto samplerState = mSamplerState ? mSamplerState.Get() : mDeviceResources->stateObjects.LinearClamp();
+
+    deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+    deviceContext->OMSetDepthStencilState(depthStencilState, 0);
+    deviceContext->RSSetState(rasterizerState);
+    deviceContext->PSSetSamplers(0, 1, &samplerState);
+
+    // Set shaders.
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    SetShaders(false);
+
+    // Set the index buffer.
+    deviceContext->IASetIndexBuffer(mDeviceResources->indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+
+    // Set the transform matrix.
+    SetTransform(deviceContext, mTransformMatrix);
+
+    if (mDistanceField.type != SpriteDistanceField_None)
+    {
+        SetDistanceFieldConstants(deviceContext);
+    }
+
+    // If this is a deferred D3D context, reset position so the first Map call will use D3D11_MAP_WRITE_DISCARD.
+    if (deviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+    {
+        mContextResources->vertexBufferPosition = 0;
+        mContextResources->instanceBufferPosition = 0;
+        mContextResources->arrayVertexBufferPosition = 0;
+    }
+
+    // Hook lets the caller replace our settings with their own custom shaders.
+    if (mSetCustomShaders)
+    {
+        mSetCustomShaders();
+    }
+}
+
+
+// Binds the input layout, shaders and vertex buffer for either regular or texture array sprites.
+void SpriteBatch::Impl::SetShaders(bool textureArray)
+{
+    auto deviceContext = mContextResources->deviceContext.Get();
+
+    // Sprite shaders and constants replace whatever the built-in effects last bound.
+    InvalidateEffectStateCache(deviceContext);
+
+    ID3D11Buffer* vertexBuffer;
+    UINT vertexStride;
+
+    if (textureArray)
+    {
+        deviceContext->IASetInputLayout(mDeviceResources->arrayInputLayout.Get());
+        deviceContext->VSSetShader(mDeviceResources->arrayVertexShader.Get(), nullptr, 0);
+        deviceContext->PSSetShader(mDeviceResources->arrayPixelShader.Get(), nullptr, 0);
+
+        vertexBuffer = mContextResources->GetArrayVertexBuffer();
+        vertexStride = sizeof(SpriteArrayVertex);
+    }
+    else
+    {
+        if (mUseInstancing)
+        {
+            deviceContext->IASetInputLayout(mDeviceResources->instancedInputLayout.Get());
+            deviceContext->VSSetShader(mDeviceResources->instancedVertexShader.Get(), nullptr, 0);
+
+            vertexBuffer = mContextResources->GetInstanceBuffer();
+            vertexStride = sizeof(SpriteInstance);
+        }
+        else
+        {
+            auto vertexShader = mMultiViewCount ? mDeviceResources->multiViewVertexShader.Get() : mDeviceResources->vertexShader.Get();
+
+            deviceContext->IASetInputLayout(mDeviceResources->inputLayout.Get());
+            deviceContext->VSSetShader(vertexShader, nullptr, 0);
+
+            vertexBuffer = mContextResources->vertexBuffer.Get();
+            vertexStride = sizeof(VertexPositionColorTexture);
+        }
+
+        deviceContext->PSSetShader(GetPixelShader(), nullptr, 0);
+    }
+
+    // Xbox One sets placement vertex buffers for each batch instead.
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    UINT vertexOffset = 0;
+
+    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+#else
+    UNREFERENCED_PARAMETER(vertexBuffer);
+    UNREFERENCED_PARAMETER(vertexStride);
+#endif
+
+    mTextureArrayShadersBound = textureArray;
+}
+
+
+// Picks the pixel shader for regular sprites.
+ID3D11PixelShader* SpriteBatch::Impl::GetPixelShader() const noexcept
+{
+    switch (mDistanceField.type)
+    {
+        case SpriteDistanceField_SingleChannel:
+            return mDeviceResources->distanceFieldPixelShader.Get();
+
+        case SpriteDistanceField_MultiChannel:
+            return mDeviceResources->multiChannelDistanceFieldPixelShader.Get();
+
+        default:
+            return mDeviceResources->pixelShader.Get();
+    }
+}
+
+
+// Sets the pixel shader constants for distance field sprites.
+void SpriteBatch::Impl::SetDistanceFieldConstants(_In_ ID3D11DeviceContext* deviceContext)
+{
+    DistanceFieldConstants constants = {};
+
+    constants.outlineColor = mDistanceField.outlineColor;
+    constants.shadowColor = mDistanceField.shadowColor;
+    constants.shadowOffset = mDistanceField.shadowOffset;
+    constants.distanceRange = mDistanceField.distanceRange;
+    constants.weight = mDistanceField.weight;
+    constants.outlineWidth = mDistanceField.outlineWidth;
+    constants.shadowSoftness = mDistanceField.shadowSoftness;
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void* grfxMemory;
+    mContextResources->distanceFieldConstants.SetData(deviceContext, constants, &grfxMemory);
+
+    mContextResources->deviceContext->PSSetPlacementConstantBuffer(0, mContextResources->distanceFieldConstants.GetBuffer(), grfxMemory);
+#else
+    mContextResources->distanceFieldConstants.SetData(deviceContext, constants);
+
+    ID3D11Buffer* constantBuffer = mContextResources->distanceFieldConstants.GetBuffer();
+
+    deviceContext->PSSetConstantBuffers(0, 1, &constantBuffer);
+#endif
+}
+
+
+// Sets the clip rectangle for following sprites.
+_Use_decl_annotations_
+void SpriteBatch::Impl::SetClipRectangle(RECT const* clipRectangle)
+{
+    if (!clipRectangle)
+    {
+        mClipEnabled = false;
+        return;
+    }
+
+    mClipRectangle = XMFLOAT4(float(clipRectangle->left), float(clipRectangle->top),
+                              float(clipRectangle->right), float(clipRectangle->bottom));
+    mClipEnabled = true;
+}
+
+
+// Trims a queued sprite to the clip rectangle, returning false if nothing of it is left. Unrotated sprites are
+// rewritten with their origin at the top left corner, their source region in texels and their size in pixels,
+// covering just the part of the quad inside the rectangle and the matching part of the source region. Rotated
+// sprites are only tested by their bounds.
+_Use_decl_annotations_
+bool SpriteBatch::Impl::ClipSprite(SpriteInfo* sprite) const
+{
+    float rotation = sprite->originRotationDepth.z;
+
+    XMFLOAT2 sourcePos(sprite->source.x, sprite->source.y);
+    XMFLOAT2 sourceSize(sprite->source.z, sprite->source.w);
+    XMFLOAT2 destSize(sprite->destination.z, sprite->destination.w);
+
+    if (!(sprite->flags & SpriteInfo::SourceInTexels) || !(sprite->flags & SpriteInfo::DestSizeInPixels))
+    {
+        XMFLOAT2 textureSize;
+        XMStoreFloat2(&textureSize, GetTextureSize(sprite->texture));
+
+        if (!(sprite->flags & SpriteInfo::SourceInTexels))
+        {
+            sourcePos = XMFLOAT2(sourcePos.x * textureSize.x, sourcePos.y * textureSize.y);
+            sourceSize = XMFLOAT2(sourceSize.x * textureSize.x, sourceSize.y * textureSize.y);
+        }
+
+        if (!(sprite->flags & SpriteInfo::DestSizeInPixels))
+        {
+            destSize = XMFLOAT2(destSize.x * textureSize.x, destSize.y * textureSize.y);
+        }
+    }
+
+    // The origin is in texels of the source region, and places the quad relative to the destination position.
+    float originX = (sourceSize.x != 0) ? sprite->originRotationDepth.x / sourceSize.x : 0.f;
+    float originY = (sourceSize.y != 0) ? sprite->originRotationDepth.y / sourceSize.y : 0.f;
+
+    if (rotation != 0)
+    {
+        float sin, cos;
+        XMScalarSinCos(&sin, &cos, rotation);
+
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            float cx = (float(i & 1) - originX) * destSize.x;
+            float cy = (float(i >> 1) - originY) * destSize.y;
+
+            float x = sprite->destination.x + cx * cos - cy * sin;
+            float y = sprite->destination.y + cx * sin + cy * cos;
+
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+
+        return maxX > mClipRectangle.x && minX < mClipRectangle.z
+            && maxY > mClipRectangle.y && minY < mClipRectangle.w;
+    }
+
+    // Quad edges as x0 + t * width for t in [0, 1], and likewise in y.
+    float x0 = sprite->destination.x - originX * destSize.x;
+    float y0 = sprite->destination.y - originY * destSize.y;
+
+    auto clipRange = [](float start, float size, float clipMin, float clipMax, float& t0, float& t1) noexcept
+    {
+        t0 = 0.f;
+        t1 = 1.f;
+
+        if (size == 0)
+            return start >= clipMin && start <= clipMax;
+
+        float a = (clipMin - start) / size;
+        float b = (clipMax - start) / size;
+
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+
+        return t0 < t1;
+    };
+
+    float tx0, tx1, ty0, ty1;
+    if (!clipRange(x0, destSize.x, mClipRectangle.x, mClipRectangle.z, tx0, tx1)
+        || !clipRange(y0, destSize.y, mClipRectangle.y, mClipRectangle.w, ty0, ty1))
+    {
+        return false;
+    }
+
+    if (tx0 == 0 && tx1 == 1 && ty0 == 0 && ty1 == 1)
+    {
+        // Entirely inside, so leave the sprite exactly as it was drawn.
+        return true;
+    }
+
+    // A mirrored axis reads the source region backwards.
+    float ux0 = tx0, ux1 = tx1;
+    if (sprite->flags & SpriteEffects_FlipHorizontally)
+    {
+        ux0 = 1.f - tx1;
+        ux1 = 1.f - tx0;
+    }
+
+    float uy0 = ty0, uy1 = ty1;
+    if (sprite->flags & SpriteEffects_FlipVertically)
+    {
+        uy0 = 1.f - ty1;
+        uy1 = 1.f - ty0;
+    }
+
+    sprite->source = XMFLOAT4A(sourcePos.x + ux0 * sourceSize.x, sourcePos.y + uy0 * sourceSize.y,
+                               (ux1 - ux0) * sourceSize.x, (uy1 - uy0) * sourceSize.y);
+
+    sprite->destination = XMFLOAT4A(x0 + tx0 * destSize.x, y0 + ty0 * destSize.y,
+                                    (tx1 - tx0) * destSize.x, (ty1 - ty0) * destSize.y);
+
+    sprite->originRotationDepth.x = 0;
+    sprite->originRotationDepth.y = 0;
+
+    sprite->flags |= SpriteInfo::SourceInTexels | SpriteInfo::DestSizeInPixels;
+
+    return true;
+}
+
+
+// Chooses distance field shading for following batches.
+_Use_decl_annotations_
+void SpriteBatch::Impl::SetDistanceField(SpriteDistanceFieldSettings const* settings)
+{
+    if (mInBeginEndPair || mRecording)
+        throw std::exception("Cannot change distance field settings inside a Begin/End pair or while recording");
+
+    if (!settings || settings->type == SpriteDistanceField_None)
+    {
+        mDistanceField = {};
+        return;
+    }
+
+    if (settings->type > SpriteDistanceField_MultiChannel)
+        throw std::invalid_argument("Invalid distance field type");
+
+    if (!(settings->distanceRange > 0.f))
+        throw std::invalid_argument("Distance field range must be greater than zero");
+
+    if (!mDeviceResources->distanceFieldPixelShader)
+        throw std::exception("Distance field sprites require Feature Level 10.0 or later");
+
+    mDistanceField = *settings;
+}
+
+
+// Chooses the views following batches are drawn into.
+_Use_decl_annotations_
+void SpriteBatch::Impl::SetMultiView(size_t count, D3D11_VIEWPORT const* viewports, XMMATRIX const* viewTransforms)
+{
+    if (mInBeginEndPair || mRecording)
+        throw std::exception("Cannot change multi-view settings inside a Begin/End pair or while recording");
+
+    if (!count || !viewports)
+    {
+        mMultiViewCount = 0;
+        return;
+    }
+
+    if (count > MaxViews)
+        throw std::out_of_range("Too many views for SpriteBatch multi-view");
+
+    if (mUseInstancing)
+        throw std::exception("SpriteBatch multi-view cannot be combined with SpriteBatch_Instancing");
+
+    if (!mDeviceResources->multiViewVertexShader)
+        throw std::exception("SpriteBatch multi-view requires Feature Level 10.0 or later");
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!(viewports[i].Width > 0) || !(viewports[i].Height > 0))
+            throw std::invalid_argument("Invalid multi-view viewport");
+
+        mMultiViewports[i] = viewports[i];
+
+        XMStoreFloat4x4(&mMultiViewTransforms[i], viewTransforms ? viewTransforms[i] : MatrixIdentity);
+    }
+
+    mMultiViewCount = count;
+}
+
+
+// Sets the vertex shader constants for multi-view sprites. Each view's sprites are laid out in pixels from the
+// view's top left corner, moved there within the full viewport, and clipped to the view's rectangle.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Impl::SetMultiViewConstants(ID3D11DeviceContext* deviceContext, FXMMATRIX transformMatrix, CXMMATRIX viewportTransform)
+{
+    MultiViewConstants constants = {};
+
+    // Clip-space planes are pixel-space planes through the inverse transpose of the viewport transform.
+    XMMATRIX planeTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, viewportTransform));
+
+    for (size_t i = 0; i < mMultiViewCount; ++i)
+    {
+        auto const& vp = mMultiViewports[i];
+
+        float left = vp.TopLeftX - mViewPort.TopLeftX;
+        float top = vp.TopLeftY - mViewPort.TopLeftY;
+        float right = left + vp.Width;
+        float bottom = top + vp.Height;
+
+        XMMATRIX viewTransform = XMLoadFloat4x4(&mMultiViewTransforms[i]);
+
+        constants.viewTransforms[i] = transformMatrix * viewTransform * XMMatrixTranslation(left, top, 0) * viewportTransform;
+
+        constants.clipPlanes[i * 4] = XMPlaneTransform(XMVectorSet(1, 0, 0, -left), planeTransform);
+        constants.clipPlanes[i * 4 + 1] = XMPlaneTransform(XMVectorSet(-1, 0, 0, right), planeTransform);
+        constants.clipPlanes[i * 4 + 2] = XMPlaneTransform(XMVectorSet(0, 1, 0, -top), planeTransform);
+        constants.clipPlanes[i * 4 + 3] = XMPlaneTransform(XMVectorSet(0, -1, 0, bottom), planeTransform);
+    }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void* grfxMemory;
+    mContextResources->multiViewConstants.SetData(deviceContext, constants, &grfxMemory);
+
+    mContextResources->deviceContext->VSSetPlacementConstantBuffer(1, mContextResources->multiViewConstants.GetBuffer(), grfxMemory);
+#else
+    mContextResources->multiViewConstants.SetData(deviceContext, constants);
+
+    ID3D11Buffer* constantBuffer = mContextResources->multiViewConstants.GetBuffer();
+
+    deviceContext->VSSetConstantBuffers(1, 1, &constantBuffer);
+#endif
+}
+
+
+// Draws sprites from the shared index buffer, once per view in multi-view.
+void SpriteBatch::Impl::DrawSprites(_In_ ID3D11DeviceContext* deviceContext, UINT indexCount, UINT startIndex, INT baseVertex) const
+{
+    if (mMultiViewCount)
+    {
+        deviceContext->DrawIndexedInstanced(indexCount, static_cast<UINT>(mMultiViewCount), startIndex, baseVertex, 0);
+    }
+    else
     {
-        mSetCustomShaders();
+        deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+    }
+}
+
+
+// Sets the vertex shader constants, combining the given transform with the viewport transform.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Impl::SetTransform(ID3D11DeviceContext* deviceContext, FXMMATRIX transformMatrix)
+{
+    if (mMultiViewCount)
+    {
+        if (mRotation != DXGI_MODE_ROTATION_IDENTITY)
+            throw std::exception("Multi-view sprites require DXGI_MODE_ROTATION_IDENTITY");
+
+        // Looks up the full viewport the views are placed in.
+        XMMATRIX viewportTransform = GetViewportTransform(deviceContext, mRotation);
+
+        SetMultiViewConstants(deviceContext, transformMatrix, viewportTransform);
     }
+
+    XMMATRIX finalTransform = (mRotation == DXGI_MODE_ROTATION_UNSPECIFIED)
+        ? transformMatrix
+        : (transformMatrix * GetViewportTransform(deviceContext, mRotation));
+
+    // Replaces the constant buffer the built-in effects last bound, even when a custom effect supplies the shaders.
+    InvalidateEffectStateCache(deviceContext);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void* grfxMemory;
+    mContextResources->constantBuffer.SetData(deviceContext, finalTransform, &grfxMemory);
+
+    deviceContext->VSSetPlacementConstantBuffer(0, mContextResources->constantBuffer.GetBuffer(), grfxMemory);
+#else
+    mContextResources->constantBuffer.SetData(deviceContext, finalTransform);
+
+    ID3D11Buffer* constantBuffer = mContextResources->constantBuffer.GetBuffer();
+
+    deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer);
+#endif
 }
 
 
@@ -649,9 +1705,16 @@ void SpriteBatch::Impl::FlushBatch()
     // Flush the final batch.
     RenderBatch(batchTexture, &mSortedSprites[batchStart], mSpriteQueueCount - batchStart);
 
-    // Reset the queue.
+    ResetSpriteQueue();
+}
+
+
+// Empties the queue once its sprites have been drawn or recorded.
+void SpriteBatch::Impl::ResetSpriteQueue()
+{
     mSpriteQueueCount = 0;
     mSpriteTextureReferences.clear();
+    mArrayQueryTexture.Reset();
 
     // When sorting is disabled, we persist mSortedSprites data from one batch to the next, to avoid
     // uneccessary work in GrowSortedSprites. But we never reuse these when sorting, because re-sorting
@@ -675,78 +1738,426 @@ void SpriteBatch::Impl::SortSprites()
     switch (mSortMode)
     {
         case SpriteSortMode_Texture:
-            // Sort by texture.
-            std::sort(mSortedSprites.begin(), mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-                {
-                    return x->texture < y->texture;
-                });
-            break;
-
         case SpriteSortMode_BackToFront:
-            // Sort back to front.
-            std::sort(mSortedSprites.begin(), mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-                {
-                    return x->originRotationDepth.w > y->originRotationDepth.w;
-                });
+        case SpriteSortMode_FrontToBack:
+            RadixSortSprites();
             break;
 
-        case SpriteSortMode_FrontToBack:
-            // Sort front to back.
-            std::sort(mSortedSprites.begin(), mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-                {
-                    return x->originRotationDepth.w < y->originRotationDepth.w;
-                });
+        default:
             break;
+    }
+}
+
+
+// Stable LSD radix sort of the queued sprites by texture or depth.
+void SpriteBatch::Impl::RadixSortSprites()
+{
+    size_t count = mSpriteQueueCount;
+
+    if (mSortKeys.size() < count * 2)
+    {
+        mSortKeys.resize(count * 2);
+    }
+
+    SortKey* keys = mSortKeys.data();
+    SortKey* scratch = keys + count;
+
+    if (mSortMode == SpriteSortMode_Texture)
+    {
+        // Texture slot ids are ranks in a sorted list of the distinct textures in this batch,
+        // so sprites end up grouped by texture in the same order as comparing the raw pointers.
+        mTextureSlots.clear();
+
+        for (auto const& texture : mSpriteTextureReferences)
+        {
+            mTextureSlots.push_back(texture.Get());
+        }
+
+        std::sort(mTextureSlots.begin(), mTextureSlots.end());
+        mTextureSlots.erase(std::unique(mTextureSlots.begin(), mTextureSlots.end()), mTextureSlots.end());
+
+        // Consecutive sprites usually share a texture, so only search when it changes.
+        ID3D11ShaderResourceView* lastTexture = nullptr;
+        uint32_t lastSlot = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            ID3D11ShaderResourceView* texture = mSpriteQueue[i].texture;
+
+            if (texture != lastTexture)
+            {
+                auto slot = std::lower_bound(mTextureSlots.begin(), mTextureSlots.end(), texture);
+
+                lastSlot = static_cast<uint32_t>(slot - mTextureSlots.begin());
+                lastTexture = texture;
+            }
+
+            keys[i].key = lastSlot;
+            keys[i].index = static_cast<uint32_t>(i);
+        }
+    }
+    else
+    {
+        // Remap the float depth bits so unsigned integer order matches float order.
+        uint32_t invert = (mSortMode == SpriteSortMode_BackToFront) ? UINT32_MAX : 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t bits;
+            memcpy(&bits, &mSpriteQueue[i].originRotationDepth.w, sizeof(bits));
+
+            // Treat -0 the same as +0.
+            if (bits == 0x80000000u)
+                bits = 0;
+
+            uint32_t key = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+
+            keys[i].key = key ^ invert;
+            keys[i].index = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Count the occurrences of each digit, for all four 8-bit digits at once.
+    uint32_t histograms[4][256] = {};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t key = keys[i].key;
+
+        histograms[0][key & 0xFF]++;
+        histograms[1][(key >> 8) & 0xFF]++;
+        histograms[2][(key >> 16) & 0xFF]++;
+        histograms[3][key >> 24]++;
+    }
+
+    for (unsigned int pass = 0; pass < 4; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        unsigned int shift = pass * 8;
+
+        // Skip passes where every key has the same digit, such as the upper bits of texture slot ids.
+        if (histogram[(keys[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+
+        for (size_t digit = 0; digit < 256; digit++)
+        {
+            uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            scratch[histogram[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+        }
+
+        std::swap(keys, scratch);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        mSortedSprites[i] = &mSpriteQueue[keys[i].index];
+    }
+}
+
+
+// Populates the mSortedSprites vector with pointers to individual elements of the mSpriteQueue array.
+void SpriteBatch::Impl::GrowSortedSprites()
+{
+    size_t previousSize = mSortedSprites.size();
+
+    mSortedSprites.resize(mSpriteQueueCount);
+
+    for (size_t i = previousSize; i < mSpriteQueueCount; i++)
+    {
+        mSortedSprites[i] = &mSpriteQueue[i];
+    }
+}
+
+
+// Submits a batch of sprites to the GPU.
+_Use_decl_annotations_
+void SpriteBatch::Impl::RenderBatch(ID3D11ShaderResourceView* texture, SpriteInfo const* const* sprites, size_t count)
+{
+    // Texture arrays swap in their own shaders, which replace any custom shaders for that batch.
+    if (IsTextureArray(texture))
+    {
+        if (!mDeviceResources->arrayVertexShader)
+            throw std::exception("Drawing texture arrays requires Feature Level 10.0 or later");
+
+        if (mMultiViewCount)
+            throw std::exception("Texture array sprites cannot be drawn with multi-view");
+
+        if (!mTextureArrayShadersBound)
+        {
+            SetShaders(true);
+        }
+
+        RenderBatchArray(texture, sprites, count);
+        return;
+    }
+
+    if (mTextureArrayShadersBound)
+    {
+        SetShaders(false);
+
+        // Switching back restores the caller's custom shaders as well as our own.
+        if (mSetCustomShaders)
+        {
+            mSetCustomShaders();
+        }
+    }
+
+    if (mUseInstancing)
+    {
+        RenderBatchInstanced(texture, sprites, count);
+        return;
+    }
+
+    auto deviceContext = mContextResources->deviceContext.Get();
+
+    // Draw using the specified texture.
+    deviceContext->PSSetShaderResources(0, 1, &texture);
+
+    XMVECTOR textureSize = GetTextureSize(texture);
+    XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
+            
+    while (count > 0)
+    {
+        // How many sprites do we want to draw?
+        size_t batchSize = count;
+
+        // How many sprites does the D3D vertex buffer have room for?
+        size_t remainingSpace = MaxBatchSize - mContextResources->vertexBufferPosition;
+
+        if (batchSize > remainingSpace)
+        {
+            if (remainingSpace < MinBatchSize)
+            {
+                // If we are out of room, or about to submit an excessively small batch, wrap back to the start of the vertex buffer.
+                mContextResources->vertexBufferPosition = 0;
+
+                batchSize = std::min(count, MaxBatchSize);
+            }
+            else
+            {
+                // Take however many sprites fit in what's left of the vertex buffer.
+                batchSize = remainingSpace;
+            }
+        }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        void *grfxMemory = GraphicsMemory::Get().Allocate(deviceContext, sizeof(VertexPositionColorTexture) * batchSize * VerticesPerSprite, 64);
+
+        auto vertices = static_cast<VertexPositionColorTexture*>(grfxMemory);
+#else
+        // Lock the vertex buffer.
+        D3D11_MAP mapType = (mContextResources->vertexBufferPosition == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+        D3D11_MAPPED_SUBRESOURCE mappedBuffer;
+
+        ThrowIfFailed(
+            deviceContext->Map(mContextResources->vertexBuffer.Get(), 0, mapType, 0, &mappedBuffer)
+        );
+
+        auto vertices = static_cast<VertexPositionColorTexture*>(mappedBuffer.pData) + mContextResources->vertexBufferPosition * VerticesPerSprite;
+#endif
+
+        // Generate sprite vertex data.
+        ForEachSpriteChunk(mContextResources->vertexBufferPosition, batchSize, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                assert(i < count);
+                _Analysis_assume_(i < count);
+                RenderSprite(sprites[i], vertices + i * VerticesPerSprite, textureSize, inverseTextureSize);
+            }
+        });
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        deviceContext->IASetPlacementVertexBuffer(0, mContextResources->vertexBuffer.Get(), grfxMemory, sizeof(VertexPositionColorTexture));
+#else
+        deviceContext->Unmap(mContextResources->vertexBuffer.Get(), 0);
+#endif
+
+        // Ok lads, the time has come for us draw ourselves some sprites!
+        auto startIndex = static_cast<UINT>(mContextResources->vertexBufferPosition * IndicesPerSprite);
+        auto indexCount = static_cast<UINT>(batchSize * IndicesPerSprite);
+
+        DrawSprites(deviceContext, indexCount, startIndex, 0);
+
+        // Advance the buffer position.
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+        mContextResources->vertexBufferPosition += batchSize;
+#endif
+
+        sprites += batchSize;
+        count -= batchSize;
+    }
+}
+
+
+// Submits a batch of sprites to the GPU as one instance record per sprite.
+_Use_decl_annotations_
+void SpriteBatch::Impl::RenderBatchInstanced(ID3D11ShaderResourceView* texture, SpriteInfo const* const* sprites, size_t count)
+{
+    auto deviceContext = mContextResources->deviceContext.Get();
+
+    // Draw using the specified texture.
+    deviceContext->PSSetShaderResources(0, 1, &texture);
+
+    XMVECTOR textureSize = GetTextureSize(texture);
+    XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
+
+    auto instanceBuffer = mContextResources->GetInstanceBuffer();
+
+    while (count > 0)
+    {
+        // How many sprites do we want to draw?
+        size_t batchSize = count;
+
+        // How many sprites does the D3D instance buffer have room for?
+        size_t remainingSpace = MaxBatchSize - mContextResources->instanceBufferPosition;
+
+        if (batchSize > remainingSpace)
+        {
+            if (remainingSpace < MinBatchSize)
+            {
+                // If we are out of room, or about to submit an excessively small batch, wrap back to the start of the instance buffer.
+                mContextResources->instanceBufferPosition = 0;
+
+                batchSize = std::min(count, MaxBatchSize);
+            }
+            else
+            {
+                // Take however many sprites fit in what's left of the instance buffer.
+                batchSize = remainingSpace;
+            }
+        }
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        void *grfxMemory = GraphicsMemory::Get().Allocate(deviceContext, sizeof(SpriteInstance) * batchSize, 64);
+
+        auto instances = static_cast<SpriteInstance*>(grfxMemory);
+#else
+        // Lock the instance buffer.
+        D3D11_MAP mapType = (mContextResources->instanceBufferPosition == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+        D3D11_MAPPED_SUBRESOURCE mappedBuffer;
+
+        ThrowIfFailed(
+            deviceContext->Map(instanceBuffer, 0, mapType, 0, &mappedBuffer)
+        );
+
+        auto instances = static_cast<SpriteInstance*>(mappedBuffer.pData) + mContextResources->instanceBufferPosition;
+#endif
+
+        // Generate one instance record per sprite.
+        ForEachSpriteChunk(mContextResources->instanceBufferPosition, batchSize, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                assert(i < count);
+                _Analysis_assume_(i < count);
+                RenderSpriteInstance(sprites[i], &instances[i], textureSize, inverseTextureSize);
+            }
+        });
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        deviceContext->IASetPlacementVertexBuffer(0, instanceBuffer, grfxMemory, sizeof(SpriteInstance));
+#else
+        deviceContext->Unmap(instanceBuffer, 0);
+#endif
+
+        // The first six entries of the shared index buffer describe a single quad, which the
+        // vertex shader expands from SV_VertexID, so each sprite is one instance of that quad.
+        auto startInstance = static_cast<UINT>(mContextResources->instanceBufferPosition);
+        auto instanceCount = static_cast<UINT>(batchSize);
 
-        default:
-            break;
+        deviceContext->DrawIndexedInstanced(static_cast<UINT>(IndicesPerSprite), instanceCount, 0, 0, startInstance);
+
+        // Advance the buffer position.
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+        mContextResources->instanceBufferPosition += batchSize;
+#endif
+
+        sprites += batchSize;
+        count -= batchSize;
     }
 }
 
 
-// Populates the mSortedSprites vector with pointers to individual elements of the mSpriteQueue array.
-void SpriteBatch::Impl::GrowSortedSprites()
+// Sorts the queued sprites and generates their vertices into a CPU array, calling visitBatch for each run that shares a texture.
+_Use_decl_annotations_
+void SpriteBatch::Impl::RenderSortedSprites(VertexPositionColorTexture* vertices,
+    std::function<void(ID3D11ShaderResourceView* texture, size_t start, size_t count)> const& visitBatch)
 {
-    size_t previousSize = mSortedSprites.size();
+    SortSprites();
 
-    mSortedSprites.resize(mSpriteQueueCount);
+    size_t batchStart = 0;
 
-    for (size_t i = previousSize; i < mSpriteQueueCount; i++)
+    while (batchStart < mSpriteQueueCount)
     {
-        mSortedSprites[i] = &mSpriteQueue[i];
+        ID3D11ShaderResourceView* texture = mSortedSprites[batchStart]->texture;
+
+        size_t batchEnd = batchStart + 1;
+
+        while (batchEnd < mSpriteQueueCount && mSortedSprites[batchEnd]->texture == texture)
+        {
+            batchEnd++;
+        }
+
+        visitBatch(texture, batchStart, batchEnd - batchStart);
+
+        XMVECTOR textureSize = GetTextureSize(texture);
+        XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
+
+        SpriteInfo const* const* sprites = &mSortedSprites[batchStart];
+        VertexPositionColorTexture* batchVertices = vertices + batchStart * VerticesPerSprite;
+
+        ForEachSpriteChunk(batchStart, batchEnd - batchStart, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                RenderSprite(sprites[i], batchVertices + i * VerticesPerSprite, textureSize, inverseTextureSize);
+            }
+        });
+
+        batchStart = batchEnd;
     }
 }
 
 
-// Submits a batch of sprites to the GPU.
+// Submits a batch of texture array sprites to the GPU.
 _Use_decl_annotations_
-void SpriteBatch::Impl::RenderBatch(ID3D11ShaderResourceView* texture, SpriteInfo const* const* sprites, size_t count)
+void SpriteBatch::Impl::RenderBatchArray(ID3D11ShaderResourceView* texture, SpriteInfo const* const* sprites, size_t count)
 {
     auto deviceContext = mContextResources->deviceContext.Get();
 
-    // Draw using the specified texture.
+    // Draw using the specified texture array.
     deviceContext->PSSetShaderResources(0, 1, &texture);
 
     XMVECTOR textureSize = GetTextureSize(texture);
     XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
-            
+
+    auto vertexBuffer = mContextResources->GetArrayVertexBuffer();
+
     while (count > 0)
     {
         // How many sprites do we want to draw?
         size_t batchSize = count;
 
         // How many sprites does the D3D vertex buffer have room for?
-        size_t remainingSpace = MaxBatchSize - mContextResources->vertexBufferPosition;
+        size_t remainingSpace = MaxBatchSize - mContextResources->arrayVertexBufferPosition;
 
         if (batchSize > remainingSpace)
         {
             if (remainingSpace < MinBatchSize)
             {
                 // If we are out of room, or about to submit an excessively small batch, wrap back to the start of the vertex buffer.
-                mContextResources->vertexBufferPosition = 0;
+                mContextResources->arrayVertexBufferPosition = 0;
 
                 batchSize = std::min(count, MaxBatchSize);
             }
@@ -758,47 +2169,47 @@ void SpriteBatch::Impl::RenderBatch(ID3D11ShaderResourceView* texture, SpriteInf
         }
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
-        void *grfxMemory = GraphicsMemory::Get().Allocate(deviceContext, sizeof(VertexPositionColorTexture) * batchSize * VerticesPerSprite, 64);
+        void *grfxMemory = GraphicsMemory::Get().Allocate(deviceContext, sizeof(SpriteArrayVertex) * batchSize * VerticesPerSprite, 64);
 
-        auto vertices = static_cast<VertexPositionColorTexture*>(grfxMemory);
+        auto vertices = static_cast<SpriteArrayVertex*>(grfxMemory);
 #else
         // Lock the vertex buffer.
-        D3D11_MAP mapType = (mContextResources->vertexBufferPosition == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+        D3D11_MAP mapType = (mContextResources->arrayVertexBufferPosition == 0) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
 
         D3D11_MAPPED_SUBRESOURCE mappedBuffer;
 
         ThrowIfFailed(
-            deviceContext->Map(mContextResources->vertexBuffer.Get(), 0, mapType, 0, &mappedBuffer)
+            deviceContext->Map(vertexBuffer, 0, mapType, 0, &mappedBuffer)
         );
 
-        auto vertices = static_cast<VertexPositionColorTexture*>(mappedBuffer.pData) + mContextResources->vertexBufferPosition * VerticesPerSprite;
+        auto vertices = static_cast<SpriteArrayVertex*>(mappedBuffer.pData) + mContextResources->arrayVertexBufferPosition * VerticesPerSprite;
 #endif
 
         // Generate sprite vertex data.
-        for (size_t i = 0; i < batchSize; i++)
+        ForEachSpriteChunk(mContextResources->arrayVertexBufferPosition, batchSize, [&](size_t begin, size_t end)
         {
-            assert(i < count);
-            _Analysis_assume_(i < count);
-            RenderSprite(sprites[i], vertices, textureSize, inverseTextureSize);
-
-            vertices += VerticesPerSprite;
-        }
+            for (size_t i = begin; i < end; i++)
+            {
+                assert(i < count);
+                _Analysis_assume_(i < count);
+                RenderSpriteArray(sprites[i], vertices + i * VerticesPerSprite, textureSize, inverseTextureSize);
+            }
+        });
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
-        deviceContext->IASetPlacementVertexBuffer(0, mContextResources->vertexBuffer.Get(), grfxMemory, sizeof(VertexPositionColorTexture));
+        deviceContext->IASetPlacementVertexBuffer(0, vertexBuffer, grfxMemory, sizeof(SpriteArrayVertex));
 #else
-        deviceContext->Unmap(mContextResources->vertexBuffer.Get(), 0);
+        deviceContext->Unmap(vertexBuffer, 0);
 #endif
 
-        // Ok lads, the time has come for us draw ourselves some sprites!
-        auto startIndex = static_cast<UINT>(mContextResources->vertexBufferPosition * IndicesPerSprite);
+        auto startIndex = static_cast<UINT>(mContextResources->arrayVertexBufferPosition * IndicesPerSprite);
         auto indexCount = static_cast<UINT>(batchSize * IndicesPerSprite);
 
         deviceContext->DrawIndexed(indexCount, startIndex, 0);
 
         // Advance the buffer position.
 #if !defined(_XBOX_ONE) || !defined(_TITLE)
-        mContextResources->vertexBufferPosition += batchSize;
+        mContextResources->arrayVertexBufferPosition += batchSize;
 #endif
 
         sprites += batchSize;
@@ -807,6 +2218,42 @@ void SpriteBatch::Impl::RenderBatch(ID3D11ShaderResourceView* texture, SpriteInf
 }
 
 
+// Runs generate over [0, count), split across worker threads if parallel vertex generation is enabled.
+void SpriteBatch::Impl::ForEachSpriteChunk(size_t bufferPosition, size_t count, std::function<void(size_t begin, size_t end)> const& generate)
+{
+    if (!mParallelVertexGeneration || count < ParallelMinBatchSize)
+    {
+        generate(0, count);
+        return;
+    }
+
+    // Chunk boundaries fall on multiples of ParallelChunkSize within the vertex buffer, so each
+    // chunk covers whole cache lines and no two workers ever write to the same line of mapped memory.
+    static_assert(((ParallelChunkSize * VerticesPerSprite * sizeof(VertexPositionColorTexture)) % 64) == 0, "Chunks must be cache line aligned");
+    static_assert(((ParallelChunkSize * sizeof(SpriteInstance)) % 64) == 0, "Chunks must be cache line aligned");
+
+    size_t firstChunkSize = std::min(count, ParallelChunkSize - (bufferPosition % ParallelChunkSize));
+    size_t chunkCount = 1 + (count - firstChunkSize + ParallelChunkSize - 1) / ParallelChunkSize;
+
+    auto processChunk = [&](size_t chunkIndex)
+    {
+        size_t begin = (chunkIndex == 0) ? 0 : firstChunkSize + (chunkIndex - 1) * ParallelChunkSize;
+        size_t end = (chunkIndex == 0) ? firstChunkSize : std::min(count, begin + ParallelChunkSize);
+
+        generate(begin, end);
+    };
+
+    if (mTaskScheduler)
+    {
+        mTaskScheduler(chunkCount, processChunk);
+    }
+    else
+    {
+        ParallelFor(chunkCount, processChunk);
+    }
+}
+
+
 // Generates vertex data for drawing a single sprite.
 _Use_decl_annotations_
 void XM_CALLCONV SpriteBatch::Impl::RenderSprite(SpriteInfo const* sprite,
@@ -922,6 +2369,102 @@ void XM_CALLCONV SpriteBatch::Impl::RenderSprite(SpriteInfo const* sprite,
 }
 
 
+// Generates vertex data for drawing a single texture array sprite.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Impl::RenderSpriteArray(SpriteInfo const* sprite,
+    SpriteArrayVertex* vertices,
+    FXMVECTOR textureSize,
+    FXMVECTOR inverseTextureSize)
+{
+    VertexPositionColorTexture corners[VerticesPerSprite];
+
+    RenderSprite(sprite, corners, textureSize, inverseTextureSize);
+
+    auto slice = static_cast<float>(sprite->arraySlice);
+
+    for (size_t i = 0; i < VerticesPerSprite; i++)
+    {
+        vertices[i].position = corners[i].position;
+        vertices[i].color = corners[i].color;
+        vertices[i].textureCoordinate = XMFLOAT3(corners[i].textureCoordinate.x, corners[i].textureCoordinate.y, slice);
+    }
+}
+
+
+// Generates the instance record for drawing a single sprite. This performs the same
+// texel and origin normalization as RenderSprite, leaving rotation to the vertex shader.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Impl::RenderSpriteInstance(SpriteInfo const* sprite,
+    SpriteInstance* instance,
+    FXMVECTOR textureSize,
+    FXMVECTOR inverseTextureSize)
+{
+    // Load sprite parameters into SIMD registers.
+    XMVECTOR source = XMLoadFloat4A(&sprite->source);
+    XMVECTOR destination = XMLoadFloat4A(&sprite->destination);
+    XMVECTOR originRotationDepth = XMLoadFloat4A(&sprite->originRotationDepth);
+
+    unsigned int flags = sprite->flags;
+
+    // Extract the source and destination sizes into separate vectors.
+    XMVECTOR sourceSize = XMVectorSwizzle<2, 3, 2, 3>(source);
+    XMVECTOR destinationSize = XMVectorSwizzle<2, 3, 2, 3>(destination);
+
+    // Scale the origin offset by source size, taking care to avoid overflow if the source region is zero.
+    XMVECTOR isZeroMask = XMVectorEqual(sourceSize, XMVectorZero());
+    XMVECTOR nonZeroSourceSize = XMVectorSelect(sourceSize, g_XMEpsilon, isZeroMask);
+
+    XMVECTOR origin = XMVectorDivide(originRotationDepth, nonZeroSourceSize);
+
+    // Convert the source region from texels to mod-1 texture coordinate format.
+    if (flags & SpriteInfo::SourceInTexels)
+    {
+        source = XMVectorMultiply(source, inverseTextureSize);
+        sourceSize = XMVectorMultiply(sourceSize, inverseTextureSize);
+    }
+    else
+    {
+        origin = XMVectorMultiply(origin, inverseTextureSize);
+    }
+
+    // If the destination size is relative to the source region, convert it to pixels.
+    if (!(flags & SpriteInfo::DestSizeInPixels))
+    {
+        destinationSize = XMVectorMultiply(destinationSize, textureSize);
+    }
+
+    static_assert(SpriteEffects_FlipHorizontally == 1 &&
+                  SpriteEffects_FlipVertically == 2, "If you change these enum values, the mirroring implementation must be updated to match");
+
+    // Mirroring reads the source region from the opposite edge: u' = u + width, width' = -width.
+    static const XMVECTORF32 mirrorScale[4] =
+    {
+        { { {  1,  1, 0, 0 } } },
+        { { { -1,  1, 0, 0 } } },
+        { { {  1, -1, 0, 0 } } },
+        { { { -1, -1, 0, 0 } } },
+    };
+
+    static const XMVECTORF32 mirrorOffset[4] =
+    {
+        { { { 0, 0, 0, 0 } } },
+        { { { 1, 0, 0, 0 } } },
+        { { { 0, 1, 0, 0 } } },
+        { { { 1, 1, 0, 0 } } },
+    };
+
+    const unsigned int mirrorBits = flags & 3u;
+
+    XMVECTOR sourceOrigin = XMVectorMultiplyAdd(mirrorOffset[mirrorBits], sourceSize, source);
+    XMVECTOR sourceExtent = XMVectorMultiply(mirrorScale[mirrorBits], sourceSize);
+
+    XMStoreFloat4(&instance->destination, XMVectorPermute<0, 1, 4, 5>(destination, destinationSize));
+    XMStoreFloat4(&instance->source, XMVectorPermute<0, 1, 4, 5>(sourceOrigin, sourceExtent));
+    XMStoreFloat4(&instance->color, XMLoadFloat4A(&sprite->color));
+    XMStoreFloat4(&instance->originRotationDepth, XMVectorPermute<0, 1, 6, 7>(origin, originRotationDepth));
+}
+
+
 // Helper looks up the size of the specified texture.
 XMVECTOR SpriteBatch::Impl::GetTextureSize(_In_ ID3D11ShaderResourceView* texture)
 {
@@ -951,6 +2494,23 @@ XMVECTOR SpriteBatch::Impl::GetTextureSize(_In_ ID3D11ShaderResourceView* textur
 }
 
 
+// Helper checks whether the specified view selects slices of a texture array.
+bool SpriteBatch::Impl::IsTextureArray(_In_ ID3D11ShaderResourceView* texture)
+{
+    if (texture != mArrayQueryTexture.Get())
+    {
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc;
+
+        texture->GetDesc(&desc);
+
+        mArrayQueryTexture = texture;
+        mArrayQueryResult = (desc.ViewDimension == D3D11_SRV_DIMENSION_TEXTURE2DARRAY);
+    }
+
+    return mArrayQueryResult;
+}
+
+
 // Generates a viewport transform matrix for rendering sprites using x-right y-down screen pixel coordinates.
 XMMATRIX SpriteBatch::Impl::GetViewportTransform(_In_ ID3D11DeviceContext* deviceContext, DXGI_MODE_ROTATION rotation)
 {
@@ -1011,8 +2571,8 @@ XMMATRIX SpriteBatch::Impl::GetViewportTransform(_In_ ID3D11DeviceContext* devic
 
 
 // Public constructor.
-SpriteBatch::SpriteBatch(_In_ ID3D11DeviceContext* deviceContext)
-  : pImpl(std::make_unique<Impl>(deviceContext))
+SpriteBatch::SpriteBatch(_In_ ID3D11DeviceContext* deviceContext, SPRITEBATCH_FLAGS flags)
+  : pImpl(std::make_unique<Impl>(deviceContext, flags))
 {
 }
 
@@ -1182,6 +2742,71 @@ void XM_CALLCONV SpriteBatch::Draw(ID3D11ShaderResourceView* texture,
 }
 
 
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Draw(SpriteList const& spriteList, FXMMATRIX transformMatrix)
+{
+    pImpl->Draw(*spriteList.pImpl, transformMatrix);
+}
+
+
+void SpriteBatch::BeginRecording(SpriteSortMode sortMode)
+{
+    pImpl->BeginRecording(sortMode);
+}
+
+
+std::unique_ptr<SpriteList> SpriteBatch::EndRecording(bool allowUpdates)
+{
+    // SpriteList has a private constructor, so cannot use make_unique here.
+    return std::unique_ptr<SpriteList>(new SpriteList(pImpl->EndRecording(allowUpdates)));
+}
+
+
+void SpriteBatch::EndRecording(SpriteList& spriteList, size_t firstSprite)
+{
+    pImpl->EndRecording(*spriteList.pImpl, firstSprite);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Draw(ID3D11ShaderResourceView* textureArray,
+    UINT arraySlice,
+    XMFLOAT2 const& position,
+    RECT const* sourceRectangle,
+    FXMVECTOR color,
+    float rotation,
+    XMFLOAT2 const& origin,
+    float scale,
+    SpriteEffects effects,
+    float layerDepth)
+{
+    XMVECTOR destination = XMVectorPermute<0, 1, 4, 4>(XMLoadFloat2(&position), XMLoadFloat(&scale)); // x, y, scale, scale
+
+    XMVECTOR originRotationDepth = XMVectorSet(origin.x, origin.y, rotation, layerDepth);
+
+    pImpl->Draw(textureArray, destination, sourceRectangle, color, originRotationDepth, static_cast<unsigned int>(effects), arraySlice);
+}
+
+
+_Use_decl_annotations_
+void XM_CALLCONV SpriteBatch::Draw(ID3D11ShaderResourceView* textureArray,
+    UINT arraySlice,
+    RECT const& destinationRectangle,
+    RECT const* sourceRectangle,
+    FXMVECTOR color,
+    float rotation,
+    XMFLOAT2 const& origin,
+    SpriteEffects effects,
+    float layerDepth)
+{
+    XMVECTOR destination = LoadRect(&destinationRectangle); // x, y, w, h
+
+    XMVECTOR originRotationDepth = XMVectorSet(origin.x, origin.y, rotation, layerDepth);
+
+    pImpl->Draw(textureArray, destination, sourceRectangle, color, originRotationDepth, static_cast<unsigned int>(effects) | Impl::SpriteInfo::DestSizeInPixels, arraySlice);
+}
+
+
 void SpriteBatch::SetRotation(DXGI_MODE_ROTATION mode)
 {
     pImpl->mRotation = mode;
@@ -1199,3 +2824,80 @@ void SpriteBatch::SetViewport(const D3D11_VIEWPORT& viewPort)
     pImpl->mSetViewport = true;
     pImpl->mViewPort = viewPort;
 }
+
+
+void SpriteBatch::SetParallelVertexGeneration(bool enable, TaskScheduler scheduler)
+{
+    pImpl->mParallelVertexGeneration = enable;
+    pImpl->mTaskScheduler = enable ? scheduler : nullptr;
+}
+
+
+_Use_decl_annotations_
+void SpriteBatch::SetDistanceField(SpriteDistanceFieldSettings const* settings)
+{
+    pImpl->SetDistanceField(settings);
+}
+
+
+_Use_decl_annotations_
+void SpriteBatch::SetClipRectangle(RECT const* clipRectangle)
+{
+    pImpl->SetClipRectangle(clipRectangle);
+}
+
+
+_Use_decl_annotations_
+void SpriteBatch::SetMultiView(size_t count, D3D11_VIEWPORT const* viewports, XMMATRIX const* viewTransforms)
+{
+    pImpl->SetMultiView(count, viewports, viewTransforms);
+}
+
+
+//--------------------------------------------------------------------------------------
+// SpriteList
+//--------------------------------------------------------------------------------------
+
+SpriteList::SpriteList(std::unique_ptr<Impl> impl) noexcept
+  : pImpl(std::move(impl))
+{
+}
+
+
+// Move constructor.
+SpriteList::SpriteList(SpriteList&& moveFrom) noexcept
+  : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+SpriteList& SpriteList::operator= (SpriteList&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+SpriteList::~SpriteList()
+{
+}
+
+
+size_t SpriteList::GetSpriteCount() const noexcept
+{
+    return pImpl->spriteCount;
+}
+
+
+size_t SpriteList::GetBatchCount() const noexcept
+{
+    return pImpl->batches.size();
+}
+
+
+bool SpriteList::IsUpdatable() const noexcept
+{
+    return pImpl->updatable;
+}
@@ -15,7 +15,9 @@
 #include "SpriteFont.h"
 #include "DirectXHelpers.h"
 #include "BinaryReader.h"
+#include "DynamicGlyphCache.h"
 #include "LoaderHelpers.h"
+#include "SpriteFontFormat.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -26,9 +28,12 @@ class SpriteFont::Impl
 {
 public:
     Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader, bool forceSRGB);
+    Impl(_In_ ID3D11Device* device, _In_reads_bytes_(dataSize) uint8_t const* data, size_t dataSize, ScopedMappedView&& mappedView, bool forceSRGB);
     Impl(_In_ ID3D11ShaderResourceView* texture, _In_reads_(glyphCount) Glyph const* glyphs, _In_ size_t glyphCount, _In_ float lineSpacing);
+    Impl(_In_ ID3D11Device* device, _In_ IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize);
 
     Glyph const* FindGlyph(wchar_t character) const;
+    bool ContainsCharacter(wchar_t character) const noexcept;
 
     void SetDefaultCharacter(wchar_t character);
 
@@ -37,13 +42,50 @@ public:
 
     const wchar_t* ConvertUTF8(_In_z_ const char *text);
 
+    void XM_CALLCONV DrawGlyph(_In_ SpriteBatch* spriteBatch,
+        _In_ Glyph const* glyph,
+        float x,
+        float y,
+        FXMVECTOR position,
+        FXMVECTOR color,
+        float rotation,
+        FXMVECTOR baseOffset,
+        GXMVECTOR scale,
+        SpriteEffects effects,
+        float layerDepth) const;
+
     // Fields.
     ComPtr<ID3D11ShaderResourceView> texture;
     std::vector<Glyph> glyphs;
     Glyph const* defaultGlyph;
     float lineSpacing;
 
+    SpriteDistanceField distanceField;
+    float distanceFieldRange;
+
+    // Only set for dynamic fonts, which find their glyphs here rather than in the glyphs vector.
+    std::unique_ptr<DynamicGlyphCache> glyphCache;
+
 private:
+    void CreateGlyphTable();
+    void CreateTexture(_In_ ID3D11Device* device, DXGI_FORMAT format, uint32_t width, uint32_t height, _In_ void const* data, uint32_t stride);
+    Glyph const* LookupGlyph(wchar_t character) const noexcept;
+
+    // Direct-indexed lookup table for FindGlyph, split into pages of GlyphPageSize characters. Pages are
+    // only allocated for the ranges of the Basic Multilingual Plane that the font actually contains.
+    static const size_t GlyphPageSize = 256;
+    static const size_t GlyphPageCount = 0x10000 / GlyphPageSize;
+
+    std::vector<std::unique_ptr<Glyph const*[]>> glyphPages;
+
+    // Version 2 fonts use the glyph table and lookup index from the file in place, either from the mapped file
+    // or, for fonts created from memory, from a copy of the tables.
+    ScopedMappedView mappedFile;
+    std::unique_ptr<uint8_t[]> tableCopy;
+    Glyph const* indexedGlyphs;
+    uint16_t const* indexedPageMap;
+    uint16_t const* indexedPages;
+
     size_t utfBufferSize;
     std::unique_ptr<wchar_t[]> utfBuffer;
 };
@@ -54,23 +96,64 @@ const XMFLOAT2 SpriteFont::Float2Zero(0, 0);
 
 static const char spriteFontMagic[] = "DXTKfont";
 
+// Optional block after the texture data, describing a distance field sprite sheet. Older readers ignore it.
+static const char distanceFieldMagic[] = "DXTKdfld";
 
-// Comparison operators make our sorted glyph vector work with std::binary_search and lower_bound.
-namespace DirectX
+
+namespace
 {
-    static inline bool operator< (SpriteFont::Glyph const& left, SpriteFont::Glyph const& right) noexcept
+    static_assert(SpriteEffects_FlipHorizontally == 1 &&
+                  SpriteEffects_FlipVertically == 2, "If you change these enum values, the following tables must be updated to match");
+
+    // Lookup table indicates which way to move along each axis per SpriteEffects enum value.
+    const XMVECTORF32 axisDirectionTable[4] =
     {
-        return left.Character < right.Character;
-    }
+        { { { -1, -1, 0, 0 } } },
+        { { {  1, -1, 0, 0 } } },
+        { { { -1,  1, 0, 0 } } },
+        { { {  1,  1, 0, 0 } } },
+    };
 
-    static inline bool operator< (wchar_t left, SpriteFont::Glyph const& right) noexcept
+    // Lookup table indicates which axes are mirrored for each SpriteEffects enum value.
+    const XMVECTORF32 axisIsMirroredTable[4] =
     {
-        return left < right.Character;
-    }
+        { { { 0, 0, 0, 0 } } },
+        { { { 1, 0, 0, 0 } } },
+        { { { 0, 1, 0, 0 } } },
+        { { { 1, 1, 0, 0 } } },
+    };
+}
+
+
+// Internal SpriteFont::TextLayout implementation class.
+class SpriteFont::TextLayout::Impl
+{
+public:
+    // A glyph positioned by SpriteFont::Impl::ForEachGlyph.
+    struct PlacedGlyph
+    {
+        Glyph const* glyph;
+        float x;
+        float y;
+        float advance;
+    };
+
+    Impl(SpriteFont::Impl const* ifont, _In_z_ wchar_t const* text);
 
-    static inline bool operator< (SpriteFont::Glyph const& left, wchar_t right) noexcept
+    RECT MeasureDrawBounds(XMFLOAT2 const& position) const noexcept;
+
+    SpriteFont::Impl const* font;
+    std::vector<PlacedGlyph> glyphs;
+    XMFLOAT2 size;
+};
+
+
+// Comparison operator lets std::is_sorted validate the order of user specified glyphs.
+namespace DirectX
+{
+    static inline bool operator< (SpriteFont::Glyph const& left, SpriteFont::Glyph const& right) noexcept
     {
-        return left.Character < right;
+        return left.Character < right.Character;
     }
 }
 
@@ -78,6 +161,11 @@ namespace DirectX
 // Reads a SpriteFont from the binary format created by the MakeSpriteFont utility.
 SpriteFont::Impl::Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader, bool forceSRGB) :
     defaultGlyph(nullptr),
+    distanceField(SpriteDistanceField_None),
+    distanceFieldRange(0),
+    indexedGlyphs(nullptr),
+    indexedPageMap(nullptr),
+    indexedPages(nullptr),
     utfBufferSize(0)
 {
     // Validate the header.
@@ -96,6 +184,8 @@ SpriteFont::Impl::Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader, boo
 
     glyphs.assign(glyphData, glyphData + glyphCount);
 
+    CreateGlyphTable();
+
     // Read font properties.
     lineSpacing = reader->Read<float>();
 
@@ -109,15 +199,164 @@ SpriteFont::Impl::Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader, boo
     auto textureRows = reader->Read<uint32_t>();
     auto textureData = reader->ReadArray<uint8_t>(size_t(textureStride) * size_t(textureRows));
 
+    // Read the optional distance field description.
+    if (reader->Remaining() >= sizeof(distanceFieldMagic) - 1 + sizeof(uint32_t) + sizeof(float))
+    {
+        auto magic = reader->ReadArray<char>(sizeof(distanceFieldMagic) - 1);
+
+        if (memcmp(magic, distanceFieldMagic, sizeof(distanceFieldMagic) - 1) == 0)
+        {
+            auto type = reader->Read<uint32_t>();
+            auto range = reader->Read<float>();
+
+            if (type > SpriteDistanceField_MultiChannel || !(range > 0.f))
+            {
+                DebugTrace("ERROR: SpriteFont provided with an invalid distance field (type %u, range %f)\n", type, double(range));
+                throw std::exception("Invalid distance field in .spritefont file");
+            }
+
+            distanceField = static_cast<SpriteDistanceField>(type);
+            distanceFieldRange = range;
+        }
+    }
+
+    if (forceSRGB)
+    {
+        textureFormat = LoaderHelpers::MakeSRGB(textureFormat);
+    }
+
+    CreateTexture(device, textureFormat, textureWidth, textureHeight, textureData, textureStride);
+}
+
+
+// Reads a SpriteFont from the version 2 format (see SpriteFontFormat.h). With a mapped view, which is kept for the
+// lifetime of the font, the glyph table and lookup index are used straight from the file; otherwise they are copied.
+_Use_decl_annotations_
+SpriteFont::Impl::Impl(ID3D11Device* device, uint8_t const* data, size_t dataSize, ScopedMappedView&& mappedView, bool forceSRGB) :
+    defaultGlyph(nullptr),
+    distanceField(SpriteDistanceField_None),
+    distanceFieldRange(0),
+    indexedGlyphs(nullptr),
+    indexedPageMap(nullptr),
+    indexedPages(nullptr),
+    utfBufferSize(0)
+{
+    using namespace SpriteFontFormat;
+
+    static_assert(sizeof(Glyph) == 32, "Glyph layout must match the spritefont glyph table");
+    static_assert(PAGE_SIZE == GlyphPageSize && PAGE_COUNT == GlyphPageCount, "Spritefont index must match the glyph lookup table");
+
+    // Validate the header.
+    if (dataSize < sizeof(Header))
+        throw std::exception("End of file");
+
+    auto header = reinterpret_cast<Header const*>(data);
+
+    if (memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION)
+    {
+        DebugTrace("ERROR: SpriteFont provided with an invalid .spritefont file\n");
+        throw std::exception("Not a MakeSpriteFont output binary");
+    }
+
+    if (header->fileSize > dataSize)
+        throw std::exception("End of file");
+
+    // Every table must lie inside the file, and start on the boundary its contents need.
+    auto fitsInFile = [&](uint32_t offset, uint64_t size, uint32_t alignment)
+    {
+        return (offset % alignment) == 0 && offset >= sizeof(Header) && uint64_t(offset) + size <= header->fileSize;
+    };
+
+    uint64_t textureSize = uint64_t(header->textureStride) * uint64_t(header->textureRows);
+
+    if (header->glyphCount >= NO_GLYPH
+        || header->pageCount > PAGE_COUNT
+        || !fitsInFile(header->glyphsOffset, uint64_t(header->glyphCount) * sizeof(Glyph), 4)
+        || !fitsInFile(header->pageMapOffset, PAGE_COUNT * sizeof(uint16_t), 4)
+        || !fitsInFile(header->pagesOffset, uint64_t(header->pageCount) * PAGE_SIZE * sizeof(uint16_t), 4)
+        || !fitsInFile(header->textureOffset, textureSize, DATA_ALIGNMENT))
+    {
+        DebugTrace("ERROR: SpriteFont provided with a corrupt .spritefont file\n");
+        throw std::exception("Invalid .spritefont file");
+    }
+
+    // The texture data must hold every row the format needs, since it is given to D3D without copying.
+    auto textureFormat = static_cast<DXGI_FORMAT>(header->textureFormat);
+
+    size_t rowBytes, numRows;
+    if (FAILED(LoaderHelpers::GetSurfaceInfo(header->textureWidth, header->textureHeight, textureFormat, nullptr, &rowBytes, &numRows))
+        || header->textureStride < rowBytes
+        || header->textureRows < numRows)
+    {
+        DebugTrace("ERROR: SpriteFont provided with an invalid texture (%u x %u, format %u)\n", header->textureWidth, header->textureHeight, header->textureFormat);
+        throw std::exception("Invalid texture in .spritefont file");
+    }
+
+    if (header->distanceField > SpriteDistanceField_MultiChannel
+        || (header->distanceField != SpriteDistanceField_None && !(header->distanceFieldRange > 0.f)))
+    {
+        DebugTrace("ERROR: SpriteFont provided with an invalid distance field (type %u, range %f)\n", header->distanceField, double(header->distanceFieldRange));
+        throw std::exception("Invalid distance field in .spritefont file");
+    }
+
+    // Use the tables in place, or copy them when the caller keeps ownership of the data. Tables come before the texture.
+    uint8_t const* tables = data;
+
+    if (mappedView)
+    {
+        mappedFile = std::move(mappedView);
+    }
+    else
+    {
+        size_t tablesSize = std::max({ header->glyphsOffset + header->glyphCount * sizeof(Glyph),
+                                       header->pageMapOffset + PAGE_COUNT * sizeof(uint16_t),
+                                       header->pagesOffset + header->pageCount * PAGE_SIZE * sizeof(uint16_t) });
+
+        tableCopy.reset(new uint8_t[tablesSize]);
+        memcpy(tableCopy.get(), data, tablesSize);
+
+        tables = tableCopy.get();
+    }
+
+    indexedGlyphs = reinterpret_cast<Glyph const*>(tables + header->glyphsOffset);
+    indexedPageMap = reinterpret_cast<uint16_t const*>(tables + header->pageMapOffset);
+    indexedPages = reinterpret_cast<uint16_t const*>(tables + header->pagesOffset);
+
+    // Lookups index straight into the tables, so check every entry once here.
+    for (size_t page = 0; page < PAGE_COUNT; ++page)
+    {
+        if (indexedPageMap[page] > header->pageCount)
+            throw std::exception("Invalid .spritefont index");
+    }
+
+    for (size_t entry = 0; entry < size_t(header->pageCount) * PAGE_SIZE; ++entry)
+    {
+        if (indexedPages[entry] != NO_GLYPH && indexedPages[entry] >= header->glyphCount)
+            throw std::exception("Invalid .spritefont index");
+    }
+
+    lineSpacing = header->lineSpacing;
+    distanceField = static_cast<SpriteDistanceField>(header->distanceField);
+    distanceFieldRange = header->distanceFieldRange;
+
+    SetDefaultCharacter(static_cast<wchar_t>(header->defaultCharacter));
+
     if (forceSRGB)
     {
         textureFormat = LoaderHelpers::MakeSRGB(textureFormat);
     }
 
-    // Create the D3D texture.
-    CD3D11_TEXTURE2D_DESC textureDesc(textureFormat, textureWidth, textureHeight, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
-    CD3D11_SHADER_RESOURCE_VIEW_DESC viewDesc(D3D11_SRV_DIMENSION_TEXTURE2D, textureFormat);
-    D3D11_SUBRESOURCE_DATA initData = { textureData, textureStride, 0 };
+    CreateTexture(device, textureFormat, header->textureWidth, header->textureHeight, data + header->textureOffset, header->textureStride);
+}
+
+
+// Creates the sprite sheet texture.
+_Use_decl_annotations_
+void SpriteFont::Impl::CreateTexture(ID3D11Device* device, DXGI_FORMAT format, uint32_t width, uint32_t height, void const* data, uint32_t stride)
+{
+    CD3D11_TEXTURE2D_DESC textureDesc(format, width, height, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+    CD3D11_SHADER_RESOURCE_VIEW_DESC viewDesc(D3D11_SRV_DIMENSION_TEXTURE2D, format);
+    D3D11_SUBRESOURCE_DATA initData = { data, stride, 0 };
     ComPtr<ID3D11Texture2D> texture2D;
 
     ThrowIfFailed(
@@ -140,23 +379,88 @@ SpriteFont::Impl::Impl(ID3D11ShaderResourceView* itexture, Glyph const* iglyphs,
     glyphs(iglyphs, iglyphs + glyphCount),
     defaultGlyph(nullptr),
     lineSpacing(ilineSpacing),
+    distanceField(SpriteDistanceField_None),
+    distanceFieldRange(0),
+    indexedGlyphs(nullptr),
+    indexedPageMap(nullptr),
+    indexedPages(nullptr),
     utfBufferSize(0)
 {
     if (!std::is_sorted(iglyphs, iglyphs + glyphCount))
     {
         throw std::exception("Glyphs must be in ascending codepoint order");
     }
+
+    CreateGlyphTable();
+}
+
+
+// Constructs a dynamic font, which rasterizes glyphs into its atlas as they are first drawn.
+_Use_decl_annotations_
+SpriteFont::Impl::Impl(ID3D11Device* device, IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize)
+    : defaultGlyph(nullptr),
+    distanceField(SpriteDistanceField_None),
+    distanceFieldRange(0),
+    glyphCache(std::make_unique<DynamicGlyphCache>(device, fontFace, fontSize, atlasSize)),
+    indexedGlyphs(nullptr),
+    indexedPageMap(nullptr),
+    indexedPages(nullptr),
+    utfBufferSize(0)
+{
+    texture = glyphCache->GetTexture();
+    lineSpacing = glyphCache->GetLineSpacing();
+}
+
+
+// Builds the direct-indexed glyph lookup table.
+void SpriteFont::Impl::CreateGlyphTable()
+{
+    glyphPages.resize(GlyphPageCount);
+
+    for (auto const& glyph : glyphs)
+    {
+        // Characters outside the Basic Multilingual Plane cannot be passed as a wchar_t.
+        if (glyph.Character >= GlyphPageSize * GlyphPageCount)
+            continue;
+
+        auto& page = glyphPages[glyph.Character / GlyphPageSize];
+
+        if (!page)
+        {
+            page.reset(new Glyph const*[GlyphPageSize]());
+        }
+
+        // Keep the first of any duplicate entries.
+        auto& entry = page[glyph.Character % GlyphPageSize];
+
+        if (!entry)
+        {
+            entry = &glyph;
+        }
+    }
 }
 
 
 // Looks up the requested glyph, falling back to the default character if it is not in the font.
 SpriteFont::Glyph const* SpriteFont::Impl::FindGlyph(wchar_t character) const
 {
-    auto glyph = std::lower_bound(glyphs.begin(), glyphs.end(), character);
+    if (glyphCache)
+    {
+        auto glyph = glyphCache->FindGlyph(character);
 
-    if (glyph != glyphs.end() && glyph->Character == character)
+        if (glyph)
+        {
+            return glyph;
+        }
+    }
+    else
     {
-        return &*glyph;
+        auto glyph = LookupGlyph(character);
+
+        if (glyph)
+        {
+            return glyph;
+        }
     }
 
     if (defaultGlyph)
@@ -169,6 +473,51 @@ SpriteFont::Glyph const* SpriteFont::Impl::FindGlyph(wchar_t character) const
 }
 
 
+// Checks whether the font has a glyph for the requested character, ignoring the default character.
+bool SpriteFont::Impl::ContainsCharacter(wchar_t character) const noexcept
+{
+    if (glyphCache)
+    {
+        try
+        {
+            return glyphCache->FindGlyph(character) != nullptr;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    return LookupGlyph(character) != nullptr;
+}
+
+
+// Looks up a glyph of a static font in its direct-indexed table, returning null if the font does not contain it.
+SpriteFont::Glyph const* SpriteFont::Impl::LookupGlyph(wchar_t character) const noexcept
+{
+    auto index = static_cast<size_t>(character);
+
+    if (index >= GlyphPageSize * GlyphPageCount)
+        return nullptr;
+
+    if (indexedGlyphs)
+    {
+        auto page = indexedPageMap[index / GlyphPageSize];
+
+        if (!page)
+            return nullptr;
+
+        auto entry = indexedPages[(page - 1) * GlyphPageSize + index % GlyphPageSize];
+
+        return (entry != SpriteFontFormat::NO_GLYPH) ? &indexedGlyphs[entry] : nullptr;
+    }
+
+    auto page = glyphPages[index / GlyphPageSize].get();
+
+    return page ? page[index % GlyphPageSize] : nullptr;
+}
+
+
 // Sets the missing-character fallback glyph.
 void SpriteFont::Impl::SetDefaultCharacter(wchar_t character)
 {
@@ -259,12 +608,133 @@ const wchar_t* SpriteFont::Impl::ConvertUTF8(_In_z_ const char *text)
 }
 
 
+// Draws a single glyph placed by ForEachGlyph, shared between the string and TextLayout overloads of DrawString.
+_Use_decl_annotations_
+void XM_CALLCONV SpriteFont::Impl::DrawGlyph(SpriteBatch* spriteBatch,
+    Glyph const* glyph,
+    float x,
+    float y,
+    FXMVECTOR position,
+    FXMVECTOR color,
+    float rotation,
+    FXMVECTOR baseOffset,
+    GXMVECTOR scale,
+    SpriteEffects effects,
+    float layerDepth) const
+{
+    // Dynamic glyphs still being rasterized keep their place in the layout but are not drawn yet.
+    if (glyphCache && !glyphCache->Touch(glyph))
+        return;
+
+    XMVECTOR offset = XMVectorMultiplyAdd(XMVectorSet(x, y + glyph->YOffset, 0, 0), axisDirectionTable[effects & 3], baseOffset);
+
+    if (effects)
+    {
+        // For mirrored characters, specify bottom and/or right instead of top left.
+        XMVECTOR glyphRect = XMConvertVectorIntToFloat(XMLoadInt4(reinterpret_cast<uint32_t const*>(&glyph->Subrect)), 0);
+
+        // xy = glyph width/height.
+        glyphRect = XMVectorSubtract(XMVectorSwizzle<2, 3, 0, 1>(glyphRect), glyphRect);
+
+        offset = XMVectorMultiplyAdd(glyphRect, axisIsMirroredTable[effects & 3], offset);
+    }
+
+    spriteBatch->Draw(texture.Get(), position, &glyph->Subrect, color, rotation, offset, scale, effects, layerDepth);
+}
+
+
+// Lays out a string, caching the same glyph positions and size that DrawString and MeasureString compute.
+_Use_decl_annotations_
+SpriteFont::TextLayout::Impl::Impl(SpriteFont::Impl const* ifont, wchar_t const* text)
+    : font(ifont),
+    size(0, 0)
+{
+    XMVECTOR result = XMVectorZero();
+
+    font->ForEachGlyph(text, [&](Glyph const* glyph, float x, float y, float advance)
+    {
+        PlacedGlyph placed = { glyph, x, y, advance };
+
+        glyphs.push_back(placed);
+
+        auto w = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+        auto h = static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top) + glyph->YOffset;
+
+        h = std::max(h, font->lineSpacing);
+
+        result = XMVectorMax(result, XMVectorSet(x + w, y + h, 0, 0));
+    });
+
+    XMStoreFloat2(&size, result);
+}
+
+
+// Computes draw bounds from the cached glyphs, matching SpriteFont::MeasureDrawBounds.
+RECT SpriteFont::TextLayout::Impl::MeasureDrawBounds(XMFLOAT2 const& position) const noexcept
+{
+    RECT result = { LONG_MAX, LONG_MAX, 0, 0 };
+
+    for (auto const& placed : glyphs)
+    {
+        auto glyph = placed.glyph;
+
+        auto w = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+        auto h = static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top);
+
+        float minX = position.x + placed.x;
+        float minY = position.y + placed.y + glyph->YOffset;
+
+        float maxX = std::max(minX + placed.advance, minX + w);
+        float maxY = minY + h;
+
+        if (minX < result.left)
+            result.left = long(minX);
+
+        if (minY < result.top)
+            result.top = long(minY);
+
+        if (result.right < maxX)
+            result.right = long(maxX);
+
+        if (result.bottom < maxY)
+            result.bottom = long(maxY);
+    }
+
+    if (result.left == LONG_MAX)
+    {
+        result.left = 0;
+        result.top = 0;
+    }
+
+    return result;
+}
+
+
 // Construct from a binary file created by the MakeSpriteFont utility.
 SpriteFont::SpriteFont(_In_ ID3D11Device* device, _In_z_ wchar_t const* fileName, bool forceSRGB)
 {
-    BinaryReader reader(fileName);
+    size_t dataSize = 0;
+    ScopedMappedView data;
+    HRESULT hr = BinaryReader::MapEntireFile(fileName, data, &dataSize);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: SpriteFont failed (%08X) loading '%ls'\n", hr, fileName);
+        throw std::exception("SpriteFont");
+    }
+
+    auto bytes = static_cast<uint8_t const*>(data.get());
+
+    // Version 2 fonts keep the view, and version 1 fonts are read from it without a heap copy of the file.
+    if (dataSize >= sizeof(SpriteFontFormat::Header) && memcmp(bytes, SpriteFontFormat::MAGIC, sizeof(SpriteFontFormat::MAGIC) - 1) == 0)
+    {
+        pImpl = std::make_unique<Impl>(device, bytes, dataSize, std::move(data), forceSRGB);
+    }
+    else
+    {
+        BinaryReader reader(bytes, dataSize);
 
-    pImpl = std::make_unique<Impl>(device, &reader, forceSRGB);
+        pImpl = std::make_unique<Impl>(device, &reader, forceSRGB);
+    }
 }
 
 
@@ -272,9 +742,16 @@ SpriteFont::SpriteFont(_In_ ID3D11Device* device, _In_z_ wchar_t const* fileName
 _Use_decl_annotations_
 SpriteFont::SpriteFont(ID3D11Device* device, uint8_t const* dataBlob, size_t dataSize, bool forceSRGB)
 {
-    BinaryReader reader(dataBlob, dataSize);
+    if (dataSize >= sizeof(SpriteFontFormat::Header) && memcmp(dataBlob, SpriteFontFormat::MAGIC, sizeof(SpriteFontFormat::MAGIC) - 1) == 0)
+    {
+        pImpl = std::make_unique<Impl>(device, dataBlob, dataSize, ScopedMappedView(), forceSRGB);
+    }
+    else
+    {
+        BinaryReader reader(dataBlob, dataSize);
 
-    pImpl = std::make_unique<Impl>(device, &reader, forceSRGB);
+        pImpl = std::make_unique<Impl>(device, &reader, forceSRGB);
+    }
 }
 
 
@@ -286,6 +763,14 @@ SpriteFont::SpriteFont(ID3D11ShaderResourceView* texture, Glyph const* glyphs, s
 }
 
 
+// Construct a dynamic font from a DirectWrite font face.
+_Use_decl_annotations_
+SpriteFont::SpriteFont(ID3D11Device* device, IDWriteFontFace* fontFace, float fontSize, unsigned int atlasSize)
+    : pImpl(std::make_unique<Impl>(device, fontFace, fontSize, atlasSize))
+{
+}
+
+
 // Move constructor.
 SpriteFont::SpriteFont(SpriteFont&& moveFrom) noexcept
     : pImpl(std::move(moveFrom.pImpl))
@@ -328,27 +813,6 @@ void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, _In_z_ wc
 
 void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, _In_z_ wchar_t const* text, FXMVECTOR position, FXMVECTOR color, float rotation, FXMVECTOR origin, GXMVECTOR scale, SpriteEffects effects, float layerDepth) const
 {
-    static_assert(SpriteEffects_FlipHorizontally == 1 &&
-                  SpriteEffects_FlipVertically == 2, "If you change these enum values, the following tables must be updated to match");
-
-    // Lookup table indicates which way to move along each axis per SpriteEffects enum value.
-    static XMVECTORF32 axisDirectionTable[4] =
-    {
-        { { { -1, -1, 0, 0 } } },
-        { { {  1, -1, 0, 0 } } },
-        { { { -1,  1, 0, 0 } } },
-        { { {  1,  1, 0, 0 } } },
-    };
-
-    // Lookup table indicates which axes are mirrored for each SpriteEffects enum value.
-    static XMVECTORF32 axisIsMirroredTable[4] =
-    {
-        { { { 0, 0, 0, 0 } } },
-        { { { 1, 0, 0, 0 } } },
-        { { { 0, 1, 0, 0 } } },
-        { { { 1, 1, 0, 0 } } },
-    };
-
     XMVECTOR baseOffset = origin;
 
     // If the text is mirrored, offset the start position accordingly.
@@ -365,20 +829,7 @@ void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, _In_z_ wc
     {
         UNREFERENCED_PARAMETER(advance);
 
-        XMVECTOR offset = XMVectorMultiplyAdd(XMVectorSet(x, y + glyph->YOffset, 0, 0), axisDirectionTable[effects & 3], baseOffset);
-
-        if (effects)
-        {
-            // For mirrored characters, specify bottom and/or right instead of top left.
-            XMVECTOR glyphRect = XMConvertVectorIntToFloat(XMLoadInt4(reinterpret_cast<uint32_t const*>(&glyph->Subrect)), 0);
-
-            // xy = glyph width/height.
-            glyphRect = XMVectorSubtract(XMVectorSwizzle<2, 3, 0, 1>(glyphRect), glyphRect);
-
-            offset = XMVectorMultiplyAdd(glyphRect, axisIsMirroredTable[effects & 3], offset);
-        }
-
-        spriteBatch->Draw(pImpl->texture.Get(), position, &glyph->Subrect, color, rotation, offset, scale, effects, layerDepth);
+        pImpl->DrawGlyph(spriteBatch, glyph, x, y, position, color, rotation, baseOffset, scale, effects, layerDepth);
     });
 }
 
@@ -496,6 +947,50 @@ RECT XM_CALLCONV SpriteFont::MeasureDrawBounds(_In_z_ char const* text, FXMVECTO
 }
 
 
+// Pre-shaped text
+void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, XMFLOAT2 const& position, FXMVECTOR color, float rotation, XMFLOAT2 const& origin, float scale, SpriteEffects effects, float layerDepth) const
+{
+    DrawString(spriteBatch, layout, XMLoadFloat2(&position), color, rotation, XMLoadFloat2(&origin), XMVectorReplicate(scale), effects, layerDepth);
+}
+
+
+void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, XMFLOAT2 const& position, FXMVECTOR color, float rotation, XMFLOAT2 const& origin, XMFLOAT2 const& scale, SpriteEffects effects, float layerDepth) const
+{
+    DrawString(spriteBatch, layout, XMLoadFloat2(&position), color, rotation, XMLoadFloat2(&origin), XMLoadFloat2(&scale), effects, layerDepth);
+}
+
+
+void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, FXMVECTOR position, FXMVECTOR color, float rotation, FXMVECTOR origin, float scale, SpriteEffects effects, float layerDepth) const
+{
+    DrawString(spriteBatch, layout, position, color, rotation, origin, XMVectorReplicate(scale), effects, layerDepth);
+}
+
+
+void XM_CALLCONV SpriteFont::DrawString(_In_ SpriteBatch* spriteBatch, TextLayout const& layout, FXMVECTOR position, FXMVECTOR color, float rotation, FXMVECTOR origin, GXMVECTOR scale, SpriteEffects effects, float layerDepth) const
+{
+    auto layoutImpl = layout.pImpl.get();
+
+    if (layoutImpl->font != pImpl.get())
+        throw std::exception("TextLayout was created for a different SpriteFont");
+
+    XMVECTOR baseOffset = origin;
+
+    // If the text is mirrored, offset the start position accordingly.
+    if (effects)
+    {
+        baseOffset = XMVectorNegativeMultiplySubtract(
+            XMLoadFloat2(&layoutImpl->size),
+            axisIsMirroredTable[effects & 3],
+            baseOffset);
+    }
+
+    for (auto const& placed : layoutImpl->glyphs)
+    {
+        pImpl->DrawGlyph(spriteBatch, placed.glyph, placed.x, placed.y, position, color, rotation, baseOffset, scale, effects, layerDepth);
+    }
+}
+
+
 // Spacing properties
 float SpriteFont::GetLineSpacing() const noexcept
 {
@@ -524,7 +1019,44 @@ void SpriteFont::SetDefaultCharacter(wchar_t character)
 
 bool SpriteFont::ContainsCharacter(wchar_t character) const
 {
-    return std::binary_search(pImpl->glyphs.begin(), pImpl->glyphs.end(), character);
+    return pImpl->ContainsCharacter(character);
+}
+
+
+SpriteDistanceField SpriteFont::GetDistanceFieldType() const noexcept
+{
+    return pImpl->distanceField;
+}
+
+
+float SpriteFont::GetDistanceFieldRange() const noexcept
+{
+    return pImpl->distanceFieldRange;
+}
+
+
+// Settings for drawing this font's plain fill, ready for an outline or shadow to be added.
+SpriteDistanceFieldSettings SpriteFont::GetDistanceFieldSettings() const noexcept
+{
+    SpriteDistanceFieldSettings settings = {};
+
+    settings.type = pImpl->distanceField;
+    settings.distanceRange = pImpl->distanceFieldRange;
+
+    return settings;
+}
+
+
+void SpriteFont::SetDistanceField(SpriteDistanceField type, float distanceRange)
+{
+    if (type > SpriteDistanceField_MultiChannel)
+        throw std::invalid_argument("Invalid distance field type");
+
+    if (type != SpriteDistanceField_None && !(distanceRange > 0.f))
+        throw std::invalid_argument("Distance field range must be greater than zero");
+
+    pImpl->distanceField = type;
+    pImpl->distanceFieldRange = (type != SpriteDistanceField_None) ? distanceRange : 0.f;
 }
 
 
@@ -542,3 +1074,85 @@ void SpriteFont::GetSpriteSheet(ID3D11ShaderResourceView** texture) const
 
     ThrowIfFailed(pImpl->texture.CopyTo(texture));
 }
+
+
+// Dynamic fonts
+bool SpriteFont::IsDynamic() const noexcept
+{
+    return pImpl->glyphCache != nullptr;
+}
+
+
+void SpriteFont::Update(_In_ ID3D11DeviceContext* deviceContext)
+{
+    if (pImpl->glyphCache)
+    {
+        pImpl->glyphCache->Update(deviceContext);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// SpriteFont::TextLayout
+//--------------------------------------------------------------------------------------
+
+_Use_decl_annotations_
+SpriteFont::TextLayout::TextLayout(SpriteFont const& font, wchar_t const* text)
+    : pImpl(std::make_unique<Impl>(font.pImpl.get(), text))
+{
+}
+
+
+_Use_decl_annotations_
+SpriteFont::TextLayout::TextLayout(SpriteFont const& font, char const* text)
+    : pImpl(std::make_unique<Impl>(font.pImpl.get(), font.pImpl->ConvertUTF8(text)))
+{
+}
+
+
+// Move constructor.
+SpriteFont::TextLayout::TextLayout(TextLayout&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+SpriteFont::TextLayout& SpriteFont::TextLayout::operator= (TextLayout&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+SpriteFont::TextLayout::~TextLayout()
+{
+}
+
+
+XMVECTOR XM_CALLCONV SpriteFont::TextLayout::Measure() const noexcept
+{
+    return XMLoadFloat2(&pImpl->size);
+}
+
+
+RECT SpriteFont::TextLayout::MeasureDrawBounds(XMFLOAT2 const& position) const noexcept
+{
+    return pImpl->MeasureDrawBounds(position);
+}
+
+
+RECT XM_CALLCONV SpriteFont::TextLayout::MeasureDrawBounds(FXMVECTOR position) const noexcept
+{
+    XMFLOAT2 pos;
+    XMStoreFloat2(&pos, position);
+
+    return pImpl->MeasureDrawBounds(pos);
+}
+
+
+size_t SpriteFont::TextLayout::GetGlyphCount() const noexcept
+{
+    return pImpl->glyphs.size();
+}
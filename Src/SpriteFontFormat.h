@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteFontFormat.h
+//
+// Version 2 .spritefont file format written by MakeSpriteFont /FastLoad and read by SpriteFont.
+// The glyph table and a direct lookup index are stored ready to use, so a memory-mapped file
+// is used in place, and the sprite sheet is stored exactly as it is given to CreateTexture2D.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+
+namespace SpriteFontFormat
+{
+    // Version 1 files start with "DXTKfont" instead, and are read field by field.
+    const char MAGIC[] = "DXTKfnt2";
+    const uint32_t VERSION = 2;
+
+    // Texture data starts on this boundary; every table starts on a 4 byte boundary.
+    const uint32_t DATA_ALIGNMENT = 16;
+
+    // The index covers the Basic Multilingual Plane in pages of PAGE_SIZE characters. The page map holds, for each
+    // page, 0 if the font has no characters in it or else the 1-based number of its page of glyph indices.
+    const uint32_t PAGE_SIZE = 256;
+    const uint32_t PAGE_COUNT = 0x10000 / PAGE_SIZE;
+
+    // Page entry for a character the font does not contain, which also limits the number of glyphs.
+    const uint16_t NO_GLYPH = 0xFFFF;
+
+#pragma pack(push,4)
+
+    struct Header
+    {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    fileSize;
+
+        uint32_t    glyphCount;
+        float       lineSpacing;
+        uint32_t    defaultCharacter;
+
+        uint32_t    distanceField;          // SpriteDistanceField
+        float       distanceFieldRange;
+
+        uint32_t    textureWidth;
+        uint32_t    textureHeight;
+        uint32_t    textureFormat;          // DXGI_FORMAT
+        uint32_t    textureStride;          // Bytes per row, or per row of blocks for compressed formats
+        uint32_t    textureRows;
+
+        uint32_t    glyphsOffset;           // SpriteFont::Glyph[glyphCount]
+        uint32_t    pageMapOffset;          // uint16_t[PAGE_COUNT]
+        uint32_t    pagesOffset;            // uint16_t[pageCount][PAGE_SIZE], glyph indices or NO_GLYPH
+        uint32_t    pageCount;
+        uint32_t    textureOffset;          // textureStride * textureRows bytes, DATA_ALIGNMENT aligned
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(Header) == 76, "Spritefont header size mismatch");
+}
@@ -0,0 +1,502 @@
+//--------------------------------------------------------------------------------------
+// File: TextureLoadQueue.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TextureLoadQueue.h"
+
+#include "BinaryReader.h"
+#include "DDS.h"
+#include "DDSTextureLoader.h"
+#include "PlatformHelpers.h"
+#include "WICTextureLoader.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace DirectX
+{
+    extern HRESULT _CreateWIC(_COM_Outptr_ IWICImagingFactory** factory) noexcept;
+    extern IWICImagingFactory* _SetThreadWIC(_In_opt_ IWICImagingFactory* factory) noexcept;
+}
+
+namespace
+{
+    struct LoadJob
+    {
+        std::wstring fileName;
+        const uint8_t* data;
+        size_t dataSize;
+        size_t maxsize;
+        bool forceSRGB;
+        TextureLoadQueue::Callback callback;
+    };
+
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    using LoaderDevice = ID3D11DeviceX;
+    using LoaderContext = ID3D11DeviceContextX;
+#else
+    using LoaderDevice = ID3D11Device;
+    using LoaderContext = ID3D11DeviceContext;
+#endif
+
+
+    // A null context creates the texture without auto-generated mipmaps.
+    HRESULT CreateTexture(_In_ LoaderDevice* device, _In_opt_ LoaderContext* deferredContext,
+                          _In_reads_bytes_(dataSize) const uint8_t* data, size_t dataSize,
+                          size_t maxsize, bool forceSRGB, TextureLoadResult& result) noexcept
+    {
+        if (dataSize >= sizeof(uint32_t) && *reinterpret_cast<const uint32_t*>(data) == DDS_MAGIC)
+        {
+            return CreateDDSTextureFromMemoryEx(device, deferredContext, data, dataSize, maxsize,
+                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB,
+                result.texture.ReleaseAndGetAddressOf(), result.textureView.ReleaseAndGetAddressOf());
+        }
+
+        return CreateWICTextureFromMemoryEx(device, deferredContext, data, dataSize, maxsize,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT,
+            result.texture.ReleaseAndGetAddressOf(), result.textureView.ReleaseAndGetAddressOf());
+    }
+}
+
+
+// Internal TextureLoadQueue implementation class.
+class TextureLoadQueue::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t maxConcurrency, bool generateMips)
+        : mSlotCount(0),
+        mRunning(0),
+        mPending(0)
+    {
+        if (!device)
+            throw std::exception("Device cannot be null");
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+        ThrowIfFailed(device->QueryInterface(IID_GRAPHICS_PPV_ARGS(mDevice.GetAddressOf())));
+#else
+        mDevice = device;
+#endif
+
+        if (!maxConcurrency)
+        {
+            maxConcurrency = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        mSlotCount = maxConcurrency;
+        mSlots.reset(new Slot[maxConcurrency]);
+
+        if (generateMips)
+        {
+            for (size_t j = 0; j < maxConcurrency; ++j)
+            {
+                ComPtr<ID3D11DeviceContext> deferredContext;
+                ThrowIfFailed(device->CreateDeferredContext(0, deferredContext.GetAddressOf()));
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+                ThrowIfFailed(deferredContext.As(&mSlots[j].deferredContext));
+#else
+                mSlots[j].deferredContext = deferredContext;
+#endif
+            }
+        }
+
+        mFreeSlots.reserve(maxConcurrency);
+        for (size_t j = maxConcurrency; j > 0; --j)
+        {
+            mFreeSlots.push_back(j - 1);
+        }
+    }
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        std::deque<LoadJob> aborted;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        aborted.swap(mJobs);
+        mPending -= aborted.size();
+
+        mCondition.wait(lock, [this]() noexcept { return mRunning == 0; });
+
+        lock.unlock();
+
+        TextureLoadResult result = {};
+        result.hr = E_ABORT;
+
+        for (auto const& job : aborted)
+        {
+            job.callback(result);
+        }
+    }
+
+    void Enqueue(LoadJob&& job);
+
+    void WaitForAll()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() noexcept { return mPending == 0; });
+    }
+
+    void ExecuteUploads(_In_ ID3D11DeviceContext* immediateContext);
+
+    size_t GetPendingCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPending;
+    }
+
+    size_t GetMaxConcurrency() const noexcept
+    {
+        return mSlotCount;
+    }
+
+private:
+    // Per concurrency slot state, used by one worker at a time.
+    struct Slot
+    {
+        Slot() noexcept : hasUploads(false) {}
+
+        // Created by the first worker to use the slot.
+        ComPtr<IWICImagingFactory> factory;
+
+        ComPtr<LoaderContext> deferredContext;
+        bool hasUploads;
+
+        // Held while a job records into the deferred context, so ExecuteUploads never finishes a command list
+        // mid-recording.
+        std::mutex mutex;
+    };
+
+    struct WorkerContext
+    {
+        Impl* impl;
+        size_t slot;
+    };
+
+    static void CALLBACK WorkerCallback(PTP_CALLBACK_INSTANCE, PVOID context) noexcept;
+
+    void Run(size_t slot) noexcept;
+    void RunJob(LoadJob const& job, Slot& slot) noexcept;
+
+    ComPtr<LoaderDevice> mDevice;
+
+    size_t mSlotCount;
+    std::unique_ptr<Slot[]> mSlots;
+    std::vector<size_t> mFreeSlots;
+
+    std::deque<LoadJob> mJobs;
+    size_t mRunning;
+    size_t mPending;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+
+void TextureLoadQueue::Impl::Enqueue(LoadJob&& job)
+{
+    if (!job.callback)
+        throw std::exception("Callback cannot be empty");
+
+    std::unique_ptr<WorkerContext> worker;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mJobs.emplace_back(std::move(job));
+        ++mPending;
+
+        if (mFreeSlots.empty())
+            return;
+
+        // Start another worker; running workers keep taking jobs until the queue is empty.
+        worker.reset(new WorkerContext{ this, mFreeSlots.back() });
+        mFreeSlots.pop_back();
+        ++mRunning;
+    }
+
+    if (!TrySubmitThreadpoolCallback(WorkerCallback, worker.get(), nullptr))
+    {
+        DebugTrace("ERROR: TextureLoadQueue failed to queue work (%08X)\n", static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())));
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mFreeSlots.push_back(worker->slot);
+        --mRunning;
+
+        // Any other running worker will pick the job up. With none, it would never run.
+        if (!mRunning)
+        {
+            mJobs.pop_back();
+            --mPending;
+            throw std::exception("TrySubmitThreadpoolCallback");
+        }
+        return;
+    }
+
+    // The callback now owns the context.
+    worker.release();
+}
+
+
+void CALLBACK TextureLoadQueue::Impl::WorkerCallback(PTP_CALLBACK_INSTANCE, PVOID context) noexcept
+{
+    std::unique_ptr<WorkerContext> worker(static_cast<WorkerContext*>(context));
+
+    worker->impl->Run(worker->slot);
+}
+
+
+void TextureLoadQueue::Impl::Run(size_t slot) noexcept
+{
+    // Pool threads are not guaranteed to be in an apartment, which WIC needs.
+    HRESULT hrCom = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    auto& factory = mSlots[slot].factory;
+    if (!factory)
+    {
+        if (FAILED(_CreateWIC(factory.GetAddressOf())))
+        {
+            // Decode with the shared factory instead.
+            factory.Reset();
+        }
+    }
+
+    auto previousFactory = _SetThreadWIC(factory.Get());
+
+    for (;;)
+    {
+        LoadJob job;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (mJobs.empty())
+            {
+                mFreeSlots.push_back(slot);
+                --mRunning;
+
+                // The queue may be destroyed as soon as the lock is released, so nothing after this touches it.
+                mCondition.notify_all();
+                break;
+            }
+
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        RunJob(job, mSlots[slot]);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mPending;
+            mCondition.notify_all();
+        }
+    }
+
+    (void)_SetThreadWIC(previousFactory);
+
+    if (SUCCEEDED(hrCom))
+    {
+        CoUninitialize();
+    }
+}
+
+
+void TextureLoadQueue::Impl::RunJob(LoadJob const& job, Slot& slot) noexcept
+{
+    TextureLoadResult result = {};
+
+    std::unique_lock<std::mutex> slotLock(slot.mutex, std::defer_lock);
+
+    auto deferredContext = slot.deferredContext.Get();
+
+    if (!job.fileName.empty())
+    {
+        ScopedMappedView view;
+        size_t dataSize = 0;
+
+        // The file read does not touch the deferred context, so it happens before taking the slot.
+        result.hr = BinaryReader::MapEntireFile(job.fileName.c_str(), view, &dataSize);
+        if (SUCCEEDED(result.hr))
+        {
+            slotLock.lock();
+
+            result.hr = CreateTexture(mDevice.Get(), deferredContext, static_cast<const uint8_t*>(view.get()), dataSize, job.maxsize, job.forceSRGB, result);
+        }
+
+        if (FAILED(result.hr))
+        {
+            DebugTrace("ERROR: TextureLoadQueue failed (%08X) to load '%ls'\n", static_cast<unsigned int>(result.hr), job.fileName.c_str());
+        }
+    }
+    else
+    {
+        slotLock.lock();
+
+        result.hr = CreateTexture(mDevice.Get(), deferredContext, job.data, job.dataSize, job.maxsize, job.forceSRGB, result);
+    }
+
+    if (deferredContext && SUCCEEDED(result.hr))
+    {
+        slot.hasUploads = true;
+    }
+
+    if (slotLock.owns_lock())
+    {
+        slotLock.unlock();
+    }
+
+    job.callback(result);
+}
+
+
+_Use_decl_annotations_
+void TextureLoadQueue::Impl::ExecuteUploads(ID3D11DeviceContext* immediateContext)
+{
+    if (!immediateContext)
+        throw std::exception("Context cannot be null");
+
+    for (size_t j = 0; j < mSlotCount; ++j)
+    {
+        auto& slot = mSlots[j];
+
+        if (!slot.deferredContext)
+            continue;
+
+        ComPtr<ID3D11CommandList> commandList;
+
+        {
+            // A worker decoding into this slot holds it for the whole decode, so rather than stall the render thread
+            // its uploads wait for the next call.
+            std::unique_lock<std::mutex> lock(slot.mutex, std::try_to_lock);
+
+            if (!lock.owns_lock() || !slot.hasUploads)
+                continue;
+
+            ThrowIfFailed(slot.deferredContext->FinishCommandList(FALSE, commandList.GetAddressOf()));
+            slot.hasUploads = false;
+        }
+
+        immediateContext->ExecuteCommandList(commandList.Get(), TRUE);
+    }
+}
+
+
+// Public constructor.
+TextureLoadQueue::TextureLoadQueue(_In_ ID3D11Device* device, size_t maxConcurrency, bool generateMips)
+    : pImpl(std::make_unique<Impl>(device, maxConcurrency, generateMips))
+{
+}
+
+
+// Move constructor.
+TextureLoadQueue::TextureLoadQueue(TextureLoadQueue&& moveFrom) noexcept
+    : pImpl(std::move(moveFrom.pImpl))
+{
+}
+
+
+// Move assignment.
+TextureLoadQueue& TextureLoadQueue::operator= (TextureLoadQueue&& moveFrom) noexcept
+{
+    pImpl = std::move(moveFrom.pImpl);
+    return *this;
+}
+
+
+// Public destructor.
+TextureLoadQueue::~TextureLoadQueue()
+{
+}
+
+
+_Use_decl_annotations_
+void TextureLoadQueue::LoadFromFile(const wchar_t* fileName, Callback callback, size_t maxsize, bool forceSRGB)
+{
+    if (!fileName || !*fileName)
+        throw std::exception("Invalid file name");
+
+    LoadJob job = { fileName, nullptr, 0, maxsize, forceSRGB, std::move(callback) };
+    pImpl->Enqueue(std::move(job));
+}
+
+
+_Use_decl_annotations_
+std::future<TextureLoadResult> TextureLoadQueue::LoadFromFile(const wchar_t* fileName, size_t maxsize, bool forceSRGB)
+{
+    auto promise = std::make_shared<std::promise<TextureLoadResult>>();
+    auto result = promise->get_future();
+
+    LoadFromFile(fileName, [promise](const TextureLoadResult& r)
+    {
+        promise->set_value(r);
+    }, maxsize, forceSRGB);
+
+    return result;
+}
+
+
+_Use_decl_annotations_
+void TextureLoadQueue::LoadFromMemory(const uint8_t* data, size_t dataSize, Callback callback, size_t maxsize, bool forceSRGB)
+{
+    if (!data || !dataSize)
+        throw std::exception("Invalid arguments");
+
+    LoadJob job = { std::wstring(), data, dataSize, maxsize, forceSRGB, std::move(callback) };
+    pImpl->Enqueue(std::move(job));
+}
+
+
+_Use_decl_annotations_
+std::future<TextureLoadResult> TextureLoadQueue::LoadFromMemory(const uint8_t* data, size_t dataSize, size_t maxsize, bool forceSRGB)
+{
+    auto promise = std::make_shared<std::promise<TextureLoadResult>>();
+    auto result = promise->get_future();
+
+    LoadFromMemory(data, dataSize, [promise](const TextureLoadResult& r)
+    {
+        promise->set_value(r);
+    }, maxsize, forceSRGB);
+
+    return result;
+}
+
+
+void TextureLoadQueue::WaitForAll()
+{
+    pImpl->WaitForAll();
+}
+
+
+_Use_decl_annotations_
+void TextureLoadQueue::ExecuteUploads(ID3D11DeviceContext* immediateContext)
+{
+    pImpl->ExecuteUploads(immediateContext);
+}
+
+
+size_t TextureLoadQueue::GetPendingCount() const noexcept
+{
+    return pImpl->GetPendingCount();
+}
+
+
+size_t TextureLoadQueue::GetMaxConcurrency() const noexcept
+{
+    return pImpl->GetMaxConcurrency();
+}
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// File: ThreadPool.h
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "PlatformHelpers.h"
+
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        // Shared state for one ParallelFor call. Workers claim indices until they run out.
+        struct ParallelForContext
+        {
+            std::atomic<size_t> next;
+            size_t count;
+            std::function<void(size_t)> const* work;
+
+            void Run()
+            {
+                for (;;)
+                {
+                    size_t index = next.fetch_add(1);
+
+                    if (index >= count)
+                        break;
+
+                    (*work)(index);
+                }
+            }
+        };
+
+        inline void CALLBACK ParallelForCallback(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WORK) noexcept
+        {
+            static_cast<ParallelForContext*>(context)->Run();
+        }
+    }
+
+
+    // Runs work(index) for every index in [0, count) on the system thread pool, with the calling
+    // thread also taking part, and returns once every call has completed. The work function must
+    // not throw. Falls back to running serially if no thread pool work item can be created.
+    inline void ParallelFor(size_t count, std::function<void(size_t index)> const& work)
+    {
+        if (!count)
+            return;
+
+        Internal::ParallelForContext context;
+        context.next = 0;
+        context.count = count;
+        context.work = &work;
+
+        PTP_WORK poolWork = nullptr;
+
+        if (count > 1)
+        {
+            poolWork = CreateThreadpoolWork(Internal::ParallelForCallback, &context, nullptr);
+
+            if (poolWork)
+            {
+                size_t workers = std::min<size_t>(count - 1, std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+                for (size_t j = 0; j < workers; ++j)
+                {
+                    SubmitThreadpoolWork(poolWork);
+                }
+            }
+        }
+
+        context.Run();
+
+        if (poolWork)
+        {
+            WaitForThreadpoolWorkCallbacks(poolWork, FALSE);
+            CloseThreadpoolWork(poolWork);
+        }
+    }
+}
@@ -9,12 +9,14 @@
 
 #include "pch.h"
 #include "PostProcess.h"
+#include "Effects.h"
 
 #include "AlignedNew.h"
 #include "CommonStates.h"
 #include "ConstantBuffer.h"
 #include "DemandCreate.h"
 #include "DirectXHelpers.h"
+#include "GpuProfiler.h"
 #include "SharedResourcePool.h"
 
 using namespace DirectX;
@@ -43,6 +45,20 @@ namespace
     };
 
     static_assert((sizeof(ToneMapConstants) % 16) == 0, "CB size not padded correctly");
+
+    // Auto-exposure constant buffer layout. Must match the shader!
+    __declspec(align(16)) struct AutoExposureConstants
+    {
+        // minLogLuminance is .x, inverseLogLuminanceRange is .y, logLuminanceRange is .z, adaptation is .w
+        XMVECTOR luminance;
+
+        // exposureCompensation is .x, paperWhiteNits is .y, targetLuminance is .z
+        XMVECTOR exposure;
+    };
+
+    static_assert((sizeof(AutoExposureConstants) % 16) == 0, "CB size not padded correctly");
+
+    const UINT HistogramBins = 256;
 }
 
 // Include the precompiled shader code.
@@ -66,6 +82,9 @@ namespace
     #include "Shaders/Compiled/XboxOneToneMap_PSHDR10_Saturate_SRGB.inc"
     #include "Shaders/Compiled/XboxOneToneMap_PSHDR10_Reinhard_SRGB.inc"
     #include "Shaders/Compiled/XboxOneToneMap_PSHDR10_ACESFilmic_SRGB.inc"
+
+    #include "Shaders/Compiled/XboxOneAutoExposure_CSHistogram.inc"
+    #include "Shaders/Compiled/XboxOneAutoExposure_CSAdaptExposure.inc"
 #else
     #include "Shaders/Compiled/ToneMap_VSQuad.inc"
 
@@ -78,6 +97,9 @@ namespace
     #include "Shaders/Compiled/ToneMap_PSReinhard_SRGB.inc"
     #include "Shaders/Compiled/ToneMap_PSACESFilmic_SRGB.inc"
     #include "Shaders/Compiled/ToneMap_PSHDR10.inc"
+
+    #include "Shaders/Compiled/AutoExposure_CSHistogram.inc"
+    #include "Shaders/Compiled/AutoExposure_CSAdaptExposure.inc"
 #endif
 }
 
@@ -166,6 +188,8 @@ namespace
             mDevice(device),
             mVertexShader{},
             mPixelShaders{},
+            mHistogramShader{},
+            mAdaptShader{},
             mMutex{}
         { }
 
@@ -203,12 +227,41 @@ namespace
             });
         }
 
+        // Gets or lazily creates the auto-exposure compute shaders.
+        ID3D11ComputeShader* GetHistogramShader()
+        {
+            return DemandCreate(mHistogramShader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(AutoExposure_CSHistogram, sizeof(AutoExposure_CSHistogram), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ToneMapPostProcess");
+
+                return hr;
+            });
+        }
+
+        ID3D11ComputeShader* GetAdaptShader()
+        {
+            return DemandCreate(mAdaptShader, mMutex, [&](ID3D11ComputeShader** pResult) -> HRESULT
+            {
+                HRESULT hr = mDevice->CreateComputeShader(AutoExposure_CSAdaptExposure, sizeof(AutoExposure_CSAdaptExposure), nullptr, pResult);
+
+                if (SUCCEEDED(hr))
+                    SetDebugObjectName(*pResult, "ToneMapPostProcess");
+
+                return hr;
+            });
+        }
+
         CommonStates                stateObjects;
 
     protected:
         ComPtr<ID3D11Device>        mDevice;
         ComPtr<ID3D11VertexShader>  mVertexShader;
         ComPtr<ID3D11PixelShader>   mPixelShaders[PixelShaderCount];
+        ComPtr<ID3D11ComputeShader> mHistogramShader;
+        ComPtr<ID3D11ComputeShader> mAdaptShader;
         std::mutex                  mMutex;
     };
 }
@@ -224,6 +277,8 @@ public:
 
     int GetCurrentShaderPermutation() const noexcept;
 
+    void SetAutoExposure(bool value);
+
     // Fields.
     ToneMapConstants                        constants;
     ComPtr<ID3D11ShaderResourceView>        hdrTexture;
@@ -234,11 +289,31 @@ public:
     TransferFunction                        func;
     bool                                    mrt;
 
+    AutoExposureConstants                   autoExposureConstants;
+    float                                   minLogLuminance;
+    float                                   maxLogLuminance;
+    float                                   adaptationRate;
+    float                                   targetLuminance;
+    float                                   elapsedTime;
+    bool                                    resetAdaptation;
+
 private:
     int                                     mDirtyFlags;
 
     ConstantBuffer<ToneMapConstants>        mConstantBuffer;
 
+    void                                    SetConstants(_In_ ID3D11DeviceContext* deviceContext);
+    void                                    UpdateExposure(_In_ ID3D11DeviceContext* deviceContext);
+
+    // Auto-exposure state, kept on the GPU. mExposure is copied into mExposureConstants each frame.
+    ComPtr<ID3D11Device>                    mDevice;
+    ComPtr<ID3D11Buffer>                    mHistogram;
+    ComPtr<ID3D11UnorderedAccessView>       mHistogramUAV;
+    ComPtr<ID3D11Buffer>                    mExposure;
+    ComPtr<ID3D11UnorderedAccessView>       mExposureUAV;
+    ComPtr<ID3D11Buffer>                    mExposureConstants;
+    ConstantBuffer<AutoExposureConstants>   mAutoExposureBuffer;
+
     // Per-device resources.
     std::shared_ptr<DeviceResources>        mDeviceResources;
 
@@ -258,8 +333,17 @@ ToneMapPostProcess::Impl::Impl(_In_ ID3D11Device* device)
     op(None),
     func(Linear),
     mrt(false),
+    autoExposureConstants{},
+    minLogLuminance(-10.f),
+    maxLogLuminance(2.f),
+    adaptationRate(1.5f),
+    targetLuminance(0.18f),
+    elapsedTime(1.f / 60.f),
+    resetAdaptation(true),
     mDirtyFlags(INT_MAX),
     mConstantBuffer(device),
+    mDevice(device),
+    mAutoExposureBuffer(device),
     mDeviceResources(deviceResourcesPool.DemandCreate(device))
 {
     if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
@@ -291,7 +375,37 @@ void ToneMapPostProcess::Impl::Process(_In_ ID3D11DeviceContext* deviceContext,
     deviceContext->VSSetShader(vertexShader, nullptr, 0);
     deviceContext->PSSetShader(pixelShader, nullptr, 0);
 
+    InvalidateEffectStateCache(deviceContext);
+
     // Set constants.
+    if (mExposure && hdrTexture)
+    {
+        UpdateExposure(deviceContext);
+
+        auto buffer = mExposureConstants.Get();
+        deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+    }
+    else
+    {
+        SetConstants(deviceContext);
+    }
+
+    if (setCustomState)
+    {
+        setCustomState();
+    }
+
+    // Draw quad.
+    deviceContext->IASetInputLayout(nullptr);
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    deviceContext->Draw(3, 0);
+}
+
+
+// Sets the application supplied exposure.
+void ToneMapPostProcess::Impl::SetConstants(_In_ ID3D11DeviceContext* deviceContext)
+{
     if (mDirtyFlags & Dirty_Parameters)
     {
         mDirtyFlags &= ~Dirty_Parameters;
@@ -322,17 +436,112 @@ void ToneMapPostProcess::Impl::Process(_In_ ID3D11DeviceContext* deviceContext,
 
     deviceContext->PSSetConstantBuffers(0, 1, &buffer);
 #endif
+}
 
-    if (setCustomState)
+
+// Builds the histogram and adapts the exposure on the GPU, then copies the result into the tonemap constants.
+void ToneMapPostProcess::Impl::UpdateExposure(_In_ ID3D11DeviceContext* deviceContext)
+{
+    ComPtr<ID3D11Resource> res;
+    hdrTexture->GetResource(res.GetAddressOf());
+
+    ComPtr<ID3D11Texture2D> tex;
+    if (FAILED(res.As(&tex)))
+        throw std::exception("Auto-exposure requires a 2D HDR source texture");
+
+    D3D11_TEXTURE2D_DESC desc;
+    tex->GetDesc(&desc);
+
+    float range = maxLogLuminance - minLogLuminance;
+    float adaptation = (resetAdaptation) ? 1.f : (1.f - expf(-elapsedTime * adaptationRate));
+    resetAdaptation = false;
+
+    autoExposureConstants.luminance = XMVectorSet(minLogLuminance, 1.f / range, range, adaptation);
+    autoExposureConstants.exposure = XMVectorSet(linearExposure, paperWhiteNits, targetLuminance, 0.f);
+
+    ID3D11ShaderResourceView* textures[1] = { hdrTexture.Get() };
+    deviceContext->CSSetShaderResources(0, 1, textures);
+
+    ID3D11UnorderedAccessView* uavs[2] = { mHistogramUAV.Get(), mExposureUAV.Get() };
+    deviceContext->CSSetUnorderedAccessViews(0, 2, uavs, nullptr);
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    void *grfxMemory;
+    mAutoExposureBuffer.SetData(deviceContext, autoExposureConstants, &grfxMemory);
+
+    Microsoft::WRL::ComPtr<ID3D11DeviceContextX> deviceContextX;
+    ThrowIfFailed(deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(deviceContextX.GetAddressOf())));
+
+    deviceContextX->CSSetPlacementConstantBuffer(0, mAutoExposureBuffer.GetBuffer(), grfxMemory);
+#else
+    mAutoExposureBuffer.SetData(deviceContext, autoExposureConstants);
+
+    auto buffer = mAutoExposureBuffer.GetBuffer();
+    deviceContext->CSSetConstantBuffers(0, 1, &buffer);
+#endif
+
+    deviceContext->CSSetShader(mDeviceResources->GetHistogramShader(), nullptr, 0);
+    deviceContext->Dispatch((desc.Width + 15) / 16, (desc.Height + 15) / 16, 1);
+
+    deviceContext->CSSetShader(mDeviceResources->GetAdaptShader(), nullptr, 0);
+    deviceContext->Dispatch(1, 1, 1);
+
+    ID3D11ShaderResourceView* nullSRV[1] = {};
+    ID3D11UnorderedAccessView* nullUAV[2] = {};
+    deviceContext->CSSetShaderResources(0, 1, nullSRV);
+    deviceContext->CSSetUnorderedAccessViews(0, 2, nullUAV, nullptr);
+
+    // The exposure buffer starts with the same layout as ToneMapConstants.
+    D3D11_BOX box = { 0, 0, 0, sizeof(ToneMapConstants), 1, 1 };
+    deviceContext->CopySubresourceRegion(mExposureConstants.Get(), 0, 0, 0, 0, mExposure.Get(), 0, &box);
+}
+
+
+void ToneMapPostProcess::Impl::SetAutoExposure(bool value)
+{
+    if (!value)
     {
-        setCustomState();
+        mHistogram.Reset();
+        mHistogramUAV.Reset();
+        mExposure.Reset();
+        mExposureUAV.Reset();
+        mExposureConstants.Reset();
+        return;
     }
 
-    // Draw quad.
-    deviceContext->IASetInputLayout(nullptr);
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    if (mExposure || mDevice->GetFeatureLevel() < D3D_FEATURE_LEVEL_11_0)
+        return;
 
-    deviceContext->Draw(3, 0);
+    const uint32_t zeroes[HistogramBins] = {};
+    D3D11_SUBRESOURCE_DATA initData = { zeroes, 0, 0 };
+
+    CD3D11_BUFFER_DESC desc(HistogramBins * sizeof(uint32_t), D3D11_BIND_UNORDERED_ACCESS, D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS);
+    ThrowIfFailed(mDevice->CreateBuffer(&desc, &initData, mHistogram.ReleaseAndGetAddressOf()));
+
+    SetDebugObjectName(mHistogram.Get(), "ToneMapPostProcess");
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = HistogramBins;
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    ThrowIfFailed(mDevice->CreateUnorderedAccessView(mHistogram.Get(), &uavDesc, mHistogramUAV.ReleaseAndGetAddressOf()));
+
+    desc.ByteWidth = sizeof(XMFLOAT4);
+    ThrowIfFailed(mDevice->CreateBuffer(&desc, &initData, mExposure.ReleaseAndGetAddressOf()));
+
+    SetDebugObjectName(mExposure.Get(), "ToneMapPostProcess");
+
+    uavDesc.Buffer.NumElements = sizeof(XMFLOAT4) / sizeof(uint32_t);
+    ThrowIfFailed(mDevice->CreateUnorderedAccessView(mExposure.Get(), &uavDesc, mExposureUAV.ReleaseAndGetAddressOf()));
+
+    // Filled by copying from the exposure buffer, so it cannot be dynamic like the usual constant buffer.
+    CD3D11_BUFFER_DESC cbDesc(sizeof(ToneMapConstants), D3D11_BIND_CONSTANT_BUFFER);
+    ThrowIfFailed(mDevice->CreateBuffer(&cbDesc, &initData, mExposureConstants.ReleaseAndGetAddressOf()));
+
+    SetDebugObjectName(mExposureConstants.Get(), "ToneMapPostProcess");
+
+    resetAdaptation = true;
 }
 
 
@@ -378,6 +587,8 @@ ToneMapPostProcess::~ToneMapPostProcess()
 // IPostProcess methods.
 void ToneMapPostProcess::Process(_In_ ID3D11DeviceContext* deviceContext, _In_opt_ std::function<void __cdecl()> setCustomState)
 {
+    GpuProfileScope profileScope(deviceContext, L"ToneMapPostProcess::Process");
+
     pImpl->Process(deviceContext, setCustomState);
 }
 
@@ -428,3 +639,30 @@ void ToneMapPostProcess::SetST2084Parameter(float paperWhiteNits)
     pImpl->paperWhiteNits = paperWhiteNits;
     pImpl->SetDirtyFlag();
 }
+
+
+void ToneMapPostProcess::SetAutoExposure(bool value)
+{
+    pImpl->SetAutoExposure(value);
+}
+
+
+void ToneMapPostProcess::SetAutoExposureParameters(float minLogLuminance, float maxLogLuminance, float adaptationRate, float targetLuminance)
+{
+    if (maxLogLuminance <= minLogLuminance)
+        throw std::out_of_range("Luminance range is empty");
+
+    if (adaptationRate < 0.f || targetLuminance <= 0.f)
+        throw std::out_of_range("Adaptation rate and target luminance must be positive");
+
+    pImpl->minLogLuminance = minLogLuminance;
+    pImpl->maxLogLuminance = maxLogLuminance;
+    pImpl->adaptationRate = adaptationRate;
+    pImpl->targetLuminance = targetLuminance;
+}
+
+
+void ToneMapPostProcess::SetElapsedTime(float seconds)
+{
+    pImpl->elapsedTime = std::max(seconds, 0.f);
+}
@@ -171,3 +171,48 @@ void XM_CALLCONV VertexPositionNormalTangentColorTextureSkinning::SetBlendWeight
     XMStoreUByteN4(&packed, iweights);
     this->weights = packed.v;
 }
+
+
+//--------------------------------------------------------------------------------------
+// Packed vertex struct holding position, normal vector, and texture mapping information.
+const D3D11_INPUT_ELEMENT_DESC VertexPositionNormalTexturePacked::InputElements[] =
+{
+    { "SV_Position", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "NORMAL",      0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD",    0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+static_assert(sizeof(VertexPositionNormalTexturePacked) == 16, "Vertex struct/layout mismatch");
+
+
+//--------------------------------------------------------------------------------------
+// Packed vertex struct holding position, normal, tangent, color (RGBA), and texture mapping information
+const D3D11_INPUT_ELEMENT_DESC VertexPositionNormalTangentColorTexturePacked::InputElements[] =
+{
+    { "SV_Position", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "NORMAL",      0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TANGENT",     0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "COLOR",       0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD",    0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+static_assert(sizeof(VertexPositionNormalTangentColorTexturePacked) == 24, "Vertex struct/layout mismatch");
+
+
+//--------------------------------------------------------------------------------------
+// Packed vertex struct holding position, normal, tangent, color (RGBA), texture mapping
+// information, and skinning weights
+const D3D11_INPUT_ELEMENT_DESC VertexPositionNormalTangentColorTextureSkinningPacked::InputElements[] =
+{
+    { "SV_Position", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "NORMAL",      0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TANGENT",     0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "COLOR",       0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD",    0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "BLENDINDICES",0, DXGI_FORMAT_R8G8B8A8_UINT,      0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "BLENDWEIGHT", 0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+static_assert(VertexPositionNormalTangentColorTextureSkinningPacked::InputElementCount == VertexPositionNormalTangentColorTexturePacked::InputElementCount + 2, "layout mismatch");
+
+static_assert(sizeof(VertexPositionNormalTangentColorTextureSkinningPacked) == 32, "Vertex struct/layout mismatch");
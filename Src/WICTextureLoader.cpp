@@ -7,7 +7,8 @@
 // Note: Assumes application has already called CoInitializeEx
 //
 // Warning: CreateWICTexture* functions are not thread-safe if given a d3dContext instance for
-//          auto-gen mipmap support.
+//          auto-gen mipmap support. A deferred context may be given instead, in which case the
+//          upload and GenerateMips are only recorded, and run when its command list is executed.
 //
 // Note these functions are useful for images created as simple 2D textures. For
 // more complex resources, DDSTextureLoader is an excellent light-weight runtime loader.
@@ -31,6 +32,10 @@
 #include "DirectXHelpers.h"
 #include "PlatformHelpers.h"
 #include "LoaderHelpers.h"
+#include "MemoryTracker.h"
+#include "BCEncode.h"
+#include "BinaryReader.h"
+#include "PixelConvert.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -140,6 +145,31 @@ namespace
         // We don't support n-channel formats
     };
 
+    //-------------------------------------------------------------------------------------
+    // Conversions done with our own scanline kernels rather than IWICFormatConverter
+    //-------------------------------------------------------------------------------------
+    struct WICFastConvert
+    {
+        GUID                source;
+        GUID                target;
+        PIXEL_CONVERSION    conversion;
+    };
+
+    const WICFastConvert g_WICFastConvert[] =
+    {
+        { GUID_WICPixelFormat24bppRGB,              GUID_WICPixelFormat32bppRGBA,   PIXEL_CONVERSION_RGB24_TO_RGBA32 },
+        { GUID_WICPixelFormat24bppBGR,              GUID_WICPixelFormat32bppRGBA,   PIXEL_CONVERSION_BGR24_TO_RGBA32 },
+        { GUID_WICPixelFormat32bppBGR,              GUID_WICPixelFormat32bppRGBA,   PIXEL_CONVERSION_BGRX32_TO_RGBA32 },
+        { GUID_WICPixelFormat32bppBGRA,             GUID_WICPixelFormat32bppRGBA,   PIXEL_CONVERSION_BGRA32_TO_RGBA32 },
+        { GUID_WICPixelFormat48bppRGB,              GUID_WICPixelFormat64bppRGBA,   PIXEL_CONVERSION_RGB48_TO_RGBA64 },
+        { GUID_WICPixelFormat48bppBGR,              GUID_WICPixelFormat64bppRGBA,   PIXEL_CONVERSION_BGR48_TO_RGBA64 },
+        { GUID_WICPixelFormat64bppBGRA,             GUID_WICPixelFormat64bppRGBA,   PIXEL_CONVERSION_BGRA64_TO_RGBA64 },
+
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8) || defined(_WIN7_PLATFORM_UPDATE)
+        { GUID_WICPixelFormat32bppRGB,              GUID_WICPixelFormat32bppRGBA,   PIXEL_CONVERSION_RGBX32_TO_RGBA32 },
+    #endif
+    };
+
     bool g_WIC2 = false;
 
     BOOL WINAPI InitializeWICFactory(PINIT_ONCE, PVOID, PVOID *ifactory) noexcept
@@ -188,6 +218,12 @@ namespace DirectX
     IWICImagingFactory* _GetWIC() noexcept;
         // Also used by ScreenGrab
 
+    HRESULT _CreateWIC(_COM_Outptr_ IWICImagingFactory** factory) noexcept;
+    IWICImagingFactory* _SetThreadWIC(_In_opt_ IWICImagingFactory* factory) noexcept;
+        // Used by TextureLoadQueue
+
+    static thread_local IWICImagingFactory* t_threadWIC = nullptr;
+
     bool _IsWIC2() noexcept
     {
         return g_WIC2;
@@ -195,6 +231,10 @@ namespace DirectX
 
     IWICImagingFactory* _GetWIC() noexcept
     {
+        // A thread with a factory of its own uses that instead of the shared one.
+        if (t_threadWIC)
+            return t_threadWIC;
+
         static INIT_ONCE s_initOnce = INIT_ONCE_STATIC_INIT;
 
         IWICImagingFactory* factory = nullptr;
@@ -207,6 +247,45 @@ namespace DirectX
         return factory;
     }
 
+    // Creates another factory of the same kind as the shared one.
+    HRESULT _CreateWIC(IWICImagingFactory** factory) noexcept
+    {
+        if (!factory)
+            return E_INVALIDARG;
+
+        *factory = nullptr;
+
+        auto previous = t_threadWIC;
+        t_threadWIC = nullptr;
+        auto shared = _GetWIC();
+        t_threadWIC = previous;
+
+        if (!shared)
+            return E_NOINTERFACE;
+
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8) || defined(_WIN7_PLATFORM_UPDATE)
+        if (g_WIC2)
+        {
+            return CoCreateInstance(CLSID_WICImagingFactory2, nullptr, CLSCTX_INPROC_SERVER,
+                __uuidof(IWICImagingFactory2), reinterpret_cast<LPVOID*>(factory));
+        }
+
+        return CoCreateInstance(CLSID_WICImagingFactory1, nullptr, CLSCTX_INPROC_SERVER,
+            __uuidof(IWICImagingFactory), reinterpret_cast<LPVOID*>(factory));
+    #else
+        return CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+            __uuidof(IWICImagingFactory), reinterpret_cast<LPVOID*>(factory));
+    #endif
+    }
+
+    // Sets the factory used by the calling thread, returning the previous one. Null restores the shared factory.
+    IWICImagingFactory* _SetThreadWIC(IWICImagingFactory* factory) noexcept
+    {
+        auto previous = t_threadWIC;
+        t_threadWIC = factory;
+        return previous;
+    }
+
 } // namespace DirectX
 
 
@@ -261,6 +340,456 @@ namespace
         return bpp;
     }
 
+    //---------------------------------------------------------------------------------
+    // Decodes the source in its own format and converts it with PixelConvert, which is several times quicker than
+    // IWICFormatConverter for large images. Returns S_FALSE if there is no kernel for the pair of formats.
+    HRESULT _CopyPixelsConverted(
+        _In_ IWICBitmapSource* source,
+        REFGUID sourceFormat,
+        REFGUID targetFormat,
+        UINT width,
+        UINT height,
+        size_t rowPitch,
+        _Out_writes_bytes_(rowPitch * height) uint8_t* pixels) noexcept
+    {
+        for (size_t i = 0; i < _countof(g_WICFastConvert); ++i)
+        {
+            if (memcmp(&g_WICFastConvert[i].source, &sourceFormat, sizeof(GUID)) != 0
+                || memcmp(&g_WICFastConvert[i].target, &targetFormat, sizeof(GUID)) != 0)
+                continue;
+
+            auto conversion = g_WICFastConvert[i].conversion;
+            assert(GetPixelConversionDestSize(conversion) * width <= rowPitch);
+
+            uint64_t srcRowBytes = uint64_t(width) * GetPixelConversionSourceSize(conversion);
+            uint64_t srcBytes = srcRowBytes * uint64_t(height);
+            if (srcBytes > UINT32_MAX)
+                return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+            std::unique_ptr<uint8_t[]> decoded(new (std::nothrow) uint8_t[static_cast<size_t>(srcBytes)]);
+            if (!decoded)
+                return E_OUTOFMEMORY;
+
+            HRESULT hr = source->CopyPixels(nullptr, static_cast<UINT>(srcRowBytes), static_cast<UINT>(srcBytes), decoded.get());
+            if (FAILED(hr))
+                return hr;
+
+            ConvertPixels(conversion, decoded.get(), static_cast<size_t>(srcRowBytes), pixels, rowPitch, width, height);
+            return S_OK;
+        }
+
+        return S_FALSE;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Picks the best block format asked for that the device can sample. BC7 falls back to BC3, which also keeps alpha.
+    DXGI_FORMAT _ChooseBCFormat(_In_ ID3D11Device* d3dDevice, unsigned int loadFlags, bool srgb) noexcept
+    {
+        static const struct
+        {
+            unsigned int flag;
+            DXGI_FORMAT format;
+        } s_bcFormats[] =
+        {
+            { WIC_LOADER_COMPRESS_BC7, DXGI_FORMAT_BC7_UNORM },
+            { WIC_LOADER_COMPRESS_BC3, DXGI_FORMAT_BC3_UNORM },
+            { WIC_LOADER_COMPRESS_BC1, DXGI_FORMAT_BC1_UNORM },
+        };
+
+        if (loadFlags & WIC_LOADER_COMPRESS_BC7)
+            loadFlags |= WIC_LOADER_COMPRESS_BC3;
+
+        for (size_t i = 0; i < _countof(s_bcFormats); ++i)
+        {
+            if (!(loadFlags & s_bcFormats[i].flag))
+                continue;
+
+            DXGI_FORMAT format = (srgb) ? LoaderHelpers::MakeSRGB(s_bcFormats[i].format) : s_bcFormats[i].format;
+
+            UINT support = 0;
+            HRESULT hr = d3dDevice->CheckFormatSupport(format, &support);
+            if (SUCCEEDED(hr) && (support & D3D11_FORMAT_SUPPORT_TEXTURE2D))
+                return format;
+        }
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Writes a converted texture, and any mips it has, as a DX10 header DDS file.
+    HRESULT _SaveDDSCache(
+        _In_z_ const wchar_t* fileName,
+        const D3D11_TEXTURE2D_DESC& desc,
+        _In_reads_bytes_(dataSize) const uint8_t* data,
+        size_t dataSize) noexcept
+    {
+        if (dataSize > UINT32_MAX)
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        size_t slicePitch, rowPitch;
+        HRESULT hr = LoaderHelpers::GetSurfaceInfo(desc.Width, desc.Height, desc.Format, &slicePitch, &rowPitch, nullptr);
+        if (FAILED(hr))
+            return hr;
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        ScopedHandle hFile(safe_handle(CreateFile2(fileName, GENERIC_WRITE | DELETE, 0, CREATE_ALWAYS, nullptr)));
+#else
+        ScopedHandle hFile(safe_handle(CreateFileW(fileName, GENERIC_WRITE | DELETE, 0, nullptr, CREATE_ALWAYS, 0, nullptr)));
+#endif
+        if (!hFile)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        LoaderHelpers::auto_delete_file delonfail(hFile.get());
+
+        const size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+        uint8_t fileHeader[HEADER_SIZE] = {};
+
+        *reinterpret_cast<uint32_t*>(&fileHeader[0]) = DDS_MAGIC;
+
+        auto header = reinterpret_cast<DDS_HEADER*>(&fileHeader[0] + sizeof(uint32_t));
+        header->size = sizeof(DDS_HEADER);
+        header->flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP;
+        header->height = desc.Height;
+        header->width = desc.Width;
+        header->mipMapCount = desc.MipLevels;
+        header->caps = DDS_SURFACE_FLAGS_TEXTURE | ((desc.MipLevels > 1) ? DDS_SURFACE_FLAGS_MIPMAP : 0u);
+
+        if (LoaderHelpers::IsCompressed(desc.Format))
+        {
+            header->flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+            header->pitchOrLinearSize = static_cast<uint32_t>(slicePitch);
+        }
+        else
+        {
+            header->flags |= DDS_HEADER_FLAGS_PITCH;
+            header->pitchOrLinearSize = static_cast<uint32_t>(rowPitch);
+        }
+
+        memcpy_s(&header->ddspf, sizeof(header->ddspf), &DDSPF_DX10, sizeof(DDS_PIXELFORMAT));
+
+        auto extHeader = reinterpret_cast<DDS_HEADER_DXT10*>(&fileHeader[0] + sizeof(uint32_t) + sizeof(DDS_HEADER));
+        extHeader->dxgiFormat = desc.Format;
+        extHeader->resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+        extHeader->arraySize = 1;
+
+        DWORD bytesWritten;
+        if (!WriteFile(hFile.get(), fileHeader, static_cast<DWORD>(HEADER_SIZE), &bytesWritten, nullptr))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        if (bytesWritten != HEADER_SIZE)
+            return E_FAIL;
+
+        if (!WriteFile(hFile.get(), data, static_cast<DWORD>(dataSize), &bytesWritten, nullptr))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        if (bytesWritten != dataSize)
+            return E_FAIL;
+
+        delonfail.clear();
+
+        return S_OK;
+    }
+
+    //---------------------------------------------------------------------------------
+    // 64-bit FNV-1a
+    const uint64_t c_hashOffset = 14695981039346656037ull;
+
+    uint64_t _Hash(uint64_t hash, _In_reads_bytes_(size) const void* data, size_t size) noexcept
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t j = 0; j < size; ++j)
+        {
+            hash = (hash ^ bytes[j]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Builds the name of the DDS file that caches a compressed copy of fileName, <file>.<key>.bc?.dds, where the key
+    // is a hash of the image size and every option that changes the texture. Returns false if a compression flag is
+    // not set, or the name does not fit.
+    bool _GetBCCacheFileName(
+        _In_ ID3D11Device* d3dDevice,
+        _In_z_ const wchar_t* fileName,
+        size_t maxsize,
+        unsigned int loadFlags,
+        _Out_writes_(MAX_PATH) wchar_t* cacheFile) noexcept
+    {
+        const wchar_t* suffix;
+        if (loadFlags & WIC_LOADER_COMPRESS_BC7)
+            suffix = L"bc7";
+        else if (loadFlags & WIC_LOADER_COMPRESS_BC3)
+            suffix = L"bc3";
+        else if (loadFlags & WIC_LOADER_COMPRESS_BC1)
+            suffix = L"bc1";
+        else
+            return false;
+
+        WIN32_FILE_ATTRIBUTE_DATA source;
+        if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &source))
+            return false;
+
+        const uint64_t options[] =
+        {
+            loadFlags,
+            maxsize,
+            static_cast<uint64_t>(d3dDevice->GetFeatureLevel()),
+            (uint64_t(source.nFileSizeHigh) << 32) | source.nFileSizeLow,
+        };
+
+        uint64_t key = _Hash(c_hashOffset, options, sizeof(options));
+
+        return swprintf_s(cacheFile, MAX_PATH, L"%ls.%016llX.%ls.dds", fileName, key, suffix) >= 0;
+    }
+
+    //---------------------------------------------------------------------------------
+    // The cache is used only if it is at least as new as the image it was made from.
+    bool _IsBCCacheCurrent(_In_z_ const wchar_t* fileName, _In_z_ const wchar_t* cacheFile) noexcept
+    {
+        WIN32_FILE_ATTRIBUTE_DATA source;
+        WIN32_FILE_ATTRIBUTE_DATA cache;
+        if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &source)
+            || !GetFileAttributesExW(cacheFile, GetFileExInfoStandard, &cache))
+            return false;
+
+        return CompareFileTime(&cache.ftLastWriteTime, &source.ftLastWriteTime) >= 0;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Content addressed cache shared by the file loaders, off while the directory is empty.
+    std::mutex g_cacheMutex;
+    wchar_t g_cacheDirectory[MAX_PATH] = {};
+
+    // Finds where loading fileName is cached, if anywhere: next to the image for WIC_LOADER_CACHE_DDS, otherwise in
+    // the cache directory under a hash of the file contents and every option that changes the converted texture.
+    // current is set if the cached file can be loaded instead of decoding the image.
+    bool _GetCacheFileName(
+        _In_ ID3D11Device* d3dDevice,
+        _In_z_ const wchar_t* fileName,
+        size_t maxsize,
+        unsigned int loadFlags,
+        _Out_writes_(MAX_PATH) wchar_t* cacheFile,
+        _Out_ bool* current) noexcept
+    {
+        *current = false;
+
+        if (loadFlags & WIC_LOADER_CACHE_DDS)
+        {
+            if (!_GetBCCacheFileName(d3dDevice, fileName, maxsize, loadFlags, cacheFile))
+                return false;
+
+            *current = _IsBCCacheCurrent(fileName, cacheFile);
+            return true;
+        }
+
+        wchar_t directory[MAX_PATH];
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+
+            if (!*g_cacheDirectory)
+                return false;
+
+            wcscpy_s(directory, g_cacheDirectory);
+        }
+
+        ScopedMappedView view;
+        size_t dataSize;
+        if (FAILED(BinaryReader::MapEntireFile(fileName, view, &dataSize)))
+            return false;
+
+        const uint64_t options[] =
+        {
+            loadFlags,
+            maxsize,
+            static_cast<uint64_t>(d3dDevice->GetFeatureLevel()),
+        };
+
+        uint64_t key = _Hash(c_hashOffset, view.get(), dataSize);
+        key = _Hash(key, options, sizeof(options));
+
+        if (swprintf_s(cacheFile, MAX_PATH, L"%ls\\%016llX.dds", directory, key) < 0)
+            return false;
+
+        *current = (GetFileAttributesW(cacheFile) != INVALID_FILE_ATTRIBUTES);
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Decodes the frame once, builds the whole mip chain with WIC, and block compresses every level on the CPU.
+    // Returns S_FALSE without creating anything if the device cannot sample any of the requested formats.
+    HRESULT CreateBCTextureFromWIC(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ IWICBitmapFrameDecode *frame,
+        _In_ UINT twidth,
+        _In_ UINT theight,
+        _In_ bool srgb,
+        _In_ D3D11_USAGE usage,
+        _In_ unsigned int bindFlags,
+        _In_ unsigned int cpuAccessFlags,
+        _In_ unsigned int miscFlags,
+        _In_ unsigned int loadFlags,
+        _In_opt_z_ const wchar_t* ddsCacheFile,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
+    {
+        DXGI_FORMAT format = _ChooseBCFormat(d3dDevice, loadFlags, srgb);
+        if (format == DXGI_FORMAT_UNKNOWN)
+            return S_FALSE;
+
+        auto pWIC = _GetWIC();
+        if (!pWIC)
+            return E_NOINTERFACE;
+
+        // The top level of a block compressed texture must be a multiple of 4 in each direction.
+        twidth = (twidth + 3u) & ~3u;
+        theight = (theight + 3u) & ~3u;
+
+        size_t mipLevels = 1;
+        if (d3dDevice->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0
+            || (!(twidth & (twidth - 1)) && !(theight & (theight - 1))))
+        {
+            for (UINT w = twidth, h = theight; w > 1 || h > 1; w = std::max(w >> 1, 1u), h = std::max(h >> 1, 1u))
+                ++mipLevels;
+        }
+
+        ComPtr<IWICFormatConverter> FC;
+        HRESULT hr = pWIC->CreateFormatConverter(FC.GetAddressOf());
+        if (FAILED(hr))
+            return hr;
+
+        hr = FC->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeMedianCut);
+        if (FAILED(hr))
+            return hr;
+
+        ComPtr<IWICBitmap> source;
+        hr = pWIC->CreateBitmapFromSource(FC.Get(), WICBitmapCacheOnLoad, source.GetAddressOf());
+        if (FAILED(hr))
+            return hr;
+
+        UINT width, height;
+        hr = source->GetSize(&width, &height);
+        if (FAILED(hr))
+            return hr;
+
+        // Lay out every level in one block so it can be written to the cache as is.
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData(new (std::nothrow) D3D11_SUBRESOURCE_DATA[mipLevels]);
+        if (!initData)
+            return E_OUTOFMEMORY;
+
+        size_t totalBytes = 0;
+        for (size_t level = 0; level < mipLevels; ++level)
+        {
+            size_t numBytes, rowBytes;
+            hr = LoaderHelpers::GetSurfaceInfo(std::max<size_t>(twidth >> level, 1), std::max<size_t>(theight >> level, 1), format, &numBytes, &rowBytes, nullptr);
+            if (FAILED(hr))
+                return hr;
+
+            initData[level].pSysMem = reinterpret_cast<const void*>(totalBytes);
+            initData[level].SysMemPitch = static_cast<UINT>(rowBytes);
+            initData[level].SysMemSlicePitch = static_cast<UINT>(numBytes);
+            totalBytes += numBytes;
+        }
+
+        uint64_t scratchBytes = uint64_t(twidth) * uint64_t(theight) * 4u;
+        if (totalBytes > UINT32_MAX || scratchBytes > UINT32_MAX)
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        std::unique_ptr<uint8_t[]> blocks(new (std::nothrow) uint8_t[totalBytes]);
+        std::unique_ptr<uint8_t[]> scratch(new (std::nothrow) uint8_t[static_cast<size_t>(scratchBytes)]);
+        if (!blocks || !scratch)
+            return E_OUTOFMEMORY;
+
+        for (size_t level = 0; level < mipLevels; ++level)
+        {
+            auto w = std::max<UINT>(twidth >> level, 1u);
+            auto h = std::max<UINT>(theight >> level, 1u);
+            UINT rowPitch = w * 4u;
+            UINT imageSize = rowPitch * h;
+
+            if (w == width && h == height)
+            {
+                hr = source->CopyPixels(nullptr, rowPitch, imageSize, scratch.get());
+            }
+            else
+            {
+                ComPtr<IWICBitmapScaler> scaler;
+                hr = pWIC->CreateBitmapScaler(scaler.GetAddressOf());
+                if (FAILED(hr))
+                    return hr;
+
+                hr = scaler->Initialize(source.Get(), w, h, WICBitmapInterpolationModeFant);
+                if (FAILED(hr))
+                    return hr;
+
+                hr = scaler->CopyPixels(nullptr, rowPitch, imageSize, scratch.get());
+            }
+
+            if (FAILED(hr))
+                return hr;
+
+            auto dest = blocks.get() + reinterpret_cast<size_t>(initData[level].pSysMem);
+            initData[level].pSysMem = dest;
+
+            CompressBC(format, scratch.get(), w, h, rowPitch, dest, initData[level].SysMemPitch);
+        }
+
+        scratch.reset();
+
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width = twidth;
+        desc.Height = theight;
+        desc.MipLevels = static_cast<UINT>(mipLevels);
+        desc.ArraySize = 1;
+        desc.Format = format;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage = usage;
+        desc.BindFlags = bindFlags;
+        desc.CPUAccessFlags = cpuAccessFlags;
+        desc.MiscFlags = miscFlags & ~static_cast<unsigned int>(D3D11_RESOURCE_MISC_GENERATE_MIPS);
+
+        ID3D11Texture2D* tex = nullptr;
+        hr = d3dDevice->CreateTexture2D(&desc, initData.get(), &tex);
+        if (FAILED(hr) || !tex)
+            return hr;
+
+        if (textureView)
+        {
+            D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+            SRVDesc.Format = desc.Format;
+            SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+            SRVDesc.Texture2D.MipLevels = desc.MipLevels;
+
+            hr = d3dDevice->CreateShaderResourceView(tex, &SRVDesc, textureView);
+            if (FAILED(hr))
+            {
+                tex->Release();
+                return hr;
+            }
+        }
+
+        if (texture)
+        {
+            *texture = tex;
+        }
+        else
+        {
+            SetDebugObjectName(tex, "WICTextureLoader");
+            tex->Release();
+        }
+
+        if (ddsCacheFile)
+        {
+            // A cache that cannot be written only costs the next load another compression.
+            if (FAILED(_SaveDDSCache(ddsCacheFile, desc, blocks.get(), totalBytes)))
+            {
+                DebugTrace("WARNING: WICTextureLoader could not write compressed texture cache\n");
+            }
+        }
+
+        return S_OK;
+    }
+
     //---------------------------------------------------------------------------------
     HRESULT CreateTextureFromWIC(
         _In_ ID3D11Device* d3dDevice,
@@ -276,6 +805,7 @@ namespace
         _In_ unsigned int cpuAccessFlags,
         _In_ unsigned int miscFlags,
         _In_ unsigned int loadFlags,
+        _In_opt_z_ const wchar_t* ddsCacheFile,
         _Outptr_opt_ ID3D11Resource** texture,
         _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
     {
@@ -422,9 +952,11 @@ namespace
             return E_FAIL;
 
         // Handle sRGB formats
+        bool srgb = false;
         if (loadFlags & WIC_LOADER_FORCE_SRGB)
         {
             format = LoaderHelpers::MakeSRGB(format);
+            srgb = true;
         }
         else if (!(loadFlags & WIC_LOADER_IGNORE_SRGB))
         {
@@ -473,11 +1005,30 @@ namespace
                     (void)PropVariantClear(&value);
 
                     if (sRGB)
+                    {
                         format = LoaderHelpers::MakeSRGB(format);
+                        srgb = true;
+                    }
                 }
             }
         }
 
+        if (loadFlags & (WIC_LOADER_COMPRESS_BC1 | WIC_LOADER_COMPRESS_BC3 | WIC_LOADER_COMPRESS_BC7))
+        {
+            hr = CreateBCTextureFromWIC(d3dDevice, frame, twidth, theight, srgb,
+                usage, bindFlags, cpuAccessFlags, miscFlags, loadFlags, ddsCacheFile,
+                texture, textureView);
+            if (hr != S_FALSE)
+                return hr;
+
+            // Otherwise the device has none of the formats, so carry on uncompressed. A <file>.bc?.dds sidecar
+            // must only ever hold compressed data, so it is not written.
+            if (loadFlags & WIC_LOADER_CACHE_DDS)
+            {
+                ddsCacheFile = nullptr;
+            }
+        }
+
         // Verify our target format is supported by the current device
         // (handles WDDM 1.0 or WDDM 1.1 device driver cases as well as DirectX 11.0 Runtime without 16bpp format support)
         UINT support = 0;
@@ -542,6 +1093,11 @@ namespace
                 if (FAILED(hr))
                     return hr;
             }
+            else if ((hr = _CopyPixelsConverted(scaler.Get(), pfScaler, convertGUID, twidth, theight, rowPitch, temp.get())) != S_FALSE)
+            {
+                if (FAILED(hr))
+                    return hr;
+            }
             else
             {
                 ComPtr<IWICFormatConverter> FC;
@@ -565,6 +1121,12 @@ namespace
                     return hr;
             }
         }
+        else if ((hr = _CopyPixelsConverted(frame, pixelFormat, convertGUID, twidth, theight, rowPitch, temp.get())) != S_FALSE)
+        {
+            // Format conversion with our own kernels, but no resize
+            if (FAILED(hr))
+                return hr;
+        }
         else
         {
             // Format conversion but no resize
@@ -672,8 +1234,12 @@ namespace
                     {
                         d3dContext->CopySubresourceRegion(tex, 0, 0, 0, 0, pStaging, 0, nullptr);
 
-                        UINT64 copyFence = d3dContextX->InsertFence(0);
-                        while (d3dDeviceX->IsFencePending(copyFence)) { SwitchToThread(); }
+                        // A deferred context's command list holds its own reference to the staging texture.
+                        if (d3dContext->GetType() != D3D11_DEVICE_CONTEXT_DEFERRED)
+                        {
+                            UINT64 copyFence = d3dContextX->InsertFence(0);
+                            while (d3dDeviceX->IsFencePending(copyFence)) { SwitchToThread(); }
+                        }
                         pStaging->Release();
                     }
 #else
@@ -692,6 +1258,16 @@ namespace
                 SetDebugObjectName(tex, "WICTextureLoader");
                 tex->Release();
             }
+
+            if (ddsCacheFile)
+            {
+                // Only the top level is kept; mips are generated again when the cache is loaded with a context.
+                desc.MipLevels = 1;
+                if (FAILED(_SaveDDSCache(ddsCacheFile, desc, temp.get(), rowPitch * theight)))
+                {
+                    DebugTrace("WARNING: WICTextureLoader could not write texture cache\n");
+                }
+            }
         }
 
         return hr;
@@ -771,6 +1347,29 @@ namespace
         UNREFERENCED_PARAMETER(textureView);
 #endif
     }
+
+    //--------------------------------------------------------------------------------------
+    void TrackTextureMemory(
+        _In_opt_z_ const wchar_t* fileName,
+        _In_opt_ ID3D11Resource** texture,
+        _In_opt_ ID3D11ShaderResourceView** textureView) noexcept
+    {
+        if (!MemoryTracker::IsEnabled())
+            return;
+
+        // Callers may ask for only the view, which still keeps the texture alive.
+        Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+        if (texture && *texture)
+        {
+            resource = *texture;
+        }
+        else if (textureView && *textureView)
+        {
+            (*textureView)->GetResource(resource.GetAddressOf());
+        }
+
+        MemoryTracker::TrackResource(resource.Get(), MemoryCategory_Texture, fileName ? fileName : L"WICTextureLoader");
+    }
 } // anonymous namespace
 
 //--------------------------------------------------------------------------------------
@@ -885,7 +1484,7 @@ HRESULT DirectX::CreateWICTextureFromMemoryEx(
 #endif
         frame.Get(), maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
-        loadFlags,
+        loadFlags, nullptr,
         texture, textureView);
     if (FAILED(hr))
         return hr;
@@ -900,6 +1499,8 @@ HRESULT DirectX::CreateWICTextureFromMemoryEx(
         SetDebugObjectName(*textureView, "WICTextureLoader");
     }
 
+    TrackTextureMemory(nullptr, texture, textureView);
+
     return hr;
 }
 
@@ -981,7 +1582,7 @@ _Use_decl_annotations_
         frame.Get(),
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
-        loadFlags,
+        loadFlags, nullptr,
         texture, textureView);
     if (FAILED(hr))
         return hr;
@@ -996,6 +1597,8 @@ _Use_decl_annotations_
         SetDebugObjectName(*textureView, "WICTextureLoader");
     }
 
+    TrackTextureMemory(nullptr, texture, textureView);
+
     return hr;
 }
 
@@ -1071,6 +1674,30 @@ HRESULT DirectX::CreateWICTextureFromFileEx(
         return E_INVALIDARG;
     }
 
+    // A texture saved by an earlier load skips the decode, conversion and any compression.
+    wchar_t cacheFile[MAX_PATH];
+    bool cacheCurrent = false;
+    bool useCache = _GetCacheFileName(d3dDevice, fileName, maxsize, loadFlags, cacheFile, &cacheCurrent);
+    if (useCache && cacheCurrent)
+    {
+        ScopedMappedView view;
+        size_t dataSize;
+        HRESULT hr = BinaryReader::MapEntireFile(cacheFile, view, &dataSize);
+        if (SUCCEEDED(hr))
+        {
+            hr = CreateDDSTextureFromMemoryEx(d3dDevice, static_cast<const uint8_t*>(view.get()), dataSize, maxsize,
+                usage, bindFlags, cpuAccessFlags, miscFlags, false,
+                texture, textureView);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            SetDebugTextureInfo(fileName, texture, textureView);
+            TrackTextureMemory(fileName, texture, textureView);
+            return hr;
+        }
+    }
+
     auto pWIC = _GetWIC();
     if (!pWIC)
         return E_NOINTERFACE;
@@ -1097,12 +1724,13 @@ HRESULT DirectX::CreateWICTextureFromFileEx(
         frame.Get(),
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
-        loadFlags,
+        loadFlags, (useCache) ? cacheFile : nullptr,
         texture, textureView);
 
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
+        TrackTextureMemory(fileName, texture, textureView);
     }
 
     return hr;
@@ -1147,6 +1775,30 @@ _Use_decl_annotations_
         return E_INVALIDARG;
     }
 
+    // A texture saved by an earlier load skips the decode, conversion and any compression.
+    wchar_t cacheFile[MAX_PATH];
+    bool cacheCurrent = false;
+    bool useCache = _GetCacheFileName(d3dDevice, fileName, maxsize, loadFlags, cacheFile, &cacheCurrent);
+    if (useCache && cacheCurrent)
+    {
+        ScopedMappedView view;
+        size_t dataSize;
+        HRESULT hr = BinaryReader::MapEntireFile(cacheFile, view, &dataSize);
+        if (SUCCEEDED(hr))
+        {
+            hr = CreateDDSTextureFromMemoryEx(d3dDevice, d3dContext, static_cast<const uint8_t*>(view.get()), dataSize, maxsize,
+                usage, bindFlags, cpuAccessFlags, miscFlags, false,
+                texture, textureView);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            SetDebugTextureInfo(fileName, texture, textureView);
+            TrackTextureMemory(fileName, texture, textureView);
+            return hr;
+        }
+    }
+
     auto pWIC = _GetWIC();
     if (!pWIC)
         return E_NOINTERFACE;
@@ -1173,13 +1825,53 @@ _Use_decl_annotations_
         frame.Get(),
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
-        loadFlags,
+        loadFlags, (useCache) ? cacheFile : nullptr,
         texture, textureView);
 
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
+        TrackTextureMemory(fileName, texture, textureView);
     }
 
     return hr;
 }
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::SetWICTextureCacheDirectory(const wchar_t* directory) noexcept
+{
+    if (directory)
+    {
+        DWORD attributes = GetFileAttributesW(directory);
+        if (attributes == INVALID_FILE_ATTRIBUTES)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        if (!(attributes & FILE_ATTRIBUTE_DIRECTORY))
+            return E_INVALIDARG;
+    }
+
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+
+    if (!directory)
+    {
+        *g_cacheDirectory = 0;
+        return S_OK;
+    }
+
+    if (wcscpy_s(g_cacheDirectory, directory))
+    {
+        *g_cacheDirectory = 0;
+        return HRESULT_FROM_WIN32(ERROR_BUFFER_OVERFLOW);
+    }
+
+    // A trailing separator would be doubled up in the cache file names.
+    size_t length = wcslen(g_cacheDirectory);
+    if (length > 0 && (g_cacheDirectory[length - 1] == L'\\' || g_cacheDirectory[length - 1] == L'/'))
+    {
+        g_cacheDirectory[length - 1] = 0;
+    }
+
+    return S_OK;
+}
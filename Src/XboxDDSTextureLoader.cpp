@@ -413,17 +413,21 @@ namespace
     }
 
     //--------------------------------------------------------------------------------------
-    HRESULT CreateTextureFromDDS(_In_ ID3D11DeviceX* d3dDevice,
-        _In_ const DDS_HEADER* header,
-        _In_reads_bytes_(bitSize) const uint8_t* bitData,
-        _In_ size_t bitSize,
-        _In_ bool forceSRGB,
-        _Outptr_opt_ ID3D11Resource** texture,
-        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-        _Outptr_ void** grfxMemory) noexcept
+    struct TextureLayout
     {
-        HRESULT hr = S_OK;
+        const DDS_HEADER_XBOX*  xboxext;
+        uint32_t                width;
+        uint32_t                height;
+        uint32_t                depth;
+        uint32_t                mipCount;
+        uint32_t                arraySize;
+        bool                    isCubeMap;
+    };
 
+    HRESULT GetTextureLayout(_In_ const DDS_HEADER* header,
+        _In_ size_t bitSize,
+        _Out_ TextureLayout& layout) noexcept
+    {
         uint32_t width = header->width;
         uint32_t height = header->height;
         uint32_t depth = header->depth;
@@ -559,6 +563,34 @@ namespace
             return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
         }
 
+        layout.xboxext = xboxext;
+        layout.width = width;
+        layout.height = height;
+        layout.depth = depth;
+        layout.mipCount = mipCount;
+        layout.arraySize = arraySize;
+        layout.isCubeMap = isCubeMap;
+
+        return S_OK;
+    }
+
+    //--------------------------------------------------------------------------------------
+    HRESULT CreateTextureFromDDS(_In_ ID3D11DeviceX* d3dDevice,
+        _In_ const DDS_HEADER* header,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        _In_ bool forceSRGB,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+        _Outptr_ void** grfxMemory) noexcept
+    {
+        TextureLayout layout;
+        HRESULT hr = GetTextureLayout(header, bitSize, layout);
+        if (FAILED(hr))
+            return hr;
+
+        auto xboxext = layout.xboxext;
+
         // Allocate graphics memory. Depending on the data size it uses 4MB or 64K pages.
         *grfxMemory = XMemAlloc(xboxext->dataSize, c_XMemAllocAttributes);
         if (!*grfxMemory)
@@ -569,18 +601,50 @@ namespace
 
         // Create the texture
         hr = CreateD3DResources(d3dDevice, xboxext,
-            width, height, depth, mipCount, arraySize,
-            forceSRGB, isCubeMap, *grfxMemory,
+            layout.width, layout.height, layout.depth, layout.mipCount, layout.arraySize,
+            forceSRGB, layout.isCubeMap, *grfxMemory,
             texture, textureView);
         if (FAILED(hr))
         {
-            XMemFree(grfxMemory, c_XMemAllocAttributes);
+            XMemFree(*grfxMemory, c_XMemAllocAttributes);
             *grfxMemory = nullptr;
         }
 
         return hr;
     }
 
+    //--------------------------------------------------------------------------------------
+    // Finds room for the texture in caller-reserved graphics memory, at the next offset meeting its base alignment.
+    HRESULT PlaceInHeap(_In_ const DDS_HEADER_XBOX* xboxext,
+        _In_ void* heapMemory,
+        _In_ size_t heapSize,
+        _In_ size_t heapOffset,
+        _Out_ size_t* placementOffset) noexcept
+    {
+        size_t alignment = xboxext->baseAlignment;
+        if (alignment & (alignment - 1))
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        auto base = reinterpret_cast<uintptr_t>(heapMemory);
+        if (heapOffset > heapSize || (base + heapOffset) > (UINTPTR_MAX - alignment))
+        {
+            return E_INVALIDARG;
+        }
+
+        auto address = (base + heapOffset + alignment - 1) & ~uintptr_t(alignment - 1);
+        auto offset = static_cast<size_t>(address - base);
+
+        if (offset > heapSize || xboxext->dataSize > (heapSize - offset))
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        *placementOffset = offset;
+        return S_OK;
+    }
+
     //--------------------------------------------------------------------------------------
     DDS_ALPHA_MODE GetAlphaMode(_In_ const DDS_HEADER* header) noexcept
     {
@@ -606,6 +670,77 @@ namespace
 
         return DDS_ALPHA_MODE_UNKNOWN;
     }
+
+    //--------------------------------------------------------------------------------------
+    HRESULT GetHeaderFromMemory(_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _Outptr_ const DDS_HEADER** header) noexcept
+    {
+        // Validate DDS file in memory
+        if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        {
+            return E_FAIL;
+        }
+
+        auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData);
+        if (dwMagicNumber != DDS_MAGIC)
+        {
+            return E_FAIL;
+        }
+
+        auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+
+        // Verify header to validate DDS file
+        if (hdr->size != sizeof(DDS_HEADER) ||
+            hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+        {
+            return E_FAIL;
+        }
+
+        // Check for XBOX extension
+        if (!(hdr->ddspf.flags & DDS_FOURCC)
+            || (MAKEFOURCC('X', 'B', 'O', 'X') != hdr->ddspf.fourCC))
+        {
+            // Use standard DDSTextureLoader instead
+            return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+        }
+
+        // Must be long enough for both headers and magic value
+        if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_XBOX)))
+        {
+            return E_FAIL;
+        }
+
+        *header = hdr;
+        return S_OK;
+    }
+
+    //--------------------------------------------------------------------------------------
+    HRESULT ReadAt(_In_ HANDLE hFile, _In_ uint64_t offset, _In_ uint32_t size, _Out_writes_bytes_(size) void* dest, _Inout_ OVERLAPPED& overlapped) noexcept
+    {
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        if (!ReadFile(hFile, dest, size, nullptr, &overlapped))
+        {
+            DWORD error = GetLastError();
+            if (error != ERROR_IO_PENDING)
+                return HRESULT_FROM_WIN32(error);
+        }
+
+        return S_OK;
+    }
+
+    HRESULT WaitForRead(_In_ HANDLE hFile, _In_ uint32_t size, _Inout_ OVERLAPPED& overlapped) noexcept
+    {
+        DWORD bytesRead = 0;
+        if (!GetOverlappedResult(hFile, &overlapped, &bytesRead, TRUE))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        return (bytesRead < size) ? HRESULT_FROM_WIN32(ERROR_HANDLE_EOF) : S_OK;
+    }
 } // anonymous namespace
 
 
@@ -643,44 +778,16 @@ HRESULT Xbox::CreateDDSTextureFromMemory(
         return E_INVALIDARG;
     }
 
-    // Validate DDS file in memory
-    if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
-    {
-        return E_FAIL;
-    }
-
-    auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData);
-    if (dwMagicNumber != DDS_MAGIC)
+    const DDS_HEADER* header = nullptr;
+    HRESULT hr = GetHeaderFromMemory( ddsData, ddsDataSize, &header );
+    if ( FAILED(hr) )
     {
-        return E_FAIL;
-    }
-
-    auto header = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
-
-    // Verify header to validate DDS file
-    if (header->size != sizeof(DDS_HEADER) ||
-        header->ddspf.size != sizeof(DDS_PIXELFORMAT))
-    {
-        return E_FAIL;
-    }
-
-    // Check for XBOX extension
-    if ( !( header->ddspf.flags & DDS_FOURCC )
-         || ( MAKEFOURCC( 'X', 'B', 'O', 'X' ) != header->ddspf.fourCC ) )
-    {
-        // Use standard DDSTextureLoader instead
-        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
-    }
-
-    // Must be long enough for both headers and magic value
-    if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_XBOX)))
-    {
-        return E_FAIL;
+        return hr;
     }
 
     auto offset = sizeof( uint32_t ) + sizeof( DDS_HEADER ) + sizeof( DDS_HEADER_XBOX );
 
-    HRESULT hr = CreateTextureFromDDS( d3dDevice, header,
+    hr = CreateTextureFromDDS( d3dDevice, header,
                                        ddsData + offset, ddsDataSize - offset, forceSRGB,
                                        texture, textureView,
                                        grfxMemory );
@@ -777,6 +884,252 @@ HRESULT Xbox::CreateDDSTextureFromFile(
     return hr;
 }
 
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT Xbox::CreateDDSTextureFromMemoryInHeap(
+    ID3D11DeviceX* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    void* heapMemory,
+    size_t heapSize,
+    size_t* heapOffset,
+    ID3D11Resource** texture,
+    ID3D11ShaderResourceView** textureView,
+    DDS_ALPHA_MODE* alphaMode,
+    bool forceSRGB ) noexcept
+{
+    if ( texture )
+    {
+        *texture = nullptr;
+    }
+    if ( textureView )
+    {
+        *textureView = nullptr;
+    }
+    if ( alphaMode )
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+
+    if ( !d3dDevice || !ddsData || (!texture && !textureView) || !heapMemory || !heapOffset )
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    HRESULT hr = GetHeaderFromMemory( ddsData, ddsDataSize, &header );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    auto offset = sizeof( uint32_t ) + sizeof( DDS_HEADER ) + sizeof( DDS_HEADER_XBOX );
+
+    TextureLayout layout;
+    hr = GetTextureLayout( header, ddsDataSize - offset, layout );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    size_t placement = 0;
+    hr = PlaceInHeap( layout.xboxext, heapMemory, heapSize, *heapOffset, &placement );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    auto grfxMemory = static_cast<uint8_t*>(heapMemory) + placement;
+
+    // Copy tiled data into graphics memory
+    memcpy( grfxMemory, ddsData + offset, layout.xboxext->dataSize );
+
+    hr = CreateD3DResources( d3dDevice, layout.xboxext,
+                             layout.width, layout.height, layout.depth, layout.mipCount, layout.arraySize,
+                             forceSRGB, layout.isCubeMap, grfxMemory,
+                             texture, textureView );
+    if ( SUCCEEDED(hr) )
+    {
+        if (texture != 0 && *texture != 0)
+        {
+            SetDebugObjectName(*texture, "XboxDDSTextureLoader");
+        }
+
+        if (textureView != 0 && *textureView != 0)
+        {
+            SetDebugObjectName(*textureView, "XboxDDSTextureLoader");
+        }
+
+        if ( alphaMode )
+            *alphaMode = GetAlphaMode( header );
+
+        *heapOffset = placement + layout.xboxext->dataSize;
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT Xbox::CreateDDSTextureFromFileInHeap(
+    ID3D11DeviceX* d3dDevice,
+    const wchar_t* fileName,
+    void* heapMemory,
+    size_t heapSize,
+    size_t* heapOffset,
+    ID3D11Resource** texture,
+    ID3D11ShaderResourceView** textureView,
+    DDS_ALPHA_MODE* alphaMode,
+    bool forceSRGB ) noexcept
+{
+    if ( texture )
+    {
+        *texture = nullptr;
+    }
+    if ( textureView )
+    {
+        *textureView = nullptr;
+    }
+    if ( alphaMode )
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+
+    if ( !d3dDevice || !fileName || (!texture && !textureView) || !heapMemory || !heapOffset )
+    {
+        return E_INVALIDARG;
+    }
+
+    CREATEFILE2_EXTENDED_PARAMETERS params = {};
+    params.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+    params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    params.dwFileFlags = FILE_FLAG_OVERLAPPED;
+
+    ScopedHandle hFile( safe_handle( CreateFile2( fileName,
+                                                  GENERIC_READ,
+                                                  FILE_SHARE_READ,
+                                                  OPEN_EXISTING,
+                                                  &params ) ) );
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    FILE_STANDARD_INFO fileInfo;
+    if ( !GetFileInformationByHandleEx( hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo) ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    // File is too big for 32-bit allocation, so reject read
+    if ( fileInfo.EndOfFile.HighPart > 0 )
+    {
+        return E_FAIL;
+    }
+
+    ScopedHandle hEvent( CreateEventEx( nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_MODIFY_STATE | SYNCHRONIZE ) );
+    if ( !hEvent )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = hEvent.get();
+
+    // Only the headers go through system memory
+    auto offset = sizeof( uint32_t ) + sizeof( DDS_HEADER ) + sizeof( DDS_HEADER_XBOX );
+
+    uint32_t headerData[ (sizeof( uint32_t ) + sizeof( DDS_HEADER ) + sizeof( DDS_HEADER_XBOX )) / sizeof( uint32_t ) ] = {};
+    auto headerSize = std::min<uint32_t>( fileInfo.EndOfFile.LowPart, static_cast<uint32_t>( sizeof(headerData) ) );
+
+    HRESULT hr = ReadAt( hFile.get(), 0, headerSize, headerData, overlapped );
+    if ( SUCCEEDED(hr) )
+    {
+        hr = WaitForRead( hFile.get(), headerSize, overlapped );
+    }
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    hr = GetHeaderFromMemory( reinterpret_cast<const uint8_t*>( headerData ), headerSize, &header );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    TextureLayout layout;
+    hr = GetTextureLayout( header, fileInfo.EndOfFile.LowPart - offset, layout );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    size_t placement = 0;
+    hr = PlaceInHeap( layout.xboxext, heapMemory, heapSize, *heapOffset, &placement );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    auto grfxMemory = static_cast<uint8_t*>(heapMemory) + placement;
+    auto dataSize = layout.xboxext->dataSize;
+
+    // Read the tiled data straight into its placement. The placement resources don't touch that memory, so they
+    // are created while the read is in flight.
+    ResetEvent( hEvent.get() );
+    hr = ReadAt( hFile.get(), offset, dataSize, grfxMemory, overlapped );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    hr = CreateD3DResources( d3dDevice, layout.xboxext,
+                             layout.width, layout.height, layout.depth, layout.mipCount, layout.arraySize,
+                             forceSRGB, layout.isCubeMap, grfxMemory,
+                             texture, textureView );
+
+    // The read must be finished before returning, even on failure, since it targets the caller's memory
+    HRESULT hrRead = WaitForRead( hFile.get(), dataSize, overlapped );
+    if ( SUCCEEDED(hr) && FAILED(hrRead) )
+    {
+        if ( texture && *texture )
+        {
+            (*texture)->Release();
+            *texture = nullptr;
+        }
+        if ( textureView && *textureView )
+        {
+            (*textureView)->Release();
+            *textureView = nullptr;
+        }
+
+        hr = hrRead;
+    }
+
+    if ( SUCCEEDED(hr) )
+    {
+#if !defined(NO_D3D11_DEBUG_NAME) && ( defined(_DEBUG) || defined(PROFILE) )
+        if (texture != 0 && *texture != 0)
+        {
+            (*texture)->SetName( fileName );
+        }
+        if (textureView != 0 && *textureView != 0 )
+        {
+            (*textureView)->SetName( fileName );
+        }
+#endif
+
+        if ( alphaMode )
+            *alphaMode = GetAlphaMode( header );
+
+        *heapOffset = placement + dataSize;
+    }
+
+    return hr;
+}
+
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 void Xbox::FreeDDSTextureMemory(void* grfxMemory) noexcept
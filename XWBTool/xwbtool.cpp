@@ -33,9 +33,13 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <list>
 #include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "WAVFileReader.h"
@@ -261,6 +265,10 @@ namespace
         return bitCount;
     }
 
+    // Microsoft ADPCM standard encoding coefficients
+    const short g_pAdpcmCoefficients1[] = { 256,  512, 0, 192, 240,  460,  392 };
+    const short g_pAdpcmCoefficients2[] = { 0, -256, 0,  64,   0, -208, -232 };
+
     WORD AdpcmBlockSizeFromPcmFrames(WORD nPcmFrames, WORD nChannels)
     {
         // The full calculation is as follows:
@@ -440,10 +448,6 @@ namespace
                 bool valid = true;
                 for (int j = 0; j < 7 /*MSADPCM_NUM_COEFFICIENTS*/; ++j)
                 {
-                    // Microsoft ADPCM standard encoding coefficients
-                    static const short g_pAdpcmCoefficients1[] = { 256,  512, 0, 192, 240,  460,  392 };
-                    static const short g_pAdpcmCoefficients2[] = { 0, -256, 0,  64,   0, -208, -232 };
-
                     if (wfadpcm->aCoef[j].iCoef1 != g_pAdpcmCoefficients1[j]
                         || wfadpcm->aCoef[j].iCoef2 != g_pAdpcmCoefficients2[j])
                     {
@@ -783,6 +787,11 @@ enum OPTIONS
     OPT_FRIENDLY_NAMES,
     OPT_NOLOGO,
     OPT_FILELIST,
+    OPT_PARALLEL,
+    OPT_INCREMENTAL,
+    OPT_ORDER,
+    OPT_ALIGNMENT,
+    OPT_ADPCM,
     OPT_MAX
 };
 
@@ -850,6 +859,11 @@ const SValue g_pOptions[] =
     { L"f",         OPT_FRIENDLY_NAMES },
     { L"nologo",    OPT_NOLOGO },
     { L"flist",     OPT_FILELIST },
+    { L"mt",        OPT_PARALLEL },
+    { L"inc",       OPT_INCREMENTAL },
+    { L"order",     OPT_ORDER },
+    { L"align",     OPT_ALIGNMENT },
+    { L"adpcm",     OPT_ADPCM },
     { nullptr,      0 }
 };
 
@@ -977,6 +991,12 @@ namespace
         wprintf(L"   -f                  include entry friendly names\n");
         wprintf(L"   -nologo             suppress copyright message\n");
         wprintf(L"   -flist <filename>   use text file with a list of input files (one per line)\n");
+        wprintf(L"   -mt                 read wave files using multiple threads\n");
+        wprintf(L"   -inc                skip the build if inputs are unchanged since the last -inc build\n");
+        wprintf(L"   -order <filename>   lay out wave data in the access order given by a text file\n");
+        wprintf(L"                       of entry names (one per line), entry indices are unchanged\n");
+        wprintf(L"   -align <bytes>      minimum entry alignment (2048 for DVD, 4096 for HDD/SSD)\n");
+        wprintf(L"   -adpcm              encode 8-bit and 16-bit mono/stereo PCM entries as MS ADPCM\n");
     }
 
     const char* GetFormatTagName(WORD wFormatTag)
@@ -1044,6 +1064,474 @@ namespace
 
         return false;
     }
+
+    //--------------------------------------------------------------------------------------
+    // Runs fn(0..count-1) across one thread per logical processor; any reporting is left
+    // to the caller so output stays in input order
+    //--------------------------------------------------------------------------------------
+    template<typename Fn>
+    void ParallelFor(size_t count, Fn fn)
+    {
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for (size_t j = next++; j < count; j = next++)
+            {
+                fn(j);
+            }
+        };
+
+        size_t threadCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), count);
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (size_t j = 1; j < threadCount; ++j)
+            threads.emplace_back(worker);
+
+        worker();
+
+        for (auto& t : threads)
+            t.join();
+    }
+
+    void LoadWaveFiles(const std::list<SConversion>& conversion, std::vector<WaveFile>& waves, std::vector<HRESULT>& results)
+    {
+        std::vector<const wchar_t*> files;
+        files.reserve(conversion.size());
+        for (auto it = conversion.cbegin(); it != conversion.cend(); ++it)
+            files.push_back(it->szSrc);
+
+        waves.resize(files.size());
+        results.resize(files.size(), E_FAIL);
+
+        ParallelFor(files.size(), [&](size_t j)
+        {
+            results[j] = DirectX::LoadWAVAudioFromFileEx(files[j], waves[j].waveData, waves[j].data);
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // MS ADPCM encoder
+    //--------------------------------------------------------------------------------------
+    const WORD ADPCM_SAMPLES_PER_BLOCK = 512;
+    const size_t ADPCM_FORMAT_SIZE = sizeof(WAVEFORMATEX) + 32 /*MSADPCM_FORMAT_EXTRA_BYTES*/;
+
+    const int g_AdpcmAdaptationTable[16] = { 230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230 };
+
+    enum ADPCM_RESULT
+    {
+        ADPCM_ENCODED = 0,
+        ADPCM_NOT_PCM,
+        ADPCM_UNSUPPORTED_PCM,
+        ADPCM_UNALIGNED_LOOP,
+        ADPCM_OUT_OF_MEMORY,
+    };
+
+    struct AdpcmState
+    {
+        int coef1;
+        int coef2;
+        int delta;
+        int sample1;
+        int sample2;
+    };
+
+    inline int AdpcmPredict(const AdpcmState& state)
+    {
+        return (state.sample1 * state.coef1 + state.sample2 * state.coef2) / 256;
+    }
+
+    // Quantizes one sample and steps the state exactly as the decoder will
+    inline int AdpcmEncodeSample(AdpcmState& state, int sample)
+    {
+        int predict = AdpcmPredict(state);
+        int diff = sample - predict;
+        int nibble = (diff >= 0) ? (diff + state.delta / 2) / state.delta : (diff - state.delta / 2) / state.delta;
+        nibble = std::max(-8, std::min(7, nibble));
+
+        int value = std::max(-32768, std::min(32767, predict + nibble * state.delta));
+        state.sample2 = state.sample1;
+        state.sample1 = value;
+
+        state.delta = std::max(16, (g_AdpcmAdaptationTable[nibble & 0xF] * state.delta) / 256);
+        return nibble & 0xF;
+    }
+
+    // Tries each of the standard predictors on the block and keeps the one with the least squared error
+    BYTE AdpcmChoosePredictor(const int16_t* samples, size_t frames, AdpcmState& best)
+    {
+        BYTE bestPredictor = 0;
+        uint64_t bestError = UINT64_MAX;
+
+        for (BYTE p = 0; p < 7 /*MSADPCM_NUM_COEFFICIENTS*/; ++p)
+        {
+            AdpcmState state = {};
+            state.coef1 = g_pAdpcmCoefficients1[p];
+            state.coef2 = g_pAdpcmCoefficients2[p];
+            state.sample2 = samples[0];
+            state.sample1 = samples[1];
+
+            // Initial step size from the mean prediction error over the start of the block
+            int sum = 0;
+            {
+                AdpcmState probe = state;
+                for (size_t j = 2; j < std::min<size_t>(18, frames); ++j)
+                {
+                    sum += abs(samples[j] - AdpcmPredict(probe));
+                    probe.sample2 = probe.sample1;
+                    probe.sample1 = samples[j];
+                }
+            }
+            state.delta = std::max(16, std::min(32767, sum / (16 * 4)));
+
+            const AdpcmState initial = state;
+
+            uint64_t error = 0;
+            for (size_t j = 2; j < frames && error < bestError; ++j)
+            {
+                (void)AdpcmEncodeSample(state, samples[j]);
+
+                int64_t e = int64_t(samples[j]) - int64_t(state.sample1);
+                error += uint64_t(e * e);
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestPredictor = p;
+                best = initial;
+            }
+        }
+
+        return bestPredictor;
+    }
+
+    inline uint8_t* AdpcmWriteShort(uint8_t* ptr, int value)
+    {
+        *ptr++ = static_cast<uint8_t>(value & 0xFF);
+        *ptr++ = static_cast<uint8_t>((value >> 8) & 0xFF);
+        return ptr;
+    }
+
+    // Encodes a block of blockFrames interleaved frames (at most ADPCM_SAMPLES_PER_BLOCK) from the first frames of pcm,
+    // repeating the last frame to fill out the header or an odd mono nibble
+    void AdpcmEncodeBlock(const int16_t* pcm, size_t frames, size_t blockFrames, WORD nChannels, uint8_t* out)
+    {
+        assert(frames > 0 && frames <= blockFrames && blockFrames <= ADPCM_SAMPLES_PER_BLOCK);
+
+        int16_t block[2][ADPCM_SAMPLES_PER_BLOCK] = {};
+        for (size_t j = 0; j < blockFrames; ++j)
+        {
+            const size_t src = std::min(j, frames - 1);
+            for (WORD ch = 0; ch < nChannels; ++ch)
+                block[ch][j] = pcm[src * nChannels + ch];
+        }
+
+        AdpcmState state[2] = {};
+        for (WORD ch = 0; ch < nChannels; ++ch)
+            *out++ = AdpcmChoosePredictor(block[ch], blockFrames, state[ch]);
+
+        for (WORD ch = 0; ch < nChannels; ++ch)
+            out = AdpcmWriteShort(out, state[ch].delta);
+        for (WORD ch = 0; ch < nChannels; ++ch)
+            out = AdpcmWriteShort(out, state[ch].sample1);
+        for (WORD ch = 0; ch < nChannels; ++ch)
+            out = AdpcmWriteShort(out, state[ch].sample2);
+
+        bool high = true;
+        for (size_t j = 2; j < blockFrames; ++j)
+        {
+            for (WORD ch = 0; ch < nChannels; ++ch)
+            {
+                int nibble = AdpcmEncodeSample(state[ch], block[ch][j]);
+                if (high)
+                {
+                    *out = static_cast<uint8_t>(nibble << 4);
+                }
+                else
+                {
+                    *out++ |= static_cast<uint8_t>(nibble);
+                }
+                high = !high;
+            }
+        }
+    }
+
+    // Replaces a PCM wave with an MS ADPCM encoding of it (using the standard coefficients ConvertToMiniFormat requires)
+    ADPCM_RESULT EncodeToAdpcm(WaveFile& wave)
+    {
+        auto wfx = wave.data.wfx;
+        if (wfx->wFormatTag != WAVE_FORMAT_PCM)
+            return ADPCM_NOT_PCM;
+
+        if ((wfx->nChannels != 1 && wfx->nChannels != 2)
+            || (wfx->wBitsPerSample != 8 && wfx->wBitsPerSample != 16)
+            || wfx->nBlockAlign != (wfx->nChannels * wfx->wBitsPerSample / 8))
+            return ADPCM_UNSUPPORTED_PCM;
+
+        // XAudio2 requires ADPCM loop regions to be whole blocks
+        if (wave.data.loopLength > 0
+            && ((wave.data.loopStart % ADPCM_SAMPLES_PER_BLOCK) != 0 || (wave.data.loopLength % ADPCM_SAMPLES_PER_BLOCK) != 0))
+            return ADPCM_UNALIGNED_LOOP;
+
+        const WORD nChannels = wfx->nChannels;
+        const size_t frames = wave.data.audioBytes / wfx->nBlockAlign;
+        if (!frames)
+            return ADPCM_UNSUPPORTED_PCM;
+
+        std::unique_ptr<int16_t[]> pcm(new (std::nothrow) int16_t[frames * nChannels]);
+        if (!pcm)
+            return ADPCM_OUT_OF_MEMORY;
+
+        if (wfx->wBitsPerSample == 8)
+        {
+            for (size_t j = 0; j < frames * nChannels; ++j)
+                pcm[j] = static_cast<int16_t>((int(wave.data.startAudio[j]) - 128) * 256);
+        }
+        else
+        {
+            memcpy(pcm.get(), wave.data.startAudio, frames * nChannels * sizeof(int16_t));
+        }
+
+        const size_t blocks = (frames + ADPCM_SAMPLES_PER_BLOCK - 1) / ADPCM_SAMPLES_PER_BLOCK;
+        const WORD blockAlign = AdpcmBlockSizeFromPcmFrames(ADPCM_SAMPLES_PER_BLOCK, nChannels);
+
+        // The final block is trimmed to the frames actually left rather than padded out, so there is no
+        // trailing silence; it still needs the two header frames, and mono nibbles come in pairs
+        const size_t lastFrames = frames - (blocks - 1) * ADPCM_SAMPLES_PER_BLOCK;
+        size_t lastBlockFrames = std::max<size_t>(2, lastFrames);
+        if (nChannels == 1)
+            lastBlockFrames += lastBlockFrames & 1;
+        const WORD lastBlockAlign = AdpcmBlockSizeFromPcmFrames(WORD(lastBlockFrames), nChannels);
+
+        const uint64_t audioBytes = uint64_t(blocks - 1) * blockAlign + lastBlockAlign;
+        if (audioBytes > UINT32_MAX)
+            return ADPCM_OUT_OF_MEMORY;
+
+        std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[ADPCM_FORMAT_SIZE + size_t(audioBytes)]);
+        if (!buffer)
+            return ADPCM_OUT_OF_MEMORY;
+
+        auto fmt = reinterpret_cast<ADPCMWAVEFORMAT*>(buffer.get());
+        fmt->wfx.wFormatTag = WAVE_FORMAT_ADPCM;
+        fmt->wfx.nChannels = nChannels;
+        fmt->wfx.nSamplesPerSec = wfx->nSamplesPerSec;
+        fmt->wfx.nAvgBytesPerSec = DWORD((uint64_t(wfx->nSamplesPerSec) * blockAlign) / ADPCM_SAMPLES_PER_BLOCK);
+        fmt->wfx.nBlockAlign = blockAlign;
+        fmt->wfx.wBitsPerSample = 4 /*MSADPCM_BITS_PER_SAMPLE*/;
+        fmt->wfx.cbSize = 32 /*MSADPCM_FORMAT_EXTRA_BYTES*/;
+        fmt->wSamplesPerBlock = ADPCM_SAMPLES_PER_BLOCK;
+        fmt->wNumCoef = 7 /*MSADPCM_NUM_COEFFICIENTS*/;
+
+        for (int j = 0; j < 7 /*MSADPCM_NUM_COEFFICIENTS*/; ++j)
+        {
+            fmt->aCoef[j].iCoef1 = g_pAdpcmCoefficients1[j];
+            fmt->aCoef[j].iCoef2 = g_pAdpcmCoefficients2[j];
+        }
+
+        uint8_t* out = buffer.get() + ADPCM_FORMAT_SIZE;
+        for (size_t b = 0; b < blocks; ++b)
+        {
+            size_t first = b * ADPCM_SAMPLES_PER_BLOCK;
+            if (b + 1 < blocks)
+            {
+                AdpcmEncodeBlock(&pcm[first * nChannels], ADPCM_SAMPLES_PER_BLOCK, ADPCM_SAMPLES_PER_BLOCK, nChannels, out);
+                out += blockAlign;
+            }
+            else
+            {
+                AdpcmEncodeBlock(&pcm[first * nChannels], lastFrames, lastBlockFrames, nChannels, out);
+                out += lastBlockAlign;
+            }
+        }
+
+        wave.data.wfx = &fmt->wfx;
+        wave.data.startAudio = buffer.get() + ADPCM_FORMAT_SIZE;
+        wave.data.audioBytes = uint32_t(audioBytes);
+        wave.waveData = std::move(buffer);
+        return ADPCM_ENCODED;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Incremental build cache
+    //--------------------------------------------------------------------------------------
+    const uint32_t CACHE_MAGIC = MAKEFOURCC('X', 'W', 'B', 'C');
+    const uint32_t CACHE_VERSION = 2;
+
+    // Options which change the content of the wave bank or C header
+    const DWORD CACHE_OPTIONS = (1 << OPT_STREAMING) | (1 << OPT_COMPACT) | (1 << OPT_NOCOMPACT) | (1 << OPT_FRIENDLY_NAMES)
+        | (1 << OPT_ORDER) | (1 << OPT_ALIGNMENT) | (1 << OPT_ADPCM);
+
+    struct CacheEntry
+    {
+        uint64_t size;
+        uint64_t writeTime;
+        uint64_t hash;
+        std::wstring path;
+    };
+
+    bool GetFileStamp(const wchar_t* pszFilename, uint64_t& size, uint64_t& writeTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA info = {};
+        if (!GetFileAttributesExW(pszFilename, GetFileExInfoStandard, &info))
+            return false;
+
+        size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        writeTime = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+    // FNV-1a
+    uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        auto ptr = static_cast<const uint8_t*>(data);
+        for (size_t j = 0; j < size; ++j)
+        {
+            hash ^= ptr[j];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Covers everything from the .wav that is stored in the wave bank
+    uint64_t HashWave(const DirectX::WAVData& data)
+    {
+        size_t fmtSize = (data.wfx->wFormatTag == WAVE_FORMAT_PCM) ? offsetof(WAVEFORMATEX, cbSize) : (sizeof(WAVEFORMATEX) + data.wfx->cbSize);
+
+        uint64_t hash = HashBytes(14695981039346656037ull, data.wfx, fmtSize);
+        hash = HashBytes(hash, data.startAudio, data.audioBytes);
+        hash = HashBytes(hash, &data.loopStart, sizeof(data.loopStart));
+        hash = HashBytes(hash, &data.loopLength, sizeof(data.loopLength));
+        if (data.seek)
+            hash = HashBytes(hash, data.seek, data.seekCount * sizeof(uint32_t));
+        return hash;
+    }
+
+    bool ReadCacheString(std::ifstream& inFile, std::wstring& str)
+    {
+        uint32_t length = 0;
+        inFile.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!inFile || length > 32767)
+            return false;
+
+        str.resize(length);
+        if (length > 0)
+            inFile.read(reinterpret_cast<char*>(&str[0]), std::streamsize(length * sizeof(wchar_t)));
+        return !inFile.fail();
+    }
+
+    void WriteCacheString(std::ofstream& outFile, const std::wstring& str)
+    {
+        auto length = static_cast<uint32_t>(str.size());
+        outFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        outFile.write(reinterpret_cast<const char*>(str.c_str()), std::streamsize(length * sizeof(wchar_t)));
+    }
+
+    bool ReadCache(const wchar_t* pszFilename, DWORD& options, uint64_t& settings, std::wstring& header, std::vector<CacheEntry>& entries)
+    {
+        std::ifstream inFile(pszFilename, std::ios::in | std::ios::binary);
+        if (!inFile)
+            return false;
+
+        uint32_t hdr[4] = {}; // magic, version, options, entry count
+        inFile.read(reinterpret_cast<char*>(hdr), sizeof(hdr));
+        if (!inFile || hdr[0] != CACHE_MAGIC || hdr[1] != CACHE_VERSION)
+            return false;
+
+        options = hdr[2];
+        inFile.read(reinterpret_cast<char*>(&settings), sizeof(settings));
+        if (!inFile || !ReadCacheString(inFile, header))
+            return false;
+
+        entries.clear();
+        for (uint32_t j = 0; j < hdr[3]; ++j)
+        {
+            CacheEntry entry = {};
+            uint64_t values[3] = {};
+            inFile.read(reinterpret_cast<char*>(values), sizeof(values));
+            if (!inFile || !ReadCacheString(inFile, entry.path))
+                return false;
+
+            entry.size = values[0];
+            entry.writeTime = values[1];
+            entry.hash = values[2];
+            entries.emplace_back(std::move(entry));
+        }
+
+        return true;
+    }
+
+    bool WriteCache(const wchar_t* pszFilename, DWORD options, uint64_t settings, const wchar_t* header, const std::vector<CacheEntry>& entries)
+    {
+        std::ofstream outFile(pszFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!outFile)
+            return false;
+
+        const uint32_t hdr[4] = { CACHE_MAGIC, CACHE_VERSION, options, static_cast<uint32_t>(entries.size()) };
+        outFile.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+        outFile.write(reinterpret_cast<const char*>(&settings), sizeof(settings));
+        WriteCacheString(outFile, header);
+
+        for (auto it = entries.cbegin(); it != entries.cend(); ++it)
+        {
+            const uint64_t values[3] = { it->size, it->writeTime, it->hash };
+            outFile.write(reinterpret_cast<const char*>(values), sizeof(values));
+            WriteCacheString(outFile, it->path);
+        }
+
+        outFile.close();
+        return !outFile.fail();
+    }
+
+    // Inputs whose size and timestamp match the cache are trusted; a changed timestamp alone means re-reading the
+    // file and comparing its hash, refreshing the cache if the content turns out to be the same.
+    bool IsUpToDate(const wchar_t* cacheFile, DWORD options, uint64_t settings, const wchar_t* headerFile, const wchar_t* outputFile, const std::list<SConversion>& conversion)
+    {
+        DWORD cachedOptions = 0;
+        uint64_t cachedSettings = 0;
+        std::wstring cachedHeader;
+        std::vector<CacheEntry> entries;
+        if (!ReadCache(cacheFile, cachedOptions, cachedSettings, cachedHeader, entries))
+            return false;
+
+        if (cachedOptions != options
+            || cachedSettings != settings
+            || _wcsicmp(cachedHeader.c_str(), headerFile) != 0
+            || entries.size() != conversion.size())
+            return false;
+
+        if (!FileExists(outputFile) || (*headerFile && !FileExists(headerFile)))
+            return false;
+
+        bool touched = false;
+        auto it = entries.begin();
+        for (auto pConv = conversion.cbegin(); pConv != conversion.cend(); ++pConv, ++it)
+        {
+            if (_wcsicmp(it->path.c_str(), pConv->szSrc) != 0)
+                return false;
+
+            uint64_t size, writeTime;
+            if (!GetFileStamp(pConv->szSrc, size, writeTime) || size != it->size)
+                return false;
+
+            if (writeTime != it->writeTime)
+            {
+                std::unique_ptr<uint8_t[]> waveData;
+                DirectX::WAVData data = {};
+                if (FAILED(DirectX::LoadWAVAudioFromFileEx(pConv->szSrc, waveData, data))
+                    || HashWave(data) != it->hash)
+                    return false;
+
+                it->writeTime = writeTime;
+                touched = true;
+            }
+        }
+
+        if (touched)
+            (void)WriteCache(cacheFile, options, settings, headerFile, entries);
+
+        return true;
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1062,6 +1550,8 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
     // Parameters and defaults
     wchar_t szOutputFile[MAX_PATH] = {};
     wchar_t szHeaderFile[MAX_PATH] = {};
+    std::vector<std::wstring> accessOrder;
+    DWORD dwUserAlignment = 0;
 
     ScopedHandle hFile;
 
@@ -1099,6 +1589,8 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             case OPT_OUTPUTFILE:
             case OPT_OUTPUTHEADER:
             case OPT_FILELIST:
+            case OPT_ORDER:
+            case OPT_ALIGNMENT:
                 if (!*pValue)
                 {
                     if ((iArg + 1 >= argc))
@@ -1180,6 +1672,43 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 inFile.close();
             }
             break;
+
+            case OPT_ORDER:
+            {
+                std::wifstream inFile(pValue);
+                if (!inFile)
+                {
+                    wprintf(L"Error opening -order file %ls\n", pValue);
+                    return 1;
+                }
+                wchar_t fname[1024] = {};
+                for (;;)
+                {
+                    inFile >> fname;
+                    if (!inFile)
+                        break;
+
+                    if (*fname != L'#')
+                    {
+                        accessOrder.emplace_back(fname);
+                    }
+
+                    inFile.ignore(1000, '\n');
+                }
+                inFile.close();
+            }
+            break;
+
+            case OPT_ALIGNMENT:
+                if (swscanf_s(pValue, L"%lu", &dwUserAlignment) != 1
+                    || dwUserAlignment < ALIGNMENT_MIN
+                    || dwUserAlignment > 65536
+                    || (dwUserAlignment & (dwUserAlignment - 1)) != 0)
+                {
+                    wprintf(L"Invalid value specified with -align (%ls), must be a power of 2 from 4 to 65536\n", pValue);
+                    return 1;
+                }
+                break;
             }
         }
         else if (wcspbrk(pArg, L"?*") != nullptr)
@@ -1211,6 +1740,44 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
     if (~dwOptions & (1 << OPT_NOLOGO))
         PrintLogo();
 
+    if (!*szOutputFile)
+    {
+        wchar_t ext[_MAX_EXT];
+        wchar_t fname[_MAX_FNAME];
+        _wsplitpath_s(conversion.front().szSrc, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
+
+        if (_wcsicmp(ext, L".xwb") == 0)
+        {
+            wprintf(L"ERROR: Need to specify output file via -o\n");
+            return 1;
+        }
+
+        _wmakepath_s(szOutputFile, nullptr, nullptr, fname, L".xwb");
+    }
+
+    wchar_t szCacheFile[MAX_PATH] = {};
+    uint64_t cacheSettings = 0;
+    if (dwOptions & (1 << OPT_INCREMENTAL))
+    {
+        cacheSettings = HashBytes(14695981039346656037ull, &dwUserAlignment, sizeof(dwUserAlignment));
+        for (auto it = accessOrder.cbegin(); it != accessOrder.cend(); ++it)
+            cacheSettings = HashBytes(cacheSettings, it->c_str(), (it->size() + 1) * sizeof(wchar_t));
+
+        wcscpy_s(szCacheFile, szOutputFile);
+        wcscat_s(szCacheFile, L".cache");
+
+        if (IsUpToDate(szCacheFile, dwOptions & CACHE_OPTIONS, cacheSettings, szHeaderFile, szOutputFile, conversion))
+        {
+            wprintf(L"wavebank %ls is up to date\n", szOutputFile);
+            return 0;
+        }
+    }
+
+    std::vector<WaveFile> loaded;
+    std::vector<HRESULT> loadResults;
+    if (dwOptions & (1 << OPT_PARALLEL))
+        LoadWaveFiles(conversion, loaded, loadResults);
+
     // Gather wave files
     std::unique_ptr<uint8_t[]> entries;
     std::unique_ptr<char[]> entryNames;
@@ -1222,39 +1789,32 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
     size_t index = 0;
     for (auto pConv = conversion.begin(); pConv != conversion.end(); ++pConv, ++index)
     {
-        wchar_t ext[_MAX_EXT];
-        wchar_t fname[_MAX_FNAME];
-        _wsplitpath_s(pConv->szSrc, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
         // Load source image
         if (pConv != conversion.begin())
             wprintf(L"\n");
-        else if (!*szOutputFile)
-        {
-            if (_wcsicmp(ext, L".xwb") == 0)
-            {
-                wprintf(L"ERROR: Need to specify output file via -o\n");
-                return 1;
-            }
-
-            _wmakepath_s(szOutputFile, nullptr, nullptr, fname, L".xwb");
-        }
 
         wprintf(L"reading %ls", pConv->szSrc);
         fflush(stdout);
 
         WaveFile wave;
-        wave.conv = index;
-        std::unique_ptr<uint8_t[]> waveData;
+        HRESULT hr = S_OK;
+        if (!loaded.empty())
+        {
+            wave = std::move(loaded[index]);
+            hr = loadResults[index];
+        }
+        else
+        {
+            hr = DirectX::LoadWAVAudioFromFileEx(pConv->szSrc, wave.waveData, wave.data);
+        }
 
-        HRESULT hr = DirectX::LoadWAVAudioFromFileEx(pConv->szSrc, waveData, wave.data);
         if (FAILED(hr))
         {
             wprintf(L"\nERROR: Failed to load file (%08X)\n", static_cast<unsigned int>(hr));
             return 1;
         }
 
-        wave.waveData = std::move(waveData);
+        wave.conv = index;
 
         PrintInfo(wave);
 
@@ -1266,12 +1826,77 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
 
     wprintf(L"\n");
 
+    // The cache describes the source files, so hash them before any encoding
+    std::vector<uint64_t> sourceHashes;
+    if (dwOptions & (1 << OPT_INCREMENTAL))
+    {
+        sourceHashes.reserve(waves.size());
+        for (auto it = waves.cbegin(); it != waves.cend(); ++it)
+            sourceHashes.push_back(HashWave(it->data));
+    }
+
+    if (dwOptions & (1 << OPT_ADPCM))
+    {
+        std::vector<ADPCM_RESULT> results(waves.size(), ADPCM_NOT_PCM);
+        std::vector<uint32_t> sourceBytes(waves.size());
+        auto encode = [&](size_t j)
+        {
+            sourceBytes[j] = waves[j].data.audioBytes;
+            results[j] = EncodeToAdpcm(waves[j]);
+        };
+
+        if (dwOptions & (1 << OPT_PARALLEL))
+        {
+            ParallelFor(waves.size(), encode);
+        }
+        else
+        {
+            for (size_t j = 0; j < waves.size(); ++j)
+                encode(j);
+        }
+
+        size_t encoded = 0;
+        uint64_t before = 0;
+        uint64_t after = 0;
+        auto cit = conversion.cbegin();
+        for (size_t j = 0; j < waves.size(); ++j, ++cit)
+        {
+            switch (results[j])
+            {
+            case ADPCM_ENCODED:
+                ++encoded;
+                before += sourceBytes[j];
+                after += waves[j].data.audioBytes;
+                break;
+
+            case ADPCM_UNSUPPORTED_PCM:
+                wprintf(L"WARNING: %ls is not 8-bit or 16-bit mono/stereo PCM, leaving it unencoded\n", cit->szSrc);
+                break;
+
+            case ADPCM_UNALIGNED_LOOP:
+                wprintf(L"WARNING: %ls loop region is not a multiple of %u samples, leaving it as PCM\n", cit->szSrc, ADPCM_SAMPLES_PER_BLOCK);
+                break;
+
+            case ADPCM_OUT_OF_MEMORY:
+                wprintf(L"ERROR: Failed encoding %ls to MS ADPCM\n", cit->szSrc);
+                return 1;
+
+            default:
+                break;
+            }
+        }
+
+        wprintf(L"encoded %zu of %zu entries to MS ADPCM (%llu -> %llu bytes)\n\n", encoded, waves.size(), before, after);
+    }
+
     DWORD dwAlignment = ALIGNMENT_MIN;
     if (dwOptions & (1 << OPT_STREAMING))
         dwAlignment = ALIGNMENT_DVD;
     else if (xma)
         dwAlignment = 2048;
 
+    dwAlignment = std::max(dwAlignment, dwUserAlignment);
+
     // Convert wave format to miniformat, failing if any won't map
     // Check to see if we can use the compact wave bank format
     bool compact = (dwOptions & (1 << OPT_NOCOMPACT)) ? false : true;
@@ -1319,6 +1944,81 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
         reason |= 0x4;
     }
 
+    // Place the wave data in access order if given a profile; listed entries go first, the rest follow in input order.
+    // Only the layout of the data segment changes, so the entry indices (and the C header enum) stay the same.
+    std::vector<size_t> layout;
+    layout.reserve(waves.size());
+    if (!accessOrder.empty())
+    {
+        std::unordered_map<std::wstring, size_t> lookup;
+        size_t windex = 0;
+        for (auto cit = conversion.cbegin(); cit != conversion.cend(); ++cit, ++windex)
+        {
+            wchar_t wEntryName[_MAX_FNAME];
+            _wsplitpath_s(cit->szSrc, nullptr, 0, nullptr, 0, wEntryName, _MAX_FNAME, nullptr, 0);
+            _wcslwr_s(wEntryName);
+
+            lookup.emplace(wEntryName, windex);
+        }
+
+        std::vector<bool> placed(waves.size(), false);
+        for (auto it = accessOrder.cbegin(); it != accessOrder.cend(); ++it)
+        {
+            wchar_t wEntryName[_MAX_FNAME];
+            _wsplitpath_s(it->c_str(), nullptr, 0, nullptr, 0, wEntryName, _MAX_FNAME, nullptr, 0);
+            _wcslwr_s(wEntryName);
+
+            auto match = lookup.find(wEntryName);
+            if (match == lookup.end())
+            {
+                wprintf(L"WARNING: -order entry %ls does not match any wave file\n", it->c_str());
+            }
+            else if (!placed[match->second])
+            {
+                placed[match->second] = true;
+                layout.push_back(match->second);
+            }
+        }
+
+        for (size_t j = 0; j < waves.size(); ++j)
+        {
+            if (!placed[j])
+                layout.push_back(j);
+        }
+    }
+    else
+    {
+        for (size_t j = 0; j < waves.size(); ++j)
+            layout.push_back(j);
+    }
+
+    const bool reordered = !std::is_sorted(layout.cbegin(), layout.cend());
+
+    // Compact entries find their length from the next entry's offset, so they need the data in index order
+    if (reordered)
+    {
+        compact = false;
+        reason |= 0x8;
+    }
+
+    // Compact entries record the padding in 11 bits
+    if (dwAlignment > 2048)
+    {
+        compact = false;
+        reason |= 0x10;
+    }
+
+    std::vector<uint32_t> offsets(waves.size());
+    {
+        uint64_t offset = 0;
+        for (auto j : layout)
+        {
+            offsets[j] = uint32_t(offset);
+            offset += BLOCKALIGNPAD(waves[j].data.audioBytes, dwAlignment);
+        }
+        assert(offset == waveOffset);
+    }
+
     if ((dwOptions & (1 << OPT_COMPACT)) && !compact)
     {
         wprintf(L"ERROR: Cannot create compact wave bank:\n");
@@ -1334,6 +2034,14 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
         {
             wprintf(L"- Audio wave data is too large to encode in compact wavebank (%llu > %llu).\n", waveOffset, (uint64_t(MAX_COMPACT_DATA_SEGMENT_SIZE) * uint64_t(dwAlignment)));
         }
+        if (reason & 0x8)
+        {
+            wprintf(L"- Entries are laid out with -order. Compact wavebanks must store wave data in entry order.\n");
+        }
+        if (reason & 0x10)
+        {
+            wprintf(L"- Alignment is %lu. Compact wavebanks support alignments up to 2048.\n", dwAlignment);
+        }
         return 1;
     }
 
@@ -1347,7 +2055,6 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
         memset(entryNames.get(), 0, sizeof(char) * waves.size() * ENTRYNAME_LENGTH);
     }
 
-    waveOffset = 0;
     size_t count = 0;
     size_t seekEntries = 0;
     for (auto it = waves.begin(); it != waves.end(); ++it, ++count)
@@ -1374,8 +2081,9 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             int partial = it->data.audioBytes % wfx->nBlockAlign;
             if (partial)
             {
+                // A short final block holds two header frames plus two nibbles per byte
                 if (partial >= (7 * wfx->nChannels))
-                    duration += (uint64_t(partial) * 2 / uint64_t(wfx->nChannels - 12));
+                    duration += 2 + uint64_t(partial - 7 * wfx->nChannels) * 2 / wfx->nChannels;
             }
         }
         break;
@@ -1398,8 +2106,8 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             auto entry = reinterpret_cast<ENTRYCOMPACT*>(entries.get() + count * sizeof(ENTRYCOMPACT));
             memset(entry, 0, sizeof(ENTRYCOMPACT));
 
-            assert(waveOffset <= (MAX_COMPACT_DATA_SEGMENT_SIZE * uint64_t(dwAlignment)));
-            entry->dwOffset = uint32_t(waveOffset / dwAlignment);
+            assert(offsets[count] <= (MAX_COMPACT_DATA_SEGMENT_SIZE * uint64_t(dwAlignment)));
+            entry->dwOffset = offsets[count] / dwAlignment;
 
             assert(dwAlignment <= 2048);
             entry->dwLengthDeviation = alignedSize - it->data.audioBytes;
@@ -1417,7 +2125,7 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
 
             entry->Duration = uint32_t(duration);
             memcpy(&entry->Format, &it->miniFmt, sizeof(MINIWAVEFORMAT));
-            entry->PlayRegion.dwOffset = uint32_t(waveOffset);
+            entry->PlayRegion.dwOffset = offsets[count];
             entry->PlayRegion.dwLength = it->data.audioBytes;
 
             if (it->data.loopLength > 0)
@@ -1441,8 +2149,6 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 memset(&entryNames[count * ENTRYNAME_LENGTH], 0, ENTRYNAME_LENGTH);
             }
         }
-
-        waveOffset += alignedSize;
     }
 
     assert(count > 0 && count == waves.size());
@@ -1670,8 +2376,12 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
     header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset = segmentOffset;
     header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwLength = uint32_t(waveOffset);
 
-    for (auto it = waves.begin(); it != waves.end(); ++it)
+    for (auto j : layout)
     {
+        auto it = &waves[j];
+
+        assert(segmentOffset == (header.Segments[HEADER::SEGIDX_ENTRYWAVEDATA].dwOffset + offsets[j]));
+
         if (SetFilePointer(hFile.get(), LONG(segmentOffset), nullptr, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
         {
             wprintf(L"ERROR: Failed writing audio data to %ls, SFP %lu\n", szOutputFile, GetLastError());
@@ -1756,6 +2466,20 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
 
             fprintf_s(file, "};\n\n#define XACT_WAVEBANK_%ls_ENTRY_COUNT %zu\n", wBankName, count);
 
+            if (reordered)
+            {
+                // Entries in the order their wave data is stored. Neighbors are adjacent in the file (apart from
+                // alignment padding), so a streaming engine can prefetch a run of them with a single read.
+                fprintf_s(file, "\nstatic const unsigned int XACT_WAVEBANK_%ls_LAYOUT_ORDER[%zu] =\n{\n", wBankName, count);
+
+                for (auto j : layout)
+                {
+                    fprintf_s(file, "    %zu,\n", j);
+                }
+
+                fprintf_s(file, "};\n");
+            }
+
             fclose(file);
         }
         else
@@ -1765,5 +2489,29 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
         }
     }
 
+    if (dwOptions & (1 << OPT_INCREMENTAL))
+    {
+        std::vector<CacheEntry> cache;
+        cache.reserve(waves.size());
+
+        bool stamped = true;
+        for (auto it = waves.cbegin(); it != waves.cend() && stamped; ++it)
+        {
+            auto cit = conversion.cbegin();
+            advance(cit, it->conv);
+
+            CacheEntry entry = {};
+            stamped = GetFileStamp(cit->szSrc, entry.size, entry.writeTime);
+            entry.hash = sourceHashes[it->conv];
+            entry.path = cit->szSrc;
+            cache.emplace_back(std::move(entry));
+        }
+
+        if (!stamped || !WriteCache(szCacheFile, dwOptions & CACHE_OPTIONS, cacheSettings, szHeaderFile, cache))
+        {
+            wprintf(L"WARNING: Failed writing incremental build cache %ls\n", szCacheFile);
+        }
+    }
+
     return 0;
 }